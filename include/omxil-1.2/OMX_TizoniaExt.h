@@ -72,6 +72,7 @@
 #define OMX_TizoniaIndexParamAudioDirblePlaylist     OMX_IndexVendorStartUnused + 16 /**< reference: OMX_TIZONIA_AUDIO_PARAM_DIRBLEPLAYLISTTYPE */
 #define OMX_TizoniaIndexParamAudioYoutubeSession     OMX_IndexVendorStartUnused + 17 /**< reference: OMX_TIZONIA_AUDIO_PARAM_YOUTUBESESSIONTYPE */
 #define OMX_TizoniaIndexParamAudioYoutubePlaylist    OMX_IndexVendorStartUnused + 18 /**< reference: OMX_TIZONIA_AUDIO_PARAM_YOUTUBEPLAYLISTTYPE */
+#define OMX_TizoniaIndexConfigStreamPosition         OMX_IndexVendorStartUnused + 19 /**< reference: OMX_TIZONIA_STREAMPOSITIONTYPE */
 
 /**
  * OMX_AUDIO_CODINGTYPE extensions
@@ -85,6 +86,15 @@
 #define OMX_AUDIO_CodingMP4   OMX_AUDIO_CodingVendorStartUnused + 6 /** this for audio in a mp4 container */
 #define OMX_AUDIO_CodingWEBM  OMX_AUDIO_CodingVendorStartUnused + 7 /** this for audio in a webm container */
 
+/**
+ * OMX_NUMERICALDATATYPE extensions
+ *
+ * OMX_NumericalDataFloat is used together with nBitPerSample 32 to describe
+ * 32-bit IEEE float samples. With OMX_NumericalDataSigned, nBitPerSample 32
+ * means 32-bit signed integer samples, and 24 means packed 3-byte samples.
+ */
+#define OMX_NumericalDataFloat ((OMX_NUMERICALDATATYPE) 0x7F000001)
+
 /**
  * OMX_VIDEO_CODINGTYPE extensions
  */
@@ -313,6 +323,34 @@ typedef struct OMX_TIZONIA_PLAYLISTSKIPTYPE {
     OMX_S32 nValue;              /** Can be a positive or a negative value. Wrap-around use cases are allowed. */
 } OMX_TIZONIA_PLAYLISTSKIPTYPE;
 
+/**
+ * Extension to seek within a stream.
+ *
+ * A decoder that is able to seek reports a non-negative nTimestamp, and a
+ * negative one otherwise. To seek, a client sets nTimestamp to an offset
+ * relative to the current decoding position (which may be negative). The
+ * decoder then looks up the closest seek point that precedes the target,
+ * replaces the structure with the absolute media time and byte offset of
+ * that seek point (nByteOffset is negative when the offset cannot be
+ * resolved from the stream), signals OMX_EventIndexSettingChanged and
+ * discards its input until a buffer flagged with OMX_BUFFERFLAG_STARTTIME
+ * arrives. Decoded samples that precede the target are dropped.
+ *
+ * On a source component, SetConfig repositions the stream, to nByteOffset
+ * or, if the source can seek by time, to the absolute media time in
+ * nTimestamp. The first buffer produced after the seek is flagged with
+ * OMX_BUFFERFLAG_STARTTIME and carries the media time of the new position
+ * in nTimeStamp.
+ */
+
+typedef struct OMX_TIZONIA_STREAMPOSITIONTYPE {
+    OMX_U32 nSize;
+    OMX_VERSIONTYPE nVersion;
+    OMX_U32 nPortIndex;
+    OMX_TICKS nTimestamp;        /**< Media time, in microseconds */
+    OMX_S64 nByteOffset;         /**< Byte offset in the stream, or -1 if not known */
+} OMX_TIZONIA_STREAMPOSITIONTYPE;
+
 /**
  * Google Play Music source component
  * References:
@@ -31,6 +31,7 @@
 
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <assert.h>
 #include <sys/types.h>
 #include <dirent.h>
@@ -42,6 +43,8 @@
 #include <string.h>
 #include <errno.h>
 #include <limits.h>
+#include <stdio.h>
+#include <fcntl.h>
 
 #include <OMX_Core.h>
 #include <OMX_Component.h>
@@ -68,6 +71,10 @@
 #define TIZ_IL_CORE_RM_NAME "OMX.Aratelia.ilcore"
 #define TIZ_DEFAULT_COMP_ENTRY_POINT_NAME "OMX_ComponentInit"
 #define TIZ_CORE_QUEUE_MAX_ITEMS 30
+#define TIZ_CORE_REGISTRY_CACHE_MAGIC "tizcore-registry-cache 2"
+#define TIZ_CORE_REGISTRY_CACHE_NONE "none"
+#define TIZ_CORE_REGISTRY_CACHE_FILE "tizonia/ilcore-registry"
+#define TIZ_CORE_INDEX_MIN_BUCKETS 32
 
 typedef struct role_list_item role_list_item_t;
 typedef role_list_item_t * role_list_t;
@@ -222,12 +229,38 @@ struct tiz_core_registry_item
   OMX_STRING p_dl_name;
   OMX_STRING p_dl_path;
   OMX_PTR p_entry_point;
-  OMX_PTR p_dl_hdl;
-  OMX_HANDLETYPE p_hdl;
   role_list_t p_roles;
+  struct timespec dl_mtime;
+  off_t dl_size;
+  ino_t dl_ino;
   tiz_core_registry_item_t * p_next;
 };
 
+/* Chained hash tables used to index the registry by component name and by
+ * role, and to track the live component instances by handle. Keys are not
+ * copied: they point to strings owned by the registry item, or are the
+ * component handle itself. A key may appear more than once (e.g. a role
+ * implemented by several components); entries with the same key are kept in
+ * insertion order. */
+typedef struct tiz_core_index_entry tiz_core_index_entry_t;
+struct tiz_core_index_entry
+{
+  OMX_PTR p_key;
+  OMX_U32 hash;
+  tiz_core_registry_item_t * p_reg_item;
+  OMX_PTR p_dl_hdl; /* Only used in the handle index */
+  tiz_core_index_entry_t * p_next;
+};
+
+typedef struct tiz_core_index tiz_core_index_t;
+struct tiz_core_index
+{
+  tiz_core_index_entry_t ** pp_buckets;
+  OMX_U32 nbuckets;
+  OMX_U32 nentries;
+  bool str_keys;
+};
+
 typedef struct tizcore tiz_core_t;
 struct tizcore
 {
@@ -238,6 +271,14 @@ struct tizcore
   OMX_ERRORTYPE error;
   tiz_core_state_t state;
   tiz_core_registry_t p_registry;
+  /* Items of plugins that changed on disk; live instances may still point
+     to them */
+  tiz_core_registry_t p_retired;
+  tiz_core_index_t names;
+  tiz_core_index_t roles;
+  tiz_core_index_t handles;
+  tiz_core_registry_t p_registry_cache;
+  bool registry_cache_dirty;
   tiz_rm_t rm;
   tiz_rm_proxy_callbacks_t rmcbacks;
   bool rm_inited;
@@ -250,6 +291,250 @@ get_core (void);
 static tiz_core_registry_item_t *
 find_comp_in_registry (const OMX_STRING ap_name);
 
+static OMX_U32
+index_hash (const tiz_core_index_t * ap_idx, const OMX_PTR ap_key)
+{
+  OMX_U32 hash = 2166136261u;
+
+  assert (ap_idx);
+
+  if (ap_idx->str_keys)
+    {
+      /* FNV-1a */
+      const unsigned char * p_str = (const unsigned char *) ap_key;
+      size_t i = 0;
+      for (i = 0; i < OMX_MAX_STRINGNAME_SIZE && p_str[i]; ++i)
+        {
+          hash = (hash ^ p_str[i]) * 16777619u;
+        }
+    }
+  else
+    {
+      uintptr_t val = (uintptr_t) ap_key;
+      hash = (OMX_U32) ((val >> 4) ^ (val >> 20)) * 2654435761u;
+    }
+
+  return hash;
+}
+
+static bool
+index_key_equals (const tiz_core_index_t * ap_idx,
+                  const tiz_core_index_entry_t * ap_entry, const OMX_PTR ap_key,
+                  OMX_U32 a_hash)
+{
+  assert (ap_idx);
+  assert (ap_entry);
+
+  if (ap_entry->hash != a_hash)
+    {
+      return false;
+    }
+
+  return ap_idx->str_keys
+           ? 0 == strncmp ((const char *) ap_entry->p_key,
+                           (const char *) ap_key, OMX_MAX_STRINGNAME_SIZE)
+           : ap_entry->p_key == ap_key;
+}
+
+static void
+index_link (tiz_core_index_entry_t ** pp_buckets, OMX_U32 a_nbuckets,
+            tiz_core_index_entry_t * ap_entry)
+{
+  tiz_core_index_entry_t ** pp_tail = &pp_buckets[ap_entry->hash
+                                                  & (a_nbuckets - 1)];
+  while (*pp_tail)
+    {
+      pp_tail = &((*pp_tail)->p_next);
+    }
+  ap_entry->p_next = NULL;
+  *pp_tail = ap_entry;
+}
+
+static OMX_ERRORTYPE
+index_grow (tiz_core_index_t * ap_idx)
+{
+  tiz_core_index_entry_t ** pp_buckets = NULL;
+  tiz_core_index_entry_t * p_entry = NULL;
+  tiz_core_index_entry_t * p_next = NULL;
+  OMX_U32 nbuckets = 0;
+  OMX_U32 i = 0;
+
+  assert (ap_idx);
+
+  nbuckets = ap_idx->nbuckets > 0 ? ap_idx->nbuckets * 2
+                                  : TIZ_CORE_INDEX_MIN_BUCKETS;
+  if (NULL == (pp_buckets = (tiz_core_index_entry_t **) tiz_mem_calloc (
+                 nbuckets, sizeof (tiz_core_index_entry_t *))))
+    {
+      return OMX_ErrorInsufficientResources;
+    }
+
+  /* Buckets are walked in order, so entries with equal keys keep their
+   * relative order */
+  for (i = 0; i < ap_idx->nbuckets; ++i)
+    {
+      for (p_entry = ap_idx->pp_buckets[i]; p_entry; p_entry = p_next)
+        {
+          p_next = p_entry->p_next;
+          index_link (pp_buckets, nbuckets, p_entry);
+        }
+    }
+
+  tiz_mem_free (ap_idx->pp_buckets);
+  ap_idx->pp_buckets = pp_buckets;
+  ap_idx->nbuckets = nbuckets;
+
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+index_insert (tiz_core_index_t * ap_idx, OMX_PTR ap_key,
+              tiz_core_registry_item_t * ap_reg_item, OMX_PTR ap_dl_hdl)
+{
+  tiz_core_index_entry_t * p_entry = NULL;
+
+  assert (ap_idx);
+  assert (ap_key);
+
+  if (ap_idx->nentries >= ap_idx->nbuckets)
+    {
+      tiz_check_omx (index_grow (ap_idx));
+    }
+
+  if (NULL == (p_entry = (tiz_core_index_entry_t *) tiz_mem_calloc (
+                 1, sizeof (tiz_core_index_entry_t))))
+    {
+      return OMX_ErrorInsufficientResources;
+    }
+
+  p_entry->p_key = ap_key;
+  p_entry->hash = index_hash (ap_idx, ap_key);
+  p_entry->p_reg_item = ap_reg_item;
+  p_entry->p_dl_hdl = ap_dl_hdl;
+  index_link (ap_idx->pp_buckets, ap_idx->nbuckets, p_entry);
+  ap_idx->nentries++;
+
+  return OMX_ErrorNone;
+}
+
+/* Returns the a_index-th entry with the given key */
+static tiz_core_index_entry_t *
+index_find (const tiz_core_index_t * ap_idx, const OMX_PTR ap_key,
+            OMX_U32 a_index)
+{
+  tiz_core_index_entry_t * p_entry = NULL;
+  OMX_U32 hash = 0;
+
+  assert (ap_idx);
+  assert (ap_key);
+
+  if (0 == ap_idx->nentries)
+    {
+      return NULL;
+    }
+
+  hash = index_hash (ap_idx, ap_key);
+  for (p_entry = ap_idx->pp_buckets[hash & (ap_idx->nbuckets - 1)]; p_entry;
+       p_entry = p_entry->p_next)
+    {
+      if (index_key_equals (ap_idx, p_entry, ap_key, hash) && 0 == a_index--)
+        {
+          break;
+        }
+    }
+
+  return p_entry;
+}
+
+/* Unlinks the first entry with the given key. The caller owns the returned
+ * entry. */
+static tiz_core_index_entry_t *
+index_take (tiz_core_index_t * ap_idx, const OMX_PTR ap_key)
+{
+  tiz_core_index_entry_t ** pp_entry = NULL;
+  tiz_core_index_entry_t * p_entry = NULL;
+  OMX_U32 hash = 0;
+
+  assert (ap_idx);
+  assert (ap_key);
+
+  if (0 == ap_idx->nentries)
+    {
+      return NULL;
+    }
+
+  hash = index_hash (ap_idx, ap_key);
+  for (pp_entry = &ap_idx->pp_buckets[hash & (ap_idx->nbuckets - 1)];
+       *pp_entry; pp_entry = &((*pp_entry)->p_next))
+    {
+      if (index_key_equals (ap_idx, *pp_entry, ap_key, hash))
+        {
+          p_entry = *pp_entry;
+          *pp_entry = p_entry->p_next;
+          p_entry->p_next = NULL;
+          ap_idx->nentries--;
+          break;
+        }
+    }
+
+  return p_entry;
+}
+
+/* Removes every entry that refers to the given registry item */
+static void
+index_remove_item (tiz_core_index_t * ap_idx,
+                   const tiz_core_registry_item_t * ap_reg_item)
+{
+  tiz_core_index_entry_t ** pp_entry = NULL;
+  tiz_core_index_entry_t * p_entry = NULL;
+  OMX_U32 i = 0;
+
+  assert (ap_idx);
+
+  for (i = 0; i < ap_idx->nbuckets; ++i)
+    {
+      pp_entry = &ap_idx->pp_buckets[i];
+      while (*pp_entry)
+        {
+          if ((*pp_entry)->p_reg_item == ap_reg_item)
+            {
+              p_entry = *pp_entry;
+              *pp_entry = p_entry->p_next;
+              tiz_mem_free (p_entry);
+              ap_idx->nentries--;
+            }
+          else
+            {
+              pp_entry = &((*pp_entry)->p_next);
+            }
+        }
+    }
+}
+
+static void
+index_clear (tiz_core_index_t * ap_idx)
+{
+  tiz_core_index_entry_t * p_entry = NULL;
+  tiz_core_index_entry_t * p_next = NULL;
+  OMX_U32 i = 0;
+
+  assert (ap_idx);
+
+  for (i = 0; i < ap_idx->nbuckets; ++i)
+    {
+      for (p_entry = ap_idx->pp_buckets[i]; p_entry; p_entry = p_next)
+        {
+          p_next = p_entry->p_next;
+          tiz_mem_free (p_entry);
+        }
+    }
+
+  tiz_mem_free (ap_idx->pp_buckets);
+  ap_idx->pp_buckets = NULL;
+  ap_idx->nbuckets = 0;
+  ap_idx->nentries = 0;
+}
+
 static void
 wait_complete (OMX_U32 rid, OMX_PTR ap_data)
 {
@@ -434,10 +719,74 @@ get_component_roles (OMX_COMPONENTTYPE * ap_hdl, role_list_t * app_role_list)
   return rc;
 }
 
+static OMX_ERRORTYPE
+append_to_registry (tiz_core_registry_item_t * ap_reg_item)
+{
+  tiz_core_t * p_core = get_core ();
+  tiz_core_registry_item_t * p_registry_last = NULL;
+  role_list_item_t * p_role = NULL;
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+
+  assert (p_core);
+  assert (ap_reg_item);
+  assert (ap_reg_item->p_comp_name);
+
+  rc = index_insert (&(p_core->names), ap_reg_item->p_comp_name, ap_reg_item,
+                     NULL);
+  for (p_role = ap_reg_item->p_roles; p_role && OMX_ErrorNone == rc;
+       p_role = p_role->p_next)
+    {
+      rc = index_insert (&(p_core->roles), p_role->role, ap_reg_item, NULL);
+    }
+
+  if (OMX_ErrorNone != rc)
+    {
+      TIZ_LOG (TIZ_PRIORITY_ERROR, "[%s] : Could not index component [%s]",
+               tiz_err_to_str (rc), ap_reg_item->p_comp_name);
+      index_remove_item (&(p_core->names), ap_reg_item);
+      index_remove_item (&(p_core->roles), ap_reg_item);
+      return rc;
+    }
+
+  ap_reg_item->p_next = NULL;
+
+  if (NULL == (p_core->p_registry))
+    {
+      /* First entry in the registry */
+      TIZ_LOG (TIZ_PRIORITY_TRACE, "Component added (first component) [%s]",
+               ap_reg_item->p_comp_name);
+      p_core->p_registry = ap_reg_item;
+    }
+  else
+    {
+      /* Find the last entry in the registry */
+      p_registry_last = p_core->p_registry;
+      while (p_registry_last->p_next)
+        {
+          p_registry_last = p_registry_last->p_next;
+        }
+      p_registry_last->p_next = ap_reg_item;
+    }
+
+  return OMX_ErrorNone;
+}
+
+static void
+free_registry_item (tiz_core_registry_item_t * ap_reg_item)
+{
+  if (ap_reg_item)
+    {
+      tiz_mem_free (ap_reg_item->p_comp_name);
+      tiz_mem_free (ap_reg_item->p_dl_name);
+      tiz_mem_free (ap_reg_item->p_dl_path);
+      free_roles (ap_reg_item->p_roles);
+      tiz_mem_free (ap_reg_item);
+    }
+}
+
 static OMX_ERRORTYPE
 add_to_comp_registry (const OMX_STRING ap_dl_path, const OMX_STRING ap_dl_name,
-                      OMX_PTR ap_entry_point, OMX_PTR ap_dl_hdl,
-                      OMX_COMPONENTTYPE * ap_hdl,
+                      OMX_PTR ap_entry_point, OMX_COMPONENTTYPE * ap_hdl,
                       tiz_core_registry_item_t ** app_reg_item)
 {
   OMX_ERRORTYPE rc = OMX_ErrorNone;
@@ -446,14 +795,12 @@ add_to_comp_registry (const OMX_STRING ap_dl_path, const OMX_STRING ap_dl_name,
   tiz_core_registry_item_t * p_registry_last = NULL;
   tiz_core_registry_item_t * p_registry_new = NULL;
   role_list_t p_role_list = NULL;
-  tiz_core_t * p_core = get_core ();
   char comp_name[OMX_MAX_STRINGNAME_SIZE];
 
   TIZ_LOG (TIZ_PRIORITY_TRACE, "dl_name [%s]", ap_dl_name);
 
   assert (ap_dl_name);
   assert (ap_entry_point);
-  assert (p_core);
   assert (ap_hdl);
   assert (app_reg_item);
 
@@ -528,43 +875,28 @@ add_to_comp_registry (const OMX_STRING ap_dl_path, const OMX_STRING ap_dl_name,
   if (OMX_ErrorNone == rc)
     {
 
-      /* Add to registry */
-      if (NULL == (p_core->p_registry))
-        {
-          /* First entry in the registry */
-          TIZ_LOG (TIZ_PRIORITY_TRACE, "Component added (first component) [%s]",
-                   comp_name);
-
-          p_core->p_registry = p_registry_new;
-        }
-      else
-        {
-          /* Find the last entry in the registry */
-          p_registry_last = p_core->p_registry;
-          while (true)
-            {
-              if (p_registry_last->p_next)
-                {
-                  p_registry_last = p_registry_last->p_next;
-                }
-              else
-                {
-                  break;
-                }
-            }
-          p_registry_last->p_next = p_registry_new;
-        }
-
-      /* Finish filling the registry entry... */
+      /* Fill the registry entry... */
       p_registry_new->p_comp_name
         = strndup (comp_name, OMX_MAX_STRINGNAME_SIZE);
       p_registry_new->p_dl_name = strndup (ap_dl_name, NAME_MAX);
       p_registry_new->p_dl_path = strndup (ap_dl_path, PATH_MAX);
       p_registry_new->p_entry_point = ap_entry_point;
-      p_registry_new->p_dl_hdl = ap_dl_hdl;
-      p_registry_new->p_hdl = ap_hdl;
       p_registry_new->p_roles = p_role_list;
 
+      /* ... and add it to the registry */
+      if (!p_registry_new->p_comp_name || !p_registry_new->p_dl_name
+          || !p_registry_new->p_dl_path
+          || OMX_ErrorNone != append_to_registry (p_registry_new))
+        {
+          TIZ_LOG (TIZ_PRIORITY_ERROR,
+                   "[OMX_ErrorInsufficientResources] : "
+                   "Could not add [%s] to the registry.",
+                   comp_name);
+          free_registry_item (p_registry_new);
+          (void) ap_hdl->ComponentDeInit ((OMX_HANDLETYPE) ap_hdl);
+          return OMX_ErrorInsufficientResources;
+        }
+
       /* TODO: move this to its own function */
       TIZ_LOG (TIZ_PRIORITY_TRACE, "Component [%s] added.",
                p_registry_new->p_comp_name);
@@ -572,8 +904,6 @@ add_to_comp_registry (const OMX_STRING ap_dl_path, const OMX_STRING ap_dl_name,
       TIZ_LOG (TIZ_PRIORITY_TRACE, "dl_path [%s].", p_registry_new->p_dl_path);
       TIZ_LOG (TIZ_PRIORITY_TRACE, "dl_entry_point [%p].",
                p_registry_new->p_entry_point);
-      TIZ_LOG (TIZ_PRIORITY_TRACE, "p_dl_hdl [%p].", p_registry_new->p_dl_hdl);
-      TIZ_LOG (TIZ_PRIORITY_TRACE, "p_hdl [%p].", p_registry_new->p_hdl);
 
       *app_reg_item = p_registry_new;
     }
@@ -588,7 +918,17 @@ delete_registry (void)
 {
   tiz_core_t * p_core = get_core ();
   tiz_core_registry_item_t *p_registry_last = NULL, *p_registry_next = NULL;
-  role_list_item_t *p_roles_last = NULL, *p_roles_next = NULL;
+
+  index_clear (&(p_core->names));
+  index_clear (&(p_core->roles));
+  index_clear (&(p_core->handles));
+
+  while (p_core->p_retired)
+    {
+      p_registry_next = p_core->p_retired->p_next;
+      free_registry_item (p_core->p_retired);
+      p_core->p_retired = p_registry_next;
+    }
 
   if (NULL == p_core->p_registry)
     {
@@ -598,21 +938,8 @@ delete_registry (void)
   p_registry_last = p_core->p_registry;
   while (p_registry_last)
     {
-      tiz_mem_free (p_registry_last->p_comp_name);
-      tiz_mem_free (p_registry_last->p_dl_name);
-      tiz_mem_free (p_registry_last->p_dl_path);
-
-      /* Delete roles */
-      p_roles_last = p_registry_last->p_roles;
-      while (p_roles_last)
-        {
-          p_roles_next = p_roles_last->p_next;
-          tiz_mem_free (p_roles_last);
-          p_roles_last = p_roles_next;
-        }
-
       p_registry_next = p_registry_last->p_next;
-      tiz_mem_free (p_registry_last);
+      free_registry_item (p_registry_last);
       p_registry_last = p_registry_next;
     }
 
@@ -671,7 +998,8 @@ instantiate_comp_lib (const OMX_STRING ap_path, const OMX_STRING ap_name,
 }
 
 static OMX_ERRORTYPE
-cache_comp_info (const OMX_STRING ap_dl_path, const OMX_STRING ap_dl_name)
+cache_comp_info (const OMX_STRING ap_dl_path, const OMX_STRING ap_dl_name,
+                 const struct stat * ap_dl_stat)
 {
   OMX_PTR p_dl_hdl = NULL;
   OMX_PTR p_entry_point = NULL;
@@ -700,13 +1028,19 @@ cache_comp_info (const OMX_STRING ap_dl_path, const OMX_STRING ap_dl_name)
       else
         {
           if (OMX_ErrorNone == (rc = add_to_comp_registry (
-                                  ap_dl_path, ap_dl_name, p_entry_point, NULL,
-                                  p_hdl, &p_reg_item)))
+                                  ap_dl_path, ap_dl_name, p_entry_point, p_hdl,
+                                  &p_reg_item)))
             {
-              assert (p_reg_item && p_reg_item->p_hdl);
+              assert (p_reg_item);
               TIZ_LOG (TIZ_PRIORITY_TRACE, "component [%s] : info cached",
                        p_reg_item->p_comp_name);
-              p_reg_item->p_hdl = NULL;
+              if (ap_dl_stat)
+                {
+                  p_reg_item->dl_mtime = ap_dl_stat->st_mtim;
+                  p_reg_item->dl_size = ap_dl_stat->st_size;
+                  p_reg_item->dl_ino = ap_dl_stat->st_ino;
+                }
+              get_core ()->registry_cache_dirty = true;
             }
 
           /* delete the comp hadle */
@@ -767,6 +1101,469 @@ free_paths (char ** pp_paths, unsigned long npaths)
   tiz_mem_free (pp_paths);
 }
 
+static const char *
+registry_cache_path (char * ap_buf, size_t a_buf_len)
+{
+  const char * p_path
+    = tiz_rcfile_get_value ("ilcore", "component-registry-cache");
+  const char * p_env = NULL;
+
+  assert (ap_buf);
+
+  if (p_path && 0 == strncmp (p_path, TIZ_CORE_REGISTRY_CACHE_NONE,
+                              sizeof (TIZ_CORE_REGISTRY_CACHE_NONE)))
+    {
+      return NULL;
+    }
+
+  if (p_path && strlen (p_path) > 0)
+    {
+      snprintf (ap_buf, a_buf_len, "%s", p_path);
+    }
+  else if ((p_env = getenv ("XDG_CACHE_HOME")) && strlen (p_env) > 0)
+    {
+      snprintf (ap_buf, a_buf_len, "%s/%s", p_env,
+                TIZ_CORE_REGISTRY_CACHE_FILE);
+    }
+  else if ((p_env = getenv ("HOME")) && strlen (p_env) > 0)
+    {
+      snprintf (ap_buf, a_buf_len, "%s/.cache/%s", p_env,
+                TIZ_CORE_REGISTRY_CACHE_FILE);
+    }
+  else
+    {
+      return NULL;
+    }
+
+  return ap_buf;
+}
+
+/* Creates the missing directories in the path of the cache file, readable
+ * by the user only */
+static void
+make_registry_cache_dir (const char * ap_path)
+{
+  char dir[PATH_MAX];
+  char * p = NULL;
+
+  assert (ap_path);
+
+  snprintf (dir, sizeof (dir), "%s", ap_path);
+  for (p = strchr (dir + 1, '/'); p; p = strchr (p + 1, '/'))
+    {
+      *p = '\0';
+      if (0 != mkdir (dir, 0700) && EEXIST != errno)
+        {
+          TIZ_LOG (TIZ_PRIORITY_NOTICE, "Unable to create [%s] - [%s]", dir,
+                   strerror (errno));
+          return;
+        }
+      *p = '/';
+    }
+}
+
+static bool
+dl_stat_matches (const tiz_core_registry_item_t * ap_reg_item,
+                 const struct stat * ap_dl_stat)
+{
+  assert (ap_reg_item);
+  assert (ap_dl_stat);
+  return (ap_reg_item->dl_size == ap_dl_stat->st_size
+          && ap_reg_item->dl_ino == ap_dl_stat->st_ino
+          && ap_reg_item->dl_mtime.tv_sec == ap_dl_stat->st_mtim.tv_sec
+          && ap_reg_item->dl_mtime.tv_nsec == ap_dl_stat->st_mtim.tv_nsec);
+}
+
+static bool
+dl_item_matches (const tiz_core_registry_item_t * ap_reg_item,
+                 const OMX_STRING ap_dl_path, const OMX_STRING ap_dl_name)
+{
+  assert (ap_reg_item);
+  return (0 == strncmp (ap_reg_item->p_dl_path, ap_dl_path, PATH_MAX)
+          && 0 == strncmp (ap_reg_item->p_dl_name, ap_dl_name, NAME_MAX));
+}
+
+/* Parses one line of the registry cache file. The fields are tab-separated:
+ * dl_path, dl_name, mtime secs, mtime nsecs, size, inode, component name and
+ * one or more roles. */
+static tiz_core_registry_item_t *
+parse_registry_cache_line (char * ap_line)
+{
+  tiz_core_registry_item_t * p_item = NULL;
+  role_list_item_t * p_last_role = NULL;
+  char * p_save = NULL;
+  char * p_fields[7];
+  char * p_role = NULL;
+  size_t i = 0;
+
+  assert (ap_line);
+
+  for (i = 0; i < 7; ++i)
+    {
+      if (NULL == (p_fields[i] = strtok_r (i == 0 ? ap_line : NULL, "\t\n",
+                                           &p_save)))
+        {
+          return NULL;
+        }
+    }
+
+  if (NULL == (p_item = (tiz_core_registry_item_t *) tiz_mem_calloc (
+                 1, sizeof (tiz_core_registry_item_t))))
+    {
+      return NULL;
+    }
+
+  p_item->p_dl_path = strndup (p_fields[0], PATH_MAX);
+  p_item->p_dl_name = strndup (p_fields[1], NAME_MAX);
+  p_item->dl_mtime.tv_sec = (time_t) strtoll (p_fields[2], NULL, 10);
+  p_item->dl_mtime.tv_nsec = strtol (p_fields[3], NULL, 10);
+  p_item->dl_size = (off_t) strtoll (p_fields[4], NULL, 10);
+  p_item->dl_ino = (ino_t) strtoull (p_fields[5], NULL, 10);
+  p_item->p_comp_name = strndup (p_fields[6], OMX_MAX_STRINGNAME_SIZE);
+
+  while ((p_role = strtok_r (NULL, "\t\n", &p_save)))
+    {
+      role_list_item_t * p_rli
+        = (role_list_item_t *) tiz_mem_calloc (1, sizeof (role_list_item_t));
+      if (NULL == p_rli)
+        {
+          free_registry_item (p_item);
+          return NULL;
+        }
+      strncpy ((char *) p_rli->role, p_role, OMX_MAX_STRINGNAME_SIZE);
+      p_rli->role[OMX_MAX_STRINGNAME_SIZE - 1] = '\0';
+      if (p_last_role)
+        {
+          p_last_role->p_next = p_rli;
+        }
+      else
+        {
+          p_item->p_roles = p_rli;
+        }
+      p_last_role = p_rli;
+    }
+
+  if (!p_item->p_dl_path || !p_item->p_dl_name || !p_item->p_comp_name
+      || !p_item->p_roles)
+    {
+      free_registry_item (p_item);
+      return NULL;
+    }
+
+  return p_item;
+}
+
+static void
+load_registry_cache (void)
+{
+  tiz_core_t * p_core = get_core ();
+  tiz_core_registry_item_t * p_last = NULL;
+  tiz_core_registry_item_t * p_item = NULL;
+  char path[PATH_MAX];
+  char * p_line = NULL;
+  size_t line_len = 0;
+  FILE * p_file = NULL;
+  struct stat cache_stat;
+  int fd = -1;
+
+  assert (p_core);
+  assert (NULL == p_core->p_registry_cache);
+
+  if (NULL == registry_cache_path (path, sizeof (path)))
+    {
+      return;
+    }
+
+  if ((fd = open (path, O_RDONLY | O_NOFOLLOW | O_CLOEXEC)) < 0)
+    {
+      TIZ_LOG (TIZ_PRIORITY_TRACE, "No registry cache at [%s] - [%s]", path,
+               strerror (errno));
+      return;
+    }
+
+  /* The cache decides which libraries get dlopen'ed: only trust a file that
+   * nobody else could have written */
+  if (0 != fstat (fd, &cache_stat) || !S_ISREG (cache_stat.st_mode)
+      || cache_stat.st_uid != getuid ()
+      || 0 != (cache_stat.st_mode & (S_IWGRP | S_IWOTH)))
+    {
+      TIZ_LOG (TIZ_PRIORITY_NOTICE, "Ignoring untrusted registry cache [%s]",
+               path);
+      (void) close (fd);
+      p_core->registry_cache_dirty = true;
+      return;
+    }
+
+  if (NULL == (p_file = fdopen (fd, "r")))
+    {
+      (void) close (fd);
+      return;
+    }
+
+  if (getline (&p_line, &line_len, p_file) <= 0
+      || 0 != strncmp (p_line, TIZ_CORE_REGISTRY_CACHE_MAGIC,
+                       sizeof (TIZ_CORE_REGISTRY_CACHE_MAGIC) - 1))
+    {
+      TIZ_LOG (TIZ_PRIORITY_NOTICE, "Ignoring invalid registry cache [%s]",
+               path);
+      p_core->registry_cache_dirty = true;
+    }
+  else
+    {
+      while (getline (&p_line, &line_len, p_file) > 0)
+        {
+          if (NULL == (p_item = parse_registry_cache_line (p_line)))
+            {
+              TIZ_LOG (TIZ_PRIORITY_NOTICE,
+                       "Discarding malformed registry cache entry");
+              p_core->registry_cache_dirty = true;
+              continue;
+            }
+
+          if (p_last)
+            {
+              p_last->p_next = p_item;
+            }
+          else
+            {
+              p_core->p_registry_cache = p_item;
+            }
+          p_last = p_item;
+        }
+    }
+
+  free (p_line);
+  (void) fclose (p_file);
+}
+
+static void
+save_registry_cache (void)
+{
+  tiz_core_t * p_core = get_core ();
+  tiz_core_registry_item_t * p_item = NULL;
+  role_list_item_t * p_role = NULL;
+  char path[PATH_MAX];
+  char tmp_path[PATH_MAX + 16];
+  FILE * p_file = NULL;
+  bool success = true;
+  int fd = -1;
+
+  assert (p_core);
+
+  if (NULL == registry_cache_path (path, sizeof (path)))
+    {
+      return;
+    }
+
+  make_registry_cache_dir (path);
+
+  /* Write to a new, private file first, so that concurrent processes never
+   * read a partially written cache */
+  snprintf (tmp_path, sizeof (tmp_path), "%s.XXXXXX", path);
+  if ((fd = mkstemp (tmp_path)) < 0)
+    {
+      TIZ_LOG (TIZ_PRIORITY_NOTICE, "Unable to write registry cache [%s] - [%s]",
+               tmp_path, strerror (errno));
+      return;
+    }
+
+  if (NULL == (p_file = fdopen (fd, "w")))
+    {
+      TIZ_LOG (TIZ_PRIORITY_NOTICE, "Unable to write registry cache [%s] - [%s]",
+               tmp_path, strerror (errno));
+      (void) close (fd);
+      (void) unlink (tmp_path);
+      return;
+    }
+
+  success = (fprintf (p_file, "%s\n", TIZ_CORE_REGISTRY_CACHE_MAGIC) > 0);
+
+  for (p_item = p_core->p_registry; p_item && success; p_item = p_item->p_next)
+    {
+      success = (fprintf (p_file, "%s\t%s\t%lld\t%ld\t%lld\t%llu\t%s",
+                          p_item->p_dl_path, p_item->p_dl_name,
+                          (long long) p_item->dl_mtime.tv_sec,
+                          (long) p_item->dl_mtime.tv_nsec,
+                          (long long) p_item->dl_size,
+                          (unsigned long long) p_item->dl_ino,
+                          p_item->p_comp_name)
+                 > 0);
+      for (p_role = p_item->p_roles; p_role && success; p_role = p_role->p_next)
+        {
+          success = (fprintf (p_file, "\t%s", (char *) p_role->role) > 0);
+        }
+      success = success && (fputc ('\n', p_file) != EOF);
+    }
+
+  if (0 != fclose (p_file))
+    {
+      success = false;
+    }
+
+  if (!success || 0 != rename (tmp_path, path))
+    {
+      TIZ_LOG (TIZ_PRIORITY_NOTICE, "Unable to write registry cache [%s] - [%s]",
+               path, strerror (errno));
+      (void) unlink (tmp_path);
+      return;
+    }
+
+  TIZ_LOG (TIZ_PRIORITY_TRACE, "Registry cache saved to [%s]", path);
+  p_core->registry_cache_dirty = false;
+}
+
+static void
+delete_registry_cache (void)
+{
+  tiz_core_t * p_core = get_core ();
+  tiz_core_registry_item_t * p_next = NULL;
+
+  assert (p_core);
+
+  while (p_core->p_registry_cache)
+    {
+      p_next = p_core->p_registry_cache->p_next;
+      free_registry_item (p_core->p_registry_cache);
+      p_core->p_registry_cache = p_next;
+      /* Whatever was left unclaimed belongs to a plugin that is gone */
+      p_core->registry_cache_dirty = true;
+    }
+}
+
+/* Removes and returns the cache entry of the given plugin, if there is one */
+static tiz_core_registry_item_t *
+take_from_registry_cache (const OMX_STRING ap_dl_path,
+                          const OMX_STRING ap_dl_name)
+{
+  tiz_core_t * p_core = get_core ();
+  tiz_core_registry_item_t * p_prev = NULL;
+  tiz_core_registry_item_t * p_item = NULL;
+
+  assert (p_core);
+
+  for (p_item = p_core->p_registry_cache; p_item; p_item = p_item->p_next)
+    {
+      if (dl_item_matches (p_item, ap_dl_path, ap_dl_name))
+        {
+          if (p_prev)
+            {
+              p_prev->p_next = p_item->p_next;
+            }
+          else
+            {
+              p_core->p_registry_cache = p_item->p_next;
+            }
+          p_item->p_next = NULL;
+          break;
+        }
+      p_prev = p_item;
+    }
+
+  return p_item;
+}
+
+/* Takes the item of a plugin that changed on disk out of the registry, so
+ * that the plugin can be registered again */
+static void
+retire_registry_item (tiz_core_registry_item_t * ap_reg_item)
+{
+  tiz_core_t * p_core = get_core ();
+  tiz_core_registry_item_t ** pp_item = NULL;
+
+  assert (p_core);
+  assert (ap_reg_item);
+
+  for (pp_item = &(p_core->p_registry); *pp_item;
+       pp_item = &((*pp_item)->p_next))
+    {
+      if (*pp_item == ap_reg_item)
+        {
+          *pp_item = ap_reg_item->p_next;
+          break;
+        }
+    }
+
+  index_remove_item (&(p_core->names), ap_reg_item);
+  index_remove_item (&(p_core->roles), ap_reg_item);
+  ap_reg_item->p_next = p_core->p_retired;
+  p_core->p_retired = ap_reg_item;
+  p_core->registry_cache_dirty = true;
+}
+
+static tiz_core_registry_item_t *
+find_dl_in_registry (const OMX_STRING ap_dl_path, const OMX_STRING ap_dl_name)
+{
+  tiz_core_t * p_core = get_core ();
+  tiz_core_registry_item_t * p_item = NULL;
+
+  assert (p_core);
+
+  for (p_item = p_core->p_registry; p_item; p_item = p_item->p_next)
+    {
+      if (dl_item_matches (p_item, ap_dl_path, ap_dl_name))
+        {
+          break;
+        }
+    }
+
+  return p_item;
+}
+
+/* Registers the component in the given plugin. The plugin is only dlopen'ed
+ * when neither the registry nor the registry cache hold up to date
+ * information about it. */
+static OMX_ERRORTYPE
+register_comp_lib (const OMX_STRING ap_dl_path, const OMX_STRING ap_dl_name)
+{
+  char full_name[PATH_MAX];
+  struct stat dl_stat;
+  tiz_core_registry_item_t * p_reg_item = NULL;
+
+  assert (ap_dl_path);
+  assert (ap_dl_name);
+
+  snprintf (full_name, sizeof (full_name), "%s/%s", ap_dl_path, ap_dl_name);
+  if (0 != stat (full_name, &dl_stat))
+    {
+      TIZ_LOG (TIZ_PRIORITY_ERROR, "Unable to stat [%s] - [%s]", full_name,
+               strerror (errno));
+      return cache_comp_info (ap_dl_path, ap_dl_name, NULL);
+    }
+
+  if ((p_reg_item = find_dl_in_registry (ap_dl_path, ap_dl_name)))
+    {
+      if (dl_stat_matches (p_reg_item, &dl_stat))
+        {
+          TIZ_LOG (TIZ_PRIORITY_TRACE, "[%s] : already registered",
+                   p_reg_item->p_comp_name);
+          return OMX_ErrorNone;
+        }
+      TIZ_LOG (TIZ_PRIORITY_NOTICE, "[%s] : [%s] has changed",
+               p_reg_item->p_comp_name, full_name);
+      retire_registry_item (p_reg_item);
+    }
+
+  if ((p_reg_item = take_from_registry_cache (ap_dl_path, ap_dl_name)))
+    {
+      if (dl_stat_matches (p_reg_item, &dl_stat)
+          && NULL == find_comp_in_registry (p_reg_item->p_comp_name))
+        {
+          TIZ_LOG (TIZ_PRIORITY_TRACE, "[%s] : registered from cache",
+                   p_reg_item->p_comp_name);
+          if (OMX_ErrorNone != append_to_registry (p_reg_item))
+            {
+              free_registry_item (p_reg_item);
+              return OMX_ErrorInsufficientResources;
+            }
+          return OMX_ErrorNone;
+        }
+      free_registry_item (p_reg_item);
+      get_core ()->registry_cache_dirty = true;
+    }
+
+  return cache_comp_info (ap_dl_path, ap_dl_name, &dl_stat);
+}
+
 static OMX_ERRORTYPE
 scan_component_folders (void)
 {
@@ -782,6 +1579,11 @@ scan_component_folders (void)
       return OMX_ErrorInsufficientResources;
     }
 
+  if (NULL == get_core ()->p_registry)
+    {
+      load_registry_cache ();
+    }
+
   for (i = 0; i < (int) npaths; i++)
     {
       TIZ_LOG (TIZ_PRIORITY_TRACE, "Looking for component plugins : %s",
@@ -806,10 +1608,12 @@ scan_component_folders (void)
                   if (p_dir_entry->d_type == DT_REG)
                     {
                       if (OMX_ErrorInsufficientResources
-                          == cache_comp_info (pp_paths[i], p_dir_entry->d_name))
+                          == register_comp_lib (pp_paths[i],
+                                                p_dir_entry->d_name))
                         {
                           (void) closedir (p_dir);
                           free_paths (pp_paths, npaths);
+                          delete_registry_cache ();
                           return OMX_ErrorInsufficientResources;
                         }
                     }
@@ -822,6 +1626,12 @@ scan_component_folders (void)
 
   free_paths (pp_paths, npaths);
 
+  delete_registry_cache ();
+  if (get_core ()->registry_cache_dirty)
+    {
+      save_registry_cache ();
+    }
+
   return OMX_ErrorNone;
 }
 
@@ -829,106 +1639,40 @@ static tiz_core_registry_item_t *
 find_role_in_registry (const OMX_STRING ap_role_str, OMX_U32 a_index)
 {
   tiz_core_t * p_core = get_core ();
-  tiz_core_registry_t p_registry = NULL;
-  role_list_item_t * p_role = NULL;
-  OMX_U32 num_components_found = 0;
+  tiz_core_index_entry_t * p_entry = NULL;
 
   assert (p_core);
   assert (ap_role_str);
 
-  p_registry = p_core->p_registry;
-
-  while (p_registry && num_components_found < a_index + 1)
-    {
-      p_role = p_registry->p_roles;
-      while (p_role)
-        {
-          if (0 == strncmp ((OMX_STRING) p_role->role, ap_role_str,
-                            OMX_MAX_STRINGNAME_SIZE))
-            {
-              num_components_found++;
-              TIZ_LOG (TIZ_PRIORITY_TRACE,
-                       "[%s] found - comp [%s] "
-                       "num comps [%d].",
-                       ap_role_str, p_registry->p_comp_name,
-                       num_components_found);
-              break;
-            }
-          p_role = p_role->p_next;
-        }
-
-      if (num_components_found < a_index + 1)
-        {
-          p_registry = p_registry->p_next;
-        }
-    }
-
-  if (num_components_found < a_index + 1)
+  if (NULL == (p_entry = index_find (&(p_core->roles), ap_role_str, a_index)))
     {
       TIZ_LOG (TIZ_PRIORITY_TRACE, "Could not find [%s] index [%d].",
                ap_role_str, a_index);
-      /* Make sure we return null in this case */
-      p_registry = NULL;
+      return NULL;
     }
 
-  return p_registry;
+  TIZ_LOG (TIZ_PRIORITY_TRACE, "[%s] found - comp [%s] index [%d].",
+           ap_role_str, p_entry->p_reg_item->p_comp_name, a_index);
+  return p_entry->p_reg_item;
 }
 
 static tiz_core_registry_item_t *
 find_comp_in_registry (const OMX_STRING ap_name)
 {
   tiz_core_t * p_core = get_core ();
-  tiz_core_registry_t p_registry = NULL;
+  tiz_core_index_entry_t * p_entry = NULL;
 
   assert (p_core);
   assert (ap_name);
 
-  p_registry = p_core->p_registry;
-
-  while (p_registry)
-    {
-      if (0 == strncmp (p_registry->p_comp_name, ap_name,
-                        OMX_MAX_STRINGNAME_SIZE))
-        {
-          TIZ_LOG (TIZ_PRIORITY_TRACE, "[%s] found.", ap_name);
-          return p_registry;
-        }
-      p_registry = p_registry->p_next;
-    }
-
-  TIZ_LOG (TIZ_PRIORITY_TRACE, "Could not find [%s].", ap_name);
-
-  return p_registry;
-}
-
-static tiz_core_registry_item_t *
-find_hdl_in_registry (OMX_HANDLETYPE ap_hdl)
-{
-
-  tiz_core_t * p_core = get_core ();
-  tiz_core_registry_t p_registry = NULL;
-
-  assert (p_core);
-  assert (ap_hdl);
-
-  p_registry = p_core->p_registry;
-
-  while (p_registry)
+  if (NULL == (p_entry = index_find (&(p_core->names), ap_name, 0)))
     {
-      if (p_registry->p_hdl == ap_hdl)
-        {
-          TIZ_LOG (TIZ_PRIORITY_TRACE, "[%s] found.", p_registry->p_comp_name);
-          break;
-        }
-      p_registry = p_registry->p_next;
-    }
-
-  if (NULL == p_registry)
-    {
-      TIZ_LOG (TIZ_PRIORITY_TRACE, "Could not find hdl [%p].", ap_hdl);
+      TIZ_LOG (TIZ_PRIORITY_TRACE, "Could not find [%s].", ap_name);
+      return NULL;
     }
 
-  return p_registry;
+  TIZ_LOG (TIZ_PRIORITY_TRACE, "[%s] found.", ap_name);
+  return p_entry->p_reg_item;
 }
 
 static inline OMX_ERRORTYPE
@@ -994,9 +1738,22 @@ instantiate_component (tiz_core_msg_gethandle_t * ap_msg)
               return rc;
             }
 
+          /* Track the instance, so that FreeHandle can find the registry
+             item and the library handle */
+          if (OMX_ErrorNone
+              != (rc = index_insert (&(get_core ()->handles), p_hdl,
+                                     p_reg_item, p_dl_hdl)))
+            {
+              TIZ_LOG (TIZ_PRIORITY_ERROR,
+                       "[%s] : Could not register the component instance",
+                       tiz_err_to_str (rc));
+              (void) p_hdl->ComponentDeInit ((OMX_HANDLETYPE) p_hdl);
+              tiz_mem_free (p_hdl);
+              dlclose (p_dl_hdl);
+              return rc;
+            }
+
           *(ap_msg->pp_hdl) = p_hdl;
-          p_reg_item->p_hdl = p_hdl;
-          p_reg_item->p_dl_hdl = p_dl_hdl;
         }
     }
   else
@@ -1016,15 +1773,15 @@ remove_comp_instance (tiz_core_msg_freehandle_t * ap_msg)
 {
   OMX_ERRORTYPE rc = OMX_ErrorNone;
   OMX_COMPONENTTYPE * p_hdl = NULL;
-  tiz_core_registry_item_t * p_reg_item = NULL;
+  tiz_core_index_entry_t * p_entry = NULL;
 
   TIZ_LOG (TIZ_PRIORITY_TRACE, "Removing component instance...");
 
-  if ((p_reg_item = find_hdl_in_registry (ap_msg->p_hdl)))
+  if ((p_entry = index_take (&(get_core ()->handles), ap_msg->p_hdl)))
     {
-
-      p_hdl = (OMX_COMPONENTTYPE *) p_reg_item->p_hdl;
+      p_hdl = (OMX_COMPONENTTYPE *) p_entry->p_key;
       assert (p_hdl);
+      assert (p_entry->p_reg_item);
 
       /* Unload the component */
       if (OMX_ErrorNone
@@ -1035,14 +1792,13 @@ remove_comp_instance (tiz_core_msg_freehandle_t * ap_msg)
       else
         {
           TIZ_LOG (TIZ_PRIORITY_TRACE, "Success - [%s] deleted ",
-                   p_reg_item->p_comp_name);
+                   p_entry->p_reg_item->p_comp_name);
         }
 
       /*  Deallocate the component hdl */
       tiz_mem_free (p_hdl);
-      p_reg_item->p_hdl = NULL;
-      dlclose (p_reg_item->p_dl_hdl);
-      p_reg_item->p_dl_hdl = NULL;
+      dlclose (p_entry->p_dl_hdl);
+      tiz_mem_free (p_entry);
     }
   else
     {
@@ -1214,7 +1970,6 @@ do_cre (tiz_core_state_t * ap_state, tiz_core_msg_t * ap_msg)
   tiz_core_msg_roleofcompenum_t * p_msg_cre = NULL;
   tiz_core_registry_item_t * p_reg_item = NULL;
   OMX_BOOL found = OMX_FALSE;
-  OMX_U32 i = 0;
 
   assert (ap_msg);
   assert (ap_state);
@@ -1232,22 +1987,15 @@ do_cre (tiz_core_state_t * ap_state, tiz_core_msg_t * ap_msg)
            "Role [%s] Index [%d]...",
            p_msg_cre->p_role, p_msg_cre->index);
 
-  /* Do the obvious linear search for now */
-  i = p_msg_cre->index;
-  while ((p_reg_item = find_role_in_registry (p_msg_cre->p_role, i)))
+  if ((p_reg_item = find_role_in_registry (p_msg_cre->p_role,
+                                           p_msg_cre->index)))
     {
-      if (p_msg_cre->index == i)
-        {
-          assert (p_reg_item->p_comp_name);
-          strncpy (p_msg_cre->p_comp_name,
-                   (const char *) p_reg_item->p_comp_name,
-                   OMX_MAX_STRINGNAME_SIZE);
-          /* Make sure the resulting string is null-terminated */
-          p_msg_cre->p_comp_name[OMX_MAX_STRINGNAME_SIZE - 1] = '\0';
-          found = OMX_TRUE;
-          break;
-        }
-      i++;
+      assert (p_reg_item->p_comp_name);
+      strncpy (p_msg_cre->p_comp_name, (const char *) p_reg_item->p_comp_name,
+               OMX_MAX_STRINGNAME_SIZE);
+      /* Make sure the resulting string is null-terminated */
+      p_msg_cre->p_comp_name[OMX_MAX_STRINGNAME_SIZE - 1] = '\0';
+      found = OMX_TRUE;
     }
 
   if (OMX_TRUE == found)
@@ -1418,6 +2166,12 @@ get_core (void)
       pg_core->error = OMX_ErrorNone;
       pg_core->state = ETIZCoreStateStarting;
       pg_core->p_registry = NULL;
+      pg_core->p_retired = NULL;
+      pg_core->names.str_keys = true;
+      pg_core->roles.str_keys = true;
+      pg_core->handles.str_keys = false;
+      pg_core->p_registry_cache = NULL;
+      pg_core->registry_cache_dirty = false;
 
       TIZ_LOG (TIZ_PRIORITY_TRACE, "IL Core initialization success.");
     }
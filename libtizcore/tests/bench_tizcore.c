@@ -0,0 +1,272 @@
+/**
+ * Copyright (C) 2011-2017 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   bench_tizcore.c
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Tizonia IL Core micro-benchmarks
+ *
+ * Not part of 'make check'. Run './bench_tizcore' to run all the benchmarks,
+ * or './bench_tizcore <name>...' to run only some of them. Uses the same
+ * configuration file and RM daemon as check_tizcore.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <limits.h>
+#include <time.h>
+#include <sys/types.h>
+
+#include <OMX_Core.h>
+
+#include <tizplatform.h>
+
+#include "check_tizcore.h"
+
+#ifdef TIZ_LOG_CATEGORY_NAME
+#undef TIZ_LOG_CATEGORY_NAME
+#define TIZ_LOG_CATEGORY_NAME "tiz.ilcore.bench"
+#endif
+
+#define TIZ_CORE_TEST_COMPONENT_NAME "OMX.Aratelia.ilcore.test_component"
+
+#define REGISTRY_BENCH_ROUNDS 20
+/* Total handles, and handles alive at once */
+#define HANDLE_BENCH_TOTAL 10000
+#define HANDLE_BENCH_BATCH 50
+
+#define BENCH_CHECK(expr)                                             \
+  do                                                                  \
+    {                                                                 \
+      if (!(expr))                                                    \
+        {                                                             \
+          fprintf (stderr, "%s:%d: check failed: %s\n", __FILE__,     \
+                   __LINE__, #expr);                                  \
+          abort ();                                                   \
+        }                                                             \
+    }                                                                 \
+  while (0)
+
+static inline double
+bench_now_secs (void)
+{
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static pid_t g_rmd_pid;
+
+static void
+start_rm_daemon (void)
+{
+  const char *p_rmdb_path
+    = tiz_rcfile_get_value ("resource-management", "rmdb");
+  const char *p_sqlite_path
+    = tiz_rcfile_get_value ("resource-management", "rmdb.sqlite_script");
+  const char *p_init_path
+    = tiz_rcfile_get_value ("resource-management", "rmdb.init_script");
+  const char *p_rmd_path
+    = tiz_rcfile_get_value ("resource-management", "rmd.path");
+  char cmd[3 * PATH_MAX];
+
+  BENCH_CHECK (p_rmdb_path && p_sqlite_path && p_init_path && p_rmd_path);
+
+  /* Re-fresh the rm db */
+  snprintf (cmd, sizeof (cmd), "%s %s %s", p_init_path, p_sqlite_path,
+            p_rmdb_path);
+  BENCH_CHECK (-1 != system (cmd));
+
+  g_rmd_pid = fork ();
+  BENCH_CHECK (-1 != g_rmd_pid);
+  if (0 == g_rmd_pid)
+    {
+      execlp (p_rmd_path, "", (char *) NULL);
+      _exit (EXIT_FAILURE);
+    }
+  sleep (1);
+}
+
+static void
+stop_rm_daemon (void)
+{
+  if (g_rmd_pid > 0)
+    {
+      BENCH_CHECK (-1 != kill (g_rmd_pid, SIGTERM));
+      g_rmd_pid = 0;
+    }
+}
+
+/*
+ * Registry: OMX_Init + OMX_Deinit with and without the registry cache
+ */
+
+static void
+bench_registry (void)
+{
+  const char *p_cache_path
+    = tiz_rcfile_get_value ("ilcore", "component-registry-cache");
+  double start = 0;
+  double cold_secs = 0;
+  double cached_secs = 0;
+  int i = 0;
+
+  BENCH_CHECK (NULL != p_cache_path);
+
+  /* Cold: every OMX_Init has to load all the plugins */
+  start = bench_now_secs ();
+  for (i = 0; i < REGISTRY_BENCH_ROUNDS; ++i)
+    {
+      (void) unlink (p_cache_path);
+      BENCH_CHECK (OMX_ErrorNone == OMX_Init ());
+      BENCH_CHECK (OMX_ErrorNone == OMX_Deinit ());
+    }
+  cold_secs = bench_now_secs () - start;
+
+  /* Cached: unchanged plugins are not loaded */
+  start = bench_now_secs ();
+  for (i = 0; i < REGISTRY_BENCH_ROUNDS; ++i)
+    {
+      BENCH_CHECK (OMX_ErrorNone == OMX_Init ());
+      BENCH_CHECK (OMX_ErrorNone == OMX_Deinit ());
+    }
+  cached_secs = bench_now_secs () - start;
+
+  printf ("OMX_Init + OMX_Deinit: cold [%.3f] ms - "
+          "cached registry [%.3f] ms\n",
+          cold_secs * 1000.0 / REGISTRY_BENCH_ROUNDS,
+          cached_secs * 1000.0 / REGISTRY_BENCH_ROUNDS);
+}
+
+/*
+ * Handles: OMX_GetHandle + OMX_FreeHandle, in batches
+ */
+
+static void
+bench_handles (void)
+{
+  OMX_HANDLETYPE p_hdls[HANDLE_BENCH_BATCH];
+  OMX_U32 app_data = 0;
+  OMX_CALLBACKTYPE callbacks;
+  double start = 0;
+  double secs = 0;
+  int i = 0;
+  int j = 0;
+
+  memset (&callbacks, 0, sizeof (callbacks));
+
+  start_rm_daemon ();
+  BENCH_CHECK (OMX_ErrorNone == OMX_Init ());
+
+  start = bench_now_secs ();
+  for (i = 0; i < HANDLE_BENCH_TOTAL / HANDLE_BENCH_BATCH; ++i)
+    {
+      for (j = 0; j < HANDLE_BENCH_BATCH; ++j)
+        {
+          BENCH_CHECK (OMX_ErrorNone
+                       == OMX_GetHandle (&p_hdls[j],
+                                         TIZ_CORE_TEST_COMPONENT_NAME,
+                                         &app_data, &callbacks));
+        }
+
+      /* Free them in reverse order, so that lookups don't always hit the
+         most recently created handle */
+      for (j = HANDLE_BENCH_BATCH - 1; j >= 0; --j)
+        {
+          BENCH_CHECK (OMX_ErrorNone == OMX_FreeHandle (p_hdls[j]));
+        }
+    }
+  secs = bench_now_secs () - start;
+
+  printf ("get/free handle: [%d] handles in [%.3f] s - [%.1f] us per handle\n",
+          HANDLE_BENCH_TOTAL, secs, secs * 1000000.0 / HANDLE_BENCH_TOTAL);
+
+  BENCH_CHECK (OMX_ErrorNone == OMX_Deinit ());
+  stop_rm_daemon ();
+}
+
+typedef struct bench bench_t;
+struct bench
+{
+  const char *p_name;
+  void (*pf_run) (void);
+};
+
+static const bench_t benches[] = {
+  { "registry", bench_registry },
+  { "handles", bench_handles },
+};
+
+int
+main (int argc, char **argv)
+{
+  const size_t nbenches = sizeof (benches) / sizeof (benches[0]);
+  int status = EXIT_SUCCESS;
+  size_t b;
+  int i;
+
+  putenv (TIZ_PLATFORM_RC_FILE_ENV);
+
+  tiz_log_init ();
+
+  if (argc < 2)
+    {
+      for (b = 0; b < nbenches; b++)
+        {
+          benches[b].pf_run ();
+        }
+    }
+
+  for (i = 1; i < argc; i++)
+    {
+      for (b = 0; b < nbenches; b++)
+        {
+          if (0 == strcmp (argv[i], benches[b].p_name))
+            {
+              benches[b].pf_run ();
+              break;
+            }
+        }
+      if (b == nbenches)
+        {
+          fprintf (stderr, "%s: unknown benchmark '%s'\n", argv[0], argv[i]);
+          status = EXIT_FAILURE;
+        }
+    }
+
+  tiz_log_deinit ();
+
+  return status;
+}
+
+/* Local Variables: */
+/* c-default-style: gnu */
+/* fill-column: 79 */
+/* indent-tabs-mode: nil */
+/* compile-command: "make bench_tizcore" */
+/* End: */
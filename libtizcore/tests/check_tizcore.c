@@ -40,6 +40,9 @@
 #include <sys/types.h>
 #include <signal.h>
 #include <limits.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/stat.h>
 
 #include <tizplatform.h>
 
@@ -58,6 +61,52 @@
 char *pg_rmd_path;
 pid_t g_rmd_pid;
 
+/* Finds the registry cache entry of a component. Returns the plugin's full
+ * path and the mtime recorded in the cache. */
+static bool
+find_registry_cache_entry (const char *ap_cache_path, const char *ap_comp_name,
+                           char *ap_dl_full_name, size_t a_len,
+                           long long *ap_mtime_sec)
+{
+  bool found = false;
+  char *p_line = NULL;
+  size_t line_len = 0;
+  FILE *p_file = fopen (ap_cache_path, "r");
+
+  if (!p_file)
+    {
+      return false;
+    }
+
+  /* dl_path, dl_name, mtime secs, mtime nsecs, size, inode, component name,
+     roles... */
+  while (!found && getline (&p_line, &line_len, p_file) > 0)
+    {
+      char *p_save = NULL;
+      char *p_fields[7];
+      int i = 0;
+      for (i = 0; i < 7; ++i)
+        {
+          if (!(p_fields[i] = strtok_r (i == 0 ? p_line : NULL, "\t\n",
+                                        &p_save)))
+            {
+              break;
+            }
+        }
+      if (7 == i && 0 == strcmp (p_fields[6], ap_comp_name))
+        {
+          snprintf (ap_dl_full_name, a_len, "%s/%s", p_fields[0],
+                    p_fields[1]);
+          *ap_mtime_sec = strtoll (p_fields[2], NULL, 10);
+          found = true;
+        }
+    }
+
+  free (p_line);
+  fclose (p_file);
+  return found;
+}
+
 static bool
 refresh_rm_db (void)
 {
@@ -284,6 +333,121 @@ START_TEST (test_ilcore_role_of_comp_enum)
   fail_if (error != OMX_ErrorNone);
 }
 
+END_TEST
+START_TEST (test_ilcore_registry_cache)
+{
+  OMX_ERRORTYPE error = OMX_ErrorNone;
+  OMX_HANDLETYPE p_hdl = NULL;
+  OMX_U32 appData;
+  OMX_CALLBACKTYPE callBacks;
+  OMX_S8 comp_name[OMX_MAX_STRINGNAME_SIZE];
+  const char *p_cache_path = NULL;
+  struct stat cache_stat;
+
+  p_cache_path = tiz_rcfile_get_value ("ilcore", "component-registry-cache");
+  fail_if (NULL == p_cache_path);
+
+  /* Without a cache, all the plugins are loaded and the cache is written */
+  (void) unlink (p_cache_path);
+  error = OMX_Init ();
+  fail_if (error != OMX_ErrorNone);
+  error = OMX_Deinit ();
+  fail_if (error != OMX_ErrorNone);
+
+  fail_if (0 != stat (p_cache_path, &cache_stat));
+  fail_if (0 != (cache_stat.st_mode & (S_IRWXG | S_IRWXO)));
+
+  /* A cache that others can write to is not trusted, and gets replaced */
+  fail_if (0 != chmod (p_cache_path, 0666));
+  error = OMX_Init ();
+  fail_if (error != OMX_ErrorNone);
+  error = OMX_Deinit ();
+  fail_if (error != OMX_ErrorNone);
+
+  fail_if (0 != stat (p_cache_path, &cache_stat));
+  fail_if (0 != (cache_stat.st_mode & (S_IRWXG | S_IRWXO)));
+
+  /* The components registered from the cache must be fully usable */
+  error = OMX_Init ();
+  fail_if (error != OMX_ErrorNone);
+
+  error = OMX_ComponentOfRoleEnum ((OMX_STRING) comp_name,
+                                   TIZ_CORE_TEST_COMPONENT_ROLE, 0);
+  fail_if (error != OMX_ErrorNone);
+
+  error = OMX_GetHandle (&p_hdl,
+                         TIZ_CORE_TEST_COMPONENT_NAME,
+                         (OMX_PTR *) (&appData), &callBacks);
+  fail_if (error != OMX_ErrorNone);
+
+  error = OMX_FreeHandle (p_hdl);
+  fail_if (error != OMX_ErrorNone);
+
+  error = OMX_Deinit ();
+  fail_if (error != OMX_ErrorNone);
+}
+
+END_TEST
+START_TEST (test_ilcore_registry_cache_plugin_changed)
+{
+  OMX_ERRORTYPE error = OMX_ErrorNone;
+  OMX_HANDLETYPE p_hdl = NULL;
+  OMX_U32 appData;
+  OMX_CALLBACKTYPE callBacks;
+  char name[OMX_MAX_STRINGNAME_SIZE];
+  char dl_full_name[PATH_MAX];
+  const char *p_cache_path = NULL;
+  long long mtime_sec = 0;
+  long long new_mtime_sec = 0;
+  struct stat dl_stat;
+  struct timespec times[2];
+
+  p_cache_path = tiz_rcfile_get_value ("ilcore", "component-registry-cache");
+  fail_if (NULL == p_cache_path);
+
+  error = OMX_Init ();
+  fail_if (error != OMX_ErrorNone);
+
+  fail_if (!find_registry_cache_entry (p_cache_path,
+                                       TIZ_CORE_TEST_COMPONENT_NAME,
+                                       dl_full_name, sizeof (dl_full_name),
+                                       &mtime_sec));
+  fail_if (0 != stat (dl_full_name, &dl_stat));
+  fail_if (mtime_sec != (long long) dl_stat.st_mtim.tv_sec);
+
+  /* Update the plugin while the core is up; the next component enumeration
+     must re-register it and rewrite its cache entry */
+  times[0] = dl_stat.st_atim;
+  times[1] = dl_stat.st_mtim;
+  times[1].tv_sec += 1;
+  fail_if (0 != utimensat (AT_FDCWD, dl_full_name, times, 0));
+
+  error = OMX_ComponentNameEnum ((OMX_STRING) name, sizeof (name), 0);
+  fail_if (error != OMX_ErrorNone);
+
+  fail_if (!find_registry_cache_entry (p_cache_path,
+                                       TIZ_CORE_TEST_COMPONENT_NAME,
+                                       dl_full_name, sizeof (dl_full_name),
+                                       &new_mtime_sec));
+  fail_if (new_mtime_sec != mtime_sec + 1);
+
+  error = OMX_GetHandle (&p_hdl,
+                         TIZ_CORE_TEST_COMPONENT_NAME,
+                         (OMX_PTR *) (&appData), &callBacks);
+  fail_if (error != OMX_ErrorNone);
+
+  error = OMX_FreeHandle (p_hdl);
+  fail_if (error != OMX_ErrorNone);
+
+  error = OMX_Deinit ();
+  fail_if (error != OMX_ErrorNone);
+
+  /* Leave the plugin as it was */
+  times[1].tv_sec -= 1;
+  fail_if (0 != utimensat (AT_FDCWD, dl_full_name, times, 0));
+}
+
+END_TEST
 END_TEST Suite * tizcore_suite (void)
 {
   TCase *tc_ilcore;
@@ -302,6 +466,8 @@ END_TEST Suite * tizcore_suite (void)
   /*   tcase_add_test (tc_ilcore, test_ilcore_setup_tunnel_tear_down_tunnel); */
   tcase_add_test (tc_ilcore, test_ilcore_comp_of_role_enum);
   tcase_add_test (tc_ilcore, test_ilcore_role_of_comp_enum);
+  tcase_add_test (tc_ilcore, test_ilcore_registry_cache);
+  tcase_add_test (tc_ilcore, test_ilcore_registry_cache_plugin_changed);
 
   /* TODO: Negative case for OMX_ErrorPortsNotConnected error */
 
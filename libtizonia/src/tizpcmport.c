@@ -73,7 +73,11 @@ pcmport_SetParameter_common (const void * ap_obj, OMX_HANDLETYPE ap_hdl,
               case 32000:
               case 44100:
               case 48000:
+              case 64000:
+              case 88200:
               case 96000:
+              case 176400:
+              case 192000:
                 {
                   break;
                 }
@@ -92,6 +96,7 @@ pcmport_SetParameter_common (const void * ap_obj, OMX_HANDLETYPE ap_hdl,
             {
               case 8:
               case 16:
+              case 24: /* packed, 3 bytes per sample */
               case 32:
                 {
                   break;
@@ -108,6 +113,18 @@ pcmport_SetParameter_common (const void * ap_obj, OMX_HANDLETYPE ap_hdl,
                 }
             };
 
+          if (OMX_NumericalDataFloat == p_pcmmode->eNumData
+              && 32 != p_pcmmode->nBitPerSample)
+            {
+              TIZ_ERROR (ap_hdl,
+                         "[OMX_ErrorBadParameter] : PORT [%d] "
+                         "SetParameter [%s]... Float samples must be 32 "
+                         "bits wide [%d]",
+                         tiz_port_dir (p_obj), tiz_idx_to_str (a_index),
+                         p_pcmmode->nBitPerSample);
+              return OMX_ErrorBadParameter;
+            }
+
           /* Apply the new default values */
           p_obj->pcmmode_.nChannels = p_pcmmode->nChannels;
           p_obj->pcmmode_.eNumData = p_pcmmode->eNumData;
@@ -495,6 +512,7 @@ pcmport_apply_slaving_behaviour (void * ap_obj, void * ap_mos_port,
     OMX_U32 new_rate = p_obj->pcmmode_.nSamplingRate;
     OMX_U32 new_channels = p_obj->pcmmode_.nChannels;
     OMX_U32 new_bps = p_obj->pcmmode_.nBitPerSample;
+    OMX_NUMERICALDATATYPE new_numdata = p_obj->pcmmode_.eNumData;
 
     switch (a_index)
       {
@@ -504,6 +522,7 @@ pcmport_apply_slaving_behaviour (void * ap_obj, void * ap_mos_port,
             new_rate = p_pcmmode->nSamplingRate;
             new_channels = p_pcmmode->nChannels;
             new_bps = p_pcmmode->nBitPerSample;
+            new_numdata = p_pcmmode->eNumData;
             /* min buffer size = At least 5ms or pcm data */
             new_min_buf_sz = ((new_rate * new_bps * new_channels) / 8000) * 5;
 
@@ -663,13 +682,15 @@ pcmport_apply_slaving_behaviour (void * ap_obj, void * ap_mos_port,
 
     if ((p_obj->pcmmode_.nSamplingRate != new_rate)
         || (p_obj->pcmmode_.nChannels != new_channels)
-        || (p_obj->pcmmode_.nBitPerSample != new_bps))
+        || (p_obj->pcmmode_.nBitPerSample != new_bps)
+        || (p_obj->pcmmode_.eNumData != new_numdata))
       {
         OMX_INDEXTYPE id = OMX_IndexParamAudioPcm;
 
         p_obj->pcmmode_.nSamplingRate = new_rate;
         p_obj->pcmmode_.nChannels = new_channels;
         p_obj->pcmmode_.nBitPerSample = new_bps;
+        p_obj->pcmmode_.eNumData = new_numdata;
 
         tiz_check_omx_ret_oom (tiz_vector_push_back (ap_changed_idxs, &id));
 
@@ -96,21 +96,25 @@ get_mark_info (const tiz_port_t * ap_obj, OMX_U32 a_mark_idx)
   return *pp_mi;
 }
 
+/* The default hooks take the buffers from the platform's buffer pool, so
+   that they are reused across state transitions and across components.
+   ap_args is the port, whose nBufferAlignment is honoured. */
 /*@null@*/ /*@only@*/ /*@out@*/
 static OMX_U8 *
 default_alloc_hook (OMX_U32 * ap_size, OMX_PTR * app_port_priv, void * ap_args)
 {
-  OMX_U8 * p = NULL;
+  const tiz_port_t * p_obj = ap_args;
   assert (ap_size && *ap_size > 0);
-  p = tiz_mem_calloc ((size_t) *ap_size, sizeof (OMX_U8));
-  return p;
+  assert (p_obj);
+  return tiz_bufpool_alloc ((size_t) *ap_size,
+                            (size_t) p_obj->portdef_.nBufferAlignment, 0);
 }
 
 static void
 default_free_hook (OMX_PTR ap_buf, OMX_PTR ap_port_priv, void * ap_args)
 {
   assert (ap_buf);
-  tiz_mem_free (ap_buf);
+  tiz_bufpool_free (ap_buf);
 }
 
 static OMX_ERRORTYPE
@@ -281,7 +285,7 @@ port_ctor (void * ap_obj, va_list * app)
       /* Use default hooks */
       p_obj->opts_.mem_hooks.pf_alloc = default_alloc_hook;
       p_obj->opts_.mem_hooks.pf_free = default_free_hook;
-      p_obj->opts_.mem_hooks.p_args = NULL;
+      p_obj->opts_.mem_hooks.p_args = p_obj;
     }
 
   /* Init the OMX_PARAM_PORTDEFINITIONTYPE structure */
@@ -32,6 +32,12 @@
 
 #include <assert.h>
 #include <string.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <pthread.h>
 
 #include <OMX_Core.h>
 #include <OMX_Component.h>
@@ -55,6 +61,14 @@
 
 #define SCHED_OMX_DEFAULT_ROLE "default"
 #define SCHED_QUEUE_MAX_ITEMS 30
+/* Messages in flight are bounded by the queue capacity, plus the message
+   being dispatched, plus those held by producers blocked on a full queue */
+#define SCHED_MSG_POOL_SIZE (2 * SCHED_QUEUE_MAX_ITEMS)
+#define SCHED_MSG_POOL_NIL UINT32_MAX
+#define SCHED_MSG_BATCH_MAX SCHED_QUEUE_MAX_ITEMS
+/* Upper bound on how long a pool worker waiting on another component sleeps
+   before checking again whether it can run that component itself */
+#define SCHED_POOL_HELP_WAIT_MS 5
 
 #ifndef S_SPLINT_S
 #define TIZ_COMP_INIT_MSG(hdl, msg, msgtype)         \
@@ -96,6 +110,19 @@ struct tiz_srv_group
   OMX_COMPONENTTYPE * p_hdl;
 };
 
+typedef struct tiz_sched_msg_pool tiz_sched_msg_pool_t;
+typedef struct tiz_sched_worker tiz_sched_worker_t;
+
+/* Only used when the scheduler is serviced by the worker pool */
+typedef enum tiz_sched_run_state tiz_sched_run_state_t;
+enum tiz_sched_run_state
+{
+  ETIZSchedRunIdle = 0, /* No pending work, or not in any ready list yet */
+  ETIZSchedRunScheduled, /* In a worker's ready list */
+  ETIZSchedRunRunning,   /* Being run by exactly one thread */
+  ETIZSchedRunDone       /* Deinitialised; no thread will touch it again */
+};
+
 typedef struct tiz_scheduler tiz_scheduler_t;
 struct tiz_scheduler
 {
@@ -103,10 +130,14 @@ struct tiz_scheduler
      name */
   char cname[OMX_MAX_STRINGNAME_SIZE + 4096];
   tiz_thread_t thread;
-  OMX_S32 thread_id;
+  bool pooled;
+  tiz_sched_run_state_t run_state; /* pool mode only */
+  tiz_sched_worker_t * p_worker; /* pool mode only: ready list owner */
+  tiz_scheduler_t * p_next_ready; /* pool mode only: ready list link */
   tiz_mutex_t mutex;
   tiz_sem_t sem;
   tiz_queue_t * p_queue;
+  tiz_sched_msg_pool_t * p_msg_pool;
   tiz_soa_t * p_soa;
   tiz_os_t * p_objsys;
   OMX_S32 error;
@@ -348,6 +379,53 @@ struct tiz_sched_msg
   };
 };
 
+/* Worker pool used when [ilcore] scheduler-mode = pool. Each worker has its
+   own ready list; idle workers take work from the other workers' lists. A
+   scheduler is in at most one ready list and is run by at most one thread at
+   a time, which preserves the ordering of its messages and servant ticks. */
+struct tiz_sched_worker
+{
+  tiz_thread_t thread;
+  tiz_scheduler_t * p_first;
+  tiz_scheduler_t * p_last;
+  struct tiz_sched_pool * p_pool;
+};
+
+typedef struct tiz_sched_pool tiz_sched_pool_t;
+struct tiz_sched_pool
+{
+  tiz_mutex_t mutex;
+  tiz_cond_t cond;
+  tiz_cond_t help_cond;
+  OMX_U32 nworkers;
+  OMX_U32 nidle;
+  OMX_U32 nhelpers;
+  OMX_U32 next_worker;
+  tiz_sched_worker_t * p_workers;
+};
+
+/* The pool lives for as long as the process, as the event loop thread does */
+static tiz_sched_pool_t * gp_sched_pool = NULL;
+static pthread_once_t g_sched_pool_once = PTHREAD_ONCE_INIT;
+/* The scheduler whose messages and servants the calling thread is currently
+   running, if any */
+static __thread tiz_scheduler_t * tls_current_sched = NULL;
+/* The pool worker that the calling thread is, if any */
+static __thread tiz_sched_worker_t * tls_worker = NULL;
+
+/* Messages are allocated by any thread calling into the component and freed
+   by the scheduler thread, so tiz_soa_t (not thread-safe) can't be used
+   here. The pool is a lock-free stack of slot indexes; the top 32 bits of
+   'head' are a tag that is incremented on every update to prevent ABA. */
+struct tiz_sched_msg_pool
+{
+  uint64_t head;
+  uint32_t next[SCHED_MSG_POOL_SIZE];
+  tiz_sched_msg_t msgs[SCHED_MSG_POOL_SIZE];
+  OMX_U64 pool_allocs;
+  OMX_U64 heap_allocs;
+};
+
 /* Forward declarations */
 static OMX_ERRORTYPE
 do_init (tiz_scheduler_t *, tiz_sched_state_t *, tiz_sched_msg_t *);
@@ -416,6 +494,15 @@ static OMX_ERRORTYPE
 start_scheduler (tiz_scheduler_t *);
 static void
 delete_scheduler (tiz_scheduler_t *);
+static void
+pool_notify (tiz_scheduler_t *);
+static bool
+pool_try_claim (tiz_scheduler_t *);
+static void
+pool_run (tiz_scheduler_t *);
+typedef bool (*tiz_sched_pool_pred_f) (tiz_scheduler_t *, tiz_sched_msg_t *);
+static void
+pool_help_until (tiz_scheduler_t *, tiz_sched_msg_t *, tiz_sched_pool_pred_f);
 
 typedef OMX_ERRORTYPE (*tiz_sched_msg_dispatch_f) (tiz_scheduler_t * ap_sched,
                                                    tiz_sched_state_t * ap_state,
@@ -602,13 +689,55 @@ store_roles (tiz_scheduler_t * ap_sched,
   return rc;
 }
 
+static bool
+pool_msg_queued (tiz_scheduler_t * ap_sched, tiz_sched_msg_t * ap_msg)
+{
+  return (OMX_ErrorNone == tiz_queue_try_send (ap_sched->p_queue, ap_msg));
+}
+
+static bool
+pool_msg_replied (tiz_scheduler_t * ap_sched, tiz_sched_msg_t * ap_msg)
+{
+  OMX_S32 posted = 0;
+  (void) ap_msg;
+  return (OMX_ErrorNone == tiz_sem_getvalue (&(ap_sched->sem), &posted)
+          && posted > 0);
+}
+
+static inline OMX_ERRORTYPE
+enqueue_msg (tiz_scheduler_t * ap_sched, tiz_sched_msg_t * ap_msg)
+{
+  assert (ap_sched);
+  assert (ap_msg);
+  if (!ap_sched->pooled)
+    {
+      return tiz_queue_send (ap_sched->p_queue, ap_msg);
+    }
+  if (tls_worker)
+    {
+      /* A pool worker must not block on a full queue that it may be the only
+         one able to drain */
+      pool_help_until (ap_sched, ap_msg, pool_msg_queued);
+    }
+  else
+    {
+      tiz_check_omx_ret_oom (tiz_queue_send (ap_sched->p_queue, ap_msg));
+    }
+  pool_notify (ap_sched);
+  return OMX_ErrorNone;
+}
+
 static inline OMX_ERRORTYPE
 send_msg_blocking (tiz_scheduler_t * ap_sched, tiz_sched_msg_t * ap_msg)
 {
   assert (ap_msg);
   assert (ap_sched);
   ap_msg->will_block = OMX_TRUE;
-  tiz_check_omx_ret_oom (tiz_queue_send (ap_sched->p_queue, ap_msg));
+  tiz_check_omx_ret_oom (enqueue_msg (ap_sched, ap_msg));
+  if (ap_sched->pooled && tls_worker)
+    {
+      pool_help_until (ap_sched, ap_msg, pool_msg_replied);
+    }
   tiz_check_omx_ret_oom (tiz_sem_wait (&(ap_sched->sem)));
   return ap_sched->error;
 }
@@ -619,19 +748,20 @@ send_msg_non_blocking (tiz_scheduler_t * ap_sched, tiz_sched_msg_t * ap_msg)
   assert (ap_msg);
   assert (ap_sched);
   ap_msg->will_block = OMX_FALSE;
-  return tiz_queue_send (ap_sched->p_queue, ap_msg);
+  tiz_check_omx_ret_oom (enqueue_msg (ap_sched, ap_msg));
+  return OMX_ErrorNone;
 }
 
 static inline OMX_ERRORTYPE
 send_msg (tiz_scheduler_t * ap_sched, tiz_sched_msg_t * ap_msg)
 {
-  const OMX_S32 tid = tiz_thread_id ();
   OMX_ERRORTYPE rc = OMX_ErrorNone;
 
   assert (ap_sched);
   assert (ap_msg);
 
-  if (tid == ap_sched->thread_id && ap_msg->class != ETIZSchedMsgPluggableEvent)
+  if (tls_current_sched == ap_sched
+      && ap_msg->class != ETIZSchedMsgPluggableEvent)
     {
       TIZ_WARN (ap_sched->child.p_hdl,
                 "WARNING: (API %s called from IL callback context...)",
@@ -1380,6 +1510,79 @@ do_estat (tiz_scheduler_t * ap_sched, tiz_sched_state_t * ap_state,
                              p_msg_estat->id, p_msg_estat->events);
 }
 
+static tiz_sched_msg_pool_t *
+init_msg_pool (void)
+{
+  tiz_sched_msg_pool_t * p_pool
+    = tiz_mem_calloc (1, sizeof (tiz_sched_msg_pool_t));
+  if (p_pool)
+    {
+      uint32_t i = 0;
+      for (i = 0; i < SCHED_MSG_POOL_SIZE - 1; ++i)
+        {
+          p_pool->next[i] = i + 1;
+        }
+      p_pool->next[SCHED_MSG_POOL_SIZE - 1] = SCHED_MSG_POOL_NIL;
+      p_pool->head = 0; /* tag 0, first slot 0 */
+    }
+  return p_pool;
+}
+
+static tiz_sched_msg_t *
+alloc_msg (tiz_sched_msg_pool_t * ap_pool)
+{
+  uint64_t head = 0;
+  uint64_t new_head = 0;
+  uint32_t slot = 0;
+
+  assert (ap_pool);
+
+  head = __atomic_load_n (&(ap_pool->head), __ATOMIC_ACQUIRE);
+  do
+    {
+      slot = (uint32_t) head;
+      if (SCHED_MSG_POOL_NIL == slot)
+        {
+          (void) __atomic_add_fetch (&(ap_pool->heap_allocs), 1,
+                                     __ATOMIC_RELAXED);
+          return tiz_mem_calloc (1, sizeof (tiz_sched_msg_t));
+        }
+      new_head = (((head >> 32) + 1) << 32)
+                 | __atomic_load_n (&(ap_pool->next[slot]), __ATOMIC_RELAXED);
+    }
+  while (!__atomic_compare_exchange_n (&(ap_pool->head), &head, new_head, true,
+                                       __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+
+  (void) __atomic_add_fetch (&(ap_pool->pool_allocs), 1, __ATOMIC_RELAXED);
+  return memset (&(ap_pool->msgs[slot]), 0, sizeof (tiz_sched_msg_t));
+}
+
+static void
+free_msg (tiz_sched_msg_pool_t * ap_pool, tiz_sched_msg_t * ap_msg)
+{
+  uint64_t head = 0;
+  uint32_t slot = 0;
+
+  assert (ap_pool);
+
+  if (ap_msg < ap_pool->msgs || ap_msg >= ap_pool->msgs + SCHED_MSG_POOL_SIZE)
+    {
+      tiz_mem_free (ap_msg);
+      return;
+    }
+
+  slot = (uint32_t) (ap_msg - ap_pool->msgs);
+  head = __atomic_load_n (&(ap_pool->head), __ATOMIC_RELAXED);
+  do
+    {
+      __atomic_store_n (&(ap_pool->next[slot]), (uint32_t) head,
+                        __ATOMIC_RELAXED);
+    }
+  while (!__atomic_compare_exchange_n (
+    &(ap_pool->head), &head, (((head >> 32) + 1) << 32) | slot, true,
+    __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
 /* NOTE: Start ignoring splint warnings in this section of code */
 /*@ignore@*/
 static inline tiz_sched_msg_t *
@@ -1391,8 +1594,7 @@ init_scheduler_message (OMX_HANDLETYPE ap_hdl,
   assert (ap_hdl);
   assert (a_msg_class < ETIZSchedMsgMax);
 
-  if (!(p_msg
-        = (tiz_sched_msg_t *) tiz_mem_calloc (1, sizeof (tiz_sched_msg_t))))
+  if (!(p_msg = alloc_msg (get_sched (ap_hdl)->p_msg_pool)))
     {
       TIZ_ERROR (ap_hdl,
                  "[OMX_ErrorInsufficientResources] : "
@@ -1671,7 +1873,7 @@ sched_SetConfig (OMX_HANDLETYPE ap_hdl, OMX_INDEXTYPE a_index,
       if (!(p_msg_sconf->p_struct
             = tiz_mem_calloc (1, (*(OMX_U32 *) ap_struct))))
         {
-          tiz_mem_free (p_msg);
+          free_msg (p_sched->p_msg_pool, p_msg);
           TIZ_ERROR (ap_hdl,
                      "[OMX_ErrorInsufficientResources] : "
                      "(While allocating memory for config struct)");
@@ -2047,7 +2249,7 @@ dispatch_msg (tiz_scheduler_t * ap_sched, tiz_sched_state_t * ap_state,
   /* Return error to client */
   ap_sched->error = rc;
 
-  tiz_mem_free (ap_msg);
+  free_msg (ap_sched->p_msg_pool, ap_msg);
 
   return signal_client;
 }
@@ -2112,47 +2314,401 @@ schedule_servants (tiz_scheduler_t * ap_sched, const tiz_sched_state_t ap_state)
   /*     } */
 }
 
+/* Dispatches a batch of queued messages and then ticks the servants. Returns
+   false once the component has been deinitialised (or on error). */
+static bool
+run_scheduler_slice (tiz_scheduler_t * ap_sched, const bool a_may_block)
+{
+  OMX_PTR msgs[SCHED_MSG_BATCH_MAX];
+  OMX_S32 nmsgs = 0;
+  OMX_S32 i = 0;
+  OMX_BOOL signal_client = OMX_FALSE;
+
+  assert (ap_sched);
+
+  /* Dispatch everything that is queued (e.g. a burst of
+     EmptyThisBuffer/FillThisBuffer calls) before ticking the servants,
+     instead of alternating one message with one round of ticks */
+  if (a_may_block || tiz_queue_length (ap_sched->p_queue) > 0)
+    {
+      tiz_check_omx_ret_val (tiz_queue_receive_batch (ap_sched->p_queue, msgs,
+                                                      SCHED_MSG_BATCH_MAX,
+                                                      &nmsgs),
+                             false);
+    }
+
+  for (i = 0; i < nmsgs && ETIZSchedStateStopped != ap_sched->state; ++i)
+    {
+      assert (msgs[i]);
+      signal_client = dispatch_msg (ap_sched, &(ap_sched->state),
+                                    (tiz_sched_msg_t *) msgs[i]);
+
+      if (OMX_TRUE == signal_client)
+        {
+          tiz_check_omx_ret_val (tiz_sem_post (&(ap_sched->sem)), false);
+        }
+    }
+
+  if (ETIZSchedStateStopped == ap_sched->state)
+    {
+      for (; i < nmsgs; ++i)
+        {
+          TIZ_LOG (TIZ_PRIORITY_ERROR,
+                   "[%s] : Dropping message [%s] received after deinit",
+                   ap_sched->cname,
+                   tiz_sched_msg_to_str (((tiz_sched_msg_t *) msgs[i])->class));
+          free_msg (ap_sched->p_msg_pool, msgs[i]);
+        }
+      return false;
+    }
+
+  schedule_servants (ap_sched, ap_sched->state);
+  return true;
+}
+
 static void *
 il_sched_thread_func (void * p_arg)
 {
   tiz_scheduler_t * p_sched = (tiz_scheduler_t *) (p_arg);
-  OMX_PTR p_data = NULL;
-  OMX_BOOL signal_client = OMX_FALSE;
 
   assert (p_sched);
 
-  p_sched->thread_id = tiz_thread_id ();
+  tls_current_sched = p_sched;
   tiz_check_omx_ret_null (tiz_sem_post (&(p_sched->sem)));
 
-  for (;;)
+  while (run_scheduler_slice (p_sched, true))
+    {
+    }
+
+  return NULL;
+}
+
+/* The functions below must be called with the pool mutex held */
+
+static void
+pool_ready_push (tiz_sched_worker_t * ap_worker, tiz_scheduler_t * ap_sched)
+{
+  ap_sched->p_worker = ap_worker;
+  ap_sched->p_next_ready = NULL;
+  if (ap_worker->p_last)
     {
-      tiz_check_omx_ret_null (tiz_queue_receive (p_sched->p_queue, &p_data));
+      ap_worker->p_last->p_next_ready = ap_sched;
+    }
+  else
+    {
+      ap_worker->p_first = ap_sched;
+    }
+  ap_worker->p_last = ap_sched;
+}
 
-      assert (p_data);
-      signal_client
-        = dispatch_msg (p_sched, &(p_sched->state), (tiz_sched_msg_t *) p_data);
+static void
+pool_ready_unlink (tiz_sched_worker_t * ap_worker, tiz_scheduler_t * ap_sched)
+{
+  tiz_scheduler_t * p_prev = NULL;
+  tiz_scheduler_t * p_cur = ap_worker->p_first;
 
-      if (OMX_TRUE == signal_client)
+  while (p_cur && p_cur != ap_sched)
+    {
+      p_prev = p_cur;
+      p_cur = p_cur->p_next_ready;
+    }
+
+  assert (p_cur);
+  if (p_prev)
+    {
+      p_prev->p_next_ready = ap_sched->p_next_ready;
+    }
+  else
+    {
+      ap_worker->p_first = ap_sched->p_next_ready;
+    }
+  if (ap_worker->p_last == ap_sched)
+    {
+      ap_worker->p_last = p_prev;
+    }
+  ap_sched->p_next_ready = NULL;
+  ap_sched->p_worker = NULL;
+}
+
+static tiz_scheduler_t *
+pool_ready_next (tiz_sched_pool_t * ap_pool, tiz_sched_worker_t * ap_worker)
+{
+  const OMX_U32 self = ap_worker - ap_pool->p_workers;
+  OMX_U32 i = 0;
+
+  /* Own list first, then steal from the others */
+  for (i = 0; i < ap_pool->nworkers; ++i)
+    {
+      tiz_sched_worker_t * p_victim
+        = &(ap_pool->p_workers[(self + i) % ap_pool->nworkers]);
+      tiz_scheduler_t * p_sched = p_victim->p_first;
+      if (p_sched)
         {
-          tiz_check_omx_ret_null (tiz_sem_post (&(p_sched->sem)));
+          pool_ready_unlink (p_victim, p_sched);
+          return p_sched;
         }
+    }
+  return NULL;
+}
+
+/* End of functions that must be called with the pool mutex held */
 
-      if (ETIZSchedStateStopped == p_sched->state)
+static void
+pool_notify (tiz_scheduler_t * ap_sched)
+{
+  tiz_sched_pool_t * p_pool = gp_sched_pool;
+
+  assert (ap_sched);
+  assert (p_pool);
+
+  /* Pairs with the fence in pool_run: either this thread sees the scheduler
+     idle, or the worker that releases it sees the new message */
+  __atomic_thread_fence (__ATOMIC_SEQ_CST);
+  if (ETIZSchedRunIdle
+      != __atomic_load_n (&(ap_sched->run_state), __ATOMIC_RELAXED))
+    {
+      return;
+    }
+
+  (void) tiz_mutex_lock (&(p_pool->mutex));
+  if (ETIZSchedRunIdle == ap_sched->run_state)
+    {
+      /* Keep work produced by a worker on that worker's list */
+      tiz_sched_worker_t * p_worker
+        = tls_worker ? tls_worker
+                     : &(p_pool->p_workers[p_pool->next_worker++
+                                           % p_pool->nworkers]);
+      __atomic_store_n (&(ap_sched->run_state), ETIZSchedRunScheduled,
+                        __ATOMIC_RELAXED);
+      pool_ready_push (p_worker, ap_sched);
+      if (p_pool->nidle > 0)
         {
-          break;
+          (void) tiz_cond_signal (&(p_pool->cond));
         }
+    }
+  (void) tiz_mutex_unlock (&(p_pool->mutex));
+}
+
+static bool
+pool_try_claim (tiz_scheduler_t * ap_sched)
+{
+  tiz_sched_pool_t * p_pool = gp_sched_pool;
+  bool claimed = false;
+
+  assert (ap_sched);
+  assert (p_pool);
 
-      schedule_servants (p_sched, p_sched->state);
+  (void) tiz_mutex_lock (&(p_pool->mutex));
+  if (ETIZSchedRunScheduled == ap_sched->run_state)
+    {
+      pool_ready_unlink (ap_sched->p_worker, ap_sched);
+      claimed = true;
+    }
+  else if (ETIZSchedRunIdle == ap_sched->run_state)
+    {
+      claimed = true;
+    }
+  if (claimed)
+    {
+      __atomic_store_n (&(ap_sched->run_state), ETIZSchedRunRunning,
+                        __ATOMIC_RELAXED);
+    }
+  (void) tiz_mutex_unlock (&(p_pool->mutex));
+
+  return claimed;
+}
+
+/* Runs a scheduler that the calling thread has claimed, and releases it */
+static void
+pool_run (tiz_scheduler_t * ap_sched)
+{
+  tiz_sched_pool_t * p_pool = gp_sched_pool;
+  tiz_scheduler_t * p_prev = tls_current_sched;
+  bool running = true;
+
+  assert (ap_sched);
+  assert (p_pool);
+  assert (ETIZSchedRunRunning == ap_sched->run_state);
+
+  tls_current_sched = ap_sched;
+  running = run_scheduler_slice (ap_sched, false);
+  tls_current_sched = p_prev;
+
+  (void) tiz_mutex_lock (&(p_pool->mutex));
+  __atomic_store_n (&(ap_sched->run_state),
+                    running ? ETIZSchedRunIdle : ETIZSchedRunDone,
+                    __ATOMIC_RELAXED);
+  if (p_pool->nhelpers > 0)
+    {
+      (void) tiz_cond_broadcast (&(p_pool->help_cond));
+    }
+  (void) tiz_mutex_unlock (&(p_pool->mutex));
+
+  if (!running)
+    {
+      /* Tell delete_scheduler that no worker will touch this scheduler
+         again */
+      (void) tiz_sem_post (&(ap_sched->sem));
+      return;
+    }
+
+  __atomic_thread_fence (__ATOMIC_SEQ_CST);
+  if (tiz_queue_length (ap_sched->p_queue) > 0)
+    {
+      pool_notify (ap_sched);
+    }
+}
+
+/* Used by pool workers instead of blocking on another component's queue or
+   semaphore: a blocked worker is one less thread to run the ready components,
+   and the component it waits on could end up with no one to run it. So,
+   whenever no other thread is running the target component, run it here. */
+static void
+pool_help_until (tiz_scheduler_t * ap_sched, tiz_sched_msg_t * ap_msg,
+                 tiz_sched_pool_pred_f a_pred)
+{
+  tiz_sched_pool_t * p_pool = gp_sched_pool;
+
+  assert (ap_sched);
+  assert (p_pool);
+  assert (a_pred);
+
+  while (!a_pred (ap_sched, ap_msg))
+    {
+      if (pool_try_claim (ap_sched))
+        {
+          pool_run (ap_sched);
+          continue;
+        }
+      (void) tiz_mutex_lock (&(p_pool->mutex));
+      if (ETIZSchedRunRunning == ap_sched->run_state
+          || ETIZSchedRunDone == ap_sched->run_state)
+        {
+          /* pool_run wakes us up when the current owner lets go of it */
+          p_pool->nhelpers++;
+          (void) tiz_cond_timedwait (&(p_pool->help_cond), &(p_pool->mutex),
+                                     SCHED_POOL_HELP_WAIT_MS);
+          p_pool->nhelpers--;
+        }
+      (void) tiz_mutex_unlock (&(p_pool->mutex));
+    }
+}
+
+static void *
+pool_worker_thread_func (void * p_arg)
+{
+  tiz_sched_worker_t * p_worker = (tiz_sched_worker_t *) p_arg;
+  tiz_sched_pool_t * p_pool = NULL;
+
+  assert (p_worker);
+  p_pool = p_worker->p_pool;
+  assert (p_pool);
+
+  tls_worker = p_worker;
+
+  for (;;)
+    {
+      tiz_scheduler_t * p_sched = NULL;
+
+      tiz_check_omx_ret_null (tiz_mutex_lock (&(p_pool->mutex)));
+      while (!(p_sched = pool_ready_next (p_pool, p_worker)))
+        {
+          p_pool->nidle++;
+          (void) tiz_cond_wait (&(p_pool->cond), &(p_pool->mutex));
+          p_pool->nidle--;
+        }
+      __atomic_store_n (&(p_sched->run_state), ETIZSchedRunRunning,
+                        __ATOMIC_RELAXED);
+      tiz_check_omx_ret_null (tiz_mutex_unlock (&(p_pool->mutex)));
+
+      pool_run (p_sched);
     }
 
   return NULL;
 }
 
+static OMX_U32
+get_pool_size (void)
+{
+  const char * p_size
+    = tiz_rcfile_get_value ("ilcore", "scheduler-pool-size");
+  long size = p_size ? strtol (p_size, NULL, 10) : 0;
+  if (size <= 0)
+    {
+      size = sysconf (_SC_NPROCESSORS_ONLN);
+    }
+  return size > 0 ? (OMX_U32) size : 1;
+}
+
+static void
+init_sched_pool (void)
+{
+  tiz_sched_pool_t * p_pool = NULL;
+  OMX_U32 i = 0;
+
+  if (!(p_pool = tiz_mem_calloc (1, sizeof (tiz_sched_pool_t))))
+    {
+      return;
+    }
+
+  p_pool->nworkers = get_pool_size ();
+  if (!(p_pool->p_workers
+        = tiz_mem_calloc (p_pool->nworkers, sizeof (tiz_sched_worker_t)))
+      || OMX_ErrorNone != tiz_mutex_init (&(p_pool->mutex))
+      || OMX_ErrorNone != tiz_cond_init (&(p_pool->cond))
+      || OMX_ErrorNone != tiz_cond_init (&(p_pool->help_cond)))
+    {
+      TIZ_LOG (TIZ_PRIORITY_ERROR,
+               "[OMX_ErrorInsufficientResources] : "
+               "(Could not allocate the scheduler worker pool)");
+      tiz_mem_free (p_pool->p_workers);
+      tiz_mem_free (p_pool);
+      return;
+    }
+
+  /* Workers are only started after the pool is published */
+  gp_sched_pool = p_pool;
+
+  for (i = 0; i < p_pool->nworkers; ++i)
+    {
+      char name[16];
+      p_pool->p_workers[i].p_pool = p_pool;
+      if (OMX_ErrorNone != tiz_thread_create (&(p_pool->p_workers[i].thread),
+                                              0, 0, pool_worker_thread_func,
+                                              &(p_pool->p_workers[i])))
+        {
+          TIZ_LOG (TIZ_PRIORITY_ERROR, "Could not create pool worker [%u]",
+                   (unsigned int) i);
+          /* The workers already created will pick up all the work */
+          p_pool->nworkers = i;
+          break;
+        }
+      (void) snprintf (name, sizeof (name), "tizworker%u", (unsigned int) i);
+      (void) tiz_thread_setname (&(p_pool->p_workers[i].thread), name);
+    }
+
+  TIZ_LOG (TIZ_PRIORITY_NOTICE, "Scheduler worker pool started - workers [%u]",
+           (unsigned int) p_pool->nworkers);
+}
+
 static OMX_ERRORTYPE
 start_scheduler (tiz_scheduler_t * ap_sched)
 {
   assert (ap_sched);
 
+  if (ap_sched->pooled)
+    {
+      (void) pthread_once (&g_sched_pool_once, init_sched_pool);
+      if (!gp_sched_pool || 0 == gp_sched_pool->nworkers)
+        {
+          TIZ_LOG (TIZ_PRIORITY_ERROR,
+                   "[OMX_ErrorInsufficientResources] : "
+                   "(The scheduler worker pool is not available)");
+          return OMX_ErrorInsufficientResources;
+        }
+      return OMX_ErrorNone;
+    }
+
   /* Create scheduler thread */
   tiz_check_omx_ret_oom (tiz_mutex_lock (&(ap_sched->mutex)));
   tiz_check_omx_ret_oom (tiz_thread_create (&(ap_sched->thread), 0, 0,
@@ -2169,15 +2725,49 @@ delete_scheduler (tiz_scheduler_t * ap_sched)
 {
   OMX_PTR p_result = NULL;
   assert (ap_sched);
-  (void) tiz_thread_join (&(ap_sched->thread), &p_result);
+  if (ap_sched->pooled)
+    {
+      /* Wait for the worker that ran ComponentDeInit to let go of it */
+      (void) tiz_sem_wait (&(ap_sched->sem));
+    }
+  else
+    {
+      (void) tiz_thread_join (&(ap_sched->thread), &p_result);
+    }
   delete_roles (ap_sched);
   (void) tiz_mutex_destroy (&(ap_sched->mutex));
   (void) tiz_sem_destroy (&(ap_sched->sem));
   tiz_queue_destroy (ap_sched->p_queue);
   ap_sched->p_queue = NULL;
+  TIZ_LOG (TIZ_PRIORITY_TRACE,
+           "[%s] messages: pool allocs [%" PRIu64 "] heap allocs [%" PRIu64
+           "]",
+           ap_sched->cname, (uint64_t) ap_sched->p_msg_pool->pool_allocs,
+           (uint64_t) ap_sched->p_msg_pool->heap_allocs);
+  tiz_mem_free (ap_sched->p_msg_pool);
+  ap_sched->p_msg_pool = NULL;
   tiz_mem_free (ap_sched);
 }
 
+static tiz_queue_mode_t
+get_queue_mode (void)
+{
+  /* The scheduler's queue has one consumer (the scheduler thread) but
+     multiple producers (the IL client, the threads of tunnelled components,
+     and the component's own servants). The lock-free MPSC queue is used
+     unless the mutex-based queue is explicitly requested in tizonia.conf. */
+  return (0 == tiz_rcfile_compare_value ("ilcore", "scheduler-queue",
+                                         "locking")
+            ? ETIZQueueModeLocking
+            : ETIZQueueModeLockFreeMpsc);
+}
+
+static bool
+use_worker_pool (void)
+{
+  return (0 == tiz_rcfile_compare_value ("ilcore", "scheduler-mode", "pool"));
+}
+
 static tiz_scheduler_t *
 instantiate_scheduler (OMX_HANDLETYPE ap_hdl, const char * ap_cname)
 {
@@ -2196,8 +2786,15 @@ instantiate_scheduler (OMX_HANDLETYPE ap_hdl, const char * ap_cname)
 
   tiz_check_omx_ret_null (tiz_mutex_init (&(p_sched->mutex)));
   tiz_check_omx_ret_null (tiz_sem_init (&(p_sched->sem), 0));
-  tiz_check_omx_ret_null (
-    tiz_queue_init (&(p_sched->p_queue), SCHED_QUEUE_MAX_ITEMS));
+  tiz_check_omx_ret_null (tiz_queue_init_with_mode (
+    &(p_sched->p_queue), SCHED_QUEUE_MAX_ITEMS, get_queue_mode ()));
+  if (!(p_sched->p_msg_pool = init_msg_pool ()))
+    {
+      TIZ_LOG (TIZ_PRIORITY_ERROR,
+               "[OMX_ErrorInsufficientResources] : "
+               "(Could not allocate the message pool)");
+      return NULL;
+    }
 
   p_sched->child.p_fsm = NULL;
   p_sched->child.p_ker = NULL;
@@ -2209,6 +2806,10 @@ instantiate_scheduler (OMX_HANDLETYPE ap_hdl, const char * ap_cname)
   p_sched->state = ETIZSchedStateStarting;
   p_sched->appdata = NULL;
   p_sched->cbacks = NULL;
+  p_sched->pooled = use_worker_pool ();
+  p_sched->run_state = ETIZSchedRunIdle;
+  p_sched->p_worker = NULL;
+  p_sched->p_next_ready = NULL;
 
   len = strnlen (ap_cname, OMX_MAX_STRINGNAME_SIZE - 1);
   strncpy (p_sched->cname, ap_cname, len);
@@ -2247,7 +2848,10 @@ init_servants (tiz_scheduler_t * ap_sched, tiz_sched_msg_t * ap_msg)
   assert (ap_sched);
   assert (ap_msg);
 
-  set_thread_name (ap_sched);
+  if (!ap_sched->pooled)
+    {
+      set_thread_name (ap_sched);
+    }
 
   p_hdl = ap_sched->child.p_hdl;
 
@@ -2626,6 +3230,20 @@ tiz_comp_event_queue_unused_spaces (const OMX_HANDLETYPE ap_hdl)
   return SCHED_QUEUE_MAX_ITEMS - tiz_queue_length (p_sched->p_queue);
 }
 
+void
+tiz_comp_msg_stats (const OMX_HANDLETYPE ap_hdl,
+                    tiz_comp_msg_stats_t * ap_stats)
+{
+  tiz_scheduler_t * p_sched = get_sched (ap_hdl);
+  assert (p_sched);
+  assert (p_sched->p_msg_pool);
+  assert (ap_stats);
+  ap_stats->pool_allocs = __atomic_load_n (&(p_sched->p_msg_pool->pool_allocs),
+                                           __ATOMIC_RELAXED);
+  ap_stats->heap_allocs = __atomic_load_n (&(p_sched->p_msg_pool->heap_allocs),
+                                           __ATOMIC_RELAXED);
+}
+
 void *
 tiz_get_sched (const OMX_HANDLETYPE ap_hdl)
 {
@@ -397,6 +397,29 @@ tiz_comp_event_stat (const OMX_HANDLETYPE ap_hdl, tiz_event_stat_t * ap_ev_stat,
 size_t
 tiz_comp_event_queue_unused_spaces (const OMX_HANDLETYPE ap_hdl);
 
+/**
+ * Scheduler message allocation counters.
+ * @ingroup tizscheduler
+ */
+typedef struct tiz_comp_msg_stats tiz_comp_msg_stats_t;
+struct tiz_comp_msg_stats
+{
+  OMX_U64 pool_allocs; /**< Messages taken from the scheduler's pool */
+  OMX_U64 heap_allocs; /**< Messages allocated on the heap because the pool
+                          was exhausted */
+};
+
+/**
+ * Retrieve the number of scheduler messages allocated so far (one per OMX
+ * API call and per event delivered to the component).
+ * @ingroup tizscheduler
+ * @param ap_hdl The OpenMAX IL handle.
+ * @param ap_stats The counters (output).
+ */
+void
+tiz_comp_msg_stats (const OMX_HANDLETYPE ap_hdl,
+                    tiz_comp_msg_stats_t * ap_stats);
+
 /* Utility functions */
 
 /**
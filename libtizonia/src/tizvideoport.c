@@ -327,8 +327,14 @@ videoport_apply_slaving_behaviour (void * ap_obj, void * ap_mos_port,
       const OMX_PARAM_PORTDEFINITIONTYPE * p_portdef = ap_struct;
       const OMX_U32 new_width = p_portdef->format.video.nFrameWidth;
       const OMX_U32 new_height = p_portdef->format.video.nFrameHeight;
-      const OMX_U32 y_sz = new_width * new_height;
-      const OMX_U32 u_sz = y_sz / 4;
+      /* Planar 4:2:0 frames are laid out tightly: the luma stride is the
+       * frame width and the slice height is the frame height. Chroma planes
+       * are half the luma stride and slice height, rounded up */
+      const OMX_U32 new_stride = new_width;
+      const OMX_U32 new_slice_height = new_height;
+      const OMX_U32 y_sz = new_stride * new_slice_height;
+      const OMX_U32 u_sz
+        = ((new_stride + 1) / 2) * ((new_slice_height + 1) / 2);
       const OMX_U32 v_sz = u_sz;
       const OMX_U32 new_buf_sz = y_sz + u_sz + v_sz;
       OMX_BOOL portdef_changed = OMX_FALSE;
@@ -338,10 +344,14 @@ videoport_apply_slaving_behaviour (void * ap_obj, void * ap_mos_port,
                  new_height, y_sz, u_sz, v_sz, new_buf_sz);
 
       if ((p_base->portdef_.format.video.nFrameWidth != new_width)
-          || (p_base->portdef_.format.video.nFrameHeight != new_height))
+          || (p_base->portdef_.format.video.nFrameHeight != new_height)
+          || (p_base->portdef_.format.video.nStride != (OMX_S32) new_stride)
+          || (p_base->portdef_.format.video.nSliceHeight != new_slice_height))
         {
           p_base->portdef_.format.video.nFrameWidth = new_width;
           p_base->portdef_.format.video.nFrameHeight = new_height;
+          p_base->portdef_.format.video.nStride = new_stride;
+          p_base->portdef_.format.video.nSliceHeight = new_slice_height;
           portdef_changed = OMX_TRUE;
         }
 
@@ -0,0 +1,318 @@
+/**
+ * Copyright (C) 2011-2017 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   bench_tizonia.c
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  libtizonia buffer exchange benchmark
+ *
+ * Not part of 'make check'. Measures how many buffers per second the test
+ * component can take and return when the IL client hands them over in
+ * bursts. Uses the same configuration file and RM daemon as check_tizonia.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <assert.h>
+#include <limits.h>
+#include <time.h>
+#include <sys/types.h>
+
+#include <OMX_Component.h>
+
+#include <tizplatform.h>
+
+#include "check_tizonia.h"
+
+#ifdef TIZ_LOG_CATEGORY_NAME
+#undef TIZ_LOG_CATEGORY_NAME
+#define TIZ_LOG_CATEGORY_NAME "tiz.tizonia.bench"
+#endif
+
+#define COMPONENT_NAME "OMX.Aratelia.tizonia.test_component"
+
+/* duration of event timeout in msec */
+#define TIMEOUT_EXPECTING_SUCCESS 1000
+
+#define BUFFER_EXCHANGE_MAX_BUFFERS 64
+#define BUFFER_EXCHANGE_ROUNDS 2000
+
+#define BENCH_CHECK(expr)                                             \
+  do                                                                  \
+    {                                                                 \
+      if (!(expr))                                                    \
+        {                                                             \
+          fprintf (stderr, "%s:%d: check failed: %s\n", __FILE__,     \
+                   __LINE__, #expr);                                  \
+          abort ();                                                   \
+        }                                                             \
+    }                                                                 \
+  while (0)
+
+typedef struct bench_context bench_context_t;
+struct bench_context
+{
+  tiz_mutex_t mutex;
+  tiz_cond_t cond;
+  OMX_STATETYPE state;
+  OMX_U32 nbuffers_done;
+};
+
+static pid_t g_rmd_pid;
+
+static void
+start_rm_daemon (void)
+{
+  const char *p_rmdb_path
+    = tiz_rcfile_get_value ("resource-management", "rmdb");
+  const char *p_sqlite_path
+    = tiz_rcfile_get_value ("resource-management", "rmdb.sqlite_script");
+  const char *p_init_path
+    = tiz_rcfile_get_value ("resource-management", "rmdb.init_script");
+  const char *p_rmd_path
+    = tiz_rcfile_get_value ("resource-management", "rmd.path");
+  char cmd[3 * PATH_MAX];
+
+  BENCH_CHECK (p_rmdb_path && p_sqlite_path && p_init_path && p_rmd_path);
+
+  /* Re-fresh the rm db */
+  snprintf (cmd, sizeof (cmd), "%s %s %s", p_init_path, p_sqlite_path,
+            p_rmdb_path);
+  BENCH_CHECK (-1 != system (cmd));
+
+  g_rmd_pid = fork ();
+  BENCH_CHECK (-1 != g_rmd_pid);
+  if (0 == g_rmd_pid)
+    {
+      execlp (p_rmd_path, "", (char *) NULL);
+      _exit (EXIT_FAILURE);
+    }
+  sleep (1);
+}
+
+static void
+stop_rm_daemon (void)
+{
+  if (g_rmd_pid > 0)
+    {
+      BENCH_CHECK (-1 != kill (g_rmd_pid, SIGTERM));
+    }
+}
+
+static OMX_ERRORTYPE
+bench_EventHandler (OMX_HANDLETYPE ap_hdl, OMX_PTR ap_app_data,
+                    OMX_EVENTTYPE eEvent, OMX_U32 nData1, OMX_U32 nData2,
+                    OMX_PTR pEventData)
+{
+  bench_context_t *p_ctx = ap_app_data;
+  (void) ap_hdl;
+  (void) pEventData;
+
+  BENCH_CHECK (OMX_EventError != eEvent);
+  if (OMX_EventCmdComplete == eEvent && OMX_CommandStateSet == nData1)
+    {
+      tiz_mutex_lock (&p_ctx->mutex);
+      p_ctx->state = (OMX_STATETYPE) nData2;
+      tiz_cond_broadcast (&p_ctx->cond);
+      tiz_mutex_unlock (&p_ctx->mutex);
+    }
+
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+bench_EmptyBufferDone (OMX_HANDLETYPE ap_hdl, OMX_PTR ap_app_data,
+                       OMX_BUFFERHEADERTYPE *ap_buf)
+{
+  bench_context_t *p_ctx = ap_app_data;
+  (void) ap_hdl;
+  (void) ap_buf;
+
+  tiz_mutex_lock (&p_ctx->mutex);
+  p_ctx->nbuffers_done++;
+  tiz_cond_broadcast (&p_ctx->cond);
+  tiz_mutex_unlock (&p_ctx->mutex);
+
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+bench_FillBufferDone (OMX_HANDLETYPE ap_hdl, OMX_PTR ap_app_data,
+                      OMX_BUFFERHEADERTYPE *ap_buf)
+{
+  (void) ap_hdl;
+  (void) ap_app_data;
+  (void) ap_buf;
+  return OMX_ErrorNone;
+}
+
+static OMX_CALLBACKTYPE bench_cbacks
+  = { bench_EventHandler, bench_EmptyBufferDone, bench_FillBufferDone };
+
+static void
+wait_for_state (bench_context_t *ap_ctx, OMX_STATETYPE a_state)
+{
+  tiz_mutex_lock (&ap_ctx->mutex);
+  while (a_state != ap_ctx->state)
+    {
+      BENCH_CHECK (OMX_ErrorUndefined
+                   != tiz_cond_timedwait (&ap_ctx->cond, &ap_ctx->mutex,
+                                          TIMEOUT_EXPECTING_SUCCESS)
+                   || a_state == ap_ctx->state);
+    }
+  tiz_mutex_unlock (&ap_ctx->mutex);
+}
+
+static void
+wait_for_buffers (bench_context_t *ap_ctx, OMX_U32 a_count)
+{
+  tiz_mutex_lock (&ap_ctx->mutex);
+  while (ap_ctx->nbuffers_done < a_count)
+    {
+      BENCH_CHECK (OMX_ErrorUndefined
+                   != tiz_cond_timedwait (&ap_ctx->cond, &ap_ctx->mutex,
+                                          TIMEOUT_EXPECTING_SUCCESS)
+                   || ap_ctx->nbuffers_done >= a_count);
+    }
+  tiz_mutex_unlock (&ap_ctx->mutex);
+}
+
+static inline double
+bench_now_secs (void)
+{
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void
+bench_buffer_exchange (void)
+{
+  bench_context_t ctx;
+  OMX_HANDLETYPE p_hdl = NULL;
+  OMX_PARAM_PORTDEFINITIONTYPE port_def;
+  OMX_BUFFERHEADERTYPE *hdrs[BUFFER_EXCHANGE_MAX_BUFFERS];
+  OMX_U32 nbuffers = 0;
+  OMX_U32 expected = 0;
+  OMX_U32 round = 0;
+  OMX_U32 i;
+  double start = 0;
+  double secs = 0;
+
+  BENCH_CHECK (OMX_ErrorNone == tiz_mutex_init (&ctx.mutex));
+  BENCH_CHECK (OMX_ErrorNone == tiz_cond_init (&ctx.cond));
+  ctx.state = OMX_StateLoaded;
+  ctx.nbuffers_done = 0;
+
+  BENCH_CHECK (OMX_ErrorNone == OMX_Init ());
+  BENCH_CHECK (OMX_ErrorNone
+               == OMX_GetHandle (&p_hdl, COMPONENT_NAME, &ctx,
+                                 &bench_cbacks));
+
+  port_def.nSize = sizeof (OMX_PARAM_PORTDEFINITIONTYPE);
+  port_def.nVersion.nVersion = OMX_VERSION;
+  port_def.nPortIndex = 0;
+  BENCH_CHECK (OMX_ErrorNone
+               == OMX_GetParameter (p_hdl, OMX_IndexParamPortDefinition,
+                                    &port_def));
+  nbuffers = port_def.nBufferCountActual;
+  BENCH_CHECK (nbuffers <= BUFFER_EXCHANGE_MAX_BUFFERS);
+
+  /* Loaded -> Idle -> Executing */
+  BENCH_CHECK (OMX_ErrorNone == OMX_SendCommand (p_hdl, OMX_CommandStateSet,
+                                                 OMX_StateIdle, NULL));
+  for (i = 0; i < nbuffers; ++i)
+    {
+      BENCH_CHECK (OMX_ErrorNone
+                   == OMX_AllocateBuffer (p_hdl, &hdrs[i], 0, 0,
+                                          port_def.nBufferSize));
+    }
+  wait_for_state (&ctx, OMX_StateIdle);
+  BENCH_CHECK (OMX_ErrorNone == OMX_SendCommand (p_hdl, OMX_CommandStateSet,
+                                                 OMX_StateExecuting, NULL));
+  wait_for_state (&ctx, OMX_StateExecuting);
+
+  /* Hand over all the buffers in a burst, wait for all of them to come back,
+     and repeat */
+  start = bench_now_secs ();
+  for (round = 0; round < BUFFER_EXCHANGE_ROUNDS; ++round)
+    {
+      for (i = 0; i < nbuffers; ++i)
+        {
+          hdrs[i]->nFilledLen = hdrs[i]->nAllocLen;
+          BENCH_CHECK (OMX_ErrorNone == OMX_EmptyThisBuffer (p_hdl, hdrs[i]));
+        }
+      expected += nbuffers;
+      wait_for_buffers (&ctx, expected);
+    }
+  secs = bench_now_secs () - start;
+
+  printf ("buffer exchange: [%u] buffers in [%.3f] s - [%.0f] buffers/s\n",
+          (unsigned) expected, secs, secs > 0 ? expected / secs : 0);
+
+  /* Executing -> Idle -> Loaded */
+  BENCH_CHECK (OMX_ErrorNone == OMX_SendCommand (p_hdl, OMX_CommandStateSet,
+                                                 OMX_StateIdle, NULL));
+  wait_for_state (&ctx, OMX_StateIdle);
+  BENCH_CHECK (OMX_ErrorNone == OMX_SendCommand (p_hdl, OMX_CommandStateSet,
+                                                 OMX_StateLoaded, NULL));
+  for (i = 0; i < nbuffers; ++i)
+    {
+      BENCH_CHECK (OMX_ErrorNone == OMX_FreeBuffer (p_hdl, 0, hdrs[i]));
+    }
+  wait_for_state (&ctx, OMX_StateLoaded);
+
+  BENCH_CHECK (OMX_ErrorNone == OMX_FreeHandle (p_hdl));
+  BENCH_CHECK (OMX_ErrorNone == OMX_Deinit ());
+
+  tiz_cond_destroy (&ctx.cond);
+  tiz_mutex_destroy (&ctx.mutex);
+}
+
+int
+main (void)
+{
+  putenv (TIZ_PLATFORM_RC_FILE_ENV);
+
+  tiz_log_init ();
+
+  start_rm_daemon ();
+  bench_buffer_exchange ();
+  stop_rm_daemon ();
+
+  tiz_log_deinit ();
+
+  return EXIT_SUCCESS;
+}
+
+/* Local Variables: */
+/* c-default-style: gnu */
+/* fill-column: 79 */
+/* indent-tabs-mode: nil */
+/* compile-command: "make bench_tizonia" */
+/* End: */
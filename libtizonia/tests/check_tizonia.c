@@ -70,6 +70,11 @@ pid_t g_rmd_pid;
 #define TIMEOUT_EXPECTING_SUCCESS 1000
 /* duration of event timeout in msec when we don't expect event to be set */
 #define TIMEOUT_EXPECTING_FAILURE 2000
+/* buffer exchange test */
+#define BUFFER_EXCHANGE_MAX_BUFFERS 64
+#define BUFFER_EXCHANGE_ROUNDS 50
+/* the pool test case's fixture restarts the RM daemon for every test */
+#define SCHEDULER_POOL_TEST_TIMEOUT 20
 
 typedef void *cc_ctx_t;
 typedef struct check_common_context check_common_context_t;
@@ -82,6 +87,7 @@ struct check_common_context
   OMX_ERRORTYPE error;
   OMX_U32 port;
   OMX_BUFFERHEADERTYPE *p_hdr;
+  OMX_U32 nbuffers_done;
 };
 
 static bool
@@ -176,6 +182,16 @@ teardown (void)
   tiz_mem_free (pg_rmd_path);
 }
 
+/* The pool tests run in the forked test process (checked fixture), so that
+   the configuration file is loaded there, and not in the parent */
+static void
+setup_pool (void)
+{
+  putenv (TIZ_PLATFORM_POOL_RC_FILE_ENV);
+  fail_if (0 != tiz_rcfile_compare_value ("ilcore", "scheduler-mode", "pool"));
+  setup ();
+}
+
 static OMX_ERRORTYPE
 _ctx_init (cc_ctx_t * app_ctx)
 {
@@ -206,6 +222,7 @@ _ctx_init (cc_ctx_t * app_ctx)
   p_ctx->error = OMX_ErrorMax;
   p_ctx->port = OMX_ALL;
   p_ctx->p_hdr = NULL;
+  p_ctx->nbuffers_done = 0;
 
   * app_ctx = p_ctx;
 
@@ -309,6 +326,38 @@ _ctx_wait (cc_ctx_t * app_ctx, OMX_U32 a_millis, OMX_BOOL * ap_has_timedout)
 
 }
 
+/* Waits until 'a_count' buffers in total have been returned by the component */
+static OMX_ERRORTYPE
+_ctx_wait_buffers (cc_ctx_t * app_ctx, OMX_U32 a_count, OMX_U32 a_millis,
+                   OMX_BOOL * ap_has_timedout)
+{
+  check_common_context_t *p_ctx = NULL;
+  assert (app_ctx);
+  p_ctx = * app_ctx;
+
+  * ap_has_timedout = OMX_FALSE;
+
+  if (tiz_mutex_lock (&p_ctx->mutex))
+    {
+      return OMX_ErrorBadParameter;
+    }
+
+  while (p_ctx->nbuffers_done < a_count)
+    {
+      if (OMX_ErrorUndefined == tiz_cond_timedwait (&p_ctx->cond,
+                                                    &p_ctx->mutex, a_millis)
+          && p_ctx->nbuffers_done < a_count)
+        {
+          * ap_has_timedout = OMX_TRUE;
+          break;
+        }
+    }
+
+  tiz_mutex_unlock (&p_ctx->mutex);
+
+  return OMX_ErrorNone;
+}
+
 static OMX_ERRORTYPE
 _ctx_reset (cc_ctx_t * app_ctx)
 {
@@ -420,6 +469,10 @@ OMX_ERRORTYPE check_EmptyBufferDone
   pp_ctx = (cc_ctx_t *) ap_app_data;
   p_ctx = *pp_ctx;
 
+  tiz_mutex_lock (&p_ctx->mutex);
+  p_ctx->nbuffers_done++;
+  tiz_mutex_unlock (&p_ctx->mutex);
+
   p_ctx->p_hdr = ap_buf;
   _ctx_signal (pp_ctx);
 
@@ -775,6 +828,8 @@ START_TEST (test_tizonia_move_to_exe_and_transfer_with_allocbuffer)
   OMX_INDEXTYPE index = OMX_IndexParamPortDefinition;
   OMX_BUFFERHEADERTYPE *p_hdr = NULL;
   OMX_U32 i;
+  tiz_comp_msg_stats_t stats_exe;
+  tiz_comp_msg_stats_t stats_transfer;
 
   error = _ctx_init (&ctx);
   fail_if (OMX_ErrorNone != error);
@@ -843,6 +898,7 @@ START_TEST (test_tizonia_move_to_exe_and_transfer_with_allocbuffer)
   fail_if (OMX_StateExecuting != p_ctx->state);
 
   /* Transfer buffer */
+  tiz_comp_msg_stats (p_hdl, &stats_exe);
   error = _ctx_reset (&ctx);
   p_hdr->nFilledLen = p_hdr->nAllocLen;
   error = OMX_EmptyThisBuffer (p_hdl, p_hdr);
@@ -854,6 +910,12 @@ START_TEST (test_tizonia_move_to_exe_and_transfer_with_allocbuffer)
   fail_if (OMX_TRUE == timedout);
   fail_if (p_ctx->p_hdr != p_hdr);
 
+  /* The buffer exchange must not have allocated scheduler messages on the
+     heap */
+  tiz_comp_msg_stats (p_hdl, &stats_transfer);
+  fail_if (stats_transfer.pool_allocs <= stats_exe.pool_allocs);
+  fail_if (stats_transfer.heap_allocs != stats_exe.heap_allocs);
+
   /* Initiate transition to IDLE */
   error = _ctx_reset (&ctx);
   state = OMX_StateIdle;
@@ -905,6 +967,118 @@ START_TEST (test_tizonia_move_to_exe_and_transfer_with_allocbuffer)
 }
 END_TEST
 
+START_TEST (test_tizonia_buffer_exchange_burst)
+{
+  OMX_ERRORTYPE error = OMX_ErrorNone;
+  OMX_HANDLETYPE p_hdl = 0;
+  OMX_COMMANDTYPE cmd = OMX_CommandStateSet;
+  OMX_STATETYPE state = OMX_StateIdle;
+  cc_ctx_t ctx;
+  check_common_context_t *p_ctx = NULL;
+  OMX_BOOL timedout = OMX_FALSE;
+  OMX_PARAM_PORTDEFINITIONTYPE port_def;
+  OMX_INDEXTYPE index = OMX_IndexParamPortDefinition;
+  OMX_BUFFERHEADERTYPE *hdrs[BUFFER_EXCHANGE_MAX_BUFFERS];
+  OMX_U32 nbuffers = 0;
+  OMX_U32 expected = 0;
+  OMX_U32 round = 0;
+  OMX_U32 i;
+
+  error = _ctx_init (&ctx);
+  fail_if (OMX_ErrorNone != error);
+
+  p_ctx = (check_common_context_t *) (ctx);
+
+  error = OMX_Init ();
+  fail_if (OMX_ErrorNone != error);
+
+  error = OMX_GetHandle (&p_hdl, COMPONENT_NAME, (OMX_PTR *) (&ctx),
+                         &_check_cbacks);
+  fail_if (OMX_ErrorNone != error);
+
+  port_def.nSize = sizeof (OMX_PARAM_PORTDEFINITIONTYPE);
+  port_def.nVersion.nVersion = OMX_VERSION;
+  port_def.nPortIndex = 0;
+  error = OMX_GetParameter (p_hdl, index, &port_def);
+  fail_if (OMX_ErrorNone != error);
+  nbuffers = MIN (port_def.nBufferCountActual, BUFFER_EXCHANGE_MAX_BUFFERS);
+  fail_if (nbuffers != port_def.nBufferCountActual);
+
+  /* Loaded -> Idle */
+  error = OMX_SendCommand (p_hdl, cmd, state, NULL);
+  fail_if (OMX_ErrorNone != error);
+  for (i = 0; i < nbuffers; ++i)
+    {
+      error = OMX_AllocateBuffer (p_hdl, &hdrs[i], 0, 0, port_def.nBufferSize);
+      fail_if (OMX_ErrorNone != error);
+    }
+  error = _ctx_wait (&ctx, TIMEOUT_EXPECTING_SUCCESS, &timedout);
+  fail_if (OMX_ErrorNone != error);
+  fail_if (OMX_TRUE == timedout);
+  fail_if (OMX_StateIdle != p_ctx->state);
+
+  /* Idle -> Executing */
+  error = _ctx_reset (&ctx);
+  state = OMX_StateExecuting;
+  error = OMX_SendCommand (p_hdl, cmd, state, NULL);
+  fail_if (OMX_ErrorNone != error);
+  error = _ctx_wait (&ctx, TIMEOUT_EXPECTING_SUCCESS, &timedout);
+  fail_if (OMX_ErrorNone != error);
+  fail_if (OMX_TRUE == timedout);
+  fail_if (OMX_StateExecuting != p_ctx->state);
+
+  /* Hand over all the buffers in a burst, wait for all of them to come back,
+     and repeat */
+  for (round = 0; round < BUFFER_EXCHANGE_ROUNDS; ++round)
+    {
+      for (i = 0; i < nbuffers; ++i)
+        {
+          hdrs[i]->nFilledLen = hdrs[i]->nAllocLen;
+          error = OMX_EmptyThisBuffer (p_hdl, hdrs[i]);
+          fail_if (OMX_ErrorNone != error);
+        }
+      expected += nbuffers;
+      error = _ctx_wait_buffers (&ctx, expected, TIMEOUT_EXPECTING_SUCCESS,
+                                 &timedout);
+      fail_if (OMX_ErrorNone != error);
+      fail_if (OMX_TRUE == timedout);
+    }
+
+  /* Executing -> Idle */
+  error = _ctx_reset (&ctx);
+  state = OMX_StateIdle;
+  error = OMX_SendCommand (p_hdl, cmd, state, NULL);
+  fail_if (OMX_ErrorNone != error);
+  error = _ctx_wait (&ctx, TIMEOUT_EXPECTING_SUCCESS, &timedout);
+  fail_if (OMX_ErrorNone != error);
+  fail_if (OMX_TRUE == timedout);
+  fail_if (OMX_StateIdle != p_ctx->state);
+
+  /* Idle -> Loaded */
+  error = _ctx_reset (&ctx);
+  state = OMX_StateLoaded;
+  error = OMX_SendCommand (p_hdl, cmd, state, NULL);
+  fail_if (OMX_ErrorNone != error);
+  for (i = 0; i < nbuffers; ++i)
+    {
+      error = OMX_FreeBuffer (p_hdl, 0, hdrs[i]);
+      fail_if (OMX_ErrorNone != error);
+    }
+  error = _ctx_wait (&ctx, TIMEOUT_EXPECTING_SUCCESS, &timedout);
+  fail_if (OMX_ErrorNone != error);
+  fail_if (OMX_TRUE == timedout);
+  fail_if (OMX_StateLoaded != p_ctx->state);
+
+  error = OMX_FreeHandle (p_hdl);
+  fail_if (OMX_ErrorNone != error);
+
+  error = OMX_Deinit ();
+  fail_if (OMX_ErrorNone != error);
+
+  _ctx_destroy(&ctx);
+}
+END_TEST
+
 START_TEST (test_tizonia_command_cancellation_loaded_to_idle_no_buffers)
 {
   OMX_ERRORTYPE error = OMX_ErrorNone;
@@ -2025,10 +2199,27 @@ Suite *
 tiz_suite (void)
 {
   TCase *tc_tizonia;
+  TCase *tc_tizonia_pool;
   Suite *s = suite_create ("libtizonia");
 
   putenv(TIZ_PLATFORM_RC_FILE_ENV);
 
+  /* Same sequences, with the component schedulers run by the shared worker
+     pool. This test case must be added first: the configuration file is
+     loaded only once per process, and the unchecked fixture of the
+     "tizonia" test case loads it in the parent process. */
+  tc_tizonia_pool = tcase_create ("tizonia scheduler pool");
+  tcase_add_checked_fixture (tc_tizonia_pool, setup_pool, teardown);
+  tcase_set_timeout (tc_tizonia_pool, SCHEDULER_POOL_TEST_TIMEOUT);
+  tcase_add_test (tc_tizonia_pool,
+                  test_tizonia_move_to_exe_and_transfer_with_allocbuffer);
+  tcase_add_test (tc_tizonia_pool, test_tizonia_buffer_exchange_burst);
+  tcase_add_test (tc_tizonia_pool,
+                  test_tizonia_command_cancellation_loaded_to_idle_no_buffers);
+  tcase_add_test (tc_tizonia_pool,
+                  test_tizonia_command_cancellation_disabled_to_enabled_no_buffers);
+  suite_add_tcase (s, tc_tizonia_pool);
+
   /* IL Common API test cases */
   tc_tizonia = tcase_create ("tizonia");
   tcase_add_unchecked_fixture (tc_tizonia, setup, teardown);
@@ -2054,6 +2245,7 @@ tiz_suite (void)
   tcase_add_test (tc_tizonia, test_tizonia_pd_set);
   tcase_add_test (tc_tizonia,
                   test_tizonia_move_to_exe_and_transfer_with_allocbuffer);
+  tcase_add_test (tc_tizonia, test_tizonia_buffer_exchange_burst);
   tcase_add_test (tc_tizonia,
                   test_tizonia_command_cancellation_loaded_to_idle_no_buffers);
   /* TEST DISABLED */
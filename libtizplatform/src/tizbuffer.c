@@ -30,10 +30,15 @@
 #include <config.h>
 #endif
 
+#define _GNU_SOURCE
+
 #include <assert.h>
+#include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
 #include <limits.h>
+#include <unistd.h>
+#include <sys/mman.h>
 
 #include "tizmem.h"
 #include "tizlog.h"
@@ -48,10 +53,13 @@
 struct tiz_buffer
 {
   unsigned char * p_store;
-  int alloc_len;
-  int filled_len;
-  int offset;
+  size_t alloc_len;
+  size_t filled_len;
+  size_t offset;
+  size_t start; /* data before this position has been discarded */
+  size_t high_watermark;
   int seek_mode;
+  bool mirrored; /* the store is mapped twice, back to back */
 };
 
 static long
@@ -61,6 +69,240 @@ abs_of (const long v)
   return (v + mask) ^ mask;
 }
 
+static inline bool
+is_circular (const tiz_buffer_t * ap_buf)
+{
+  return TIZ_BUFFER_CIRCULAR == ap_buf->seek_mode;
+}
+
+static size_t
+round_to_page_size (const size_t a_nbytes)
+{
+  const long page_size = sysconf (_SC_PAGESIZE);
+  const size_t p = page_size > 0 ? (size_t) page_size : 4096;
+  return ((a_nbytes + p - 1) / p) * p;
+}
+
+/* In circular mode, the same pages are mapped twice, one copy right after
+   the other. The data that wraps around the end of the store can then be
+   read and written as if it were contiguous. */
+static unsigned char *
+map_mirrored_store (const size_t a_nbytes)
+{
+#ifdef HAVE_MEMFD_CREATE
+  unsigned char * p_base = MAP_FAILED;
+  const int fd = memfd_create ("tizbuffer", MFD_CLOEXEC);
+
+  if (fd < 0)
+    {
+      return NULL;
+    }
+
+  if (0 == ftruncate (fd, a_nbytes)
+      && MAP_FAILED != (p_base = mmap (NULL, 2 * a_nbytes, PROT_NONE,
+                                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0)))
+    {
+      if (MAP_FAILED == mmap (p_base, a_nbytes, PROT_READ | PROT_WRITE,
+                              MAP_SHARED | MAP_FIXED, fd, 0)
+          || MAP_FAILED == mmap (p_base + a_nbytes, a_nbytes,
+                                 PROT_READ | PROT_WRITE,
+                                 MAP_SHARED | MAP_FIXED, fd, 0))
+        {
+          (void) munmap (p_base, 2 * a_nbytes);
+          p_base = MAP_FAILED;
+        }
+    }
+
+  (void) close (fd);
+  return MAP_FAILED != p_base ? p_base : NULL;
+#else
+  (void) a_nbytes;
+  return NULL;
+#endif
+}
+
+static void
+free_store (tiz_buffer_t * ap_buf)
+{
+  assert (ap_buf);
+  if (ap_buf->mirrored)
+    {
+      (void) munmap (ap_buf->p_store, 2 * ap_buf->alloc_len);
+    }
+  else
+    {
+      tiz_mem_free (ap_buf->p_store);
+    }
+  ap_buf->p_store = NULL;
+  ap_buf->mirrored = false;
+}
+
+/* Copies the data available, taking care of the wrap around in circular
+   mode when the store is not mirrored */
+static void
+copy_out (const tiz_buffer_t * ap_buf, unsigned char * ap_dst,
+          const size_t a_nbytes)
+{
+  assert (ap_buf);
+  assert (a_nbytes <= ap_buf->filled_len);
+  if (is_circular (ap_buf) && !ap_buf->mirrored
+      && ap_buf->offset + a_nbytes > ap_buf->alloc_len)
+    {
+      const size_t first = ap_buf->alloc_len - ap_buf->offset;
+      memcpy (ap_dst, ap_buf->p_store + ap_buf->offset, first);
+      memcpy (ap_dst + first, ap_buf->p_store, a_nbytes - first);
+    }
+  else
+    {
+      memcpy (ap_dst, ap_buf->p_store + ap_buf->offset, a_nbytes);
+    }
+}
+
+/* Moves the data available to the start of a new store of (at least)
+   a_nbytes, laid out for circular mode or not. Any data behind the current
+   position is dropped. */
+static bool
+replace_store (tiz_buffer_t * ap_buf, const bool a_circular, size_t a_nbytes)
+{
+  unsigned char * p_store = NULL;
+  bool mirrored = false;
+
+  assert (ap_buf);
+  assert (a_nbytes >= ap_buf->filled_len);
+
+  if (a_circular)
+    {
+      a_nbytes = round_to_page_size (a_nbytes);
+      mirrored = (NULL != (p_store = map_mirrored_store (a_nbytes)));
+    }
+
+  if (!p_store && !(p_store = tiz_mem_alloc (a_nbytes)))
+    {
+      return false;
+    }
+
+  copy_out (ap_buf, p_store, ap_buf->filled_len);
+  free_store (ap_buf);
+  ap_buf->p_store = p_store;
+  ap_buf->alloc_len = a_nbytes;
+  ap_buf->offset = 0;
+  ap_buf->start = 0;
+  ap_buf->mirrored = mirrored;
+  return true;
+}
+
+static void
+reverse (unsigned char * ap_first, unsigned char * ap_last)
+{
+  while (ap_first < --ap_last)
+    {
+      const unsigned char tmp = *ap_first;
+      *ap_first++ = *ap_last;
+      *ap_last = tmp;
+    }
+}
+
+/* Rotates the store in place so that the data starts at the beginning. Only
+   needed in circular mode when the store could not be mirrored. */
+static void
+rotate_to_front (tiz_buffer_t * ap_buf)
+{
+  unsigned char * p_store = ap_buf->p_store;
+  reverse (p_store, p_store + ap_buf->offset);
+  reverse (p_store + ap_buf->offset, p_store + ap_buf->alloc_len);
+  reverse (p_store, p_store + ap_buf->alloc_len);
+  ap_buf->offset = 0;
+}
+
+/* The number of bytes that can be pushed without growing the store */
+static inline size_t
+free_space (const tiz_buffer_t * ap_buf)
+{
+  return is_circular (ap_buf)
+           ? ap_buf->alloc_len - ap_buf->filled_len
+           : ap_buf->alloc_len - (ap_buf->offset + ap_buf->filled_len);
+}
+
+/* The number of bytes that need to be preserved in the store */
+static inline size_t
+retained_len (const tiz_buffer_t * ap_buf)
+{
+  return is_circular (ap_buf)
+           ? ap_buf->filled_len
+           : ap_buf->offset + ap_buf->filled_len - ap_buf->start;
+}
+
+static void
+compact (tiz_buffer_t * ap_buf)
+{
+  if (ap_buf->start > 0)
+    {
+      memmove (ap_buf->p_store, ap_buf->p_store + ap_buf->start,
+               retained_len (ap_buf));
+      ap_buf->offset -= ap_buf->start;
+      ap_buf->start = 0;
+    }
+}
+
+/* Data is only moved when there is not enough room at the back of the
+   store. The store grows geometrically, but never beyond the high
+   watermark, if one has been set. */
+static void
+make_room (tiz_buffer_t * ap_buf, const size_t a_nbytes)
+{
+  const size_t needed = retained_len (ap_buf) + a_nbytes;
+  size_t new_len = MAX (ap_buf->alloc_len * 2, needed);
+
+  if (ap_buf->high_watermark > 0)
+    {
+      new_len = MIN (new_len, MAX (ap_buf->high_watermark, ap_buf->alloc_len));
+    }
+
+  if (is_circular (ap_buf))
+    {
+      if (new_len > ap_buf->alloc_len)
+        {
+          (void) replace_store (ap_buf, true, new_len);
+        }
+      return;
+    }
+
+  compact (ap_buf);
+
+  if (free_space (ap_buf) < a_nbytes && new_len > ap_buf->alloc_len)
+    {
+      unsigned char * p_store = tiz_mem_realloc (ap_buf->p_store, new_len);
+      if (p_store)
+        {
+          ap_buf->p_store = p_store;
+          ap_buf->alloc_len = new_len;
+        }
+    }
+}
+
+static void
+write_data (tiz_buffer_t * ap_buf, const void * ap_data, const size_t a_nbytes)
+{
+  size_t pos = ap_buf->offset + ap_buf->filled_len;
+  assert (a_nbytes <= free_space (ap_buf));
+  if (is_circular (ap_buf))
+    {
+      if (pos >= ap_buf->alloc_len)
+        {
+          pos -= ap_buf->alloc_len;
+        }
+      if (!ap_buf->mirrored && pos + a_nbytes > ap_buf->alloc_len)
+        {
+          const size_t first = ap_buf->alloc_len - pos;
+          memcpy (ap_buf->p_store + pos, ap_data, first);
+          memcpy (ap_buf->p_store, (const unsigned char *) ap_data + first,
+                  a_nbytes - first);
+          return;
+        }
+    }
+  memcpy (ap_buf->p_store + pos, ap_data, a_nbytes);
+}
+
 static inline void *
 alloc_data_store (tiz_buffer_t * ap_buf, const size_t nbytes)
 {
@@ -75,7 +317,10 @@ alloc_data_store (tiz_buffer_t * ap_buf, const size_t nbytes)
           ap_buf->alloc_len = nbytes;
           ap_buf->filled_len = 0;
           ap_buf->offset = 0;
+          ap_buf->start = 0;
+          ap_buf->high_watermark = 0;
           ap_buf->seek_mode = TIZ_BUFFER_NON_SEEKABLE;
+          ap_buf->mirrored = false;
         }
     }
   return ap_buf->p_store;
@@ -89,11 +334,11 @@ dealloc_data_store (
 {
   if (ap_buf)
     {
-      tiz_mem_free (ap_buf->p_store);
-      ap_buf->p_store = NULL;
+      free_store (ap_buf);
       ap_buf->alloc_len = 0;
       ap_buf->filled_len = 0;
       ap_buf->offset = 0;
+      ap_buf->start = 0;
       ap_buf->seek_mode = TIZ_BUFFER_NON_SEEKABLE;
     }
 }
@@ -150,115 +395,177 @@ tiz_buffer_seek_mode (tiz_buffer_t * ap_buf, const int a_seek_mode)
 {
   int old_val = -1;
   if (a_seek_mode == TIZ_BUFFER_SEEKABLE
-      || a_seek_mode == TIZ_BUFFER_NON_SEEKABLE)
+      || a_seek_mode == TIZ_BUFFER_NON_SEEKABLE
+      || a_seek_mode == TIZ_BUFFER_CIRCULAR)
     {
       assert (ap_buf);
       old_val = ap_buf->seek_mode;
+      if (old_val != a_seek_mode
+          && (TIZ_BUFFER_CIRCULAR == a_seek_mode
+              || TIZ_BUFFER_CIRCULAR == old_val))
+        {
+          /* The store is laid out differently in circular mode */
+          if (!replace_store (ap_buf, TIZ_BUFFER_CIRCULAR == a_seek_mode,
+                              ap_buf->alloc_len))
+            {
+              return -1;
+            }
+        }
       ap_buf->seek_mode = a_seek_mode;
     }
   return old_val;
 }
 
-int
+void
+tiz_buffer_set_high_watermark (tiz_buffer_t * ap_buf, const size_t a_nbytes)
+{
+  assert (ap_buf);
+  ap_buf->high_watermark = a_nbytes;
+}
+
+size_t
 tiz_buffer_push (tiz_buffer_t * ap_buf, const void * ap_data,
                  const size_t a_nbytes)
 {
-  OMX_U32 nbytes_to_copy = 0;
+  size_t nbytes_to_copy = 0;
 
   assert (ap_buf);
-  assert (ap_buf->alloc_len >= (ap_buf->offset + ap_buf->filled_len));
+  assert (is_circular (ap_buf)
+          || ap_buf->alloc_len >= (ap_buf->offset + ap_buf->filled_len));
 
   if (ap_data && a_nbytes > 0)
     {
-      size_t avail = 0;
-
-      if (ap_buf->seek_mode == TIZ_BUFFER_NON_SEEKABLE
-          && ap_buf->offset > 0)
+      if (ap_buf->seek_mode == TIZ_BUFFER_NON_SEEKABLE)
         {
-          memmove (ap_buf->p_store, (ap_buf->p_store + ap_buf->offset),
-                   ap_buf->filled_len);
-          ap_buf->offset = 0;
+          /* Discard the data behind the position marker */
+          ap_buf->start = ap_buf->offset;
         }
 
-      avail = ap_buf->alloc_len - (ap_buf->offset + ap_buf->filled_len);
-
-      if (a_nbytes > avail)
+      if (a_nbytes > free_space (ap_buf))
         {
-          /* need to re-alloc */
-          OMX_U8 * p_new_store = NULL;
-          size_t need = ap_buf->alloc_len * 2;
-          p_new_store = tiz_mem_realloc (ap_buf->p_store, need);
-          if (p_new_store)
-            {
-              ap_buf->p_store = p_new_store;
-              ap_buf->alloc_len = need;
-              avail = ap_buf->alloc_len - (ap_buf->offset + ap_buf->filled_len);
-            }
+          make_room (ap_buf, a_nbytes);
         }
-      nbytes_to_copy = MIN (avail, a_nbytes);
-      memcpy (ap_buf->p_store + ap_buf->offset + ap_buf->filled_len, ap_data, nbytes_to_copy);
+
+      nbytes_to_copy = MIN (free_space (ap_buf), a_nbytes);
+      write_data (ap_buf, ap_data, nbytes_to_copy);
       ap_buf->filled_len += nbytes_to_copy;
     }
   return nbytes_to_copy;
 }
 
-int
+size_t
 tiz_buffer_available (const tiz_buffer_t * ap_buf)
 {
   assert (ap_buf);
-  assert (ap_buf->alloc_len >= (ap_buf->offset + ap_buf->filled_len));
   return ap_buf->filled_len;
 }
 
-int
+size_t
 tiz_buffer_offset (const tiz_buffer_t * ap_buf)
 {
   assert (ap_buf);
-  assert (ap_buf->alloc_len >= (ap_buf->offset + ap_buf->filled_len));
-  return ap_buf->offset;
+  return is_circular (ap_buf) ? ap_buf->offset
+                              : ap_buf->offset - ap_buf->start;
 }
 
 void *
-tiz_buffer_get (const tiz_buffer_t * ap_buf)
+tiz_buffer_get (tiz_buffer_t * ap_buf)
 {
   assert (ap_buf);
-  assert (ap_buf->alloc_len >= (ap_buf->offset + ap_buf->filled_len));
+  if (is_circular (ap_buf) && !ap_buf->mirrored
+      && ap_buf->offset + ap_buf->filled_len > ap_buf->alloc_len)
+    {
+      /* The data wraps around, and there is no mirror to read it from. Move
+         it to a fresh store; rotate in place only if that is not possible */
+      if (!replace_store (ap_buf, true, ap_buf->alloc_len))
+        {
+          rotate_to_front (ap_buf);
+        }
+    }
   return (ap_buf->p_store + ap_buf->offset);
 }
 
-int
-tiz_buffer_advance (tiz_buffer_t * ap_buf, const int nbytes)
+size_t
+tiz_buffer_peek (const tiz_buffer_t * ap_buf, void ** app_first,
+                 size_t * ap_first_len, void ** app_second,
+                 size_t * ap_second_len)
 {
-  int min_nbytes = 0;
+  size_t first_len = 0;
   assert (ap_buf);
-  if (nbytes > 0)
+  assert (app_first);
+  assert (ap_first_len);
+  assert (app_second);
+  assert (ap_second_len);
+
+  first_len = ap_buf->filled_len;
+  if (is_circular (ap_buf) && !ap_buf->mirrored)
     {
-      min_nbytes = MIN (nbytes, tiz_buffer_available (ap_buf));
-      ap_buf->offset += min_nbytes;
-      ap_buf->filled_len -= min_nbytes;
+      first_len = MIN (first_len, ap_buf->alloc_len - ap_buf->offset);
     }
-  return min_nbytes;
+
+  *app_first = ap_buf->p_store + ap_buf->offset;
+  *ap_first_len = first_len;
+  *app_second = ap_buf->p_store;
+  *ap_second_len = ap_buf->filled_len - first_len;
+  return ap_buf->filled_len;
+}
+
+size_t
+tiz_buffer_advance (tiz_buffer_t * ap_buf, const size_t a_nbytes)
+{
+  size_t nbytes = 0;
+  assert (ap_buf);
+  nbytes = MIN (a_nbytes, ap_buf->filled_len);
+  ap_buf->offset += nbytes;
+  ap_buf->filled_len -= nbytes;
+  if (is_circular (ap_buf))
+    {
+      if (ap_buf->offset >= ap_buf->alloc_len)
+        {
+          ap_buf->offset -= ap_buf->alloc_len;
+        }
+      if (0 == ap_buf->filled_len)
+        {
+          /* Rewind, so that the next push does not wrap around */
+          ap_buf->offset = 0;
+        }
+    }
+  return nbytes;
 }
 
 int
 tiz_buffer_seek (tiz_buffer_t * ap_buf, const long offset, const int whence)
 {
   int rc = -1;
+  size_t total = 0;
   assert (ap_buf);
+
+  if (is_circular (ap_buf))
+    {
+      /* Only forward from the current position */
+      if (whence == TIZ_BUFFER_SEEK_CUR && offset >= 0)
+        {
+          (void) tiz_buffer_advance (ap_buf, offset);
+          rc = 0;
+        }
+      return rc;
+    }
+
   assert (ap_buf->alloc_len >= (ap_buf->offset + ap_buf->filled_len));
 
-  int total = ap_buf->offset + ap_buf->filled_len;
-  if (whence == TIZ_BUFFER_SEEK_SET)
+  total = ap_buf->offset + ap_buf->filled_len;
+  if (whence == TIZ_BUFFER_SEEK_SET && offset >= 0)
     {
-      ap_buf->offset = MIN (offset, total);
+      ap_buf->offset
+        = ap_buf->start + MIN ((size_t) offset, total - ap_buf->start);
       rc = 0;
     }
   else if (whence == TIZ_BUFFER_SEEK_CUR)
     {
-      unsigned int r = abs_of (offset);
+      size_t r = abs_of (offset);
       if (offset < 0)
         {
-          ap_buf->offset -= MIN (r, ap_buf->offset);
+          ap_buf->offset -= MIN (r, ap_buf->offset - ap_buf->start);
         }
       else
         {
@@ -268,8 +575,8 @@ tiz_buffer_seek (tiz_buffer_t * ap_buf, const long offset, const int whence)
     }
   else if (whence == TIZ_BUFFER_SEEK_END && offset < 0)
     {
-      unsigned int r = abs_of (offset);
-      ap_buf->offset = total - MIN (r, total);
+      size_t r = abs_of (offset);
+      ap_buf->offset = total - MIN (r, total - ap_buf->start);
       rc = 0;
     }
   if (0 == rc)
@@ -289,5 +596,6 @@ tiz_buffer_clear (tiz_buffer_t * ap_buf)
     {
       ap_buf->offset = 0;
       ap_buf->filled_len = 0;
+      ap_buf->start = 0;
     }
 }
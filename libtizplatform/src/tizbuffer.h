@@ -52,6 +52,12 @@ extern "C" {
 #define TIZ_BUFFER_SEEKABLE \
   1 /** Data pushed on to the buffer is only discarded explicitely when
         'tiz_clear_buffer' is used. */
+#define TIZ_BUFFER_CIRCULAR \
+  2 /** Ring buffer. Data is consumed as in TIZ_BUFFER_NON_SEEKABLE, but
+        pushing never moves the data already in the buffer. Where possible,
+        the store is mapped twice, back to back, so that the data available
+        is always contiguous; otherwise see 'tiz_buffer_peek'. Only forward
+        seeks from the current position are supported. */
 
 /* The possibilities for the third argument to 'tiz_buffer_seek'.
    These values should not be changed.  */
@@ -89,15 +95,30 @@ tiz_buffer_destroy (tiz_buffer_t * ap_buf);
 /**
  * Set a new overwrite mode.
  *
+ * Switching to or from TIZ_BUFFER_CIRCULAR re-allocates the store, and only
+ * the data available is kept.
+ *
  * @ingroup tizbuffer
  * @param ap_buf The dynamic buffer handle.
- * @param a_seek_mode TIZ_BUFFER_NON_SEEKABLE (default) or
- * TIZ_BUFFER_SEEKABLE.
+ * @param a_seek_mode TIZ_BUFFER_NON_SEEKABLE (default), TIZ_BUFFER_SEEKABLE
+ * or TIZ_BUFFER_CIRCULAR.
  * @return The old seek mode, or -1 on error.
  */
 int
 tiz_buffer_seek_mode (tiz_buffer_t * ap_buf, const int a_seek_mode);
 
+/**
+ * Limit the size the data store may grow to. Once the limit has been
+ * reached, tiz_buffer_push only stores what fits.
+ *
+ * @ingroup tizbuffer
+ * @param ap_buf The dynamic buffer handle.
+ * @param a_nbytes The maximum size of the data store, or zero (the default)
+ * for no limit.
+ */
+void
+tiz_buffer_set_high_watermark (tiz_buffer_t * ap_buf, const size_t a_nbytes);
+
 /**
  * Copy data at the back the buffer.
  *
@@ -107,7 +128,7 @@ tiz_buffer_seek_mode (tiz_buffer_t * ap_buf, const int a_seek_mode);
  * @param a_nbytes The number of bytes to store.
  * @return The number of bytes actually stored.
  */
-int
+size_t
 tiz_buffer_push (tiz_buffer_t * ap_buf, const void * ap_data,
                  const size_t a_nbytes);
 
@@ -129,7 +150,7 @@ tiz_buffer_clear (tiz_buffer_t * ap_buf);
  * @param ap_buf The dynamic buffer handle.
  * @return The total number of bytes currently available.
  */
-int
+size_t
 tiz_buffer_available (const tiz_buffer_t * ap_buf);
 
 /**
@@ -139,7 +160,7 @@ tiz_buffer_available (const tiz_buffer_t * ap_buf);
  * @param ap_buf The  buffer handle.
  * @return The offset in bytes that marks the current position in the buffer.
  */
-int
+size_t
 tiz_buffer_offset (const tiz_buffer_t * ap_buf);
 
 /**
@@ -149,12 +170,36 @@ tiz_buffer_offset (const tiz_buffer_t * ap_buf);
  * If the buffer is empty, i.e. tiz_buffer_available returns zero, the
  * pointer returned is the position of the start of the buffer.
  *
+ * The data available can be read contiguously from here. In
+ * TIZ_BUFFER_CIRCULAR mode, when the store could not be mirrored, this may
+ * need to move the data first; tiz_buffer_peek never does.
+ *
  * @ingroup tizbuffer
  * @param ap_buf The dynamic buffer handle.
  * @return The pointer to the current position in the buffer.
  */
 void *
-tiz_buffer_get (const tiz_buffer_t * ap_buf);
+tiz_buffer_get (tiz_buffer_t * ap_buf);
+
+/**
+ * @brief Retrieve the data available without moving it.
+ *
+ * The data is returned in two segments. The second one is only non-empty in
+ * TIZ_BUFFER_CIRCULAR mode, when the data wraps around the end of a store
+ * that could not be mirrored.
+ *
+ * @ingroup tizbuffer
+ * @param ap_buf The dynamic buffer handle.
+ * @param app_first The start of the first segment.
+ * @param ap_first_len The length of the first segment.
+ * @param app_second The start of the second segment.
+ * @param ap_second_len The length of the second segment.
+ * @return The total number of bytes currently available.
+ */
+size_t
+tiz_buffer_peek (const tiz_buffer_t * ap_buf, void ** app_first,
+                 size_t * ap_first_len, void ** app_second,
+                 size_t * ap_second_len);
 
 /**
  * @brief Advance the current position in the buffer.
@@ -164,8 +209,8 @@ tiz_buffer_get (const tiz_buffer_t * ap_buf);
  * @param nbytes The number of bytes to increment the position marker by.
  * @return The number of bytes actually advanced.
  */
-int
-tiz_buffer_advance (tiz_buffer_t * ap_buf, const int nbytes);
+size_t
+tiz_buffer_advance (tiz_buffer_t * ap_buf, const size_t nbytes);
 
 /**
  * @brief Re-position the position marker.
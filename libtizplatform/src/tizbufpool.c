@@ -0,0 +1,374 @@
+/**
+ * Copyright (C) 2011-2017 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   tizbufpool.c
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Tizonia Platform - Aligned, pooled OpenMAX IL buffer allocator
+ *
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "tizplatform.h"
+#include "tizbufpool.h"
+
+#ifdef TIZ_LOG_CATEGORY_NAME
+#undef TIZ_LOG_CATEGORY_NAME
+#define TIZ_LOG_CATEGORY_NAME "tiz.platform.bufpool"
+#endif
+
+/* Sizes from here on are rounded up to whole pages, so that buffers of
+   roughly the same size can be reused for one another */
+#define BUFPOOL_PAGE_ROUNDING_THRESHOLD (64 * 1024)
+
+typedef struct bufpool_blk bufpool_blk_t;
+struct bufpool_blk
+{
+  bufpool_blk_t * p_next;
+  OMX_U8 * p_addr;
+  size_t capacity;
+  size_t alignment;
+  size_t map_len; /* non-zero if the buffer was mmap'ed */
+};
+
+static struct
+{
+  pthread_mutex_t mutex;
+  bufpool_blk_t * p_used;
+  bufpool_blk_t * p_cached;
+  tiz_bufpool_info_t info;
+} g_bufpool = {PTHREAD_MUTEX_INITIALIZER, NULL, NULL, {0, 0, 0, 0, 0, 0}};
+
+static size_t
+page_size (void)
+{
+  const long ps = sysconf (_SC_PAGESIZE);
+  return ps > 0 ? (size_t) ps : 4096;
+}
+
+static inline size_t
+round_up (const size_t a_nbytes, const size_t a_multiple)
+{
+  return ((a_nbytes + a_multiple - 1) / a_multiple) * a_multiple;
+}
+
+static size_t
+effective_alignment (const size_t a_alignment, const OMX_U32 a_flags)
+{
+  size_t alignment = TIZ_BUFPOOL_DEFAULT_ALIGNMENT;
+  if (a_flags & (TIZ_BUFPOOL_PAGE_ALIGNED | TIZ_BUFPOOL_HUGEPAGES))
+    {
+      alignment = page_size ();
+    }
+  while (alignment < a_alignment)
+    {
+      alignment <<= 1;
+    }
+  return alignment;
+}
+
+static size_t
+effective_capacity (const size_t a_size, const size_t a_alignment)
+{
+  size_t capacity = round_up (MAX (a_size, (size_t) 1), a_alignment);
+  if (capacity >= BUFPOOL_PAGE_ROUNDING_THRESHOLD)
+    {
+      capacity = round_up (capacity, page_size ());
+    }
+  return capacity;
+}
+
+static OMX_U8 *
+map_buffer (const size_t a_capacity, size_t * ap_map_len)
+{
+  void * p_addr = MAP_FAILED;
+  size_t map_len = 0;
+
+  assert (ap_map_len);
+
+#ifdef MAP_HUGETLB
+  /* Only succeeds if huge pages have been reserved (vm.nr_hugepages) */
+  map_len = round_up (a_capacity, TIZ_BUFPOOL_HUGEPAGE_SIZE);
+  p_addr = mmap (NULL, map_len, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+
+  if (MAP_FAILED == p_addr)
+    {
+      map_len = a_capacity;
+      p_addr = mmap (NULL, map_len, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+#ifdef MADV_HUGEPAGE
+      if (MAP_FAILED != p_addr)
+        {
+          /* A hint only; transparent huge pages may be disabled */
+          (void) madvise (p_addr, map_len, MADV_HUGEPAGE);
+        }
+#endif
+    }
+
+  *ap_map_len = MAP_FAILED != p_addr ? map_len : 0;
+  return MAP_FAILED != p_addr ? p_addr : NULL;
+}
+
+static bufpool_blk_t *
+new_block (const size_t a_capacity, const size_t a_alignment,
+           const OMX_U32 a_flags)
+{
+  bufpool_blk_t * p_blk = tiz_mem_calloc (1, sizeof (bufpool_blk_t));
+
+  if (p_blk)
+    {
+      p_blk->capacity = a_capacity;
+      p_blk->alignment = a_alignment;
+
+      if ((a_flags & TIZ_BUFPOOL_HUGEPAGES)
+          && a_capacity >= TIZ_BUFPOOL_HUGEPAGE_SIZE
+          && a_alignment <= page_size ())
+        {
+          /* Anonymous mappings are already zeroed */
+          p_blk->p_addr = map_buffer (a_capacity, &(p_blk->map_len));
+        }
+
+      if (!p_blk->p_addr)
+        {
+          void * p_addr = NULL;
+          if (0 == posix_memalign (&p_addr, a_alignment, a_capacity))
+            {
+              p_blk->p_addr = tiz_mem_set (p_addr, 0, a_capacity);
+            }
+        }
+
+      if (!p_blk->p_addr)
+        {
+          tiz_mem_free (p_blk);
+          p_blk = NULL;
+        }
+    }
+
+  return p_blk;
+}
+
+static void
+delete_block (bufpool_blk_t * ap_blk)
+{
+  assert (ap_blk);
+  if (ap_blk->map_len > 0)
+    {
+      (void) munmap (ap_blk->p_addr, ap_blk->map_len);
+    }
+  else
+    {
+      free (ap_blk->p_addr);
+    }
+  tiz_mem_free (ap_blk);
+}
+
+/* To be called with the mutex held */
+static bufpool_blk_t *
+take_cached_block (const size_t a_capacity, const size_t a_alignment,
+                   const OMX_U32 a_flags)
+{
+  bufpool_blk_t ** pp_blk = &(g_bufpool.p_cached);
+  const bool huge = (a_flags & TIZ_BUFPOOL_HUGEPAGES)
+                    && a_capacity >= TIZ_BUFPOOL_HUGEPAGE_SIZE;
+
+  while (*pp_blk)
+    {
+      bufpool_blk_t * p_blk = *pp_blk;
+      if (p_blk->capacity == a_capacity && p_blk->alignment >= a_alignment
+          && (!huge || p_blk->map_len > 0))
+        {
+          *pp_blk = p_blk->p_next;
+          g_bufpool.info.cached_bufs--;
+          g_bufpool.info.cached_bytes -= p_blk->capacity;
+          return p_blk;
+        }
+      pp_blk = &(p_blk->p_next);
+    }
+
+  return NULL;
+}
+
+/* To be called with the mutex held */
+static void
+add_used_block (bufpool_blk_t * ap_blk)
+{
+  assert (ap_blk);
+  ap_blk->p_next = g_bufpool.p_used;
+  g_bufpool.p_used = ap_blk;
+  g_bufpool.info.used_bufs++;
+  g_bufpool.info.used_bytes += ap_blk->capacity;
+}
+
+/* To be called with the mutex held */
+static bufpool_blk_t *
+remove_used_block (const OMX_PTR ap_buf)
+{
+  bufpool_blk_t ** pp_blk = &(g_bufpool.p_used);
+
+  while (*pp_blk)
+    {
+      bufpool_blk_t * p_blk = *pp_blk;
+      if (p_blk->p_addr == ap_buf)
+        {
+          *pp_blk = p_blk->p_next;
+          g_bufpool.info.used_bufs--;
+          g_bufpool.info.used_bytes -= p_blk->capacity;
+          return p_blk;
+        }
+      pp_blk = &(p_blk->p_next);
+    }
+
+  return NULL;
+}
+
+OMX_PTR
+tiz_bufpool_alloc (size_t a_size, size_t a_alignment, OMX_U32 a_flags)
+{
+  const size_t alignment = effective_alignment (a_alignment, a_flags);
+  const size_t capacity = effective_capacity (a_size, alignment);
+  bufpool_blk_t * p_blk = NULL;
+
+  (void) pthread_mutex_lock (&(g_bufpool.mutex));
+  if ((p_blk = take_cached_block (capacity, alignment, a_flags)))
+    {
+      g_bufpool.info.hits++;
+      add_used_block (p_blk);
+    }
+  (void) pthread_mutex_unlock (&(g_bufpool.mutex));
+
+  if (p_blk)
+    {
+      /* Clients get the same zeroed memory a new buffer would have; only
+         the requested size is cleared */
+      (void) tiz_mem_set (p_blk->p_addr, 0, a_size);
+    }
+  else if ((p_blk = new_block (capacity, alignment, a_flags)))
+    {
+      (void) pthread_mutex_lock (&(g_bufpool.mutex));
+      g_bufpool.info.misses++;
+      add_used_block (p_blk);
+      (void) pthread_mutex_unlock (&(g_bufpool.mutex));
+    }
+
+  TIZ_LOG (TIZ_PRIORITY_TRACE, "size [%zu] alignment [%zu] buf [%p] [%s]",
+           a_size, alignment, p_blk ? p_blk->p_addr : NULL,
+           p_blk ? (p_blk->map_len > 0 ? "mapped" : "heap") : "failed");
+
+  return p_blk ? p_blk->p_addr : NULL;
+}
+
+void
+tiz_bufpool_free (OMX_PTR ap_buf)
+{
+  bufpool_blk_t * p_blk = NULL;
+
+  if (!ap_buf)
+    {
+      return;
+    }
+
+  (void) pthread_mutex_lock (&(g_bufpool.mutex));
+  if ((p_blk = remove_used_block (ap_buf)))
+    {
+      if (g_bufpool.info.cached_bytes + p_blk->capacity
+          <= TIZ_BUFPOOL_MAX_CACHED_BYTES)
+        {
+          p_blk->p_next = g_bufpool.p_cached;
+          g_bufpool.p_cached = p_blk;
+          g_bufpool.info.cached_bufs++;
+          g_bufpool.info.cached_bytes += p_blk->capacity;
+          p_blk = NULL;
+        }
+    }
+  else
+    {
+      TIZ_LOG (TIZ_PRIORITY_ERROR, "Unknown buffer [%p]", ap_buf);
+      assert (0);
+    }
+  (void) pthread_mutex_unlock (&(g_bufpool.mutex));
+
+  if (p_blk)
+    {
+      /* The pool is full */
+      delete_block (p_blk);
+    }
+}
+
+void
+tiz_bufpool_trim (void)
+{
+  bufpool_blk_t * p_blk = NULL;
+
+  (void) pthread_mutex_lock (&(g_bufpool.mutex));
+  p_blk = g_bufpool.p_cached;
+  g_bufpool.p_cached = NULL;
+  g_bufpool.info.cached_bufs = 0;
+  g_bufpool.info.cached_bytes = 0;
+  (void) pthread_mutex_unlock (&(g_bufpool.mutex));
+
+  while (p_blk)
+    {
+      bufpool_blk_t * p_next = p_blk->p_next;
+      delete_block (p_blk);
+      p_blk = p_next;
+    }
+}
+
+void
+tiz_bufpool_info (tiz_bufpool_info_t * ap_info)
+{
+  assert (ap_info);
+  (void) pthread_mutex_lock (&(g_bufpool.mutex));
+  *ap_info = g_bufpool.info;
+  (void) pthread_mutex_unlock (&(g_bufpool.mutex));
+}
+
+OMX_U8 *
+tiz_bufpool_alloc_hook (OMX_U32 * ap_size, OMX_PTR * app_port_priv,
+                        void * ap_args)
+{
+  const OMX_U32 flags = ap_args ? *(const OMX_U32 *) ap_args : 0;
+  (void) app_port_priv;
+  assert (ap_size && *ap_size > 0);
+  return tiz_bufpool_alloc ((size_t) *ap_size, 0, flags);
+}
+
+void
+tiz_bufpool_free_hook (OMX_PTR ap_buf, OMX_PTR ap_port_priv, void * ap_args)
+{
+  (void) ap_port_priv;
+  (void) ap_args;
+  assert (ap_buf);
+  tiz_bufpool_free (ap_buf);
+}
@@ -0,0 +1,153 @@
+/**
+ * Copyright (C) 2011-2017 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   tizbufpool.h
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Tizonia Platform - Aligned, pooled OpenMAX IL buffer allocator
+ *
+ *
+ */
+
+#ifndef TIZBUFPOOL_H
+#define TIZBUFPOOL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup tizbufpool OpenMAX IL buffer pool
+ *
+ * A process-wide pool of aligned data buffers. Buffers that are freed are
+ * kept (up to TIZ_BUFPOOL_MAX_CACHED_BYTES) and handed out again to the next
+ * request for the same size and alignment, so that the buffers of a port
+ * survive Idle->Loaded->Idle cycles, and the buffers of a graph can be
+ * picked up by the next graph of the same shape.
+ *
+ * Buffers are always handed out zeroed, whether they are new or reused.
+ *
+ * All functions are thread-safe.
+ *
+ * @ingroup libtizplatform
+ */
+
+#include <stddef.h>
+
+#include <OMX_Types.h>
+
+/** Alignment used when none (or a smaller one) is requested. */
+#define TIZ_BUFPOOL_DEFAULT_ALIGNMENT 64
+
+/** Upper limit of the memory kept in the pool while not in use. */
+#define TIZ_BUFPOOL_MAX_CACHED_BYTES (64 * 1024 * 1024)
+
+/** Buffers at least this large may be backed by huge pages. */
+#define TIZ_BUFPOOL_HUGEPAGE_SIZE (2 * 1024 * 1024)
+
+/** Align the buffer to the page size. */
+#define TIZ_BUFPOOL_PAGE_ALIGNED 0x1
+/** Page-align the buffer and, if it is at least TIZ_BUFPOOL_HUGEPAGE_SIZE
+    bytes, back it with huge pages (MAP_HUGETLB if the system has them
+    reserved, transparent huge pages otherwise). */
+#define TIZ_BUFPOOL_HUGEPAGES 0x2
+
+typedef struct tiz_bufpool_info tiz_bufpool_info_t;
+struct tiz_bufpool_info
+{
+  /* Buffers currently handed out */
+  size_t used_bufs;
+  size_t used_bytes;
+  /* Buffers kept for reuse */
+  size_t cached_bufs;
+  size_t cached_bytes;
+  /* Requests served from the pool, and requests that needed a new buffer */
+  size_t hits;
+  size_t misses;
+};
+
+/**
+ * Allocate a buffer.
+ *
+ * @ingroup tizbufpool
+ * @param a_size The buffer size in bytes.
+ * @param a_alignment The minimum alignment. Rounded up to a power of two,
+ * and to at least TIZ_BUFPOOL_DEFAULT_ALIGNMENT; zero selects the default.
+ * @param a_flags Zero, or a combination of TIZ_BUFPOOL_PAGE_ALIGNED and
+ * TIZ_BUFPOOL_HUGEPAGES.
+ * @return The buffer, or NULL if memory is exhausted.
+ */
+/*@null@*/ /*@only@*/ OMX_PTR
+tiz_bufpool_alloc (size_t a_size, size_t a_alignment, OMX_U32 a_flags);
+
+/**
+ * Return a buffer to the pool.
+ *
+ * @ingroup tizbufpool
+ * @param ap_buf A buffer allocated with tiz_bufpool_alloc (or NULL).
+ */
+void
+tiz_bufpool_free (/*@only@*/ /*@null@*/ OMX_PTR ap_buf);
+
+/**
+ * Release all the buffers currently kept for reuse.
+ *
+ * @ingroup tizbufpool
+ */
+void
+tiz_bufpool_trim (void);
+
+/**
+ * Retrieve the pool's usage figures.
+ *
+ * @ingroup tizbufpool
+ * @param ap_info The structure to fill in.
+ */
+void
+tiz_bufpool_info (tiz_bufpool_info_t * ap_info);
+
+/**
+ * Port buffer allocation hook (see tiz_alloc_hooks_t in libtizonia) backed
+ * by the pool.
+ *
+ * @ingroup tizbufpool
+ * @param ap_size The buffer size requested (it is not modified).
+ * @param app_port_priv Unused.
+ * @param ap_args NULL, or a pointer to an OMX_U32 with the
+ * TIZ_BUFPOOL_* flags to use.
+ * @return The buffer, or NULL if memory is exhausted.
+ */
+/*@null@*/ /*@only@*/ OMX_U8 *
+tiz_bufpool_alloc_hook (OMX_U32 * ap_size, OMX_PTR * app_port_priv,
+                        void * ap_args);
+
+/**
+ * Port buffer free hook, the counterpart of tiz_bufpool_alloc_hook.
+ *
+ * @ingroup tizbufpool
+ */
+void
+tiz_bufpool_free_hook (OMX_PTR ap_buf, OMX_PTR ap_port_priv, void * ap_args);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TIZBUFPOOL_H */
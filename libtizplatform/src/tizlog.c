@@ -30,14 +30,23 @@
 #include <config.h>
 #endif
 
+#define _GNU_SOURCE
+
 #include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
 #include <string.h>
 #include <assert.h>
+#include <pthread.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
 #include <sys/syscall.h>
+#include <linux/futex.h>
 #include <time.h>
+#include <sys/time.h>
 #include <alloca.h>
 
 #include <log4c.h>
@@ -45,8 +54,13 @@
 #include <log4c/appender_type_rollingfile.h>
 #include <log4c/rollingpolicy.h>
 
+#include "tizmacros.h"
 #include "tizlog.h"
 
+/* Starts at 1 so that zero-initialised call sites are refreshed on first
+   use */
+unsigned int tiz_log_generation = 1;
+
 typedef struct user_locinfo user_locinfo_t;
 struct user_locinfo
 {
@@ -54,6 +68,8 @@ struct user_locinfo
   int tid;
   const char * cname;
   char * cbuf;
+  /* Set when the event is logged after the fact, by the async backend */
+  const struct timeval * p_tv;
 };
 
 static const char *
@@ -70,8 +86,13 @@ log_layout_format (const log4c_layout_t * a_layout,
   if (a_event->evt_loc->loc_data)
     {
       struct tm tm;
-      gmtime_r (&a_event->evt_timestamp.tv_sec, &tm);
+      const struct timeval * p_tv = &(a_event->evt_timestamp);
       uloc = (user_locinfo_t *) a_event->evt_loc->loc_data;
+      if (uloc->p_tv)
+        {
+          p_tv = uloc->p_tv;
+        }
+      gmtime_r (&(p_tv->tv_sec), &tm);
 
       if (NULL == uloc->cname)
         {
@@ -79,7 +100,7 @@ log_layout_format (const log4c_layout_t * a_layout,
                     "%02d-%02d-%04d %02d:%02d:%02d.%03ld - "
                     "[PID:%i][TID:%i] [%s] [%s] [%s:%s:%i] --- %s\n",
                     tm.tm_mday, tm.tm_mon + 1, tm.tm_year + 1900, tm.tm_hour,
-                    tm.tm_min, tm.tm_sec, a_event->evt_timestamp.tv_usec / 1000,
+                    tm.tm_min, tm.tm_sec, p_tv->tv_usec / 1000,
                     uloc->pid, uloc->tid,
                     log4c_priority_to_string (a_event->evt_priority),
                     a_event->evt_category, a_event->evt_loc->loc_file,
@@ -94,7 +115,7 @@ log_layout_format (const log4c_layout_t * a_layout,
                     "%02d-%02d-%04d %02d:%02d:%02d.%03ld - "
                     "[PID:%i][TID:%i] [%s] [%s] [%s:%s:%i] --- %s\n",
                     tm.tm_mday, tm.tm_mon + 1, tm.tm_year + 1900, tm.tm_hour,
-                    tm.tm_min, tm.tm_sec, a_event->evt_timestamp.tv_usec / 1000,
+                    tm.tm_min, tm.tm_sec, p_tv->tv_usec / 1000,
                     uloc->pid, uloc->tid,
                     log4c_priority_to_string (a_event->evt_priority),
                     uloc->cname, a_event->evt_loc->loc_file,
@@ -139,12 +160,778 @@ log_formatters_init (void)
   return rc;
 }
 
+#ifndef WITHOUT_LOG4C
+
+/*
+ * Asynchronous backend (enabled with TIZONIA_LOG_ASYNC=1 in the environment)
+ *
+ * The logging thread does not format anything: it copies the format pointer,
+ * the arguments (strings by value) and a timestamp into a fixed-size record
+ * in a ring that only it writes to, and returns. A background thread drains
+ * the rings, formats the records and hands them to log4c, i.e. to whatever
+ * appender is configured, e.g. the rolling file set up by
+ * tiz_log_set_unique_rolling_file. When a ring is full, records are dropped
+ * (and counted) rather than blocking the caller. The only system call on the
+ * logging thread is the wake-up of the background thread when a ring gets
+ * half full; otherwise it polls.
+ */
+
+#define LOG_ASYNC_RING_SLOTS 256 /* Must be a power of two */
+#define LOG_ASYNC_MAX_ARGS 16
+#define LOG_ASYNC_STRINGS_SIZE 384
+#define LOG_ASYNC_CNAME_SIZE 64
+#define LOG_ASYNC_POLL_MS 5
+#define LOG_ASYNC_MSG_SIZE 4096
+
+typedef struct log_spec log_spec_t;
+struct log_spec
+{
+  const char * p_end;    /* One past the conversion character */
+  const char * p_flags;  /* First flag character, if any */
+  size_t flags_len;
+  int width;             /* -1: none, -2: '*' */
+  int precision;         /* -1: none, -2: '*' */
+  char length;           /* 0, 'H' (hh), 'h', 'l', 'q' (ll), 'j', 'z', 't', 'L' */
+  char conv;
+};
+
+typedef struct log_arg log_arg_t;
+struct log_arg
+{
+  union
+  {
+    long long i;
+    double d;
+    const void * p;
+    unsigned int offset; /* Of a string copied into the record */
+  } v;
+};
+
+typedef struct log_record log_record_t;
+struct log_record
+{
+  const log4c_category_t * p_category;
+  const char * p_file;
+  const char * p_func;
+  const char * p_format; /* NULL: 'strings' holds the formatted message */
+  struct timeval tv;
+  int line;
+  int priority;
+  int nargs;
+  char cname[LOG_ASYNC_CNAME_SIZE];
+  log_arg_t args[LOG_ASYNC_MAX_ARGS];
+  char strings[LOG_ASYNC_STRINGS_SIZE];
+};
+
+typedef struct log_ring log_ring_t;
+struct log_ring
+{
+  /* Written by the consumer only */
+  uint32_t head;
+  char pad1[64 - sizeof (uint32_t)];
+  /* Written by the owner thread only */
+  uint32_t tail;
+  uint32_t dropped;
+  char pad2[64 - 2 * sizeof (uint32_t)];
+  int tid;
+  bool orphaned; /* The owner thread has exited */
+  log_ring_t * p_next;
+  log_record_t slots[LOG_ASYNC_RING_SLOTS];
+};
+
+typedef struct log_async log_async_t;
+struct log_async
+{
+  bool enabled;
+  bool stop;
+  uint32_t wakeup; /* futex word */
+  pthread_t thread;
+  pthread_once_t key_once;
+  pthread_key_t ring_key;
+  /* Protects the list of rings */
+  pthread_mutex_t rings_mutex;
+  log_ring_t * p_rings;
+  /* Serialises the consumer's use of log4c with appender reconfiguration */
+  pthread_mutex_t write_mutex;
+};
+
+static log_async_t g_log_async = {
+  .enabled = false,
+  .stop = false,
+  .key_once = PTHREAD_ONCE_INIT,
+  .rings_mutex = PTHREAD_MUTEX_INITIALIZER,
+  .p_rings = NULL,
+  .write_mutex = PTHREAD_MUTEX_INITIALIZER,
+};
+
+static __thread log_ring_t * tls_log_ring = NULL;
+/* Marks a thread whose ring has been handed over to the consumer (see
+   log_ring_orphan). Its records go through the synchronous path. */
+static log_ring_t g_log_ring_exited;
+
+/* Parses the conversion specification that starts at ap_fmt (a '%'). Returns
+   false for the conversions that can't be captured ('%n', wide strings,
+   positional arguments, unknown conversions). */
+static bool
+log_parse_spec (const char * ap_fmt, log_spec_t * ap_spec)
+{
+  const char * p = ap_fmt + 1;
+
+  ap_spec->p_flags = p;
+  while (*p && strchr ("-+ #0'", *p))
+    {
+      ++p;
+    }
+  ap_spec->flags_len = (size_t) (p - ap_spec->p_flags);
+
+  ap_spec->width = -1;
+  if ('*' == *p)
+    {
+      ap_spec->width = -2;
+      ++p;
+    }
+  else if (*p >= '0' && *p <= '9')
+    {
+      ap_spec->width = (int) strtol (p, (char **) &p, 10);
+      if ('$' == *p)
+        {
+          return false;
+        }
+    }
+
+  ap_spec->precision = -1;
+  if ('.' == *p)
+    {
+      ++p;
+      if ('*' == *p)
+        {
+          ap_spec->precision = -2;
+          ++p;
+        }
+      else
+        {
+          ap_spec->precision = (int) strtol (p, (char **) &p, 10);
+        }
+    }
+
+  ap_spec->length = 0;
+  switch (*p)
+    {
+      case 'h':
+        ap_spec->length = ('h' == p[1]) ? 'H' : 'h';
+        p += ('h' == p[1]) ? 2 : 1;
+        break;
+      case 'l':
+        ap_spec->length = ('l' == p[1]) ? 'q' : 'l';
+        p += ('l' == p[1]) ? 2 : 1;
+        break;
+      case 'q':
+      case 'j':
+      case 'z':
+      case 't':
+      case 'L':
+        ap_spec->length = *p++;
+        break;
+      default:
+        break;
+    };
+
+  ap_spec->conv = *p;
+  ap_spec->p_end = p + 1;
+  switch (ap_spec->conv)
+    {
+      case 'd':
+      case 'i':
+      case 'u':
+      case 'o':
+      case 'x':
+      case 'X':
+      case 'c':
+      case 'e':
+      case 'E':
+      case 'f':
+      case 'F':
+      case 'g':
+      case 'G':
+      case 'a':
+      case 'A':
+      case 'p':
+      case '%':
+        return true;
+      case 's':
+        return ('l' != ap_spec->length);
+      default:
+        return false;
+    };
+}
+
+static bool
+log_capture_int (log_record_t * ap_rec, int a_value)
+{
+  if (ap_rec->nargs >= LOG_ASYNC_MAX_ARGS)
+    {
+      return false;
+    }
+  ap_rec->args[ap_rec->nargs++].v.i = a_value;
+  return true;
+}
+
+/* Copies the arguments described by the record's format into the record */
+static bool
+log_capture_args (log_record_t * ap_rec, va_list a_va)
+{
+  const char * p = ap_rec->p_format;
+  unsigned int strings_len = 0;
+  log_spec_t spec;
+
+  while ((p = strchr (p, '%')))
+    {
+      int precision = -1;
+      log_arg_t * p_arg = NULL;
+
+      if (!log_parse_spec (p, &spec))
+        {
+          return false;
+        }
+      p = spec.p_end;
+      if ('%' == spec.conv)
+        {
+          continue;
+        }
+      if (-2 == spec.width && !log_capture_int (ap_rec, va_arg (a_va, int)))
+        {
+          return false;
+        }
+      if (-2 == spec.precision)
+        {
+          precision = va_arg (a_va, int);
+          if (!log_capture_int (ap_rec, precision))
+            {
+              return false;
+            }
+        }
+      else
+        {
+          precision = spec.precision;
+        }
+
+      if (ap_rec->nargs >= LOG_ASYNC_MAX_ARGS)
+        {
+          return false;
+        }
+      p_arg = &(ap_rec->args[ap_rec->nargs++]);
+
+      switch (spec.conv)
+        {
+          case 'd':
+          case 'i':
+            switch (spec.length)
+              {
+                case 'H':
+                  p_arg->v.i = (signed char) va_arg (a_va, int);
+                  break;
+                case 'h':
+                  p_arg->v.i = (short) va_arg (a_va, int);
+                  break;
+                case 'l':
+                  p_arg->v.i = va_arg (a_va, long);
+                  break;
+                case 'q':
+                  p_arg->v.i = va_arg (a_va, long long);
+                  break;
+                case 'j':
+                  p_arg->v.i = va_arg (a_va, intmax_t);
+                  break;
+                case 'z':
+                  p_arg->v.i = va_arg (a_va, ssize_t);
+                  break;
+                case 't':
+                  p_arg->v.i = va_arg (a_va, ptrdiff_t);
+                  break;
+                default:
+                  p_arg->v.i = va_arg (a_va, int);
+                  break;
+              };
+            break;
+          case 'u':
+          case 'o':
+          case 'x':
+          case 'X':
+            switch (spec.length)
+              {
+                case 'H':
+                  p_arg->v.i = (unsigned char) va_arg (a_va, unsigned int);
+                  break;
+                case 'h':
+                  p_arg->v.i = (unsigned short) va_arg (a_va, unsigned int);
+                  break;
+                case 'l':
+                  p_arg->v.i = (long long) va_arg (a_va, unsigned long);
+                  break;
+                case 'q':
+                  p_arg->v.i = (long long) va_arg (a_va, unsigned long long);
+                  break;
+                case 'j':
+                  p_arg->v.i = (long long) va_arg (a_va, uintmax_t);
+                  break;
+                case 'z':
+                  p_arg->v.i = (long long) va_arg (a_va, size_t);
+                  break;
+                case 't':
+                  p_arg->v.i = (long long) va_arg (a_va, ptrdiff_t);
+                  break;
+                default:
+                  p_arg->v.i = va_arg (a_va, unsigned int);
+                  break;
+              };
+            break;
+          case 'c':
+            p_arg->v.i = va_arg (a_va, int);
+            break;
+          case 'p':
+            p_arg->v.p = va_arg (a_va, void *);
+            break;
+          case 's':
+            {
+              const char * p_str = va_arg (a_va, const char *);
+              size_t len = 0;
+              if (!p_str)
+                {
+                  p_str = "(null)";
+                }
+              len = (precision >= 0) ? strnlen (p_str, (size_t) precision)
+                                     : strlen (p_str);
+              /* Long strings are truncated; strings_len never goes past the
+                 last byte, so there is always room for the terminator */
+              len = MIN (len, LOG_ASYNC_STRINGS_SIZE - 1 - strings_len);
+              memcpy (ap_rec->strings + strings_len, p_str, len);
+              ap_rec->strings[strings_len + len] = '\0';
+              p_arg->v.offset = strings_len;
+              strings_len
+                = MIN (strings_len + len + 1, LOG_ASYNC_STRINGS_SIZE - 1);
+            }
+            break;
+          default:
+            /* Floating point conversions */
+            if ('L' == spec.length)
+              {
+                p_arg->v.d = (double) va_arg (a_va, long double);
+              }
+            else
+              {
+                p_arg->v.d = va_arg (a_va, double);
+              }
+            break;
+        };
+    }
+  return true;
+}
+
+/* Formats a captured record. Each conversion is rebuilt with its arguments
+   resolved, e.g. "%-*lu" with width 8 becomes "%-8llu". */
+static void
+log_format_record (const log_record_t * ap_rec, char * ap_buf, size_t a_size)
+{
+  const char * p = ap_rec->p_format;
+  size_t used = 0;
+  int arg = 0;
+  log_spec_t spec;
+
+  if (!p)
+    {
+      (void) snprintf (ap_buf, a_size, "%s", ap_rec->strings);
+      return;
+    }
+
+  while (*p && used + 1 < a_size)
+    {
+      const char * p_pct = strchr (p, '%');
+      size_t lit = p_pct ? (size_t) (p_pct - p) : strlen (p);
+      char fmt[64];
+      int n = 0;
+
+      lit = MIN (lit, a_size - used - 1);
+      memcpy (ap_buf + used, p, lit);
+      used += lit;
+      if (!p_pct || used + 1 >= a_size)
+        {
+          break;
+        }
+
+      /* The format has already been validated by log_capture_args */
+      (void) log_parse_spec (p_pct, &spec);
+      p = spec.p_end;
+      if ('%' == spec.conv)
+        {
+          ap_buf[used++] = '%';
+          continue;
+        }
+      n = snprintf (fmt, sizeof (fmt), "%%%.*s", (int) spec.flags_len,
+                    spec.p_flags);
+      if (-2 == spec.width)
+        {
+          /* A negative width prints as the '-' flag, as printf wants it */
+          n += snprintf (fmt + n, sizeof (fmt) - n, "%d",
+                         (int) ap_rec->args[arg++].v.i);
+        }
+      else if (spec.width >= 0)
+        {
+          n += snprintf (fmt + n, sizeof (fmt) - n, "%d", spec.width);
+        }
+      if (-2 == spec.precision)
+        {
+          const int precision = (int) ap_rec->args[arg++].v.i;
+          if (precision >= 0)
+            {
+              n += snprintf (fmt + n, sizeof (fmt) - n, ".%d", precision);
+            }
+        }
+      else if (spec.precision >= 0)
+        {
+          n += snprintf (fmt + n, sizeof (fmt) - n, ".%d", spec.precision);
+        }
+
+      switch (spec.conv)
+        {
+          case 'd':
+          case 'i':
+          case 'u':
+          case 'o':
+          case 'x':
+          case 'X':
+            (void) snprintf (fmt + n, sizeof (fmt) - n, "ll%c", spec.conv);
+            n = snprintf (ap_buf + used, a_size - used, fmt,
+                          ap_rec->args[arg].v.i);
+            break;
+          case 'c':
+            (void) snprintf (fmt + n, sizeof (fmt) - n, "c");
+            n = snprintf (ap_buf + used, a_size - used, fmt,
+                          (int) ap_rec->args[arg].v.i);
+            break;
+          case 'p':
+            (void) snprintf (fmt + n, sizeof (fmt) - n, "p");
+            n = snprintf (ap_buf + used, a_size - used, fmt,
+                          ap_rec->args[arg].v.p);
+            break;
+          case 's':
+            (void) snprintf (fmt + n, sizeof (fmt) - n, "s");
+            n = snprintf (ap_buf + used, a_size - used, fmt,
+                          ap_rec->strings + ap_rec->args[arg].v.offset);
+            break;
+          default:
+            (void) snprintf (fmt + n, sizeof (fmt) - n, "%c", spec.conv);
+            n = snprintf (ap_buf + used, a_size - used, fmt,
+                          ap_rec->args[arg].v.d);
+            break;
+        };
+      ++arg;
+      used += (n > 0) ? MIN ((size_t) n, a_size - used - 1) : 0;
+    }
+  ap_buf[used] = '\0';
+}
+
+static void
+log_ring_orphan (void * ap_ring)
+{
+  /* Once orphaned, the ring may be freed by the consumer at any time. Other
+     key destructors of this thread may still log; they must not touch the
+     ring, nor allocate a new one. */
+  tls_log_ring = &g_log_ring_exited;
+  __atomic_store_n (&(((log_ring_t *) ap_ring)->orphaned), true,
+                    __ATOMIC_RELEASE);
+}
+
+static void
+log_create_ring_key (void)
+{
+  (void) pthread_key_create (&(g_log_async.ring_key), log_ring_orphan);
+}
+
+static void
+log_async_wakeup (void)
+{
+  (void) __atomic_add_fetch (&(g_log_async.wakeup), 1, __ATOMIC_RELEASE);
+  (void) syscall (SYS_futex, &(g_log_async.wakeup), FUTEX_WAKE_PRIVATE, 1,
+                  NULL, NULL, 0);
+}
+
+static void
+log_async_wait (uint32_t a_wakeup)
+{
+  const struct timespec ts
+    = {.tv_sec = 0, .tv_nsec = LOG_ASYNC_POLL_MS * 1000000L };
+  (void) syscall (SYS_futex, &(g_log_async.wakeup), FUTEX_WAIT_PRIVATE,
+                  a_wakeup, &ts, NULL, 0);
+}
+
+static log_ring_t *
+log_get_ring (void)
+{
+  log_ring_t * p_ring = tls_log_ring;
+  if (&g_log_ring_exited == p_ring)
+    {
+      return NULL;
+    }
+  if (!p_ring)
+    {
+      /* First record logged by this thread */
+      if (!(p_ring = calloc (1, sizeof (log_ring_t))))
+        {
+          return NULL;
+        }
+      p_ring->tid = syscall (SYS_gettid);
+      (void) pthread_setspecific (g_log_async.ring_key, p_ring);
+      (void) pthread_mutex_lock (&(g_log_async.rings_mutex));
+      p_ring->p_next = g_log_async.p_rings;
+      g_log_async.p_rings = p_ring;
+      (void) pthread_mutex_unlock (&(g_log_async.rings_mutex));
+      tls_log_ring = p_ring;
+    }
+  return p_ring;
+}
+
+static bool
+log_async_push (const log4c_category_t * ap_category, const char * ap_file,
+                int a_line, const char * ap_func, int a_priority,
+                const char * ap_cname, const char * ap_format, va_list a_va)
+{
+  log_ring_t * p_ring = NULL;
+  log_record_t * p_rec = NULL;
+  uint32_t tail = 0;
+  uint32_t used = 0;
+  va_list va;
+
+  if (!__atomic_load_n (&(g_log_async.enabled), __ATOMIC_ACQUIRE)
+      || !(p_ring = log_get_ring ()))
+    {
+      return false;
+    }
+
+  tail = p_ring->tail;
+  used = tail - __atomic_load_n (&(p_ring->head), __ATOMIC_ACQUIRE);
+  if (used >= LOG_ASYNC_RING_SLOTS)
+    {
+      __atomic_add_fetch (&(p_ring->dropped), 1, __ATOMIC_RELAXED);
+      return true;
+    }
+
+  p_rec = &(p_ring->slots[tail & (LOG_ASYNC_RING_SLOTS - 1)]);
+  p_rec->p_category = ap_category;
+  p_rec->p_file = ap_file;
+  p_rec->p_func = ap_func;
+  p_rec->p_format = ap_format;
+  p_rec->line = a_line;
+  p_rec->priority = a_priority;
+  p_rec->nargs = 0;
+  (void) gettimeofday (&(p_rec->tv), NULL);
+  p_rec->cname[0] = '\0';
+  if (ap_cname)
+    {
+      /* The component may be gone by the time the record is written out */
+      (void) snprintf (p_rec->cname, sizeof (p_rec->cname), "%s", ap_cname);
+    }
+
+  va_copy (va, a_va);
+  if (!log_capture_args (p_rec, va))
+    {
+      /* Not capturable; format it here instead */
+      p_rec->p_format = NULL;
+      (void) vsnprintf (p_rec->strings, sizeof (p_rec->strings), ap_format,
+                        a_va);
+    }
+  va_end (va);
+
+  __atomic_store_n (&(p_ring->tail), tail + 1, __ATOMIC_RELEASE);
+  if (LOG_ASYNC_RING_SLOTS / 2 == used + 1)
+    {
+      log_async_wakeup ();
+    }
+  return true;
+}
+
+static void
+log_async_write (const log_ring_t * ap_ring, const log_record_t * ap_rec,
+                 int a_pid, char * ap_msg, char * ap_cbuf)
+{
+  log4c_location_info_t locinfo;
+  user_locinfo_t user_locinfo;
+
+  log_format_record (ap_rec, ap_msg, LOG_ASYNC_MSG_SIZE);
+
+  user_locinfo.pid = a_pid;
+  user_locinfo.tid = ap_ring->tid;
+  user_locinfo.cname = ap_rec->cname[0] ? ap_rec->cname : NULL;
+  user_locinfo.cbuf = ap_cbuf;
+  user_locinfo.p_tv = &(ap_rec->tv);
+  locinfo.loc_file = ap_rec->p_file;
+  locinfo.loc_line = ap_rec->line;
+  locinfo.loc_function = ap_rec->p_func;
+  locinfo.loc_data = &user_locinfo;
+
+  log4c_category_log_locinfo (ap_rec->p_category, &locinfo, ap_rec->priority,
+                              "%s", ap_msg);
+}
+
+/* Writes out everything that is in the rings. Returns the number of records
+   written. */
+static unsigned int
+log_async_drain (int a_pid, char * ap_msg, char * ap_cbuf)
+{
+  log_ring_t ** pp_ring = NULL;
+  unsigned int count = 0;
+
+  (void) pthread_mutex_lock (&(g_log_async.rings_mutex));
+  pp_ring = &(g_log_async.p_rings);
+  while (*pp_ring)
+    {
+      log_ring_t * p_ring = *pp_ring;
+      const bool orphaned
+        = __atomic_load_n (&(p_ring->orphaned), __ATOMIC_ACQUIRE);
+      const uint32_t tail = __atomic_load_n (&(p_ring->tail), __ATOMIC_ACQUIRE);
+      const uint32_t dropped
+        = __atomic_exchange_n (&(p_ring->dropped), 0, __ATOMIC_RELAXED);
+      uint32_t head = p_ring->head;
+
+      (void) pthread_mutex_lock (&(g_log_async.write_mutex));
+      if (dropped > 0)
+        {
+          log4c_category_log (log4c_category_get ("root"),
+                              LOG4C_PRIORITY_WARN,
+                              "[TID:%i] : %u log records dropped",
+                              p_ring->tid, (unsigned int) dropped);
+        }
+      for (; head != tail; ++head, ++count)
+        {
+          log_async_write (p_ring,
+                           &(p_ring->slots[head & (LOG_ASYNC_RING_SLOTS - 1)]),
+                           a_pid, ap_msg, ap_cbuf);
+          __atomic_store_n (&(p_ring->head), head + 1, __ATOMIC_RELEASE);
+        }
+      (void) pthread_mutex_unlock (&(g_log_async.write_mutex));
+
+      if (orphaned)
+        {
+          /* The ring was empty after its owner had exited */
+          *pp_ring = p_ring->p_next;
+          free (p_ring);
+        }
+      else
+        {
+          pp_ring = &(p_ring->p_next);
+        }
+    }
+  (void) pthread_mutex_unlock (&(g_log_async.rings_mutex));
+
+  return count;
+}
+
+static void *
+log_async_thread_func (void * ap_arg)
+{
+  const int pid = getpid ();
+  char * p_msg = malloc (LOG_ASYNC_MSG_SIZE);
+  char * p_cbuf = malloc (LOG_ASYNC_MSG_SIZE);
+  (void) ap_arg;
+
+  (void) pthread_setname_np (pthread_self (), "tizlogasync");
+
+  while (p_msg && p_cbuf)
+    {
+      const uint32_t wakeup
+        = __atomic_load_n (&(g_log_async.wakeup), __ATOMIC_ACQUIRE);
+      const bool stop = __atomic_load_n (&(g_log_async.stop), __ATOMIC_ACQUIRE);
+      if (0 == log_async_drain (pid, p_msg, p_cbuf))
+        {
+          if (stop)
+            {
+              break;
+            }
+          log_async_wait (wakeup);
+        }
+    }
+
+  free (p_msg);
+  free (p_cbuf);
+  return NULL;
+}
+
+static void
+log_async_start (void)
+{
+  const char * p_env = getenv ("TIZONIA_LOG_ASYNC");
+  if (!p_env || 0 == strcmp (p_env, "0")
+      || __atomic_load_n (&(g_log_async.enabled), __ATOMIC_ACQUIRE))
+    {
+      return;
+    }
+
+  g_log_async.stop = false;
+  (void) pthread_once (&(g_log_async.key_once), log_create_ring_key);
+  if (0 != pthread_create (&(g_log_async.thread), NULL, log_async_thread_func,
+                           NULL))
+    {
+      return;
+    }
+  __atomic_store_n (&(g_log_async.enabled), true, __ATOMIC_RELEASE);
+}
+
+static void
+log_async_stop (void)
+{
+  log_ring_t ** pp_ring = NULL;
+
+  if (!__atomic_load_n (&(g_log_async.enabled), __ATOMIC_ACQUIRE))
+    {
+      return;
+    }
+
+  /* New records go through the synchronous path from now on; the ones
+     already queued are written out before the thread exits */
+  __atomic_store_n (&(g_log_async.enabled), false, __ATOMIC_RELEASE);
+  __atomic_store_n (&(g_log_async.stop), true, __ATOMIC_RELEASE);
+  log_async_wakeup ();
+  (void) pthread_join (g_log_async.thread, NULL);
+
+  /* Rings of threads that have exited are freed. Rings of threads that are
+     still alive are kept; they will be reused if the backend is started
+     again */
+  (void) pthread_mutex_lock (&(g_log_async.rings_mutex));
+  pp_ring = &(g_log_async.p_rings);
+  while (*pp_ring)
+    {
+      log_ring_t * p_ring = *pp_ring;
+      if (__atomic_load_n (&(p_ring->orphaned), __ATOMIC_ACQUIRE))
+        {
+          *pp_ring = p_ring->p_next;
+          free (p_ring);
+        }
+      else
+        {
+          p_ring->head = p_ring->tail;
+          pp_ring = &(p_ring->p_next);
+        }
+    }
+  (void) pthread_mutex_unlock (&(g_log_async.rings_mutex));
+}
+
+#endif /* !WITHOUT_LOG4C */
+
+static void
+invalidate_log_sites (void)
+{
+  (void) __atomic_add_fetch (&tiz_log_generation, 1, __ATOMIC_RELEASE);
+}
+
 int
 tiz_log_init (void)
 {
 #ifndef WITHOUT_LOG4C
+  int rc = 0;
   log_formatters_init ();
-  return log4c_init ();
+  rc = log4c_init ();
+  invalidate_log_sites ();
+  log_async_start ();
+  return rc;
 #else
   return 0;
 #endif
@@ -162,6 +949,9 @@ tiz_log_set_unique_rolling_file (const char * ap_logdir,
       return;
     }
 
+#ifndef WITHOUT_LOG4C
+  (void) pthread_mutex_lock (&(g_log_async.write_mutex));
+#endif
   {
     log4c_appender_t * app = log4c_appender_get ("tizlogfile");
 
@@ -191,12 +981,17 @@ tiz_log_set_unique_rolling_file (const char * ap_logdir,
           }
       }
   }
+#ifndef WITHOUT_LOG4C
+  (void) pthread_mutex_unlock (&(g_log_async.write_mutex));
+#endif
 }
 
 int
 tiz_log_deinit (void)
 {
 #ifndef WITHOUT_LOG4C
+  log_async_stop ();
+  invalidate_log_sites ();
   return log4c_fini ();
 #else
   return 0;
@@ -204,45 +999,125 @@ tiz_log_deinit (void)
 }
 
 void
-tiz_log (const char * ap_file, int a_line, const char * ap_func,
-         const char * ap_cat_name, int a_priority, const char * ap_cname,
-         char * ap_cbuf, const char * ap_format, ...)
+tiz_log_reload (void)
+{
+#ifndef WITHOUT_LOG4C
+  (void) log4c_reread ();
+  invalidate_log_sites ();
+#endif
+}
+
+int
+tiz_log_site_refresh (tiz_log_site_t * ap_site, const char * ap_cat_name)
+{
+#ifndef WITHOUT_LOG4C
+  /* Read the generation first: if the configuration changes while we are
+     here, the next call will refresh again */
+  const unsigned int generation
+    = __atomic_load_n (&tiz_log_generation, __ATOMIC_ACQUIRE);
+  const log4c_category_t * p_category = log4c_category_get (ap_cat_name);
+  const int priority = log4c_category_get_chainedpriority (p_category);
+
+  assert (ap_site);
+
+  __atomic_store_n (&(ap_site->p_category), (const void *) p_category,
+                    __ATOMIC_RELAXED);
+  __atomic_store_n (&(ap_site->priority), priority, __ATOMIC_RELAXED);
+  __atomic_store_n (&(ap_site->generation), generation, __ATOMIC_RELEASE);
+  return priority;
+#else
+  (void) ap_site;
+  (void) ap_cat_name;
+  return TIZ_PRIORITY_TRACE;
+#endif
+}
+
+static void
+log_va (const log4c_category_t * ap_category, const char * ap_file,
+        int a_line, const char * ap_func, int a_priority,
+        const char * ap_cname, char * ap_cbuf, const char * ap_format,
+        va_list a_va)
 {
 #ifndef WITHOUT_LOG4C
   log4c_location_info_t locinfo;
   user_locinfo_t user_locinfo;
+  char * buffer = NULL;
 
-  const log4c_category_t * p_category = log4c_category_get (ap_cat_name);
-  if (log4c_category_is_priority_enabled (p_category, a_priority))
+  if (log_async_push (ap_category, ap_file, a_line, ap_func, a_priority,
+                      ap_cname, ap_format, a_va))
     {
-      /* TODO: 4096 - this value should be obtained at config time */
-      char * buffer = alloca (4096);
-      user_locinfo.pid = getpid ();
-      user_locinfo.tid = syscall (SYS_gettid);
-      user_locinfo.cname = ap_cname;
-      user_locinfo.cbuf = ap_cbuf;
-      locinfo.loc_file = ap_file;
-      locinfo.loc_line = a_line;
-      locinfo.loc_function = ap_func;
-      /*          locinfo.loc_data = NULL; */
-      locinfo.loc_data = &user_locinfo;
+      return;
+    }
+
+  /* TODO: 4096 - this value should be obtained at config time */
+  buffer = alloca (4096);
+  user_locinfo.pid = getpid ();
+  user_locinfo.tid = syscall (SYS_gettid);
+  user_locinfo.cname = ap_cname;
+  user_locinfo.cbuf = ap_cbuf;
+  user_locinfo.p_tv = NULL;
+  locinfo.loc_file = ap_file;
+  locinfo.loc_line = a_line;
+  locinfo.loc_function = ap_func;
+  /*          locinfo.loc_data = NULL; */
+  locinfo.loc_data = &user_locinfo;
+
+  vsprintf (buffer, ap_format, a_va);
+  log4c_category_log_locinfo (ap_category, &locinfo, a_priority, "%s", buffer);
+#else
+  (void) ap_category;
+  vprintf (ap_format, a_va);
+  printf ("\n");
+#endif
+}
 
+void
+tiz_log (const char * ap_file, int a_line, const char * ap_func,
+         const char * ap_cat_name, int a_priority, const char * ap_cname,
+         char * ap_cbuf, const char * ap_format, ...)
+{
+  const log4c_category_t * p_category = NULL;
+#ifndef WITHOUT_LOG4C
+  p_category = log4c_category_get (ap_cat_name);
+  if (log4c_category_is_priority_enabled (p_category, a_priority))
+#endif
+    {
       va_list va;
       va_start (va, ap_format);
-      vsprintf (buffer, ap_format, va);
+      log_va (p_category, ap_file, a_line, ap_func, a_priority, ap_cname,
+              ap_cbuf, ap_format, va);
       va_end (va);
-      log4c_category_log_locinfo (p_category, &locinfo, a_priority, "%s",
-                                  buffer);
     }
-#else
+}
 
+void
+tiz_log_site (tiz_log_site_t * ap_site, const char * ap_file, int a_line,
+              const char * ap_func, const char * ap_cat_name, int a_priority,
+              const char * ap_cname, char * ap_cbuf, const char * ap_format,
+              ...)
+{
+  const log4c_category_t * p_category = NULL;
   va_list va;
-  va_start (va, ap_format);
-  vprintf (ap_format, va);
-  va_end (va);
-  printf ("\n");
 
+  assert (ap_site);
+
+  /* The caller has already checked the priority against this site's cached
+     category */
+  p_category = (const log4c_category_t *) __atomic_load_n (
+    &(ap_site->p_category), __ATOMIC_RELAXED);
+#ifndef WITHOUT_LOG4C
+  if (!p_category)
+    {
+      p_category = log4c_category_get (ap_cat_name);
+    }
+#else
+  (void) ap_cat_name;
 #endif
+
+  va_start (va, ap_format);
+  log_va (p_category, ap_file, a_line, ap_func, a_priority, ap_cname, ap_cbuf,
+          ap_format, va);
+  va_end (va);
 }
 
 /*  TODO: Allow override the logging configuration via command line */
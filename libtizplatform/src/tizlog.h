@@ -41,10 +41,6 @@ extern "C" {
 
 /* #define WITHOUT_LOG4C 1 */
 
-#define TIZ_LOG(priority, format, args...)                                    \
-  tiz_log (__FILE__, __LINE__, __FUNCTION__, TIZ_LOG_CATEGORY_NAME, priority, \
-           NULL, NULL, format, ##args);
-
 #ifndef WITHOUT_LOG4C
 #define TIZ_PRIORITY_ERROR LOG4C_PRIORITY_ERROR
 #define TIZ_PRIORITY_WARN LOG4C_PRIORITY_WARN
@@ -59,6 +55,63 @@ extern "C" {
 #define TIZ_PRIORITY_TRACE 5
 #endif
 
+/* Build with -DTIZ_LOG_DISABLE_TRACE (configure --disable-trace-log) to
+   compile TRACE logging out entirely */
+#ifdef TIZ_LOG_DISABLE_TRACE
+#define TIZ_LOG_COMPILED_OUT(priority) ((priority) >= TIZ_PRIORITY_TRACE)
+#else
+#define TIZ_LOG_COMPILED_OUT(priority) 0
+#endif
+
+/* Per call site cache of the category lookup. The cached category and its
+   priority are valid while 'generation' matches tiz_log_generation, which
+   changes every time the logging configuration is (re)loaded. Changes to
+   log4crc reach the call sites through tiz_log_reload, not through log4c's
+   own 'reread' option. */
+typedef struct tiz_log_site tiz_log_site_t;
+struct tiz_log_site
+{
+  unsigned int generation;
+  int priority;
+  const void * p_category;
+};
+
+extern unsigned int tiz_log_generation;
+
+int
+tiz_log_site_refresh (tiz_log_site_t * ap_site, const char * ap_cat_name);
+
+static inline int
+tiz_log_site_priority (tiz_log_site_t * ap_site, const char * ap_cat_name)
+{
+  if (__atomic_load_n (&(ap_site->generation), __ATOMIC_ACQUIRE)
+      == __atomic_load_n (&tiz_log_generation, __ATOMIC_RELAXED))
+    {
+      return __atomic_load_n (&(ap_site->priority), __ATOMIC_RELAXED);
+    }
+  return tiz_log_site_refresh (ap_site, ap_cat_name);
+}
+
+/* Neither the arguments are evaluated nor tiz_log_site called unless the
+   priority is enabled for the category */
+#define TIZ_LOG_SITE(cat_name, priority, cname, cbuf, format, args...)     \
+  do                                                                       \
+    {                                                                      \
+      static tiz_log_site_t tiz_log_site_cache;                            \
+      if (!TIZ_LOG_COMPILED_OUT (priority)                                 \
+          && tiz_log_site_priority (&tiz_log_site_cache, (cat_name))       \
+               >= (priority))                                              \
+        {                                                                  \
+          tiz_log_site (&tiz_log_site_cache, __FILE__, __LINE__,           \
+                        __FUNCTION__, (cat_name), (priority), (cname),     \
+                        (cbuf), format, ##args);                           \
+        }                                                                  \
+    }                                                                      \
+  while (0)
+
+#define TIZ_LOG(priority, format, args...)                                  \
+  TIZ_LOG_SITE (TIZ_LOG_CATEGORY_NAME, priority, NULL, NULL, format, ##args);
+
 int
 tiz_log_init (void);
 void
@@ -67,11 +120,19 @@ tiz_log_set_unique_rolling_file (const char * ap_logdir,
 int
 tiz_log_deinit (void);
 void
+tiz_log_reload (void);
+void
 tiz_log (const char * __p_file, int __line, const char * __p_func,
          const char * __p_cat_name, int __priority,
          /*@null@ */ const char * __p_cname,
          /*@null@ */ char * __p_cbuf,
          /*@null@ */ const char * __p_format, ...);
+void
+tiz_log_site (tiz_log_site_t * ap_site, const char * __p_file, int __line,
+              const char * __p_func, const char * __p_cat_name,
+              int __priority, /*@null@ */ const char * __p_cname,
+              /*@null@ */ char * __p_cbuf,
+              /*@null@ */ const char * __p_format, ...);
 
 #ifdef __cplusplus
 }
@@ -631,6 +631,8 @@ static const tiz_idx_str_t tiz_idx_to_str_tbl[] = {
    (const OMX_STRING) "OMX_TizoniaIndexParamAudioYoutubeSession"},
   {OMX_TizoniaIndexParamAudioYoutubePlaylist,
    (const OMX_STRING) "OMX_TizoniaIndexParamAudioYoutubePlaylist"},
+  {OMX_TizoniaIndexConfigStreamPosition,
+   (const OMX_STRING) "OMX_TizoniaIndexConfigStreamPosition"},
   {OMX_IndexKhronosExtensions, (const OMX_STRING) "OMX_IndexKhronosExtensions"},
   {OMX_IndexVendorStartUnused, (const OMX_STRING) "OMX_IndexVendorStartUnused"},
   {OMX_IndexMax, (const OMX_STRING) "OMX_IndexMax"}};
@@ -0,0 +1,1930 @@
+/**
+ * Copyright (C) 2011-2017 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   tizpcm.c
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  PCM sample processing utilities
+ *
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <byteswap.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define TIZ_PCM_X86
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#define TIZ_PCM_NEON
+#include <arm_neon.h>
+#endif
+
+#include "tizplatform.h"
+
+#ifdef TIZ_LOG_CATEGORY_NAME
+#undef TIZ_LOG_CATEGORY_NAME
+#define TIZ_LOG_CATEGORY_NAME "tiz.platform.pcm"
+#endif
+
+/* The gain and ramp front-ends expand the gain (and the dithered
+   requantization its noise) into a per-sample array of this many elements,
+   which the format kernels then consume. */
+#define TIZ_PCM_BLOCK_SAMPLES 1024
+
+#define TIZ_PCM_S16_MIN -32768.f
+#define TIZ_PCM_S16_MAX 32767.f
+#define TIZ_PCM_S24_MIN -8388608.f
+#define TIZ_PCM_S24_MAX 8388607.f
+#define TIZ_PCM_S32_MIN -2147483648.0
+#define TIZ_PCM_S32_MAX 2147483647.0
+
+/* Full scale (i.e. the value of 1.0) of each integer format */
+#define TIZ_PCM_S16_SCALE 32768.f
+#define TIZ_PCM_S24_SCALE 8388608.f
+#define TIZ_PCM_S32_SCALE 2147483648.0
+
+/* Range of the fractional bits accepted by tiz_pcm_fixed_to_s16: at least
+   one bit must be shifted out, and the clipped sample plus the rounding
+   offset and the dither must still fit in 32 bits */
+#define TIZ_PCM_FIXED_MIN_FRAC_BITS 16
+#define TIZ_PCM_FIXED_MAX_FRAC_BITS 30
+
+typedef void (*tiz_pcm_mul_f) (void * ap_data, const float * ap_gains,
+                               size_t a_nsamples);
+typedef void (*tiz_pcm_swap_f) (void * ap_data, size_t a_nsamples);
+typedef void (*tiz_pcm_from_flt_f) (void * ap_dst, const float * ap_src,
+                                    size_t a_nsamples);
+typedef void (*tiz_pcm_to_flt_f) (float * ap_dst, const void * ap_src,
+                                  size_t a_nsamples);
+typedef void (*tiz_pcm_fixed_f) (int16_t * ap_dst, const int32_t * ap_src,
+                                 const int32_t * ap_noise, size_t a_nsamples,
+                                 unsigned a_frac_bits);
+typedef void (*tiz_pcm_ilv2_f) (void * ap_dst, const void * ap_left,
+                                const void * ap_right, size_t a_nframes);
+typedef void (*tiz_pcm_dilv2_f) (void * ap_left, void * ap_right,
+                                 const void * ap_src, size_t a_nframes);
+
+typedef struct tiz_pcm_ops tiz_pcm_ops_t;
+struct tiz_pcm_ops
+{
+  tiz_pcm_isa_t isa;
+  tiz_pcm_mul_f pf_mul[ETIZPcmFmtMax]; /* indexed by tiz_pcm_fmt_t */
+  tiz_pcm_swap_f pf_swap16;
+  tiz_pcm_swap_f pf_swap32;
+  tiz_pcm_from_flt_f pf_from_flt[ETIZPcmFmtMax]; /* indexed by tiz_pcm_fmt_t */
+  tiz_pcm_to_flt_f pf_to_flt[ETIZPcmFmtMax];     /* indexed by tiz_pcm_fmt_t */
+  tiz_pcm_fixed_f pf_fixed_s16;
+  /* Only stereo 16 and 32-bit frames have specialised (de)interleavers */
+  tiz_pcm_ilv2_f pf_ilv2_16;
+  tiz_pcm_ilv2_f pf_ilv2_32;
+  tiz_pcm_dilv2_f pf_dilv2_16;
+  tiz_pcm_dilv2_f pf_dilv2_32;
+};
+
+/*
+ * Scalar implementation. The SIMD variants process the tail of each block
+ * with these, so their results must match lane by lane: the clamps are
+ * written so that they select the same operand as minps/maxps do (including
+ * for NaNs), and the conversions round to nearest, ties to even.
+ */
+
+static inline float
+clamp_flt (float a_val, const float a_lo, const float a_hi)
+{
+  a_val = a_val > a_lo ? a_val : a_lo;
+  return a_val < a_hi ? a_val : a_hi;
+}
+
+static inline double
+clamp_dbl (double a_val, const double a_lo, const double a_hi)
+{
+  a_val = a_val > a_lo ? a_val : a_lo;
+  return a_val < a_hi ? a_val : a_hi;
+}
+
+static inline int32_t
+sign_extend_s24 (const int32_t a_val)
+{
+  return (int32_t) ((uint32_t) a_val << 8) >> 8;
+}
+
+static inline int32_t
+load_s24_3 (const uint8_t * ap_pcm)
+{
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  const uint32_t raw = ((uint32_t) ap_pcm[0] << 16)
+                       | ((uint32_t) ap_pcm[1] << 8) | ap_pcm[2];
+#else
+  const uint32_t raw = ((uint32_t) ap_pcm[2] << 16)
+                       | ((uint32_t) ap_pcm[1] << 8) | ap_pcm[0];
+#endif
+  return sign_extend_s24 ((int32_t) raw);
+}
+
+static inline void
+store_s24_3 (uint8_t * ap_pcm, const uint32_t a_val)
+{
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  ap_pcm[0] = (uint8_t) (a_val >> 16);
+  ap_pcm[1] = (uint8_t) (a_val >> 8);
+  ap_pcm[2] = (uint8_t) a_val;
+#else
+  ap_pcm[0] = (uint8_t) a_val;
+  ap_pcm[1] = (uint8_t) (a_val >> 8);
+  ap_pcm[2] = (uint8_t) (a_val >> 16);
+#endif
+}
+
+static void
+mul_s16_scalar (void * ap_data, const float * ap_gains, size_t a_nsamples)
+{
+  int16_t * p_pcm = ap_data;
+  size_t i = 0;
+  for (i = 0; i < a_nsamples; ++i)
+    {
+      const float val = clamp_flt ((float) p_pcm[i] * ap_gains[i],
+                                   TIZ_PCM_S16_MIN, TIZ_PCM_S16_MAX);
+      p_pcm[i] = (int16_t) lrintf (val);
+    }
+}
+
+static void
+mul_s24_scalar (void * ap_data, const float * ap_gains, size_t a_nsamples)
+{
+  int32_t * p_pcm = ap_data;
+  size_t i = 0;
+  for (i = 0; i < a_nsamples; ++i)
+    {
+      const float val
+        = clamp_flt ((float) sign_extend_s24 (p_pcm[i]) * ap_gains[i],
+                     TIZ_PCM_S24_MIN, TIZ_PCM_S24_MAX);
+      p_pcm[i] = (int32_t) lrintf (val);
+    }
+}
+
+static void
+mul_s24_3_scalar (void * ap_data, const float * ap_gains, size_t a_nsamples)
+{
+  uint8_t * p_pcm = ap_data;
+  size_t i = 0;
+  for (i = 0; i < a_nsamples; ++i, p_pcm += 3)
+    {
+      const float val = clamp_flt ((float) load_s24_3 (p_pcm) * ap_gains[i],
+                                   TIZ_PCM_S24_MIN, TIZ_PCM_S24_MAX);
+      store_s24_3 (p_pcm, (uint32_t) lrintf (val));
+    }
+}
+
+static void
+mul_s32_scalar (void * ap_data, const float * ap_gains, size_t a_nsamples)
+{
+  int32_t * p_pcm = ap_data;
+  size_t i = 0;
+  for (i = 0; i < a_nsamples; ++i)
+    {
+      const double val = clamp_dbl ((double) p_pcm[i] * (double) ap_gains[i],
+                                    TIZ_PCM_S32_MIN, TIZ_PCM_S32_MAX);
+      p_pcm[i] = (int32_t) llrint (val);
+    }
+}
+
+static void
+mul_flt_scalar (void * ap_data, const float * ap_gains, size_t a_nsamples)
+{
+  float * p_pcm = ap_data;
+  size_t i = 0;
+  for (i = 0; i < a_nsamples; ++i)
+    {
+      p_pcm[i] *= ap_gains[i];
+    }
+}
+
+static void
+swap16_scalar (void * ap_data, size_t a_nsamples)
+{
+  uint16_t * p_pcm = ap_data;
+  size_t i = 0;
+  for (i = 0; i < a_nsamples; ++i)
+    {
+      p_pcm[i] = bswap_16 (p_pcm[i]);
+    }
+}
+
+static void
+swap24_scalar (void * ap_data, size_t a_nsamples)
+{
+  uint8_t * p_pcm = ap_data;
+  size_t i = 0;
+  for (i = 0; i < a_nsamples; ++i, p_pcm += 3)
+    {
+      const uint8_t tmp = p_pcm[0];
+      p_pcm[0] = p_pcm[2];
+      p_pcm[2] = tmp;
+    }
+}
+
+static void
+swap32_scalar (void * ap_data, size_t a_nsamples)
+{
+  uint32_t * p_pcm = ap_data;
+  size_t i = 0;
+  for (i = 0; i < a_nsamples; ++i)
+    {
+      p_pcm[i] = bswap_32 (p_pcm[i]);
+    }
+}
+
+static void
+from_flt_s16_scalar (void * ap_dst, const float * ap_src, size_t a_nsamples)
+{
+  int16_t * p_pcm = ap_dst;
+  size_t i = 0;
+  for (i = 0; i < a_nsamples; ++i)
+    {
+      const float val = clamp_flt (ap_src[i] * TIZ_PCM_S16_SCALE,
+                                   TIZ_PCM_S16_MIN, TIZ_PCM_S16_MAX);
+      p_pcm[i] = (int16_t) lrintf (val);
+    }
+}
+
+static void
+from_flt_s24_scalar (void * ap_dst, const float * ap_src, size_t a_nsamples)
+{
+  int32_t * p_pcm = ap_dst;
+  size_t i = 0;
+  for (i = 0; i < a_nsamples; ++i)
+    {
+      const float val = clamp_flt (ap_src[i] * TIZ_PCM_S24_SCALE,
+                                   TIZ_PCM_S24_MIN, TIZ_PCM_S24_MAX);
+      p_pcm[i] = (int32_t) lrintf (val);
+    }
+}
+
+static void
+from_flt_s24_3_scalar (void * ap_dst, const float * ap_src, size_t a_nsamples)
+{
+  uint8_t * p_pcm = ap_dst;
+  size_t i = 0;
+  for (i = 0; i < a_nsamples; ++i, p_pcm += 3)
+    {
+      const float val = clamp_flt (ap_src[i] * TIZ_PCM_S24_SCALE,
+                                   TIZ_PCM_S24_MIN, TIZ_PCM_S24_MAX);
+      store_s24_3 (p_pcm, (uint32_t) lrintf (val));
+    }
+}
+
+static void
+from_flt_s32_scalar (void * ap_dst, const float * ap_src, size_t a_nsamples)
+{
+  int32_t * p_pcm = ap_dst;
+  size_t i = 0;
+  for (i = 0; i < a_nsamples; ++i)
+    {
+      const double val = clamp_dbl ((double) ap_src[i] * TIZ_PCM_S32_SCALE,
+                                    TIZ_PCM_S32_MIN, TIZ_PCM_S32_MAX);
+      p_pcm[i] = (int32_t) llrint (val);
+    }
+}
+
+static void
+copy_flt (void * ap_dst, const float * ap_src, size_t a_nsamples)
+{
+  memmove (ap_dst, ap_src, a_nsamples * sizeof (float));
+}
+
+static void
+to_flt_s16_scalar (float * ap_dst, const void * ap_src, size_t a_nsamples)
+{
+  const int16_t * p_pcm = ap_src;
+  size_t i = 0;
+  for (i = 0; i < a_nsamples; ++i)
+    {
+      ap_dst[i] = (float) p_pcm[i] * (1.f / TIZ_PCM_S16_SCALE);
+    }
+}
+
+static void
+to_flt_s24_scalar (float * ap_dst, const void * ap_src, size_t a_nsamples)
+{
+  const int32_t * p_pcm = ap_src;
+  size_t i = 0;
+  for (i = 0; i < a_nsamples; ++i)
+    {
+      ap_dst[i]
+        = (float) sign_extend_s24 (p_pcm[i]) * (1.f / TIZ_PCM_S24_SCALE);
+    }
+}
+
+static void
+to_flt_s24_3_scalar (float * ap_dst, const void * ap_src, size_t a_nsamples)
+{
+  const uint8_t * p_pcm = ap_src;
+  size_t i = 0;
+  for (i = 0; i < a_nsamples; ++i, p_pcm += 3)
+    {
+      ap_dst[i] = (float) load_s24_3 (p_pcm) * (1.f / TIZ_PCM_S24_SCALE);
+    }
+}
+
+static void
+to_flt_s32_scalar (float * ap_dst, const void * ap_src, size_t a_nsamples)
+{
+  const int32_t * p_pcm = ap_src;
+  size_t i = 0;
+  for (i = 0; i < a_nsamples; ++i)
+    {
+      ap_dst[i] = (float) p_pcm[i] * (float) (1.0 / TIZ_PCM_S32_SCALE);
+    }
+}
+
+static void
+to_flt_flt (float * ap_dst, const void * ap_src, size_t a_nsamples)
+{
+  memmove (ap_dst, ap_src, a_nsamples * sizeof (float));
+}
+
+/* Clips to [-1.0, 1.0), adds the noise and the rounding offset and drops the
+   extra fractional bits. The final saturation only matters when positive
+   full scale is rounded or dithered up. */
+static void
+fixed_s16_scalar (int16_t * ap_dst, const int32_t * ap_src,
+                  const int32_t * ap_noise, size_t a_nsamples,
+                  unsigned a_frac_bits)
+{
+  const int32_t lo = -((int32_t) 1 << a_frac_bits);
+  const int32_t hi = ((int32_t) 1 << a_frac_bits) - 1;
+  const unsigned shift = a_frac_bits - 15;
+  const int32_t half = (int32_t) 1 << (shift - 1);
+  size_t i = 0;
+  for (i = 0; i < a_nsamples; ++i)
+    {
+      int32_t val = ap_src[i];
+      val = val > lo ? val : lo;
+      val = val < hi ? val : hi;
+      val = (val + ap_noise[i] + half) >> shift;
+      val = val > -32768 ? val : -32768;
+      ap_dst[i] = (int16_t) (val < 32767 ? val : 32767);
+    }
+}
+
+static void
+ilv2_16_scalar (void * ap_dst, const void * ap_left, const void * ap_right,
+                size_t a_nframes)
+{
+  int16_t * p_dst = ap_dst;
+  const int16_t * p_left = ap_left;
+  const int16_t * p_right = ap_right;
+  size_t i = 0;
+  for (i = 0; i < a_nframes; ++i)
+    {
+      p_dst[2 * i] = p_left[i];
+      p_dst[2 * i + 1] = p_right[i];
+    }
+}
+
+static void
+ilv2_32_scalar (void * ap_dst, const void * ap_left, const void * ap_right,
+                size_t a_nframes)
+{
+  uint32_t * p_dst = ap_dst;
+  const uint32_t * p_left = ap_left;
+  const uint32_t * p_right = ap_right;
+  size_t i = 0;
+  for (i = 0; i < a_nframes; ++i)
+    {
+      p_dst[2 * i] = p_left[i];
+      p_dst[2 * i + 1] = p_right[i];
+    }
+}
+
+static void
+dilv2_16_scalar (void * ap_left, void * ap_right, const void * ap_src,
+                 size_t a_nframes)
+{
+  int16_t * p_left = ap_left;
+  int16_t * p_right = ap_right;
+  const int16_t * p_src = ap_src;
+  size_t i = 0;
+  for (i = 0; i < a_nframes; ++i)
+    {
+      p_left[i] = p_src[2 * i];
+      p_right[i] = p_src[2 * i + 1];
+    }
+}
+
+static void
+dilv2_32_scalar (void * ap_left, void * ap_right, const void * ap_src,
+                 size_t a_nframes)
+{
+  uint32_t * p_left = ap_left;
+  uint32_t * p_right = ap_right;
+  const uint32_t * p_src = ap_src;
+  size_t i = 0;
+  for (i = 0; i < a_nframes; ++i)
+    {
+      p_left[i] = p_src[2 * i];
+      p_right[i] = p_src[2 * i + 1];
+    }
+}
+
+/* Any sample size and number of channels; one channel at a time */
+static void
+interleave_scalar (void * ap_dst, const void * const * app_src,
+                   const size_t a_width, const OMX_U32 a_nchannels,
+                   const size_t a_nframes)
+{
+  const size_t stride = a_width * a_nchannels;
+  OMX_U32 c = 0;
+  for (c = 0; c < a_nchannels; ++c)
+    {
+      const uint8_t * p_src = app_src[c];
+      uint8_t * p_dst = (uint8_t *) ap_dst + c * a_width;
+      size_t i = 0;
+      for (i = 0; i < a_nframes; ++i, p_src += a_width, p_dst += stride)
+        {
+          memcpy (p_dst, p_src, a_width);
+        }
+    }
+}
+
+static void
+deinterleave_scalar (void * const * app_dst, const void * ap_src,
+                     const size_t a_width, const OMX_U32 a_nchannels,
+                     const size_t a_nframes)
+{
+  const size_t stride = a_width * a_nchannels;
+  OMX_U32 c = 0;
+  for (c = 0; c < a_nchannels; ++c)
+    {
+      const uint8_t * p_src = (const uint8_t *) ap_src + c * a_width;
+      uint8_t * p_dst = app_dst[c];
+      size_t i = 0;
+      for (i = 0; i < a_nframes; ++i, p_src += stride, p_dst += a_width)
+        {
+          memcpy (p_dst, p_src, a_width);
+        }
+    }
+}
+
+static const tiz_pcm_ops_t scalar_ops = {
+  ETIZPcmIsaScalar,
+  {mul_s16_scalar, mul_s24_scalar, mul_s24_3_scalar, mul_s32_scalar,
+   mul_flt_scalar},
+  swap16_scalar,
+  swap32_scalar,
+  {from_flt_s16_scalar, from_flt_s24_scalar, from_flt_s24_3_scalar,
+   from_flt_s32_scalar, copy_flt},
+  {to_flt_s16_scalar, to_flt_s24_scalar, to_flt_s24_3_scalar,
+   to_flt_s32_scalar, to_flt_flt},
+  fixed_s16_scalar,
+  ilv2_16_scalar,
+  ilv2_32_scalar,
+  dilv2_16_scalar,
+  dilv2_32_scalar
+};
+
+#ifdef TIZ_PCM_X86
+
+/*
+ * SSE2 and AVX2 implementations. These are compiled with target attributes
+ * so that the library itself can still be built for the baseline ISA; they
+ * are only ever called after a runtime check of the CPU features.
+ */
+
+#define TIZ_PCM_SSE2 __attribute__ ((target ("sse2")))
+#define TIZ_PCM_AVX2 __attribute__ ((target ("avx2")))
+
+static TIZ_PCM_SSE2 void
+mul_s16_sse2 (void * ap_data, const float * ap_gains, size_t a_nsamples)
+{
+  int16_t * p_pcm = ap_data;
+  const __m128 lo = _mm_set1_ps (TIZ_PCM_S16_MIN);
+  const __m128 hi = _mm_set1_ps (TIZ_PCM_S16_MAX);
+  size_t i = 0;
+  for (i = 0; i + 8 <= a_nsamples; i += 8)
+    {
+      const __m128i in = _mm_loadu_si128 ((const __m128i *) (p_pcm + i));
+      /* Interleaving with itself and shifting back sign-extends to 32 bits */
+      __m128 f0
+        = _mm_cvtepi32_ps (_mm_srai_epi32 (_mm_unpacklo_epi16 (in, in), 16));
+      __m128 f1
+        = _mm_cvtepi32_ps (_mm_srai_epi32 (_mm_unpackhi_epi16 (in, in), 16));
+      f0 = _mm_mul_ps (f0, _mm_loadu_ps (ap_gains + i));
+      f1 = _mm_mul_ps (f1, _mm_loadu_ps (ap_gains + i + 4));
+      f0 = _mm_min_ps (_mm_max_ps (f0, lo), hi);
+      f1 = _mm_min_ps (_mm_max_ps (f1, lo), hi);
+      _mm_storeu_si128 ((__m128i *) (p_pcm + i),
+                        _mm_packs_epi32 (_mm_cvtps_epi32 (f0),
+                                         _mm_cvtps_epi32 (f1)));
+    }
+  mul_s16_scalar (p_pcm + i, ap_gains + i, a_nsamples - i);
+}
+
+static TIZ_PCM_SSE2 void
+mul_s24_sse2 (void * ap_data, const float * ap_gains, size_t a_nsamples)
+{
+  int32_t * p_pcm = ap_data;
+  const __m128 lo = _mm_set1_ps (TIZ_PCM_S24_MIN);
+  const __m128 hi = _mm_set1_ps (TIZ_PCM_S24_MAX);
+  size_t i = 0;
+  for (i = 0; i + 4 <= a_nsamples; i += 4)
+    {
+      __m128i in = _mm_loadu_si128 ((const __m128i *) (p_pcm + i));
+      __m128 f;
+      in = _mm_srai_epi32 (_mm_slli_epi32 (in, 8), 8);
+      f = _mm_mul_ps (_mm_cvtepi32_ps (in), _mm_loadu_ps (ap_gains + i));
+      f = _mm_min_ps (_mm_max_ps (f, lo), hi);
+      _mm_storeu_si128 ((__m128i *) (p_pcm + i), _mm_cvtps_epi32 (f));
+    }
+  mul_s24_scalar (p_pcm + i, ap_gains + i, a_nsamples - i);
+}
+
+static TIZ_PCM_SSE2 void
+mul_s32_sse2 (void * ap_data, const float * ap_gains, size_t a_nsamples)
+{
+  int32_t * p_pcm = ap_data;
+  const __m128d lo = _mm_set1_pd (TIZ_PCM_S32_MIN);
+  const __m128d hi = _mm_set1_pd (TIZ_PCM_S32_MAX);
+  size_t i = 0;
+  for (i = 0; i + 4 <= a_nsamples; i += 4)
+    {
+      const __m128i in = _mm_loadu_si128 ((const __m128i *) (p_pcm + i));
+      const __m128 g = _mm_loadu_ps (ap_gains + i);
+      __m128d d0 = _mm_cvtepi32_pd (in);
+      __m128d d1 = _mm_cvtepi32_pd (_mm_srli_si128 (in, 8));
+      d0 = _mm_mul_pd (d0, _mm_cvtps_pd (g));
+      d1 = _mm_mul_pd (d1, _mm_cvtps_pd (_mm_movehl_ps (g, g)));
+      d0 = _mm_min_pd (_mm_max_pd (d0, lo), hi);
+      d1 = _mm_min_pd (_mm_max_pd (d1, lo), hi);
+      _mm_storeu_si128 ((__m128i *) (p_pcm + i),
+                        _mm_unpacklo_epi64 (_mm_cvtpd_epi32 (d0),
+                                            _mm_cvtpd_epi32 (d1)));
+    }
+  mul_s32_scalar (p_pcm + i, ap_gains + i, a_nsamples - i);
+}
+
+static TIZ_PCM_SSE2 void
+mul_flt_sse2 (void * ap_data, const float * ap_gains, size_t a_nsamples)
+{
+  float * p_pcm = ap_data;
+  size_t i = 0;
+  for (i = 0; i + 8 <= a_nsamples; i += 8)
+    {
+      _mm_storeu_ps (p_pcm + i, _mm_mul_ps (_mm_loadu_ps (p_pcm + i),
+                                            _mm_loadu_ps (ap_gains + i)));
+      _mm_storeu_ps (p_pcm + i + 4,
+                     _mm_mul_ps (_mm_loadu_ps (p_pcm + i + 4),
+                                 _mm_loadu_ps (ap_gains + i + 4)));
+    }
+  mul_flt_scalar (p_pcm + i, ap_gains + i, a_nsamples - i);
+}
+
+static TIZ_PCM_SSE2 void
+swap16_sse2 (void * ap_data, size_t a_nsamples)
+{
+  uint16_t * p_pcm = ap_data;
+  size_t i = 0;
+  for (i = 0; i + 8 <= a_nsamples; i += 8)
+    {
+      const __m128i in = _mm_loadu_si128 ((const __m128i *) (p_pcm + i));
+      _mm_storeu_si128 ((__m128i *) (p_pcm + i),
+                        _mm_or_si128 (_mm_slli_epi16 (in, 8),
+                                      _mm_srli_epi16 (in, 8)));
+    }
+  swap16_scalar (p_pcm + i, a_nsamples - i);
+}
+
+static TIZ_PCM_SSE2 void
+swap32_sse2 (void * ap_data, size_t a_nsamples)
+{
+  uint32_t * p_pcm = ap_data;
+  size_t i = 0;
+  for (i = 0; i + 4 <= a_nsamples; i += 4)
+    {
+      __m128i in = _mm_loadu_si128 ((const __m128i *) (p_pcm + i));
+      /* Swap the 16-bit halves of each word, then the bytes of each half */
+      in = _mm_shufflehi_epi16 (_mm_shufflelo_epi16 (in, 0xB1), 0xB1);
+      _mm_storeu_si128 ((__m128i *) (p_pcm + i),
+                        _mm_or_si128 (_mm_slli_epi16 (in, 8),
+                                      _mm_srli_epi16 (in, 8)));
+    }
+  swap32_scalar (p_pcm + i, a_nsamples - i);
+}
+
+static TIZ_PCM_SSE2 void
+from_flt_s16_sse2 (void * ap_dst, const float * ap_src, size_t a_nsamples)
+{
+  int16_t * p_pcm = ap_dst;
+  const __m128 scale = _mm_set1_ps (TIZ_PCM_S16_SCALE);
+  const __m128 lo = _mm_set1_ps (TIZ_PCM_S16_MIN);
+  const __m128 hi = _mm_set1_ps (TIZ_PCM_S16_MAX);
+  size_t i = 0;
+  for (i = 0; i + 8 <= a_nsamples; i += 8)
+    {
+      __m128 f0 = _mm_mul_ps (_mm_loadu_ps (ap_src + i), scale);
+      __m128 f1 = _mm_mul_ps (_mm_loadu_ps (ap_src + i + 4), scale);
+      f0 = _mm_min_ps (_mm_max_ps (f0, lo), hi);
+      f1 = _mm_min_ps (_mm_max_ps (f1, lo), hi);
+      _mm_storeu_si128 ((__m128i *) (p_pcm + i),
+                        _mm_packs_epi32 (_mm_cvtps_epi32 (f0),
+                                         _mm_cvtps_epi32 (f1)));
+    }
+  from_flt_s16_scalar (p_pcm + i, ap_src + i, a_nsamples - i);
+}
+
+static TIZ_PCM_SSE2 void
+from_flt_s24_sse2 (void * ap_dst, const float * ap_src, size_t a_nsamples)
+{
+  int32_t * p_pcm = ap_dst;
+  const __m128 scale = _mm_set1_ps (TIZ_PCM_S24_SCALE);
+  const __m128 lo = _mm_set1_ps (TIZ_PCM_S24_MIN);
+  const __m128 hi = _mm_set1_ps (TIZ_PCM_S24_MAX);
+  size_t i = 0;
+  for (i = 0; i + 4 <= a_nsamples; i += 4)
+    {
+      __m128 f = _mm_mul_ps (_mm_loadu_ps (ap_src + i), scale);
+      f = _mm_min_ps (_mm_max_ps (f, lo), hi);
+      _mm_storeu_si128 ((__m128i *) (p_pcm + i), _mm_cvtps_epi32 (f));
+    }
+  from_flt_s24_scalar (p_pcm + i, ap_src + i, a_nsamples - i);
+}
+
+static TIZ_PCM_SSE2 void
+from_flt_s32_sse2 (void * ap_dst, const float * ap_src, size_t a_nsamples)
+{
+  int32_t * p_pcm = ap_dst;
+  const __m128d scale = _mm_set1_pd (TIZ_PCM_S32_SCALE);
+  const __m128d lo = _mm_set1_pd (TIZ_PCM_S32_MIN);
+  const __m128d hi = _mm_set1_pd (TIZ_PCM_S32_MAX);
+  size_t i = 0;
+  for (i = 0; i + 4 <= a_nsamples; i += 4)
+    {
+      const __m128 f = _mm_loadu_ps (ap_src + i);
+      __m128d d0 = _mm_mul_pd (_mm_cvtps_pd (f), scale);
+      __m128d d1 = _mm_mul_pd (_mm_cvtps_pd (_mm_movehl_ps (f, f)), scale);
+      d0 = _mm_min_pd (_mm_max_pd (d0, lo), hi);
+      d1 = _mm_min_pd (_mm_max_pd (d1, lo), hi);
+      _mm_storeu_si128 ((__m128i *) (p_pcm + i),
+                        _mm_unpacklo_epi64 (_mm_cvtpd_epi32 (d0),
+                                            _mm_cvtpd_epi32 (d1)));
+    }
+  from_flt_s32_scalar (p_pcm + i, ap_src + i, a_nsamples - i);
+}
+
+static TIZ_PCM_SSE2 void
+to_flt_s16_sse2 (float * ap_dst, const void * ap_src, size_t a_nsamples)
+{
+  const int16_t * p_pcm = ap_src;
+  const __m128 scale = _mm_set1_ps (1.f / TIZ_PCM_S16_SCALE);
+  size_t i = 0;
+  for (i = 0; i + 8 <= a_nsamples; i += 8)
+    {
+      const __m128i in = _mm_loadu_si128 ((const __m128i *) (p_pcm + i));
+      const __m128 f0
+        = _mm_cvtepi32_ps (_mm_srai_epi32 (_mm_unpacklo_epi16 (in, in), 16));
+      const __m128 f1
+        = _mm_cvtepi32_ps (_mm_srai_epi32 (_mm_unpackhi_epi16 (in, in), 16));
+      _mm_storeu_ps (ap_dst + i, _mm_mul_ps (f0, scale));
+      _mm_storeu_ps (ap_dst + i + 4, _mm_mul_ps (f1, scale));
+    }
+  to_flt_s16_scalar (ap_dst + i, p_pcm + i, a_nsamples - i);
+}
+
+static TIZ_PCM_SSE2 void
+to_flt_s24_sse2 (float * ap_dst, const void * ap_src, size_t a_nsamples)
+{
+  const int32_t * p_pcm = ap_src;
+  const __m128 scale = _mm_set1_ps (1.f / TIZ_PCM_S24_SCALE);
+  size_t i = 0;
+  for (i = 0; i + 4 <= a_nsamples; i += 4)
+    {
+      __m128i in = _mm_loadu_si128 ((const __m128i *) (p_pcm + i));
+      in = _mm_srai_epi32 (_mm_slli_epi32 (in, 8), 8);
+      _mm_storeu_ps (ap_dst + i, _mm_mul_ps (_mm_cvtepi32_ps (in), scale));
+    }
+  to_flt_s24_scalar (ap_dst + i, p_pcm + i, a_nsamples - i);
+}
+
+static TIZ_PCM_SSE2 void
+to_flt_s32_sse2 (float * ap_dst, const void * ap_src, size_t a_nsamples)
+{
+  const int32_t * p_pcm = ap_src;
+  const __m128 scale = _mm_set1_ps ((float) (1.0 / TIZ_PCM_S32_SCALE));
+  size_t i = 0;
+  for (i = 0; i + 4 <= a_nsamples; i += 4)
+    {
+      const __m128i in = _mm_loadu_si128 ((const __m128i *) (p_pcm + i));
+      _mm_storeu_ps (ap_dst + i, _mm_mul_ps (_mm_cvtepi32_ps (in), scale));
+    }
+  to_flt_s32_scalar (ap_dst + i, p_pcm + i, a_nsamples - i);
+}
+
+/* SSE2 has no 32-bit integer min/max; select with a compare mask instead */
+static TIZ_PCM_SSE2 inline __m128i
+clamp_epi32_sse2 (__m128i a_val, const __m128i a_lo, const __m128i a_hi)
+{
+  __m128i mask = _mm_cmpgt_epi32 (a_val, a_lo);
+  a_val = _mm_or_si128 (_mm_and_si128 (mask, a_val),
+                        _mm_andnot_si128 (mask, a_lo));
+  mask = _mm_cmplt_epi32 (a_val, a_hi);
+  return _mm_or_si128 (_mm_and_si128 (mask, a_val),
+                       _mm_andnot_si128 (mask, a_hi));
+}
+
+static TIZ_PCM_SSE2 void
+fixed_s16_sse2 (int16_t * ap_dst, const int32_t * ap_src,
+                const int32_t * ap_noise, size_t a_nsamples,
+                unsigned a_frac_bits)
+{
+  const unsigned shift = a_frac_bits - 15;
+  const __m128i lo = _mm_set1_epi32 (-((int32_t) 1 << a_frac_bits));
+  const __m128i hi = _mm_set1_epi32 (((int32_t) 1 << a_frac_bits) - 1);
+  const __m128i half = _mm_set1_epi32 ((int32_t) 1 << (shift - 1));
+  const __m128i count = _mm_cvtsi32_si128 ((int) shift);
+  size_t i = 0;
+  for (i = 0; i + 8 <= a_nsamples; i += 8)
+    {
+      __m128i v0 = _mm_loadu_si128 ((const __m128i *) (ap_src + i));
+      __m128i v1 = _mm_loadu_si128 ((const __m128i *) (ap_src + i + 4));
+      v0 = _mm_add_epi32 (clamp_epi32_sse2 (v0, lo, hi),
+                          _mm_loadu_si128 ((const __m128i *) (ap_noise + i)));
+      v1 = _mm_add_epi32 (
+        clamp_epi32_sse2 (v1, lo, hi),
+        _mm_loadu_si128 ((const __m128i *) (ap_noise + i + 4)));
+      v0 = _mm_sra_epi32 (_mm_add_epi32 (v0, half), count);
+      v1 = _mm_sra_epi32 (_mm_add_epi32 (v1, half), count);
+      _mm_storeu_si128 ((__m128i *) (ap_dst + i), _mm_packs_epi32 (v0, v1));
+    }
+  fixed_s16_scalar (ap_dst + i, ap_src + i, ap_noise + i, a_nsamples - i,
+                    a_frac_bits);
+}
+
+static TIZ_PCM_SSE2 void
+ilv2_16_sse2 (void * ap_dst, const void * ap_left, const void * ap_right,
+              size_t a_nframes)
+{
+  int16_t * p_dst = ap_dst;
+  const int16_t * p_left = ap_left;
+  const int16_t * p_right = ap_right;
+  size_t i = 0;
+  for (i = 0; i + 8 <= a_nframes; i += 8)
+    {
+      const __m128i l = _mm_loadu_si128 ((const __m128i *) (p_left + i));
+      const __m128i r = _mm_loadu_si128 ((const __m128i *) (p_right + i));
+      _mm_storeu_si128 ((__m128i *) (p_dst + 2 * i),
+                        _mm_unpacklo_epi16 (l, r));
+      _mm_storeu_si128 ((__m128i *) (p_dst + 2 * i + 8),
+                        _mm_unpackhi_epi16 (l, r));
+    }
+  ilv2_16_scalar (p_dst + 2 * i, p_left + i, p_right + i, a_nframes - i);
+}
+
+static TIZ_PCM_SSE2 void
+ilv2_32_sse2 (void * ap_dst, const void * ap_left, const void * ap_right,
+              size_t a_nframes)
+{
+  uint32_t * p_dst = ap_dst;
+  const uint32_t * p_left = ap_left;
+  const uint32_t * p_right = ap_right;
+  size_t i = 0;
+  for (i = 0; i + 4 <= a_nframes; i += 4)
+    {
+      const __m128i l = _mm_loadu_si128 ((const __m128i *) (p_left + i));
+      const __m128i r = _mm_loadu_si128 ((const __m128i *) (p_right + i));
+      _mm_storeu_si128 ((__m128i *) (p_dst + 2 * i),
+                        _mm_unpacklo_epi32 (l, r));
+      _mm_storeu_si128 ((__m128i *) (p_dst + 2 * i + 4),
+                        _mm_unpackhi_epi32 (l, r));
+    }
+  ilv2_32_scalar (p_dst + 2 * i, p_left + i, p_right + i, a_nframes - i);
+}
+
+static TIZ_PCM_SSE2 void
+dilv2_16_sse2 (void * ap_left, void * ap_right, const void * ap_src,
+               size_t a_nframes)
+{
+  int16_t * p_left = ap_left;
+  int16_t * p_right = ap_right;
+  const int16_t * p_src = ap_src;
+  size_t i = 0;
+  for (i = 0; i + 8 <= a_nframes; i += 8)
+    {
+      const __m128i a = _mm_loadu_si128 ((const __m128i *) (p_src + 2 * i));
+      const __m128i b
+        = _mm_loadu_si128 ((const __m128i *) (p_src + 2 * i + 8));
+      /* Sign-extend each half of the 32-bit frames; the packs cannot
+         saturate */
+      _mm_storeu_si128 (
+        (__m128i *) (p_left + i),
+        _mm_packs_epi32 (_mm_srai_epi32 (_mm_slli_epi32 (a, 16), 16),
+                         _mm_srai_epi32 (_mm_slli_epi32 (b, 16), 16)));
+      _mm_storeu_si128 ((__m128i *) (p_right + i),
+                        _mm_packs_epi32 (_mm_srai_epi32 (a, 16),
+                                         _mm_srai_epi32 (b, 16)));
+    }
+  dilv2_16_scalar (p_left + i, p_right + i, p_src + 2 * i, a_nframes - i);
+}
+
+static TIZ_PCM_SSE2 void
+dilv2_32_sse2 (void * ap_left, void * ap_right, const void * ap_src,
+               size_t a_nframes)
+{
+  float * p_left = ap_left;
+  float * p_right = ap_right;
+  const float * p_src = ap_src;
+  size_t i = 0;
+  for (i = 0; i + 4 <= a_nframes; i += 4)
+    {
+      /* Shuffling as floats only moves bits around */
+      const __m128 a = _mm_loadu_ps (p_src + 2 * i);
+      const __m128 b = _mm_loadu_ps (p_src + 2 * i + 4);
+      _mm_storeu_ps (p_left + i,
+                     _mm_shuffle_ps (a, b, _MM_SHUFFLE (2, 0, 2, 0)));
+      _mm_storeu_ps (p_right + i,
+                     _mm_shuffle_ps (a, b, _MM_SHUFFLE (3, 1, 3, 1)));
+    }
+  dilv2_32_scalar (p_left + i, p_right + i, p_src + 2 * i, a_nframes - i);
+}
+
+static TIZ_PCM_AVX2 void
+mul_s16_avx2 (void * ap_data, const float * ap_gains, size_t a_nsamples)
+{
+  int16_t * p_pcm = ap_data;
+  const __m256 lo = _mm256_set1_ps (TIZ_PCM_S16_MIN);
+  const __m256 hi = _mm256_set1_ps (TIZ_PCM_S16_MAX);
+  size_t i = 0;
+  for (i = 0; i + 8 <= a_nsamples; i += 8)
+    {
+      const __m128i in = _mm_loadu_si128 ((const __m128i *) (p_pcm + i));
+      __m256 f = _mm256_cvtepi32_ps (_mm256_cvtepi16_epi32 (in));
+      __m256i out;
+      f = _mm256_mul_ps (f, _mm256_loadu_ps (ap_gains + i));
+      f = _mm256_min_ps (_mm256_max_ps (f, lo), hi);
+      out = _mm256_cvtps_epi32 (f);
+      _mm_storeu_si128 ((__m128i *) (p_pcm + i),
+                        _mm_packs_epi32 (_mm256_castsi256_si128 (out),
+                                         _mm256_extracti128_si256 (out, 1)));
+    }
+  mul_s16_scalar (p_pcm + i, ap_gains + i, a_nsamples - i);
+}
+
+static TIZ_PCM_AVX2 void
+mul_s24_avx2 (void * ap_data, const float * ap_gains, size_t a_nsamples)
+{
+  int32_t * p_pcm = ap_data;
+  const __m256 lo = _mm256_set1_ps (TIZ_PCM_S24_MIN);
+  const __m256 hi = _mm256_set1_ps (TIZ_PCM_S24_MAX);
+  size_t i = 0;
+  for (i = 0; i + 8 <= a_nsamples; i += 8)
+    {
+      __m256i in = _mm256_loadu_si256 ((const __m256i *) (p_pcm + i));
+      __m256 f;
+      in = _mm256_srai_epi32 (_mm256_slli_epi32 (in, 8), 8);
+      f = _mm256_mul_ps (_mm256_cvtepi32_ps (in),
+                         _mm256_loadu_ps (ap_gains + i));
+      f = _mm256_min_ps (_mm256_max_ps (f, lo), hi);
+      _mm256_storeu_si256 ((__m256i *) (p_pcm + i), _mm256_cvtps_epi32 (f));
+    }
+  mul_s24_scalar (p_pcm + i, ap_gains + i, a_nsamples - i);
+}
+
+static TIZ_PCM_AVX2 void
+mul_s32_avx2 (void * ap_data, const float * ap_gains, size_t a_nsamples)
+{
+  int32_t * p_pcm = ap_data;
+  const __m256d lo = _mm256_set1_pd (TIZ_PCM_S32_MIN);
+  const __m256d hi = _mm256_set1_pd (TIZ_PCM_S32_MAX);
+  size_t i = 0;
+  for (i = 0; i + 4 <= a_nsamples; i += 4)
+    {
+      const __m128i in = _mm_loadu_si128 ((const __m128i *) (p_pcm + i));
+      __m256d d = _mm256_cvtepi32_pd (in);
+      d = _mm256_mul_pd (d, _mm256_cvtps_pd (_mm_loadu_ps (ap_gains + i)));
+      d = _mm256_min_pd (_mm256_max_pd (d, lo), hi);
+      _mm_storeu_si128 ((__m128i *) (p_pcm + i), _mm256_cvtpd_epi32 (d));
+    }
+  mul_s32_scalar (p_pcm + i, ap_gains + i, a_nsamples - i);
+}
+
+static TIZ_PCM_AVX2 void
+mul_flt_avx2 (void * ap_data, const float * ap_gains, size_t a_nsamples)
+{
+  float * p_pcm = ap_data;
+  size_t i = 0;
+  for (i = 0; i + 8 <= a_nsamples; i += 8)
+    {
+      _mm256_storeu_ps (p_pcm + i,
+                        _mm256_mul_ps (_mm256_loadu_ps (p_pcm + i),
+                                       _mm256_loadu_ps (ap_gains + i)));
+    }
+  mul_flt_scalar (p_pcm + i, ap_gains + i, a_nsamples - i);
+}
+
+static TIZ_PCM_AVX2 void
+swap_bytes_avx2 (uint8_t * ap_bytes, size_t a_nbytes, const __m256i a_mask)
+{
+  size_t i = 0;
+  for (i = 0; i + 32 <= a_nbytes; i += 32)
+    {
+      const __m256i in = _mm256_loadu_si256 ((const __m256i *) (ap_bytes + i));
+      _mm256_storeu_si256 ((__m256i *) (ap_bytes + i),
+                           _mm256_shuffle_epi8 (in, a_mask));
+    }
+}
+
+static TIZ_PCM_AVX2 void
+swap16_avx2 (void * ap_data, size_t a_nsamples)
+{
+  const __m256i mask = _mm256_setr_epi8 (
+    1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+    1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+  const size_t nvec = a_nsamples & ~(size_t) 15;
+  swap_bytes_avx2 (ap_data, nvec * 2, mask);
+  swap16_scalar ((uint16_t *) ap_data + nvec, a_nsamples - nvec);
+}
+
+static TIZ_PCM_AVX2 void
+swap32_avx2 (void * ap_data, size_t a_nsamples)
+{
+  const __m256i mask = _mm256_setr_epi8 (
+    3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+    3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+  const size_t nvec = a_nsamples & ~(size_t) 7;
+  swap_bytes_avx2 (ap_data, nvec * 4, mask);
+  swap32_scalar ((uint32_t *) ap_data + nvec, a_nsamples - nvec);
+}
+
+static TIZ_PCM_AVX2 void
+from_flt_s16_avx2 (void * ap_dst, const float * ap_src, size_t a_nsamples)
+{
+  int16_t * p_pcm = ap_dst;
+  const __m256 scale = _mm256_set1_ps (TIZ_PCM_S16_SCALE);
+  const __m256 lo = _mm256_set1_ps (TIZ_PCM_S16_MIN);
+  const __m256 hi = _mm256_set1_ps (TIZ_PCM_S16_MAX);
+  size_t i = 0;
+  for (i = 0; i + 8 <= a_nsamples; i += 8)
+    {
+      __m256 f = _mm256_mul_ps (_mm256_loadu_ps (ap_src + i), scale);
+      __m256i out;
+      f = _mm256_min_ps (_mm256_max_ps (f, lo), hi);
+      out = _mm256_cvtps_epi32 (f);
+      _mm_storeu_si128 ((__m128i *) (p_pcm + i),
+                        _mm_packs_epi32 (_mm256_castsi256_si128 (out),
+                                         _mm256_extracti128_si256 (out, 1)));
+    }
+  from_flt_s16_scalar (p_pcm + i, ap_src + i, a_nsamples - i);
+}
+
+static TIZ_PCM_AVX2 void
+from_flt_s24_avx2 (void * ap_dst, const float * ap_src, size_t a_nsamples)
+{
+  int32_t * p_pcm = ap_dst;
+  const __m256 scale = _mm256_set1_ps (TIZ_PCM_S24_SCALE);
+  const __m256 lo = _mm256_set1_ps (TIZ_PCM_S24_MIN);
+  const __m256 hi = _mm256_set1_ps (TIZ_PCM_S24_MAX);
+  size_t i = 0;
+  for (i = 0; i + 8 <= a_nsamples; i += 8)
+    {
+      __m256 f = _mm256_mul_ps (_mm256_loadu_ps (ap_src + i), scale);
+      f = _mm256_min_ps (_mm256_max_ps (f, lo), hi);
+      _mm256_storeu_si256 ((__m256i *) (p_pcm + i), _mm256_cvtps_epi32 (f));
+    }
+  from_flt_s24_scalar (p_pcm + i, ap_src + i, a_nsamples - i);
+}
+
+static TIZ_PCM_AVX2 void
+from_flt_s32_avx2 (void * ap_dst, const float * ap_src, size_t a_nsamples)
+{
+  int32_t * p_pcm = ap_dst;
+  const __m256d scale = _mm256_set1_pd (TIZ_PCM_S32_SCALE);
+  const __m256d lo = _mm256_set1_pd (TIZ_PCM_S32_MIN);
+  const __m256d hi = _mm256_set1_pd (TIZ_PCM_S32_MAX);
+  size_t i = 0;
+  for (i = 0; i + 4 <= a_nsamples; i += 4)
+    {
+      __m256d d = _mm256_mul_pd (_mm256_cvtps_pd (_mm_loadu_ps (ap_src + i)),
+                                 scale);
+      d = _mm256_min_pd (_mm256_max_pd (d, lo), hi);
+      _mm_storeu_si128 ((__m128i *) (p_pcm + i), _mm256_cvtpd_epi32 (d));
+    }
+  from_flt_s32_scalar (p_pcm + i, ap_src + i, a_nsamples - i);
+}
+
+static TIZ_PCM_AVX2 void
+to_flt_s16_avx2 (float * ap_dst, const void * ap_src, size_t a_nsamples)
+{
+  const int16_t * p_pcm = ap_src;
+  const __m256 scale = _mm256_set1_ps (1.f / TIZ_PCM_S16_SCALE);
+  size_t i = 0;
+  for (i = 0; i + 8 <= a_nsamples; i += 8)
+    {
+      const __m128i in = _mm_loadu_si128 ((const __m128i *) (p_pcm + i));
+      const __m256 f = _mm256_cvtepi32_ps (_mm256_cvtepi16_epi32 (in));
+      _mm256_storeu_ps (ap_dst + i, _mm256_mul_ps (f, scale));
+    }
+  to_flt_s16_scalar (ap_dst + i, p_pcm + i, a_nsamples - i);
+}
+
+static TIZ_PCM_AVX2 void
+to_flt_s24_avx2 (float * ap_dst, const void * ap_src, size_t a_nsamples)
+{
+  const int32_t * p_pcm = ap_src;
+  const __m256 scale = _mm256_set1_ps (1.f / TIZ_PCM_S24_SCALE);
+  size_t i = 0;
+  for (i = 0; i + 8 <= a_nsamples; i += 8)
+    {
+      __m256i in = _mm256_loadu_si256 ((const __m256i *) (p_pcm + i));
+      in = _mm256_srai_epi32 (_mm256_slli_epi32 (in, 8), 8);
+      _mm256_storeu_ps (ap_dst + i,
+                        _mm256_mul_ps (_mm256_cvtepi32_ps (in), scale));
+    }
+  to_flt_s24_scalar (ap_dst + i, p_pcm + i, a_nsamples - i);
+}
+
+static TIZ_PCM_AVX2 void
+to_flt_s32_avx2 (float * ap_dst, const void * ap_src, size_t a_nsamples)
+{
+  const int32_t * p_pcm = ap_src;
+  const __m256 scale = _mm256_set1_ps ((float) (1.0 / TIZ_PCM_S32_SCALE));
+  size_t i = 0;
+  for (i = 0; i + 8 <= a_nsamples; i += 8)
+    {
+      const __m256i in = _mm256_loadu_si256 ((const __m256i *) (p_pcm + i));
+      _mm256_storeu_ps (ap_dst + i,
+                        _mm256_mul_ps (_mm256_cvtepi32_ps (in), scale));
+    }
+  to_flt_s32_scalar (ap_dst + i, p_pcm + i, a_nsamples - i);
+}
+
+static TIZ_PCM_AVX2 void
+fixed_s16_avx2 (int16_t * ap_dst, const int32_t * ap_src,
+                const int32_t * ap_noise, size_t a_nsamples,
+                unsigned a_frac_bits)
+{
+  const unsigned shift = a_frac_bits - 15;
+  const __m256i lo = _mm256_set1_epi32 (-((int32_t) 1 << a_frac_bits));
+  const __m256i hi = _mm256_set1_epi32 (((int32_t) 1 << a_frac_bits) - 1);
+  const __m256i half = _mm256_set1_epi32 ((int32_t) 1 << (shift - 1));
+  const __m128i count = _mm_cvtsi32_si128 ((int) shift);
+  size_t i = 0;
+  for (i = 0; i + 8 <= a_nsamples; i += 8)
+    {
+      __m256i v = _mm256_loadu_si256 ((const __m256i *) (ap_src + i));
+      v = _mm256_min_epi32 (_mm256_max_epi32 (v, lo), hi);
+      v = _mm256_add_epi32 (
+        v, _mm256_loadu_si256 ((const __m256i *) (ap_noise + i)));
+      v = _mm256_sra_epi32 (_mm256_add_epi32 (v, half), count);
+      _mm_storeu_si128 ((__m128i *) (ap_dst + i),
+                        _mm_packs_epi32 (_mm256_castsi256_si128 (v),
+                                         _mm256_extracti128_si256 (v, 1)));
+    }
+  fixed_s16_scalar (ap_dst + i, ap_src + i, ap_noise + i, a_nsamples - i,
+                    a_frac_bits);
+}
+
+static const tiz_pcm_ops_t sse2_ops = {
+  ETIZPcmIsaSse2,
+  {mul_s16_sse2, mul_s24_sse2, mul_s24_3_scalar, mul_s32_sse2, mul_flt_sse2},
+  swap16_sse2,
+  swap32_sse2,
+  {from_flt_s16_sse2, from_flt_s24_sse2, from_flt_s24_3_scalar,
+   from_flt_s32_sse2, copy_flt},
+  {to_flt_s16_sse2, to_flt_s24_sse2, to_flt_s24_3_scalar, to_flt_s32_sse2,
+   to_flt_flt},
+  fixed_s16_sse2,
+  ilv2_16_sse2,
+  ilv2_32_sse2,
+  dilv2_16_sse2,
+  dilv2_32_sse2
+};
+
+/* (De)interleaving is bound by memory bandwidth, so there is no point in
+   wider variants of those */
+static const tiz_pcm_ops_t avx2_ops = {
+  ETIZPcmIsaAvx2,
+  {mul_s16_avx2, mul_s24_avx2, mul_s24_3_scalar, mul_s32_avx2, mul_flt_avx2},
+  swap16_avx2,
+  swap32_avx2,
+  {from_flt_s16_avx2, from_flt_s24_avx2, from_flt_s24_3_scalar,
+   from_flt_s32_avx2, copy_flt},
+  {to_flt_s16_avx2, to_flt_s24_avx2, to_flt_s24_3_scalar, to_flt_s32_avx2,
+   to_flt_flt},
+  fixed_s16_avx2,
+  ilv2_16_sse2,
+  ilv2_32_sse2,
+  dilv2_16_sse2,
+  dilv2_32_sse2
+};
+
+#endif /* TIZ_PCM_X86 */
+
+#ifdef TIZ_PCM_NEON
+
+/*
+ * NEON implementation (aarch64 only, where Advanced SIMD is mandatory and the
+ * round-to-nearest conversions and IEEE minNum/maxNum are available).
+ */
+
+static void
+mul_s16_neon (void * ap_data, const float * ap_gains, size_t a_nsamples)
+{
+  int16_t * p_pcm = ap_data;
+  const float32x4_t lo = vdupq_n_f32 (TIZ_PCM_S16_MIN);
+  const float32x4_t hi = vdupq_n_f32 (TIZ_PCM_S16_MAX);
+  size_t i = 0;
+  for (i = 0; i + 8 <= a_nsamples; i += 8)
+    {
+      const int16x8_t in = vld1q_s16 (p_pcm + i);
+      float32x4_t f0 = vcvtq_f32_s32 (vmovl_s16 (vget_low_s16 (in)));
+      float32x4_t f1 = vcvtq_f32_s32 (vmovl_high_s16 (in));
+      f0 = vmulq_f32 (f0, vld1q_f32 (ap_gains + i));
+      f1 = vmulq_f32 (f1, vld1q_f32 (ap_gains + i + 4));
+      f0 = vminnmq_f32 (vmaxnmq_f32 (f0, lo), hi);
+      f1 = vminnmq_f32 (vmaxnmq_f32 (f1, lo), hi);
+      vst1q_s16 (p_pcm + i, vcombine_s16 (vqmovn_s32 (vcvtnq_s32_f32 (f0)),
+                                          vqmovn_s32 (vcvtnq_s32_f32 (f1))));
+    }
+  mul_s16_scalar (p_pcm + i, ap_gains + i, a_nsamples - i);
+}
+
+static void
+mul_s24_neon (void * ap_data, const float * ap_gains, size_t a_nsamples)
+{
+  int32_t * p_pcm = ap_data;
+  const float32x4_t lo = vdupq_n_f32 (TIZ_PCM_S24_MIN);
+  const float32x4_t hi = vdupq_n_f32 (TIZ_PCM_S24_MAX);
+  size_t i = 0;
+  for (i = 0; i + 4 <= a_nsamples; i += 4)
+    {
+      const int32x4_t in = vshrq_n_s32 (vshlq_n_s32 (vld1q_s32 (p_pcm + i), 8),
+                                        8);
+      float32x4_t f = vmulq_f32 (vcvtq_f32_s32 (in), vld1q_f32 (ap_gains + i));
+      f = vminnmq_f32 (vmaxnmq_f32 (f, lo), hi);
+      vst1q_s32 (p_pcm + i, vcvtnq_s32_f32 (f));
+    }
+  mul_s24_scalar (p_pcm + i, ap_gains + i, a_nsamples - i);
+}
+
+static void
+mul_s32_neon (void * ap_data, const float * ap_gains, size_t a_nsamples)
+{
+  int32_t * p_pcm = ap_data;
+  const float64x2_t lo = vdupq_n_f64 (TIZ_PCM_S32_MIN);
+  const float64x2_t hi = vdupq_n_f64 (TIZ_PCM_S32_MAX);
+  size_t i = 0;
+  for (i = 0; i + 4 <= a_nsamples; i += 4)
+    {
+      const int32x4_t in = vld1q_s32 (p_pcm + i);
+      const float32x4_t g = vld1q_f32 (ap_gains + i);
+      float64x2_t d0 = vcvtq_f64_s64 (vmovl_s32 (vget_low_s32 (in)));
+      float64x2_t d1 = vcvtq_f64_s64 (vmovl_high_s32 (in));
+      d0 = vmulq_f64 (d0, vcvt_f64_f32 (vget_low_f32 (g)));
+      d1 = vmulq_f64 (d1, vcvt_high_f64_f32 (g));
+      d0 = vminnmq_f64 (vmaxnmq_f64 (d0, lo), hi);
+      d1 = vminnmq_f64 (vmaxnmq_f64 (d1, lo), hi);
+      vst1q_s32 (p_pcm + i, vcombine_s32 (vmovn_s64 (vcvtnq_s64_f64 (d0)),
+                                          vmovn_s64 (vcvtnq_s64_f64 (d1))));
+    }
+  mul_s32_scalar (p_pcm + i, ap_gains + i, a_nsamples - i);
+}
+
+static void
+mul_flt_neon (void * ap_data, const float * ap_gains, size_t a_nsamples)
+{
+  float * p_pcm = ap_data;
+  size_t i = 0;
+  for (i = 0; i + 4 <= a_nsamples; i += 4)
+    {
+      vst1q_f32 (p_pcm + i,
+                 vmulq_f32 (vld1q_f32 (p_pcm + i), vld1q_f32 (ap_gains + i)));
+    }
+  mul_flt_scalar (p_pcm + i, ap_gains + i, a_nsamples - i);
+}
+
+static void
+swap16_neon (void * ap_data, size_t a_nsamples)
+{
+  uint8_t * p_bytes = ap_data;
+  const size_t nvec = a_nsamples & ~(size_t) 7;
+  size_t i = 0;
+  for (i = 0; i < nvec * 2; i += 16)
+    {
+      vst1q_u8 (p_bytes + i, vrev16q_u8 (vld1q_u8 (p_bytes + i)));
+    }
+  swap16_scalar ((uint16_t *) ap_data + nvec, a_nsamples - nvec);
+}
+
+static void
+swap32_neon (void * ap_data, size_t a_nsamples)
+{
+  uint8_t * p_bytes = ap_data;
+  const size_t nvec = a_nsamples & ~(size_t) 3;
+  size_t i = 0;
+  for (i = 0; i < nvec * 4; i += 16)
+    {
+      vst1q_u8 (p_bytes + i, vrev32q_u8 (vld1q_u8 (p_bytes + i)));
+    }
+  swap32_scalar ((uint32_t *) ap_data + nvec, a_nsamples - nvec);
+}
+
+static void
+from_flt_s16_neon (void * ap_dst, const float * ap_src, size_t a_nsamples)
+{
+  int16_t * p_pcm = ap_dst;
+  const float32x4_t lo = vdupq_n_f32 (TIZ_PCM_S16_MIN);
+  const float32x4_t hi = vdupq_n_f32 (TIZ_PCM_S16_MAX);
+  size_t i = 0;
+  for (i = 0; i + 8 <= a_nsamples; i += 8)
+    {
+      float32x4_t f0 = vmulq_n_f32 (vld1q_f32 (ap_src + i), TIZ_PCM_S16_SCALE);
+      float32x4_t f1
+        = vmulq_n_f32 (vld1q_f32 (ap_src + i + 4), TIZ_PCM_S16_SCALE);
+      f0 = vminnmq_f32 (vmaxnmq_f32 (f0, lo), hi);
+      f1 = vminnmq_f32 (vmaxnmq_f32 (f1, lo), hi);
+      vst1q_s16 (p_pcm + i, vcombine_s16 (vqmovn_s32 (vcvtnq_s32_f32 (f0)),
+                                          vqmovn_s32 (vcvtnq_s32_f32 (f1))));
+    }
+  from_flt_s16_scalar (p_pcm + i, ap_src + i, a_nsamples - i);
+}
+
+static void
+from_flt_s24_neon (void * ap_dst, const float * ap_src, size_t a_nsamples)
+{
+  int32_t * p_pcm = ap_dst;
+  const float32x4_t lo = vdupq_n_f32 (TIZ_PCM_S24_MIN);
+  const float32x4_t hi = vdupq_n_f32 (TIZ_PCM_S24_MAX);
+  size_t i = 0;
+  for (i = 0; i + 4 <= a_nsamples; i += 4)
+    {
+      float32x4_t f = vmulq_n_f32 (vld1q_f32 (ap_src + i), TIZ_PCM_S24_SCALE);
+      f = vminnmq_f32 (vmaxnmq_f32 (f, lo), hi);
+      vst1q_s32 (p_pcm + i, vcvtnq_s32_f32 (f));
+    }
+  from_flt_s24_scalar (p_pcm + i, ap_src + i, a_nsamples - i);
+}
+
+static void
+from_flt_s32_neon (void * ap_dst, const float * ap_src, size_t a_nsamples)
+{
+  int32_t * p_pcm = ap_dst;
+  const float64x2_t lo = vdupq_n_f64 (TIZ_PCM_S32_MIN);
+  const float64x2_t hi = vdupq_n_f64 (TIZ_PCM_S32_MAX);
+  size_t i = 0;
+  for (i = 0; i + 4 <= a_nsamples; i += 4)
+    {
+      const float32x4_t f = vld1q_f32 (ap_src + i);
+      float64x2_t d0
+        = vmulq_n_f64 (vcvt_f64_f32 (vget_low_f32 (f)), TIZ_PCM_S32_SCALE);
+      float64x2_t d1 = vmulq_n_f64 (vcvt_high_f64_f32 (f), TIZ_PCM_S32_SCALE);
+      d0 = vminnmq_f64 (vmaxnmq_f64 (d0, lo), hi);
+      d1 = vminnmq_f64 (vmaxnmq_f64 (d1, lo), hi);
+      vst1q_s32 (p_pcm + i, vcombine_s32 (vmovn_s64 (vcvtnq_s64_f64 (d0)),
+                                          vmovn_s64 (vcvtnq_s64_f64 (d1))));
+    }
+  from_flt_s32_scalar (p_pcm + i, ap_src + i, a_nsamples - i);
+}
+
+static void
+to_flt_s16_neon (float * ap_dst, const void * ap_src, size_t a_nsamples)
+{
+  const int16_t * p_pcm = ap_src;
+  size_t i = 0;
+  for (i = 0; i + 8 <= a_nsamples; i += 8)
+    {
+      const int16x8_t in = vld1q_s16 (p_pcm + i);
+      vst1q_f32 (ap_dst + i,
+                 vmulq_n_f32 (vcvtq_f32_s32 (vmovl_s16 (vget_low_s16 (in))),
+                              1.f / TIZ_PCM_S16_SCALE));
+      vst1q_f32 (ap_dst + i + 4,
+                 vmulq_n_f32 (vcvtq_f32_s32 (vmovl_high_s16 (in)),
+                              1.f / TIZ_PCM_S16_SCALE));
+    }
+  to_flt_s16_scalar (ap_dst + i, p_pcm + i, a_nsamples - i);
+}
+
+static void
+to_flt_s24_neon (float * ap_dst, const void * ap_src, size_t a_nsamples)
+{
+  const int32_t * p_pcm = ap_src;
+  size_t i = 0;
+  for (i = 0; i + 4 <= a_nsamples; i += 4)
+    {
+      const int32x4_t in = vshrq_n_s32 (vshlq_n_s32 (vld1q_s32 (p_pcm + i), 8),
+                                        8);
+      vst1q_f32 (ap_dst + i,
+                 vmulq_n_f32 (vcvtq_f32_s32 (in), 1.f / TIZ_PCM_S24_SCALE));
+    }
+  to_flt_s24_scalar (ap_dst + i, p_pcm + i, a_nsamples - i);
+}
+
+static void
+to_flt_s32_neon (float * ap_dst, const void * ap_src, size_t a_nsamples)
+{
+  const int32_t * p_pcm = ap_src;
+  size_t i = 0;
+  for (i = 0; i + 4 <= a_nsamples; i += 4)
+    {
+      vst1q_f32 (ap_dst + i,
+                 vmulq_n_f32 (vcvtq_f32_s32 (vld1q_s32 (p_pcm + i)),
+                              (float) (1.0 / TIZ_PCM_S32_SCALE)));
+    }
+  to_flt_s32_scalar (ap_dst + i, p_pcm + i, a_nsamples - i);
+}
+
+static void
+fixed_s16_neon (int16_t * ap_dst, const int32_t * ap_src,
+                const int32_t * ap_noise, size_t a_nsamples,
+                unsigned a_frac_bits)
+{
+  const unsigned shift = a_frac_bits - 15;
+  const int32x4_t lo = vdupq_n_s32 (-((int32_t) 1 << a_frac_bits));
+  const int32x4_t hi = vdupq_n_s32 (((int32_t) 1 << a_frac_bits) - 1);
+  const int32x4_t half = vdupq_n_s32 ((int32_t) 1 << (shift - 1));
+  /* A negative count makes vshlq an arithmetic right shift */
+  const int32x4_t count = vdupq_n_s32 (-(int32_t) shift);
+  size_t i = 0;
+  for (i = 0; i + 8 <= a_nsamples; i += 8)
+    {
+      int32x4_t v0 = vminq_s32 (vmaxq_s32 (vld1q_s32 (ap_src + i), lo), hi);
+      int32x4_t v1
+        = vminq_s32 (vmaxq_s32 (vld1q_s32 (ap_src + i + 4), lo), hi);
+      v0 = vaddq_s32 (vaddq_s32 (v0, vld1q_s32 (ap_noise + i)), half);
+      v1 = vaddq_s32 (vaddq_s32 (v1, vld1q_s32 (ap_noise + i + 4)), half);
+      vst1q_s16 (ap_dst + i,
+                 vcombine_s16 (vqmovn_s32 (vshlq_s32 (v0, count)),
+                               vqmovn_s32 (vshlq_s32 (v1, count))));
+    }
+  fixed_s16_scalar (ap_dst + i, ap_src + i, ap_noise + i, a_nsamples - i,
+                    a_frac_bits);
+}
+
+static void
+ilv2_16_neon (void * ap_dst, const void * ap_left, const void * ap_right,
+              size_t a_nframes)
+{
+  int16_t * p_dst = ap_dst;
+  const int16_t * p_left = ap_left;
+  const int16_t * p_right = ap_right;
+  size_t i = 0;
+  for (i = 0; i + 8 <= a_nframes; i += 8)
+    {
+      int16x8x2_t frames;
+      frames.val[0] = vld1q_s16 (p_left + i);
+      frames.val[1] = vld1q_s16 (p_right + i);
+      vst2q_s16 (p_dst + 2 * i, frames);
+    }
+  ilv2_16_scalar (p_dst + 2 * i, p_left + i, p_right + i, a_nframes - i);
+}
+
+static void
+ilv2_32_neon (void * ap_dst, const void * ap_left, const void * ap_right,
+              size_t a_nframes)
+{
+  uint32_t * p_dst = ap_dst;
+  const uint32_t * p_left = ap_left;
+  const uint32_t * p_right = ap_right;
+  size_t i = 0;
+  for (i = 0; i + 4 <= a_nframes; i += 4)
+    {
+      uint32x4x2_t frames;
+      frames.val[0] = vld1q_u32 (p_left + i);
+      frames.val[1] = vld1q_u32 (p_right + i);
+      vst2q_u32 (p_dst + 2 * i, frames);
+    }
+  ilv2_32_scalar (p_dst + 2 * i, p_left + i, p_right + i, a_nframes - i);
+}
+
+static void
+dilv2_16_neon (void * ap_left, void * ap_right, const void * ap_src,
+               size_t a_nframes)
+{
+  int16_t * p_left = ap_left;
+  int16_t * p_right = ap_right;
+  const int16_t * p_src = ap_src;
+  size_t i = 0;
+  for (i = 0; i + 8 <= a_nframes; i += 8)
+    {
+      const int16x8x2_t frames = vld2q_s16 (p_src + 2 * i);
+      vst1q_s16 (p_left + i, frames.val[0]);
+      vst1q_s16 (p_right + i, frames.val[1]);
+    }
+  dilv2_16_scalar (p_left + i, p_right + i, p_src + 2 * i, a_nframes - i);
+}
+
+static void
+dilv2_32_neon (void * ap_left, void * ap_right, const void * ap_src,
+               size_t a_nframes)
+{
+  uint32_t * p_left = ap_left;
+  uint32_t * p_right = ap_right;
+  const uint32_t * p_src = ap_src;
+  size_t i = 0;
+  for (i = 0; i + 4 <= a_nframes; i += 4)
+    {
+      const uint32x4x2_t frames = vld2q_u32 (p_src + 2 * i);
+      vst1q_u32 (p_left + i, frames.val[0]);
+      vst1q_u32 (p_right + i, frames.val[1]);
+    }
+  dilv2_32_scalar (p_left + i, p_right + i, p_src + 2 * i, a_nframes - i);
+}
+
+static const tiz_pcm_ops_t neon_ops = {
+  ETIZPcmIsaNeon,
+  {mul_s16_neon, mul_s24_neon, mul_s24_3_scalar, mul_s32_neon, mul_flt_neon},
+  swap16_neon,
+  swap32_neon,
+  {from_flt_s16_neon, from_flt_s24_neon, from_flt_s24_3_scalar,
+   from_flt_s32_neon, copy_flt},
+  {to_flt_s16_neon, to_flt_s24_neon, to_flt_s24_3_scalar, to_flt_s32_neon,
+   to_flt_flt},
+  fixed_s16_neon,
+  ilv2_16_neon,
+  ilv2_32_neon,
+  dilv2_16_neon,
+  dilv2_32_neon
+};
+
+#endif /* TIZ_PCM_NEON */
+
+/*
+ * Runtime dispatch
+ */
+
+static const tiz_pcm_ops_t * gp_ops = NULL;
+
+static /*@null@ */ const tiz_pcm_ops_t *
+isa_ops (const tiz_pcm_isa_t a_isa)
+{
+  const tiz_pcm_ops_t * p_ops = NULL;
+#ifdef TIZ_PCM_X86
+  __builtin_cpu_init ();
+#endif
+  switch (a_isa)
+    {
+      case ETIZPcmIsaScalar:
+        {
+          p_ops = &scalar_ops;
+        }
+        break;
+#ifdef TIZ_PCM_X86
+      case ETIZPcmIsaSse2:
+        {
+          p_ops = __builtin_cpu_supports ("sse2") ? &sse2_ops : NULL;
+        }
+        break;
+      case ETIZPcmIsaAvx2:
+        {
+          p_ops = __builtin_cpu_supports ("avx2") ? &avx2_ops : NULL;
+        }
+        break;
+#endif
+#ifdef TIZ_PCM_NEON
+      case ETIZPcmIsaNeon:
+        {
+          p_ops = &neon_ops;
+        }
+        break;
+#endif
+      default:
+        break;
+    };
+  return p_ops;
+}
+
+static const tiz_pcm_ops_t *
+get_ops (void)
+{
+  const tiz_pcm_ops_t * p_ops = __atomic_load_n (&gp_ops, __ATOMIC_ACQUIRE);
+  if (!p_ops)
+    {
+      const tiz_pcm_isa_t preferred[]
+        = {ETIZPcmIsaAvx2, ETIZPcmIsaNeon, ETIZPcmIsaSse2, ETIZPcmIsaScalar};
+      size_t i = 0;
+      for (i = 0; !p_ops && i < sizeof (preferred) / sizeof (preferred[0]);
+           ++i)
+        {
+          p_ops = isa_ops (preferred[i]);
+        }
+      assert (p_ops);
+      TIZ_LOG (TIZ_PRIORITY_TRACE, "Using [%s] pcm routines",
+               tiz_pcm_isa_to_str (p_ops->isa));
+      __atomic_store_n (&gp_ops, p_ops, __ATOMIC_RELEASE);
+    }
+  return p_ops;
+}
+
+/*
+ * Public API
+ */
+
+float
+tiz_pcm_db_to_gain (const float a_db)
+{
+  return powf (10.f, a_db / 20.f);
+}
+
+size_t
+tiz_pcm_sample_size (const tiz_pcm_fmt_t a_fmt)
+{
+  size_t size = 0;
+  switch (a_fmt)
+    {
+      case ETIZPcmFmtS16:
+        {
+          size = 2;
+        }
+        break;
+      case ETIZPcmFmtS24_3:
+        {
+          size = 3;
+        }
+        break;
+      case ETIZPcmFmtS24:
+      case ETIZPcmFmtS32:
+      case ETIZPcmFmtFloat:
+        {
+          size = 4;
+        }
+        break;
+      default:
+        break;
+    };
+  return size;
+}
+
+OMX_ERRORTYPE
+tiz_pcm_gain (void * ap_data, const tiz_pcm_fmt_t a_fmt,
+              const size_t a_nsamples, const float a_gain)
+{
+  const size_t sample_size = tiz_pcm_sample_size (a_fmt);
+  float gains[TIZ_PCM_BLOCK_SAMPLES];
+  const tiz_pcm_ops_t * p_ops = NULL;
+  uint8_t * p_pcm = ap_data;
+  size_t done = 0;
+  size_t i = 0;
+
+  if (0 == sample_size)
+    {
+      return OMX_ErrorBadParameter;
+    }
+
+  /* Unity gain is a no-op, except that 24-bit samples in a 32-bit container
+     still need to be sign-extended */
+  if (0 == a_nsamples || (1.f == a_gain && ETIZPcmFmtS24 != a_fmt))
+    {
+      return OMX_ErrorNone;
+    }
+
+  assert (ap_data);
+  p_ops = get_ops ();
+
+  for (i = 0; i < MIN (a_nsamples, TIZ_PCM_BLOCK_SAMPLES); ++i)
+    {
+      gains[i] = a_gain;
+    }
+
+  while (done < a_nsamples)
+    {
+      const size_t count = MIN (a_nsamples - done, TIZ_PCM_BLOCK_SAMPLES);
+      p_ops->pf_mul[a_fmt](p_pcm + done * sample_size, gains, count);
+      done += count;
+    }
+
+  return OMX_ErrorNone;
+}
+
+OMX_ERRORTYPE
+tiz_pcm_ramp (void * ap_data, const tiz_pcm_fmt_t a_fmt,
+              const size_t a_nframes, const OMX_U32 a_nchannels,
+              const float a_start, const float a_step)
+{
+  const size_t sample_size = tiz_pcm_sample_size (a_fmt);
+  float gains[TIZ_PCM_BLOCK_SAMPLES];
+  const tiz_pcm_ops_t * p_ops = NULL;
+  uint8_t * p_pcm = ap_data;
+  size_t block_frames = 0;
+  size_t done = 0;
+
+  if (0 == sample_size || 0 == a_nchannels
+      || a_nchannels > TIZ_PCM_BLOCK_SAMPLES)
+    {
+      return OMX_ErrorBadParameter;
+    }
+
+  if (0 == a_nframes)
+    {
+      return OMX_ErrorNone;
+    }
+
+  assert (ap_data);
+  p_ops = get_ops ();
+  block_frames = TIZ_PCM_BLOCK_SAMPLES / a_nchannels;
+
+  while (done < a_nframes)
+    {
+      const size_t count = MIN (a_nframes - done, block_frames);
+      size_t i = 0;
+      size_t n = 0;
+      for (i = 0; i < count; ++i)
+        {
+          const float gain = a_start + (float) (done + i) * a_step;
+          OMX_U32 c = 0;
+          for (c = 0; c < a_nchannels; ++c)
+            {
+              gains[n++] = gain;
+            }
+        }
+      p_ops->pf_mul[a_fmt](p_pcm + done * a_nchannels * sample_size, gains,
+                           n);
+      done += count;
+    }
+
+  return OMX_ErrorNone;
+}
+
+OMX_ERRORTYPE
+tiz_pcm_swap (void * ap_data, const size_t a_width, const size_t a_nsamples)
+{
+  const tiz_pcm_ops_t * p_ops = NULL;
+
+  if (a_width < 2 || a_width > 4)
+    {
+      return OMX_ErrorBadParameter;
+    }
+
+  if (0 == a_nsamples)
+    {
+      return OMX_ErrorNone;
+    }
+
+  assert (ap_data);
+  p_ops = get_ops ();
+
+  switch (a_width)
+    {
+      case 2:
+        {
+          p_ops->pf_swap16 (ap_data, a_nsamples);
+        }
+        break;
+      case 3:
+        {
+          swap24_scalar (ap_data, a_nsamples);
+        }
+        break;
+      default:
+        {
+          p_ops->pf_swap32 (ap_data, a_nsamples);
+        }
+        break;
+    };
+
+  return OMX_ErrorNone;
+}
+
+OMX_ERRORTYPE
+tiz_pcm_from_float (void * ap_dst, const tiz_pcm_fmt_t a_fmt,
+                    const float * ap_src, const size_t a_nsamples)
+{
+  if (0 == tiz_pcm_sample_size (a_fmt))
+    {
+      return OMX_ErrorBadParameter;
+    }
+
+  if (0 == a_nsamples)
+    {
+      return OMX_ErrorNone;
+    }
+
+  assert (ap_dst);
+  assert (ap_src);
+  get_ops ()->pf_from_flt[a_fmt](ap_dst, ap_src, a_nsamples);
+  return OMX_ErrorNone;
+}
+
+OMX_ERRORTYPE
+tiz_pcm_to_float (float * ap_dst, const void * ap_src,
+                  const tiz_pcm_fmt_t a_fmt, const size_t a_nsamples)
+{
+  if (0 == tiz_pcm_sample_size (a_fmt))
+    {
+      return OMX_ErrorBadParameter;
+    }
+
+  if (0 == a_nsamples)
+    {
+      return OMX_ErrorNone;
+    }
+
+  assert (ap_dst);
+  assert (ap_src);
+  get_ops ()->pf_to_flt[a_fmt](ap_dst, ap_src, a_nsamples);
+  return OMX_ErrorNone;
+}
+
+void
+tiz_pcm_dither_init (tiz_pcm_dither_t * ap_dither, const uint32_t a_seed)
+{
+  assert (ap_dither);
+  ap_dither->state = a_seed;
+}
+
+static inline uint32_t
+dither_next (tiz_pcm_dither_t * ap_dither)
+{
+  ap_dither->state = ap_dither->state * 1664525u + 1013904223u;
+  return ap_dither->state;
+}
+
+OMX_ERRORTYPE
+tiz_pcm_fixed_to_s16 (int16_t * ap_dst, const int32_t * ap_src,
+                      const size_t a_nsamples, const OMX_U32 a_frac_bits,
+                      tiz_pcm_dither_t * ap_dither)
+{
+  int32_t noise[TIZ_PCM_BLOCK_SAMPLES];
+  const tiz_pcm_ops_t * p_ops = NULL;
+  size_t done = 0;
+
+  if (a_frac_bits < TIZ_PCM_FIXED_MIN_FRAC_BITS
+      || a_frac_bits > TIZ_PCM_FIXED_MAX_FRAC_BITS)
+    {
+      return OMX_ErrorBadParameter;
+    }
+
+  if (0 == a_nsamples)
+    {
+      return OMX_ErrorNone;
+    }
+
+  assert (ap_dst);
+  assert (ap_src);
+  p_ops = get_ops ();
+
+  if (!ap_dither)
+    {
+      memset (noise, 0, sizeof (int32_t) * MIN (a_nsamples,
+                                                TIZ_PCM_BLOCK_SAMPLES));
+    }
+
+  while (done < a_nsamples)
+    {
+      const size_t count = MIN (a_nsamples - done, TIZ_PCM_BLOCK_SAMPLES);
+      if (ap_dither)
+        {
+          /* The difference of two uniform values in [0, 1 LSB) of the
+             output has a triangular distribution over (-1 LSB, 1 LSB) */
+          const unsigned bits = 32 - (a_frac_bits - 15);
+          size_t i = 0;
+          for (i = 0; i < count; ++i)
+            {
+              const int32_t r1 = (int32_t) (dither_next (ap_dither) >> bits);
+              const int32_t r2 = (int32_t) (dither_next (ap_dither) >> bits);
+              noise[i] = r1 - r2;
+            }
+        }
+      p_ops->pf_fixed_s16 (ap_dst + done, ap_src + done, noise, count,
+                           a_frac_bits);
+      done += count;
+    }
+
+  return OMX_ErrorNone;
+}
+
+OMX_ERRORTYPE
+tiz_pcm_interleave (void * ap_dst, const void * const * app_src,
+                    const size_t a_width, const OMX_U32 a_nchannels,
+                    const size_t a_nframes)
+{
+  if (0 == a_width || a_width > 8 || 0 == a_nchannels)
+    {
+      return OMX_ErrorBadParameter;
+    }
+
+  if (0 == a_nframes)
+    {
+      return OMX_ErrorNone;
+    }
+
+  assert (ap_dst);
+  assert (app_src);
+
+  if (2 == a_nchannels && 2 == a_width)
+    {
+      get_ops ()->pf_ilv2_16 (ap_dst, app_src[0], app_src[1], a_nframes);
+    }
+  else if (2 == a_nchannels && 4 == a_width)
+    {
+      get_ops ()->pf_ilv2_32 (ap_dst, app_src[0], app_src[1], a_nframes);
+    }
+  else if (1 == a_nchannels)
+    {
+      memmove (ap_dst, app_src[0], a_width * a_nframes);
+    }
+  else
+    {
+      interleave_scalar (ap_dst, app_src, a_width, a_nchannels, a_nframes);
+    }
+
+  return OMX_ErrorNone;
+}
+
+OMX_ERRORTYPE
+tiz_pcm_deinterleave (void * const * app_dst, const void * ap_src,
+                      const size_t a_width, const OMX_U32 a_nchannels,
+                      const size_t a_nframes)
+{
+  if (0 == a_width || a_width > 8 || 0 == a_nchannels)
+    {
+      return OMX_ErrorBadParameter;
+    }
+
+  if (0 == a_nframes)
+    {
+      return OMX_ErrorNone;
+    }
+
+  assert (app_dst);
+  assert (ap_src);
+
+  if (2 == a_nchannels && 2 == a_width)
+    {
+      get_ops ()->pf_dilv2_16 (app_dst[0], app_dst[1], ap_src, a_nframes);
+    }
+  else if (2 == a_nchannels && 4 == a_width)
+    {
+      get_ops ()->pf_dilv2_32 (app_dst[0], app_dst[1], ap_src, a_nframes);
+    }
+  else if (1 == a_nchannels)
+    {
+      memmove (app_dst[0], ap_src, a_width * a_nframes);
+    }
+  else
+    {
+      deinterleave_scalar (app_dst, ap_src, a_width, a_nchannels, a_nframes);
+    }
+
+  return OMX_ErrorNone;
+}
+
+tiz_pcm_isa_t
+tiz_pcm_get_isa (void)
+{
+  return get_ops ()->isa;
+}
+
+OMX_ERRORTYPE
+tiz_pcm_set_isa (const tiz_pcm_isa_t a_isa)
+{
+  const tiz_pcm_ops_t * p_ops = isa_ops (a_isa);
+  if (!p_ops)
+    {
+      return OMX_ErrorUnsupportedSetting;
+    }
+  __atomic_store_n (&gp_ops, p_ops, __ATOMIC_RELEASE);
+  return OMX_ErrorNone;
+}
+
+OMX_STRING
+tiz_pcm_isa_to_str (const tiz_pcm_isa_t a_isa)
+{
+  switch (a_isa)
+    {
+      case ETIZPcmIsaScalar:
+        return (OMX_STRING) "Scalar";
+      case ETIZPcmIsaSse2:
+        return (OMX_STRING) "SSE2";
+      case ETIZPcmIsaAvx2:
+        return (OMX_STRING) "AVX2";
+      case ETIZPcmIsaNeon:
+        return (OMX_STRING) "NEON";
+      default:
+        break;
+    };
+  return (OMX_STRING) "Unknown";
+}
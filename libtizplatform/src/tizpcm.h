@@ -0,0 +1,323 @@
+/**
+ * Copyright (C) 2011-2017 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   tizpcm.h
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  PCM sample processing utilities
+ *
+ *
+ */
+
+#ifndef TIZPCM_H
+#define TIZPCM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup tizpcm PCM sample processing utilities
+ *
+ * In-place gain, volume ramps and byte order swaps on interleaved PCM
+ * buffers, plus the sample format conversions, (de)interleaving and dithered
+ * fixed-point requantization that the decoders need. Each operation has a
+ * portable scalar implementation plus SSE2 and AVX2 (x86) or NEON (aarch64)
+ * variants that are selected at runtime according to the capabilities of
+ * the CPU. All variants produce bit-exact results: integer samples are
+ * scaled in floating point (double precision for 32-bit samples), clamped to
+ * the range of the format and rounded to the nearest integer, ties to even.
+ *
+ * Samples are expected in host byte order by all functions except
+ * tiz_pcm_swap.
+ *
+ * @ingroup libtizplatform
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <OMX_Core.h>
+#include <OMX_Types.h>
+
+/**
+ * Sample formats.
+ * @ingroup tizpcm
+ */
+typedef enum tiz_pcm_fmt {
+  ETIZPcmFmtS16,   /**< Signed 16-bit */
+  ETIZPcmFmtS24,   /**< Signed 24-bit, in the low three bytes of a 32-bit
+                        container */
+  ETIZPcmFmtS24_3, /**< Signed 24-bit, packed in three bytes */
+  ETIZPcmFmtS32,   /**< Signed 32-bit */
+  ETIZPcmFmtFloat, /**< 32-bit float, nominally in the [-1.0, 1.0] range */
+  ETIZPcmFmtMax
+} tiz_pcm_fmt_t;
+
+/**
+ * Instruction set variants.
+ * @ingroup tizpcm
+ */
+typedef enum tiz_pcm_isa {
+  ETIZPcmIsaScalar, /**< Portable C implementation */
+  ETIZPcmIsaSse2,   /**< x86 SSE2 */
+  ETIZPcmIsaAvx2,   /**< x86 AVX2 */
+  ETIZPcmIsaNeon,   /**< aarch64 Advanced SIMD */
+  ETIZPcmIsaMax
+} tiz_pcm_isa_t;
+
+/**
+ * State of the TPDF dither generator used by tiz_pcm_fixed_to_s16. Each
+ * stream should use its own instance.
+ * @ingroup tizpcm
+ */
+typedef struct tiz_pcm_dither tiz_pcm_dither_t;
+struct tiz_pcm_dither
+{
+  uint32_t state;
+};
+
+/**
+ * Convert a gain expressed in decibels into a linear amplitude factor.
+ *
+ * @ingroup tizpcm
+ *
+ * @param a_db The gain in dB.
+ *
+ * @return The linear gain factor (e.g. 1.0 for 0 dB).
+ */
+float tiz_pcm_db_to_gain (const float a_db);
+
+/**
+ * Return the size in bytes of a sample of the given format.
+ *
+ * @ingroup tizpcm
+ *
+ * @param a_fmt The sample format.
+ *
+ * @return The sample size, or 0 if the format is not valid.
+ */
+size_t tiz_pcm_sample_size (const tiz_pcm_fmt_t a_fmt);
+
+/**
+ * Multiply every sample in a buffer by a constant gain. Integer samples are
+ * saturated to the range of the format.
+ *
+ * @ingroup tizpcm
+ *
+ * @param ap_data The PCM samples (host byte order).
+ * @param a_fmt The sample format.
+ * @param a_nsamples The number of samples (i.e. frames times channels).
+ * @param a_gain The linear gain factor.
+ *
+ * @return OMX_ErrorNone on success, OMX_ErrorBadParameter if the format is
+ * not valid.
+ */
+OMX_ERRORTYPE tiz_pcm_gain (void * ap_data, const tiz_pcm_fmt_t a_fmt,
+                            const size_t a_nsamples, const float a_gain);
+
+/**
+ * Apply a linear volume ramp to a buffer of interleaved frames. All the
+ * samples in frame 'n' are multiplied by 'a_start + n * a_step', so a ramp
+ * that spans several buffers can be continued by passing
+ * 'a_start + a_nframes * a_step' in the next call.
+ *
+ * @ingroup tizpcm
+ *
+ * @param ap_data The PCM samples (host byte order).
+ * @param a_fmt The sample format.
+ * @param a_nframes The number of frames.
+ * @param a_nchannels The number of interleaved channels.
+ * @param a_start The gain of the first frame.
+ * @param a_step The per-frame gain increment (may be negative).
+ *
+ * @return OMX_ErrorNone on success, OMX_ErrorBadParameter if the format or
+ * the number of channels are not valid.
+ */
+OMX_ERRORTYPE tiz_pcm_ramp (void * ap_data, const tiz_pcm_fmt_t a_fmt,
+                            const size_t a_nframes, const OMX_U32 a_nchannels,
+                            const float a_start, const float a_step);
+
+/**
+ * Reverse the byte order of every sample in a buffer.
+ *
+ * @ingroup tizpcm
+ *
+ * @param ap_data The PCM samples.
+ * @param a_width The sample size in bytes (2, 3 or 4).
+ * @param a_nsamples The number of samples.
+ *
+ * @return OMX_ErrorNone on success, OMX_ErrorBadParameter if the sample size
+ * is not supported.
+ */
+OMX_ERRORTYPE tiz_pcm_swap (void * ap_data, const size_t a_width,
+                            const size_t a_nsamples);
+
+/**
+ * Convert floating point samples, nominally in the [-1.0, 1.0] range, to
+ * another format. Out-of-range values are saturated; 1.0 maps to the largest
+ * positive value of the format.
+ *
+ * @ingroup tizpcm
+ *
+ * @param ap_dst The destination buffer (host byte order).
+ * @param a_fmt The destination sample format.
+ * @param ap_src The floating point samples.
+ * @param a_nsamples The number of samples.
+ *
+ * @return OMX_ErrorNone on success, OMX_ErrorBadParameter if the format is
+ * not valid.
+ */
+OMX_ERRORTYPE tiz_pcm_from_float (void * ap_dst, const tiz_pcm_fmt_t a_fmt,
+                                  const float * ap_src,
+                                  const size_t a_nsamples);
+
+/**
+ * Convert samples of any format to floating point, in the [-1.0, 1.0)
+ * range.
+ *
+ * @ingroup tizpcm
+ *
+ * @param ap_dst The destination buffer.
+ * @param ap_src The source samples (host byte order).
+ * @param a_fmt The source sample format.
+ * @param a_nsamples The number of samples.
+ *
+ * @return OMX_ErrorNone on success, OMX_ErrorBadParameter if the format is
+ * not valid.
+ */
+OMX_ERRORTYPE tiz_pcm_to_float (float * ap_dst, const void * ap_src,
+                                const tiz_pcm_fmt_t a_fmt,
+                                const size_t a_nsamples);
+
+/**
+ * Initialise a dither generator.
+ *
+ * @ingroup tizpcm
+ *
+ * @param ap_dither The dither generator.
+ * @param a_seed The initial state.
+ */
+void tiz_pcm_dither_init (tiz_pcm_dither_t * ap_dither,
+                          const uint32_t a_seed);
+
+/**
+ * Requantize fixed-point samples (e.g. libmad's mad_fixed_t) to signed
+ * 16-bit. Samples are clipped to [-1.0, 1.0), rounded to the nearest
+ * integer and, if a dither generator is given, triangular (TPDF) noise of
+ * +/-1 LSB is added before the rounding.
+ *
+ * @ingroup tizpcm
+ *
+ * @param ap_dst The destination buffer.
+ * @param ap_src The fixed-point samples.
+ * @param a_nsamples The number of samples.
+ * @param a_frac_bits The number of fractional bits in the source samples
+ * (16 to 30).
+ * @param ap_dither The dither generator, or NULL for plain rounding.
+ *
+ * @return OMX_ErrorNone on success, OMX_ErrorBadParameter if the number of
+ * fractional bits is not supported.
+ */
+OMX_ERRORTYPE tiz_pcm_fixed_to_s16 (int16_t * ap_dst, const int32_t * ap_src,
+                                    const size_t a_nsamples,
+                                    const OMX_U32 a_frac_bits,
+                                    tiz_pcm_dither_t * ap_dither);
+
+/**
+ * Interleave a number of planar channel buffers into a buffer of frames.
+ * The same source buffer may be passed for several channels (e.g. to
+ * upmix a mono stream).
+ *
+ * @ingroup tizpcm
+ *
+ * @param ap_dst The destination buffer.
+ * @param app_src An array of 'a_nchannels' pointers to the planar samples.
+ * @param a_width The sample size in bytes (1 to 8).
+ * @param a_nchannels The number of channels.
+ * @param a_nframes The number of frames.
+ *
+ * @return OMX_ErrorNone on success, OMX_ErrorBadParameter if the sample size
+ * or the number of channels are not valid.
+ */
+OMX_ERRORTYPE tiz_pcm_interleave (void * ap_dst, const void * const * app_src,
+                                  const size_t a_width,
+                                  const OMX_U32 a_nchannels,
+                                  const size_t a_nframes);
+
+/**
+ * Split a buffer of interleaved frames into planar channel buffers.
+ *
+ * @ingroup tizpcm
+ *
+ * @param app_dst An array of 'a_nchannels' pointers to the planar buffers.
+ * @param ap_src The interleaved samples.
+ * @param a_width The sample size in bytes (1 to 8).
+ * @param a_nchannels The number of channels.
+ * @param a_nframes The number of frames.
+ *
+ * @return OMX_ErrorNone on success, OMX_ErrorBadParameter if the sample size
+ * or the number of channels are not valid.
+ */
+OMX_ERRORTYPE tiz_pcm_deinterleave (void * const * app_dst,
+                                    const void * ap_src, const size_t a_width,
+                                    const OMX_U32 a_nchannels,
+                                    const size_t a_nframes);
+
+/**
+ * Retrieve the instruction set variant currently in use. Unless overridden
+ * with tiz_pcm_set_isa, this is the best variant supported by the CPU.
+ *
+ * @ingroup tizpcm
+ *
+ * @return The instruction set variant.
+ */
+tiz_pcm_isa_t tiz_pcm_get_isa (void);
+
+/**
+ * Force a particular instruction set variant. Mostly useful for testing and
+ * benchmarking.
+ *
+ * @ingroup tizpcm
+ *
+ * @param a_isa The instruction set variant.
+ *
+ * @return OMX_ErrorNone on success, OMX_ErrorUnsupportedSetting if the
+ * variant is not available on this CPU.
+ */
+OMX_ERRORTYPE tiz_pcm_set_isa (const tiz_pcm_isa_t a_isa);
+
+/**
+ * Return a printable name for an instruction set variant.
+ *
+ * @ingroup tizpcm
+ *
+ * @param a_isa The instruction set variant.
+ *
+ * @return A null-terminated string.
+ */
+/*@observer@ */ OMX_STRING
+tiz_pcm_isa_to_str (const tiz_pcm_isa_t a_isa);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TIZPCM_H */
@@ -30,6 +30,8 @@
 #include <config.h>
 #endif
 
+#include "tizbufpool.h"
+
 /* #include "tizlog.h" */
 /* #include "tizev.h" */
 
@@ -45,4 +47,5 @@ void __attribute__ ((destructor)) tiz_platform_unload (void)
 {
   /*   (void) tiz_event_loop_destroy (); */
   /*   tiz_log_deinit (); */
+  tiz_bufpool_trim ();
 }
@@ -42,6 +42,7 @@
 #include "tizqueue.h"
 #include "tizpqueue.h"
 #include "tizbuffer.h"
+#include "tizbufpool.h"
 #include "tizvector.h"
 #include "tizsync.h"
 #include "tizthread.h"
@@ -56,6 +57,7 @@
 #include "tizprintf.h"
 #include "tizshufflelst.h"
 #include "tizurltransfer.h"
+#include "tizpcm.h"
 
 /** @} */
 
@@ -34,6 +34,11 @@
 
 #include <assert.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
 
 #ifdef TIZ_LOG_CATEGORY_NAME
 #undef TIZ_LOG_CATEGORY_NAME
@@ -63,6 +68,8 @@
     }                                                                       \
   while (0)
 
+#define TIZ_Q_CACHE_LINE_SIZE 64
+
 typedef struct tiz_queue_item tiz_queue_item_t;
 struct tiz_queue_item
 {
@@ -70,15 +77,42 @@ struct tiz_queue_item
   tiz_queue_item_t * p_next;
 };
 
+/* A slot of the lock-free ring. 'seq' is only used in MPSC mode: it tells a
+   producer whether the slot is free for position 'pos' (seq == pos) and the
+   consumer whether it has been published (seq == pos + 1). */
+typedef struct tiz_queue_cell tiz_queue_cell_t;
+struct tiz_queue_cell
+{
+  uint64_t seq;
+  OMX_PTR p_data;
+};
+
 struct tiz_queue
 {
+  tiz_queue_mode_t mode;
+  OMX_S32 capacity;
+  /* Locking mode */
   /*@null@ */ tiz_queue_item_t * p_first;
   /*@null@ */ tiz_queue_item_t * p_last;
-  OMX_S32 capacity;
   OMX_S32 length;
   tiz_mutex_t mutex;
   tiz_cond_t cond_full;
   tiz_cond_t cond_empty;
+  /* Lock-free modes */
+  /*@null@ */ tiz_queue_cell_t * p_cells;
+  uint64_t mask; /* capacity - 1 when the capacity is a power of two */
+  /* The producer and consumer positions, and the futex words the consumer and
+     the producers block on, live in separate cache lines. */
+  char pad0[TIZ_Q_CACHE_LINE_SIZE];
+  uint64_t tail; /* next position to be written by a producer */
+  char pad1[TIZ_Q_CACHE_LINE_SIZE];
+  uint64_t head; /* next position to be read by the consumer */
+  char pad2[TIZ_Q_CACHE_LINE_SIZE];
+  uint32_t not_empty;
+  uint32_t empty_waiters;
+  char pad3[TIZ_Q_CACHE_LINE_SIZE];
+  uint32_t not_full;
+  uint32_t full_waiters;
 };
 
 static inline void
@@ -87,13 +121,249 @@ deinit_queue_struct (/*@null@ */ tiz_queue_t * ap_q)
   /* Clean-up */
   if (ap_q)
     {
-      (void) tiz_cond_destroy (&(ap_q->cond_empty));
-      (void) tiz_cond_destroy (&(ap_q->cond_full));
-      (void) tiz_mutex_destroy (&(ap_q->mutex));
+      if (ETIZQueueModeLocking == ap_q->mode)
+        {
+          (void) tiz_cond_destroy (&(ap_q->cond_empty));
+          (void) tiz_cond_destroy (&(ap_q->cond_full));
+          (void) tiz_mutex_destroy (&(ap_q->mutex));
+        }
+      tiz_mem_free (ap_q->p_cells);
       tiz_mem_free (ap_q);
     }
 }
 
+static inline void
+lf_futex_wait (uint32_t * ap_word, const uint32_t a_expected)
+{
+  /* EAGAIN, EINTR and spurious wake-ups are handled by the caller's loop */
+  (void) syscall (SYS_futex, ap_word, FUTEX_WAIT_PRIVATE, a_expected, NULL,
+                  NULL, 0);
+}
+
+static inline void
+lf_futex_wake (uint32_t * ap_word, const int a_nwaiters)
+{
+  (void) syscall (SYS_futex, ap_word, FUTEX_WAKE_PRIVATE, a_nwaiters, NULL,
+                  NULL, 0);
+}
+
+static inline tiz_queue_cell_t *
+lf_cell (const tiz_queue_t * ap_q, const uint64_t a_pos)
+{
+  return &(ap_q->p_cells[ap_q->mask ? (a_pos & ap_q->mask)
+                                    : (a_pos % (uint64_t) ap_q->capacity)]);
+}
+
+static bool
+lf_try_push (tiz_queue_t * ap_q, OMX_PTR ap_data)
+{
+  uint64_t pos = __atomic_load_n (&(ap_q->tail), __ATOMIC_RELAXED);
+  tiz_queue_cell_t * p_cell = NULL;
+
+  if (ETIZQueueModeLockFreeSpsc == ap_q->mode)
+    {
+      if (pos - __atomic_load_n (&(ap_q->head), __ATOMIC_ACQUIRE)
+          >= (uint64_t) ap_q->capacity)
+        {
+          return false;
+        }
+      lf_cell (ap_q, pos)->p_data = ap_data;
+      __atomic_store_n (&(ap_q->tail), pos + 1, __ATOMIC_RELEASE);
+      return true;
+    }
+
+  for (;;)
+    {
+      int64_t diff = 0;
+      p_cell = lf_cell (ap_q, pos);
+      diff = (int64_t) (__atomic_load_n (&(p_cell->seq), __ATOMIC_ACQUIRE)
+                        - pos);
+      if (0 == diff)
+        {
+          if (__atomic_compare_exchange_n (&(ap_q->tail), &pos, pos + 1, true,
+                                           __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            {
+              break;
+            }
+          /* 'pos' has been reloaded by the failed exchange */
+        }
+      else if (diff < 0)
+        {
+          /* The consumer has not released this slot yet: the queue is full */
+          return false;
+        }
+      else
+        {
+          pos = __atomic_load_n (&(ap_q->tail), __ATOMIC_RELAXED);
+        }
+    }
+
+  p_cell->p_data = ap_data;
+  __atomic_store_n (&(p_cell->seq), pos + 1, __ATOMIC_RELEASE);
+  return true;
+}
+
+static bool
+lf_try_pop (tiz_queue_t * ap_q, OMX_PTR * app_data)
+{
+  const uint64_t pos = __atomic_load_n (&(ap_q->head), __ATOMIC_RELAXED);
+  tiz_queue_cell_t * p_cell = lf_cell (ap_q, pos);
+
+  if (ETIZQueueModeLockFreeSpsc == ap_q->mode)
+    {
+      if (__atomic_load_n (&(ap_q->tail), __ATOMIC_ACQUIRE) == pos)
+        {
+          return false;
+        }
+    }
+  else if (__atomic_load_n (&(p_cell->seq), __ATOMIC_ACQUIRE) != pos + 1)
+    {
+      return false;
+    }
+
+  *app_data = p_cell->p_data;
+  p_cell->p_data = NULL;
+  if (ETIZQueueModeLockFreeMpsc == ap_q->mode)
+    {
+      __atomic_store_n (&(p_cell->seq), pos + ap_q->capacity,
+                        __ATOMIC_RELEASE);
+    }
+  __atomic_store_n (&(ap_q->head), pos + 1, __ATOMIC_RELEASE);
+  return true;
+}
+
+/* Wakes up the threads blocked on 'ap_word', if any. The full fence orders
+   the preceding push or pop with respect to the load of the waiter count
+   (the waiting side increments that count before re-checking the queue). */
+static inline void
+lf_signal (uint32_t * ap_word, uint32_t * ap_waiters, const int a_nwaiters)
+{
+  __atomic_thread_fence (__ATOMIC_SEQ_CST);
+  if (__atomic_load_n (ap_waiters, __ATOMIC_RELAXED) > 0)
+    {
+      (void) __atomic_add_fetch (ap_word, 1, __ATOMIC_RELEASE);
+      lf_futex_wake (ap_word, a_nwaiters);
+    }
+}
+
+static OMX_ERRORTYPE
+lf_send (tiz_queue_t * ap_q, OMX_PTR ap_data)
+{
+  assert (ap_q);
+  assert (ap_data);
+
+  while (!lf_try_push (ap_q, ap_data))
+    {
+      const uint32_t word = __atomic_load_n (&(ap_q->not_full),
+                                             __ATOMIC_ACQUIRE);
+      (void) __atomic_add_fetch (&(ap_q->full_waiters), 1, __ATOMIC_SEQ_CST);
+      __atomic_thread_fence (__ATOMIC_SEQ_CST);
+      if (lf_try_push (ap_q, ap_data))
+        {
+          (void) __atomic_sub_fetch (&(ap_q->full_waiters), 1,
+                                     __ATOMIC_SEQ_CST);
+          break;
+        }
+      lf_futex_wait (&(ap_q->not_full), word);
+      (void) __atomic_sub_fetch (&(ap_q->full_waiters), 1, __ATOMIC_SEQ_CST);
+    }
+
+  /* There is only one consumer */
+  lf_signal (&(ap_q->not_empty), &(ap_q->empty_waiters), 1);
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+lf_receive_batch (tiz_queue_t * ap_q, OMX_PTR * app_data, OMX_S32 a_max,
+                  OMX_S32 * ap_count)
+{
+  OMX_S32 count = 1;
+
+  assert (ap_q);
+  assert (app_data);
+  assert (a_max > 0);
+  assert (ap_count);
+
+  while (!lf_try_pop (ap_q, &(app_data[0])))
+    {
+      const uint32_t word = __atomic_load_n (&(ap_q->not_empty),
+                                             __ATOMIC_ACQUIRE);
+      (void) __atomic_add_fetch (&(ap_q->empty_waiters), 1, __ATOMIC_SEQ_CST);
+      __atomic_thread_fence (__ATOMIC_SEQ_CST);
+      if (lf_try_pop (ap_q, &(app_data[0])))
+        {
+          (void) __atomic_sub_fetch (&(ap_q->empty_waiters), 1,
+                                     __ATOMIC_SEQ_CST);
+          break;
+        }
+      lf_futex_wait (&(ap_q->not_empty), word);
+      (void) __atomic_sub_fetch (&(ap_q->empty_waiters), 1, __ATOMIC_SEQ_CST);
+    }
+
+  while (count < a_max && lf_try_pop (ap_q, &(app_data[count])))
+    {
+      ++count;
+    }
+
+  *ap_count = count;
+
+  /* Several producers may be waiting for a free slot */
+  lf_signal (&(ap_q->not_full), &(ap_q->full_waiters), INT_MAX);
+  return OMX_ErrorNone;
+}
+
+static OMX_S32
+lf_length (tiz_queue_t * ap_q)
+{
+  const uint64_t head = __atomic_load_n (&(ap_q->head), __ATOMIC_ACQUIRE);
+  const uint64_t tail = __atomic_load_n (&(ap_q->tail), __ATOMIC_ACQUIRE);
+  /* In MPSC mode, 'tail' counts slots that have been claimed but perhaps not
+     published yet */
+  return (OMX_S32) MIN (tail - head, (uint64_t) ap_q->capacity);
+}
+
+static OMX_ERRORTYPE
+lf_init (tiz_queue_ptr_t * app_q, OMX_S32 a_capacity, tiz_queue_mode_t a_mode)
+{
+  tiz_queue_t * p_q = NULL;
+  OMX_S32 i = 0;
+
+  assert (app_q);
+
+  p_q = (tiz_queue_t *) tiz_mem_calloc (1, sizeof (tiz_queue_t));
+  if (p_q)
+    {
+      p_q->mode = a_mode;
+      p_q->capacity = a_capacity;
+      p_q->p_cells = (tiz_queue_cell_t *) tiz_mem_calloc (
+        a_capacity, sizeof (tiz_queue_cell_t));
+    }
+
+  if (!p_q || !p_q->p_cells)
+    {
+      TIZ_LOG (TIZ_PRIORITY_ERROR,
+               "OMX_ErrorInsufficientResources: "
+               "Could not instantiate lock-free queue.");
+      deinit_queue_struct (p_q);
+      return OMX_ErrorInsufficientResources;
+    }
+
+  if (0 == (a_capacity & (a_capacity - 1)))
+    {
+      p_q->mask = (uint64_t) a_capacity - 1;
+    }
+
+  for (i = 0; i < a_capacity; ++i)
+    {
+      p_q->p_cells[i].seq = (uint64_t) i;
+    }
+
+  TIZ_LOG (TIZ_PRIORITY_TRACE, "lock-free queue created [%p] mode [%d]", p_q,
+           a_mode);
+  *app_q = p_q;
+  return OMX_ErrorNone;
+}
+
 /*@null@*/ static tiz_queue_t *
 init_queue_struct (void)
 {
@@ -122,6 +392,21 @@ end:
   return p_q;
 }
 
+OMX_ERRORTYPE
+tiz_queue_init_with_mode (tiz_queue_ptr_t * app_q, OMX_S32 a_capacity,
+                          tiz_queue_mode_t a_mode)
+{
+  assert (app_q);
+  assert (a_capacity > 0);
+  assert (a_mode < ETIZQueueModeMax);
+
+  if (ETIZQueueModeLocking == a_mode)
+    {
+      return tiz_queue_init (app_q, a_capacity);
+    }
+  return lf_init (app_q, a_capacity, a_mode);
+}
+
 OMX_ERRORTYPE
 tiz_queue_init (tiz_queue_ptr_t * app_q, OMX_S32 a_capacity)
 {
@@ -208,7 +493,9 @@ tiz_queue_destroy (/*@null@ */ tiz_queue_t * p_q)
       tiz_queue_item_t * p_cur_item = 0;
       int i = 0;
 
-      for (i = 0; p_q->p_first && i < (p_q->capacity - 1); ++i)
+      for (i = 0; ETIZQueueModeLocking == p_q->mode && p_q->p_first
+                  && i < (p_q->capacity - 1);
+           ++i)
         {
           p_cur_item = p_q->p_first->p_next;
           tiz_mem_free (p_q->p_first);
@@ -226,10 +513,14 @@ tiz_queue_send (tiz_queue_t * p_q, OMX_PTR ap_data)
 
   assert (p_q);
 
+  if (ETIZQueueModeLocking != p_q->mode)
+    {
+      return lf_send (p_q, ap_data);
+    }
+
   tiz_check_omx_ret_oom (tiz_mutex_lock (&(p_q->mutex)));
 
   assert (p_q->p_last);
-  assert (NULL == (p_q->p_last->p_data));
   assert (p_q->length <= p_q->capacity);
 
   while (p_q->length == p_q->capacity)
@@ -239,6 +530,9 @@ tiz_queue_send (tiz_queue_t * p_q, OMX_PTR ap_data)
 
   if (OMX_ErrorNone == rc)
     {
+      /* The tail slot is only guaranteed to be free once the queue is not
+         full */
+      assert (NULL == (p_q->p_last->p_data));
       p_q->p_last->p_data = ap_data;
       p_q->p_last = p_q->p_last->p_next;
       p_q->length++;
@@ -250,13 +544,67 @@ tiz_queue_send (tiz_queue_t * p_q, OMX_PTR ap_data)
   return rc;
 }
 
+OMX_ERRORTYPE
+tiz_queue_try_send (tiz_queue_t * p_q, OMX_PTR ap_data)
+{
+  assert (p_q);
+  assert (ap_data);
+
+  if (ETIZQueueModeLocking != p_q->mode)
+    {
+      if (!lf_try_push (p_q, ap_data))
+        {
+          return OMX_ErrorOverflow;
+        }
+      lf_signal (&(p_q->not_empty), &(p_q->empty_waiters), 1);
+      return OMX_ErrorNone;
+    }
+
+  tiz_check_omx_ret_oom (tiz_mutex_lock (&(p_q->mutex)));
+
+  assert (p_q->p_last);
+  assert (p_q->length <= p_q->capacity);
+
+  if (p_q->length == p_q->capacity)
+    {
+      tiz_check_omx_ret_oom (tiz_mutex_unlock (&(p_q->mutex)));
+      return OMX_ErrorOverflow;
+    }
+
+  assert (NULL == (p_q->p_last->p_data));
+  p_q->p_last->p_data = ap_data;
+  p_q->p_last = p_q->p_last->p_next;
+  p_q->length++;
+
+  tiz_check_omx_ret_oom (tiz_mutex_unlock (&(p_q->mutex)));
+  tiz_check_omx_ret_oom (tiz_cond_broadcast (&(p_q->cond_empty)));
+
+  return OMX_ErrorNone;
+}
+
 OMX_ERRORTYPE
 tiz_queue_receive (tiz_queue_t * p_q, OMX_PTR * app_data)
+{
+  OMX_S32 count = 0;
+  return tiz_queue_receive_batch (p_q, app_data, 1, &count);
+}
+
+OMX_ERRORTYPE
+tiz_queue_receive_batch (tiz_queue_t * p_q, OMX_PTR * app_data, OMX_S32 a_max,
+                         OMX_S32 * ap_count)
 {
   OMX_ERRORTYPE rc = OMX_ErrorNone;
+  OMX_S32 count = 0;
 
   assert (p_q);
   assert (app_data);
+  assert (a_max > 0);
+  assert (ap_count);
+
+  if (ETIZQueueModeLocking != p_q->mode)
+    {
+      return lf_receive_batch (p_q, app_data, a_max, ap_count);
+    }
 
   tiz_check_omx_ret_oom (tiz_mutex_lock (&(p_q->mutex)));
 
@@ -267,16 +615,18 @@ tiz_queue_receive (tiz_queue_t * p_q, OMX_PTR * app_data)
       rc = tiz_cond_wait (&(p_q->cond_empty), &(p_q->mutex));
     }
 
-  if (OMX_ErrorNone == rc)
+  while (OMX_ErrorNone == rc && count < a_max && p_q->length > 0)
     {
       assert (p_q->p_first);
       assert (p_q->p_first->p_data);
-      *app_data = p_q->p_first->p_data;
+      app_data[count++] = p_q->p_first->p_data;
       p_q->p_first->p_data = 0;
       p_q->p_first = p_q->p_first->p_next;
       p_q->length--;
     }
 
+  *ap_count = count;
+
   tiz_check_omx_ret_oom (tiz_mutex_unlock (&(p_q->mutex)));
   tiz_check_omx_ret_oom (tiz_cond_broadcast (&(p_q->cond_full)));
 
@@ -290,6 +640,12 @@ tiz_queue_capacity (tiz_queue_t * p_q)
 
   assert (p_q);
 
+  if (ETIZQueueModeLocking != p_q->mode)
+    {
+      /* Immutable in the lock-free modes */
+      return p_q->capacity;
+    }
+
   tiz_check_omx_ret_oom (tiz_mutex_lock (&(p_q->mutex)));
 
   capacity = p_q->capacity;
@@ -306,6 +662,11 @@ tiz_queue_length (tiz_queue_t * p_q)
 
   assert (p_q);
 
+  if (ETIZQueueModeLocking != p_q->mode)
+    {
+      return lf_length (p_q);
+    }
+
   tiz_check_omx_ret_oom (tiz_mutex_lock (&(p_q->mutex)));
 
   length = p_q->length;
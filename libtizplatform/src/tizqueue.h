@@ -36,7 +36,11 @@ extern "C" {
 /**
  * @defgroup tizqueue Message queue handling
  *
- * Thread-safe FIFO queue.
+ * Thread-safe FIFO queue. Three implementations are available: a mutex-based
+ * queue that supports any number of producers and consumers, and two
+ * lock-free bounded ring buffers (single-producer/single-consumer and
+ * multiple-producer/single-consumer) that only block (on a futex) when the
+ * queue is empty or full.
  *
  * @ingroup libtizplatform
  */
@@ -54,7 +58,22 @@ typedef struct tiz_queue tiz_queue_t;
 typedef /*@null@ */ tiz_queue_t * tiz_queue_ptr_t;
 
 /**
- * Initialize a new empty queue.
+ * Queue implementations.
+ * @ingroup tizqueue
+ */
+typedef enum tiz_queue_mode {
+  ETIZQueueModeLocking,     /**< Mutex and condition variables; any number of
+                                 producers and consumers */
+  ETIZQueueModeLockFreeSpsc, /**< Lock-free ring; one producer thread and one
+                                  consumer thread */
+  ETIZQueueModeLockFreeMpsc, /**< Lock-free ring; any number of producer
+                                  threads and one consumer thread */
+  ETIZQueueModeMax
+} tiz_queue_mode_t;
+
+/**
+ * Initialize a new empty queue. This is equivalent to calling
+ * tiz_queue_init_with_mode with ETIZQueueModeLocking.
  *
  * @ingroup tizqueue
  *
@@ -65,6 +84,23 @@ typedef /*@null@ */ tiz_queue_t * tiz_queue_ptr_t;
 OMX_ERRORTYPE
 tiz_queue_init (/*@out@*/ tiz_queue_ptr_t * app_q, OMX_S32 a_capacity);
 
+/**
+ * Initialize a new empty queue using a specific implementation. The
+ * lock-free modes are only safe if the caller honours their producer and
+ * consumer thread restrictions. In the lock-free modes, tiz_queue_length
+ * returns a snapshot that may already be stale when the call returns.
+ *
+ * @ingroup tizqueue
+ *
+ * @param a_capacity Maximum number of items that can be send into the queue.
+ * @param a_mode The queue implementation.
+ *
+ * @return OMX_ErrorNone if success, OMX_ErrorInsufficientResources otherwise.
+ */
+OMX_ERRORTYPE
+tiz_queue_init_with_mode (/*@out@*/ tiz_queue_ptr_t * app_q,
+                          OMX_S32 a_capacity, tiz_queue_mode_t a_mode);
+
 /**
  * Destroy a queue. If ap_q is NULL, or the queue has already been detroyed
  * before, no operation is performed.
@@ -85,6 +121,16 @@ tiz_queue_destroy (/*@null@ */ tiz_queue_t * ap_q);
 OMX_ERRORTYPE
 tiz_queue_send (tiz_queue_t * ap_q, OMX_PTR ap_data);
 
+/**
+ * Add an item onto the end of the queue without blocking.
+ *
+ * @ingroup tizqueue
+ *
+ * @return OMX_ErrorNone on success, OMX_ErrorOverflow if the queue is full.
+ */
+OMX_ERRORTYPE
+tiz_queue_try_send (tiz_queue_t * ap_q, OMX_PTR ap_data);
+
 /**
  * Retrieve an item from the head of the queue. If the queue is empty, it
  * blocks until an item becomes available.
@@ -95,6 +141,23 @@ tiz_queue_send (tiz_queue_t * ap_q, OMX_PTR ap_data);
 OMX_ERRORTYPE
 tiz_queue_receive (tiz_queue_t * ap_q, OMX_PTR * app_data);
 
+/**
+ * Retrieve up to a_max items from the head of the queue. If the queue is
+ * empty, it blocks until at least one item becomes available; it never
+ * blocks waiting for more items once it has retrieved one.
+ *
+ * @ingroup tizqueue
+ *
+ * @param app_data An array of at least a_max elements (output).
+ * @param a_max The maximum number of items to retrieve.
+ * @param ap_count The number of items retrieved (output).
+ *
+ * @return OMX_ErrorNone on success.
+ */
+OMX_ERRORTYPE
+tiz_queue_receive_batch (tiz_queue_t * ap_q, OMX_PTR * app_data,
+                         OMX_S32 a_max, OMX_S32 * ap_count);
+
 /**
  * Retrieve the maximum number of items that can be stored in the queue.
  *
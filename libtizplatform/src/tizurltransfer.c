@@ -32,6 +32,7 @@
 
 #include <assert.h>
 #include <errno.h>
+#include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -46,6 +47,9 @@
 #define TIZ_LOG_CATEGORY_NAME "tiz.platform.urltrans"
 #endif
 
+/* The maximum number of headers a transfer in scatter mode keeps claimed */
+#define URLTRANS_MAX_HELD_HEADERS 16
+
 /* forward declarations */
 static void
 destroy_curl_resources (tiz_urltrans_t * ap_trans);
@@ -193,17 +197,39 @@ struct tiz_urltrans
   tiz_event_timer_t * p_ev_reconnect_timer_;
   bool awaiting_reconnect_timer_ev_;
   tiz_buffer_t * p_store_;
-  int internal_buffer_size_;
-  int internal_buffer_size_initial_;
+  size_t internal_buffer_size_;
+  size_t internal_buffer_size_initial_;
   CURL * p_curl_;        /* curl easy */
   CURLM * p_curl_multi_; /* curl multi */
   struct curl_slist * p_http_ok_aliases_;
   struct curl_slist * p_http_headers_;
   httpsrc_curl_state_id_t curl_state_;
   unsigned int curl_version_;
+  bool has_global_ref_;
+  bool timings_reported_;
+  bool scatter_mode_;
+  OMX_BUFFERHEADERTYPE * p_held_hdrs_[URLTRANS_MAX_HELD_HEADERS];
+  int nheld_;
+  size_t held_bytes_;
+  OMX_U64 bytes_received_;
+  OMX_U64 bytes_copied_;
   char curl_err[CURL_ERROR_SIZE];
 };
 
+/* Process-wide curl state. This is libcurl's global initialisation, which is
+   not thread-safe and must not be undone while other components are still
+   transferring, and a share handle that gives all the easy handles in the
+   process the same DNS cache, TLS session cache and, with libcurl >= 7.57,
+   connection pool. A new track or a new component instance talking to a host
+   that has been seen recently skips the lookup and the handshakes. */
+static struct
+{
+  pthread_mutex_t mutex;
+  int nrefs;
+  CURLSH * p_share;
+  pthread_mutex_t share_locks[CURL_LOCK_DATA_LAST];
+} g_urltrans_global = {.mutex = PTHREAD_MUTEX_INITIALIZER};
+
 /*@observer@*/ const char *
 httpsrc_curl_state_to_str (const httpsrc_curl_state_id_t a_state)
 {
@@ -247,7 +273,7 @@ httpsrc_curl_state_to_str (const httpsrc_curl_state_id_t a_state)
     {                                                                         \
       TIZ_LOG (                                                               \
         TIZ_PRIORITY_TRACE,                                                   \
-        "%s : STATE = [%s] fd [%d] store [%d] timer [%f] io [%s] "            \
+        "%s : STATE = [%s] fd [%d] store [%zu] timer [%f] io [%s] "           \
         "ct [%s] rt [%s]",                                                    \
         start_or_end_str, httpsrc_curl_state_to_str (ap_trans->curl_state_),  \
         ap_trans->sockfd_,                                                    \
@@ -303,7 +329,7 @@ static inline bool
 is_passed_buffer_high_watermark (tiz_urltrans_t * ap_trans)
 {
   assert (ap_trans);
-  return (tiz_buffer_available (ap_trans->p_store_)
+  return (tiz_buffer_available (ap_trans->p_store_) + ap_trans->held_bytes_
           >= ap_trans->internal_buffer_size_initial_);
 }
 
@@ -320,6 +346,7 @@ start_curl (tiz_urltrans_t * ap_trans)
   assert (is_transfer_stopped (ap_trans) || is_transfer_paused (ap_trans));
 
   set_curl_state (ap_trans, ECurlStateTransfering);
+  ap_trans->timings_reported_ = false;
 
   /* associate the processor with the curl handle */
   bail_on_curl_error (
@@ -586,41 +613,217 @@ resume_curl (tiz_urltrans_t * ap_trans)
   return OMX_ErrorNone;
 }
 
-static inline int
+static inline size_t
 copy_to_omx_buffer (OMX_BUFFERHEADERTYPE * ap_hdr, void * ap_src,
-                    const int nbytes)
+                    const size_t nbytes)
 {
-  int n = MIN (nbytes, ap_hdr->nAllocLen - ap_hdr->nFilledLen);
+  size_t n = MIN (nbytes, (size_t) (ap_hdr->nAllocLen - ap_hdr->nFilledLen));
   (void) memcpy (ap_hdr->pBuffer + ap_hdr->nOffset, ap_src, n);
   ap_hdr->nFilledLen += n;
   return n;
 }
 
+/* Scatter mode: the data goes straight from curl into a queue of claimed
+   headers. Only the last claimed header may be partially filled. */
+static OMX_BUFFERHEADERTYPE *
+get_scatter_header (tiz_urltrans_t * ap_trans)
+{
+  OMX_BUFFERHEADERTYPE * p_hdr = NULL;
+  assert (ap_trans);
+
+  if (ap_trans->nheld_ > 0)
+    {
+      p_hdr = ap_trans->p_held_hdrs_[ap_trans->nheld_ - 1];
+      if (p_hdr->nFilledLen < p_hdr->nAllocLen)
+        {
+          return p_hdr;
+        }
+      p_hdr = NULL;
+    }
+
+  if (ap_trans->nheld_ < URLTRANS_MAX_HELD_HEADERS
+      && (p_hdr = ap_trans->buffer_cbacks_.pf_buf_emptied (
+            ap_trans->p_parent_)))
+    {
+      ap_trans->p_held_hdrs_[ap_trans->nheld_++] = p_hdr;
+    }
+  return p_hdr;
+}
+
+static size_t
+scatter_to_headers (tiz_urltrans_t * ap_trans, char * ap_data,
+                    const size_t a_nbytes)
+{
+  OMX_BUFFERHEADERTYPE * p_hdr = NULL;
+  size_t nbytes_copied = 0;
+  assert (ap_trans);
+
+  while (nbytes_copied < a_nbytes
+         && (p_hdr = get_scatter_header (ap_trans)) != NULL)
+    {
+      nbytes_copied += copy_to_omx_buffer (p_hdr, ap_data + nbytes_copied,
+                                           a_nbytes - nbytes_copied);
+    }
+  ap_trans->held_bytes_ += nbytes_copied;
+  ap_trans->bytes_copied_ += nbytes_copied;
+  return nbytes_copied;
+}
+
+static void
+scatter_from_spill_area (tiz_urltrans_t * ap_trans)
+{
+  size_t nbytes_available = 0;
+  assert (ap_trans);
+  if ((nbytes_available = tiz_buffer_available (ap_trans->p_store_)) > 0)
+    {
+      (void) tiz_buffer_advance (
+        ap_trans->p_store_,
+        scatter_to_headers (ap_trans, tiz_buffer_get (ap_trans->p_store_),
+                            nbytes_available));
+    }
+}
+
+/* Full headers are released once the initial buffering is over. The one
+   still being filled is only released when the transfer has ended or the
+   client wants all its headers back. */
+static void
+release_held_headers (tiz_urltrans_t * ap_trans, const bool a_all)
+{
+  int nreleased = 0;
+  assert (ap_trans);
+
+  if (!a_all && ap_trans->internal_buffer_size_initial_ > 0)
+    {
+      return;
+    }
+
+  while (nreleased < ap_trans->nheld_)
+    {
+      OMX_BUFFERHEADERTYPE * p_hdr = ap_trans->p_held_hdrs_[nreleased];
+      if (!a_all && p_hdr->nFilledLen < p_hdr->nAllocLen)
+        {
+          break;
+        }
+      TIZ_PRINTF_DBG_CYN ("Releasing buffer with size [%u]",
+                          (unsigned int) p_hdr->nFilledLen);
+      ap_trans->held_bytes_ -= p_hdr->nFilledLen;
+      ++nreleased;
+      ap_trans->buffer_cbacks_.pf_buf_filled (p_hdr, ap_trans->p_parent_);
+    }
+
+  if (nreleased > 0)
+    {
+      ap_trans->nheld_ -= nreleased;
+      memmove (ap_trans->p_held_hdrs_, ap_trans->p_held_hdrs_ + nreleased,
+               ap_trans->nheld_ * sizeof (OMX_BUFFERHEADERTYPE *));
+    }
+}
+
 static OMX_ERRORTYPE
 send_from_internal_buffer (tiz_urltrans_t * p_trans)
 {
   OMX_BUFFERHEADERTYPE * p_out = NULL;
-  int nbytes_available = 0;
+  size_t nbytes_available = 0;
   assert (p_trans);
 
+  if (p_trans->scatter_mode_)
+    {
+      scatter_from_spill_area (p_trans);
+      release_held_headers (p_trans, is_transfer_stopped (p_trans));
+      return OMX_ErrorNone;
+    }
+
   while (
     (nbytes_available = tiz_buffer_available (p_trans->p_store_)) > 0
     && (p_out = p_trans->buffer_cbacks_.pf_buf_emptied (p_trans->p_parent_))
          != NULL)
     {
-      int nbytes_copied = copy_to_omx_buffer (
+      size_t nbytes_copied = copy_to_omx_buffer (
         p_out, tiz_buffer_get (p_trans->p_store_), nbytes_available);
       TIZ_PRINTF_DBG_MAG (
-        "Releasing buffer with size [%u] available [%u].",
+        "Releasing buffer with size [%u] available [%zu].",
         (unsigned int) p_out->nFilledLen,
         tiz_buffer_available (p_trans->p_store_) - nbytes_copied);
       p_trans->buffer_cbacks_.pf_buf_filled (p_out, p_trans->p_parent_);
       (void) tiz_buffer_advance (p_trans->p_store_, nbytes_copied);
+      p_trans->bytes_copied_ += nbytes_copied;
       p_out = NULL;
     }
   return OMX_ErrorNone;
 }
 
+/* The internal store is only a spill area in scatter mode. It takes what
+   does not fit in the claimed headers (at most one curl write), and while it
+   is not empty curl is kept paused. */
+static size_t
+scatter_data (tiz_urltrans_t * ap_trans, char * ap_data, const size_t a_nbytes)
+{
+  size_t rc = a_nbytes;
+  size_t nbytes_copied = 0;
+  assert (ap_trans);
+
+  /* Spilled data goes first */
+  scatter_from_spill_area (ap_trans);
+
+  if (tiz_buffer_available (ap_trans->p_store_) > 0)
+    {
+      /* There are no headers to put this in, let curl keep it */
+      TIZ_PRINTF_DBG_GRN ("Pausing curl - spill size [%zu]",
+                          tiz_buffer_available (ap_trans->p_store_));
+      rc = CURL_WRITEFUNC_PAUSE;
+      set_curl_state (ap_trans, ECurlStatePaused);
+      stop_io_watcher (ap_trans);
+      stop_curl_timer_watcher (ap_trans);
+    }
+  else if ((nbytes_copied = scatter_to_headers (ap_trans, ap_data, a_nbytes))
+           < a_nbytes)
+    {
+      const size_t nbytes_left = a_nbytes - nbytes_copied;
+      size_t nbytes_spilled = tiz_buffer_push (
+        ap_trans->p_store_, ap_data + nbytes_copied, nbytes_left);
+      ap_trans->bytes_copied_ += nbytes_spilled;
+      if (nbytes_spilled < nbytes_left)
+        {
+          TIZ_LOG (TIZ_PRIORITY_ERROR,
+                   "Unable to store all the data (wanted %zu, stored %zu).",
+                   nbytes_left, nbytes_spilled);
+        }
+    }
+
+  /* The initial buffering is also over when the claimed headers cannot take
+     any more data */
+  if (is_passed_buffer_high_watermark (ap_trans)
+      || tiz_buffer_available (ap_trans->p_store_) > 0)
+    {
+      ap_trans->internal_buffer_size_initial_ = 0;
+    }
+
+  release_held_headers (ap_trans, false);
+  return rc;
+}
+
+/* Logs how many bytes were copied for each byte that curl delivered since
+   the last report. This is 1.0 when nothing needs to be staged in the
+   internal store. */
+static void
+report_copy_stats (tiz_urltrans_t * ap_trans)
+{
+  assert (ap_trans);
+  if (ap_trans->bytes_received_ > 0)
+    {
+      TIZ_LOG (TIZ_PRIORITY_NOTICE,
+               "[%s] %llu bytes received - %.2f bytes copied per byte "
+               "received (%s mode)",
+               ap_trans->p_comp_name_,
+               (unsigned long long) ap_trans->bytes_received_,
+               (double) ap_trans->bytes_copied_
+                 / (double) ap_trans->bytes_received_,
+               ap_trans->scatter_mode_ ? "scatter" : "store");
+    }
+  ap_trans->bytes_received_ = 0;
+  ap_trans->bytes_copied_ = 0;
+}
+
 static void
 reset_initial_buffer_size (tiz_urltrans_t * ap_trans)
 {
@@ -646,6 +849,37 @@ report_connection_lost_event (tiz_urltrans_t * ap_trans)
     }
 }
 
+/* Logs, once per request, where the time to the first byte went. A zero
+   connection count means that a pooled connection was reused. */
+static void
+report_transfer_timings (tiz_urltrans_t * ap_trans)
+{
+  double lookup = 0., connect = 0., tls = 0., first_byte = 0.;
+  long nconnects = 0;
+  assert (ap_trans);
+  if (!ap_trans->timings_reported_)
+    {
+      ap_trans->timings_reported_ = true;
+      (void) curl_easy_getinfo (ap_trans->p_curl_, CURLINFO_NAMELOOKUP_TIME,
+                                &lookup);
+      (void) curl_easy_getinfo (ap_trans->p_curl_, CURLINFO_CONNECT_TIME,
+                                &connect);
+#if LIBCURL_VERSION_NUM >= 0x071300
+      (void) curl_easy_getinfo (ap_trans->p_curl_, CURLINFO_APPCONNECT_TIME,
+                                &tls);
+#endif
+      (void) curl_easy_getinfo (ap_trans->p_curl_,
+                                CURLINFO_STARTTRANSFER_TIME, &first_byte);
+      (void) curl_easy_getinfo (ap_trans->p_curl_, CURLINFO_NUM_CONNECTS,
+                                &nconnects);
+      TIZ_LOG (TIZ_PRIORITY_NOTICE,
+               "[%s] first byte after %.3f s (lookup %.3f s connect %.3f s "
+               "tls %.3f s) - %s connection",
+               ap_trans->p_comp_name_, first_byte, lookup, connect, tls,
+               nconnects > 0 ? "new" : "reused");
+    }
+}
+
 /* This function gets called by libcurl as soon as it has received header
    data. The header callback will be called once for each header and only
    complete header lines are passed on to the callback. Parsing headers is very
@@ -689,6 +923,7 @@ curl_write_cback (void * ptr, size_t size, size_t nmemb, void * userdata)
     {
       set_curl_state (p_trans, ECurlStateTransfering);
       OMX_BUFFERHEADERTYPE * p_out = NULL;
+      report_transfer_timings (p_trans);
 
       if (p_trans->info_cbacks_.pf_data_avail (p_trans->p_parent_, ptr, nbytes))
         {
@@ -701,6 +936,10 @@ curl_write_cback (void * ptr, size_t size, size_t nmemb, void * userdata)
           rc = CURL_WRITEFUNC_PAUSE;
           set_curl_state (p_trans, ECurlStatePaused);
         }
+      else if (p_trans->scatter_mode_)
+        {
+          rc = scatter_data (p_trans, ptr, nbytes);
+        }
       else
         {
 
@@ -716,11 +955,13 @@ curl_write_cback (void * ptr, size_t size, size_t nmemb, void * userdata)
                            p_trans->p_parent_))
                           != NULL)
                 {
-                  int nbytes_copied = copy_to_omx_buffer (p_out, ptr, nbytes);
+                  size_t nbytes_copied
+                    = copy_to_omx_buffer (p_out, ptr, nbytes);
                   TIZ_PRINTF_DBG_CYN ("Releasing buffer with size [%u]",
                                       (unsigned int) p_out->nFilledLen);
                   p_trans->buffer_cbacks_.pf_buf_filled (p_out,
                                                          p_trans->p_parent_);
+                  p_trans->bytes_copied_ += nbytes_copied;
                   nbytes -= nbytes_copied;
                   ptr += nbytes_copied;
                 }
@@ -732,7 +973,7 @@ curl_write_cback (void * ptr, size_t size, size_t nmemb, void * userdata)
                   > (2 * p_trans->internal_buffer_size_))
                 {
                   /* This is to pause curl */
-                  TIZ_PRINTF_DBG_GRN ("Pausing curl - cache size [%d]",
+                  TIZ_PRINTF_DBG_GRN ("Pausing curl - cache size [%zu]",
                                       tiz_buffer_available (p_trans->p_store_));
                   rc = CURL_WRITEFUNC_PAUSE;
                   set_curl_state (p_trans, ECurlStatePaused);
@@ -742,19 +983,25 @@ curl_write_cback (void * ptr, size_t size, size_t nmemb, void * userdata)
                 }
               else
                 {
-                  int nbytes_available = 0;
+                  size_t nbytes_available = 0;
                   if ((nbytes_available
                        = tiz_buffer_push (p_trans->p_store_, ptr, nbytes))
                       < nbytes)
                     {
                       TIZ_LOG (TIZ_PRIORITY_ERROR,
-                               "Unable to store all the data (wanted %d, "
-                               "stored %d).",
+                               "Unable to store all the data (wanted %zu, "
+                               "stored %zu).",
                                nbytes, nbytes_available);
                     }
+                  p_trans->bytes_copied_ += nbytes_available;
                 }
             }
         }
+
+      if (CURL_WRITEFUNC_PAUSE != rc)
+        {
+          p_trans->bytes_received_ += rc;
+        }
     }
 
   URLTRANS_LOG_CBACK_END (p_trans);
@@ -899,17 +1146,129 @@ curl_timer_cback (CURLM * multi, long timeout_ms, void * userp)
   return 0;
 }
 
+static void
+curl_share_lock_cback (CURL * p_curl, curl_lock_data data,
+                       curl_lock_access access, void * userptr)
+{
+  (void) p_curl;
+  (void) access;
+  (void) userptr;
+  assert (data < CURL_LOCK_DATA_LAST);
+  (void) pthread_mutex_lock (&(g_urltrans_global.share_locks[data]));
+}
+
+static void
+curl_share_unlock_cback (CURL * p_curl, curl_lock_data data, void * userptr)
+{
+  (void) p_curl;
+  (void) userptr;
+  assert (data < CURL_LOCK_DATA_LAST);
+  (void) pthread_mutex_unlock (&(g_urltrans_global.share_locks[data]));
+}
+
+static void
+share_curl_data (CURLSH * ap_share, curl_lock_data a_data)
+{
+  CURLSHcode code = curl_share_setopt (ap_share, CURLSHOPT_SHARE, a_data);
+  if (CURLSHE_OK != code)
+    {
+      /* Not fatal, this kind of data will just not be shared */
+      TIZ_LOG (TIZ_PRIORITY_NOTICE, "unable to share curl data [%d] (%s)",
+               a_data, curl_share_strerror (code));
+    }
+}
+
+static void
+init_curl_share (void)
+{
+  CURLSH * p_share = NULL;
+  int i = 0;
+
+  assert (!g_urltrans_global.p_share);
+
+  for (i = 0; i < CURL_LOCK_DATA_LAST; ++i)
+    {
+      (void) pthread_mutex_init (&(g_urltrans_global.share_locks[i]), NULL);
+    }
+
+  /* Without the share handle, transfers still work, but each of them has to
+     resolve, connect and negotiate TLS on its own */
+  if (!(p_share = curl_share_init ()))
+    {
+      TIZ_LOG (TIZ_PRIORITY_NOTICE, "unable to create the curl share handle");
+      return;
+    }
+
+  (void) curl_share_setopt (p_share, CURLSHOPT_LOCKFUNC,
+                            curl_share_lock_cback);
+  (void) curl_share_setopt (p_share, CURLSHOPT_UNLOCKFUNC,
+                            curl_share_unlock_cback);
+  share_curl_data (p_share, CURL_LOCK_DATA_DNS);
+#if LIBCURL_VERSION_NUM >= 0x071700
+  share_curl_data (p_share, CURL_LOCK_DATA_SSL_SESSION);
+#endif
+#if LIBCURL_VERSION_NUM >= 0x073900
+  share_curl_data (p_share, CURL_LOCK_DATA_CONNECT);
+#endif
+
+  g_urltrans_global.p_share = p_share;
+}
+
+static void
+destroy_curl_share (void)
+{
+  int i = 0;
+  if (g_urltrans_global.p_share)
+    {
+      /* All the easy handles using it are gone by now */
+      (void) curl_share_cleanup (g_urltrans_global.p_share);
+      g_urltrans_global.p_share = NULL;
+    }
+  for (i = 0; i < CURL_LOCK_DATA_LAST; ++i)
+    {
+      (void) pthread_mutex_destroy (&(g_urltrans_global.share_locks[i]));
+    }
+}
+
 static OMX_ERRORTYPE
 allocate_curl_global_resources (tiz_urltrans_t * ap_trans)
 {
   OMX_ERRORTYPE rc = OMX_ErrorInsufficientResources;
-  bail_on_curl_error (curl_global_init (CURL_GLOBAL_ALL));
+  assert (ap_trans);
+  assert (!ap_trans->has_global_ref_);
+  (void) pthread_mutex_lock (&(g_urltrans_global.mutex));
+  if (0 == g_urltrans_global.nrefs)
+    {
+      bail_on_curl_error (curl_global_init (CURL_GLOBAL_ALL));
+      init_curl_share ();
+    }
+  g_urltrans_global.nrefs++;
+  ap_trans->has_global_ref_ = true;
   /* All well */
   rc = OMX_ErrorNone;
 end:
+  (void) pthread_mutex_unlock (&(g_urltrans_global.mutex));
   return rc;
 }
 
+static void
+destroy_curl_global_resources (tiz_urltrans_t * ap_trans)
+{
+  assert (ap_trans);
+  if (ap_trans->has_global_ref_)
+    {
+      ap_trans->has_global_ref_ = false;
+      (void) pthread_mutex_lock (&(g_urltrans_global.mutex));
+      assert (g_urltrans_global.nrefs > 0);
+      if (0 == --g_urltrans_global.nrefs)
+        {
+          destroy_curl_share ();
+          curl_global_cleanup ();
+        }
+      (void) pthread_mutex_unlock (&(g_urltrans_global.mutex));
+    }
+}
+
 static OMX_ERRORTYPE
 allocate_temp_data_store (tiz_urltrans_t * ap_trans)
 {
@@ -917,6 +1276,10 @@ allocate_temp_data_store (tiz_urltrans_t * ap_trans)
   assert (ap_trans->p_store_ == NULL);
   tiz_check_omx (
     tiz_buffer_init (&(ap_trans->p_store_), ap_trans->store_bytes_));
+  /* Data is always consumed in the order it arrives; a ring avoids moving
+     the cache around on every curl write. If this fails, the store simply
+     stays linear. */
+  (void) tiz_buffer_seek_mode (ap_trans->p_store_, TIZ_BUFFER_CIRCULAR);
   return OMX_ErrorNone;
 }
 
@@ -990,6 +1353,17 @@ allocate_curl_resources (tiz_urltrans_t * ap_trans)
 
   /* Init the curl easy handle */
   tiz_check_null_ret_oom ((ap_trans->p_curl_ = curl_easy_init ()) != NULL);
+  /* These survive tiz_urltrans_set_uri, the handle is reused for every URI */
+  if (g_urltrans_global.p_share)
+    {
+      bail_on_curl_error (curl_easy_setopt (ap_trans->p_curl_, CURLOPT_SHARE,
+                                            g_urltrans_global.p_share));
+    }
+#if LIBCURL_VERSION_NUM >= 0x071900
+  /* keep idle connections in the pool alive between tracks */
+  bail_on_curl_error (
+    curl_easy_setopt (ap_trans->p_curl_, CURLOPT_TCP_KEEPALIVE, 1L));
+#endif
   /* Now init the curl multi handle */
   bail_on_oom ((ap_trans->p_curl_multi_ = curl_multi_init ()));
   /* this is to ask libcurl to accept ICY OK headers*/
@@ -1084,6 +1458,13 @@ tiz_urltrans_init (tiz_urltrans_ptr_t * app_trans, void * ap_parent,
           p_trans->p_http_headers_ = NULL;
           p_trans->curl_state_ = ECurlStateStopped;
           p_trans->curl_version_ = 0;
+          p_trans->has_global_ref_ = false;
+          p_trans->timings_reported_ = false;
+          p_trans->scatter_mode_ = false;
+          p_trans->nheld_ = 0;
+          p_trans->held_bytes_ = 0;
+          p_trans->bytes_received_ = 0;
+          p_trans->bytes_copied_ = 0;
 
           rc = allocate_temp_data_store (p_trans);
           goto_end_on_omx_error (rc, "Unable to alloc the data store");
@@ -1112,10 +1493,11 @@ tiz_urltrans_destroy (tiz_urltrans_t * ap_trans)
 {
   if (ap_trans)
     {
+      report_copy_stats (ap_trans);
       destroy_temp_data_store (ap_trans);
       destroy_events (ap_trans);
       destroy_curl_resources (ap_trans);
-      curl_global_cleanup ();
+      destroy_curl_global_resources (ap_trans);
     }
 }
 
@@ -1126,6 +1508,9 @@ tiz_urltrans_set_uri (tiz_urltrans_t * ap_trans,
   assert (ap_trans);
   assert (ap_uri_param);
   URLTRANS_LOG_API_START (ap_trans);
+  report_copy_stats (ap_trans);
+  /* In scatter mode, what is left of the previous stream goes out now */
+  release_held_headers (ap_trans, true);
   ap_trans->p_uri_param_ = ap_uri_param;
   curl_multi_remove_handle (ap_trans->p_curl_multi_, ap_trans->p_curl_);
   bail_on_curl_error (curl_easy_setopt (ap_trans->p_curl_, CURLOPT_URL,
@@ -1146,7 +1531,16 @@ tiz_urltrans_set_internal_buffer_size (tiz_urltrans_t * ap_trans,
   assert (a_nbytes > 0);
   URLTRANS_LOG_API_START (ap_trans);
   ap_trans->internal_buffer_size_ = ap_trans->internal_buffer_size_initial_
-    = a_nbytes;
+    = (size_t) a_nbytes;
+}
+
+void
+tiz_urltrans_enable_scatter_mode (tiz_urltrans_t * ap_trans)
+{
+  assert (ap_trans);
+  assert (0 == ap_trans->nheld_);
+  URLTRANS_LOG_API_START (ap_trans);
+  ap_trans->scatter_mode_ = true;
 }
 
 OMX_ERRORTYPE
@@ -1222,6 +1616,8 @@ tiz_urltrans_flush_buffer (tiz_urltrans_t * ap_trans)
     {
       tiz_buffer_clear (ap_trans->p_store_);
     }
+  /* Hand back the headers claimed in scatter mode */
+  release_held_headers (ap_trans, true);
   URLTRANS_LOG_API_END (ap_trans);
 }
 
@@ -1234,8 +1630,10 @@ tiz_urltrans_on_buffers_ready (tiz_urltrans_t * ap_trans)
   rc = send_from_internal_buffer (ap_trans);
   if (is_transfer_paused (ap_trans))
     {
-      if (tiz_buffer_available (ap_trans->p_store_)
-          <= ap_trans->internal_buffer_size_)
+      if (ap_trans->scatter_mode_
+            ? 0 == tiz_buffer_available (ap_trans->p_store_)
+            : tiz_buffer_available (ap_trans->p_store_)
+                <= ap_trans->internal_buffer_size_)
         {
           rc = resume_curl (ap_trans);
         }
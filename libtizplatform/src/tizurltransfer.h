@@ -303,6 +303,23 @@ void
 tiz_urltrans_set_internal_buffer_size (tiz_urltrans_t * ap_trans,
                                        const int a_nbytes);
 
+/**
+ * Put the transfer in scatter mode. The data received is written directly
+ * into a queue of claimed buffer headers, and the internal store is only
+ * used to hold what does not fit in them, pausing the transfer until it has
+ * been drained.
+ *
+ * In this mode, every call to the 'buffer emptied' callback must claim and
+ * return a new header (or NULL), and the 'buffer filled' callback receives
+ * the headers in the order they were claimed. The headers still held are
+ * returned through the 'buffer filled' callback by
+ * tiz_urltrans_flush_buffer and tiz_urltrans_set_uri.
+ *
+ * @param ap_trans The URL transfer object.
+ */
+void
+tiz_urltrans_enable_scatter_mode (tiz_urltrans_t * ap_trans);
+
 OMX_ERRORTYPE
 tiz_urltrans_start (tiz_urltrans_t * ap_trans);
 
@@ -0,0 +1,520 @@
+/**
+ * Copyright (C) 2011-2017 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   bench_tizplatform.c
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Tizonia Platform micro-benchmarks
+ *
+ * Not part of 'make check'. Run './bench_tizplatform' to run all the
+ * benchmarks, or './bench_tizplatform <name>...' to run only some of them.
+ *
+ */
+
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+
+#include "../src/tizplatform.h"
+
+#ifdef TIZ_LOG_CATEGORY_NAME
+#undef TIZ_LOG_CATEGORY_NAME
+#define TIZ_LOG_CATEGORY_NAME "tiz.platform.bench"
+#endif
+
+#define BENCH_CHECK(expr)                                             \
+  do                                                                  \
+    {                                                                 \
+      if (!(expr))                                                    \
+        {                                                             \
+          fprintf (stderr, "%s:%d: check failed: %s\n", __FILE__,     \
+                   __LINE__, #expr);                                  \
+          abort ();                                                   \
+        }                                                             \
+    }                                                                 \
+  while (0)
+
+static inline uint64_t
+bench_now_ns (void)
+{
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int
+bench_cmp_u64 (const void *a, const void *b)
+{
+  const uint64_t x = *(const uint64_t *) a;
+  const uint64_t y = *(const uint64_t *) b;
+  return (x > y) - (x < y);
+}
+
+/*
+ * Queue: locking vs lock-free MPSC, using the scheduler's queue capacity (see
+ * tizscheduler.c)
+ */
+
+#define QUEUE_BENCH_MAX_PRODUCERS 8
+#define QUEUE_BENCH_ITEMS_PER_PRODUCER 100000
+#define QUEUE_BENCH_CAPACITY 30
+
+typedef struct queue_bench_producer queue_bench_producer_t;
+struct queue_bench_producer
+{
+  tiz_queue_t *p_queue;
+  OMX_U32 id;
+  OMX_U32 nitems;
+  uint64_t *p_latencies; /* nanoseconds, one per send */
+};
+
+static OMX_PTR
+queue_bench_producer_thread (OMX_PTR ap_arg)
+{
+  queue_bench_producer_t *p_prod = ap_arg;
+  OMX_U32 i;
+
+  for (i = 0; i < p_prod->nitems; i++)
+    {
+      /* Items are never dereferenced: encode the producer and the sequence
+         number (plus one, as NULL items are not allowed) */
+      OMX_PTR p_item
+        = (OMX_PTR) (uintptr_t) (((uintptr_t) p_prod->id << 24) | (i + 1));
+      const uint64_t start = bench_now_ns ();
+      BENCH_CHECK (OMX_ErrorNone == tiz_queue_send (p_prod->p_queue, p_item));
+      p_prod->p_latencies[i] = bench_now_ns () - start;
+    }
+
+  return NULL;
+}
+
+static double
+queue_bench_run (tiz_queue_mode_t a_mode, OMX_U32 a_nproducers,
+                 uint64_t *ap_p99_ns)
+{
+  const OMX_U32 nitems = QUEUE_BENCH_ITEMS_PER_PRODUCER;
+  const size_t total = (size_t) a_nproducers * nitems;
+  tiz_queue_t *p_queue = NULL;
+  tiz_thread_t threads[QUEUE_BENCH_MAX_PRODUCERS];
+  queue_bench_producer_t producers[QUEUE_BENCH_MAX_PRODUCERS];
+  uint64_t *p_latencies = NULL;
+  OMX_PTR p_received = NULL;
+  uint64_t start = 0;
+  uint64_t elapsed = 0;
+  size_t i;
+
+  BENCH_CHECK (OMX_ErrorNone
+               == tiz_queue_init_with_mode (&p_queue, QUEUE_BENCH_CAPACITY,
+                                            a_mode));
+  p_latencies = tiz_mem_calloc (total, sizeof (uint64_t));
+  BENCH_CHECK (NULL != p_latencies);
+
+  start = bench_now_ns ();
+  for (i = 0; i < a_nproducers; i++)
+    {
+      producers[i].p_queue = p_queue;
+      producers[i].id = i;
+      producers[i].nitems = nitems;
+      producers[i].p_latencies = p_latencies + i * nitems;
+      BENCH_CHECK (OMX_ErrorNone
+                   == tiz_thread_create (&threads[i], 0, 0,
+                                         queue_bench_producer_thread,
+                                         &producers[i]));
+    }
+
+  for (i = 0; i < total; i++)
+    {
+      BENCH_CHECK (OMX_ErrorNone == tiz_queue_receive (p_queue, &p_received));
+    }
+  elapsed = bench_now_ns () - start;
+
+  for (i = 0; i < a_nproducers; i++)
+    {
+      void *p_result = NULL;
+      BENCH_CHECK (OMX_ErrorNone == tiz_thread_join (&threads[i], &p_result));
+    }
+
+  tiz_queue_destroy (p_queue);
+
+  qsort (p_latencies, total, sizeof (uint64_t), bench_cmp_u64);
+  *ap_p99_ns = p_latencies[(total * 99) / 100];
+  tiz_mem_free (p_latencies);
+
+  return (double) total * 1e9 / (double) (elapsed + 1);
+}
+
+static void
+bench_queue (void)
+{
+  const tiz_queue_mode_t modes[]
+    = { ETIZQueueModeLocking, ETIZQueueModeLockFreeMpsc };
+  const char *mode_names[] = { "locking", "lock-free mpsc" };
+  OMX_U32 nproducers;
+  int m;
+
+  for (nproducers = 1; nproducers <= QUEUE_BENCH_MAX_PRODUCERS;
+       nproducers *= 2)
+    {
+      for (m = 0; m < 2; m++)
+        {
+          uint64_t p99 = 0;
+          const double rate = queue_bench_run (modes[m], nproducers, &p99);
+          printf ("queue [%-14s] producers [%u] msgs/s [%10.0f] "
+                  "p99 send latency [%6" PRIu64 " ns]\n",
+                  mode_names[m], (unsigned) nproducers, rate, p99);
+        }
+    }
+}
+
+/*
+ * Buffer: linear vs circular, with the access patterns of the URL transfer
+ * (16 KiB curl writes, whole OMX buffers out, a few seconds of audio in the
+ * store) and of the decoders (input buffers in, small frames out, little data
+ * in the store)
+ */
+
+#define BUFFER_BENCH_SOURCE_LEN (4 * 1024 * 1024)
+#define BUFFER_BENCH_STREAM_LEN (256 * 1024 * 1024)
+
+static void
+bench_buffer (void)
+{
+  static const struct
+  {
+    const char *p_name;
+    size_t push_len;
+    size_t read_len;
+    size_t fill_len;
+  } patterns[] = { { "urltrans", 16384, 4096, 512 * 1024 },
+                   { "decoder", 4096, 417, 8192 } };
+  static const int modes[] = { TIZ_BUFFER_NON_SEEKABLE, TIZ_BUFFER_CIRCULAR };
+  static const char *mode_names[] = { "linear", "circular" };
+  static uint8_t source[BUFFER_BENCH_SOURCE_LEN];
+  uint32_t state = 7;
+  size_t p = 0;
+  size_t m = 0;
+  size_t i = 0;
+
+  for (i = 0; i < BUFFER_BENCH_SOURCE_LEN; ++i)
+    {
+      state = state * 1664525u + 1013904223u;
+      source[i] = (uint8_t) (state >> 8);
+    }
+
+  for (p = 0; p < sizeof (patterns) / sizeof (patterns[0]); ++p)
+    {
+      for (m = 0; m < sizeof (modes) / sizeof (modes[0]); ++m)
+        {
+          tiz_buffer_t *p_buf = NULL;
+          uint8_t out[16384];
+          size_t total = 0;
+          uint64_t start = 0;
+
+          BENCH_CHECK (OMX_ErrorNone
+                       == tiz_buffer_init (&p_buf, patterns[p].push_len));
+          BENCH_CHECK (-1 != tiz_buffer_seek_mode (p_buf, modes[m]));
+
+          start = bench_now_ns ();
+          while (total < BUFFER_BENCH_STREAM_LEN)
+            {
+              size_t off
+                = total % (BUFFER_BENCH_SOURCE_LEN - patterns[p].push_len);
+              total += tiz_buffer_push (p_buf, source + off,
+                                        patterns[p].push_len);
+              while (tiz_buffer_available (p_buf) > patterns[p].fill_len)
+                {
+                  memcpy (out, tiz_buffer_get (p_buf), patterns[p].read_len);
+                  (void) tiz_buffer_advance (p_buf, patterns[p].read_len);
+                }
+            }
+
+          printf ("buffer [%-8s] mode [%-8s] MB/s [%8.1f]\n",
+                  patterns[p].p_name, mode_names[m],
+                  (double) total * 1e3
+                    / (double) (bench_now_ns () - start + 1));
+          tiz_buffer_destroy (p_buf);
+        }
+    }
+}
+
+/*
+ * PCM: gain, ramp and byte swap, for each instruction set available
+ */
+
+#define PCM_BENCH_SAMPLES 4096
+#define PCM_BENCH_ITERATIONS 2000
+
+static const tiz_pcm_fmt_t pcm_bench_fmts[]
+  = { ETIZPcmFmtS16, ETIZPcmFmtS24, ETIZPcmFmtS24_3, ETIZPcmFmtS32,
+      ETIZPcmFmtFloat };
+
+static const char * pcm_bench_fmt_names[]
+  = { "s16", "s24", "s24_3", "s32", "float" };
+
+/* Fills a buffer with pseudo-random samples in the [-1, 1) range */
+static void
+pcm_bench_fill (uint8_t * ap_buf, const tiz_pcm_fmt_t a_fmt,
+                const size_t a_nsamples)
+{
+  static float flt[PCM_BENCH_SAMPLES];
+  uint32_t state = 42;
+  size_t i;
+
+  assert (a_nsamples <= PCM_BENCH_SAMPLES);
+  for (i = 0; i < a_nsamples; ++i)
+    {
+      state = state * 1664525u + 1013904223u;
+      flt[i] = (float) (int32_t) state / 2147483648.f;
+    }
+  BENCH_CHECK (OMX_ErrorNone
+               == tiz_pcm_from_float (ap_buf, a_fmt, flt, a_nsamples));
+}
+
+/* Returns millions of samples per second */
+static double
+pcm_bench_rate (const uint64_t a_start, const size_t a_nsamples)
+{
+  return (double) a_nsamples * PCM_BENCH_ITERATIONS * 1e3
+         / (double) (bench_now_ns () - a_start + 1);
+}
+
+static void
+bench_pcm (void)
+{
+  static uint8_t buf[PCM_BENCH_SAMPLES * 4];
+  const tiz_pcm_isa_t best = tiz_pcm_get_isa ();
+  tiz_pcm_isa_t isa;
+
+  for (isa = ETIZPcmIsaScalar; isa < ETIZPcmIsaMax; ++isa)
+    {
+      size_t f;
+      if (OMX_ErrorNone != tiz_pcm_set_isa (isa))
+        {
+          continue;
+        }
+      for (f = 0; f < sizeof (pcm_bench_fmts) / sizeof (pcm_bench_fmts[0]);
+           ++f)
+        {
+          const tiz_pcm_fmt_t fmt = pcm_bench_fmts[f];
+          uint64_t start = 0;
+          double gain_rate = 0;
+          double ramp_rate = 0;
+          double swap_rate = 0;
+          int i;
+
+          pcm_bench_fill (buf, fmt, PCM_BENCH_SAMPLES);
+
+          start = bench_now_ns ();
+          for (i = 0; i < PCM_BENCH_ITERATIONS; ++i)
+            {
+              (void) tiz_pcm_gain (buf, fmt, PCM_BENCH_SAMPLES,
+                                   (i & 1) ? 0.5f : 2.f);
+            }
+          gain_rate = pcm_bench_rate (start, PCM_BENCH_SAMPLES);
+
+          start = bench_now_ns ();
+          for (i = 0; i < PCM_BENCH_ITERATIONS; ++i)
+            {
+              (void) tiz_pcm_ramp (buf, fmt, PCM_BENCH_SAMPLES / 2, 2, 1.f,
+                                   (i & 1) ? 1e-5f : -1e-5f);
+            }
+          ramp_rate = pcm_bench_rate (start, PCM_BENCH_SAMPLES);
+
+          start = bench_now_ns ();
+          for (i = 0; i < PCM_BENCH_ITERATIONS; ++i)
+            {
+              (void) tiz_pcm_swap (buf, tiz_pcm_sample_size (fmt),
+                                   PCM_BENCH_SAMPLES);
+            }
+          swap_rate = pcm_bench_rate (start, PCM_BENCH_SAMPLES);
+
+          printf ("pcm [%-6s] fmt [%-5s] Msamples/s gain [%8.1f] "
+                  "ramp [%8.1f] swap [%8.1f]\n",
+                  tiz_pcm_isa_to_str (isa), pcm_bench_fmt_names[f],
+                  gain_rate, ramp_rate, swap_rate);
+        }
+    }
+  (void) tiz_pcm_set_isa (best);
+}
+
+/*
+ * PCM: float conversions, dithered fixed point to s16 and (de)interleaving,
+ * for each instruction set available
+ */
+
+static void
+bench_pcm_convert (void)
+{
+  static float flt[PCM_BENCH_SAMPLES];
+  static uint8_t buf[PCM_BENCH_SAMPLES * 4];
+  static uint8_t planar[2][PCM_BENCH_SAMPLES * 2];
+  const tiz_pcm_isa_t best = tiz_pcm_get_isa ();
+  tiz_pcm_isa_t isa;
+
+  pcm_bench_fill ((uint8_t *) flt, ETIZPcmFmtFloat, PCM_BENCH_SAMPLES);
+
+  for (isa = ETIZPcmIsaScalar; isa < ETIZPcmIsaMax; ++isa)
+    {
+      size_t f;
+      tiz_pcm_dither_t dither;
+      const void * src[] = { planar[0], planar[1] };
+      void * dst[] = { planar[0], planar[1] };
+      uint64_t start = 0;
+      double fixed_rate = 0;
+      double ilv_rate[2] = { 0, 0 };
+      double dilv_rate[2] = { 0, 0 };
+      size_t w;
+      int i;
+
+      if (OMX_ErrorNone != tiz_pcm_set_isa (isa))
+        {
+          continue;
+        }
+
+      for (f = 0; f < sizeof (pcm_bench_fmts) / sizeof (pcm_bench_fmts[0]);
+           ++f)
+        {
+          const tiz_pcm_fmt_t fmt = pcm_bench_fmts[f];
+          double from_rate = 0;
+          double to_rate = 0;
+
+          start = bench_now_ns ();
+          for (i = 0; i < PCM_BENCH_ITERATIONS; ++i)
+            {
+              (void) tiz_pcm_from_float (buf, fmt, flt, PCM_BENCH_SAMPLES);
+            }
+          from_rate = pcm_bench_rate (start, PCM_BENCH_SAMPLES);
+
+          start = bench_now_ns ();
+          for (i = 0; i < PCM_BENCH_ITERATIONS; ++i)
+            {
+              (void) tiz_pcm_to_float (flt, buf, fmt, PCM_BENCH_SAMPLES);
+            }
+          to_rate = pcm_bench_rate (start, PCM_BENCH_SAMPLES);
+
+          printf ("pcm [%-6s] fmt [%-5s] Msamples/s from float [%8.1f] "
+                  "to float [%8.1f]\n",
+                  tiz_pcm_isa_to_str (isa), pcm_bench_fmt_names[f],
+                  from_rate, to_rate);
+        }
+
+      pcm_bench_fill (buf, ETIZPcmFmtS32, PCM_BENCH_SAMPLES);
+      tiz_pcm_dither_init (&dither, 42);
+      start = bench_now_ns ();
+      for (i = 0; i < PCM_BENCH_ITERATIONS; ++i)
+        {
+          (void) tiz_pcm_fixed_to_s16 ((int16_t *) planar[0],
+                                       (const int32_t *) buf,
+                                       PCM_BENCH_SAMPLES, 28, &dither);
+        }
+      fixed_rate = pcm_bench_rate (start, PCM_BENCH_SAMPLES);
+
+      for (w = 0; w < 2; ++w)
+        {
+          const size_t width = w ? 4 : 2;
+          const size_t nframes = PCM_BENCH_SAMPLES * 2 / width / 2;
+          start = bench_now_ns ();
+          for (i = 0; i < PCM_BENCH_ITERATIONS; ++i)
+            {
+              (void) tiz_pcm_interleave (buf, src, width, 2, nframes);
+            }
+          ilv_rate[w] = pcm_bench_rate (start, nframes * 2);
+
+          start = bench_now_ns ();
+          for (i = 0; i < PCM_BENCH_ITERATIONS; ++i)
+            {
+              (void) tiz_pcm_deinterleave (dst, buf, width, 2, nframes);
+            }
+          dilv_rate[w] = pcm_bench_rate (start, nframes * 2);
+        }
+
+      printf ("pcm [%-6s] Msamples/s fixed to s16 dithered [%8.1f] "
+              "interleave 16/32 [%8.1f/%8.1f] deinterleave 16/32 "
+              "[%8.1f/%8.1f]\n",
+              tiz_pcm_isa_to_str (isa), fixed_rate, ilv_rate[0], ilv_rate[1],
+              dilv_rate[0], dilv_rate[1]);
+    }
+  (void) tiz_pcm_set_isa (best);
+}
+
+typedef struct bench bench_t;
+struct bench
+{
+  const char *p_name;
+  void (*pf_run) (void);
+};
+
+static const bench_t benches[] = {
+  { "queue", bench_queue },
+  { "buffer", bench_buffer },
+  { "pcm", bench_pcm },
+  { "pcm-convert", bench_pcm_convert },
+};
+
+int
+main (int argc, char **argv)
+{
+  const size_t nbenches = sizeof (benches) / sizeof (benches[0]);
+  int status = EXIT_SUCCESS;
+  size_t b;
+  int i;
+
+  tiz_log_init ();
+
+  if (argc < 2)
+    {
+      for (b = 0; b < nbenches; b++)
+        {
+          benches[b].pf_run ();
+        }
+    }
+
+  for (i = 1; i < argc; i++)
+    {
+      for (b = 0; b < nbenches; b++)
+        {
+          if (0 == strcmp (argv[i], benches[b].p_name))
+            {
+              benches[b].pf_run ();
+              break;
+            }
+        }
+      if (b == nbenches)
+        {
+          fprintf (stderr, "%s: unknown benchmark '%s'\n", argv[0], argv[i]);
+          status = EXIT_FAILURE;
+        }
+    }
+
+  tiz_log_deinit ();
+
+  return status;
+}
+
+/* Local Variables: */
+/* c-default-style: gnu */
+/* fill-column: 79 */
+/* indent-tabs-mode: nil */
+/* compile-command: "make bench_tizplatform" */
+/* End: */
@@ -0,0 +1,251 @@
+/**
+ * Copyright (C) 2011-2017 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   check_buffer.c
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Dynamic buffer API unit tests
+ *
+ *
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#define BUFFER_TEST_STREAM_LEN (4 * 1024 * 1024)
+
+static uint8_t buffer_test_stream[BUFFER_TEST_STREAM_LEN];
+
+static uint32_t
+buffer_test_rand (uint32_t * ap_state)
+{
+  *ap_state = *ap_state * 1664525u + 1013904223u;
+  return *ap_state >> 8;
+}
+
+static void
+buffer_test_fill_stream (void)
+{
+  uint32_t seed = 7;
+  size_t i = 0;
+  for (i = 0; i < BUFFER_TEST_STREAM_LEN; ++i)
+    {
+      buffer_test_stream[i] = (uint8_t) buffer_test_rand (&seed);
+    }
+}
+
+/* Pushes the test stream in chunks of random size, and consumes it, also in
+   random amounts, checking that what comes out is what went in. Returns the
+   number of bytes verified. */
+static size_t
+buffer_test_stream_through (tiz_buffer_t * ap_buf, const size_t a_max_push,
+                            const size_t a_max_read, const bool a_peek)
+{
+  uint32_t seed = 11;
+  size_t pushed = 0;
+  size_t consumed = 0;
+
+  while (consumed < BUFFER_TEST_STREAM_LEN)
+    {
+      const size_t push_rnd = 1 + buffer_test_rand (&seed) % a_max_push;
+      const size_t read_rnd = buffer_test_rand (&seed) % a_max_read;
+      const size_t push_len = MIN (push_rnd, BUFFER_TEST_STREAM_LEN - pushed);
+      size_t avail = 0;
+      size_t read_len = 0;
+
+      if (push_len > 0)
+        {
+          pushed
+            += tiz_buffer_push (ap_buf, buffer_test_stream + pushed, push_len);
+        }
+
+      avail = tiz_buffer_available (ap_buf);
+      fail_if (avail != pushed - consumed);
+
+      read_len = MIN (avail, read_rnd);
+      if (pushed == BUFFER_TEST_STREAM_LEN)
+        {
+          read_len = avail;
+        }
+
+      if (a_peek)
+        {
+          void * p_first = NULL;
+          void * p_second = NULL;
+          size_t first_len = 0;
+          size_t second_len = 0;
+          fail_if (avail
+                   != tiz_buffer_peek (ap_buf, &p_first, &first_len,
+                                       &p_second, &second_len));
+          fail_if (first_len + second_len != avail);
+          fail_if (0 != memcmp (p_first, buffer_test_stream + consumed,
+                                MIN (first_len, read_len)));
+          if (read_len > first_len)
+            {
+              fail_if (0 != memcmp (p_second,
+                                    buffer_test_stream + consumed + first_len,
+                                    read_len - first_len));
+            }
+        }
+      else
+        {
+          fail_if (0 != memcmp (tiz_buffer_get (ap_buf),
+                                buffer_test_stream + consumed, read_len));
+        }
+
+      fail_if (read_len != tiz_buffer_advance (ap_buf, read_len));
+      consumed += read_len;
+    }
+
+  fail_if (0 != tiz_buffer_available (ap_buf));
+  return consumed;
+}
+
+START_TEST (test_buffer_non_seekable)
+{
+  tiz_buffer_t * p_buf = NULL;
+
+  buffer_test_fill_stream ();
+  fail_if (OMX_ErrorNone != tiz_buffer_init (&p_buf, 1024));
+
+  /* Pushes larger than twice the current store size must not be truncated */
+  fail_if (8192 != tiz_buffer_push (p_buf, buffer_test_stream, 8192));
+  fail_if (8192 != tiz_buffer_available (p_buf));
+  tiz_buffer_clear (p_buf);
+
+  fail_if (BUFFER_TEST_STREAM_LEN
+           != buffer_test_stream_through (p_buf, 16384, 20000, false));
+
+  tiz_buffer_destroy (p_buf);
+}
+END_TEST
+
+START_TEST (test_buffer_circular)
+{
+  tiz_buffer_t * p_buf = NULL;
+
+  buffer_test_fill_stream ();
+  fail_if (OMX_ErrorNone != tiz_buffer_init (&p_buf, 1000));
+
+  /* Data already in the buffer survives the change of mode */
+  fail_if (10 != tiz_buffer_push (p_buf, buffer_test_stream, 10));
+  fail_if (4 != tiz_buffer_advance (p_buf, 4));
+  fail_if (TIZ_BUFFER_NON_SEEKABLE
+           != tiz_buffer_seek_mode (p_buf, TIZ_BUFFER_CIRCULAR));
+  fail_if (6 != tiz_buffer_available (p_buf));
+  fail_if (0 != memcmp (tiz_buffer_get (p_buf), buffer_test_stream + 4, 6));
+  tiz_buffer_clear (p_buf);
+
+  /* Reads through tiz_buffer_get and tiz_buffer_peek */
+  fail_if (BUFFER_TEST_STREAM_LEN
+           != buffer_test_stream_through (p_buf, 16384, 20000, false));
+  fail_if (BUFFER_TEST_STREAM_LEN
+           != buffer_test_stream_through (p_buf, 4096, 5000, true));
+
+  /* Only forward seeks */
+  fail_if (0 != tiz_buffer_seek (p_buf, 0, TIZ_BUFFER_SEEK_CUR));
+  fail_if (-1 != tiz_buffer_seek (p_buf, 0, TIZ_BUFFER_SEEK_SET));
+  fail_if (-1 != tiz_buffer_seek (p_buf, -1, TIZ_BUFFER_SEEK_CUR));
+
+  /* And back to a linear store */
+  fail_if (100 != tiz_buffer_push (p_buf, buffer_test_stream, 100));
+  fail_if (TIZ_BUFFER_CIRCULAR
+           != tiz_buffer_seek_mode (p_buf, TIZ_BUFFER_SEEKABLE));
+  fail_if (100 != tiz_buffer_available (p_buf));
+  fail_if (0 != memcmp (tiz_buffer_get (p_buf), buffer_test_stream, 100));
+
+  tiz_buffer_destroy (p_buf);
+}
+END_TEST
+
+START_TEST (test_buffer_high_watermark)
+{
+  tiz_buffer_t * p_buf = NULL;
+  static const int modes[] = {TIZ_BUFFER_NON_SEEKABLE, TIZ_BUFFER_CIRCULAR};
+  size_t pushed = 0;
+  size_t m = 0;
+
+  buffer_test_fill_stream ();
+
+  for (m = 0; m < sizeof (modes) / sizeof (modes[0]); ++m)
+    {
+      fail_if (OMX_ErrorNone != tiz_buffer_init (&p_buf, 4096));
+      fail_if (-1 == tiz_buffer_seek_mode (p_buf, modes[m]));
+      tiz_buffer_set_high_watermark (p_buf, 65536);
+
+      pushed = tiz_buffer_push (p_buf, buffer_test_stream, 65536);
+      fail_if (65536 != pushed);
+      fail_if (0 != tiz_buffer_push (p_buf, buffer_test_stream, 1));
+
+      /* Room is made again by consuming data */
+      fail_if (1000 != tiz_buffer_advance (p_buf, 1000));
+      fail_if (1000 != tiz_buffer_push (p_buf, buffer_test_stream, 2000));
+      fail_if (65536 != tiz_buffer_available (p_buf));
+      fail_if (0 != memcmp (tiz_buffer_get (p_buf), buffer_test_stream + 1000,
+                            64536));
+      fail_if (0 != memcmp ((uint8_t *) tiz_buffer_get (p_buf) + 64536,
+                            buffer_test_stream, 1000));
+
+      tiz_buffer_destroy (p_buf);
+    }
+}
+END_TEST
+
+START_TEST (test_buffer_seek)
+{
+  tiz_buffer_t * p_buf = NULL;
+
+  buffer_test_fill_stream ();
+  fail_if (OMX_ErrorNone != tiz_buffer_init (&p_buf, 256));
+
+  /* Non-seekable: data behind the marker is discarded on push */
+  fail_if (100 != tiz_buffer_push (p_buf, buffer_test_stream, 100));
+  fail_if (40 != tiz_buffer_advance (p_buf, 40));
+  fail_if (40 != tiz_buffer_offset (p_buf));
+  fail_if (100 != tiz_buffer_push (p_buf, buffer_test_stream + 100, 100));
+  fail_if (0 != tiz_buffer_offset (p_buf));
+  fail_if (0 != tiz_buffer_seek (p_buf, 0, TIZ_BUFFER_SEEK_SET));
+  fail_if (160 != tiz_buffer_available (p_buf));
+  fail_if (0 != memcmp (tiz_buffer_get (p_buf), buffer_test_stream + 40, 160));
+
+  /* Seekable: nothing is discarded */
+  tiz_buffer_clear (p_buf);
+  fail_if (TIZ_BUFFER_NON_SEEKABLE
+           != tiz_buffer_seek_mode (p_buf, TIZ_BUFFER_SEEKABLE));
+  fail_if (1000 != tiz_buffer_push (p_buf, buffer_test_stream, 1000));
+  fail_if (0 != tiz_buffer_seek (p_buf, 600, TIZ_BUFFER_SEEK_SET));
+  fail_if (1000 != tiz_buffer_push (p_buf, buffer_test_stream + 1000, 1000));
+  fail_if (0 != tiz_buffer_seek (p_buf, -100, TIZ_BUFFER_SEEK_CUR));
+  fail_if (500 != tiz_buffer_offset (p_buf));
+  fail_if (0 != tiz_buffer_seek (p_buf, -10, TIZ_BUFFER_SEEK_END));
+  fail_if (10 != tiz_buffer_available (p_buf));
+  fail_if (0 != memcmp (tiz_buffer_get (p_buf), buffer_test_stream + 1990, 10));
+  fail_if (-1 != tiz_buffer_seek (p_buf, -10, TIZ_BUFFER_SEEK_SET));
+
+  tiz_buffer_destroy (p_buf);
+}
+END_TEST
+
+/* Local Variables: */
+/* c-default-style: gnu */
+/* fill-column: 79 */
+/* indent-tabs-mode: nil */
+/* compile-command: "make check" */
+/* End: */
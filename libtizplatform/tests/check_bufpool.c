@@ -0,0 +1,186 @@
+/**
+ * Copyright (C) 2011-2017 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   check_bufpool.c
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  OpenMAX IL buffer pool unit tests
+ *
+ *
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+#define BUFPOOL_TEST_NBUFS 4
+
+static bool
+bufpool_test_is_aligned (const void * ap_buf, const size_t a_alignment)
+{
+  return 0 == ((uintptr_t) ap_buf % a_alignment);
+}
+
+START_TEST (test_bufpool_alignment)
+{
+  const size_t page = (size_t) sysconf (_SC_PAGESIZE);
+  static const size_t sizes[] = {1, 100, 4096, 8192 + 3, 345600};
+  size_t i = 0;
+
+  for (i = 0; i < sizeof (sizes) / sizeof (sizes[0]); ++i)
+    {
+      OMX_U8 * p_def = NULL;
+      OMX_U8 * p_odd = NULL;
+      OMX_U8 * p_page = NULL;
+
+      /* Drop the (dirty) buffers of the previous round */
+      tiz_bufpool_trim ();
+
+      p_def = tiz_bufpool_alloc (sizes[i], 0, 0);
+      p_odd = tiz_bufpool_alloc (sizes[i], 100, 0);
+      p_page = tiz_bufpool_alloc (sizes[i], 0, TIZ_BUFPOOL_PAGE_ALIGNED);
+      fail_if (!p_def || !p_odd || !p_page);
+      fail_if (!bufpool_test_is_aligned (p_def,
+                                         TIZ_BUFPOOL_DEFAULT_ALIGNMENT));
+      fail_if (!bufpool_test_is_aligned (p_odd, 128));
+      fail_if (!bufpool_test_is_aligned (p_page, page));
+      /* New buffers come zeroed */
+      fail_if (0 != p_def[0] || 0 != p_def[sizes[i] - 1]);
+      memset (p_def, 0xa5, sizes[i]);
+      memset (p_odd, 0xa5, sizes[i]);
+      memset (p_page, 0xa5, sizes[i]);
+      tiz_bufpool_free (p_def);
+      tiz_bufpool_free (p_odd);
+      tiz_bufpool_free (p_page);
+    }
+
+  tiz_bufpool_trim ();
+}
+END_TEST
+
+START_TEST (test_bufpool_reuse)
+{
+  OMX_U8 * bufs[BUFPOOL_TEST_NBUFS];
+  OMX_U8 * p_buf = NULL;
+  tiz_bufpool_info_t before;
+  tiz_bufpool_info_t after;
+  int i = 0;
+  int j = 0;
+
+  tiz_bufpool_trim ();
+  tiz_bufpool_info (&before);
+
+  /* An Idle->Loaded->Idle cycle of a port */
+  for (i = 0; i < BUFPOOL_TEST_NBUFS; ++i)
+    {
+      fail_if (!(bufs[i] = tiz_bufpool_alloc (8192, 0, 0)));
+    }
+  for (i = 0; i < BUFPOOL_TEST_NBUFS; ++i)
+    {
+      tiz_bufpool_free (bufs[i]);
+    }
+
+  tiz_bufpool_info (&after);
+  fail_if (after.misses - before.misses != BUFPOOL_TEST_NBUFS);
+  fail_if (after.cached_bufs != BUFPOOL_TEST_NBUFS);
+  fail_if (after.used_bufs != before.used_bufs);
+
+  for (i = 0; i < BUFPOOL_TEST_NBUFS; ++i)
+    {
+      fail_if (!(p_buf = tiz_bufpool_alloc (8192, 0, 0)));
+      for (j = 0; j < BUFPOOL_TEST_NBUFS && bufs[j] != p_buf; ++j)
+        {
+        }
+      fail_if (j == BUFPOOL_TEST_NBUFS);
+    }
+
+  tiz_bufpool_info (&after);
+  fail_if (after.hits - before.hits != BUFPOOL_TEST_NBUFS);
+  fail_if (after.misses - before.misses != BUFPOOL_TEST_NBUFS);
+  fail_if (after.cached_bufs != 0);
+  fail_if (after.used_bufs - before.used_bufs != BUFPOOL_TEST_NBUFS);
+
+  /* A different size needs a new buffer */
+  fail_if (!(p_buf = tiz_bufpool_alloc (16384, 0, 0)));
+  tiz_bufpool_info (&after);
+  fail_if (after.misses - before.misses != BUFPOOL_TEST_NBUFS + 1);
+
+  tiz_bufpool_free (p_buf);
+  for (i = 0; i < BUFPOOL_TEST_NBUFS; ++i)
+    {
+      tiz_bufpool_free (bufs[i]);
+    }
+
+  tiz_bufpool_trim ();
+  tiz_bufpool_info (&after);
+  fail_if (after.cached_bufs != 0 || after.cached_bytes != 0);
+  fail_if (after.used_bufs != before.used_bufs);
+}
+END_TEST
+
+START_TEST (test_bufpool_hugepages)
+{
+  const size_t page = (size_t) sysconf (_SC_PAGESIZE);
+  const size_t size = 1920 * 1080 * 3 / 2;
+  OMX_U8 * p_buf = NULL;
+  OMX_U8 * p_again = NULL;
+
+  /* Whether huge pages are used depends on the system; the buffer must be
+     usable either way */
+  fail_if (!(p_buf = tiz_bufpool_alloc (size, 0, TIZ_BUFPOOL_HUGEPAGES)));
+  fail_if (!bufpool_test_is_aligned (p_buf, page));
+  fail_if (0 != p_buf[0] || 0 != p_buf[size - 1]);
+  memset (p_buf, 0x5a, size);
+  tiz_bufpool_free (p_buf);
+
+  fail_if (!(p_again = tiz_bufpool_alloc (size, 0, TIZ_BUFPOOL_HUGEPAGES)));
+  fail_if (p_again != p_buf);
+  tiz_bufpool_free (p_again);
+
+  tiz_bufpool_trim ();
+}
+END_TEST
+
+START_TEST (test_bufpool_hooks)
+{
+  OMX_U32 size = 345600;
+  OMX_U32 flags = TIZ_BUFPOOL_PAGE_ALIGNED;
+  OMX_PTR p_priv = NULL;
+  OMX_U8 * p_buf = NULL;
+
+  fail_if (!(p_buf = tiz_bufpool_alloc_hook (&size, &p_priv, NULL)));
+  fail_if (size != 345600);
+  fail_if (!bufpool_test_is_aligned (p_buf, TIZ_BUFPOOL_DEFAULT_ALIGNMENT));
+  tiz_bufpool_free_hook (p_buf, p_priv, NULL);
+
+  fail_if (!(p_buf = tiz_bufpool_alloc_hook (&size, &p_priv, &flags)));
+  fail_if (!bufpool_test_is_aligned (p_buf, (size_t) sysconf (_SC_PAGESIZE)));
+  tiz_bufpool_free_hook (p_buf, p_priv, &flags);
+
+  tiz_bufpool_trim ();
+}
+END_TEST
+
+/* Local Variables: */
+/* c-default-style: gnu */
+/* fill-column: 79 */
+/* indent-tabs-mode: nil */
+/* compile-command: "make check" */
+/* End: */
@@ -0,0 +1,179 @@
+/**
+ * Copyright (C) 2011-2017 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   check_log.c
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Logging API unit tests (asynchronous backend)
+ *
+ *
+ */
+
+#include <pthread.h>
+#include <string.h>
+
+#define CHECK_LOG_CATEGORY "tiz.platform.check.log"
+#define CHECK_LOG_MAX_RECORDS 256
+#define CHECK_LOG_RECORD_COUNT 100
+#define CHECK_LOG_MSG_SIZE 64
+
+typedef struct check_log_record check_log_record_t;
+struct check_log_record
+{
+  char msg[CHECK_LOG_MSG_SIZE];
+  pthread_t writer;
+};
+
+static check_log_record_t g_log_records[CHECK_LOG_MAX_RECORDS];
+static int g_log_count = 0;
+
+/* Only called from the backend's writer thread */
+static int
+check_log_append (log4c_appender_t * ap_app,
+                  const log4c_logging_event_t * ap_evt)
+{
+  (void) ap_app;
+  if (g_log_count < CHECK_LOG_MAX_RECORDS)
+    {
+      snprintf (g_log_records[g_log_count].msg, CHECK_LOG_MSG_SIZE, "%s",
+                ap_evt->evt_msg);
+      g_log_records[g_log_count].writer = pthread_self ();
+    }
+  ++g_log_count;
+  return 0;
+}
+
+static const log4c_appender_type_t check_log_appender_type = {
+  "check_log", NULL, check_log_append, NULL
+};
+
+/* (Re)starts the logging subsystem with the asynchronous backend enabled and
+   sends everything logged to CHECK_LOG_CATEGORY to check_log_append */
+static void
+check_log_start_async (void)
+{
+  log4c_category_t * p_cat = NULL;
+  log4c_appender_t * p_app = NULL;
+
+  tiz_log_deinit ();
+  fail_if (0 != setenv ("TIZONIA_LOG_ASYNC", "1", 1));
+  tiz_log_init ();
+
+  (void) log4c_appender_type_set (&check_log_appender_type);
+  p_app = log4c_appender_get ("check_log");
+  fail_if (NULL == p_app);
+  (void) log4c_appender_set_type (p_app, &check_log_appender_type);
+
+  p_cat = log4c_category_get (CHECK_LOG_CATEGORY);
+  fail_if (NULL == p_cat);
+  (void) log4c_category_set_appender (p_cat, p_app);
+  (void) log4c_category_set_priority (p_cat, LOG4C_PRIORITY_NOTICE);
+  (void) log4c_category_set_additivity (p_cat, 0);
+
+  g_log_count = 0;
+}
+
+static void
+check_log_restore (void)
+{
+  (void) unsetenv ("TIZONIA_LOG_ASYNC");
+  tiz_log_init ();
+}
+
+static void
+check_log_records (const pthread_t a_caller)
+{
+  int i = 0;
+  char expected[CHECK_LOG_MSG_SIZE];
+
+  fail_if (CHECK_LOG_RECORD_COUNT != g_log_count);
+  for (i = 0; i < CHECK_LOG_RECORD_COUNT; ++i)
+    {
+      snprintf (expected, sizeof (expected), "record %d str%d", i, i);
+      fail_if (0 != strcmp (expected, g_log_records[i].msg));
+      /* Written by the backend's thread, not by the thread that logged it */
+      fail_if (pthread_equal (a_caller, g_log_records[i].writer));
+    }
+}
+
+static void
+check_log_emit_records (void)
+{
+  int i = 0;
+  char buf[CHECK_LOG_MSG_SIZE];
+
+  for (i = 0; i < CHECK_LOG_RECORD_COUNT; ++i)
+    {
+      snprintf (buf, sizeof (buf), "str%d", i);
+      TIZ_LOG_SITE (CHECK_LOG_CATEGORY, TIZ_PRIORITY_NOTICE, NULL, NULL,
+                    "record %d %s", i, buf);
+      /* The record must have captured the string, not the pointer */
+      snprintf (buf, sizeof (buf), "overwritten");
+    }
+}
+
+static void *
+check_log_thread_func (void * ap_arg)
+{
+  *(pthread_t *) ap_arg = pthread_self ();
+  check_log_emit_records ();
+  return NULL;
+}
+
+START_TEST (test_log_async_queue_and_flush)
+{
+  check_log_start_async ();
+
+  check_log_emit_records ();
+
+  /* Whatever is still queued is written out before deinit returns */
+  tiz_log_deinit ();
+  check_log_records (pthread_self ());
+
+  check_log_restore ();
+}
+END_TEST
+
+START_TEST (test_log_async_flush_exited_thread)
+{
+  pthread_t thread;
+  pthread_t logger;
+
+  check_log_start_async ();
+
+  /* The records of a thread that has exited are still written out */
+  fail_if (0 != pthread_create (&thread, NULL, check_log_thread_func,
+                                &logger));
+  fail_if (0 != pthread_join (thread, NULL));
+
+  tiz_log_deinit ();
+  check_log_records (logger);
+  fail_if (pthread_equal (pthread_self (), g_log_records[0].writer));
+
+  check_log_restore ();
+}
+END_TEST
+
+/* Local Variables: */
+/* c-default-style: gnu */
+/* fill-column: 79 */
+/* indent-tabs-mode: nil */
+/* compile-command: "make check" */
+/* End: */
@@ -0,0 +1,534 @@
+/**
+ * Copyright (C) 2011-2017 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   check_pcm.c
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  PCM sample processing API unit tests
+ *
+ *
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#define PCM_TEST_MAX_SAMPLES 8192
+
+static const size_t pcm_test_lengths[]
+  = { 0, 1, 3, 7, 8, 9, 15, 16, 17, 31, 33, 1000, 1023, 1024, 1025, 4099 };
+
+static const float pcm_test_gains[]
+  = { 0.f, 0.25f, 0.5f, 0.7071f, 1.0001f, 1.7f, 3.1f, -1.f, 1e6f };
+
+static const tiz_pcm_fmt_t pcm_test_fmts[]
+  = { ETIZPcmFmtS16, ETIZPcmFmtS24, ETIZPcmFmtS24_3, ETIZPcmFmtS32,
+      ETIZPcmFmtFloat };
+
+static const char * pcm_test_fmt_names[]
+  = { "s16", "s24", "s24_3", "s32", "float" };
+
+static uint32_t
+pcm_test_rand (uint32_t * ap_state)
+{
+  *ap_state = *ap_state * 1664525u + 1013904223u;
+  return *ap_state;
+}
+
+/* Fills a buffer with pseudo-random samples, including the extremes of the
+   format every now and then so that clamping gets exercised */
+static void
+pcm_test_fill (uint8_t * ap_buf, const tiz_pcm_fmt_t a_fmt,
+               const size_t a_nsamples, uint32_t a_seed)
+{
+  size_t i = 0;
+  for (i = 0; i < a_nsamples; ++i)
+    {
+      const uint32_t r = pcm_test_rand (&a_seed);
+      const bool extreme = (r % 13) == 0;
+      switch (a_fmt)
+        {
+          case ETIZPcmFmtS16:
+            {
+              int16_t v = extreme ? ((r & 0x100) ? 32767 : -32768)
+                                  : (int16_t) (r >> 16);
+              memcpy (ap_buf + i * 2, &v, 2);
+            }
+            break;
+          case ETIZPcmFmtS24:
+            {
+              /* Leave garbage in the top byte of the container; only the
+                 low 24 bits are significant */
+              int32_t v = extreme ? ((r & 0x100) ? 0x7FFFFF : 0x800000)
+                                  : (int32_t) r;
+              memcpy (ap_buf + i * 4, &v, 4);
+            }
+            break;
+          case ETIZPcmFmtS24_3:
+            {
+              ap_buf[i * 3] = (uint8_t) (r >> 8);
+              ap_buf[i * 3 + 1] = (uint8_t) (r >> 16);
+              ap_buf[i * 3 + 2] = (uint8_t) (r >> 24);
+            }
+            break;
+          case ETIZPcmFmtS32:
+            {
+              int32_t v = extreme ? ((r & 0x100) ? INT32_MAX : INT32_MIN)
+                                  : (int32_t) r;
+              memcpy (ap_buf + i * 4, &v, 4);
+            }
+            break;
+          case ETIZPcmFmtFloat:
+            {
+              float v = ((float) (int32_t) r / 2147483648.f) * 1.2f;
+              memcpy (ap_buf + i * 4, &v, 4);
+            }
+            break;
+          default:
+            assert (0);
+            break;
+        };
+    }
+}
+
+static void
+pcm_test_gain_ref (uint8_t * ap_buf, const tiz_pcm_fmt_t a_fmt,
+                   const size_t a_nsamples, const float a_gain)
+{
+  fail_if (OMX_ErrorNone != tiz_pcm_set_isa (ETIZPcmIsaScalar));
+  fail_if (OMX_ErrorNone != tiz_pcm_gain (ap_buf, a_fmt, a_nsamples, a_gain));
+}
+
+START_TEST (test_pcm_gain_values)
+{
+  int16_t s16[] = { 1000, 3, 5, -3, 32767, -32768, 20000, -20000 };
+  const int16_t s16_half[] = { 500, 2, 2, -2, 16384, -16384, 10000, -10000 };
+  int32_t s24[] = { 0x00FFFFFF, 0x7FFFFF, 0x12800000, 100 };
+  const int32_t s24_twice[] = { -2, 0x7FFFFF, -0x800000, 200 };
+  float flt[] = { 0.5f, -0.25f };
+
+  fail_if (OMX_ErrorNone != tiz_pcm_set_isa (ETIZPcmIsaScalar));
+
+  /* Ties round to even */
+  fail_if (OMX_ErrorNone != tiz_pcm_gain (s16, ETIZPcmFmtS16, 8, 0.5f));
+  fail_if (0 != memcmp (s16, s16_half, sizeof (s16)));
+
+  fail_if (OMX_ErrorNone != tiz_pcm_gain (s16, ETIZPcmFmtS16, 8, 10.f));
+  fail_if (s16[0] != 5000);
+  fail_if (s16[4] != 32767);
+  fail_if (s16[5] != -32768);
+
+  /* 24-bit samples are sign-extended from bit 23 and saturated */
+  fail_if (OMX_ErrorNone != tiz_pcm_gain (s24, ETIZPcmFmtS24, 4, 2.f));
+  fail_if (0 != memcmp (s24, s24_twice, sizeof (s24)));
+
+  fail_if (OMX_ErrorNone != tiz_pcm_gain (flt, ETIZPcmFmtFloat, 2, 2.f));
+  fail_if (flt[0] != 1.f || flt[1] != -0.5f);
+
+  fail_if (tiz_pcm_db_to_gain (0.f) != 1.f);
+  fail_if (tiz_pcm_db_to_gain (-6.0206f) > 0.5001f
+           || tiz_pcm_db_to_gain (-6.0206f) < 0.4999f);
+
+  fail_if (OMX_ErrorBadParameter
+           != tiz_pcm_gain (s16, ETIZPcmFmtMax, 8, 0.5f));
+  fail_if (OMX_ErrorBadParameter
+           != tiz_pcm_ramp (s16, ETIZPcmFmtS16, 4, 0, 0.f, 0.1f));
+  fail_if (OMX_ErrorBadParameter != tiz_pcm_swap (s16, 5, 8));
+}
+END_TEST
+
+START_TEST (test_pcm_gain_bit_exact)
+{
+  static uint8_t ref[PCM_TEST_MAX_SAMPLES * 4];
+  static uint8_t out[PCM_TEST_MAX_SAMPLES * 4];
+  tiz_pcm_isa_t isa;
+
+  for (isa = ETIZPcmIsaSse2; isa < ETIZPcmIsaMax; ++isa)
+    {
+      size_t f, l, g;
+      if (OMX_ErrorNone != tiz_pcm_set_isa (isa))
+        {
+          TIZ_LOG (TIZ_PRIORITY_TRACE, "[%s] not supported - skipping",
+                   tiz_pcm_isa_to_str (isa));
+          continue;
+        }
+      for (f = 0; f < sizeof (pcm_test_fmts) / sizeof (pcm_test_fmts[0]); ++f)
+        {
+          const tiz_pcm_fmt_t fmt = pcm_test_fmts[f];
+          const size_t size = tiz_pcm_sample_size (fmt);
+          for (l = 0;
+               l < sizeof (pcm_test_lengths) / sizeof (pcm_test_lengths[0]);
+               ++l)
+            {
+              const size_t len = pcm_test_lengths[l];
+              for (g = 0;
+                   g < sizeof (pcm_test_gains) / sizeof (pcm_test_gains[0]);
+                   ++g)
+                {
+                  pcm_test_fill (ref, fmt, len, (uint32_t) (l * 31 + g));
+                  memcpy (out, ref, len * size);
+                  pcm_test_gain_ref (ref, fmt, len, pcm_test_gains[g]);
+                  fail_if (OMX_ErrorNone != tiz_pcm_set_isa (isa));
+                  fail_if (OMX_ErrorNone
+                           != tiz_pcm_gain (out, fmt, len, pcm_test_gains[g]));
+                  fail_if (0 != memcmp (ref, out, len * size),
+                           "[%s] fmt [%s] len [%zu] gain [%f] mismatch",
+                           tiz_pcm_isa_to_str (isa), pcm_test_fmt_names[f],
+                           len, pcm_test_gains[g]);
+                }
+            }
+        }
+    }
+}
+END_TEST
+
+START_TEST (test_pcm_ramp_bit_exact)
+{
+  static uint8_t ref[PCM_TEST_MAX_SAMPLES * 4];
+  static uint8_t out[PCM_TEST_MAX_SAMPLES * 4];
+  const OMX_U32 channels[] = { 1, 2, 3, 6, 8 };
+  const size_t frames[] = { 0, 1, 5, 333, 1000 };
+  tiz_pcm_isa_t isa;
+
+  for (isa = ETIZPcmIsaScalar; isa < ETIZPcmIsaMax; ++isa)
+    {
+      size_t f, c, n;
+      if (OMX_ErrorNone != tiz_pcm_set_isa (isa))
+        {
+          continue;
+        }
+      for (f = 0; f < sizeof (pcm_test_fmts) / sizeof (pcm_test_fmts[0]); ++f)
+        {
+          const tiz_pcm_fmt_t fmt = pcm_test_fmts[f];
+          const size_t size = tiz_pcm_sample_size (fmt);
+          for (c = 0; c < sizeof (channels) / sizeof (channels[0]); ++c)
+            {
+              for (n = 0; n < sizeof (frames) / sizeof (frames[0]); ++n)
+                {
+                  const size_t nsamples = frames[n] * channels[c];
+                  const float step = 1.5f / (float) (frames[n] + 1);
+                  const size_t half = frames[n] / 2;
+                  const float resume = 0.25f + (float) half * step;
+                  size_t i;
+
+                  /* Reference: scalar constant gain, one frame at a time */
+                  pcm_test_fill (ref, fmt, nsamples, (uint32_t) (c * 7 + n));
+                  memcpy (out, ref, nsamples * size);
+                  for (i = 0; i < frames[n]; ++i)
+                    {
+                      const float gain
+                        = i < half ? 0.25f + (float) i * step
+                                   : resume + (float) (i - half) * step;
+                      pcm_test_gain_ref (ref + i * channels[c] * size, fmt,
+                                         channels[c], gain);
+                    }
+
+                  /* Ramp split in two calls, to check that it continues */
+                  fail_if (OMX_ErrorNone != tiz_pcm_set_isa (isa));
+                  fail_if (OMX_ErrorNone
+                           != tiz_pcm_ramp (out, fmt, half, channels[c],
+                                            0.25f, step));
+                  fail_if (OMX_ErrorNone
+                           != tiz_pcm_ramp (out + half * channels[c] * size,
+                                            fmt, frames[n] - half,
+                                            channels[c], resume, step));
+
+                  fail_if (0 != memcmp (ref, out, nsamples * size),
+                           "[%s] fmt [%s] channels [%u] frames [%zu] "
+                           "mismatch",
+                           tiz_pcm_isa_to_str (isa), pcm_test_fmt_names[f],
+                           (unsigned) channels[c], frames[n]);
+                }
+            }
+        }
+    }
+}
+END_TEST
+
+START_TEST (test_pcm_swap)
+{
+  static uint8_t ref[PCM_TEST_MAX_SAMPLES * 4];
+  static uint8_t out[PCM_TEST_MAX_SAMPLES * 4];
+  tiz_pcm_isa_t isa;
+
+  for (isa = ETIZPcmIsaScalar; isa < ETIZPcmIsaMax; ++isa)
+    {
+      size_t width, l;
+      if (OMX_ErrorNone != tiz_pcm_set_isa (isa))
+        {
+          continue;
+        }
+      for (width = 2; width <= 4; ++width)
+        {
+          for (l = 0;
+               l < sizeof (pcm_test_lengths) / sizeof (pcm_test_lengths[0]);
+               ++l)
+            {
+              const size_t len = pcm_test_lengths[l];
+              size_t i, b;
+              pcm_test_fill (ref, ETIZPcmFmtS32, len, (uint32_t) l);
+              memcpy (out, ref, len * width);
+              fail_if (OMX_ErrorNone != tiz_pcm_swap (out, width, len));
+              for (i = 0; i < len; ++i)
+                {
+                  for (b = 0; b < width; ++b)
+                    {
+                      fail_if (out[i * width + b]
+                                 != ref[i * width + width - 1 - b],
+                               "[%s] width [%zu] len [%zu] mismatch",
+                               tiz_pcm_isa_to_str (isa), width, len);
+                    }
+                }
+              fail_if (OMX_ErrorNone != tiz_pcm_swap (out, width, len));
+              fail_if (0 != memcmp (ref, out, len * width));
+            }
+        }
+    }
+}
+END_TEST
+
+START_TEST (test_pcm_convert_values)
+{
+  const float flt[]
+    = { 0.f, 0.5f, -0.5f, 1.f, -1.f, 2.f, -2.f, 1.5f / 32768.f };
+  const int16_t s16[] = { 0, 16384, -16384, 32767, -32768, 32767, -32768, 2 };
+  const int32_t s24[]
+    = { 0, 0x400000, -0x400000, 0x7FFFFF, -0x800000, 0x7FFFFF, -0x800000,
+        384 };
+  const int32_t mad[] = { 0, 1 << 27, -(1 << 27), 1 << 28, -(1 << 28),
+                          (1 << 12) - 1, 1 << 12, 0x7FFFFFFF };
+  const int16_t mad_s16[] = { 0, 16384, -16384, 32767, -32768, 0, 1, 32767 };
+  const int16_t stereo[] = { 1, -1, 2, -2, 3, -3 };
+  int16_t s16_out[8];
+  int32_t s24_out[8];
+  float flt_out[8];
+  int16_t left[3], right[3];
+  void * planes[] = { left, right };
+  const void * cplanes[] = { left, right };
+  int16_t frames[6];
+
+  fail_if (OMX_ErrorNone != tiz_pcm_set_isa (ETIZPcmIsaScalar));
+
+  /* 1.0 saturates to the largest positive value; ties round to even */
+  fail_if (OMX_ErrorNone
+           != tiz_pcm_from_float (s16_out, ETIZPcmFmtS16, flt, 8));
+  fail_if (0 != memcmp (s16_out, s16, sizeof (s16)));
+  fail_if (OMX_ErrorNone
+           != tiz_pcm_from_float (s24_out, ETIZPcmFmtS24, flt, 8));
+  fail_if (0 != memcmp (s24_out, s24, sizeof (s24)));
+
+  fail_if (OMX_ErrorNone
+           != tiz_pcm_to_float (flt_out, s16, ETIZPcmFmtS16, 3));
+  fail_if (flt_out[0] != 0.f || flt_out[1] != 0.5f || flt_out[2] != -0.5f);
+
+  /* Without dither, mad's fixed point (28 fractional bits) is rounded */
+  fail_if (OMX_ErrorNone != tiz_pcm_fixed_to_s16 (s16_out, mad, 8, 28, NULL));
+  fail_if (0 != memcmp (s16_out, mad_s16, sizeof (mad_s16)));
+
+  fail_if (OMX_ErrorNone != tiz_pcm_deinterleave (planes, stereo, 2, 2, 3));
+  fail_if (left[2] != 3 || right[2] != -3);
+  fail_if (OMX_ErrorNone != tiz_pcm_interleave (frames, cplanes, 2, 2, 3));
+  fail_if (0 != memcmp (frames, stereo, sizeof (stereo)));
+
+  fail_if (OMX_ErrorBadParameter
+           != tiz_pcm_from_float (s16_out, ETIZPcmFmtMax, flt, 8));
+  fail_if (OMX_ErrorBadParameter
+           != tiz_pcm_to_float (flt_out, s16, ETIZPcmFmtMax, 8));
+  fail_if (OMX_ErrorBadParameter
+           != tiz_pcm_fixed_to_s16 (s16_out, mad, 8, 15, NULL));
+  fail_if (OMX_ErrorBadParameter
+           != tiz_pcm_interleave (frames, cplanes, 2, 0, 3));
+  fail_if (OMX_ErrorBadParameter
+           != tiz_pcm_deinterleave (planes, stereo, 9, 2, 3));
+}
+END_TEST
+
+START_TEST (test_pcm_convert_bit_exact)
+{
+  static uint8_t src[PCM_TEST_MAX_SAMPLES * 4];
+  static uint8_t ref[PCM_TEST_MAX_SAMPLES * 4];
+  static uint8_t out[PCM_TEST_MAX_SAMPLES * 4];
+  tiz_pcm_isa_t isa;
+
+  for (isa = ETIZPcmIsaSse2; isa < ETIZPcmIsaMax; ++isa)
+    {
+      size_t f, l;
+      if (OMX_ErrorNone != tiz_pcm_set_isa (isa))
+        {
+          continue;
+        }
+      for (l = 0; l < sizeof (pcm_test_lengths) / sizeof (pcm_test_lengths[0]);
+           ++l)
+        {
+          const size_t len = pcm_test_lengths[l];
+          tiz_pcm_dither_t dither_ref, dither_out;
+
+          for (f = 0; f < sizeof (pcm_test_fmts) / sizeof (pcm_test_fmts[0]);
+               ++f)
+            {
+              const tiz_pcm_fmt_t fmt = pcm_test_fmts[f];
+              const size_t size = tiz_pcm_sample_size (fmt);
+
+              pcm_test_fill (src, ETIZPcmFmtFloat, len, (uint32_t) l);
+              fail_if (OMX_ErrorNone != tiz_pcm_set_isa (ETIZPcmIsaScalar));
+              fail_if (OMX_ErrorNone
+                       != tiz_pcm_from_float (ref, fmt, (float *) src, len));
+              fail_if (OMX_ErrorNone != tiz_pcm_set_isa (isa));
+              fail_if (OMX_ErrorNone
+                       != tiz_pcm_from_float (out, fmt, (float *) src, len));
+              fail_if (0 != memcmp (ref, out, len * size),
+                       "[%s] from float fmt [%s] len [%zu] mismatch",
+                       tiz_pcm_isa_to_str (isa), pcm_test_fmt_names[f], len);
+
+              pcm_test_fill (src, fmt, len, (uint32_t) l);
+              fail_if (OMX_ErrorNone != tiz_pcm_set_isa (ETIZPcmIsaScalar));
+              fail_if (OMX_ErrorNone
+                       != tiz_pcm_to_float ((float *) ref, src, fmt, len));
+              fail_if (OMX_ErrorNone != tiz_pcm_set_isa (isa));
+              fail_if (OMX_ErrorNone
+                       != tiz_pcm_to_float ((float *) out, src, fmt, len));
+              fail_if (0 != memcmp (ref, out, len * 4),
+                       "[%s] to float fmt [%s] len [%zu] mismatch",
+                       tiz_pcm_isa_to_str (isa), pcm_test_fmt_names[f], len);
+            }
+
+          /* Same seed, same noise */
+          pcm_test_fill (src, ETIZPcmFmtS32, len, (uint32_t) l);
+          tiz_pcm_dither_init (&dither_ref, (uint32_t) l);
+          tiz_pcm_dither_init (&dither_out, (uint32_t) l);
+          fail_if (OMX_ErrorNone != tiz_pcm_set_isa (ETIZPcmIsaScalar));
+          fail_if (OMX_ErrorNone
+                   != tiz_pcm_fixed_to_s16 ((int16_t *) ref, (int32_t *) src,
+                                            len, 28, &dither_ref));
+          fail_if (OMX_ErrorNone != tiz_pcm_set_isa (isa));
+          fail_if (OMX_ErrorNone
+                   != tiz_pcm_fixed_to_s16 ((int16_t *) out, (int32_t *) src,
+                                            len, 28, &dither_out));
+          fail_if (0 != memcmp (ref, out, len * 2),
+                   "[%s] fixed to s16 len [%zu] mismatch",
+                   tiz_pcm_isa_to_str (isa), len);
+          fail_if (dither_ref.state != dither_out.state);
+        }
+    }
+}
+END_TEST
+
+START_TEST (test_pcm_dither)
+{
+  static int32_t fixed[PCM_TEST_MAX_SAMPLES];
+  static int16_t out[PCM_TEST_MAX_SAMPLES];
+  tiz_pcm_dither_t dither;
+  double sum = 0;
+  int16_t lo = 0;
+  int16_t hi = 0;
+  size_t i;
+
+  /* A constant signal of a quarter of an LSB: the dithered output must only
+     toggle around it, and average to roughly the same value */
+  for (i = 0; i < PCM_TEST_MAX_SAMPLES; ++i)
+    {
+      fixed[i] = (1 << 13) / 4;
+    }
+  tiz_pcm_dither_init (&dither, 1);
+  fail_if (OMX_ErrorNone != tiz_pcm_set_isa (ETIZPcmIsaScalar));
+  fail_if (OMX_ErrorNone
+           != tiz_pcm_fixed_to_s16 (out, fixed, PCM_TEST_MAX_SAMPLES, 28,
+                                    &dither));
+  for (i = 0; i < PCM_TEST_MAX_SAMPLES; ++i)
+    {
+      sum += out[i];
+      lo = out[i] < lo ? out[i] : lo;
+      hi = out[i] > hi ? out[i] : hi;
+    }
+  fail_if (lo < -1 || hi > 1);
+  sum /= PCM_TEST_MAX_SAMPLES;
+  fail_if (sum < 0.2 || sum > 0.3, "dither mean [%f]", sum);
+}
+END_TEST
+
+START_TEST (test_pcm_interleave)
+{
+  static uint8_t planar[8][PCM_TEST_MAX_SAMPLES];
+  static uint8_t frames[PCM_TEST_MAX_SAMPLES * 8];
+  static uint8_t check[8][PCM_TEST_MAX_SAMPLES];
+  const OMX_U32 channels[] = { 1, 2, 3, 6, 8 };
+  const size_t nframes[] = { 0, 1, 3, 7, 8, 9, 17, 100, 333 };
+  tiz_pcm_isa_t isa;
+
+  for (isa = ETIZPcmIsaScalar; isa < ETIZPcmIsaMax; ++isa)
+    {
+      size_t width, c, n;
+      if (OMX_ErrorNone != tiz_pcm_set_isa (isa))
+        {
+          continue;
+        }
+      for (width = 1; width <= 4; ++width)
+        {
+          for (c = 0; c < sizeof (channels) / sizeof (channels[0]); ++c)
+            {
+              for (n = 0; n < sizeof (nframes) / sizeof (nframes[0]); ++n)
+                {
+                  const void * src[8];
+                  void * dst[8];
+                  size_t ch, i;
+                  for (ch = 0; ch < channels[c]; ++ch)
+                    {
+                      pcm_test_fill (planar[ch], ETIZPcmFmtS32,
+                                     nframes[n] * width / 4 + 1,
+                                     (uint32_t) (ch + n));
+                      src[ch] = planar[ch];
+                      dst[ch] = check[ch];
+                    }
+                  fail_if (OMX_ErrorNone
+                           != tiz_pcm_interleave (frames, src, width,
+                                                  channels[c], nframes[n]));
+                  for (i = 0; i < nframes[n]; ++i)
+                    {
+                      for (ch = 0; ch < channels[c]; ++ch)
+                        {
+                          fail_if (0 != memcmp (frames + (i * channels[c] + ch)
+                                                           * width,
+                                                planar[ch] + i * width, width),
+                                   "[%s] width [%zu] channels [%u] frames "
+                                   "[%zu] mismatch",
+                                   tiz_pcm_isa_to_str (isa), width,
+                                   (unsigned) channels[c], nframes[n]);
+                        }
+                    }
+                  fail_if (OMX_ErrorNone
+                           != tiz_pcm_deinterleave (dst, frames, width,
+                                                    channels[c], nframes[n]));
+                  for (ch = 0; ch < channels[c]; ++ch)
+                    {
+                      fail_if (0 != memcmp (check[ch], planar[ch],
+                                            nframes[n] * width));
+                    }
+                }
+            }
+        }
+    }
+}
+END_TEST
+
+/* Local Variables: */
+/* c-default-style: gnu */
+/* fill-column: 79 */
+/* indent-tabs-mode: nil */
+/* compile-command: "make check" */
+/* End: */
@@ -26,6 +26,8 @@
  *
  */
 
+#include <stdint.h>
+
 
 START_TEST (test_queue_init_and_destroy)
 {
@@ -85,6 +87,241 @@ START_TEST (test_queue_send_and_receive)
 }
 END_TEST
 
+#define QUEUE_TEST_MAX_PRODUCERS 8
+#define QUEUE_TEST_ITEMS_PER_PRODUCER 20000
+
+typedef struct queue_test_producer queue_test_producer_t;
+struct queue_test_producer
+{
+  tiz_queue_t *p_queue;
+  OMX_U32 id;
+  OMX_U32 nitems;
+};
+
+static OMX_PTR
+queue_test_producer_thread (OMX_PTR ap_arg)
+{
+  queue_test_producer_t *p_prod = ap_arg;
+  OMX_U32 i;
+
+  for (i = 0; i < p_prod->nitems; i++)
+    {
+      /* Items are never dereferenced: encode the producer and the sequence
+         number (plus one, as NULL items are not allowed) */
+      OMX_PTR p_item
+        = (OMX_PTR) (uintptr_t) (((uintptr_t) p_prod->id << 24) | (i + 1));
+      fail_if (OMX_ErrorNone != tiz_queue_send (p_prod->p_queue, p_item));
+    }
+
+  return NULL;
+}
+
+/* Runs 'a_nproducers' producer threads against the calling thread acting as
+   the consumer and verifies per-producer FIFO ordering. */
+static void
+queue_test_run (tiz_queue_mode_t a_mode, OMX_S32 a_capacity,
+                OMX_U32 a_nproducers, OMX_U32 a_nitems)
+{
+  tiz_queue_t *p_queue = NULL;
+  tiz_thread_t threads[QUEUE_TEST_MAX_PRODUCERS];
+  queue_test_producer_t producers[QUEUE_TEST_MAX_PRODUCERS];
+  OMX_U32 next[QUEUE_TEST_MAX_PRODUCERS];
+  OMX_PTR p_received = NULL;
+  OMX_U32 i;
+
+  fail_if (a_nproducers > QUEUE_TEST_MAX_PRODUCERS);
+  fail_if (OMX_ErrorNone
+           != tiz_queue_init_with_mode (&p_queue, a_capacity, a_mode));
+
+  for (i = 0; i < a_nproducers; i++)
+    {
+      producers[i].p_queue = p_queue;
+      producers[i].id = i;
+      producers[i].nitems = a_nitems;
+      next[i] = 1;
+      fail_if (OMX_ErrorNone
+               != tiz_thread_create (&threads[i], 0, 0,
+                                     queue_test_producer_thread,
+                                     &producers[i]));
+    }
+
+  for (i = 0; i < a_nproducers * a_nitems; i++)
+    {
+      uintptr_t item = 0;
+      OMX_U32 id = 0;
+      fail_if (OMX_ErrorNone != tiz_queue_receive (p_queue, &p_received));
+      item = (uintptr_t) p_received;
+      id = item >> 24;
+      fail_if (id >= a_nproducers);
+      fail_if ((item & 0xFFFFFF) != next[id]);
+      next[id]++;
+    }
+
+  for (i = 0; i < a_nproducers; i++)
+    {
+      void *p_result = NULL;
+      fail_if (OMX_ErrorNone != tiz_thread_join (&threads[i], &p_result));
+    }
+
+  fail_if (0 != tiz_queue_length (p_queue));
+  tiz_queue_destroy (p_queue);
+}
+
+START_TEST (test_queue_lock_free_send_and_receive)
+{
+  /* Power-of-two and non-power-of-two capacities */
+  const OMX_S32 capacities[] = { 8, 10 };
+  const tiz_queue_mode_t modes[]
+    = { ETIZQueueModeLockFreeSpsc, ETIZQueueModeLockFreeMpsc };
+  OMX_PTR p_received = NULL;
+  OMX_ERRORTYPE error = OMX_ErrorNone;
+  tiz_queue_t *p_queue = NULL;
+  int m, c, round;
+  OMX_S32 i;
+
+  for (m = 0; m < 2; m++)
+    {
+      for (c = 0; c < 2; c++)
+        {
+          error = tiz_queue_init_with_mode (&p_queue, capacities[c], modes[m]);
+          fail_if (error != OMX_ErrorNone);
+          fail_if (capacities[c] != tiz_queue_capacity (p_queue));
+
+          /* Fill and drain the queue several times to wrap around the ring */
+          for (round = 0; round < 5; round++)
+            {
+              for (i = 0; i < capacities[c]; i++)
+                {
+                  error = tiz_queue_send (p_queue,
+                                          (OMX_PTR) (uintptr_t) (i + 1));
+                  fail_if (error != OMX_ErrorNone);
+                }
+
+              fail_if (capacities[c] != tiz_queue_length (p_queue));
+
+              for (i = 0; i < capacities[c]; i++)
+                {
+                  error = tiz_queue_receive (p_queue, &p_received);
+                  fail_if (error != OMX_ErrorNone);
+                  fail_if ((uintptr_t) p_received != (uintptr_t) (i + 1));
+                }
+
+              fail_if (0 != tiz_queue_length (p_queue));
+            }
+
+          tiz_queue_destroy (p_queue);
+          p_queue = NULL;
+        }
+    }
+}
+END_TEST
+
+START_TEST (test_queue_lock_free_blocking)
+{
+  /* A tiny capacity makes both the producers and the consumer block */
+  queue_test_run (ETIZQueueModeLockFreeSpsc, 2, 1,
+                  QUEUE_TEST_ITEMS_PER_PRODUCER);
+  queue_test_run (ETIZQueueModeLockFreeMpsc, 3, 4,
+                  QUEUE_TEST_ITEMS_PER_PRODUCER);
+  queue_test_run (ETIZQueueModeLockFreeMpsc, 16, QUEUE_TEST_MAX_PRODUCERS,
+                  QUEUE_TEST_ITEMS_PER_PRODUCER);
+}
+END_TEST
+
+START_TEST (test_queue_receive_batch)
+{
+  const tiz_queue_mode_t modes[] = { ETIZQueueModeLocking,
+                                     ETIZQueueModeLockFreeSpsc,
+                                     ETIZQueueModeLockFreeMpsc };
+  OMX_PTR items[4];
+  OMX_S32 count = 0;
+  OMX_ERRORTYPE error = OMX_ErrorNone;
+  tiz_queue_t *p_queue = NULL;
+  int m;
+  OMX_S32 i;
+
+  for (m = 0; m < 3; m++)
+    {
+      error = tiz_queue_init_with_mode (&p_queue, 10, modes[m]);
+      fail_if (error != OMX_ErrorNone);
+
+      for (i = 0; i < 7; i++)
+        {
+          error = tiz_queue_send (p_queue, (OMX_PTR) (uintptr_t) (i + 1));
+          fail_if (error != OMX_ErrorNone);
+        }
+
+      /* A full batch, then whatever is left */
+      error = tiz_queue_receive_batch (p_queue, items, 4, &count);
+      fail_if (error != OMX_ErrorNone);
+      fail_if (4 != count);
+      for (i = 0; i < count; i++)
+        {
+          fail_if ((uintptr_t) items[i] != (uintptr_t) (i + 1));
+        }
+
+      error = tiz_queue_receive_batch (p_queue, items, 4, &count);
+      fail_if (error != OMX_ErrorNone);
+      fail_if (3 != count);
+      for (i = 0; i < count; i++)
+        {
+          fail_if ((uintptr_t) items[i] != (uintptr_t) (i + 5));
+        }
+
+      fail_if (0 != tiz_queue_length (p_queue));
+      tiz_queue_destroy (p_queue);
+      p_queue = NULL;
+    }
+}
+END_TEST
+
+START_TEST (test_queue_try_send)
+{
+  const tiz_queue_mode_t modes[] = { ETIZQueueModeLocking,
+                                     ETIZQueueModeLockFreeSpsc,
+                                     ETIZQueueModeLockFreeMpsc };
+  OMX_PTR p_item = NULL;
+  OMX_ERRORTYPE error = OMX_ErrorNone;
+  tiz_queue_t *p_queue = NULL;
+  int m;
+  OMX_S32 i;
+
+  for (m = 0; m < 3; m++)
+    {
+      error = tiz_queue_init_with_mode (&p_queue, 5, modes[m]);
+      fail_if (error != OMX_ErrorNone);
+
+      for (i = 0; i < 5; i++)
+        {
+          error = tiz_queue_try_send (p_queue, (OMX_PTR) (uintptr_t) (i + 1));
+          fail_if (error != OMX_ErrorNone);
+        }
+
+      /* Full: the item is rejected without blocking */
+      error = tiz_queue_try_send (p_queue, (OMX_PTR) (uintptr_t) 6);
+      fail_if (error != OMX_ErrorOverflow);
+      fail_if (5 != tiz_queue_length (p_queue));
+
+      error = tiz_queue_receive (p_queue, &p_item);
+      fail_if (error != OMX_ErrorNone);
+      fail_if ((uintptr_t) p_item != 1);
+
+      error = tiz_queue_try_send (p_queue, (OMX_PTR) (uintptr_t) 6);
+      fail_if (error != OMX_ErrorNone);
+
+      for (i = 1; i < 6; i++)
+        {
+          error = tiz_queue_receive (p_queue, &p_item);
+          fail_if (error != OMX_ErrorNone);
+          fail_if ((uintptr_t) p_item != (uintptr_t) (i + 1));
+        }
+
+      tiz_queue_destroy (p_queue);
+      p_queue = NULL;
+    }
+}
+END_TEST
+
 /* Local Variables: */
 /* c-default-style: gnu */
 /* fill-column: 79 */
@@ -51,6 +51,10 @@
 #include "./check_event.c"
 #include "./check_http_parser.c"
 #include "./check_map.c"
+#include "./check_pcm.c"
+#include "./check_buffer.c"
+#include "./check_bufpool.c"
+#include "./check_log.c"
 
 #define EVENT_API_TEST_TIMEOUT 100
 
@@ -103,6 +107,10 @@ platform_queue_suite (void)
   tc_queue = tcase_create ("queue");
   tcase_add_test (tc_queue, test_queue_init_and_destroy);
   tcase_add_test (tc_queue, test_queue_send_and_receive);
+  tcase_add_test (tc_queue, test_queue_lock_free_send_and_receive);
+  tcase_add_test (tc_queue, test_queue_lock_free_blocking);
+  tcase_add_test (tc_queue, test_queue_receive_batch);
+  tcase_add_test (tc_queue, test_queue_try_send);
   suite_add_tcase (s, tc_queue);
 
   return s;
@@ -145,6 +153,40 @@ platform_vector_suite (void)
   return s;
 }
 
+Suite *
+platform_buffer_suite (void)
+{
+  TCase *tc_buffer = NULL;
+  Suite *s = suite_create ("Dynamic buffer implementation");
+
+  /* buffer API test case */
+  tc_buffer = tcase_create ("buffer");
+  tcase_add_test (tc_buffer, test_buffer_non_seekable);
+  tcase_add_test (tc_buffer, test_buffer_circular);
+  tcase_add_test (tc_buffer, test_buffer_high_watermark);
+  tcase_add_test (tc_buffer, test_buffer_seek);
+  suite_add_tcase (s, tc_buffer);
+
+  return s;
+}
+
+Suite *
+platform_bufpool_suite (void)
+{
+  TCase *tc_bufpool = NULL;
+  Suite *s = suite_create ("OpenMAX IL buffer pool");
+
+  /* buffer pool API test case */
+  tc_bufpool = tcase_create ("bufpool");
+  tcase_add_test (tc_bufpool, test_bufpool_alignment);
+  tcase_add_test (tc_bufpool, test_bufpool_reuse);
+  tcase_add_test (tc_bufpool, test_bufpool_hugepages);
+  tcase_add_test (tc_bufpool, test_bufpool_hooks);
+  suite_add_tcase (s, tc_bufpool);
+
+  return s;
+}
+
 Suite *
 platform_rcfile_suite (void)
 {
@@ -227,6 +269,42 @@ platform_map_suite (void)
 
 }
 
+Suite *
+platform_pcm_suite (void)
+{
+  TCase *tc_pcm = NULL;
+  Suite *s = suite_create ("PCM sample processing");
+
+  /* pcm API test case */
+  tc_pcm = tcase_create ("pcm");
+  tcase_add_test (tc_pcm, test_pcm_gain_values);
+  tcase_add_test (tc_pcm, test_pcm_gain_bit_exact);
+  tcase_add_test (tc_pcm, test_pcm_ramp_bit_exact);
+  tcase_add_test (tc_pcm, test_pcm_swap);
+  tcase_add_test (tc_pcm, test_pcm_convert_values);
+  tcase_add_test (tc_pcm, test_pcm_convert_bit_exact);
+  tcase_add_test (tc_pcm, test_pcm_dither);
+  tcase_add_test (tc_pcm, test_pcm_interleave);
+  suite_add_tcase (s, tc_pcm);
+
+  return s;
+}
+
+Suite *
+platform_log_suite (void)
+{
+  TCase *tc_log = NULL;
+  Suite *s = suite_create ("Logging");
+
+  /* log API test case */
+  tc_log = tcase_create ("log");
+  tcase_add_test (tc_log, test_log_async_queue_and_flush);
+  tcase_add_test (tc_log, test_log_async_flush_exited_thread);
+  suite_add_tcase (s, tc_log);
+
+  return s;
+}
+
 int
 main (void)
 {
@@ -242,11 +320,15 @@ main (void)
   srunner_add_suite (sr, platform_queue_suite ());
   srunner_add_suite (sr, platform_pqueue_suite ());
   srunner_add_suite (sr, platform_vector_suite ());
+  srunner_add_suite (sr, platform_buffer_suite ());
+  srunner_add_suite (sr, platform_bufpool_suite ());
   srunner_add_suite (sr, platform_rcfile_suite ());
   srunner_add_suite (sr, platform_soa_suite ());
   srunner_add_suite (sr, platform_http_parser_suite ());
   srunner_add_suite (sr, platform_map_suite ());
   srunner_add_suite (sr, platform_event_suite ());
+  srunner_add_suite (sr, platform_pcm_suite ());
+  srunner_add_suite (sr, platform_log_suite ());
   srunner_run_all (sr, CK_VERBOSE);
   number_failed = srunner_ntests_failed (sr);
   srunner_free (sr);
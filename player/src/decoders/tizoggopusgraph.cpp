@@ -139,6 +139,7 @@ void graph::oggopusdecops::get_pcm_codec_info (OMX_AUDIO_PARAM_PCMMODETYPE &pcmt
       "Unable to set OMX_IndexParamAudioPcm");
 
   pcmtype.nBitPerSample = decoder_pcmtype.nBitPerSample;
+  pcmtype.eNumData = decoder_pcmtype.eNumData;
   pcmtype.nSamplingRate = 48000; //decoder_pcmtype.nSamplingRate;
 }
 
@@ -161,10 +162,10 @@ graph::oggopusdecops::probe_stream_hook ()
     {
       OMX_AUDIO_PARAM_PCMMODETYPE pcmtype;
       probe_ptr_->get_pcm_codec_info (pcmtype);
-      // Ammend the bits per sample value, as the ogg opus decoder produces 32 bit
-      // per sample output
-      // TODO: Remove this hack
+      // Ammend the sample format, as the ogg opus decoder produces 32 bit
+      // float output
       pcmtype.nBitPerSample = 32;
+      pcmtype.eNumData = OMX_NumericalDataFloat;
       probe_ptr_->set_pcm_codec_info (pcmtype);
     }
   return true;
@@ -29,7 +29,7 @@
 #define TIZHTTPCLNTGRAPHFSM_HPP
 
 #define BOOST_MPL_CFG_NO_PREPROCESSED_HEADERS
-#define BOOST_MPL_LIMIT_VECTOR_SIZE 40
+#define BOOST_MPL_LIMIT_VECTOR_SIZE 50
 #define FUSION_MAX_VECTOR_SIZE      20
 #define SPIRIT_ARGUMENTS_LIMIT      20
 
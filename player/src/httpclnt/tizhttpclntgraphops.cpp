@@ -530,6 +530,7 @@ graph::httpclntops::set_channels_and_rate_on_renderer (
   {
     // Opus and Vorbis decoders output 32 bit samples (floats)
     renderer_pcmtype.nBitPerSample = 32;
+    renderer_pcmtype.eNumData = OMX_NumericalDataFloat;
   }
 
   // Set the new pcm settings
@@ -48,11 +48,13 @@ namespace tiz
                       const std::vector< std::string > &bitrate_mode_list,
                       const std::string &station_name,
                       const std::string &station_genre,
-                      const bool &icy_metadata_enabled)
+                      const bool &icy_metadata_enabled,
+                      const bool &transcoding_enabled = false)
         : config (playlist), host_ (host), addr_ (ip_address), port_ (port),
           sampling_rate_list_ (sampling_rate_list), bitrate_mode_list_ (bitrate_mode_list),
           station_name_ (station_name), station_genre_ (station_genre),
-          icy_metadata_enabled_ (icy_metadata_enabled)
+          icy_metadata_enabled_ (icy_metadata_enabled),
+          transcoding_enabled_ (transcoding_enabled)
       {
       }
 
@@ -100,6 +102,11 @@ namespace tiz
         return icy_metadata_enabled_;
       }
 
+      bool get_transcoding_enabled () const
+      {
+        return transcoding_enabled_;
+      }
+
     protected:
       const std::string host_;
       const std::string addr_;
@@ -109,6 +116,7 @@ namespace tiz
       const std::string station_name_;
       const std::string station_genre_;
       const bool icy_metadata_enabled_;
+      const bool transcoding_enabled_;
     };
   }  // namespace graph
 }  // namespace tiz
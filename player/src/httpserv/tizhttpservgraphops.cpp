@@ -144,18 +144,18 @@ graph::httpservops::configure_server ()
   httpsrv.nVersion.nVersion = OMX_VERSION;
 
   tiz_check_omx (OMX_GetParameter (
-      handles_[1],
+      http_renderer_handle (),
       static_cast< OMX_INDEXTYPE >(OMX_TizoniaIndexParamHttpServer), &httpsrv));
 
   tizhttpservconfig_ptr_t srv_config
       = boost::dynamic_pointer_cast< httpservconfig >(config_);
   assert (srv_config);
   httpsrv.nListeningPort = srv_config->get_port ();
-  httpsrv.nMaxClients = 1;  // the http renderer component supports only one
-  // client, for now
+  httpsrv.nMaxClients
+      = tiz::graph::util::get_streaming_server_max_clients ();
 
   return OMX_SetParameter (
-      handles_[1],
+      http_renderer_handle (),
       static_cast< OMX_INDEXTYPE >(OMX_TizoniaIndexParamHttpServer), &httpsrv);
 }
 
@@ -172,7 +172,7 @@ graph::httpservops::configure_station ()
   assert (srv_config);
 
   tiz_check_omx (OMX_GetParameter (
-      handles_[1],
+      http_renderer_handle (),
       static_cast< OMX_INDEXTYPE >(OMX_TizoniaIndexParamIcecastMountpoint),
       &mount));
 
@@ -195,9 +195,9 @@ graph::httpservops::configure_station ()
            mount.nIcyMetadataPeriod);
 
   mount.eEncoding = OMX_AUDIO_CodingMP3;
-  mount.nMaxClients = 1;
+  mount.nMaxClients = tiz::graph::util::get_streaming_server_max_clients ();
   return OMX_SetParameter (
-      handles_[1],
+      http_renderer_handle (),
       static_cast< OMX_INDEXTYPE >(OMX_TizoniaIndexParamIcecastMountpoint),
       &mount);
 }
@@ -231,8 +231,9 @@ graph::httpservops::configure_stream_metadata ()
     TIZ_LOG (TIZ_PRIORITY_TRACE, "p_metadata->cStreamTitle [%s]...",
              p_metadata->cStreamTitle);
 
-    rc = OMX_SetConfig (handles_[1], static_cast< OMX_INDEXTYPE >(
-                                         OMX_TizoniaIndexConfigIcecastMetadata),
+    rc = OMX_SetConfig (http_renderer_handle (),
+                        static_cast< OMX_INDEXTYPE >(
+                            OMX_TizoniaIndexConfigIcecastMetadata),
                         p_metadata);
 
     tiz_mem_free (p_metadata);
@@ -242,39 +243,20 @@ graph::httpservops::configure_stream_metadata ()
   return rc;
 }
 
+OMX_HANDLETYPE
+graph::httpservops::http_renderer_handle () const
+{
+  assert (!handles_.empty ());
+  return handles_[handles_.size () - 1];
+}
+
 OMX_ERRORTYPE
 graph::httpservops::switch_tunnel (const int tunnel_id,
     const OMX_COMMANDTYPE to_disabled_or_enabled)
 {
-  OMX_ERRORTYPE rc = OMX_ErrorNone;
-
-  assert (to_disabled_or_enabled == OMX_CommandPortDisable
-          || to_disabled_or_enabled == OMX_CommandPortEnable);
-
-  if (to_disabled_or_enabled == OMX_CommandPortDisable)
-  {
-    rc = tiz::graph::util::disable_tunnel (handles_, tunnel_id);
-  }
-  else
-  {
-    rc = tiz::graph::util::enable_tunnel (handles_, tunnel_id);
-  }
-
-  if (OMX_ErrorNone == rc)
-  {
-    clear_expected_port_transitions ();
-    const int file_reader_index = 0;
-    const int file_reader_input_port = 0;
-    add_expected_port_transition (handles_[file_reader_index],
-                                  file_reader_input_port,
-                                  to_disabled_or_enabled);
-    const int http_renderer_index = 1;
-    const int http_renderer_input_port = 0;
-    add_expected_port_transition (handles_[http_renderer_index],
-                                  http_renderer_input_port,
-                                  to_disabled_or_enabled);
-  }
-  return rc;
+  // Only one tunnel is ever disabled or enabled at a time in this graph
+  clear_expected_port_transitions ();
+  return tiz::graph::ops::switch_tunnel (tunnel_id, to_disabled_or_enabled);
 }
 
 void graph::httpservops::get_mp3_codec_info (OMX_AUDIO_PARAM_MP3TYPE &mp3type)
@@ -56,13 +56,18 @@ namespace tiz
       bool is_initial_configuration () const;
       void do_flag_initial_config_done ();
 
-    private:
-      OMX_ERRORTYPE configure_server ();
-      OMX_ERRORTYPE configure_station ();
+    protected:
+      // The http renderer is always the last component in the graph
+      OMX_HANDLETYPE http_renderer_handle () const;
       OMX_ERRORTYPE configure_stream_metadata ();
+      // re-implemented from the base class
       OMX_ERRORTYPE switch_tunnel (const int tunnel_id,
           const OMX_COMMANDTYPE to_disabled_or_enabled);
 
+    private:
+      OMX_ERRORTYPE configure_server ();
+      OMX_ERRORTYPE configure_station ();
+
     private:
       void get_mp3_codec_info (OMX_AUDIO_PARAM_MP3TYPE &mp3type);
       // re-implemented from the base class
@@ -37,7 +37,9 @@
 #include <tizplatform.h>
 
 #include <tizgraphmgrcaps.hpp>
+#include "tizhttpservconfig.hpp"
 #include "tizhttpservgraph.hpp"
+#include "tizhttpservtranscodergraph.hpp"
 #include "tizhttpservmgr.hpp"
 
 #ifdef TIZ_LOG_CATEGORY_NAME
@@ -102,11 +104,19 @@ tizgraph_ptr_t graphmgr::httpservmgrops::get_graph (
     const std::string & /* uri */)
 {
   tizgraph_ptr_t g_ptr;
-  std::string encoding ("http/mp3");
+  const bool transcoding = is_transcoding_enabled ();
+  std::string encoding (transcoding ? "http/transcode" : "http/mp3");
   tizgraph_ptr_map_t::const_iterator it = graph_registry_.find (encoding);
   if (it == graph_registry_.end ())
   {
-    g_ptr = boost::make_shared< tiz::graph::httpserver >();
+    if (transcoding)
+    {
+      g_ptr = boost::make_shared< tiz::graph::httptranscoder >();
+    }
+    else
+    {
+      g_ptr = boost::make_shared< tiz::graph::httpserver >();
+    }
     if (g_ptr)
     {
       // TODO: Check rc
@@ -138,6 +148,16 @@ tizgraph_ptr_t graphmgr::httpservmgrops::get_graph (
   return g_ptr;
 }
 
+bool graphmgr::httpservmgrops::is_transcoding_enabled () const
+{
+  httpservmgr *p_servermgr = dynamic_cast< httpservmgr * >(p_mgr_);
+  assert (p_servermgr);
+  tizhttpservconfig_ptr_t srv_config
+      = boost::dynamic_pointer_cast< tiz::graph::httpservconfig >(
+          p_servermgr->config_);
+  return srv_config && srv_config->get_transcoding_enabled ();
+}
+
 void graphmgr::httpservmgrops::do_load ()
 {
   tizgraph_ptr_t g_ptr (get_graph (std::string ()));
@@ -74,6 +74,7 @@ namespace tiz
 
     private:
       tizgraph_ptr_t get_graph (const std::string &uri);
+      bool is_transcoding_enabled () const;
     };
   }  // namespace graphmgr
 }  // namespace tiz
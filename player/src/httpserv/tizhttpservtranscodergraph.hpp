@@ -0,0 +1,59 @@
+/**
+ * Copyright (C) 2011-2017 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   tizhttpservtranscodergraph.hpp
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  HTTP Streaming Server graph (transcoding variant)
+ *
+ *
+ */
+
+#ifndef TIZHTTPSERVTRANSCODERGRAPH_HPP
+#define TIZHTTPSERVTRANSCODERGRAPH_HPP
+
+#include "tizgraph.hpp"
+#include "tizhttpservtranscodergraphfsm.hpp"
+
+namespace tiz
+{
+  namespace graph
+  {
+    // Forward declarations
+    class cmd;
+    class ops;
+
+    class httptranscoder : public graph
+    {
+
+    public:
+      httptranscoder ();
+
+    protected:
+      ops *do_init ();
+      bool dispatch_cmd (const tiz::graph::cmd *p_cmd);
+
+    protected:
+      tcfsm::fsm fsm_;
+    };
+  }  // namespace graph
+}  // namespace tiz
+
+#endif  // TIZHTTPSERVTRANSCODERGRAPH_HPP
@@ -0,0 +1,426 @@
+/**
+ * Copyright (C) 2011-2017 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   tizhttpservtranscodergraphops.cpp
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  OpenMAX IL HTTP Streaming Server (transcoding) graph operations
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <boost/bind.hpp>
+#include <boost/filesystem.hpp>
+
+#include <OMX_Core.h>
+#include <OMX_Component.h>
+#include <OMX_TizoniaExt.h>
+#include <tizplatform.h>
+
+#include "tizgraphutil.hpp"
+#include "tizprobe.hpp"
+#include "tizgraph.hpp"
+#include "tizhttpservtranscodergraphops.hpp"
+
+#ifdef TIZ_LOG_CATEGORY_NAME
+#undef TIZ_LOG_CATEGORY_NAME
+#define TIZ_LOG_CATEGORY_NAME "tiz.play.graph.httptranscoderops"
+#endif
+
+namespace graph = tiz::graph;
+
+namespace
+{
+  // Positions of the components in the graph
+  const int TIZ_TRANSCODER_READER_INDEX = 0;
+  const int TIZ_TRANSCODER_DECODER_INDEX = 1;
+  const int TIZ_TRANSCODER_ENCODER_INDEX = 2;
+
+  // Extra buffers on both sides of the encoder, so that the decoder and the
+  // http renderer can keep working while a buffer is being encoded
+  const OMX_U32 TIZ_TRANSCODER_ENCODER_INPUT_BUFFERS = 4;
+  const OMX_U32 TIZ_TRANSCODER_ENCODER_OUTPUT_BUFFERS = 8;
+
+  bool find_decoder (const tizprobe_ptr_t &probe_ptr, std::string &comp_name,
+                     std::string &comp_role)
+  {
+    bool found = true;
+    switch (probe_ptr->get_audio_coding_type ())
+    {
+      case OMX_AUDIO_CodingMP3:
+      {
+        comp_name = "OMX.Aratelia.audio_decoder.mp3";
+        comp_role = "audio_decoder.mp3";
+      }
+      break;
+      case OMX_AUDIO_CodingMP2:
+      {
+        comp_name = "OMX.Aratelia.audio_decoder.mpeg";
+        comp_role = "audio_decoder.mp2";
+      }
+      break;
+      case OMX_AUDIO_CodingAAC:
+      {
+        comp_name = "OMX.Aratelia.audio_decoder.aac";
+        comp_role = "audio_decoder.aac";
+      }
+      break;
+      case OMX_AUDIO_CodingFLAC:
+      {
+        // Ogg FLAC files need the ogg demuxer; not supported here
+        const std::string extension (
+            boost::filesystem::path (probe_ptr->get_uri ())
+                .extension ()
+                .string ());
+        found = (extension.compare (".oga") != 0
+                 && extension.compare (".ogg") != 0);
+        comp_name = "OMX.Aratelia.audio_decoder.flac";
+        comp_role = "audio_decoder.flac";
+      }
+      break;
+      case OMX_AUDIO_CodingOPUS:
+      {
+        comp_name = "OMX.Aratelia.audio_decoder.opusfile.opus";
+        comp_role = "audio_decoder.opus";
+      }
+      break;
+      case OMX_AUDIO_CodingPCM:
+      {
+        comp_name = "OMX.Aratelia.audio_decoder.pcm";
+        comp_role = "audio_decoder.pcm";
+      }
+      break;
+      default:
+      {
+        // e.g. Vorbis, which needs the ogg demuxer
+        found = false;
+      }
+      break;
+    };
+    return found;
+  }
+}
+
+//
+// httptranscoderops
+//
+graph::httptranscoderops::httptranscoderops (
+    graph *p_graph, const omx_comp_name_lst_t &comp_lst,
+    const omx_comp_role_lst_t &role_lst)
+  : tiz::graph::httpservops (p_graph, comp_lst, role_lst),
+    need_port_settings_changed_evt_ (false)
+{
+}
+
+void graph::httptranscoderops::do_load ()
+{
+  tiz::graph::ops::do_load ();
+  if (last_op_succeeded ())
+  {
+    G_OPS_BAIL_IF_ERROR (
+        util::set_port_buffer_count (handles_[TIZ_TRANSCODER_ENCODER_INDEX], 0,
+                                     TIZ_TRANSCODER_ENCODER_INPUT_BUFFERS),
+        "Unable to set the encoder's input buffer count");
+    G_OPS_BAIL_IF_ERROR (
+        util::set_port_buffer_count (handles_[TIZ_TRANSCODER_ENCODER_INDEX], 1,
+                                     TIZ_TRANSCODER_ENCODER_OUTPUT_BUFFERS),
+        "Unable to set the encoder's output buffer count");
+  }
+}
+
+void graph::httptranscoderops::do_probe ()
+{
+  need_port_settings_changed_evt_ = false;
+  G_OPS_BAIL_IF_ERROR (
+      probe_stream (OMX_PortDomainAudio, OMX_AUDIO_CodingAutoDetect,
+                    "http/transcode", "server", &tiz::probe::dump_pcm_info),
+      "Unable to probe the stream.");
+
+  std::string comp_name;
+  std::string comp_role;
+  // NOTE: this has been verified already in probe_stream_hook
+  (void)find_decoder (probe_ptr_, comp_name, comp_role);
+  G_OPS_BAIL_IF_ERROR (replace_decoder (comp_name, comp_role),
+                       "Unable to instantiate the decoder.");
+  G_OPS_BAIL_IF_ERROR (configure_decoder (), "Unable to configure the decoder.");
+}
+
+bool graph::httptranscoderops::is_port_settings_evt_required () const
+{
+  return need_port_settings_changed_evt_;
+}
+
+void graph::httptranscoderops::do_configure_stream ()
+{
+  G_OPS_BAIL_IF_ERROR (
+      tiz::graph::util::set_content_uri (handles_[TIZ_TRANSCODER_READER_INDEX],
+                                         probe_ptr_->get_uri ()),
+      "Unable to set OMX_IndexParamContentURI");
+  G_OPS_BAIL_IF_ERROR (
+      tiz::graph::util::set_pcm_mode (
+          handles_[TIZ_TRANSCODER_ENCODER_INDEX], 0,
+          boost::bind (&tiz::graph::httptranscoderops::get_pcm_codec_info,
+                       this, _1)),
+      "Unable to set OMX_IndexParamAudioPcm");
+  bool need_port_settings_changed_evt = false;  // not needed here
+  G_OPS_BAIL_IF_ERROR (
+      tiz::graph::util::set_mp3_type (
+          handles_[TIZ_TRANSCODER_ENCODER_INDEX], 1,
+          boost::bind (&tiz::graph::httptranscoderops::get_mp3_output_info,
+                       this, _1),
+          need_port_settings_changed_evt),
+      "Unable to set OMX_IndexParamAudioMp3");
+  G_OPS_BAIL_IF_ERROR (
+      tiz::graph::util::set_mp3_type (
+          http_renderer_handle (), 0,
+          boost::bind (&tiz::graph::httptranscoderops::get_mp3_output_info,
+                       this, _1),
+          need_port_settings_changed_evt),
+      "Unable to set OMX_IndexParamAudioMp3");
+  G_OPS_BAIL_IF_ERROR (configure_stream_metadata (),
+                       "Unable to set OMX_TizoniaIndexConfigIcecastMetadata");
+}
+
+void graph::httptranscoderops::do_loaded2idle_chain ()
+{
+  if (last_op_succeeded ())
+  {
+    G_OPS_BAIL_IF_ERROR (
+        transition_chain (OMX_StateIdle, OMX_StateLoaded),
+        "Unable to transition the decoding chain from Loaded->Idle");
+  }
+}
+
+void graph::httptranscoderops::do_idle2exe_chain ()
+{
+  if (last_op_succeeded ())
+  {
+    G_OPS_BAIL_IF_ERROR (
+        transition_chain (OMX_StateExecuting, OMX_StateIdle),
+        "Unable to transition the decoding chain from Idle->Exe");
+  }
+}
+
+void graph::httptranscoderops::do_exe2idle_chain ()
+{
+  if (last_op_succeeded ())
+  {
+    G_OPS_BAIL_IF_ERROR (
+        transition_chain (OMX_StateIdle, OMX_StateExecuting),
+        "Unable to transition the decoding chain from Exe->Idle");
+  }
+}
+
+void graph::httptranscoderops::do_idle2loaded_chain ()
+{
+  if (last_op_succeeded ())
+  {
+    G_OPS_BAIL_IF_ERROR (
+        transition_chain (OMX_StateLoaded, OMX_StateIdle),
+        "Unable to transition the decoding chain from Idle->Loaded");
+  }
+}
+
+OMX_ERRORTYPE
+graph::httptranscoderops::replace_decoder (const std::string &comp_name,
+                                           const std::string &comp_role)
+{
+  const int dec = TIZ_TRANSCODER_DECODER_INDEX;
+
+  if (comp_lst_[dec] == comp_name)
+  {
+    // Same decoder as for the previous track; nothing to do
+    return OMX_ErrorNone;
+  }
+
+  TIZ_LOG (TIZ_PRIORITY_TRACE, "Replacing [%s] with [%s]...",
+           comp_lst_[dec].c_str (), comp_name.c_str ());
+
+  // The whole chain is in Loaded state at this point. Take the current
+  // decoder out of the graph...
+  tiz_check_omx (OMX_TeardownTunnel (handles_[dec - 1], 0, handles_[dec], 0));
+  tiz_check_omx (OMX_TeardownTunnel (handles_[dec], 1, handles_[dec + 1], 0));
+  h2n_.erase (handles_[dec]);
+  tiz_check_omx (OMX_FreeHandle (handles_[dec]));
+  handles_[dec] = NULL;
+
+  // ... and put the new one in its place
+  tiz::graph::cbackhandler &cbacks = get_cback_handler ();
+  tiz_check_omx (util::instantiate_component (comp_name, dec, &(cbacks),
+                                              cbacks.get_omx_cbacks (),
+                                              handles_, h2n_));
+  tiz_check_omx (util::set_role (handles_[dec], comp_role));
+  comp_lst_[dec] = comp_name;
+  role_lst_[dec] = comp_role;
+
+  tiz_check_omx (util::setup_suppliers (handles_, dec - 1));
+  tiz_check_omx (util::setup_tunnels (handles_, dec - 1));
+  tiz_check_omx (util::setup_suppliers (handles_, dec));
+  tiz_check_omx (util::setup_tunnels (handles_, dec));
+
+  return OMX_ErrorNone;
+}
+
+OMX_ERRORTYPE
+graph::httptranscoderops::configure_decoder ()
+{
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+  const OMX_HANDLETYPE decoder = handles_[TIZ_TRANSCODER_DECODER_INDEX];
+  switch (probe_ptr_->get_audio_coding_type ())
+  {
+    case OMX_AUDIO_CodingMP3:
+    {
+      rc = tiz::graph::util::set_mp3_type (
+          decoder, 0,
+          boost::bind (&tiz::probe::get_mp3_codec_info, probe_ptr_, _1),
+          need_port_settings_changed_evt_);
+    }
+    break;
+    case OMX_AUDIO_CodingAAC:
+    {
+      rc = tiz::graph::util::set_aac_type (
+          decoder, 0,
+          boost::bind (&tiz::probe::get_aac_codec_info, probe_ptr_, _1),
+          need_port_settings_changed_evt_);
+    }
+    break;
+    case OMX_AUDIO_CodingFLAC:
+    {
+      rc = tiz::graph::util::set_flac_type (
+          decoder, 0,
+          boost::bind (&tiz::probe::get_flac_codec_info, probe_ptr_, _1),
+          need_port_settings_changed_evt_);
+    }
+    break;
+    default:
+    {
+      // The mpeg, opus and pcm decoders work out the stream settings by
+      // themselves
+    }
+    break;
+  };
+  return rc;
+}
+
+OMX_ERRORTYPE
+graph::httptranscoderops::transition_chain (const OMX_STATETYPE to_state,
+                                            const OMX_STATETYPE from_state)
+{
+  // The chain is everything but the http renderer, which stays in Executing
+  // state for the lifetime of the graph, so that clients remain connected
+  omx_comp_handle_lst_t chain_handles (handles_.begin (), handles_.end () - 1);
+  OMX_ERRORTYPE rc
+      = tiz::graph::util::transition_all (chain_handles, to_state, from_state);
+  if (OMX_ErrorNone == rc)
+  {
+    clear_expected_transitions ();
+    omx_comp_handle_lst_t::const_iterator it = chain_handles.begin ();
+    for (; it != chain_handles.end (); ++it)
+    {
+      add_expected_transition (*it, to_state);
+    }
+  }
+  return rc;
+}
+
+void graph::httptranscoderops::get_pcm_codec_info (
+    OMX_AUDIO_PARAM_PCMMODETYPE &pcmtype)
+{
+  OMX_U32 dec_port_id = 1;
+  OMX_AUDIO_PARAM_PCMMODETYPE dec_pcmtype;
+  TIZ_INIT_OMX_PORT_STRUCT (dec_pcmtype, dec_port_id);
+
+  G_OPS_BAIL_IF_ERROR (
+      OMX_GetParameter (handles_[TIZ_TRANSCODER_DECODER_INDEX],
+                        OMX_IndexParamAudioPcm, &dec_pcmtype),
+      "Unable to get OMX_IndexParamAudioPcm from decoder");
+
+  assert (probe_ptr_);
+  probe_ptr_->get_pcm_codec_info (pcmtype);
+
+  // Ammend the endianness, sign, and interleave config as per the decoder
+  // values
+  pcmtype.eEndian = dec_pcmtype.eEndian;
+  pcmtype.eNumData = dec_pcmtype.eNumData;
+  pcmtype.bInterleaved = dec_pcmtype.bInterleaved;
+
+  if (OMX_NumericalDataFloat == dec_pcmtype.eNumData)
+  {
+    // Float samples are always 32-bit, whatever the stream's bit depth
+    pcmtype.nBitPerSample = dec_pcmtype.nBitPerSample;
+  }
+
+  if (OMX_AUDIO_CodingOPUS == probe_ptr_->get_audio_coding_type ())
+  {
+    // The opus decoder always produces samples at 48KHz
+    pcmtype.nSamplingRate = dec_pcmtype.nSamplingRate;
+  }
+}
+
+void graph::httptranscoderops::get_mp3_output_info (
+    OMX_AUDIO_PARAM_MP3TYPE &mp3type)
+{
+  // Every track is re-encoded with the same settings, so that the stream
+  // served to the clients has a constant format
+  mp3type.nChannels = 2;
+  mp3type.nBitRate = tiz::graph::util::get_streaming_server_transcoding_bitrate ();
+  mp3type.nSampleRate
+      = tiz::graph::util::get_streaming_server_transcoding_sampling_rate ();
+  mp3type.nAudioBandWidth = 0;
+  mp3type.eChannelMode = OMX_AUDIO_ChannelModeJointStereo;
+  mp3type.eFormat = OMX_AUDIO_MP3StreamFormatMP1Layer3;
+}
+
+bool graph::httptranscoderops::probe_stream_hook ()
+{
+  bool rc = false;
+  if (probe_ptr_)
+  {
+    std::string comp_name;
+    std::string comp_role;
+    rc = find_decoder (probe_ptr_, comp_name, comp_role);
+
+    OMX_AUDIO_PARAM_PCMMODETYPE pcmtype;
+    probe_ptr_->get_pcm_codec_info (pcmtype);
+
+    // The mp3 encoder takes mono or stereo input, with 16-bit, packed 24-bit
+    // (e.g. 24-bit FLAC) or 32-bit integer samples, or 32-bit float samples
+    // (as produced by the opus decoder)
+    rc &= (pcmtype.nChannels == 1 || pcmtype.nChannels == 2);
+    if (OMX_NumericalDataFloat == pcmtype.eNumData)
+    {
+      rc &= (pcmtype.nBitPerSample == 32);
+    }
+    else
+    {
+      rc &= (pcmtype.nBitPerSample == 16 || pcmtype.nBitPerSample == 24
+             || pcmtype.nBitPerSample == 32);
+    }
+
+    TIZ_LOG (TIZ_PRIORITY_TRACE,
+             "decoder [%s] nChannels [%d] nBitPerSample [%d] supported [%s]...",
+             comp_name.c_str (), pcmtype.nChannels, pcmtype.nBitPerSample,
+             rc ? "YES" : "NO");
+  }
+  return rc;
+}
@@ -0,0 +1,83 @@
+/**
+ * Copyright (C) 2011-2017 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   tizhttpservtranscodergraphops.hpp
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  OpenMAX IL HTTP Streaming Server (transcoding) - graph operations
+ *
+ *
+ */
+
+#ifndef TIZHTTPSERVTRANSCODEROPS_HPP
+#define TIZHTTPSERVTRANSCODEROPS_HPP
+
+#include <string>
+
+#include "tizhttpservgraphops.hpp"
+
+namespace tiz
+{
+  namespace graph
+  {
+    class graph;
+
+    /**
+     * Operations of the transcoding variant of the streaming server
+     * graph. The graph is: file reader -> decoder -> mp3 encoder -> http
+     * renderer. The decoder is replaced whenever the coding type of the next
+     * track requires it. Only the http renderer is kept in Executing state
+     * between tracks, the rest of the graph (the 'chain') is re-cycled.
+     */
+    class httptranscoderops : public httpservops
+    {
+    public:
+      httptranscoderops (graph *p_graph, const omx_comp_name_lst_t &comp_lst,
+                         const omx_comp_role_lst_t &role_lst);
+
+    public:
+      void do_load ();
+      void do_probe ();
+      bool is_port_settings_evt_required () const;
+      void do_configure_stream ();
+
+      void do_loaded2idle_chain ();
+      void do_idle2exe_chain ();
+      void do_exe2idle_chain ();
+      void do_idle2loaded_chain ();
+
+    private:
+      OMX_ERRORTYPE replace_decoder (const std::string &comp_name,
+                                     const std::string &comp_role);
+      OMX_ERRORTYPE configure_decoder ();
+      OMX_ERRORTYPE transition_chain (const OMX_STATETYPE to_state,
+                                      const OMX_STATETYPE from_state);
+      void get_pcm_codec_info (OMX_AUDIO_PARAM_PCMMODETYPE &pcmtype);
+      void get_mp3_output_info (OMX_AUDIO_PARAM_MP3TYPE &mp3type);
+      // re-implemented from the base class
+      bool probe_stream_hook ();
+
+    private:
+      bool need_port_settings_changed_evt_;
+    };
+  }  // namespace graph
+}  // namespace tiz
+
+#endif  // TIZHTTPSERVTRANSCODEROPS_HPP
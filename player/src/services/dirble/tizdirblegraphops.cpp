@@ -476,6 +476,7 @@ graph::dirbleops::set_channels_and_rate_on_renderer (
   {
     // Opus and Vorbis decoders output 32 bit samples (floats)
     renderer_pcmtype_.nBitPerSample = 32;
+    renderer_pcmtype_.eNumData = OMX_NumericalDataFloat;
   }
 
   // Set the new pcm settings
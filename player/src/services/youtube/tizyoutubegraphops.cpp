@@ -681,6 +681,7 @@ graph::youtubeops::set_channels_and_rate_on_renderer (
   {
     // Vorbis decoders outputs 32 bit samples (floats)
     renderer_pcmtype_.nBitPerSample = 32;
+    renderer_pcmtype_.eNumData = OMX_NumericalDataFloat;
   }
 
   // Set the new pcm settings
@@ -164,9 +164,9 @@ graph::graph::pause ()
 }
 
 OMX_ERRORTYPE
-graph::graph::seek ()
+graph::graph::seek (const int offset_ms)
 {
-  return post_cmd (new tiz::graph::cmd (tiz::graph::seek_evt ()));
+  return post_cmd (new tiz::graph::cmd (tiz::graph::seek_evt (offset_ms)));
 }
 
 OMX_ERRORTYPE
@@ -217,9 +217,15 @@ void graph::graph::omx_evt (const omx_event_info &evt_info)
                         p_ops_->handle2name (evt_info.component_).c_str (),
                         evt_info.to_string ().c_str ());
 
-    if (evt_info.event_ == OMX_EventCmdComplete
-        && static_cast< OMX_COMMANDTYPE > (evt_info.ndata1_)
-               == OMX_CommandStateSet)
+    if (p_ops_->is_detached_component (evt_info.component_))
+    {
+      post_cmd (new tiz::graph::cmd (tiz::graph::omx_detached_evt (
+          evt_info.component_, evt_info.event_, evt_info.ndata1_,
+          evt_info.ndata2_)));
+    }
+    else if (evt_info.event_ == OMX_EventCmdComplete
+             && static_cast< OMX_COMMANDTYPE > (evt_info.ndata1_)
+                    == OMX_CommandStateSet)
     {
       OMX_ERRORTYPE error
           = static_cast< OMX_ERRORTYPE >(*((int *)&((evt_info.pEventData_))));
@@ -245,6 +251,15 @@ void graph::graph::omx_evt (const omx_event_info &evt_info)
       post_cmd (new tiz::graph::cmd (tiz::graph::omx_port_enabled_evt (
           evt_info.component_, evt_info.ndata2_, error)));
     }
+    else if (evt_info.event_ == OMX_EventCmdComplete
+             && static_cast< OMX_COMMANDTYPE > (evt_info.ndata1_)
+                    == OMX_CommandFlush)
+    {
+      OMX_ERRORTYPE error
+          = static_cast< OMX_ERRORTYPE > (*((int *)&((evt_info.pEventData_))));
+      post_cmd (new tiz::graph::cmd (tiz::graph::omx_port_flushed_evt (
+          evt_info.component_, evt_info.ndata2_, error)));
+    }
     else if (evt_info.event_ == OMX_EventError)
     {
       post_cmd (new tiz::graph::cmd (tiz::graph::omx_err_evt (
@@ -71,7 +71,7 @@ namespace tiz
       OMX_ERRORTYPE load ();
       OMX_ERRORTYPE execute (const tizgraphconfig_ptr_t config);
       OMX_ERRORTYPE pause ();
-      OMX_ERRORTYPE seek ();
+      OMX_ERRORTYPE seek (const int offset_ms);
       OMX_ERRORTYPE skip (const int jump);
       OMX_ERRORTYPE volume_step (const int step);
       OMX_ERRORTYPE volume (const double vol);
@@ -98,6 +98,7 @@ namespace tiz
                                   else INJECT_EVENT (unload_evt)
                                     else INJECT_EVENT (omx_port_disabled_evt)
                                       else INJECT_EVENT (omx_port_enabled_evt)
+                                       else INJECT_EVENT (omx_port_flushed_evt)
                                         else INJECT_EVENT (omx_port_settings_evt)
                                          else INJECT_EVENT (omx_index_setting_evt)
                                            else INJECT_EVENT (omx_format_detected_evt)
@@ -107,10 +108,12 @@ namespace tiz
                                                    else INJECT_EVENT (graph_updated_evt)
                                                      else INJECT_EVENT (graph_reconfigured_evt)
                                                        else INJECT_EVENT (tunnel_reconfigured_evt)
-                                                         else
-                                                           {
-                                                             assert (0);
-                                                           }
+                                                         else INJECT_EVENT (next_probed_evt)
+                                                           else INJECT_EVENT (omx_detached_evt)
+                                                             else
+                                                               {
+                                                                 assert (0);
+                                                               }
       }
 
     private:
@@ -95,8 +95,24 @@ namespace tiz
       }
     };
 
+    // Make this state convertible from any state (this event exits a sub-machine)
+    struct gapless_switched_evt
+    {
+      gapless_switched_evt ()
+      {
+      }
+      template < class Event >
+      gapless_switched_evt (Event const &)
+      {
+      }
+    };
+
     struct seek_evt
     {
+      seek_evt (const int offset_ms) : offset_ms_ (offset_ms)
+      {
+      }
+      int offset_ms_;
     };
 
     struct volume_step_evt
@@ -154,6 +170,32 @@ namespace tiz
       OMX_U32 flags_;
     };
 
+    // The result of probing the next track in the background
+    struct next_probed_evt
+    {
+      next_probed_evt (const tizprobe_ptr_t &probe) : probe_ (probe)
+      {
+      }
+      tizprobe_ptr_t probe_;
+    };
+
+    // An event from a component that is not in the graph's handle list, i.e.
+    // the next track's source and decoder while they are being prepared, or
+    // the previous track's while they are being unloaded
+    struct omx_detached_evt
+    {
+      omx_detached_evt (const OMX_HANDLETYPE a_handle,
+                        const OMX_EVENTTYPE a_event, const OMX_U32 a_data1,
+                        const OMX_U32 a_data2)
+        : handle_ (a_handle), event_ (a_event), data1_ (a_data1), data2_ (a_data2)
+      {
+      }
+      OMX_HANDLETYPE handle_;
+      OMX_EVENTTYPE event_;
+      OMX_U32 data1_;
+      OMX_U32 data2_;
+    };
+
     struct stop_evt
     {
     };
@@ -28,8 +28,10 @@
 #ifndef TIZGRAPHFSM_HPP
 #define TIZGRAPHFSM_HPP
 
+/* Whichever fsm header is included first sets the mpl limits for the whole
+   translation unit, so they all define the same BOOST_MPL_LIMIT_VECTOR_SIZE */
 #define BOOST_MPL_CFG_NO_PREPROCESSED_HEADERS
-#define BOOST_MPL_LIMIT_VECTOR_SIZE 40
+#define BOOST_MPL_LIMIT_VECTOR_SIZE 50
 #define FUSION_MAX_VECTOR_SIZE      20
 #define SPIRIT_ARGUMENTS_LIMIT      20
 
@@ -42,6 +44,7 @@
 #include <boost/msm/front/euml/operator.hpp>
 #include <boost/msm/back/tools.hpp>
 
+#include <OMX_TizoniaExt.h>
 #include <tizplatform.h>
 
 #include "tizgraphops.hpp"
@@ -73,6 +76,9 @@ namespace tiz
                                                "configuring",
                                                "executing",
                                                "skipping",
+                                               "switching",
+                                               "seeking",
+                                               "seek_flushing",
                                                "exe2pause",
                                                "pause",
                                                "pause2exe",
@@ -274,12 +280,91 @@ namespace tiz
       // typedef boost::msm::back::state_machine<skipping_, boost::msm::back::mpl_graph_fsm_check> skipping;
       typedef boost::msm::back::state_machine<skipping_> skipping;
 
+      /* 'switching' is a submachine: gapless switch to the next track. The
+         next track's source and decoder have been prepared beforehand and are
+         already in Executing; the decoder <-> renderer tunnel is disabled
+         only while the renderer is moved over to the new decoder */
+      struct switching_ : public boost::msm::front::state_machine_def<switching_>
+      {
+        // no need for exception handling
+        typedef int no_exception_thrown;
+
+        // data members
+        ops ** pp_ops_;
+
+        switching_()
+          :
+          pp_ops_(NULL)
+        {}
+        switching_(ops **pp_ops)
+          :
+          pp_ops_(pp_ops)
+        {
+          assert (pp_ops);
+        }
+
+        // submachine states
+        struct to_disabled : public boost::msm::front::state<>
+        {
+          template <class Event,class FSM>
+          void on_entry(Event const & evt, FSM & fsm)
+          {
+            G_FSM_LOG();
+            if (fsm.pp_ops_ && *(fsm.pp_ops_))
+              {
+                (*(fsm.pp_ops_))->do_start_gapless_switch ();
+                (*(fsm.pp_ops_))->do_disable_tunnel (1);
+              }
+          }
+          template <class Event,class FSM>
+          void on_exit(Event const & evt, FSM & fsm) {G_FSM_LOG();}
+        };
+
+        struct switch_exit : public boost::msm::front::exit_pseudo_state<gapless_switched_evt>
+        {
+          template <class Event,class FSM>
+          void on_entry(Event const & evt, FSM & fsm) {G_FSM_LOG();}
+        };
+
+        // the initial state. Must be defined
+        typedef to_disabled initial_state;
+
+        // transition actions
+
+        // guard conditions
+
+        // Transition table for switching
+        struct transition_table : boost::mpl::vector<
+          //                       Start             Event                    Next              Action                           Guard
+          //    +-----------------+------------------+------------------------+-----------------+--------------------------------+-------------------------------+
+          boost::msm::front::Row < to_disabled       , omx_port_disabled_evt  , enabling_tunnel , boost::msm::front::ActionSequence_<
+                                                                                                    boost::mpl::vector<
+                                                                                                      do_promote_next_chain,
+                                                                                                      do_enable_tunnel<1> > > , is_port_disabling_complete  >,
+          boost::msm::front::Row < enabling_tunnel   , omx_port_enabled_evt   , switch_exit     , do_ack_gapless_switch          , is_port_enabling_complete     >
+          //    +-----------------+------------------+------------------------+-----------------+--------------------------------+-------------------------------+
+          > {};
+
+        // Replaces the default no-transition response.
+        template <class FSM,class Event>
+        void no_transition(Event const& e, FSM&,int state)
+        {
+          TIZ_LOG (TIZ_PRIORITY_ERROR, "no transition from state %d on event %s",
+                   state, typeid(e).name());
+        }
+
+      };
+      // typedef boost::msm::back::state_machine<switching_, boost::msm::back::mpl_graph_fsm_check> switching;
+      typedef boost::msm::back::state_machine<switching_> switching;
+
       // The initial state of the SM. Must be defined
       typedef boost::mpl::vector<inited, AllOk> initial_state;
 
       // transition actions
 
       // guard conditions
+      typedef is_setting_changed< static_cast< OMX_INDEXTYPE >(
+          OMX_TizoniaIndexConfigStreamPosition) > is_stream_position_changed;
 
       // Transition table for the graph fsm
       struct transition_table : boost::mpl::vector<
@@ -305,7 +390,8 @@ namespace tiz
                                   ::conf_exit>, configured_evt , executing               , boost::msm::front::ActionSequence_<
                                                                                              boost::mpl::vector<
                                                                                                do_retrieve_metadata,
-                                                                                               do_ack_execd> >                            >,
+                                                                                               do_ack_execd,
+                                                                                               do_probe_next> >                           >,
         boost::msm::front::Row < configuring
                                  ::exit_pt
                                  <configuring_
@@ -316,7 +402,9 @@ namespace tiz
                                                                                                do_destroy_graph> > , is_end_of_play       >,
         //    +------------------------------+-----------------+-------------------------+-------------------------+----------------------+
         boost::msm::front::Row < executing   , skip_evt        , skipping                , do_store_skip                                  >,
-        boost::msm::front::Row < executing   , seek_evt        , boost::msm::front::none , do_seek                                        >,
+        boost::msm::front::Row < executing   , seek_evt        , seeking                 , do_seek                 , is_seekable          >,
+        boost::msm::front::Row < executing   , seek_evt        , boost::msm::front::none , boost::msm::front::none , boost::msm::front::euml::Not_<
+                                                                                                                       is_seekable>      >,
         boost::msm::front::Row < executing   , volume_step_evt , boost::msm::front::none , do_volume_step                                 >,
         boost::msm::front::Row < executing   , volume_evt      , boost::msm::front::none , do_volume                                      >,
         boost::msm::front::Row < executing   , mute_evt        , boost::msm::front::none , do_mute                                        >,
@@ -329,6 +417,10 @@ namespace tiz
         boost::msm::front::Row < executing   , omx_err_evt     , skipping                , boost::msm::front::none                        >,
         boost::msm::front::Row < executing   , omx_err_evt     , skipping                , do_record_fatal_error   , is_fatal_error       >,
         boost::msm::front::Row < executing   , omx_eos_evt     , skipping                , boost::msm::front::none , is_last_eos          >,
+        boost::msm::front::Row < executing   , omx_eos_evt     , switching               , boost::msm::front::none , bmf::euml::And_<
+                                                                                                                       is_last_eos,
+                                                                                                                       is_gapless_switch_possible > >,
+        boost::msm::front::Row < executing   , omx_eos_evt     , boost::msm::front::none , do_start_next_chain     , is_next_chain_ready  >,
         //    +------------------------------+-----------------+-------------------------+-------------------------+----------------------+
         boost::msm::front::Row < skipping
                                  ::exit_pt
@@ -352,6 +444,35 @@ namespace tiz
                                   ::skip_exit>, skipped_evt    , configuring             , boost::msm::front::none , boost::msm::front::euml::Not_<
                                                                                                                        is_end_of_play>   >,
         //    +------------------------------+-----------------+-------------------------+-------------------------+----------------------+
+        boost::msm::front::Row < switching
+                                 ::exit_pt
+                                 <switching_
+                                  ::switch_exit>, gapless_switched_evt, executing    , boost::msm::front::ActionSequence_<
+                                                                                             boost::mpl::vector<
+                                                                                               do_retrieve_metadata,
+                                                                                               do_ack_execd,
+                                                                                               do_probe_next> >                           >,
+        boost::msm::front::Row < switching
+                                 ::exit_pt
+                                 <switching_
+                                  ::switch_exit>, gapless_switched_evt, unloaded     , boost::msm::front::ActionSequence_<
+                                                                                             boost::mpl::vector<
+                                                                                               do_error,
+                                                                                               do_tear_down_tunnels,
+                                                                                               do_destroy_graph> > , is_internal_error    >,
+        //    +------------------------------+-----------------+-------------------------+-------------------------+----------------------+
+        boost::msm::front::Row < seeking     , omx_index_setting_evt , seek_flushing     , boost::msm::front::ActionSequence_<
+                                                                                             boost::mpl::vector<
+                                                                                               do_flush_tunnel<0>,
+                                                                                               do_flush_tunnel<1> > > , is_stream_position_changed >,
+        boost::msm::front::Row < seeking     , omx_err_evt     , skipping                , do_record_fatal_error   , is_fatal_error       >,
+        //    +------------------------------+-----------------+-------------------------+-------------------------+----------------------+
+        boost::msm::front::Row < seek_flushing, omx_port_flushed_evt, executing          , boost::msm::front::ActionSequence_<
+                                                                                             boost::mpl::vector<
+                                                                                               do_seek_source,
+                                                                                               do_ack_seeked> >    , is_port_flushing_complete >,
+        boost::msm::front::Row < seek_flushing, omx_err_evt    , skipping                , do_record_fatal_error   , is_fatal_error       >,
+        //    +------------------------------+-----------------+-------------------------+-------------------------+----------------------+
         boost::msm::front::Row < exe2pause   , omx_trans_evt   , pause                   , do_ack_paused           , is_trans_complete    >,
         //    +------------------------------+-----------------+-------------------------+-------------------------+----------------------+
         boost::msm::front::Row < pause       , execute_evt     , pause2exe               , do_pause2exe                               >,
@@ -395,7 +516,9 @@ namespace tiz
                                                                                                do_tear_down_tunnels,
                                                                                                do_destroy_graph> > , is_trans_complete    >,
         //    +------------------------------+-----------------+-------------------------+-------------------------+----------------------+
-        boost::msm::front::Row < AllOk       , err_evt         , unloaded                , do_error                                       >
+        boost::msm::front::Row < AllOk       , err_evt         , unloaded                , do_error                                       >,
+        boost::msm::front::Row < AllOk       , next_probed_evt , boost::msm::front::none , do_preroll_next                                >,
+        boost::msm::front::Row < AllOk       , omx_detached_evt, boost::msm::front::none , do_detached_evt                                >
         //    +------------------------------+-----------------+-------------------------+-------------------------+----------------------+
         > {};
 
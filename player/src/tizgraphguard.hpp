@@ -84,6 +84,71 @@ namespace tiz
       }
     };
 
+    struct is_port_flushing_complete
+    {
+      template < class EVT, class FSM, class SourceState, class TargetState >
+      bool operator()(EVT const& evt, FSM& fsm, SourceState& source,
+                      TargetState& target)
+      {
+        bool rc = false;
+        if (fsm.pp_ops_ && *(fsm.pp_ops_))
+        {
+          rc = (*(fsm.pp_ops_))
+                   ->is_port_flushing_complete (evt.handle_, evt.port_);
+        }
+        G_GUARD_LOG (rc);
+        return rc;
+      }
+    };
+
+    struct is_seekable
+    {
+      template < class EVT, class FSM, class SourceState, class TargetState >
+      bool operator()(EVT const& evt, FSM& fsm, SourceState& source,
+                      TargetState& target)
+      {
+        bool rc = false;
+        if (fsm.pp_ops_ && *(fsm.pp_ops_))
+        {
+          rc = (*(fsm.pp_ops_))->is_seekable ();
+        }
+        G_GUARD_LOG (rc);
+        return rc;
+      }
+    };
+
+    struct is_gapless_switch_possible
+    {
+      template < class EVT, class FSM, class SourceState, class TargetState >
+      bool operator()(EVT const& evt, FSM& fsm, SourceState& source,
+                      TargetState& target)
+      {
+        bool rc = false;
+        if (fsm.pp_ops_ && *(fsm.pp_ops_))
+        {
+          rc = (*(fsm.pp_ops_))->is_gapless_switch_possible ();
+        }
+        G_GUARD_LOG (rc);
+        return rc;
+      }
+    };
+
+    struct is_next_chain_ready
+    {
+      template < class EVT, class FSM, class SourceState, class TargetState >
+      bool operator()(EVT const& evt, FSM& fsm, SourceState& source,
+                      TargetState& target)
+      {
+        bool rc = false;
+        if (fsm.pp_ops_ && *(fsm.pp_ops_))
+        {
+          rc = (*(fsm.pp_ops_))->is_next_chain_ready (evt.handle_);
+        }
+        G_GUARD_LOG (rc);
+        return rc;
+      }
+    };
+
     struct is_disabled_evt_required
     {
       template < class EVT, class FSM, class SourceState, class TargetState >
@@ -243,6 +243,14 @@ graphmgr::mgr::quit ()
   return post_cmd (new graphmgr::cmd (graphmgr::quit_evt ()));
 }
 
+OMX_ERRORTYPE
+graphmgr::mgr::complete_playlist (const uri_lst_t &uri_list)
+{
+  assert (p_ops_);
+  p_ops_->complete_playlist (uri_list);
+  return OMX_ErrorNone;
+}
+
 OMX_ERRORTYPE
 graphmgr::mgr::graph_loaded ()
 {
@@ -210,6 +210,19 @@ namespace tiz
        */
       OMX_ERRORTYPE quit ();
 
+      /**
+       * Append the rest of a playlist that was given to init () before a scan
+       * had found all of its entries (see tiz::playlist::set_complete).
+       *
+       * @note This method may be called from any thread. The entries are
+       * picked up the next time the manager moves on to another sub-playlist.
+       *
+       * @pre init() has been called on this manager.
+       *
+       * @return OMX_ErrorNone.
+       */
+      OMX_ERRORTYPE complete_playlist (const uri_lst_t &uri_list);
+
     protected:
       virtual ops *do_init (const tizplaylist_ptr_t &playlist,
                             const termination_callback_t &termination_cback,
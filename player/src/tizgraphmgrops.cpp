@@ -30,6 +30,7 @@
 #endif
 
 #include <boost/make_shared.hpp>
+#include <boost/thread/locks.hpp>
 
 #include <tizplatform.h>
 #include <tizmacros.h>
@@ -62,7 +63,10 @@ graphmgr::ops::ops (graphmgr::mgr *p_mgr, const tizplaylist_ptr_t &playlist,
     p_managed_graph_ (),
     termination_cback_ (termination_cback),
     error_code_ (OMX_ErrorNone),
-    error_msg_ ()
+    error_msg_ (),
+    rest_mutex_ (),
+    rest_uri_list_ (),
+    rest_ready_ (false)
 {
   TIZ_LOG (TIZ_PRIORITY_TRACE, "Constructing...");
 }
@@ -132,6 +136,7 @@ tizgraph_ptr_t graphmgr::ops::get_graph (const std::string &uri)
 
 void graphmgr::ops::do_load ()
 {
+  merge_playlist_rest ();
   next_playlist_ = find_next_sub_list ();
 
   if (next_playlist_)
@@ -159,7 +164,10 @@ void graphmgr::ops::do_execute ()
   assert (playlist_);
   assert (next_playlist_);
 
-  next_playlist_->set_loop_playback (playlist_->single_format ());
+  // While a scan is still completing the playlist, let the graph report the
+  // end of its sub-playlist, so that the new entries get picked up here
+  next_playlist_->set_loop_playback (playlist_->single_format ()
+                                     && playlist_->complete ());
   graph_config_.reset ();
   graph_config_ = boost::make_shared< tiz::graph::config >(next_playlist_);
 
@@ -228,12 +236,16 @@ void graphmgr::ops::do_prev ()
 
 void graphmgr::ops::do_fwd ()
 {
-  // TODO:
+  GMGR_OPS_BAIL_IF_ERROR (p_managed_graph_,
+                          p_managed_graph_->seek (SEEK_STEP_MS),
+                          "Unable to seek forward.");
 }
 
 void graphmgr::ops::do_rwd ()
 {
-  // TODO:
+  GMGR_OPS_BAIL_IF_ERROR (p_managed_graph_,
+                          p_managed_graph_->seek (-SEEK_STEP_MS),
+                          "Unable to seek backward.");
 }
 
 void graphmgr::ops::do_vol_up ()
@@ -355,3 +367,37 @@ tizplaylist_ptr_t graphmgr::ops::find_next_sub_list () const
 
   return next_lst;
 }
+
+/**
+ * Hands over the entries that a background scan has found after playback
+ * started. This is called from the scanning thread; the entries are merged
+ * into the playlist the next time a sub-playlist is loaded.
+ */
+void graphmgr::ops::complete_playlist (const uri_lst_t &uri_list)
+{
+  boost::lock_guard< boost::mutex > lock (rest_mutex_);
+  rest_uri_list_.insert (rest_uri_list_.end (), uri_list.begin (),
+                         uri_list.end ());
+  rest_ready_ = true;
+}
+
+void graphmgr::ops::merge_playlist_rest ()
+{
+  assert (playlist_);
+
+  uri_lst_t uri_list;
+  {
+    boost::lock_guard< boost::mutex > lock (rest_mutex_);
+    if (!rest_ready_)
+    {
+      return;
+    }
+    uri_list.swap (rest_uri_list_);
+    rest_ready_ = false;
+  }
+
+  TIZ_LOG (TIZ_PRIORITY_TRACE, "[%zu] entries appended to the playlist",
+           uri_list.size ());
+  playlist_->append (uri_list);
+  playlist_->set_complete (true);
+}
@@ -31,6 +31,7 @@
 
 #include <string>
 #include <boost/function.hpp>
+#include <boost/thread/mutex.hpp>
 
 #include <OMX_Core.h>
 
@@ -79,6 +80,9 @@ namespace tiz
       typedef boost::function< void(OMX_ERRORTYPE, std::string) >
           termination_callback_t;
 
+      // The size of a fwd/rwd step
+      static const int SEEK_STEP_MS = 10000;
+
     public:
       ops (mgr *p_mgr, const tizplaylist_ptr_t &playlist,
            const termination_callback_t &termination_cback);
@@ -115,9 +119,13 @@ namespace tiz
 
       tizplaylist_ptr_t find_next_sub_list () const;
 
+      void complete_playlist (const uri_lst_t &uri_list);
+
     protected:
       virtual tizgraph_ptr_t get_graph (const std::string &uri);
 
+      void merge_playlist_rest ();
+
     protected:
       mgr *p_mgr_;              // Not owned
       tizplaylist_ptr_t playlist_;
@@ -128,6 +136,9 @@ namespace tiz
       termination_callback_t termination_cback_;
       OMX_ERRORTYPE error_code_;
       std::string error_msg_;
+      boost::mutex rest_mutex_;
+      uri_lst_t rest_uri_list_;
+      bool rest_ready_;
     };
   }  // namespace graphmgr
 }  // namespace tiz
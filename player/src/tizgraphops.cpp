@@ -35,11 +35,13 @@
 
 #include <algorithm>
 
+#include <boost/bind.hpp>
 #include <boost/make_shared.hpp>
 #include <boost/mem_fn.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/assign/list_of.hpp>
 
+#include <OMX_TizoniaExt.h>
 #include <tizplatform.h>
 #include <tizmacros.h>
 
@@ -48,6 +50,7 @@
 #include "tizgraphconfig.hpp"
 #include "tizgraphutil.hpp"
 #include "tizgraphcback.hpp"
+#include "tizgraphcmd.hpp"
 #include "tizgraphops.hpp"
 
 #ifdef TIZ_LOG_CATEGORY_NAME
@@ -64,6 +67,11 @@ graph::ops::ops (graph *p_graph, const omx_comp_name_lst_t &comp_lst,
                  const omx_comp_role_lst_t &role_lst)
   : p_graph_ (p_graph),
     probe_ptr_ (),
+    next_probe_ptr_ (),
+    probe_thread_ptr_ (),
+    next_chain_ (omx_comp_handle_lst_t (), OMX_StateLoaded),
+    retired_chains_ (),
+    side_chains_mutex_ (),
     comp_lst_ (comp_lst),
     role_lst_ (role_lst),
     handles_ (),
@@ -76,6 +84,11 @@ graph::ops::ops (graph *p_graph, const omx_comp_name_lst_t &comp_lst,
     destination_state_ (OMX_StateMax),
     metadata_ (),
     volume_ (80),
+    seek_start_ (),
+    gapless_start_ (),
+    graph_id_ (),
+    graph_action_ (),
+    stream_info_dump_f_ (NULL),
     error_code_ (OMX_ErrorNone),
     error_msg_ ()
 {
@@ -86,6 +99,7 @@ graph::ops::ops (graph *p_graph, const omx_comp_name_lst_t &comp_lst,
 
 graph::ops::~ops ()
 {
+  join_probe_thread ();
 }
 
 void graph::ops::do_load ()
@@ -195,7 +209,24 @@ void graph::ops::do_flush_tunnel (const int tunnel_id)
 {
   if (last_op_succeeded ())
   {
-    // TODO
+    std::string err_msg ("Unable to flush tunnel id [");
+    err_msg.append (boost::lexical_cast< std::string >(tunnel_id));
+    err_msg.append ("]");
+    assert (tunnel_id >= 0
+            && static_cast< std::size_t >(tunnel_id + 1) < handles_.size ());
+    if (0 == tunnel_id)
+    {
+      clear_expected_port_transitions ();
+    }
+    // The upstream end of a tunnel is the output port of the component
+    // (port #0 of the source, port #1 of the others); the downstream end is
+    // always port #0
+    add_expected_port_transition (handles_[tunnel_id], tunnel_id == 0 ? 0 : 1,
+                                  OMX_CommandFlush);
+    add_expected_port_transition (handles_[tunnel_id + 1], 0,
+                                  OMX_CommandFlush);
+    G_OPS_BAIL_IF_ERROR (
+        util::modify_tunnel (handles_, tunnel_id, OMX_CommandFlush), err_msg);
   }
 }
 
@@ -362,6 +393,7 @@ void graph::ops::do_pause2exe ()
 
 void graph::ops::do_pause2idle ()
 {
+  retire_next_chain ();
   assert (!handles_.empty ());
   if (last_op_succeeded ())
   {
@@ -383,6 +415,7 @@ void graph::ops::do_pause2idle ()
 
 void graph::ops::do_exe2idle ()
 {
+  retire_next_chain ();
   if (last_op_succeeded ())
   {
     G_OPS_BAIL_IF_ERROR (
@@ -423,13 +456,244 @@ void graph::ops::do_idle2loaded_comp (const int comp_id)
   }
 }
 
-void graph::ops::do_seek ()
+/**
+ * Default implementation of do_seek () operation. It hands the request over to
+ * the decoder (the second element of the graph), which replies with an
+ * OMX_EventIndexSettingChanged event once it has worked out where the source
+ * needs to be repositioned.
+ *
+ * @param offset_ms The offset, in milliseconds, relative to the current
+ * position (negative to seek backwards).
+ */
+void graph::ops::do_seek (const int offset_ms)
+{
+  if (last_op_succeeded ())
+  {
+    OMX_TIZONIA_STREAMPOSITIONTYPE position;
+    TIZ_INIT_OMX_PORT_STRUCT (position, 0);
+    position.nTimestamp = static_cast< OMX_TICKS >(offset_ms) * 1000;
+    position.nByteOffset = -1;
+    (void)gettimeofday (&seek_start_, NULL);
+    G_OPS_BAIL_IF_ERROR (
+        OMX_SetConfig (handles_[1], static_cast< OMX_INDEXTYPE >(
+                                        OMX_TizoniaIndexConfigStreamPosition),
+                       &position),
+        "Unable to set OMX_TizoniaIndexConfigStreamPosition (decoder)");
+  }
+}
+
+/**
+ * Repositions the source at the seek point that the decoder has published on
+ * its input port, once the decoder's tunnels have been flushed.
+ */
+void graph::ops::do_seek_source ()
+{
+  if (last_op_succeeded ())
+  {
+    OMX_TIZONIA_STREAMPOSITIONTYPE position;
+    TIZ_INIT_OMX_PORT_STRUCT (position, 0);
+    G_OPS_BAIL_IF_ERROR (
+        OMX_GetConfig (handles_[1], static_cast< OMX_INDEXTYPE >(
+                                        OMX_TizoniaIndexConfigStreamPosition),
+                       &position),
+        "Unable to get OMX_TizoniaIndexConfigStreamPosition (decoder)");
+    TIZ_LOG (TIZ_PRIORITY_NOTICE, "seek point : time [%lld] us offset [%lld]",
+             (long long)position.nTimestamp, (long long)position.nByteOffset);
+    position.nPortIndex = 0;
+    G_OPS_BAIL_IF_ERROR (
+        OMX_SetConfig (handles_[0], static_cast< OMX_INDEXTYPE >(
+                                        OMX_TizoniaIndexConfigStreamPosition),
+                       &position),
+        "Unable to set OMX_TizoniaIndexConfigStreamPosition (source)");
+  }
+}
+
+void graph::ops::do_ack_seeked ()
+{
+  if (last_op_succeeded ())
+  {
+    struct timeval now;
+    (void)gettimeofday (&now, NULL);
+    const long long latency_us
+        = (now.tv_sec - seek_start_.tv_sec) * 1000000LL
+          + (now.tv_usec - seek_start_.tv_usec);
+    TIZ_LOG (TIZ_PRIORITY_NOTICE, "[%s] : seek latency [%lld] us",
+             p_graph_ ? p_graph_->get_graph_name ().c_str () : "",
+             latency_us);
+  }
+}
+
+/**
+ * Probes the track that follows the current one, in the background, so that
+ * its source and decoder can be prepared while the current track plays. This
+ * only happens when gapless playback is enabled and the graph is a plain
+ * source -> decoder -> renderer chain. The result arrives as a
+ * next_probed_evt.
+ */
+void graph::ops::do_probe_next ()
+{
+  // A chain prepared for another track is of no use anymore
+  retire_next_chain ();
+  join_probe_thread ();
+  next_probe_ptr_.reset ();
+  if (last_op_succeeded () && playlist_ && 3 == handles_.size ()
+      && util::is_gapless_playback_enabled ())
+  {
+    const std::string next_uri = playlist_->peek_uri (SKIP_DEFAULT_VALUE);
+    if (!next_uri.empty ())
+    {
+      probe_thread_ptr_ = boost::make_shared< boost::thread >(
+          boost::bind (&ops::probe_next_uri, this, next_uri));
+    }
+  }
+}
+
+/**
+ * Stores the next track's probe, and if the track can be played without
+ * stopping the renderer, instantiates its source and decoder and takes them
+ * to Idle, outside the graph's handle list.
+ */
+void graph::ops::do_preroll_next (const tizprobe_ptr_t &probe)
+{
+  assert (probe);
+  next_probe_ptr_ = probe;
+  if (last_op_succeeded () && next_chain_.first.empty ()
+      && 3 == handles_.size () && 3 == comp_lst_.size ()
+      && (util::verify_transition_all (handles_, OMX_StateExecuting)
+          || util::verify_transition_all (handles_, OMX_StatePause))
+      && is_next_track_compatible ())
+  {
+    const OMX_ERRORTYPE rc = prepare_next_chain ();
+    if (OMX_ErrorNone != rc)
+    {
+      TIZ_LOG (TIZ_PRIORITY_ERROR,
+               "[%s] : Unable to prepare the next track's chain",
+               tiz_err_to_str (rc));
+      retire_next_chain ();
+    }
+  }
+}
+
+/**
+ * Handles the events from the components that are not in handles_. Errors
+ * discard the next track's chain, and state transitions move the retired
+ * chains along their way to Loaded.
+ */
+void graph::ops::do_detached_evt (const OMX_HANDLETYPE handle,
+                                  const OMX_EVENTTYPE event,
+                                  const OMX_U32 data1, const OMX_U32 data2)
+{
+  if (OMX_EventError == event)
+  {
+    TIZ_LOG (TIZ_PRIORITY_ERROR, "[%s] : detached component error [%s]",
+             handle2name (handle).c_str (),
+             tiz_err_to_str (static_cast< OMX_ERRORTYPE >(data1)));
+    if (std::find (next_chain_.first.begin (), next_chain_.first.end (),
+                   handle) != next_chain_.first.end ())
+    {
+      retire_next_chain ();
+    }
+  }
+  else if (OMX_EventCmdComplete == event
+           && OMX_CommandStateSet == static_cast< OMX_COMMANDTYPE >(data1))
+  {
+    advance_retired_chains ();
+  }
+}
+
+/**
+ * Called at the decoder's end of stream: the next track's source and decoder
+ * start decoding, and wait for the renderer behind the decoder's disabled
+ * output port.
+ */
+void graph::ops::do_start_next_chain ()
+{
+  const OMX_ERRORTYPE rc = util::transition_all (
+      next_chain_.first, OMX_StateExecuting, OMX_StateIdle);
+  if (OMX_ErrorNone != rc)
+  {
+    TIZ_LOG (TIZ_PRIORITY_ERROR,
+             "[%s] : Unable to transition the next track's chain to "
+             "Executing",
+             tiz_err_to_str (rc));
+    retire_next_chain ();
+  }
+  else
+  {
+    next_chain_.second = OMX_StateExecuting;
+  }
+}
+
+/**
+ * Replaces the current source and decoder with the next track's, once the
+ * decoder <-> renderer tunnel is disabled. The previous source and decoder are
+ * retired, i.e. unloaded and destroyed as their events arrive.
+ */
+void graph::ops::do_promote_next_chain ()
 {
-  // TODO
+  if (last_op_succeeded ())
+  {
+    assert (2 == next_chain_.first.size ());
+    assert (next_probe_ptr_);
+    G_OPS_BAIL_IF_ERROR (
+        OMX_TeardownTunnel (handles_[1], 1, handles_[2], 0),
+        "Unable to tear down the decoder <-> renderer tunnel.");
+    {
+      boost::lock_guard< boost::mutex > lock (side_chains_mutex_);
+      retired_chains_.push_back (side_chain_t (
+          omx_comp_handle_lst_t (handles_.begin (), handles_.begin () + 2),
+          OMX_StateExecuting));
+      handles_[0] = next_chain_.first[0];
+      handles_[1] = next_chain_.first[1];
+      next_chain_.first.clear ();
+    }
+    advance_retired_chains ();
+
+    G_OPS_BAIL_IF_ERROR (util::setup_suppliers (handles_, 1),
+                         "Unable to setup suppliers.");
+    G_OPS_BAIL_IF_ERROR (util::setup_tunnels (handles_, 1),
+                         "Unable to setup tunnels.");
+
+    // The next track is now the current one
+    playlist_->skip (SKIP_DEFAULT_VALUE);
+    probe_ptr_ = next_probe_ptr_;
+    next_probe_ptr_.reset ();
+  }
+}
+
+void graph::ops::do_start_gapless_switch ()
+{
+  (void)gettimeofday (&gapless_start_, NULL);
+}
+
+/**
+ * Reports the time that the renderer spent with its input port disabled,
+ * expressed in samples at the current track's sampling rate. The renderer may
+ * still have been playing out its own buffer in the meantime.
+ */
+void graph::ops::do_ack_gapless_switch ()
+{
+  if (last_op_succeeded () && probe_ptr_)
+  {
+    struct timeval now;
+    (void)gettimeofday (&now, NULL);
+    const long long gap_us = (now.tv_sec - gapless_start_.tv_sec) * 1000000LL
+                             + (now.tv_usec - gapless_start_.tv_usec);
+    OMX_AUDIO_PARAM_PCMMODETYPE pcmtype;
+    probe_ptr_->get_pcm_codec_info (pcmtype);
+    const long long gap_samples
+        = gap_us * (long long)pcmtype.nSamplingRate / 1000000LL;
+    TIZ_LOG (TIZ_PRIORITY_NOTICE,
+             "[%s] : renderer input disabled for [%lld] samples [%lld] us",
+             p_graph_ ? p_graph_->get_graph_name ().c_str () : "",
+             gap_samples, gap_us);
+    dump_stream_info ();
+  }
 }
 
 void graph::ops::do_skip ()
 {
+  retire_next_chain ();
   if (last_op_succeeded () && 0 != jump_ && !is_end_of_play ())
   {
     playlist_->skip (jump_);
@@ -440,6 +704,7 @@ void graph::ops::do_skip ()
 
 void graph::ops::do_store_skip (const int jump)
 {
+  retire_next_chain ();
   jump_ = jump;
 }
 
@@ -545,6 +810,20 @@ void graph::ops::do_tear_down_tunnels ()
 
 void graph::ops::do_destroy_graph ()
 {
+  join_probe_thread ();
+  // Normally the side chains are unloaded by now; if not, free them anyway
+  side_chain_lst_t side_chains;
+  {
+    boost::lock_guard< boost::mutex > lock (side_chains_mutex_);
+    side_chains.swap (retired_chains_);
+    side_chains.push_back (next_chain_);
+    next_chain_.first.clear ();
+  }
+  side_chain_lst_t::iterator it = side_chains.begin ();
+  for (; it != side_chains.end (); ++it)
+  {
+    destroy_side_chain (it->first);
+  }
   util::destroy_list (handles_);
   handles_.clear ();
   h2n_.clear ();
@@ -727,6 +1006,86 @@ bool graph::ops::is_port_enabling_complete (const OMX_HANDLETYPE handle,
   return is_port_transition_complete (handle, port_id, OMX_CommandPortEnable);
 }
 
+bool graph::ops::is_port_flushing_complete (const OMX_HANDLETYPE handle,
+                                            const OMX_U32 port_id)
+{
+  return is_port_transition_complete (handle, port_id, OMX_CommandFlush);
+}
+
+bool graph::ops::is_seekable () const
+{
+  bool rc = false;
+  if (handles_.size () > 2)
+  {
+    // A decoder advertises that it can seek by publishing a non-negative
+    // timestamp on its input port
+    OMX_TIZONIA_STREAMPOSITIONTYPE position;
+    TIZ_INIT_OMX_PORT_STRUCT (position, 0);
+    if (OMX_ErrorNone
+        == OMX_GetConfig (handles_[1], static_cast< OMX_INDEXTYPE >(
+                                           OMX_TizoniaIndexConfigStreamPosition),
+                          &position))
+    {
+      rc = (position.nTimestamp >= 0);
+    }
+  }
+  TIZ_LOG (TIZ_PRIORITY_TRACE, "is_seekable [%s]...", rc ? "YES" : "NO");
+  return rc;
+}
+
+/**
+ * At the renderer's end of stream, decides whether the graph can switch over
+ * to the next track's source and decoder, which must be in Executing already.
+ */
+bool graph::ops::is_gapless_switch_possible () const
+{
+  bool rc = false;
+  if (!next_chain_.first.empty () && OMX_StateExecuting == next_chain_.second
+      && SKIP_DEFAULT_VALUE == jump_ && next_probe_ptr_ && playlist_
+      && next_probe_ptr_->get_uri () == playlist_->peek_uri (jump_))
+  {
+    rc = util::verify_transition_all (next_chain_.first, OMX_StateExecuting);
+  }
+  TIZ_LOG (TIZ_PRIORITY_TRACE, "is_gapless_switch_possible [%s]...",
+           rc ? "YES" : "NO");
+  return rc;
+}
+
+/**
+ * Whether an end of stream event comes from the decoder while the next
+ * track's source and decoder are waiting in Idle.
+ */
+bool graph::ops::is_next_chain_ready (const OMX_HANDLETYPE eos_handle) const
+{
+  bool rc = false;
+  if (3 == handles_.size () && eos_handle == handles_[1]
+      && !next_chain_.first.empty () && OMX_StateIdle == next_chain_.second)
+  {
+    rc = util::verify_transition_all (next_chain_.first, OMX_StateIdle);
+  }
+  TIZ_LOG (TIZ_PRIORITY_TRACE, "is_next_chain_ready [%s]...",
+           rc ? "YES" : "NO");
+  return rc;
+}
+
+/**
+ * Called from the OMX callback thread, to route the events of the components
+ * that are not in handles_ away from the fsm's regular rows.
+ */
+bool graph::ops::is_detached_component (const OMX_HANDLETYPE handle) const
+{
+  boost::lock_guard< boost::mutex > lock (side_chains_mutex_);
+  bool rc = (std::find (next_chain_.first.begin (), next_chain_.first.end (),
+                        handle) != next_chain_.first.end ());
+  side_chain_lst_t::const_iterator it = retired_chains_.begin ();
+  for (; !rc && it != retired_chains_.end (); ++it)
+  {
+    rc = (std::find (it->first.begin (), it->first.end (), handle)
+          != it->first.end ());
+  }
+  return rc;
+}
+
 bool graph::ops::last_op_succeeded () const
 {
 #ifdef _DEBUG
@@ -875,10 +1234,18 @@ graph::ops::probe_stream (const OMX_PORTDOMAINTYPE omx_domain,
   const std::string &uri = playlist_->get_current_uri ();
   assert (!uri.empty ());
 
-  // Probe a new uri
+  // Probe a new uri, unless it has already been probed ahead of time
   probe_ptr_.reset ();
-  const bool quiet_probing = true;
-  probe_ptr_ = boost::make_shared< tiz::probe >(uri, quiet_probing);
+  if (next_probe_ptr_ && next_probe_ptr_->get_uri () == uri)
+  {
+    probe_ptr_ = next_probe_ptr_;
+  }
+  else
+  {
+    const bool quiet_probing = true;
+    probe_ptr_ = boost::make_shared< tiz::probe >(uri, quiet_probing);
+  }
+  next_probe_ptr_.reset ();
 
   if (probe_ptr_)
   {
@@ -887,8 +1254,13 @@ graph::ops::probe_stream (const OMX_PORTDOMAINTYPE omx_domain,
     {
       case OMX_PortDomainAudio:
       {
+        // OMX_AUDIO_CodingAutoDetect accepts any audio coding; the graph's
+        // probe_stream_hook () decides whether it can actually be handled
         const int coding = probe_ptr_->get_audio_coding_type ();
-        omx_coding_found = coding == omx_coding;
+        omx_coding_found
+            = (coding == omx_coding
+               || (OMX_AUDIO_CodingAutoDetect == omx_coding
+                   && OMX_AUDIO_CodingUnused != coding));
       }
       break;
       case OMX_PortDomainVideo:
@@ -927,16 +1299,13 @@ graph::ops::probe_stream (const OMX_PORTDOMAINTYPE omx_domain,
     }
     else
     {
+      // Kept for the tracks that start with a gapless switch
+      graph_id_ = graph_id;
+      graph_action_ = graph_action;
+      stream_info_dump_f_ = stream_info_dump_f;
       if (!quiet)
       {
-        tiz::graph::util::dump_graph_info (graph_id.c_str (),
-                                           graph_action.c_str (), uri);
-        probe_ptr_->dump_stream_metadata ();
-        boost::bind (boost::mem_fn (stream_info_dump_f), probe_ptr_)();
-
-        metadata_ = boost::assign::map_list_of ("trackid", "1")
-                        .convert_to_container< track_metadata_map_t > ();
-        do_ack_metadata ();
+        dump_stream_info ();
       }
 
       // Everything went well..
@@ -1002,10 +1371,35 @@ graph::ops::transition_tunnel (const int tunnel_id,
 
 OMX_ERRORTYPE
 graph::ops::switch_tunnel (const int tunnel_id,
-                               const OMX_COMMANDTYPE to_disabled_or_enabled)
+                           const OMX_COMMANDTYPE to_disabled_or_enabled)
 {
-  // Default implementation. To be overriden by derived classes.
-  return OMX_ErrorNone;
+  // Default implementation. Assumes the usual port layout, i.e. the upstream
+  // end of a tunnel is port #0 of the source or port #1 of any other
+  // component, and the downstream end is always port #0.
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+
+  assert (tunnel_id >= 0
+          && static_cast< std::size_t >(tunnel_id + 1) < handles_.size ());
+  assert (to_disabled_or_enabled == OMX_CommandPortDisable
+          || to_disabled_or_enabled == OMX_CommandPortEnable);
+
+  if (to_disabled_or_enabled == OMX_CommandPortDisable)
+  {
+    rc = tiz::graph::util::disable_tunnel (handles_, tunnel_id);
+  }
+  else
+  {
+    rc = tiz::graph::util::enable_tunnel (handles_, tunnel_id);
+  }
+
+  if (OMX_ErrorNone == rc)
+  {
+    add_expected_port_transition (handles_[tunnel_id], tunnel_id == 0 ? 0 : 1,
+                                  to_disabled_or_enabled);
+    add_expected_port_transition (handles_[tunnel_id + 1], 0,
+                                  to_disabled_or_enabled);
+  }
+  return rc;
 }
 
 OMX_ERRORTYPE
@@ -1066,3 +1460,242 @@ graph::cbackhandler &graph::ops::get_cback_handler () const
 {
   return p_graph_->cback_handler_;
 }
+
+OMX_ERRORTYPE
+graph::ops::configure_next_chain (const omx_comp_handle_lst_t &chain,
+                                  const tizprobe_ptr_t &probe)
+{
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+  bool need_port_settings_changed_evt = false;
+  assert (2 == chain.size ());
+  assert (probe);
+
+  tiz_check_omx (util::set_content_uri (chain[0], probe->get_uri ()));
+
+  switch (probe->get_audio_coding_type ())
+  {
+    case OMX_AUDIO_CodingMP3:
+    {
+      rc = tiz::graph::util::set_mp3_type (
+          chain[1], 0,
+          boost::bind (&tiz::probe::get_mp3_codec_info, probe, _1),
+          need_port_settings_changed_evt);
+    }
+    break;
+    case OMX_AUDIO_CodingAAC:
+    {
+      rc = tiz::graph::util::set_aac_type (
+          chain[1], 0,
+          boost::bind (&tiz::probe::get_aac_codec_info, probe, _1),
+          need_port_settings_changed_evt);
+    }
+    break;
+    case OMX_AUDIO_CodingFLAC:
+    {
+      rc = tiz::graph::util::set_flac_type (
+          chain[1], 0,
+          boost::bind (&tiz::probe::get_flac_codec_info, probe, _1),
+          need_port_settings_changed_evt);
+    }
+    break;
+    default:
+    {
+      // The other decoders work out the stream settings by themselves
+    }
+    break;
+  };
+  tiz_check_omx (rc);
+
+  // The next track has the same pcm format as the current one, so the new
+  // decoder's output port gets the current decoder's settings
+  OMX_AUDIO_PARAM_PCMMODETYPE pcmtype;
+  TIZ_INIT_OMX_PORT_STRUCT (pcmtype, 1);
+  tiz_check_omx (
+      OMX_GetParameter (handles_[1], OMX_IndexParamAudioPcm, &pcmtype));
+  tiz_check_omx (OMX_SetParameter (chain[1], OMX_IndexParamAudioPcm, &pcmtype));
+
+  return rc;
+}
+
+// Runs in the probe thread
+void graph::ops::probe_next_uri (const std::string &uri)
+{
+  const bool quiet_probing = true;
+  tizprobe_ptr_t probe = boost::make_shared< tiz::probe >(uri, quiet_probing);
+  (void)probe->get_omx_domain ();
+  p_graph_->post_cmd (new tiz::graph::cmd (tiz::graph::next_probed_evt (probe)));
+}
+
+void graph::ops::join_probe_thread ()
+{
+  if (probe_thread_ptr_)
+  {
+    probe_thread_ptr_->join ();
+    probe_thread_ptr_.reset ();
+  }
+}
+
+/**
+ * The next track must share the codec and PCM format of the current one, so
+ * that none of the renderer's settings need to change.
+ */
+bool graph::ops::is_next_track_compatible () const
+{
+  bool rc = false;
+  if (probe_ptr_ && next_probe_ptr_ && playlist_
+      && !is_disabled_evt_required () && !is_port_settings_evt_required ()
+      && next_probe_ptr_->get_uri () == playlist_->peek_uri (SKIP_DEFAULT_VALUE)
+      && next_probe_ptr_->get_omx_domain () == OMX_PortDomainAudio
+      && next_probe_ptr_->get_audio_coding_type ()
+             == probe_ptr_->get_audio_coding_type ())
+  {
+    OMX_AUDIO_PARAM_PCMMODETYPE cur_pcmtype;
+    OMX_AUDIO_PARAM_PCMMODETYPE next_pcmtype;
+    probe_ptr_->get_pcm_codec_info (cur_pcmtype);
+    next_probe_ptr_->get_pcm_codec_info (next_pcmtype);
+    rc = (cur_pcmtype.nChannels == next_pcmtype.nChannels
+          && cur_pcmtype.nSamplingRate == next_pcmtype.nSamplingRate
+          && cur_pcmtype.nBitPerSample == next_pcmtype.nBitPerSample
+          && cur_pcmtype.eNumData == next_pcmtype.eNumData
+          && cur_pcmtype.eEndian == next_pcmtype.eEndian);
+  }
+  TIZ_LOG (TIZ_PRIORITY_TRACE, "is_next_track_compatible [%s]...",
+           rc ? "YES" : "NO");
+  return rc;
+}
+
+OMX_ERRORTYPE
+graph::ops::prepare_next_chain ()
+{
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+  tiz::graph::cbackhandler &cbacks = p_graph_->cback_handler_;
+  omx_comp_handle_lst_t chain (2, OMX_HANDLETYPE (NULL));
+
+  for (int i = 0; i < 2 && OMX_ErrorNone == rc; ++i)
+  {
+    rc = util::instantiate_component (comp_lst_[i], i, &(cbacks),
+                                      cbacks.get_omx_cbacks (), chain, h2n_);
+    if (OMX_ErrorNone == rc)
+    {
+      rc = util::set_role (chain[i], role_lst_[i]);
+    }
+  }
+
+  if (OMX_ErrorNone != rc)
+  {
+    chain.erase (std::remove (chain.begin (), chain.end (),
+                              OMX_HANDLETYPE (NULL)),
+                 chain.end ());
+    destroy_side_chain (chain);
+    return rc;
+  }
+
+  // From here on, the chain's events are routed to do_detached_evt
+  {
+    boost::lock_guard< boost::mutex > lock (side_chains_mutex_);
+    next_chain_ = side_chain_t (chain, OMX_StateLoaded);
+  }
+
+  tiz_check_omx (util::setup_suppliers (chain, 0));
+  tiz_check_omx (util::setup_tunnels (chain, 0));
+  // The decoder's output port stays disabled until the renderer is
+  // tunneled to it
+  tiz_check_omx (util::disable_port (chain[1], 1));
+  tiz_check_omx (configure_next_chain (chain, next_probe_ptr_));
+  next_chain_.second = OMX_StateIdle;
+  tiz_check_omx (
+      util::transition_all (chain, OMX_StateIdle, OMX_StateLoaded));
+
+  return rc;
+}
+
+void graph::ops::retire_next_chain ()
+{
+  if (!next_chain_.first.empty ())
+  {
+    {
+      boost::lock_guard< boost::mutex > lock (side_chains_mutex_);
+      retired_chains_.push_back (next_chain_);
+      next_chain_.first.clear ();
+    }
+    advance_retired_chains ();
+  }
+}
+
+/**
+ * Takes each retired chain one step closer to Loaded, provided that it has
+ * reached the state it was last commanded to, and destroys it once there.
+ */
+void graph::ops::advance_retired_chains ()
+{
+  side_chain_lst_t unloaded_chains;
+  side_chain_lst_t::iterator it = retired_chains_.begin ();
+  while (it != retired_chains_.end ())
+  {
+    if (!util::verify_transition_all (it->first, it->second))
+    {
+      ++it;
+    }
+    else if (OMX_StateLoaded == it->second)
+    {
+      boost::lock_guard< boost::mutex > lock (side_chains_mutex_);
+      unloaded_chains.push_back (*it);
+      it = retired_chains_.erase (it);
+    }
+    else
+    {
+      const OMX_STATETYPE to_state = (OMX_StateIdle == it->second
+                                          ? OMX_StateLoaded
+                                          : OMX_StateIdle);
+      const OMX_ERRORTYPE rc
+          = util::transition_all (it->first, to_state, it->second);
+      if (OMX_ErrorNone != rc)
+      {
+        // Left for do_destroy_graph
+        TIZ_LOG (TIZ_PRIORITY_ERROR,
+                 "[%s] : Unable to transition a retired chain to [%s]",
+                 tiz_err_to_str (rc), tiz_state_to_str (to_state));
+      }
+      it->second = to_state;
+      ++it;
+    }
+  }
+
+  for (it = unloaded_chains.begin (); it != unloaded_chains.end (); ++it)
+  {
+    destroy_side_chain (it->first);
+  }
+}
+
+// Must not be called with side_chains_mutex_ held, as freeing a component may
+// wait for its callbacks
+void graph::ops::destroy_side_chain (omx_comp_handle_lst_t &chain)
+{
+  if (!chain.empty ())
+  {
+    (void)util::tear_down_tunnels (chain);
+    omx_comp_handle_lst_t::const_iterator it = chain.begin ();
+    for (; it != chain.end (); ++it)
+    {
+      h2n_.erase (*it);
+    }
+    util::destroy_list (chain);
+  }
+}
+
+void graph::ops::dump_stream_info ()
+{
+  assert (probe_ptr_);
+  tiz::graph::util::dump_graph_info (graph_id_.c_str (),
+                                     graph_action_.c_str (),
+                                     probe_ptr_->get_uri ());
+  probe_ptr_->dump_stream_metadata ();
+  if (stream_info_dump_f_)
+  {
+    boost::bind (boost::mem_fn (stream_info_dump_f_), probe_ptr_)();
+  }
+
+  metadata_ = boost::assign::map_list_of ("trackid", "1")
+                  .convert_to_container< track_metadata_map_t > ();
+  do_ack_metadata ();
+}
@@ -33,7 +33,11 @@
 #include <boost/shared_ptr.hpp>
 #include <boost/thread.hpp>
 
+#include <sys/time.h>
+
+#include <list>
 #include <string>
+#include <utility>
 
 #include <OMX_Core.h>
 #include <tizplatform.h>
@@ -116,7 +120,18 @@ namespace tiz
       virtual void do_exe2idle_comp (const int comp_id);
       virtual void do_idle2loaded ();
       virtual void do_idle2loaded_comp (const int comp_id);
-      virtual void do_seek ();
+      virtual void do_seek (const int offset_ms);
+      virtual void do_seek_source ();
+      virtual void do_ack_seeked ();
+      virtual void do_probe_next ();
+      virtual void do_preroll_next (const tizprobe_ptr_t &probe);
+      virtual void do_detached_evt (const OMX_HANDLETYPE handle,
+                                    const OMX_EVENTTYPE event,
+                                    const OMX_U32 data1, const OMX_U32 data2);
+      virtual void do_start_next_chain ();
+      virtual void do_promote_next_chain ();
+      virtual void do_start_gapless_switch ();
+      virtual void do_ack_gapless_switch ();
       virtual void do_skip ();
       virtual void do_store_skip (const int jump);
       virtual void do_volume_step (const int step);
@@ -160,6 +175,12 @@ namespace tiz
                                        const OMX_U32 port_id);
       bool is_port_enabling_complete (const OMX_HANDLETYPE handle,
                                       const OMX_U32 port_id);
+      bool is_port_flushing_complete (const OMX_HANDLETYPE handle,
+                                      const OMX_U32 port_id);
+      bool is_seekable () const;
+      bool is_gapless_switch_possible () const;
+      bool is_next_chain_ready (const OMX_HANDLETYPE eos_handle) const;
+      bool is_detached_component (const OMX_HANDLETYPE handle) const;
       bool last_op_succeeded () const;
       bool is_end_of_play () const;
       bool is_probing_result_ok () const;
@@ -208,11 +229,35 @@ namespace tiz
                                                 const bool use_first_as_heading
                                                 = true);
 
+      virtual OMX_ERRORTYPE configure_next_chain (
+          const omx_comp_handle_lst_t &chain, const tizprobe_ptr_t &probe);
+
       cbackhandler &get_cback_handler () const;
 
+    protected:
+      // A source -> decoder chain that is not in handles_, along with the
+      // state it was last commanded to
+      typedef std::pair< omx_comp_handle_lst_t, OMX_STATETYPE > side_chain_t;
+      typedef std::list< side_chain_t > side_chain_lst_t;
+
+    private:
+      void probe_next_uri (const std::string &uri);
+      void join_probe_thread ();
+      bool is_next_track_compatible () const;
+      OMX_ERRORTYPE prepare_next_chain ();
+      void retire_next_chain ();
+      void advance_retired_chains ();
+      void destroy_side_chain (omx_comp_handle_lst_t &chain);
+      void dump_stream_info ();
+
     protected:
       graph *p_graph_;
       tizprobe_ptr_t probe_ptr_;
+      tizprobe_ptr_t next_probe_ptr_;
+      boost::shared_ptr< boost::thread > probe_thread_ptr_;
+      side_chain_t next_chain_;
+      side_chain_lst_t retired_chains_;
+      mutable boost::mutex side_chains_mutex_;
       omx_comp_name_lst_t comp_lst_;
       omx_comp_role_lst_t role_lst_;
       omx_comp_handle_lst_t handles_;
@@ -225,6 +270,11 @@ namespace tiz
       OMX_STATETYPE destination_state_;
       track_metadata_map_t metadata_;
       int volume_;
+      struct timeval seek_start_;
+      struct timeval gapless_start_;
+      std::string graph_id_;
+      std::string graph_action_;
+      stream_info_dump_func_t stream_info_dump_f_;
       OMX_ERRORTYPE error_code_;
       std::string error_msg_;
     };
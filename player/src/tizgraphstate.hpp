@@ -115,6 +115,32 @@ namespace tiz
       }
     };
 
+    struct seeking : public boost::msm::front::state<>
+    {
+      typedef boost::mpl::vector<seek_evt, skip_evt, pause_evt, stop_evt, unload_evt> deferred_events;
+      template < class Event, class FSM >
+      void on_entry (Event const &evt, FSM &fsm) {G_STATE_LOG ();}
+      template < class Event, class FSM >
+      void on_exit (Event const &evt, FSM &fsm) {G_STATE_LOG ();}
+      OMX_STATETYPE target_omx_state () const
+      {
+        return OMX_StateExecuting;
+      }
+    };
+
+    struct seek_flushing : public boost::msm::front::state<>
+    {
+      typedef boost::mpl::vector<seek_evt, skip_evt, pause_evt, stop_evt, unload_evt> deferred_events;
+      template < class Event, class FSM >
+      void on_entry (Event const &evt, FSM &fsm) {G_STATE_LOG ();}
+      template < class Event, class FSM >
+      void on_exit (Event const &evt, FSM &fsm) {G_STATE_LOG ();}
+      OMX_STATETYPE target_omx_state () const
+      {
+        return OMX_StateExecuting;
+      }
+    };
+
     struct exe2pause : public boost::msm::front::state<>
     {
       template < class Event, class FSM >
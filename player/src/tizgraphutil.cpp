@@ -29,6 +29,7 @@
 #include <config.h>
 #endif
 
+#include <stdlib.h>
 #include <string>
 #include <boost/foreach.hpp>
 
@@ -50,6 +51,9 @@ namespace graph = tiz::graph;
 
 namespace  // Unnamed namespace
 {
+  const OMX_U32 TIZ_STREAMING_SERVER_DEFAULT_MAX_CLIENTS = 10;
+  const OMX_U32 TIZ_STREAMING_SERVER_DEFAULT_TRANSCODING_RATE = 44100;
+  const OMX_U32 TIZ_STREAMING_SERVER_DEFAULT_TRANSCODING_BITRATE = 128;  // kbps
 
   struct transition_to
   {
@@ -743,6 +747,25 @@ graph::util::set_flac_type (
   return OMX_ErrorNone;
 }
 
+OMX_ERRORTYPE
+graph::util::set_port_buffer_count (const OMX_HANDLETYPE handle,
+                                    const OMX_U32 port_id, const OMX_U32 count)
+{
+  OMX_PARAM_PORTDEFINITIONTYPE portdef;
+  TIZ_INIT_OMX_PORT_STRUCT (portdef, port_id);
+  tiz_check_omx (
+      OMX_GetParameter (handle, OMX_IndexParamPortDefinition, &portdef));
+  // Never go below what the port requires. When tunneled, the port with the
+  // larger count decides the number of buffers in the tunnel.
+  if (count > portdef.nBufferCountActual)
+  {
+    portdef.nBufferCountActual = count;
+    tiz_check_omx (
+        OMX_SetParameter (handle, OMX_IndexParamPortDefinition, &portdef));
+  }
+  return OMX_ErrorNone;
+}
+
 OMX_ERRORTYPE
 graph::util::enable_port_format_auto_detection (const OMX_HANDLETYPE handle,
                                                 const OMX_U32 port_id,
@@ -846,3 +869,70 @@ bool graph::util::is_mpris_enabled ()
     }
   return is_enabled;
 }
+
+bool graph::util::is_gapless_playback_enabled ()
+{
+  bool is_enabled = false;
+  const char *p_gapless_enabled
+      = tiz_rcfile_get_value ("tizonia", "gapless-playback");
+  if (p_gapless_enabled)
+    {
+      std::string gapless_enabled_str;
+      gapless_enabled_str.assign (p_gapless_enabled);
+      if (gapless_enabled_str.compare ("true") == 0)
+        {
+          is_enabled = true;
+        }
+    }
+  return is_enabled;
+}
+
+OMX_U32 graph::util::get_streaming_server_max_clients ()
+{
+  OMX_U32 max_clients = TIZ_STREAMING_SERVER_DEFAULT_MAX_CLIENTS;
+  const char *p_max_clients
+      = tiz_rcfile_get_value ("tizonia", "streaming-server-max-clients");
+  if (p_max_clients)
+    {
+      const unsigned long value = strtoul (p_max_clients, NULL, 10);
+      if (value > 0)
+        {
+          max_clients = value;
+        }
+    }
+  return max_clients;
+}
+
+OMX_U32 graph::util::get_streaming_server_transcoding_sampling_rate ()
+{
+  OMX_U32 sampling_rate = TIZ_STREAMING_SERVER_DEFAULT_TRANSCODING_RATE;
+  const char *p_rate = tiz_rcfile_get_value (
+      "tizonia", "streaming-server-transcoding-sampling-rate");
+  if (p_rate)
+    {
+      const unsigned long value = strtoul (p_rate, NULL, 10);
+      // These are the rates an MPEG-1 Layer III stream can be encoded at
+      if (value == 32000 || value == 44100 || value == 48000)
+        {
+          sampling_rate = value;
+        }
+    }
+  return sampling_rate;
+}
+
+OMX_U32 graph::util::get_streaming_server_transcoding_bitrate ()
+{
+  OMX_U32 kbps = TIZ_STREAMING_SERVER_DEFAULT_TRANSCODING_BITRATE;
+  const char *p_bitrate = tiz_rcfile_get_value (
+      "tizonia", "streaming-server-transcoding-bitrate");
+  if (p_bitrate)
+    {
+      const unsigned long value = strtoul (p_bitrate, NULL, 10);
+      if (value >= 32 && value <= 320)
+        {
+          kbps = value;
+        }
+    }
+  // OMX_AUDIO_PARAM_MP3TYPE expects bits per second
+  return kbps * 1000;
+}
@@ -177,6 +177,10 @@ namespace tiz
           boost::function< void(OMX_TIZONIA_AUDIO_PARAM_FLACTYPE &flactype) >
               getter, bool &need_port_settings_changed_evt);
 
+      static OMX_ERRORTYPE set_port_buffer_count (const OMX_HANDLETYPE handle,
+                                                  const OMX_U32 port_id,
+                                                  const OMX_U32 count);
+
       static OMX_ERRORTYPE enable_port_format_auto_detection (
           const OMX_HANDLETYPE handle, const OMX_U32 port_id,
           const OMX_PORTDOMAINTYPE domain);
@@ -190,6 +194,14 @@ namespace tiz
       static std::string get_default_pcm_renderer ();
 
       static bool is_mpris_enabled ();
+
+      static bool is_gapless_playback_enabled ();
+
+      static OMX_U32 get_streaming_server_max_clients ();
+
+      static OMX_U32 get_streaming_server_transcoding_sampling_rate ();
+
+      static OMX_U32 get_streaming_server_transcoding_bitrate ();
     };
   }  // namespace graph
 }  // namespace tiz
@@ -43,6 +43,8 @@
 #include <boost/make_shared.hpp>
 #include <boost/algorithm/string/join.hpp>
 #include <boost/version.hpp>
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
 
 #include <taglib/taglib.h>
 #include <MediaInfo/MediaInfo.h>
@@ -51,7 +53,9 @@
 #include <OMX_Core.h>
 
 #include "tizgraphtypes.hpp"
+#include "tizgraphutil.hpp"
 #include "tizgraphmgr.hpp"
+#include "tizprobecache.hpp"
 #include "tizomxutil.hpp"
 #include "decoders/tizdecgraphmgr.hpp"
 #include "httpserv/tizhttpservconfig.hpp"
@@ -137,6 +141,33 @@ namespace
     raise (SIGSTOP);
   }
 
+  void add_decodable_extensions (file_extension_lst_t &extension_list)
+  {
+    // Add here the list of file extensions currently supported for playback
+    extension_list.insert (".mp3");
+    extension_list.insert (".mp2");
+    extension_list.insert (".mpa");
+    extension_list.insert (".m2a");
+    extension_list.insert (".opus");
+    extension_list.insert (".ogg");
+    extension_list.insert (".oga");
+    extension_list.insert (".flac");
+    extension_list.insert (".aac");
+    extension_list.insert (".wav");
+    extension_list.insert (".aiff");
+    extension_list.insert (".aif");
+  }
+
+  void scan_rest_of_play_list (tiz::playlistscanner &scanner,
+                               tiz::graphmgr::mgr_ptr_t mgr_ptr)
+  {
+    uri_lst_t file_list;
+    scanner.rest (file_list);
+    // Warm up the probe cache for the new entries too
+    tiz::probecache::prefetch (file_list);
+    (void)mgr_ptr->complete_playlist (file_list);
+  }
+
   ETIZPlayUserInput wait_for_user_input (tiz::graphmgr::mgr_ptr_t mgr_ptr)
   {
     while (1)
@@ -157,13 +188,11 @@ namespace
             return ETIZPlayUserQuit;
 
           case 68:  // key left
-            // seek
-            // printf ("Seek (left key) - not implemented\n");
+            mgr_ptr->rwd ();
             break;
 
           case 67:  // key right
-            // seek
-            // printf ("Seek (right key) - not implemented\n");
+            mgr_ptr->fwd ();
             break;
 
           case 65:  // key up
@@ -493,29 +522,15 @@ tiz::playapp::decode_local ()
   print_banner ();
 
   file_extension_lst_t extension_list;
-  // Add here the list of file extensions currently supported for playback
-  extension_list.insert (".mp3");
-  extension_list.insert (".mp2");
-  extension_list.insert (".mpa");
-  extension_list.insert (".m2a");
-  extension_list.insert (".opus");
-  extension_list.insert (".ogg");
-  extension_list.insert (".oga");
-  extension_list.insert (".flac");
-  extension_list.insert (".aac");
-  extension_list.insert (".wav");
-  extension_list.insert (".aiff");
-  extension_list.insert (".aif");
+  add_decodable_extensions (extension_list);
 
-  // Create a playlist
-  BOOST_FOREACH (std::string uri, uri_list)
+  // Create a playlist with the first media files found; the rest of the
+  // directories are scanned once playback has started
+  tiz::playlistscanner scanner (uri_list, shuffle, recurse, extension_list);
+  if (!scanner.first (file_list, error_msg))
   {
-    if (!tizplaylist_t::assemble_play_list (
-            uri, shuffle, recurse, extension_list, file_list, error_msg))
-    {
-      fprintf (stderr, "%s (%s).\n", error_msg.c_str (), uri.c_str ());
-      exit (EXIT_FAILURE);
-    }
+    fprintf (stderr, "%s.\n", error_msg.c_str ());
+    exit (EXIT_FAILURE);
   }
 
   (void)daemonize_if_requested ();
@@ -524,23 +539,42 @@ tiz::playapp::decode_local ()
       = boost::make_shared< tiz::playlist >(tiz::playlist (file_list));
 
   assert (playlist);
+  playlist->set_complete (scanner.done ());
   playlist->print_info ();
 
+  // Warm up the probe cache in the background
+  tiz::probecache::prefetch (playlist->get_uri_list ());
+
   // Instantiate the decode manager
   tiz::graphmgr::mgr_ptr_t p_mgr
       = boost::make_shared< tiz::graphmgr::decodemgr >();
 
   // TODO: Check return codes
   p_mgr->init (playlist, graphmgr_termination_cback ());
+
+  // The scanner's threads are started after daemonizing, as they wouldn't
+  // survive the fork
+  boost::thread_group scanning;
+  if (!playlist->complete ())
+  {
+    scanning.create_thread (
+        boost::bind (&scan_rest_of_play_list, boost::ref (scanner), p_mgr));
+  }
+
   p_mgr->start ();
 
   while (ETIZPlayUserQuit != wait_for_user_input (p_mgr))
   {
   }
 
+  scanner.cancel ();
+  scanning.join_all ();
+
   p_mgr->quit ();
   p_mgr->deinit ();
 
+  tiz::probecache::flush ();
+
   return rc;
 }
 
@@ -559,6 +593,7 @@ tiz::playapp::serve_stream ()
   const std::vector< std::string > &bitrate_list = popts_.bitrate_list ();
   const std::string &station_name = popts_.station_name ();
   const std::string &station_genre = popts_.station_genre ();
+  const bool transcode = popts_.transcode ();
 
   print_banner ();
 
@@ -567,7 +602,15 @@ tiz::playapp::serve_stream ()
   std::string ip_address;
   std::string error_msg;
   file_extension_lst_t extension_list;
-  extension_list.insert (".mp3");
+  if (transcode)
+  {
+    // Anything that can be decoded is re-encoded to the stream's format
+    add_decodable_extensions (extension_list);
+  }
+  else
+  {
+    extension_list.insert (".mp3");
+  }
 
   // Create a playlist
   BOOST_FOREACH (std::string uri, uri_list)
@@ -592,14 +635,29 @@ tiz::playapp::serve_stream ()
     fprintf (stdout, "[%s]: Server streaming on http://%s:%ld\n",
              station_name.c_str (), hostname, port);
 
-    fprintf (stdout, "[%s]: Streaming media with sampling rates [%s].\n",
-             station_name.c_str (),
-             sampling_rates.empty () ? "ANY" : sampling_rates.c_str ());
-
-    if (!bitrate_list.empty () || bitrate_list.size () == TIZ_MAX_BITRATE_MODES)
+    if (transcode)
+    {
+      fprintf (stdout, "[%s]: Transcoding media to MP3 [%g KHz, %u kbps].\n",
+               station_name.c_str (),
+               ((float)tiz::graph::util::
+                    get_streaming_server_transcoding_sampling_rate ())
+                   / 1000,
+               (unsigned int)tiz::graph::util::
+                       get_streaming_server_transcoding_bitrate ()
+                   / 1000);
+    }
+    else
     {
-      fprintf (stdout, "[%s]: Streaming media with bitrate modes [%s].\n",
-               station_name.c_str (), bitrates.c_str ());
+      fprintf (stdout, "[%s]: Streaming media with sampling rates [%s].\n",
+               station_name.c_str (),
+               sampling_rates.empty () ? "ANY" : sampling_rates.c_str ());
+
+      if (!bitrate_list.empty ()
+          || bitrate_list.size () == TIZ_MAX_BITRATE_MODES)
+      {
+        fprintf (stdout, "[%s]: Streaming media with bitrate modes [%s].\n",
+                 station_name.c_str (), bitrates.c_str ());
+      }
     }
     fprintf (stdout, "\n");
   }
@@ -618,7 +676,11 @@ tiz::playapp::serve_stream ()
   tizgraphconfig_ptr_t config
       = boost::make_shared< tiz::graph::httpservconfig >(
           playlist, hostname, ip_address, port, sampling_rate_list,
-          bitrate_list, station_name, station_genre, icy_metadata);
+          bitrate_list, station_name, station_genre, icy_metadata, transcode);
+
+  // Warm up the probe cache in the background; the server skips files
+  // based on their format, sampling rate and bitrate
+  tiz::probecache::prefetch (playlist->get_uri_list ());
 
   // Instantiate the http streaming manager
   tiz::graphmgr::mgr_ptr_t p_mgr
@@ -635,6 +697,8 @@ tiz::playapp::serve_stream ()
   p_mgr->quit ();
   p_mgr->deinit ();
 
+  tiz::probecache::flush ();
+
   return rc;
 }
 
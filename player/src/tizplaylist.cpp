@@ -30,11 +30,19 @@
 #include <config.h>
 #endif
 
+#include <dirent.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/stat.h>
+
 #include <algorithm>
+#include <deque>
 
 #include <boost/system/error_code.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/algorithm/string.hpp>
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
 
 #include <tizplatform.h>
 
@@ -47,56 +55,275 @@
 
 namespace  // unnamed namespace
 {
-  struct pathname_of
+  void add_to_extension_list (file_extension_lst_t &list, const std::string &extension)
+  {
+    list.insert (list.end (), extension);
+  }
+
+  bool is_known_media (const file_extension_lst_t &extension_list,
+                       const std::string &pathname, std::string &extension)
+  {
+    const std::string::size_type slash = pathname.rfind ('/');
+    const std::string::size_type dot = pathname.rfind ('.');
+    if (dot == std::string::npos
+        || (slash != std::string::npos && dot < slash))
+    {
+      return false;
+    }
+    extension.assign (pathname, dot, std::string::npos);
+    boost::algorithm::to_lower (extension);
+    return extension_list.find (extension) != extension_list.end ();
+  }
+
+}  // unnamed namespace
+
+/**
+ * Scans directory trees using a pool of worker threads, each of which picks
+ * the next pending directory and lists it with readdir. The entry type
+ * reported by readdir is used where available, so that files are only stat'ed
+ * when the file system doesn't provide it (or for symlinks); on network mounts
+ * this avoids one round-trip per file. Files with unknown extensions are
+ * dropped during the walk.
+ *
+ * A walk can stop once a number of media files have been found; the
+ * directories not yet listed stay pending for the next walk.
+ */
+class tiz::dir_walker
+{
+public:
+  dir_walker (const file_extension_lst_t &extension_list, const bool recurse)
+    : extension_list_ (extension_list),
+      recurse_ (recurse),
+      busy_ (0),
+      target_ (0),
+      stop_ (false),
+      cancelled_ (false),
+      nentries_ (0)
+  {
+  }
+
+  void add_dir (const std::string &dir)
+  {
+    boost::lock_guard< boost::mutex > lock (mutex_);
+    pending_.push_back (dir);
+  }
+
+  /**
+   * Walks the pending directories until at least @a target media files have
+   * been found (zero walks them all), and appends the files to @a uri_list.
+   *
+   * @return The number of media files appended.
+   */
+  size_t walk (uri_lst_t &uri_list, file_extension_lst_t &extension_list_found,
+               const size_t target = 0)
   {
-    pathname_of (uri_lst_t &uri_list) : uri_list_ (uri_list)
+    const unsigned int nthreads = recurse_ ? max_threads () : 1;
+    boost::thread_group workers;
+
     {
+      boost::lock_guard< boost::mutex > lock (mutex_);
+      target_ = target;
+      stop_ = cancelled_;
     }
 
-    void operator()(const boost::filesystem::directory_entry &p) const
+    for (unsigned int i = 0; i < nthreads; ++i)
     {
-      uri_list_.push_back (p.path ().string ());
+      workers.create_thread (boost::bind (&dir_walker::worker, this));
     }
-    uri_lst_t &uri_list_;
-  };
+    workers.join_all ();
 
-  void add_to_extension_list (file_extension_lst_t &list, const std::string &extension)
+    const size_t nfound = found_.size ();
+    uri_list.insert (uri_list.end (), found_.begin (), found_.end ());
+    extension_list_found.insert (extensions_.begin (), extensions_.end ());
+    found_.clear ();
+    TIZ_LOG (TIZ_PRIORITY_TRACE,
+             "%zu entries, %zu media files, %zu directories pending, "
+             "%u threads",
+             nentries_, nfound, pending_.size (), nthreads);
+    return nfound;
+  }
+
+  bool done () const
   {
-    list.insert (list.end (), extension);
+    boost::lock_guard< boost::mutex > lock (mutex_);
+    return cancelled_ || pending_.empty ();
   }
 
-  OMX_ERRORTYPE
-  process_base_uri (const std::string &uri, uri_lst_t &uri_list,
-                    bool recurse = false)
+  void cancel ()
+  {
+    boost::lock_guard< boost::mutex > lock (mutex_);
+    cancelled_ = true;
+    stop_ = true;
+    cond_.notify_all ();
+  }
+
+private:
+  static unsigned int max_threads ()
+  {
+    // Directory scanning is bound by I/O latency rather than cpu, so use
+    // a few more threads than cores.
+    const unsigned int ncores = boost::thread::hardware_concurrency ();
+    return std::min (16u, std::max (4u, 2 * ncores));
+  }
+
+  void worker ()
   {
-    if (boost::filesystem::exists (uri)
-        && boost::filesystem::is_regular_file (uri))
+    uri_lst_t found;
+    file_extension_lst_t extensions;
+    std::string dir;
+
+    while (next_dir (dir))
     {
-      uri_list.push_back (uri);
-      return OMX_ErrorNone;
+      const size_t nentries = scan_dir (dir, found, extensions);
+      boost::lock_guard< boost::mutex > lock (mutex_);
+      // Publish each directory's media as soon as it has been listed, so
+      // that a walk with a target can stop early
+      found_.insert (found_.end (), found.begin (), found.end ());
+      extensions_.insert (extensions.begin (), extensions.end ());
+      found.clear ();
+      extensions.clear ();
+      nentries_ += nentries;
+      if (target_ > 0 && found_.size () >= target_)
+      {
+        stop_ = true;
+      }
+      --busy_;
+      if (stop_ || (0 == busy_ && pending_.empty ()))
+      {
+        cond_.notify_all ();
+      }
+    }
+  }
+
+  bool next_dir (std::string &dir)
+  {
+    boost::unique_lock< boost::mutex > lock (mutex_);
+    while (!stop_ && pending_.empty () && busy_ > 0)
+    {
+      cond_.wait (lock);
+    }
+    if (stop_ || pending_.empty ())
+    {
+      return false;
+    }
+    dir.swap (pending_.front ());
+    pending_.pop_front ();
+    ++busy_;
+    return true;
+  }
+
+  size_t scan_dir (const std::string &dir, uri_lst_t &found,
+                   file_extension_lst_t &extensions)
+  {
+    DIR *p_dir = opendir (dir.c_str ());
+    if (!p_dir)
+    {
+      TIZ_LOG (TIZ_PRIORITY_ERROR, "[%s] : %s", dir.c_str (),
+               strerror (errno));
+      return 0;
     }
 
-    if (boost::filesystem::exists (uri)
-        && boost::filesystem::is_directory (uri))
+    size_t nentries = 0;
+    std::string extension;
+    std::string pathname;
+    struct dirent *p_entry = NULL;
+    while ((p_entry = readdir (p_dir)) != NULL)
     {
-      if (!recurse)
+      const char *p_name = p_entry->d_name;
+      if ('.' == p_name[0]
+          && ('\0' == p_name[1] || ('.' == p_name[1] && '\0' == p_name[2])))
       {
-        std::for_each (boost::filesystem::directory_iterator (
-                           boost::filesystem::path (uri)),
-                       boost::filesystem::directory_iterator (),
-                       pathname_of (uri_list));
-        return uri_list.empty () ? OMX_ErrorContentURIError : OMX_ErrorNone;
+        continue;
       }
-      else
+
+      ++nentries;
+      pathname.assign (dir);
+      if (pathname[pathname.size () - 1] != '/')
+      {
+        pathname.push_back ('/');
+      }
+      pathname.append (p_name);
+
+      unsigned char type = p_entry->d_type;
+      if (DT_UNKNOWN == type || DT_LNK == type)
+      {
+        struct stat st;
+        if (0 != stat (pathname.c_str (), &st))
+        {
+          continue;
+        }
+        // Don't descend into symlinked directories, the same as
+        // boost::filesystem::recursive_directory_iterator
+        type = S_ISREG (st.st_mode) ? DT_REG
+             : (S_ISDIR (st.st_mode) && DT_UNKNOWN == type) ? DT_DIR
+             : DT_UNKNOWN;
+      }
+
+      if (DT_REG == type)
+      {
+        if (is_known_media (extension_list_, pathname, extension))
+        {
+          found.push_back (pathname);
+          extensions.insert (extension);
+        }
+      }
+      else if (DT_DIR == type && recurse_)
       {
-        std::for_each (boost::filesystem::recursive_directory_iterator (
-                           boost::filesystem::path (uri)),
-                       boost::filesystem::recursive_directory_iterator (),
-                       pathname_of (uri_list));
-        return uri_list.empty () ? OMX_ErrorContentURIError : OMX_ErrorNone;
+        boost::lock_guard< boost::mutex > lock (mutex_);
+        pending_.push_back (pathname);
+        cond_.notify_one ();
       }
     }
 
+    (void)closedir (p_dir);
+    return nentries;
+  }
+
+private:
+  const file_extension_lst_t &extension_list_;
+  const bool recurse_;
+  mutable boost::mutex mutex_;
+  boost::condition_variable cond_;
+  std::deque< std::string > pending_;
+  int busy_;
+  size_t target_;
+  bool stop_;
+  bool cancelled_;
+  uri_lst_t found_;
+  file_extension_lst_t extensions_;
+  size_t nentries_;
+};
+
+namespace  // unnamed namespace
+{
+  OMX_ERRORTYPE
+  process_base_uri (const std::string &uri,
+                    const file_extension_lst_t &extension_list,
+                    uri_lst_t &uri_list,
+                    file_extension_lst_t &extension_list_filtered,
+                    bool recurse = false)
+  {
+    struct stat st;
+    if (0 != stat (uri.c_str (), &st))
+    {
+      return OMX_ErrorContentURIError;
+    }
+
+    if (S_ISREG (st.st_mode))
+    {
+      uri_list.push_back (uri);
+      return OMX_ErrorNone;
+    }
+
+    if (S_ISDIR (st.st_mode))
+    {
+      tiz::dir_walker walker (extension_list, recurse);
+      walker.add_dir (uri);
+      return walker.walk (uri_list, extension_list_filtered) > 0
+                 ? OMX_ErrorNone
+                 : OMX_ErrorContentURIError;
+    }
+
     return OMX_ErrorContentURIError;
   }
 
@@ -106,32 +333,25 @@ namespace  // unnamed namespace
                         file_extension_lst_t &extension_list_filtered)
   {
     uri_lst_t::iterator it (uri_list.begin ());
-    std::vector< uri_lst_t::iterator > iter_list;
-    file_extension_lst_t ext_lst_cpy (extension_list);
     uri_lst_t filtered_uri_list;
+    std::string extension;
 
+    filtered_uri_list.reserve (uri_list.size ());
     while (it != uri_list.end ())
     {
-      std::string extension (
-          boost::filesystem::path (*it).extension ().string ());
-      boost::algorithm::to_lower (extension);
-      file_extension_lst_t::const_iterator low = std::lower_bound (
-          ext_lst_cpy.begin (), ext_lst_cpy.end (), extension);
-
-      TIZ_LOG (TIZ_PRIORITY_TRACE, "ext [%s] it [%s]", extension.c_str (),
-               (*it).c_str ());
-
-      if (!(low == ext_lst_cpy.end ()) && boost::iequals ((*low), extension))
+      TIZ_LOG (TIZ_PRIORITY_TRACE, "it [%s]", (*it).c_str ());
+      if (is_known_media (extension_list, *it, extension))
       {
-        TIZ_LOG (TIZ_PRIORITY_TRACE, "[%s] added to playlist low [%s]",
-                 (*it).c_str (), (*low).c_str ());
-        filtered_uri_list.push_back (*it);
+        TIZ_LOG (TIZ_PRIORITY_TRACE, "[%s] added to playlist ext [%s]",
+                 (*it).c_str (), extension.c_str ());
+        filtered_uri_list.push_back (std::string ());
+        filtered_uri_list.back ().swap (*it);
         extension_list_filtered.insert (extension);
       }
       ++it;
     }
 
-    uri_list = filtered_uri_list;
+    uri_list.swap (filtered_uri_list);
     TIZ_LOG (TIZ_PRIORITY_TRACE, "%d elements in playlist", uri_list.size ());
     return uri_list.empty () ? OMX_ErrorContentURIError : OMX_ErrorNone;
   }
@@ -150,7 +370,9 @@ tiz::playlist::playlist (const uri_lst_t &uri_list /* = uri_lst_t () */,
     current_sub_list_ (-1),
     shuffle_ (shuffle),
     extension_list_ (),
-    single_format_ (Unknown)
+    single_format_ (Unknown),
+    complete_ (true),
+    resume_index_ (-1)
 {
   const int list_size = uri_list_.size ();
   if (list_size)
@@ -170,7 +392,9 @@ tiz::playlist::playlist (const playlist &copy_from)
     current_sub_list_ (copy_from.current_sub_list_),
     shuffle_ (copy_from.shuffle_),
     extension_list_ (copy_from.extension_list_),
-    single_format_ (copy_from.single_format_)
+    single_format_ (copy_from.single_format_),
+    complete_ (copy_from.complete_),
+    resume_index_ (copy_from.resume_index_)
 {
   const int list_size = uri_list_.size ();
   TIZ_LOG (TIZ_PRIORITY_TRACE, "uri list size [%d]", list_size);
@@ -207,7 +431,9 @@ bool tiz::playlist::assemble_play_list (
       goto end;
     }
 
-    if (OMX_ErrorNone != process_base_uri (canonical_base_uri, uri_list, recurse))
+    if (OMX_ErrorNone != process_base_uri (canonical_base_uri, extension_list,
+                                           uri_list, extension_list_filtered,
+                                           recurse))
     {
       error_msg.assign ("File not found.");
       goto end;
@@ -286,17 +512,66 @@ const std::string &tiz::playlist::get_current_uri () const
   return uri_list_[current_index_];
 }
 
+/**
+ * Returns the uri that a call to skip (jump) would make current, without
+ * modifying the playlist's position.
+ *
+ * @return The uri, or an empty string when the jump would leave the playlist.
+ */
+std::string tiz::playlist::peek_uri (const int jump) const
+{
+  const int list_size = uri_list_.size ();
+  int index = current_index_ + jump;
+
+  if (loop_playback () && list_size > 0)
+  {
+    if (index < 0)
+    {
+      index = list_size - abs (index);
+    }
+    else if (index >= list_size)
+    {
+      index %= list_size;
+    }
+  }
+
+  if (index < 0 || index >= list_size)
+  {
+    return std::string ();
+  }
+  return uri_list_[index];
+}
+
 tiz::playlist tiz::playlist::obtain_next_sub_playlist (
     const list_direction_t up_or_down)
 {
+  // Moving on from the last entries of an incomplete playlist; carry on with
+  // the first entry appended since
+  const int resume_index = (DirUp == up_or_down) ? resume_index_ : -1;
+  resume_index_ = -1;
+
   if (uri_list_.empty () || single_format ())
   {
-    return playlist (get_uri_list ());
+    playlist new_list (get_uri_list ());
+    if (resume_index > 0)
+    {
+      new_list.set_index (resume_index);
+    }
+    return new_list;
   }
   else
   {
     assert (up_or_down < DirMax);
-    if (up_or_down == DirUp)
+    if (resume_index > 0)
+    {
+      current_sub_list_ = 0;
+      while (sub_list_indexes_[current_sub_list_ + 1]
+             <= static_cast< size_t >(resume_index))
+      {
+        current_sub_list_++;
+      }
+    }
+    else if (up_or_down == DirUp)
     {
       const int sub_lists = sub_list_indexes_.size () - 1;
       current_sub_list_++;
@@ -326,6 +601,10 @@ tiz::playlist tiz::playlist::obtain_next_sub_playlist (
     playlist new_list (uri_lst_t (first, last));
     assert (new_list.single_format ());
     current_index_ = index1;
+    if (resume_index > 0)
+    {
+      new_list.set_index (resume_index - index1);
+    }
 
     return new_list;
   }
@@ -477,6 +756,37 @@ void tiz::playlist::erase_uri (const int index)
   }
 }
 
+/**
+ * Appends entries to the playlist. The next sub-playlist obtained going up
+ * starts at the first of them.
+ */
+void tiz::playlist::append (const uri_lst_t &uri_list)
+{
+  if (!uri_list.empty ())
+  {
+    resume_index_ = uri_list_.size ();
+    uri_list_.insert (uri_list_.end (), uri_list.begin (), uri_list.end ());
+    sub_list_indexes_.clear ();
+    extension_list_.clear ();
+    single_format_ = Unknown;
+    scan_list ();
+  }
+}
+
+/**
+ * Whether all the entries are in the playlist, or a scan is still looking for
+ * more (see append).
+ */
+bool tiz::playlist::complete () const
+{
+  return complete_;
+}
+
+void tiz::playlist::set_complete (const bool complete)
+{
+  complete_ = complete;
+}
+
 void tiz::playlist::scan_list ()
 {
   if (!uri_list_.empty ())
@@ -541,3 +851,150 @@ void tiz::playlist::print_info ()
                   (long)uri_list_.size (),
                   boost::algorithm::join (extension_list_, ", ").c_str ());
 }
+
+//
+// playlistscanner
+//
+tiz::playlistscanner::playlistscanner (
+    const uri_lst_t &base_uris, const bool shuffle, const bool recurse,
+    const file_extension_lst_t &extension_list)
+  : base_uris_ (base_uris),
+    shuffle_ (shuffle),
+    extension_list_ (extension_list),
+    p_walker_ (new dir_walker (extension_list_, recurse))
+{
+}
+
+tiz::playlistscanner::~playlistscanner ()
+{
+}
+
+bool tiz::playlistscanner::first (uri_lst_t &file_list, std::string &error_msg)
+{
+  bool list_assembled = false;
+  uri_lst_t uri_list;
+  file_extension_lst_t extension_list_found;
+  std::string extension;
+
+  try
+  {
+    for (uri_lst_t::const_iterator it = base_uris_.begin ();
+         it != base_uris_.end (); ++it)
+    {
+      if (it->empty ())
+      {
+        error_msg.assign ("Empty media uri");
+        goto end;
+      }
+
+      boost::system::error_code errcode;
+      const std::string canonical_uri
+          = boost::filesystem::canonical (*it, errcode).string ();
+      std::string uri_error;
+      struct stat st;
+      if (errcode.value () != 0)
+      {
+        uri_error.assign (errcode.message ());
+      }
+      else if (0 != stat (canonical_uri.c_str (), &st))
+      {
+        uri_error.assign ("File not found");
+      }
+      else if (S_ISDIR (st.st_mode))
+      {
+        p_walker_->add_dir (canonical_uri);
+      }
+      else if (S_ISREG (st.st_mode))
+      {
+        if (is_known_media (extension_list_, canonical_uri, extension))
+        {
+          uri_list.push_back (canonical_uri);
+        }
+      }
+      else
+      {
+        uri_error.assign ("File not found");
+      }
+
+      if (!uri_error.empty ())
+      {
+        error_msg.assign (uri_error).append (" (").append (*it).append (")");
+        goto end;
+      }
+    }
+
+    // Unless some files were named explicitly, wait for the walk to find the
+    // first few; it stops once the directories in progress are listed.
+    if (uri_list.empty ())
+    {
+      (void)p_walker_->walk (uri_list, extension_list_found, 1);
+    }
+
+    if (uri_list.empty ())
+    {
+      error_msg.assign ("No supported media types found");
+      goto end;
+    }
+
+    arrange (uri_list);
+    file_list.insert (file_list.end (), uri_list.begin (), uri_list.end ());
+    list_assembled = true;
+  }
+  catch (std::exception const &e)
+  {
+    error_msg.assign (e.what ());
+  }
+  catch (...)
+  {
+    error_msg.assign ("Undefined file system error");
+  }
+
+end:
+
+  if (!list_assembled)
+  {
+    TIZ_LOG (TIZ_PRIORITY_ERROR, "[%s]", error_msg.c_str ());
+  }
+
+  return list_assembled;
+}
+
+void tiz::playlistscanner::rest (uri_lst_t &file_list)
+{
+  uri_lst_t uri_list;
+  file_extension_lst_t extension_list_found;
+
+  try
+  {
+    (void)p_walker_->walk (uri_list, extension_list_found);
+  }
+  catch (std::exception const &e)
+  {
+    TIZ_LOG (TIZ_PRIORITY_ERROR, "[%s]", e.what ());
+  }
+
+  arrange (uri_list);
+  file_list.insert (file_list.end (), uri_list.begin (), uri_list.end ());
+}
+
+bool tiz::playlistscanner::done () const
+{
+  return p_walker_->done ();
+}
+
+void tiz::playlistscanner::cancel ()
+{
+  p_walker_->cancel ();
+}
+
+void tiz::playlistscanner::arrange (uri_lst_t &file_list) const
+{
+  if (shuffle_)
+  {
+    std::random_shuffle (file_list.begin (), file_list.end ());
+  }
+  else
+  {
+    std::sort (file_list.begin (), file_list.end ());
+  }
+}
@@ -29,10 +29,14 @@
 #ifndef TIZPLAYLIST_HPP
 #define TIZPLAYLIST_HPP
 
+#include <boost/scoped_ptr.hpp>
+
 #include "tizgraphtypes.hpp"
 
 namespace tiz
 {
+  class dir_walker;
+
   class playlist
   {
 
@@ -57,6 +61,7 @@ namespace tiz
     void skip (const int jump);
     playlist obtain_next_sub_playlist (const list_direction_t up_or_down);
     const std::string & get_current_uri () const;
+    std::string peek_uri (const int jump) const;
     uri_lst_t get_sublist (const int from, const int to) const;
     const uri_lst_t &get_uri_list () const;
     int current_index () const;
@@ -70,6 +75,9 @@ namespace tiz
     bool shuffle () const;
     void set_index (const int index);
     void erase_uri (const int index);
+    void append (const uri_lst_t &uri_list);
+    bool complete () const;
+    void set_complete (const bool complete);
     void print_info ();
 
   private:
@@ -97,6 +105,53 @@ namespace tiz
     bool shuffle_;
     mutable file_extension_lst_t extension_list_;
     mutable single_format_t single_format_;
+    bool complete_;
+    int resume_index_;
+  };
+
+  /**
+   * Assembles a playlist from a set of files and directories in two steps, so
+   * that playback can start before a large media tree has been fully scanned.
+   */
+  class playlistscanner
+  {
+
+  public:
+    playlistscanner (const uri_lst_t &base_uris, const bool shuffle,
+                     const bool recurse,
+                     const file_extension_lst_t &extension_list);
+    ~playlistscanner ();
+
+    /**
+     * Returns as soon as the first media files have been found, leaving the
+     * rest of the directories for rest ().
+     */
+    bool first (uri_lst_t &file_list, std::string &error_msg);
+
+    /**
+     * Scans the directories that first () left pending.
+     */
+    void rest (uri_lst_t &file_list);
+
+    /**
+     * Whether there are directories left to scan.
+     */
+    bool done () const;
+
+    /**
+     * Makes a running rest () return early. This may be called from any
+     * thread.
+     */
+    void cancel ();
+
+  private:
+    void arrange (uri_lst_t &file_list) const;
+
+  private:
+    const uri_lst_t base_uris_;
+    const bool shuffle_;
+    const file_extension_lst_t extension_list_;
+    boost::scoped_ptr< dir_walker > p_walker_;
   };
 }  // namespace tiz
 
@@ -41,8 +41,12 @@
 #include <MediaInfo/MediaInfo.h>
 #include <MediaInfo/MediaInfo_Const.h>
 
+#include <fileref.h>
+#include <tag.h>
+
 #include <tizplatform.h>
 
+#include "tizprobecache.hpp"
 #include "tizprobe.hpp"
 
 #ifdef TIZ_LOG_CATEGORY_NAME
@@ -102,7 +106,6 @@ namespace  // unnamed
   }
 
   void obtain_stream_title_and_genre (MediaInfoLib::MediaInfo &mi,
-                                      const bool quiet,
                                       std::string &stream_title,
                                       std::string &stream_genre)
   {
@@ -111,8 +114,6 @@ namespace  // unnamed
     std::string title (mi_stream_general_info_to_std_string (mi, L"Track"));
     std::string album (mi_stream_general_info_to_std_string (mi, L"Album"));
     std::string genre (mi_stream_general_info_to_std_string (mi, L"Genre"));
-    std::string full_track_name (
-        mi_stream_general_info_to_std_string (mi, L"CompleteName"));
 
     stream_title.assign (artist);
     if (!album.empty ())
@@ -127,15 +128,6 @@ namespace  // unnamed
       stream_title.append (title);
     }
     stream_genre.assign (genre);
-
-    if (!quiet)
-    {
-      if (stream_title.empty ())
-      {
-        stream_title.assign (full_track_name);
-      }
-      boost::replace_all (stream_title, "_", " ");
-    }
   }
 
   OMX_AUDIO_CODINGTYPE obtain_codec_id (MediaInfoLib::MediaInfo &mi)
@@ -235,6 +227,82 @@ namespace  // unnamed
     }
     return container_format;
   }
+
+  void obtain_tags (const std::string &uri, tiz::probeinfo &info)
+  {
+    TagLib::FileRef meta_file (uri.c_str ());
+    if (!meta_file.isNull () && meta_file.tag ())
+    {
+      TagLib::Tag *tag = meta_file.tag ();
+      info.title_ = tag->title ().stripWhiteSpace ().to8Bit ();
+      info.artist_ = tag->artist ().stripWhiteSpace ().to8Bit ();
+      info.album_ = tag->album ().stripWhiteSpace ().to8Bit ();
+      info.comment_ = tag->comment ().stripWhiteSpace ().to8Bit ();
+      info.genre_ = tag->genre ().stripWhiteSpace ().to8Bit ();
+      info.year_ = tag->year ();
+      info.track_ = tag->track ();
+    }
+    if (!meta_file.isNull () && meta_file.audioProperties ())
+    {
+      info.length_ = meta_file.audioProperties ()->length ();
+    }
+  }
+
+  bool probe_media (const std::string &uri, tiz::probeinfo &info)
+  {
+    MediaInfoLib::MediaInfo mi;
+    bool rc = false;
+
+    if (open_media (uri, mi))
+    {
+      // Get an idea of the container format
+      info.container_type_ = obtain_container_format (mi);
+
+      // Get the codec type
+      info.codec_id_ = obtain_codec_id (mi);
+
+      // Get the stream title and genre
+      obtain_stream_title_and_genre (mi, info.stream_title_,
+                                     info.stream_genre_);
+
+      // Grab the sample rate, bitrate, num channels, and sample format (when
+      // available), and cbr flag
+      obtain_stream_properties (mi, info.samplerate_, info.bitrate_,
+                                info.nchannels_, info.bitdepth_,
+                                info.endianness_, info.sign_,
+                                info.stream_is_cbr_);
+      mi.Close ();
+
+      // And the tags and duration
+      obtain_tags (uri, info);
+      rc = true;
+    }
+
+    return rc;
+  }
+}
+
+tiz::probeinfo::probeinfo ()
+  : container_type_ (OMX_FORMATMax),
+    codec_id_ (OMX_AUDIO_CodingUnused),
+    samplerate_ (48000),
+    bitrate_ (0),
+    nchannels_ (2),
+    bitdepth_ (16),
+    endianness_ (OMX_EndianLittle),
+    sign_ (OMX_NumericalDataSigned),
+    stream_is_cbr_ (false),
+    length_ (-1),
+    year_ (0),
+    track_ (0),
+    stream_title_ (),
+    stream_genre_ (),
+    title_ (),
+    artist_ (),
+    album_ (),
+    comment_ (),
+    genre_ ()
+{
 }
 
 tiz::probe::probe (const std::string &uri, const bool quiet)
@@ -252,7 +320,7 @@ tiz::probe::probe (const std::string &uri, const bool quiet)
     vorbistype_ (),
     aactype_ (),
     vp8type_ (),
-    meta_file_ (uri.c_str ()),
+    info_ (),
     stream_title_ (),
     stream_genre_ (),
     stream_is_cbr_ (false)
@@ -407,76 +475,83 @@ tiz::probe::get_container_type ()
 
 void tiz::probe::probe_stream ()
 {
-  MediaInfoLib::MediaInfo mi;
+  probeinfo info;
 
-  if (open_media (uri_, mi))
+  // Avoid MediaInfo and TagLib altogether if the file has been seen before
+  if (!tiz::probecache::lookup (uri_, info))
   {
-    OMX_U32 samplerate = 48000;
-    OMX_U32 bitrate = 0;
-    OMX_U32 nchannels = 2;
-    OMX_U32 bitdepth = 16;
-    OMX_ENDIANTYPE endianness = OMX_EndianLittle;
-    OMX_NUMERICALDATATYPE sign = OMX_NumericalDataSigned;
-
-    // Get an idea of the container format
-    container_type_ = obtain_container_format (mi);
-
-    // Get the codec type
-    const OMX_AUDIO_CODINGTYPE codec_id = obtain_codec_id (mi);
-
-    // Get the stream title and genre
-    obtain_stream_title_and_genre (mi, quiet_, stream_title_, stream_genre_);
-
-    TIZ_PRINTF_DBG_RED ("uri [%s] codec_id [%0x]\n", uri_.c_str (), codec_id);
-
-    // Grab the sample rate, bitrate, num channels, and sample format (when
-    // available), and cbr flag
-    obtain_stream_properties (mi, samplerate, bitrate, nchannels, bitdepth,
-                              endianness, sign, stream_is_cbr_);
-
-    if (codec_id == (OMX_AUDIO_CODINGTYPE)OMX_AUDIO_CodingMP2)
+    if (!probe_media (uri_, info))
     {
-      set_mp2_codec_info (samplerate, bitrate, nchannels, bitdepth, endianness,
-                          sign);
+      return;
     }
-    else if (codec_id == OMX_AUDIO_CodingMP3)
-    {
-      set_mp3_codec_info (samplerate, bitrate, nchannels, bitdepth, endianness,
-                          sign);
-    }
-    else if (codec_id == OMX_AUDIO_CodingAAC)
-    {
-      set_aac_codec_info (samplerate, bitrate, nchannels, bitdepth, endianness,
-                          sign);
-    }
-    else if (codec_id == (OMX_AUDIO_CODINGTYPE)OMX_AUDIO_CodingFLAC)
-    {
-      set_flac_codec_info (samplerate, bitrate, nchannels, bitdepth, endianness,
-                           sign);
-    }
-    else if (codec_id == OMX_AUDIO_CodingVORBIS)
-    {
-      set_vorbis_codec_info (samplerate, bitrate, nchannels, bitdepth,
-                             endianness, sign);
-    }
-    else if (codec_id == (OMX_AUDIO_CODINGTYPE)OMX_AUDIO_CodingOPUS)
-    {
-      set_opus_codec_info (samplerate, bitrate, nchannels, bitdepth, endianness,
-                           sign);
-    }
-    else if (is_pcm_codec (codec_id))
+    tiz::probecache::store (uri_, info);
+  }
+
+  info_ = info;
+  container_type_ = info.container_type_;
+  stream_is_cbr_ = info.stream_is_cbr_;
+  stream_genre_ = info.stream_genre_;
+  stream_title_ = info.stream_title_;
+  if (!quiet_)
+  {
+    // MediaInfo's CompleteName is the uri itself
+    if (stream_title_.empty ())
     {
-      domain_ = OMX_PortDomainAudio;
-      audio_coding_type_
-          = static_cast< OMX_AUDIO_CODINGTYPE >(OMX_AUDIO_CodingPCM);
-      pcmtype_.nSamplingRate = samplerate;
-      pcmtype_.nChannels = nchannels;
-      pcmtype_.nBitPerSample = bitdepth;
-      pcmtype_.eEndian = endianness;
-      pcmtype_.eNumData = sign;
+      stream_title_.assign (uri_);
     }
+    boost::replace_all (stream_title_, "_", " ");
+  }
+
+  const OMX_AUDIO_CODINGTYPE codec_id = info.codec_id_;
+  const OMX_U32 samplerate = info.samplerate_;
+  const OMX_U32 bitrate = info.bitrate_;
+  const OMX_U32 nchannels = info.nchannels_;
+  const OMX_U32 bitdepth = info.bitdepth_;
+  const OMX_ENDIANTYPE endianness = info.endianness_;
+  const OMX_NUMERICALDATATYPE sign = info.sign_;
+
+  TIZ_PRINTF_DBG_RED ("uri [%s] codec_id [%0x]\n", uri_.c_str (), codec_id);
 
-    mi.Close ();
+  if (codec_id == (OMX_AUDIO_CODINGTYPE)OMX_AUDIO_CodingMP2)
+  {
+    set_mp2_codec_info (samplerate, bitrate, nchannels, bitdepth, endianness,
+                        sign);
+  }
+  else if (codec_id == OMX_AUDIO_CodingMP3)
+  {
+    set_mp3_codec_info (samplerate, bitrate, nchannels, bitdepth, endianness,
+                        sign);
+  }
+  else if (codec_id == OMX_AUDIO_CodingAAC)
+  {
+    set_aac_codec_info (samplerate, bitrate, nchannels, bitdepth, endianness,
+                        sign);
+  }
+  else if (codec_id == (OMX_AUDIO_CODINGTYPE)OMX_AUDIO_CodingFLAC)
+  {
+    set_flac_codec_info (samplerate, bitrate, nchannels, bitdepth, endianness,
+                         sign);
+  }
+  else if (codec_id == OMX_AUDIO_CodingVORBIS)
+  {
+    set_vorbis_codec_info (samplerate, bitrate, nchannels, bitdepth,
+                           endianness, sign);
+  }
+  else if (codec_id == (OMX_AUDIO_CODINGTYPE)OMX_AUDIO_CodingOPUS)
+  {
+    set_opus_codec_info (samplerate, bitrate, nchannels, bitdepth, endianness,
+                         sign);
+  }
+  else if (is_pcm_codec (codec_id))
+  {
+    domain_ = OMX_PortDomainAudio;
+    audio_coding_type_
+        = static_cast< OMX_AUDIO_CODINGTYPE >(OMX_AUDIO_CodingPCM);
+    pcmtype_.nSamplingRate = samplerate;
+    pcmtype_.nChannels = nchannels;
+    pcmtype_.nBitPerSample = bitdepth;
+    pcmtype_.eEndian = endianness;
+    pcmtype_.eNumData = sign;
   }
 }
 
@@ -569,9 +644,10 @@ void tiz::probe::set_opus_codec_info (const OMX_U32 samplerate,
   opustype_.nChannels = pcmtype_.nChannels = nchannels;
 
   pcmtype_.bInterleaved = OMX_TRUE;
-  pcmtype_.nBitPerSample = bitdepth;
+  // The opus decoders output 32 bit float samples, whatever MediaInfo says
+  pcmtype_.nBitPerSample = 32;
   pcmtype_.eEndian = endianness;
-  pcmtype_.eNumData = sign;
+  pcmtype_.eNumData = OMX_NumericalDataFloat;
 }
 
 void tiz::probe::set_flac_codec_info (const OMX_U32 samplerate,
@@ -592,7 +668,10 @@ void tiz::probe::set_flac_codec_info (const OMX_U32 samplerate,
     pcmtype_.bInterleaved = OMX_FALSE;
   }
 
-  pcmtype_.nBitPerSample = bitdepth;
+  // The flac decoder outputs samples at the stream's native depth, rounded up
+  // to a whole number of bytes (e.g. 20 bit streams are output as packed 24
+  // bit samples)
+  pcmtype_.nBitPerSample = ((bitdepth + 7) / 8) * 8;
   pcmtype_.eEndian = endianness;
   pcmtype_.eNumData = sign;
 }
@@ -615,11 +694,10 @@ void tiz::probe::set_vorbis_codec_info (const OMX_U32 samplerate,
     pcmtype_.bInterleaved = OMX_FALSE;
   }
 
-  // This is a hack, not sure why libav says this is a 16 bit format
-  //   pcmtype_.nBitPerSample = 32;
-  pcmtype_.nBitPerSample = bitdepth;
+  // The vorbis decoder outputs 32 bit float samples, whatever MediaInfo says
+  pcmtype_.nBitPerSample = 32;
   pcmtype_.eEndian = endianness;
-  pcmtype_.eNumData = sign;
+  pcmtype_.eNumData = OMX_NumericalDataFloat;
 }
 
 void tiz::probe::get_pcm_codec_info (OMX_AUDIO_PARAM_PCMMODETYPE &pcmtype)
@@ -747,76 +825,49 @@ bool tiz::probe::is_cbr_stream ()
   return stream_is_cbr_;
 }
 
-std::string tiz::probe::retrieve_meta_data_str (
-    TagLib::String (TagLib::Tag::*TagFunction)() const) const
-{
-  assert (TagFunction);
-  if (!meta_file_.isNull () && meta_file_.tag ())
-  {
-    TagLib::Tag *tag = meta_file_.tag ();
-    return (tag->*TagFunction)().stripWhiteSpace ().to8Bit ();
-  }
-  return std::string ();
-}
-
-unsigned int tiz::probe::retrieve_meta_data_uint (
-    TagLib::uint (TagLib::Tag::*TagFunction)() const) const
-{
-  assert (TagFunction);
-  if (!meta_file_.isNull () && meta_file_.tag ())
-  {
-    TagLib::Tag *tag = meta_file_.tag ();
-    return (tag->*TagFunction)();
-  }
-  return 0;
-}
-
 std::string tiz::probe::title () const
 {
-  return retrieve_meta_data_str (&TagLib::Tag::title);
+  return info_.title_;
 }
 
 std::string tiz::probe::artist () const
 {
-  return retrieve_meta_data_str (&TagLib::Tag::artist);
+  return info_.artist_;
 }
 
 std::string tiz::probe::album () const
 {
-  return retrieve_meta_data_str (&TagLib::Tag::album);
+  return info_.album_;
 }
 
 std::string tiz::probe::year () const
 {
-  return boost::lexical_cast< std::string >(
-      retrieve_meta_data_uint (&TagLib::Tag::year));
+  return boost::lexical_cast< std::string >(info_.year_);
 }
 
 std::string tiz::probe::comment () const
 {
-  return retrieve_meta_data_str (&TagLib::Tag::comment);
+  return info_.comment_;
 }
 
 std::string tiz::probe::track () const
 {
-  return boost::lexical_cast< std::string >(
-      retrieve_meta_data_uint (&TagLib::Tag::track));
+  return boost::lexical_cast< std::string >(info_.track_);
 }
 
 std::string tiz::probe::genre () const
 {
-  return retrieve_meta_data_str (&TagLib::Tag::genre);
+  return info_.genre_;
 }
 
 std::string tiz::probe::stream_length () const
 {
   std::string length_str;
 
-  if (!meta_file_.isNull () && meta_file_.audioProperties ())
+  if (info_.length_ >= 0)
   {
-    TagLib::AudioProperties *properties = meta_file_.audioProperties ();
-    int seconds = properties->length () % 60;
-    int minutes = (properties->length () - seconds) / 60;
+    int seconds = info_.length_ % 60;
+    int minutes = (info_.length_ - seconds) / 60;
     int hours = 0;
     if (minutes >= 60)
     {
@@ -32,9 +32,6 @@
 #include <string>
 #include <boost/shared_ptr.hpp>
 
-#include <fileref.h>
-#include <tag.h>
-
 #include <OMX_Core.h>
 #include <OMX_Component.h>
 #include <OMX_Audio.h>
@@ -43,6 +40,35 @@
 
 namespace tiz
 {
+  /**
+   * The raw stream properties that a probe obtains from MediaInfo and TagLib.
+   * This is what the probe cache stores (see tizprobecache.hpp).
+   */
+  struct probeinfo
+  {
+    probeinfo ();
+
+    OMX_MEDIACONTAINER_FORMATTYPE container_type_;
+    OMX_AUDIO_CODINGTYPE codec_id_;
+    OMX_U32 samplerate_;
+    OMX_U32 bitrate_;
+    OMX_U32 nchannels_;
+    OMX_U32 bitdepth_;
+    OMX_ENDIANTYPE endianness_;
+    OMX_NUMERICALDATATYPE sign_;
+    bool stream_is_cbr_;
+    int length_;  // in seconds, or -1 if unknown
+    unsigned int year_;
+    unsigned int track_;
+    std::string stream_title_;  // as obtained in quiet mode
+    std::string stream_genre_;
+    std::string title_;
+    std::string artist_;
+    std::string album_;
+    std::string comment_;
+    std::string genre_;
+  };
+
   class probe
   {
 
@@ -116,10 +142,6 @@ namespace tiz
                                 const OMX_U32 nchannels, const OMX_U32 bitdepth,
                                 const OMX_ENDIANTYPE endianness,
                                 const OMX_NUMERICALDATATYPE sign);
-    std::string retrieve_meta_data_str (
-        TagLib::String (TagLib::Tag::*TagFunction)() const) const;
-    unsigned int retrieve_meta_data_uint (
-        TagLib::uint (TagLib::Tag::*TagFunction)() const) const;
 
   private:
     std::string uri_;
@@ -137,7 +159,7 @@ namespace tiz
     OMX_AUDIO_PARAM_VORBISTYPE vorbistype_;
     OMX_AUDIO_PARAM_AACPROFILETYPE aactype_;
     OMX_VIDEO_PARAM_VP8TYPE vp8type_;
-    TagLib::FileRef meta_file_;
+    probeinfo info_;
     std::string stream_title_;
     std::string stream_genre_;
     bool stream_is_cbr_;
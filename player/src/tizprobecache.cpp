@@ -0,0 +1,599 @@
+/**
+ * Copyright (C) 2011-2017 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   tizprobecache.cpp
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Persistent cache of stream probing results
+ *
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <assert.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/thread.hpp>
+
+#include <tizplatform.h>
+
+#include "tizprobecache.hpp"
+
+#ifdef TIZ_LOG_CATEGORY_NAME
+#undef TIZ_LOG_CATEGORY_NAME
+#define TIZ_LOG_CATEGORY_NAME "tiz.play.probecache"
+#endif
+
+#define TIZ_PROBE_CACHE_MAGIC "tizprobecache"
+#define TIZ_PROBE_CACHE_VERSION 1
+#define TIZ_PROBE_CACHE_NONE "none"
+#define TIZ_PROBE_CACHE_MAX_PREFETCH_THREADS 4
+
+namespace  // unnamed
+{
+  enum cache_str_t
+  {
+    StrPath,
+    StrStreamTitle,
+    StrStreamGenre,
+    StrTitle,
+    StrArtist,
+    StrAlbum,
+    StrComment,
+    StrGenre,
+    StrMax
+  };
+
+  // The cache file is a header, followed by an array of fixed-size records
+  // sorted by path hash, followed by a pool that holds the records'
+  // strings. It uses the host's byte order, as it is never shared between
+  // machines.
+  struct cache_header_t
+  {
+    char magic[16];
+    uint32_t version;
+    uint32_t record_size;
+    uint32_t nrecords;
+    uint32_t pool_size;
+  };
+
+  struct cache_record_t
+  {
+    uint64_t hash;
+    int64_t mtime_sec;
+    int64_t mtime_nsec;
+    uint64_t size;
+    uint32_t container_type;
+    uint32_t codec_id;
+    uint32_t samplerate;
+    uint32_t bitrate;
+    uint32_t nchannels;
+    uint32_t bitdepth;
+    uint32_t endianness;
+    uint32_t sign;
+    uint32_t stream_is_cbr;
+    int32_t length;
+    uint32_t year;
+    uint32_t track;
+    uint32_t str_offset[StrMax];
+    uint32_t str_len[StrMax];
+  };
+
+  struct cache_entry_t
+  {
+    int64_t mtime_sec;
+    int64_t mtime_nsec;
+    uint64_t size;
+    tiz::probeinfo info;
+  };
+
+  typedef std::map< std::string, cache_entry_t > cache_map_t;
+  typedef boost::shared_ptr< boost::thread > thread_ptr_t;
+
+  struct cache_t
+  {
+    cache_t ()
+      : loaded (false),
+        dirty (false),
+        path (),
+        p_map (NULL),
+        map_size (0),
+        p_records (NULL),
+        nrecords (0),
+        p_pool (NULL),
+        pool_size (0),
+        added (),
+        mutex (),
+        prefetch_list (),
+        next_prefetch (0),
+        stop_prefetch (false),
+        workers ()
+    {
+    }
+
+    bool loaded;
+    bool dirty;
+    std::string path;
+    void *p_map;
+    size_t map_size;
+    const cache_record_t *p_records;
+    uint32_t nrecords;
+    const char *p_pool;
+    uint32_t pool_size;
+    cache_map_t added;  // entries probed since the cache file was mapped
+    boost::mutex mutex;
+    uri_lst_t prefetch_list;
+    size_t next_prefetch;
+    bool stop_prefetch;
+    std::vector< thread_ptr_t > workers;
+  };
+
+  cache_t &get_cache ()
+  {
+    static cache_t cache;
+    return cache;
+  }
+
+  uint64_t hash_path (const std::string &path)
+  {
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ULL;
+    for (std::string::const_iterator it = path.begin (); it != path.end ();
+         ++it)
+    {
+      hash ^= static_cast< unsigned char >(*it);
+      hash *= 1099511628211ULL;
+    }
+    return hash;
+  }
+
+  bool hash_less (const cache_record_t &record, const uint64_t hash)
+  {
+    return record.hash < hash;
+  }
+
+  bool entry_matches (const cache_entry_t &entry, const struct stat &st)
+  {
+    return (entry.mtime_sec == static_cast< int64_t >(st.st_mtim.tv_sec)
+            && entry.mtime_nsec == static_cast< int64_t >(st.st_mtim.tv_nsec)
+            && entry.size == static_cast< uint64_t >(st.st_size));
+  }
+
+  std::string cache_file_path ()
+  {
+    std::string path;
+    const char *p_path = tiz_rcfile_get_value ("tizonia", "probe-cache");
+    if (p_path)
+    {
+      path.assign (p_path);
+    }
+    else
+    {
+      const char *p_xdg_cache = getenv ("XDG_CACHE_HOME");
+      const char *p_home = getenv ("HOME");
+      if (p_xdg_cache && *p_xdg_cache)
+      {
+        path.assign (p_xdg_cache);
+        path.append ("/tizonia/probe-cache");
+      }
+      else if (p_home && *p_home)
+      {
+        path.assign (p_home);
+        path.append ("/.cache/tizonia/probe-cache");
+      }
+    }
+
+    if (path.compare (TIZ_PROBE_CACHE_NONE) == 0)
+    {
+      path.clear ();
+    }
+    return path;
+  }
+
+  void load_cache (cache_t &cache)
+  {
+    struct stat st;
+    int fd = -1;
+
+    assert (!cache.loaded);
+    cache.loaded = true;
+    cache.path = cache_file_path ();
+
+    if (cache.path.empty ()
+        || (fd = open (cache.path.c_str (), O_RDONLY | O_CLOEXEC)) < 0)
+    {
+      return;
+    }
+
+    if (0 == fstat (fd, &st)
+        && st.st_size >= static_cast< off_t >(sizeof (cache_header_t)))
+    {
+      void *p_map = mmap (NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (MAP_FAILED != p_map)
+      {
+        const cache_header_t *p_hdr
+            = static_cast< const cache_header_t * >(p_map);
+        const uint64_t expected_size
+            = sizeof (cache_header_t)
+              + static_cast< uint64_t >(p_hdr->nrecords)
+                    * sizeof (cache_record_t)
+              + p_hdr->pool_size;
+        if (0 == memcmp (p_hdr->magic, TIZ_PROBE_CACHE_MAGIC,
+                         sizeof (TIZ_PROBE_CACHE_MAGIC))
+            && TIZ_PROBE_CACHE_VERSION == p_hdr->version
+            && sizeof (cache_record_t) == p_hdr->record_size
+            && expected_size == static_cast< uint64_t >(st.st_size))
+        {
+          const char *p_base = static_cast< const char * >(p_map);
+          cache.p_map = p_map;
+          cache.map_size = st.st_size;
+          cache.nrecords = p_hdr->nrecords;
+          cache.p_records = reinterpret_cast< const cache_record_t * >(
+              p_base + sizeof (cache_header_t));
+          cache.pool_size = p_hdr->pool_size;
+          cache.p_pool = p_base + sizeof (cache_header_t)
+                         + cache.nrecords * sizeof (cache_record_t);
+          TIZ_LOG (TIZ_PRIORITY_NOTICE, "[%s] : [%u] entries", cache.path.c_str (),
+                   cache.nrecords);
+        }
+        else
+        {
+          TIZ_LOG (TIZ_PRIORITY_NOTICE, "[%s] : ignoring invalid cache file",
+                   cache.path.c_str ());
+          (void)munmap (p_map, st.st_size);
+        }
+      }
+    }
+
+    (void)close (fd);
+  }
+
+  bool record_str (const cache_t &cache, const cache_record_t &record,
+                   const cache_str_t which, std::string &str)
+  {
+    const uint32_t offset = record.str_offset[which];
+    const uint32_t len = record.str_len[which];
+    if (offset > cache.pool_size || len > cache.pool_size - offset)
+    {
+      return false;
+    }
+    str.assign (cache.p_pool + offset, len);
+    return true;
+  }
+
+  bool decode_record (const cache_t &cache, const cache_record_t &record,
+                      cache_entry_t &entry)
+  {
+    tiz::probeinfo &info = entry.info;
+    entry.mtime_sec = record.mtime_sec;
+    entry.mtime_nsec = record.mtime_nsec;
+    entry.size = record.size;
+    info.container_type_
+        = static_cast< OMX_MEDIACONTAINER_FORMATTYPE >(record.container_type);
+    info.codec_id_ = static_cast< OMX_AUDIO_CODINGTYPE >(record.codec_id);
+    info.samplerate_ = record.samplerate;
+    info.bitrate_ = record.bitrate;
+    info.nchannels_ = record.nchannels;
+    info.bitdepth_ = record.bitdepth;
+    info.endianness_ = static_cast< OMX_ENDIANTYPE >(record.endianness);
+    info.sign_ = static_cast< OMX_NUMERICALDATATYPE >(record.sign);
+    info.stream_is_cbr_ = (record.stream_is_cbr != 0);
+    info.length_ = record.length;
+    info.year_ = record.year;
+    info.track_ = record.track;
+    return (record_str (cache, record, StrStreamTitle, info.stream_title_)
+            && record_str (cache, record, StrStreamGenre, info.stream_genre_)
+            && record_str (cache, record, StrTitle, info.title_)
+            && record_str (cache, record, StrArtist, info.artist_)
+            && record_str (cache, record, StrAlbum, info.album_)
+            && record_str (cache, record, StrComment, info.comment_)
+            && record_str (cache, record, StrGenre, info.genre_));
+  }
+
+  bool find_record (const cache_t &cache, const std::string &path,
+                    const struct stat &st, tiz::probeinfo &info)
+  {
+    const uint64_t hash = hash_path (path);
+    const cache_record_t *p_end = cache.p_records + cache.nrecords;
+    const cache_record_t *p_rec
+        = std::lower_bound (cache.p_records, p_end, hash, hash_less);
+    std::string rec_path;
+
+    for (; p_rec < p_end && p_rec->hash == hash; ++p_rec)
+    {
+      if (record_str (cache, *p_rec, StrPath, rec_path)
+          && rec_path.compare (path) == 0)
+      {
+        cache_entry_t entry;
+        if (decode_record (cache, *p_rec, entry) && entry_matches (entry, st))
+        {
+          info = entry.info;
+          return true;
+        }
+        break;
+      }
+    }
+    return false;
+  }
+
+  void append_record (std::vector< cache_record_t > &records, std::string &pool,
+                      const std::string &path, const cache_entry_t &entry)
+  {
+    const tiz::probeinfo &info = entry.info;
+    const std::string *strs[StrMax]
+        = {&path,         &info.stream_title_, &info.stream_genre_,
+           &info.title_,  &info.artist_,       &info.album_,
+           &info.comment_, &info.genre_};
+    cache_record_t record;
+
+    memset (&record, 0, sizeof (record));
+    record.hash = hash_path (path);
+    record.mtime_sec = entry.mtime_sec;
+    record.mtime_nsec = entry.mtime_nsec;
+    record.size = entry.size;
+    record.container_type = info.container_type_;
+    record.codec_id = info.codec_id_;
+    record.samplerate = info.samplerate_;
+    record.bitrate = info.bitrate_;
+    record.nchannels = info.nchannels_;
+    record.bitdepth = info.bitdepth_;
+    record.endianness = info.endianness_;
+    record.sign = info.sign_;
+    record.stream_is_cbr = info.stream_is_cbr_ ? 1 : 0;
+    record.length = info.length_;
+    record.year = info.year_;
+    record.track = info.track_;
+    for (int i = 0; i < StrMax; ++i)
+    {
+      record.str_offset[i] = pool.size ();
+      record.str_len[i] = strs[i]->size ();
+      pool.append (*strs[i]);
+    }
+    records.push_back (record);
+  }
+
+  bool record_less (const cache_record_t &a, const cache_record_t &b)
+  {
+    return a.hash < b.hash;
+  }
+
+  void save_cache (cache_t &cache)
+  {
+    std::vector< cache_record_t > records;
+    std::string pool;
+
+    if (!cache.dirty || cache.path.empty ())
+    {
+      return;
+    }
+
+    // Entries probed in this run supersede the ones in the mapped file
+    for (cache_map_t::const_iterator it = cache.added.begin ();
+         it != cache.added.end (); ++it)
+    {
+      append_record (records, pool, it->first, it->second);
+    }
+
+    for (uint32_t i = 0; i < cache.nrecords; ++i)
+    {
+      std::string path;
+      cache_entry_t entry;
+      if (record_str (cache, cache.p_records[i], StrPath, path)
+          && cache.added.find (path) == cache.added.end ()
+          && decode_record (cache, cache.p_records[i], entry))
+      {
+        append_record (records, pool, path, entry);
+      }
+    }
+
+    if (pool.size () > UINT32_MAX)
+    {
+      TIZ_LOG (TIZ_PRIORITY_ERROR, "[%s] : cache too large, not saved",
+               cache.path.c_str ());
+      return;
+    }
+
+    std::sort (records.begin (), records.end (), record_less);
+
+    boost::system::error_code ec;
+    boost::filesystem::create_directories (
+        boost::filesystem::path (cache.path).parent_path (), ec);
+
+    const std::string tmp_path
+        = cache.path + ".tmp."
+          + boost::lexical_cast< std::string >(getpid ());
+    FILE *p_file = fopen (tmp_path.c_str (), "wb");
+    if (p_file)
+    {
+      cache_header_t hdr;
+      memset (&hdr, 0, sizeof (hdr));
+      memcpy (hdr.magic, TIZ_PROBE_CACHE_MAGIC, sizeof (TIZ_PROBE_CACHE_MAGIC));
+      hdr.version = TIZ_PROBE_CACHE_VERSION;
+      hdr.record_size = sizeof (cache_record_t);
+      hdr.nrecords = records.size ();
+      hdr.pool_size = pool.size ();
+
+      bool ok = (1 == fwrite (&hdr, sizeof (hdr), 1, p_file));
+      if (ok && !records.empty ())
+      {
+        ok = (records.size () == fwrite (&records[0], sizeof (cache_record_t),
+                                         records.size (), p_file));
+      }
+      if (ok && !pool.empty ())
+      {
+        ok = (1 == fwrite (pool.data (), pool.size (), 1, p_file));
+      }
+      ok = (0 == fclose (p_file)) && ok;
+
+      if (ok && 0 == rename (tmp_path.c_str (), cache.path.c_str ()))
+      {
+        cache.dirty = false;
+        TIZ_LOG (TIZ_PRIORITY_NOTICE, "[%s] : saved [%u] entries",
+                 cache.path.c_str (), (unsigned int)records.size ());
+      }
+      else
+      {
+        (void)unlink (tmp_path.c_str ());
+      }
+    }
+  }
+
+  void prefetch_worker ()
+  {
+    cache_t &cache = get_cache ();
+    for (;;)
+    {
+      std::string uri;
+      {
+        boost::lock_guard< boost::mutex > lock (cache.mutex);
+        if (cache.stop_prefetch
+            || cache.next_prefetch >= cache.prefetch_list.size ())
+        {
+          break;
+        }
+        uri = cache.prefetch_list[cache.next_prefetch++];
+      }
+      // Probing goes through the cache; misses get stored there
+      tiz::probe probe (uri, /* quiet = */ true);
+      (void)probe.get_omx_domain ();
+    }
+  }
+
+  void stop_prefetch (cache_t &cache)
+  {
+    {
+      boost::lock_guard< boost::mutex > lock (cache.mutex);
+      cache.stop_prefetch = true;
+    }
+    for (std::vector< thread_ptr_t >::iterator it = cache.workers.begin ();
+         it != cache.workers.end (); ++it)
+    {
+      (*it)->join ();
+    }
+    cache.workers.clear ();
+  }
+}
+
+bool tiz::probecache::lookup (const std::string &uri, probeinfo &info)
+{
+  struct stat st;
+  bool found = false;
+
+  if (0 == stat (uri.c_str (), &st) && S_ISREG (st.st_mode))
+  {
+    cache_t &cache = get_cache ();
+    boost::lock_guard< boost::mutex > lock (cache.mutex);
+    if (!cache.loaded)
+    {
+      load_cache (cache);
+    }
+
+    cache_map_t::const_iterator it = cache.added.find (uri);
+    if (it != cache.added.end ())
+    {
+      if (entry_matches (it->second, st))
+      {
+        info = it->second.info;
+        found = true;
+      }
+    }
+    else
+    {
+      found = find_record (cache, uri, st, info);
+    }
+  }
+
+  TIZ_LOG (TIZ_PRIORITY_TRACE, "[%s] : %s", uri.c_str (),
+           found ? "HIT" : "MISS");
+  return found;
+}
+
+void tiz::probecache::store (const std::string &uri, const probeinfo &info)
+{
+  struct stat st;
+
+  if (0 == stat (uri.c_str (), &st) && S_ISREG (st.st_mode))
+  {
+    cache_t &cache = get_cache ();
+    boost::lock_guard< boost::mutex > lock (cache.mutex);
+    if (!cache.loaded)
+    {
+      load_cache (cache);
+    }
+
+    cache_entry_t &entry = cache.added[uri];
+    entry.mtime_sec = st.st_mtim.tv_sec;
+    entry.mtime_nsec = st.st_mtim.tv_nsec;
+    entry.size = st.st_size;
+    entry.info = info;
+    cache.dirty = true;
+  }
+}
+
+void tiz::probecache::prefetch (const uri_lst_t &uri_list)
+{
+  cache_t &cache = get_cache ();
+  unsigned int nworkers = boost::thread::hardware_concurrency ();
+
+  stop_prefetch (cache);
+
+  {
+    boost::lock_guard< boost::mutex > lock (cache.mutex);
+    cache.prefetch_list = uri_list;
+    cache.next_prefetch = 0;
+    cache.stop_prefetch = false;
+  }
+
+  nworkers = std::max (1U, std::min (nworkers,
+                                     (unsigned int)
+                                         TIZ_PROBE_CACHE_MAX_PREFETCH_THREADS));
+  nworkers = std::min (nworkers, (unsigned int)uri_list.size ());
+  TIZ_LOG (TIZ_PRIORITY_TRACE, "prefetching [%u] uris with [%u] workers",
+           (unsigned int)uri_list.size (), nworkers);
+  for (unsigned int i = 0; i < nworkers; ++i)
+  {
+    cache.workers.push_back (boost::make_shared< boost::thread >(prefetch_worker));
+  }
+}
+
+void tiz::probecache::flush ()
+{
+  cache_t &cache = get_cache ();
+  stop_prefetch (cache);
+  boost::lock_guard< boost::mutex > lock (cache.mutex);
+  save_cache (cache);
+}
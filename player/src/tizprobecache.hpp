@@ -0,0 +1,68 @@
+/**
+ * Copyright (C) 2011-2017 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   tizprobecache.hpp
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Persistent cache of stream probing results
+ *
+ *
+ */
+
+#ifndef TIZPROBECACHE_HPP
+#define TIZPROBECACHE_HPP
+
+#include <string>
+
+#include "tizgraphtypes.hpp"
+#include "tizprobe.hpp"
+
+namespace tiz
+{
+  /**
+   * Keeps the results of probing local files, keyed by path, modification
+   * time and size, so that MediaInfo and TagLib only need to look at a file
+   * the first time it is seen. The cache is stored in a single file that is
+   * memory-mapped on first use and rewritten by flush () (see the
+   * 'probe-cache' option in tizonia.conf).
+   *
+   * All methods are thread-safe.
+   */
+  class probecache
+  {
+  public:
+    static bool lookup (const std::string &uri, probeinfo &info);
+    static void store (const std::string &uri, const probeinfo &info);
+
+    /**
+     * Probes in the background, using a few worker threads, the files in the
+     * list that are not yet in the cache.
+     */
+    static void prefetch (const uri_lst_t &uri_list);
+
+    /**
+     * Stops any prefetch in progress and saves the cache, if it has new
+     * entries.
+     */
+    static void flush ();
+  };
+}  // namespace tiz
+
+#endif  // TIZPROBECACHE_HPP
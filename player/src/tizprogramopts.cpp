@@ -284,6 +284,7 @@ tiz::programopts::programopts (int argc, char *argv[])
     station_name_ ("Tizonia Radio"),
     station_genre_ ("Unknown Genre"),
     no_icy_metadata_ (false),
+    transcode_ (false),
     bitrates_ (),
     bitrate_list_ (),
     sampling_rates_ (),
@@ -583,6 +584,11 @@ bool tiz::programopts::icy_metadata () const
   return !no_icy_metadata_;
 }
 
+bool tiz::programopts::transcode () const
+{
+  return transcode_;
+}
+
 const std::string &tiz::programopts::bitrates () const
 {
   return bitrates_;
@@ -1035,6 +1041,10 @@ void tiz::programopts::init_streaming_server_options ()
       ("no-icy-metadata", po::bool_switch (&no_icy_metadata_),
        "Disables Icecast/SHOUTcast metadata in the stream.")
       /* TIZ_CLASS_COMMENT: */
+      ("transcode", po::bool_switch (&transcode_),
+       "Transcode all media (e.g. FLAC, Opus, AAC) to a constant MP3 stream. "
+       "The output format is configured in tizonia.conf.")
+      /* TIZ_CLASS_COMMENT: */
       ("bitrate-modes", po::value (&bitrates_),
        "A comma-separated list of "
        /* TIZ_CLASS_COMMENT: */
@@ -1057,8 +1067,8 @@ void tiz::programopts::init_streaming_server_options ()
       &tiz::programopts::consume_streaming_server_options);
   all_streaming_server_options_
       = boost::assign::list_of ("server") ("port") ("station-name") (
-            "station-genre") ("no-icy-metadata") ("bitrate-modes") (
-            "sampling-rates")
+            "station-genre") ("no-icy-metadata") ("transcode") (
+            "bitrate-modes") ("sampling-rates")
             .convert_to_container< std::vector< std::string > > ();
 }
 
@@ -69,6 +69,7 @@ namespace tiz
     const std::string &station_name () const;
     const std::string &station_genre () const;
     bool icy_metadata () const;
+    bool transcode () const;
     const std::string &bitrates () const;
     const std::vector< std::string > &bitrate_list () const;
     const std::string &sampling_rates () const;
@@ -175,6 +176,7 @@ namespace tiz
     std::string station_name_;
     std::string station_genre_;
     bool no_icy_metadata_;
+    bool transcode_;
     std::string bitrates_;
     std::vector< std::string > bitrate_list_;
     std::string sampling_rates_;
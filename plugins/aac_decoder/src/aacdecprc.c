@@ -62,7 +62,10 @@ static OMX_ERRORTYPE allocate_temp_data_store (aacdec_prc_t *ap_prc)
                             OMX_IndexParamPortDefinition, &port_def));
 
   assert (ap_prc->p_store_ == NULL);
-  return tiz_buffer_init (&(ap_prc->p_store_), port_def.nBufferSize);
+  tiz_check_omx (tiz_buffer_init (&(ap_prc->p_store_), port_def.nBufferSize));
+  /* If this fails, the store simply stays linear */
+  (void) tiz_buffer_seek_mode (ap_prc->p_store_, TIZ_BUFFER_CIRCULAR);
+  return OMX_ErrorNone;
 }
 
 static inline void deallocate_temp_data_store (
@@ -459,7 +462,7 @@ static OMX_ERRORTYPE transform_buffer (aacdec_prc_t *ap_prc)
         }
 
       TIZ_TRACE (handleOf (ap_prc),
-                 "bytes_available = [%d] bytesconsumed = [%d] "
+                 "bytes_available = [%zu] bytesconsumed = [%d] "
                  "samples = [%d] error [%d]",
                  tiz_buffer_available (ap_prc->p_store_),
                  ap_prc->aac_info_.bytesconsumed, ap_prc->aac_info_.samples,
@@ -37,6 +37,7 @@
 #include <assert.h>
 
 #include <OMX_Core.h>
+#include <OMX_TizoniaExt.h>
 
 #include <tizplatform.h>
 
@@ -80,6 +81,8 @@ reset_stream_parameters (fr_prc_t * ap_prc)
   assert (ap_prc);
   ap_prc->counter_ = 0;
   ap_prc->eos_ = false;
+  ap_prc->seeked_ = false;
+  ap_prc->seek_time_ = 0;
   if (ap_prc->p_file_)
     {
       rewind (ap_prc->p_file_);
@@ -160,6 +163,15 @@ read_into_buffer (const void * ap_obj, OMX_BUFFERHEADERTYPE * p_hdr)
       p_hdr->nFilledLen = bytes_read;
       p_prc->counter_ += p_hdr->nFilledLen;
 
+      if (p_prc->seeked_)
+        {
+          /* First buffer after a seek: let the decoder know where in the
+             stream this data comes from */
+          p_hdr->nFlags |= OMX_BUFFERFLAG_STARTTIME;
+          p_hdr->nTimeStamp = p_prc->seek_time_;
+          p_prc->seeked_ = false;
+        }
+
       TIZ_TRACE (handleOf (p_prc),
                  "Reading into HEADER [%p]...nFilledLen[%d] "
                  "counter [%d] bytes_read[%d]",
@@ -277,6 +289,52 @@ fr_prc_buffers_ready (const void * ap_obj)
   return OMX_ErrorNone;
 }
 
+static OMX_ERRORTYPE
+fr_prc_config_change (void * ap_obj, OMX_U32 TIZ_UNUSED (a_pid),
+                      OMX_INDEXTYPE a_config_idx)
+{
+  fr_prc_t * p_prc = ap_obj;
+  assert (p_prc);
+
+  if (OMX_TizoniaIndexConfigStreamPosition == a_config_idx && p_prc->p_file_)
+    {
+      OMX_TIZONIA_STREAMPOSITIONTYPE position;
+      TIZ_INIT_OMX_STRUCT (position);
+      tiz_check_omx (tiz_api_GetConfig (tiz_get_krn (handleOf (p_prc)),
+                                        handleOf (p_prc),
+                                        OMX_TizoniaIndexConfigStreamPosition,
+                                        &position));
+
+      if (position.nByteOffset < 0)
+        {
+          /* This component can only seek to byte offsets */
+          TIZ_ERROR (handleOf (p_prc), "Unable to seek to time [%lld] us",
+                     (long long) position.nTimestamp);
+          return OMX_ErrorUnsupportedSetting;
+        }
+
+      if (0 != fseeko (p_prc->p_file_, (off_t) position.nByteOffset, SEEK_SET))
+        {
+          TIZ_ERROR (handleOf (p_prc), "Error seeking to offset [%lld] (%s)",
+                     (long long) position.nByteOffset, strerror (errno));
+          return OMX_ErrorUndefined;
+        }
+
+      TIZ_NOTICE (handleOf (p_prc), "Seeked to offset [%lld] time [%lld] us",
+                  (long long) position.nByteOffset,
+                  (long long) position.nTimestamp);
+
+      p_prc->counter_ = position.nByteOffset;
+      p_prc->eos_ = false;
+      p_prc->seeked_ = true;
+      p_prc->seek_time_ = position.nTimestamp;
+
+      /* There may be buffers waiting on the port already */
+      tiz_check_omx (fr_prc_buffers_ready (p_prc));
+    }
+  return OMX_ErrorNone;
+}
+
 /*
  * fr_prc_class
  */
@@ -335,6 +393,8 @@ fr_prc_init (void * ap_tos, void * ap_hdl)
      tiz_srv_stop_and_return, fr_prc_stop_and_return,
      /* TIZ_CLASS_COMMENT: */
      tiz_prc_buffers_ready, fr_prc_buffers_ready,
+     /* TIZ_CLASS_COMMENT: */
+     tiz_prc_config_change, fr_prc_config_change,
      /* TIZ_CLASS_COMMENT: stop value */
      0);
 
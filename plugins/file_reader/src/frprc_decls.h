@@ -46,6 +46,8 @@ struct fr_prc
   OMX_PARAM_CONTENTURITYPE * p_uri_param_;
   OMX_U32 counter_;
   bool eos_;
+  bool seeked_;
+  OMX_TICKS seek_time_;
 };
 
 typedef struct fr_prc_class fr_prc_class_t;
@@ -120,7 +120,7 @@ instantiate_output_port (OMX_HANDLETYPE ap_hdl)
   pcmmode.nPortIndex = 1;
   pcmmode.nChannels = 2;
   pcmmode.eNumData = OMX_NumericalDataSigned;
-  pcmmode.eEndian = OMX_EndianBig;
+  pcmmode.eEndian = OMX_EndianLittle;
   pcmmode.bInterleaved = OMX_TRUE;
   pcmmode.nBitPerSample = 16;
   pcmmode.nSamplingRate = 48000;
@@ -34,6 +34,8 @@
 #include <limits.h>
 #include <string.h>
 
+#include <OMX_TizoniaExt.h>
+
 #include <tizplatform.h>
 
 #include <tizkernel.h>
@@ -245,6 +247,92 @@ store_data (flacd_prc_t * ap_prc, const OMX_U8 * ap_data, OMX_U32 a_nbytes)
   return nbytes_to_copy;
 }
 
+static inline OMX_TICKS
+samples_to_us (const flacd_prc_t * ap_prc, const FLAC__uint64 a_samples)
+{
+  assert (ap_prc);
+  return ap_prc->sample_rate_ > 0
+           ? (OMX_TICKS) (a_samples * 1000000 / ap_prc->sample_rate_)
+           : 0;
+}
+
+static OMX_ERRORTYPE
+store_stream_position (flacd_prc_t * ap_prc, const OMX_TICKS a_timestamp,
+                       const OMX_S64 a_byte_offset)
+{
+  OMX_TIZONIA_STREAMPOSITIONTYPE position;
+  assert (ap_prc);
+  TIZ_INIT_OMX_PORT_STRUCT (position, ARATELIA_FLAC_DECODER_INPUT_PORT_INDEX);
+  position.nTimestamp = a_timestamp;
+  position.nByteOffset = a_byte_offset;
+  return tiz_krn_SetConfig_internal (tiz_get_krn (handleOf (ap_prc)),
+                                     handleOf (ap_prc),
+                                     OMX_TizoniaIndexConfigStreamPosition,
+                                     &position);
+}
+
+static void
+find_seek_point (const flacd_prc_t * ap_prc, const FLAC__uint64 a_target,
+                 FLAC__uint64 * ap_sample, FLAC__uint64 * ap_offset)
+{
+  assert (ap_prc);
+  assert (ap_sample);
+  assert (ap_offset);
+
+  *ap_sample = 0;
+  *ap_offset = ap_prc->first_frame_pos_;
+
+  if (ap_prc->p_seektable_)
+    {
+      /* Seek points are sorted by sample number, with the placeholders at
+         the end. Their offsets are relative to the first frame. */
+      const FLAC__StreamMetadata_SeekTable * p_table
+        = &(ap_prc->p_seektable_->data.seek_table);
+      unsigned i = 0;
+      for (i = 0; i < p_table->num_points; ++i)
+        {
+          const FLAC__StreamMetadata_SeekPoint * p_point = &(p_table->points[i]);
+          if (FLAC__STREAM_METADATA_SEEKPOINT_PLACEHOLDER
+                == p_point->sample_number
+              || p_point->sample_number > a_target)
+            {
+              break;
+            }
+          *ap_sample = p_point->sample_number;
+          *ap_offset = ap_prc->first_frame_pos_ + p_point->stream_offset;
+        }
+    }
+  else if (ap_prc->decoded_samples_ > 0
+           && ap_prc->decode_pos_ > ap_prc->first_frame_pos_)
+    {
+      /* No seek table: interpolate using the average size of the frames
+         decoded so far, aiming one second early to absorb bitrate
+         variations. */
+      const double bytes_per_sample
+        = (double) (ap_prc->decode_pos_ - ap_prc->first_frame_pos_)
+          / ap_prc->decoded_samples_;
+      *ap_sample
+        = a_target > ap_prc->sample_rate_ ? a_target - ap_prc->sample_rate_ : 0;
+      *ap_offset = ap_prc->first_frame_pos_
+                   + (FLAC__uint64) (*ap_sample * bytes_per_sample);
+    }
+}
+
+static void
+resync_decoder (flacd_prc_t * ap_prc)
+{
+  assert (ap_prc);
+  TIZ_TRACE (handleOf (ap_prc), "resuming at sample [%llu]",
+             (unsigned long long) ap_prc->target_sample_);
+  /* The decoder discards its state and looks for the next frame sync. Frame
+     headers carry absolute sample numbers, so write_cb can trim the output
+     exactly from there. */
+  (void) FLAC__stream_decoder_flush (ap_prc->p_flac_dec_);
+  ap_prc->awaiting_start_ = false;
+  ap_prc->store_offset_ = 0;
+  ap_prc->eos_ = false;
+}
+
 static inline bool
 input_data_available (flacd_prc_t * ap_prc)
 {
@@ -258,8 +346,23 @@ input_data_available (flacd_prc_t * ap_prc)
       while (!done && ((p_hdr = get_header (
                           ap_prc, ARATELIA_FLAC_DECODER_INPUT_PORT_INDEX))))
         {
-          int bytes_stored = store_data (
-            ap_prc, p_hdr->pBuffer + p_hdr->nOffset, p_hdr->nFilledLen);
+          int bytes_stored = 0;
+
+          if (ap_prc->awaiting_start_)
+            {
+              if (0 == (p_hdr->nFlags & OMX_BUFFERFLAG_STARTTIME))
+                {
+                  /* Data from before the seek point */
+                  p_hdr->nFilledLen = 0;
+                  release_header (ap_prc,
+                                  ARATELIA_FLAC_DECODER_INPUT_PORT_INDEX);
+                  continue;
+                }
+              resync_decoder (ap_prc);
+            }
+
+          bytes_stored = store_data (ap_prc, p_hdr->pBuffer + p_hdr->nOffset,
+                                     p_hdr->nFilledLen);
           p_hdr->nFilledLen -= bytes_stored;
 
           if ((p_hdr->nFlags & OMX_BUFFERFLAG_EOS) > 0)
@@ -415,6 +518,7 @@ read_cb (const FLAC__StreamDecoder * ap_decoder, FLAC__byte buffer[],
     {
       rc = FLAC__STREAM_DECODER_READ_STATUS_CONTINUE;
       *ap_bytes = dump_temp_store (p_prc, buffer, *ap_bytes);
+      p_prc->stream_pos_ += *ap_bytes;
     }
 
   TIZ_TRACE (handleOf (p_prc), "bytes delivered [%d] rc [%d]", *ap_bytes, rc);
@@ -422,59 +526,48 @@ read_cb (const FLAC__StreamDecoder * ap_decoder, FLAC__byte buffer[],
   return rc;
 }
 
-static void
-write_pcm_block_8 (uint8_t * ap_to, const FLAC__int32 * const ap_buffer[],
-                   const unsigned int a_nsamples,
-                   const unsigned int a_nchannels)
+static FLAC__StreamDecoderTellStatus
+tell_cb (const FLAC__StreamDecoder * ap_decoder, FLAC__uint64 * ap_offset,
+         void * ap_client_data)
 {
-  size_t i = 0;
-  size_t j = 0;
-  for (i = 0; i < a_nsamples; i += 2, ++j)
-    {
-      FLAC__int8 * out = (FLAC__int8 *) (ap_to) + i;
-      int k;
-      for (k = 0; k < a_nchannels; ++k)
-        {
-          out[k] = (FLAC__int8) ap_buffer[k][j];
-        }
-    }
+  flacd_prc_t * p_prc = (flacd_prc_t *) ap_client_data;
+  (void) ap_decoder;
+  assert (p_prc);
+  assert (ap_offset);
+  /* Only used to work out the byte offsets of frames */
+  *ap_offset = p_prc->stream_pos_;
+  return FLAC__STREAM_DECODER_TELL_STATUS_OK;
 }
 
-static void
-write_pcm_block_16 (uint8_t * ap_to, const FLAC__int32 * const ap_buffer[],
-                    const unsigned int a_nsamples,
-                    const unsigned int a_nchannels)
+/* Bytes per sample on the output port: FLAC depths that are not a multiple
+   of 8 are left-justified in the next container size up, i.e. 20-bit
+   streams are output as packed 24-bit samples */
+static unsigned
+sample_width (const unsigned a_bps)
 {
-  size_t i = 0;
-  size_t j = 0;
-  for (i = 0; i < a_nsamples; i += 2, ++j)
-    {
-      FLAC__int16 * out = (FLAC__int16 *) (ap_to) + i;
-      int k;
-      for (k = 0; k < a_nchannels; ++k)
-        {
-          out[k] = (FLAC__int16) ap_buffer[k][j];
-        }
-    }
+  return (a_bps + 7) / 8;
 }
 
 static void
-write_pcm_block_24 (uint8_t * ap_to, const FLAC__int32 * const ap_buffer[],
-                    const unsigned int a_nsamples,
-                    const unsigned int a_nchannels)
+write_pcm_block (uint8_t * ap_to, const FLAC__int32 * const ap_buffer[],
+                 const size_t a_nframes, const unsigned int a_nchannels,
+                 const unsigned int a_bps)
 {
-  size_t i = 0;
+  const unsigned width = sample_width (a_bps);
+  const unsigned shift = width * 8 - a_bps;
   size_t j = 0;
-  for (i = 0; i < a_nsamples; i += 2, ++j)
+  for (j = 0; j < a_nframes; ++j)
     {
-      unsigned char * out = (unsigned char *) (ap_to) + (i * 3);
-      int k;
+      unsigned k;
       for (k = 0; k < a_nchannels; ++k)
         {
-          unsigned long word32 = (unsigned long) ap_buffer[k][j];
-          *out++ = (unsigned char) (word32 >> 0);
-          *out++ = (unsigned char) (word32 >> 8);
-          *out++ = (unsigned char) (word32 >> 16);
+          /* Little-endian, whatever the host byte order */
+          const FLAC__uint32 word = (FLAC__uint32) ap_buffer[k][j] << shift;
+          unsigned b;
+          for (b = 0; b < width; ++b)
+            {
+              *ap_to++ = (uint8_t) (word >> (8 * b));
+            }
         }
     }
 }
@@ -487,7 +580,6 @@ write_cb (const FLAC__StreamDecoder * ap_decoder, const FLAC__Frame * ap_frame,
   FLAC__StreamDecoderWriteStatus rc
     = FLAC__STREAM_DECODER_WRITE_STATUS_CONTINUE;
 
-  (void) ap_decoder;
   assert (p_prc);
   assert (ap_frame);
   assert (ap_buffer);
@@ -496,61 +588,64 @@ write_cb (const FLAC__StreamDecoder * ap_decoder, const FLAC__Frame * ap_frame,
              ap_frame->header.blocksize, ap_frame->header.channels,
              ap_frame->header.bits_per_sample);
 
-  if (p_prc->channels_ > 2 || (ap_frame->header.bits_per_sample != 8
-                               && ap_frame->header.bits_per_sample != 16
-                               && ap_frame->header.bits_per_sample != 24))
+  {
+    const FLAC__uint64 frame_start = ap_frame->header.number.sample_number;
+    FLAC__uint64 decode_pos = 0;
+    p_prc->decoded_samples_ = frame_start + ap_frame->header.blocksize;
+    if (FLAC__stream_decoder_get_decode_position (ap_decoder, &decode_pos))
+      {
+        p_prc->decode_pos_ = decode_pos;
+      }
+    if (p_prc->target_sample_ >= p_prc->decoded_samples_)
+      {
+        /* Still short of the seek target */
+        return FLAC__STREAM_DECODER_WRITE_STATUS_CONTINUE;
+      }
+  }
+
+  if (p_prc->channels_ > 2 || ap_frame->header.bits_per_sample < 4
+      || ap_frame->header.bits_per_sample > 32)
     {
       TIZ_ERROR (handleOf (p_prc),
-                 "Only stereo streams are supported"
-                 "at 8, 16, or 24 bits per sample.");
+                 "Only mono and stereo streams are supported "
+                 "at 4 to 32 bits per sample.");
       /* TODO: Signal client */
       rc = FLAC__STREAM_DECODER_WRITE_STATUS_ABORT;
     }
   else
     {
-      /* write decoded PCM samples */
-      size_t nsamples = ap_frame->header.blocksize * p_prc->channels_;
+      /* write decoded PCM samples, starting at the seek target if it falls
+         within this frame */
+      const FLAC__int32 * channels[FLAC__MAX_CHANNELS];
+      const unsigned bps = ap_frame->header.bits_per_sample;
+      const size_t frame_len = sample_width (bps) * ap_frame->header.channels;
+      unsigned skip = 0;
+      size_t nframes = 0;
+      unsigned k = 0;
       OMX_BUFFERHEADERTYPE * p_out
         = get_header (p_prc, ARATELIA_FLAC_DECODER_OUTPUT_PORT_INDEX);
       assert (p_out);
 
-      if (nsamples * (p_prc->bps_ / 8) > p_out->nAllocLen)
+      if (p_prc->target_sample_ > ap_frame->header.number.sample_number)
         {
-          nsamples = p_out->nAllocLen / (p_prc->bps_ / 8);
+          skip = p_prc->target_sample_ - ap_frame->header.number.sample_number;
         }
-      assert (nsamples <= p_out->nAllocLen);
-
-      {
-        uint8_t * p_to = p_out->pBuffer + p_out->nOffset;
+      p_prc->target_sample_ = 0;
+      for (k = 0; k < ap_frame->header.channels; ++k)
+        {
+          channels[k] = ap_buffer[k] + skip;
+        }
+      nframes = ap_frame->header.blocksize - skip;
 
-        switch (ap_frame->header.bits_per_sample)
-          {
-            case 8:
-              {
-                write_pcm_block_8 (p_to, ap_buffer, nsamples,
-                                   ap_frame->header.channels);
-              }
-              break;
-            case 16:
-              {
-                write_pcm_block_16 (p_to, ap_buffer, nsamples,
-                                    ap_frame->header.channels);
-              }
-              break;
-            case 24:
-              {
-                write_pcm_block_24 (p_to, ap_buffer, nsamples,
-                                    ap_frame->header.channels);
-              }
-              break;
-            default:
-              {
-                assert (0);
-              }
-              break;
-          };
+      if (nframes * frame_len > p_out->nAllocLen)
+        {
+          nframes = p_out->nAllocLen / frame_len;
+        }
 
-        p_out->nFilledLen = nsamples * (p_prc->bps_ / 8);
+      {
+        write_pcm_block (p_out->pBuffer + p_out->nOffset, channels, nframes,
+                         ap_frame->header.channels, bps);
+        p_out->nFilledLen = nframes * frame_len;
         if ((p_prc->eos_ && p_prc->store_offset_ == 0))
           {
             /* Propagate EOS flag to output */
@@ -564,13 +659,46 @@ write_cb (const FLAC__StreamDecoder * ap_decoder, const FLAC__Frame * ap_frame,
   return rc;
 }
 
+static void
+update_pcm_mode (flacd_prc_t * ap_prc)
+{
+  OMX_AUDIO_PARAM_PCMMODETYPE pcmmode;
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+
+  assert (ap_prc);
+
+  /* Describe the samples as they are actually written to the output port:
+     native depth, little-endian. The stream's sampling rate may not be one
+     that the pcm port accepts, in which case the port keeps its settings */
+  TIZ_INIT_OMX_PORT_STRUCT (pcmmode, ARATELIA_FLAC_DECODER_OUTPUT_PORT_INDEX);
+  rc = tiz_api_GetParameter (tiz_get_krn (handleOf (ap_prc)),
+                             handleOf (ap_prc), OMX_IndexParamAudioPcm,
+                             &pcmmode);
+  if (OMX_ErrorNone == rc)
+    {
+      pcmmode.nSamplingRate = ap_prc->sample_rate_;
+      pcmmode.nChannels = ap_prc->channels_;
+      pcmmode.nBitPerSample = sample_width (ap_prc->bps_) * 8;
+      pcmmode.eNumData = OMX_NumericalDataSigned;
+      pcmmode.eEndian = OMX_EndianLittle;
+      rc = tiz_krn_SetParameter_internal (tiz_get_krn (handleOf (ap_prc)),
+                                          handleOf (ap_prc),
+                                          OMX_IndexParamAudioPcm, &pcmmode);
+    }
+
+  if (OMX_ErrorNone != rc)
+    {
+      TIZ_NOTICE (handleOf (ap_prc), "[%s] : Unable to update the pcm mode",
+                  tiz_err_to_str (rc));
+    }
+}
+
 static void
 metadata_cb (const FLAC__StreamDecoder * ap_decoder,
              const FLAC__StreamMetadata * ap_metadata, void * ap_client_data)
 {
   flacd_prc_t * p_prc = (flacd_prc_t *) ap_client_data;
 
-  (void) ap_decoder;
   assert (p_prc);
   assert (ap_metadata);
 
@@ -588,6 +716,34 @@ metadata_cb (const FLAC__StreamDecoder * ap_decoder,
       TIZ_TRACE (handleOf (p_prc), "bits per sample : [%u]", p_prc->bps_);
       TIZ_TRACE (handleOf (p_prc), "total samples   : [%llu]",
                  p_prc->total_samples_);
+
+      if (p_prc->bps_ >= 4 && p_prc->bps_ <= 32)
+        {
+          update_pcm_mode (p_prc);
+        }
+    }
+  else if (ap_metadata->type == FLAC__METADATA_TYPE_SEEKTABLE
+           && NULL == p_prc->p_seektable_)
+    {
+      p_prc->p_seektable_ = FLAC__metadata_object_clone (ap_metadata);
+      TIZ_TRACE (handleOf (p_prc), "seek points     : [%u]",
+                 ap_metadata->data.seek_table.num_points);
+    }
+
+  if (ap_metadata->is_last)
+    {
+      /* Seek table offsets are relative to the first frame, which follows
+         the last metadata block */
+      FLAC__uint64 pos = 0;
+      if (FLAC__stream_decoder_get_decode_position (ap_decoder, &pos))
+        {
+          p_prc->first_frame_pos_ = pos;
+        }
+      if (p_prc->sample_rate_ > 0)
+        {
+          /* Let the client know that this stream can be seeked */
+          (void) store_stream_position (p_prc, 0, p_prc->first_frame_pos_);
+        }
     }
 }
 
@@ -610,6 +766,17 @@ reset_stream_parameters (flacd_prc_t * ap_prc)
   ap_prc->sample_rate_ = 0;
   ap_prc->channels_ = 0;
   ap_prc->bps_ = 0;
+  if (ap_prc->p_seektable_)
+    {
+      FLAC__metadata_object_delete (ap_prc->p_seektable_);
+      ap_prc->p_seektable_ = NULL;
+    }
+  ap_prc->stream_pos_ = 0;
+  ap_prc->first_frame_pos_ = 0;
+  ap_prc->decode_pos_ = 0;
+  ap_prc->decoded_samples_ = 0;
+  ap_prc->target_sample_ = 0;
+  ap_prc->awaiting_start_ = false;
 }
 
 /*
@@ -630,6 +797,7 @@ flacd_prc_ctor (void * ap_obj, va_list * app)
   p_prc->p_store_ = NULL;
   p_prc->store_offset_ = 0;
   p_prc->store_size_ = 0;
+  p_prc->p_seektable_ = NULL;
   reset_stream_parameters (p_prc);
   return p_prc;
 }
@@ -674,6 +842,7 @@ flacd_prc_deallocate_resources (void * ap_obj)
       FLAC__stream_decoder_delete (p_prc->p_flac_dec_);
       p_prc->p_flac_dec_ = NULL;
     }
+  reset_stream_parameters (p_prc);
   dealloc_temp_data_store (p_prc);
   return OMX_ErrorNone;
 }
@@ -687,9 +856,11 @@ flacd_prc_prepare_to_transfer (void * ap_obj, OMX_U32 a_pid)
 
   if (p_prc->p_flac_dec_)
     {
+      (void) FLAC__stream_decoder_set_metadata_respond (
+        p_prc->p_flac_dec_, FLAC__METADATA_TYPE_SEEKTABLE);
       result = FLAC__stream_decoder_init_stream (
         p_prc->p_flac_dec_, read_cb, NULL, /* seek_callback */
-        NULL,                              /* tell_callback */
+        tell_cb,                           /* tell_callback */
         NULL,                              /* length_callback */
         NULL,                              /* eof_callback */
         write_cb, metadata_cb, error_cb, p_prc);
@@ -705,7 +876,9 @@ flacd_prc_prepare_to_transfer (void * ap_obj, OMX_U32 a_pid)
 
   reset_stream_parameters (p_prc);
   p_prc->store_offset_ = 0;
-  return OMX_ErrorNone;
+
+  /* Not seekable until the stream metadata has been parsed */
+  return store_stream_position (p_prc, -1, -1);
 }
 
 static OMX_ERRORTYPE
@@ -738,6 +911,75 @@ flacd_prc_buffers_ready (const void * ap_obj)
   return transform_stream (ap_obj);
 }
 
+static OMX_ERRORTYPE
+flacd_prc_port_flush (const void * ap_obj, OMX_U32 a_pid)
+{
+  flacd_prc_t * p_prc = (flacd_prc_t *) ap_obj;
+  assert (p_prc);
+  if (OMX_ALL == a_pid || ARATELIA_FLAC_DECODER_INPUT_PORT_INDEX == a_pid)
+    {
+      p_prc->store_offset_ = 0;
+    }
+  return release_all_headers (p_prc, a_pid);
+}
+
+static OMX_ERRORTYPE
+flacd_prc_config_change (void * ap_obj, OMX_U32 TIZ_UNUSED (a_pid),
+                         OMX_INDEXTYPE a_config_idx)
+{
+  flacd_prc_t * p_prc = ap_obj;
+  assert (p_prc);
+
+  if (OMX_TizoniaIndexConfigStreamPosition == a_config_idx
+      && p_prc->sample_rate_ > 0)
+    {
+      OMX_TIZONIA_STREAMPOSITIONTYPE position;
+      FLAC__int64 target = 0;
+      FLAC__uint64 sample = 0;
+      FLAC__uint64 offset = 0;
+
+      TIZ_INIT_OMX_STRUCT (position);
+      tiz_check_omx (tiz_api_GetConfig (tiz_get_krn (handleOf (p_prc)),
+                                        handleOf (p_prc),
+                                        OMX_TizoniaIndexConfigStreamPosition,
+                                        &position));
+
+      /* The request is relative to the current decoding position */
+      target = (FLAC__int64) p_prc->decoded_samples_
+               + position.nTimestamp * (FLAC__int64) p_prc->sample_rate_
+                   / 1000000;
+      target = MAX (target, 0);
+      if (p_prc->total_samples_ > 0
+          && (FLAC__uint64) target >= p_prc->total_samples_)
+        {
+          target = p_prc->total_samples_ - 1;
+        }
+
+      find_seek_point (p_prc, target, &sample, &offset);
+
+      TIZ_NOTICE (handleOf (p_prc),
+                  "seek target [%lld] seek point [%llu] offset [%llu]",
+                  (long long) target, (unsigned long long) sample,
+                  (unsigned long long) offset);
+
+      /* Drop the input until the source signals the new position */
+      p_prc->target_sample_ = target;
+      p_prc->awaiting_start_ = true;
+      p_prc->stream_pos_ = offset;
+      p_prc->store_offset_ = 0;
+      p_prc->eos_ = false;
+      tiz_check_omx (
+        release_all_headers (p_prc, ARATELIA_FLAC_DECODER_INPUT_PORT_INDEX));
+
+      tiz_check_omx (
+        store_stream_position (p_prc, samples_to_us (p_prc, sample), offset));
+      tiz_srv_issue_event ((OMX_PTR) p_prc, OMX_EventIndexSettingChanged,
+                           ARATELIA_FLAC_DECODER_INPUT_PORT_INDEX,
+                           OMX_TizoniaIndexConfigStreamPosition, NULL);
+    }
+  return OMX_ErrorNone;
+}
+
 /*
  * flacd_prc_class
  */
@@ -797,6 +1039,10 @@ flacd_prc_init (void * ap_tos, void * ap_hdl)
      tiz_srv_transfer_and_process, flacd_prc_transfer_and_process,
      /* TIZ_CLASS_COMMENT: */
      tiz_srv_stop_and_return, flacd_prc_stop_and_return,
+     /* TIZ_CLASS_COMMENT: */
+     tiz_prc_port_flush, flacd_prc_port_flush,
+     /* TIZ_CLASS_COMMENT: */
+     tiz_prc_config_change, flacd_prc_config_change,
      /* TIZ_CLASS_COMMENT: stop value */
      0);
 
@@ -56,6 +56,13 @@ struct flacd_prc
   OMX_U8 * p_store_;
   OMX_U32 store_offset_;
   OMX_U32 store_size_;
+  FLAC__StreamMetadata * p_seektable_;
+  FLAC__uint64 stream_pos_;
+  FLAC__uint64 first_frame_pos_;
+  FLAC__uint64 decode_pos_;
+  FLAC__uint64 decoded_samples_;
+  FLAC__uint64 target_sample_;
+  bool awaiting_start_;
 };
 
 typedef struct flacd_prc_class flacd_prc_class_t;
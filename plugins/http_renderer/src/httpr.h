@@ -51,6 +51,7 @@ extern "C" {
 #define ICE_DEFAULT_METADATA_INTERVAL 16000
 #define ICE_INITIAL_BURST_SIZE 128000
 #define ICE_MAX_CLIENTS_PER_MOUNTPOINT 10
+#define ICE_DEFAULT_MAX_LISTENER_LAG 5 /* seconds */
 #define ICE_DEFAULT_HEADER_TIMEOUT 10
 #define ICE_LISTEN_QUEUE 5
 #define ICE_MIN_BURST_SIZE 1400
@@ -58,6 +59,7 @@ extern "C" {
 #define ICE_MAX_BURST_SIZE 4200    /* Not used for now */
 #define ICE_LISTENER_BUF_SIZE \
   (ICE_MAX_BURST_SIZE + OMX_TIZONIA_MAX_SHOUTCAST_METADATA_SIZE)
+#define ICE_LISTENER_MAX_IOVECS 4
 
 #define ICE_SOCK_ERROR (int) -1
 
@@ -25,6 +25,13 @@
  *
  * NOTE: This is work in progress!!!!
  *
+ * The server fans out each encoded OMX buffer to all the connected
+ * listeners. Every listener keeps its own read cursor into the shared buffer,
+ * and the buffer is returned to the processor only once the slowest listener
+ * has consumed it (or that listener has been dropped because it lagged behind
+ * the others for longer than the configured limit). Data is paced by a single
+ * server-wide timer.
+ *
  * TODO: Better flow control
  *
  */
@@ -35,12 +42,14 @@
 
 #include <assert.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdbool.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <netinet/tcp.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <netdb.h>
 #include <string.h>
 #include <errno.h>
@@ -71,11 +80,14 @@ typedef struct httpr_listener httpr_listener_t;
 typedef struct httpr_listener_buffer httpr_listener_buffer_t;
 typedef struct httpr_mount httpr_mount_t;
 
+/* Used for the HTTP request/response exchange and, once streaming, to hold
+   the listener's pending ICY metadata block. Audio data is never copied
+   here; it is sent straight from the shared OMX buffer. */
 struct httpr_listener_buffer
 {
   unsigned int len;
-  unsigned int metadata_offset;
-  unsigned int metadata_bytes;
+  unsigned int metadata_offset; /* next metadata byte to be sent */
+  unsigned int metadata_bytes;  /* metadata bytes still to be sent */
   char * p_data;
 };
 
@@ -97,6 +109,8 @@ struct httpr_connection
   httpr_listener_t * p_lstnr;
   time_t con_time;
   uint64_t sent_total;
+  uint64_t next_metadata_pos; /* audio byte count where the next ICY metadata
+                                 block is due */
   unsigned int sent_last;
   unsigned int burst_bytes;
   OMX_S32 initial_burst_bytes;
@@ -106,7 +120,6 @@ struct httpr_connection
   char * p_ip;
   unsigned short port;
   tiz_event_io_t * p_ev_io;
-  tiz_event_timer_t * p_ev_timer;
 };
 
 struct httpr_listener
@@ -115,11 +128,10 @@ struct httpr_listener
   httpr_connection_t * p_con;
   int respcode;
   long intro_offset;
-  unsigned long pos;
+  unsigned long pos; /* This listener's read cursor into the shared buffer */
   httpr_listener_buffer_t buf;
   tiz_http_parser_t * p_parser;
   bool need_response;
-  bool timer_started;
   bool want_metadata;
 };
 
@@ -129,10 +141,17 @@ struct httpr_server
   int lstn_sockfd;
   char * p_ip;
   tiz_event_io_t * p_srv_ev_io;
-  OMX_U32 max_clients; /* In future, more than one will be allowed;
-                          only one allowed at the moment. */
+  tiz_event_timer_t * p_srv_ev_timer;
+  bool timer_started;
+  OMX_U32 max_clients;
   tiz_map_t * p_lstnrs;
-  OMX_BUFFERHEADERTYPE * p_hdr;
+  OMX_BUFFERHEADERTYPE * p_hdr; /* The buffer shared by all listeners */
+  time_t hdr_stall_time;        /* When the first listener finished with the
+                                   shared buffer, while others still had data
+                                   pending */
+  OMX_U32 max_lag;              /* Seconds a listener is allowed to hold the
+                                   shared buffer on its own, before being
+                                   dropped; zero means never drop */
   httpr_srv_release_buffer_f pf_release_buf;
   httpr_srv_acquire_buffer_f pf_acquire_buf;
   bool need_more_data;
@@ -233,15 +252,40 @@ srv_get_listeners_count (const httpr_server_t * ap_server)
   return rc;
 }
 
-static httpr_listener_t *
-srv_get_first_listener (const httpr_server_t * ap_server)
+static OMX_U32
+srv_get_max_listener_lag (void)
 {
-  httpr_listener_t * p_lstnr = NULL;
-  if (srv_get_listeners_count (ap_server) > 0)
+  OMX_U32 max_lag = ICE_DEFAULT_MAX_LISTENER_LAG;
+  const char * p_max_lag = tiz_rcfile_get_value (
+    TIZ_RCFILE_PLUGINS_DATA_SECTION,
+    "OMX.Aratelia.audio_renderer.http.max_listener_lag");
+  if (p_max_lag)
+    {
+      max_lag = strtoul (p_max_lag, NULL, 10);
+    }
+  return max_lag;
+}
+
+static inline httpr_listener_t *
+srv_get_listener_at (const httpr_server_t * ap_server, const int a_pos)
+{
+  assert (ap_server);
+  assert (ap_server->p_lstnrs);
+  return tiz_map_value_at (ap_server->p_lstnrs, a_pos);
+}
+
+static inline OMX_U32
+srv_get_max_clients (const httpr_server_t * ap_server)
+{
+  OMX_U32 max_clients = 0;
+  assert (ap_server);
+  max_clients = ap_server->max_clients;
+  if (ap_server->mountpoint.max_clients > 0
+      && ap_server->mountpoint.max_clients < max_clients)
     {
-      p_lstnr = tiz_map_value_at (ap_server->p_lstnrs, 0);
+      max_clients = ap_server->mountpoint.max_clients;
     }
-  return p_lstnr;
+  return max_clients;
 }
 
 static int
@@ -491,39 +535,46 @@ srv_stop_listener_io_watcher (httpr_listener_t * ap_lstnr)
 }
 
 static OMX_ERRORTYPE
-srv_start_listener_timer_watcher (httpr_listener_t * ap_lstnr,
-                                  const double a_wait_time)
+srv_start_server_timer_watcher (httpr_server_t * ap_server)
 {
   OMX_ERRORTYPE rc = OMX_ErrorNone;
-  assert (ap_lstnr);
-  if (!ap_lstnr->timer_started)
+  assert (ap_server);
+  if (!ap_server->timer_started)
     {
-      assert (ap_lstnr->p_server);
-      assert (ap_lstnr->p_con);
       tiz_check_omx (tiz_srv_timer_watcher_start (
-        ap_lstnr->p_server->p_parent, ap_lstnr->p_con->p_ev_timer, a_wait_time,
-        a_wait_time));
-      ap_lstnr->timer_started = true;
+        ap_server->p_parent, ap_server->p_srv_ev_timer, ap_server->wait_time,
+        ap_server->wait_time));
+      ap_server->timer_started = true;
     }
   return rc;
 }
 
 static OMX_ERRORTYPE
-srv_stop_listener_timer_watcher (httpr_listener_t * ap_lstnr)
+srv_stop_server_timer_watcher (httpr_server_t * ap_server)
 {
   OMX_ERRORTYPE rc = OMX_ErrorNone;
-  assert (ap_lstnr);
-  if (ap_lstnr->timer_started)
+  assert (ap_server);
+  if (ap_server->timer_started)
     {
-      assert (ap_lstnr->p_server);
-      assert (ap_lstnr->p_con);
-      tiz_check_omx (tiz_srv_timer_watcher_stop (
-        ap_lstnr->p_server->p_parent, ap_lstnr->p_con->p_ev_timer));
-      ap_lstnr->timer_started = false;
+      tiz_check_omx (tiz_srv_timer_watcher_stop (ap_server->p_parent,
+                                                 ap_server->p_srv_ev_timer));
+      ap_server->timer_started = false;
     }
   return rc;
 }
 
+static inline OMX_ERRORTYPE
+srv_restart_server_timer_watcher (httpr_server_t * ap_server)
+{
+  assert (ap_server);
+  if (ap_server->timer_started)
+    {
+      tiz_check_omx (srv_stop_server_timer_watcher (ap_server));
+      tiz_check_omx (srv_start_server_timer_watcher (ap_server));
+    }
+  return OMX_ErrorNone;
+}
+
 static void
 srv_destroy_connection (httpr_connection_t * ap_con)
 {
@@ -538,8 +589,6 @@ srv_destroy_connection (httpr_connection_t * ap_con)
       assert (ap_con->p_lstnr && ap_con->p_lstnr->p_server);
       tiz_srv_io_watcher_destroy (ap_con->p_lstnr->p_server->p_parent,
                                   ap_con->p_ev_io);
-      tiz_srv_timer_watcher_destroy (ap_con->p_lstnr->p_server->p_parent,
-                                     ap_con->p_ev_timer);
       tiz_mem_free (ap_con);
     }
 }
@@ -549,7 +598,6 @@ srv_destroy_listener (httpr_listener_t * ap_lstnr)
 {
   if (ap_lstnr)
     {
-      srv_stop_listener_timer_watcher (ap_lstnr);
       if (ap_lstnr->p_parser)
         {
           tiz_http_parser_destroy (ap_lstnr->p_parser);
@@ -604,6 +652,7 @@ srv_create_connection (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr,
   p_con->p_lstnr = ap_lstnr;
   p_con->con_time = 0; /* time (NULL); */
   p_con->sent_total = 0;
+  p_con->next_metadata_pos = ap_server->mountpoint.metadata_period;
   p_con->sent_last = 0;
   p_con->burst_bytes = 0;
   p_con->initial_burst_bytes = ap_server->mountpoint.initial_burst_size;
@@ -612,7 +661,6 @@ srv_create_connection (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr,
   p_con->p_ip = ap_ip;
   p_con->port = ap_port;
   p_con->p_ev_io = NULL;
-  p_con->p_ev_timer = NULL;
 
   /* We are interested in knowing when a listener socket is available for
    * writing */
@@ -620,9 +668,6 @@ srv_create_connection (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr,
                                 p_con->sockfd, TIZ_EVENT_WRITE, true);
   goto_end_on_omx_error (rc, p_hdl, "Unable to init the client's io event");
 
-  rc = tiz_srv_timer_watcher_init (ap_server->p_parent, &(p_con->p_ev_timer));
-  goto_end_on_omx_error (rc, p_hdl, "Unable to init the client's timer event");
-
 end:
   if (OMX_ErrorNone != rc)
     {
@@ -669,7 +714,6 @@ srv_create_listener (httpr_server_t * ap_server, httpr_listener_t ** app_lstnr,
   p_lstnr->buf.metadata_bytes = 0;
   p_lstnr->p_parser = NULL;
   p_lstnr->need_response = true;
-  p_lstnr->timer_started = false;
   p_lstnr->want_metadata = false;
 
   p_lstnr->buf.p_data = (char *) tiz_mem_alloc (ICE_LISTENER_BUF_SIZE);
@@ -945,7 +989,8 @@ srv_handle_listeners_request (httpr_server_t * ap_server,
   assert (ap_lstnr->p_con);
   assert (ap_lstnr->p_parser);
 
-  some_error = (srv_get_listeners_count (ap_server) > ap_server->max_clients);
+  some_error
+    = (srv_get_listeners_count (ap_server) > srv_get_max_clients (ap_server));
   bail_on_request_error (some_error, 400, "Client limit reached");
 
   /*   some_error */
@@ -1008,269 +1053,259 @@ end:
   return rc;
 }
 
-static OMX_S32
-srv_remove_existing_listener (OMX_PTR ap_key, OMX_PTR ap_value, OMX_PTR ap_arg)
+static inline bool
+srv_is_buffer_consumed (const httpr_server_t * ap_server,
+                        const httpr_listener_t * ap_lstnr)
 {
-  httpr_server_t * p_server = ap_arg;
-  httpr_listener_t * p_lstnr = NULL;
-
-  assert (p_server);
-  assert (ap_key);
-  assert (ap_value);
-
-  p_lstnr = (httpr_listener_t *) ap_value;
-
-  srv_remove_listener (p_server, p_lstnr);
-
-  return 0;
+  assert (ap_server);
+  assert (ap_lstnr);
+  return (!ap_server->p_hdr || ap_lstnr->pos >= ap_server->p_hdr->nFilledLen);
 }
 
-inline static void
-srv_release_empty_buffer (httpr_server_t * ap_server,
-                          httpr_listener_t * ap_lstnr,
-                          OMX_BUFFERHEADERTYPE ** app_hdr)
+static inline bool
+srv_is_burst_complete (const httpr_server_t * ap_server,
+                       const httpr_listener_t * ap_lstnr)
 {
-  OMX_BUFFERHEADERTYPE * p_hdr = NULL;
-
   assert (ap_server);
   assert (ap_lstnr);
-  assert (app_hdr);
+  assert (ap_lstnr->p_con);
+  return ((ap_lstnr->p_con->initial_burst_bytes <= 0)
+          && (ap_lstnr->p_con->burst_bytes >= ap_server->burst_size));
+}
 
-  p_hdr = *app_hdr;
+static void
+srv_reset_listener_cursors (httpr_server_t * ap_server)
+{
+  int i = 0;
+  assert (ap_server);
+  for (i = 0; i < srv_get_listeners_count (ap_server); ++i)
+    {
+      srv_get_listener_at (ap_server, i)->pos = 0;
+    }
+}
 
-  ap_lstnr->pos = 0;
-  p_hdr->nFilledLen = 0;
-  ap_server->pf_release_buf (p_hdr, ap_server->p_arg);
-  *app_hdr = NULL;
-  ap_server->p_hdr = NULL;
+static void
+srv_release_shared_buffer (httpr_server_t * ap_server)
+{
+  assert (ap_server);
+  if (ap_server->p_hdr)
+    {
+      OMX_BUFFERHEADERTYPE * p_hdr = ap_server->p_hdr;
+      ap_server->p_hdr = NULL;
+      ap_server->hdr_stall_time = 0;
+      srv_reset_listener_cursors (ap_server);
+      p_hdr->nFilledLen = 0;
+      ap_server->pf_release_buf (p_hdr, ap_server->p_arg);
+    }
 }
 
 static bool
-srv_is_listener_ready (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr)
+srv_acquire_shared_buffer (httpr_server_t * ap_server)
 {
-  bool lstnr_ready = true;
-  OMX_HANDLETYPE p_hdl = NULL;
+  assert (ap_server);
+  if (!ap_server->p_hdr)
+    {
+      ap_server->p_hdr = ap_server->pf_acquire_buf (ap_server->p_arg);
+      if (ap_server->p_hdr)
+        {
+          ap_server->hdr_stall_time = 0;
+          srv_reset_listener_cursors (ap_server);
+        }
+    }
+  ap_server->need_more_data = (NULL == ap_server->p_hdr);
+  return (NULL != ap_server->p_hdr);
+}
+
+static OMX_ERRORTYPE
+srv_check_listener_ready (httpr_server_t * ap_server,
+                          httpr_listener_t * ap_lstnr)
+{
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
   assert (ap_server);
   assert (ap_lstnr);
-  p_hdl = handleOf (ap_server->p_parent);
 
   if (ap_lstnr->need_response)
     {
-      OMX_ERRORTYPE rc = OMX_ErrorNone;
       if (OMX_ErrorNone
           != (rc = srv_handle_listeners_request (ap_server, ap_lstnr)))
         {
           if (OMX_ErrorNotReady == rc)
             {
-              TIZ_ERROR (p_hdl, "no data yet lets wait some time ");
+              TIZ_ERROR (handleOf (ap_server->p_parent),
+                         "no data yet lets wait some time ");
               (void) srv_start_listener_io_watcher (ap_lstnr);
             }
           else
             {
-              TIZ_ERROR (p_hdl,
+              TIZ_ERROR (handleOf (ap_server->p_parent),
                          "[%s] : while handling the "
                          "listener's initial request. Will remove the listener",
                          tiz_err_to_str (rc));
-              srv_remove_listener (ap_server, ap_lstnr);
+              /* Signal the caller that this listener must be removed */
+              rc = OMX_ErrorNoMore;
             }
-          lstnr_ready = false;
         }
     }
-  return lstnr_ready;
+  return rc;
 }
 
 static inline bool
-srv_is_time_to_send_metadata (httpr_server_t * ap_server,
-                              httpr_listener_t * ap_lstnr)
-{
-  if (ap_lstnr->p_con->sent_total == 0)
-    {
-      return false;
-    }
-
-  if (((ap_lstnr->p_con->sent_total + ap_server->burst_size)
-       % ap_server->mountpoint.metadata_period)
-      <= ap_server->burst_size)
-    {
-      return true;
-    }
-
-  return false;
-}
-
-static inline size_t
-srv_get_metadata_offset (const httpr_server_t * ap_server,
-                         const httpr_listener_t * ap_lstnr)
-{
-  size_t offset = 0;
-  if (ap_lstnr->p_con->sent_total != 0)
-    {
-      offset = (ap_server->mountpoint.metadata_period
-                * ((ap_lstnr->p_con->sent_total + ap_server->burst_size)
-                   / ap_server->mountpoint.metadata_period))
-               - ap_lstnr->p_con->sent_total;
-    }
-
-  return offset;
-}
-
-static inline size_t
-srv_get_metadata_length (const httpr_server_t * ap_server,
+srv_is_metadata_enabled (const httpr_server_t * ap_server,
                          const httpr_listener_t * ap_lstnr)
 {
-  if (ap_lstnr->p_con->sent_total == 0 || ap_lstnr->p_con->metadata_delivered)
-    {
-      return 0;
-    }
-
-  return strnlen ((char *) ap_server->mountpoint.stream_title,
-                  OMX_TIZONIA_MAX_SHOUTCAST_METADATA_SIZE);
+  assert (ap_server);
+  assert (ap_lstnr);
+  return (ap_lstnr->want_metadata && ap_server->mountpoint.metadata_period > 0);
 }
 
-static void
-srv_arrange_metadata (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr,
-                      OMX_U8 ** app_buffer, size_t * ap_len)
+static size_t
+srv_build_metadata_block (httpr_server_t * ap_server,
+                          httpr_listener_t * ap_lstnr)
 {
-  size_t len = 0;
   httpr_listener_buffer_t * p_lstnr_buf = NULL;
+  size_t metadata_len = 0;
+  size_t metadata_byte = 0;
+  size_t metadata_total = 0;
 
   assert (ap_server);
   assert (ap_lstnr);
-  assert (app_buffer);
-  assert (ap_len);
+  assert (ap_lstnr->p_con);
 
-  len = *ap_len;
   p_lstnr_buf = &ap_lstnr->buf;
 
-  if (0 == len || !ap_lstnr->want_metadata
-      || 0 == ap_server->mountpoint.metadata_period
-      || !srv_is_time_to_send_metadata (ap_server, ap_lstnr))
+  if (!ap_lstnr->p_con->metadata_delivered)
     {
-      /* p_lstnr_buf->metadata_bytes = 0; */
-      return;
+      metadata_len
+        = strnlen ((char *) ap_server->mountpoint.stream_title,
+                   OMX_TIZONIA_MAX_SHOUTCAST_METADATA_SIZE);
     }
 
-  {
-    OMX_U8 * p_buffer = *app_buffer;
-    size_t metadata_offset = srv_get_metadata_offset (ap_server, ap_lstnr);
+  /* The length byte counts 16-byte blocks */
+  metadata_byte = (metadata_len / 16) + ((metadata_len % 16) ? 1 : 0);
+  metadata_total = (metadata_byte * 16) + 1;
+  assert (metadata_total <= ICE_LISTENER_BUF_SIZE);
 
-    if (metadata_offset < len && 0 == p_lstnr_buf->metadata_bytes)
-      {
-        OMX_U8 * p_dest = NULL;
-        OMX_U8 * p_src = NULL;
-        size_t metadata_len = srv_get_metadata_length (ap_server, ap_lstnr);
-        size_t metadata_total = 0;
-        size_t metadata_byte = 0;
-
-        if (metadata_len > 0)
-          {
-            metadata_byte = metadata_len / 16;
-            if (metadata_len % 16)
-              {
-                metadata_byte++;
-              }
-          }
-        else
-          {
-            metadata_byte = 0;
-          }
-
-        metadata_total = (metadata_byte * 16) + 1;
-        p_dest = p_buffer + metadata_offset + metadata_total;
-        p_src = p_buffer + metadata_offset;
-
-        /* Move content to make space for the metadata */
-        memmove (p_dest, p_src, len - metadata_offset);
-
-        p_lstnr_buf->metadata_bytes += metadata_total;
-        p_lstnr_buf->metadata_offset += metadata_offset;
-
-        if (metadata_len)
-          {
-            snprintf ((char *) p_src, metadata_total, "%c%s",
-                      (int) metadata_byte,
-                      (char *) ap_server->mountpoint.stream_title);
-            ap_lstnr->p_con->metadata_delivered = true;
-          }
-        else
-          {
-            p_src[0] = metadata_byte;
-          }
+  tiz_mem_set (p_lstnr_buf->p_data, 0, metadata_total);
+  p_lstnr_buf->p_data[0] = (char) metadata_byte;
+  if (metadata_len)
+    {
+      memcpy (p_lstnr_buf->p_data + 1, ap_server->mountpoint.stream_title,
+              metadata_len);
+      ap_lstnr->p_con->metadata_delivered = true;
+    }
 
-        len += metadata_total;
-        p_lstnr_buf->len = len;
+  p_lstnr_buf->metadata_offset = 0;
+  p_lstnr_buf->metadata_bytes = metadata_total;
+  ap_lstnr->p_con->next_metadata_pos += ap_server->mountpoint.metadata_period;
 
-        *ap_len = len;
-        *app_buffer = p_buffer;
-      }
-  }
+  return metadata_total;
 }
 
-static void
-srv_arrange_data (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr,
-                  OMX_U8 ** app_buffer, size_t * ap_len)
+static int
+srv_arrange_iovecs (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr,
+                    struct iovec * ap_iov, bool * ap_metadata_built)
 {
-  OMX_U8 * p_buffer = NULL;
-  size_t len = 0;
   httpr_listener_buffer_t * p_lstnr_buf = NULL;
+  httpr_connection_t * p_con = NULL;
   OMX_BUFFERHEADERTYPE * p_hdr = NULL;
+  OMX_U8 * p_audio = NULL;
+  size_t budget = 0;
+  size_t audio_len = 0;
+  int niov = 0;
 
   assert (ap_server);
   assert (ap_lstnr);
-  assert (app_buffer);
-  assert (ap_len);
+  assert (ap_iov);
+  assert (ap_metadata_built);
 
   p_lstnr_buf = &ap_lstnr->buf;
+  p_con = ap_lstnr->p_con;
   p_hdr = ap_server->p_hdr;
+  *ap_metadata_built = false;
+
+  /* Audio bytes this listener may be sent with this call; these point
+     straight into the shared OMX buffer */
+  if (p_hdr && p_hdr->pBuffer && p_hdr->nFilledLen > ap_lstnr->pos)
+    {
+      p_audio = p_hdr->pBuffer + p_hdr->nOffset + ap_lstnr->pos;
+      budget = MIN (ap_server->burst_size, p_hdr->nFilledLen - ap_lstnr->pos);
+    }
 
-  if (p_hdr && p_hdr->pBuffer && p_hdr->nFilledLen > 0)
+  if (budget > 0 && 0 == p_lstnr_buf->metadata_bytes
+      && srv_is_metadata_enabled (ap_server, ap_lstnr)
+      && p_con->sent_total >= p_con->next_metadata_pos)
     {
-      int to_copy = 0;
-      if (ap_server->burst_size > p_lstnr_buf->len)
+      /* The metadata interval was reached exactly with the previous call */
+      (void) srv_build_metadata_block (ap_server, ap_lstnr);
+      *ap_metadata_built = true;
+    }
+
+  /* A pending metadata block must be completed before any more audio */
+  if (p_lstnr_buf->metadata_bytes > 0)
+    {
+      ap_iov[niov].iov_base = p_lstnr_buf->p_data + p_lstnr_buf->metadata_offset;
+      ap_iov[niov].iov_len = p_lstnr_buf->metadata_bytes;
+      ++niov;
+    }
+
+  if (budget > 0)
+    {
+      audio_len = budget;
+      if (srv_is_metadata_enabled (ap_server, ap_lstnr))
         {
-          to_copy = ap_server->burst_size - p_lstnr_buf->len;
+          assert (p_con->next_metadata_pos > p_con->sent_total);
+          audio_len = MIN (budget, p_con->next_metadata_pos - p_con->sent_total);
         }
-      if (to_copy > p_hdr->nFilledLen)
+
+      ap_iov[niov].iov_base = p_audio;
+      ap_iov[niov].iov_len = audio_len;
+      ++niov;
+
+      if (audio_len < budget && 0 == p_lstnr_buf->metadata_bytes)
         {
-          to_copy = p_hdr->nFilledLen;
+          /* The next metadata interval falls within this slice: interleave
+             the metadata block and the rest of the audio in the same call */
+          size_t rest = MIN (budget - audio_len,
+                             ap_server->mountpoint.metadata_period);
+          ap_iov[niov].iov_base = p_lstnr_buf->p_data;
+          ap_iov[niov].iov_len = srv_build_metadata_block (ap_server, ap_lstnr);
+          ++niov;
+          ap_iov[niov].iov_base = p_audio + audio_len;
+          ap_iov[niov].iov_len = rest;
+          ++niov;
+          *ap_metadata_built = true;
         }
-      memcpy (p_lstnr_buf->p_data + p_lstnr_buf->len,
-              p_hdr->pBuffer + p_hdr->nOffset, to_copy);
-      p_lstnr_buf->len += to_copy;
-      p_hdr->nFilledLen -= to_copy;
-      p_hdr->nOffset += to_copy;
     }
 
-  p_buffer = (OMX_U8 *) p_lstnr_buf->p_data;
-  len = p_lstnr_buf->len;
-
-  srv_arrange_metadata (ap_server, ap_lstnr, &p_buffer, &len);
-
-  *ap_len = len;
-  *app_buffer = p_buffer;
+  return niov;
 }
 
 static OMX_ERRORTYPE
 srv_write_to_listener (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr,
-                       const void * ap_buffer, const size_t a_buf_len,
+                       const struct iovec * ap_iov, const int a_niov,
                        int * a_bytes_written)
 {
   OMX_ERRORTYPE rc = OMX_ErrorNone;
-  int bytes = 0;
+  ssize_t bytes = 0;
   httpr_connection_t * p_con = NULL;
   int sock = ICE_SOCK_ERROR;
+  struct msghdr msg;
 
   assert (ap_server);
   assert (ap_lstnr);
-  assert (ap_buffer);
+  assert (ap_iov);
   assert (a_bytes_written);
 
   p_con = ap_lstnr->p_con;
   sock = p_con->sockfd;
   *a_bytes_written = 0;
-  errno = 0;
 
-  bytes = send (sock, (const void *) ap_buffer, a_buf_len, MSG_NOSIGNAL);
+  tiz_mem_set (&msg, 0, sizeof (msg));
+  msg.msg_iov = (struct iovec *) ap_iov;
+  msg.msg_iovlen = a_niov;
+
+  errno = 0;
+  bytes = sendmsg (sock, &msg, MSG_NOSIGNAL);
 
   if (bytes < 0)
     {
@@ -1288,7 +1323,6 @@ srv_write_to_listener (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr,
             "Recoverable error while writing to the socket"
             "(re-starting io watcher)\n");
           (void) srv_start_listener_io_watcher (ap_lstnr);
-          (void) srv_stop_listener_timer_watcher (ap_lstnr);
           rc = OMX_ErrorNotReady;
         }
     }
@@ -1299,6 +1333,77 @@ srv_write_to_listener (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr,
   return rc;
 }
 
+static void
+srv_account_written_bytes (httpr_server_t * ap_server,
+                           httpr_listener_t * ap_lstnr,
+                           const struct iovec * ap_iov, const int a_niov,
+                           const bool a_metadata_built, size_t a_bytes)
+{
+  httpr_listener_buffer_t * p_lstnr_buf = NULL;
+  httpr_connection_t * p_con = NULL;
+  size_t audio_sent = 0;
+  int i = 0;
+
+  assert (ap_server);
+  assert (ap_lstnr);
+  assert (ap_iov);
+
+  p_lstnr_buf = &ap_lstnr->buf;
+  p_con = ap_lstnr->p_con;
+
+  for (i = 0; i < a_niov; ++i)
+    {
+      const size_t chunk = MIN (a_bytes, ap_iov[i].iov_len);
+      const bool is_metadata
+        = (ap_iov[i].iov_base >= (void *) p_lstnr_buf->p_data
+           && ap_iov[i].iov_base
+                < (void *) (p_lstnr_buf->p_data + ICE_LISTENER_BUF_SIZE));
+
+      if (is_metadata)
+        {
+          if (0 == chunk && a_metadata_built)
+            {
+              /* The socket did not even reach the metadata interval; forget
+                 about the block, it will be re-built next time */
+              p_lstnr_buf->metadata_bytes = 0;
+              p_con->next_metadata_pos -= ap_server->mountpoint.metadata_period;
+              if (p_lstnr_buf->p_data[0] != 0)
+                {
+                  p_con->metadata_delivered = false;
+                }
+            }
+          else
+            {
+              p_lstnr_buf->metadata_offset += chunk;
+              p_lstnr_buf->metadata_bytes -= chunk;
+            }
+        }
+      else
+        {
+          audio_sent += chunk;
+        }
+      a_bytes -= chunk;
+    }
+
+  ap_lstnr->pos += audio_sent;
+
+  if (p_con->initial_burst_bytes > 0)
+    {
+      p_con->initial_burst_bytes -= audio_sent;
+    }
+  else
+    {
+      if (p_con->con_time == 0)
+        {
+          p_con->con_time = time (NULL);
+        }
+    }
+
+  p_con->sent_total += audio_sent;
+  p_con->sent_last = audio_sent;
+  p_con->burst_bytes += audio_sent;
+}
+
 static OMX_ERRORTYPE
 srv_write_omx_buffer (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr)
 {
@@ -1326,51 +1431,32 @@ srv_write_omx_buffer (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr)
     }
   else
     {
-      httpr_listener_buffer_t * p_lstnr_buf = &ap_lstnr->buf;
-      OMX_U8 * p_buffer = NULL;
+      struct iovec iov[ICE_LISTENER_MAX_IOVECS];
+      bool metadata_built = false;
       size_t len = 0;
+      int niov = 0;
       int bytes = 0;
+      int i = 0;
 
-      /* Obtain a pointer to the data and the amount of data to be written */
-      srv_arrange_data (ap_server, ap_lstnr, &p_buffer, &len);
+      /* Point the io vectors at the audio in the shared buffer and at this
+         listener's metadata block; nothing gets copied */
+      niov = srv_arrange_iovecs (ap_server, ap_lstnr, iov, &metadata_built);
+      for (i = 0; i < niov; ++i)
+        {
+          len += iov[i].iov_len;
+        }
 
       if (len > 0)
         {
-          int metadata_sent = 0;
-          tiz_check_omx (
-            srv_write_to_listener (ap_server, ap_lstnr, p_buffer, len, &bytes));
-          assert (bytes >= 0);
-
-          p_lstnr_buf->len
-            = bytes > p_lstnr_buf->len ? 0 : (p_lstnr_buf->len - bytes);
-
-          if (p_lstnr_buf->len > 0)
+          rc = srv_write_to_listener (ap_server, ap_lstnr, iov, niov, &bytes);
+          if (OMX_ErrorNone != rc || bytes < 0)
             {
-              memmove (p_lstnr_buf->p_data, p_lstnr_buf->p_data + bytes,
-                       p_lstnr_buf->len);
+              bytes = 0;
             }
 
-          if (bytes > p_lstnr_buf->metadata_offset)
-            {
-              metadata_sent = MIN ((bytes - p_lstnr_buf->metadata_offset),
-                                   p_lstnr_buf->metadata_bytes);
-            }
-
-          if (p_con->initial_burst_bytes > 0)
-            {
-              p_con->initial_burst_bytes -= (bytes - metadata_sent);
-            }
-          else
-            {
-              if (p_con->con_time == 0)
-                {
-                  p_con->con_time = time (NULL);
-                }
-            }
-
-          p_con->sent_total += (bytes - metadata_sent);
-          p_con->sent_last = (bytes - metadata_sent);
-          p_con->burst_bytes += (bytes - metadata_sent);
+          srv_account_written_bytes (ap_server, ap_lstnr, iov, niov,
+                                     metadata_built, bytes);
+          tiz_check_omx (rc);
 
           {
             time_t t = time (NULL);
@@ -1383,39 +1469,13 @@ srv_write_omx_buffer (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr)
               ap_server->burst_size, bytes);
           }
 
-          TIZ_PRINTF_DBG_GRN (
-            "metadata_bytes [%u] < metadata_offset [%u] metadata_sent [%u]\n",
-            p_lstnr_buf->metadata_bytes, p_lstnr_buf->metadata_offset,
-            metadata_sent);
-
-          p_lstnr_buf->metadata_bytes -= metadata_sent;
-          if (p_lstnr_buf->metadata_offset > 0 && p_lstnr_buf->metadata_bytes)
+          if ((size_t) bytes < len)
             {
-              p_lstnr_buf->metadata_offset -= ((unsigned int) bytes);
-            }
-          else
-            {
-              p_lstnr_buf->metadata_offset = 0;
-            }
-
-          if (bytes < len)
-            {
-              TIZ_PRINTF_DBG_RED (
-                "NEED TO STOP bytes [%d] < len [%u] p_lstnr_buf->len [%u]\n",
-                bytes, len, p_lstnr_buf->len);
+              TIZ_PRINTF_DBG_RED ("NEED TO STOP bytes [%d] < len [%zu]\n",
+                                  bytes, len);
               (void) srv_start_listener_io_watcher (ap_lstnr);
-              (void) srv_stop_listener_timer_watcher (ap_lstnr);
               rc = OMX_ErrorNotReady;
             }
-          else
-            {
-              if ((p_con->initial_burst_bytes <= 0)
-                  && (p_con->burst_bytes >= ap_server->burst_size))
-                {
-                  rc = srv_start_listener_timer_watcher (ap_lstnr,
-                                                         ap_server->wait_time);
-                }
-            }
         }
     }
 
@@ -1436,14 +1496,6 @@ srv_accept_connection (httpr_server_t * ap_server)
   assert (ap_server);
   p_hdl = handleOf (ap_server->p_parent);
 
-  if (srv_get_listeners_count (ap_server) > 0)
-    {
-      /* This is a simple solution to prevent more than one connection at
-       * a time. One day this could be a multi-client renderer */
-      tiz_map_for_each (ap_server->p_lstnrs, srv_remove_existing_listener,
-                        ap_server);
-    }
-
   if ((p_ip = (char *) tiz_mem_alloc (ICE_RENDERER_MAX_ADDR_LEN)))
     {
       unsigned short port = 0;
@@ -1526,90 +1578,176 @@ end:
 }
 
 static OMX_ERRORTYPE
-srv_write (httpr_server_t * ap_server)
+srv_write_to_listener_burst (httpr_server_t * ap_server,
+                             httpr_listener_t * ap_lstnr)
 {
   OMX_ERRORTYPE rc = OMX_ErrorNone;
-  OMX_BUFFERHEADERTYPE * p_hdr = NULL;
-  httpr_listener_t * p_lstnr = NULL;
-  httpr_connection_t * p_con = NULL;
 
   assert (ap_server);
+  assert (ap_lstnr);
 
-  if (srv_get_listeners_count (ap_server) <= 0)
+  /* Keep writing until this listener has reached its burst limit, its socket
+     is not accepting more data, or it has consumed the shared buffer */
+  while (OMX_ErrorNone == rc && !srv_is_burst_complete (ap_server, ap_lstnr)
+         && (ap_lstnr->buf.metadata_bytes > 0
+             || !srv_is_buffer_consumed (ap_server, ap_lstnr)))
     {
-      return OMX_ErrorNoMore;
+      rc = srv_write_omx_buffer (ap_server, ap_lstnr);
     }
 
-  /* Until support for multiple listeners gets implemented, there will only be
-     one listener in the map */
-  p_lstnr = srv_get_first_listener (ap_server);
-  assert (p_lstnr);
-  p_con = p_lstnr->p_con;
-  assert (p_con);
+  return rc;
+}
 
-  srv_stop_listener_io_watcher (p_lstnr);
-  if (!srv_is_listener_ready (ap_server, p_lstnr))
+static OMX_S32
+srv_drop_lagging_listeners (httpr_server_t * ap_server)
+{
+  OMX_S32 dropped = 0;
+  int i = 0;
+
+  assert (ap_server);
+
+  for (i = srv_get_listeners_count (ap_server) - 1; i >= 0; --i)
     {
-      return OMX_ErrorNotReady;
+      httpr_listener_t * p_lstnr = srv_get_listener_at (ap_server, i);
+      if (!p_lstnr->need_response
+          && !srv_is_buffer_consumed (ap_server, p_lstnr))
+        {
+          TIZ_NOTICE (handleOf (ap_server->p_parent),
+                      "Dropping listener [%s:%u] fd [%d] (lagged more than "
+                      "[%u] seconds behind the others)",
+                      p_lstnr->p_con->p_ip, p_lstnr->p_con->port,
+                      p_lstnr->p_con->sockfd, ap_server->max_lag);
+          srv_remove_listener (ap_server, p_lstnr);
+          ++dropped;
+        }
     }
+  return dropped;
+}
 
-  srv_start_listener_timer_watcher (p_lstnr, ap_server->wait_time);
+static bool
+srv_release_consumed_buffer (httpr_server_t * ap_server)
+{
+  int nactive = 0;
+  int ndone = 0;
+  int i = 0;
 
-  if (p_con->initial_burst_bytes <= 0)
+  assert (ap_server);
+
+  if (!ap_server->p_hdr)
     {
-      p_con->burst_bytes = 0;
+      return false;
     }
 
-  while (1)
+  for (i = 0; i < srv_get_listeners_count (ap_server); ++i)
     {
-      if (NULL == p_hdr)
+      httpr_listener_t * p_lstnr = srv_get_listener_at (ap_server, i);
+      if (!p_lstnr->need_response)
         {
-          if (NULL == (p_hdr = ap_server->pf_acquire_buf (ap_server->p_arg)))
+          ++nactive;
+          if (srv_is_buffer_consumed (ap_server, p_lstnr))
             {
-              /* no more buffers available at the moment */
-              ap_server->need_more_data = true;
-              srv_stop_listener_timer_watcher (p_lstnr);
-              rc = OMX_ErrorNone;
-              break;
+              ++ndone;
             }
-          ap_server->need_more_data = false;
-          ap_server->p_hdr = p_hdr;
         }
+    }
+
+  if (nactive > 0 && ndone < nactive && ndone > 0 && ap_server->max_lag > 0)
+    {
+      /* Some listeners are waiting for the slower ones. Apply the lag
+         policy. */
+      time_t now = time (NULL);
+      if (0 == ap_server->hdr_stall_time)
+        {
+          ap_server->hdr_stall_time = now;
+        }
+      else if (difftime (now, ap_server->hdr_stall_time) > ap_server->max_lag)
+        {
+          ndone += srv_drop_lagging_listeners (ap_server);
+        }
+    }
 
-      rc = srv_write_omx_buffer (ap_server, p_lstnr);
+  if (nactive > 0 && ndone >= nactive)
+    {
+      /* The slowest listener has now consumed the shared buffer */
+      srv_release_shared_buffer (ap_server);
+      return true;
+    }
 
-      if (OMX_ErrorNoMore == rc)
+  return false;
+}
+
+static OMX_ERRORTYPE
+srv_write (httpr_server_t * ap_server, const bool a_new_tick)
+{
+  bool buffer_released = true;
+  int nactive = 0;
+  int i = 0;
+
+  assert (ap_server);
+
+  if (srv_get_listeners_count (ap_server) <= 0)
+    {
+      (void) srv_stop_server_timer_watcher (ap_server);
+      return OMX_ErrorNoMore;
+    }
+
+  for (i = 0; i < srv_get_listeners_count (ap_server); ++i)
+    {
+      httpr_listener_t * p_lstnr = srv_get_listener_at (ap_server, i);
+      if (!p_lstnr->need_response)
         {
-          (void) srv_remove_listener (ap_server, p_lstnr);
-          break;
+          ++nactive;
+          if (a_new_tick && p_lstnr->p_con->initial_burst_bytes <= 0)
+            {
+              p_lstnr->p_con->burst_bytes = 0;
+            }
         }
+    }
 
-      if (OMX_ErrorNotReady == rc
-          || ((p_con->initial_burst_bytes <= 0)
-              && (p_con->burst_bytes >= ap_server->burst_size)))
+  if (0 == nactive)
+    {
+      /* Nobody is ready to receive data yet */
+      (void) srv_stop_server_timer_watcher (ap_server);
+      return OMX_ErrorNotReady;
+    }
+
+  while (buffer_released)
+    {
+      if (!srv_acquire_shared_buffer (ap_server))
         {
-          rc = OMX_ErrorNotReady;
+          /* no more buffers available at the moment */
+          (void) srv_stop_server_timer_watcher (ap_server);
           break;
         }
 
-      /*       if (p_lstnr->pos == ap_server->p_hdr->nFilledLen) */
-      if (0 == ap_server->p_hdr->nFilledLen)
+      tiz_check_omx (srv_start_server_timer_watcher (ap_server));
+
+      /* Iterate backwards, so that removing a listener does not affect the
+         positions still to be visited */
+      for (i = srv_get_listeners_count (ap_server) - 1; i >= 0; --i)
         {
-          /* Buffer emptied */
-          (void) srv_release_empty_buffer (ap_server, p_lstnr, &p_hdr);
+          httpr_listener_t * p_lstnr = srv_get_listener_at (ap_server, i);
+          if (!p_lstnr->need_response
+              && OMX_ErrorNoMore
+                   == srv_write_to_listener_burst (ap_server, p_lstnr))
+            {
+              (void) srv_remove_listener (ap_server, p_lstnr);
+            }
         }
-    };
 
-  return rc;
+      buffer_released = srv_release_consumed_buffer (ap_server);
+    }
+
+  return OMX_ErrorNone;
 }
 
 static OMX_ERRORTYPE
-srv_stream_to_client (httpr_server_t * ap_server)
+srv_stream_to_client (httpr_server_t * ap_server, const bool a_new_tick)
 {
   OMX_ERRORTYPE rc = OMX_ErrorNone;
   assert (ap_server);
 
-  rc = srv_write (ap_server);
+  rc = srv_write (ap_server, a_new_tick);
   switch (rc)
     {
       case OMX_ErrorNone:
@@ -1634,6 +1772,36 @@ srv_stream_to_client (httpr_server_t * ap_server)
   return rc;
 }
 
+static OMX_ERRORTYPE
+srv_listener_io_ready (httpr_server_t * ap_server, const int a_fd)
+{
+  httpr_listener_t * p_lstnr = NULL;
+  int sockfd = a_fd;
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+
+  assert (ap_server);
+
+  p_lstnr = tiz_map_find (ap_server->p_lstnrs, &sockfd);
+  if (p_lstnr)
+    {
+      srv_stop_listener_io_watcher (p_lstnr);
+      rc = srv_check_listener_ready (ap_server, p_lstnr);
+      if (OMX_ErrorNoMore == rc)
+        {
+          srv_remove_listener (ap_server, p_lstnr);
+        }
+      if (OMX_ErrorNone != rc)
+        {
+          /* Nothing else to do for now */
+          return OMX_ErrorNone;
+        }
+    }
+
+  /* Either a blocked socket is writable again or a new listener is ready;
+     resume streaming within the current tick's limits. */
+  return srv_stream_to_client (ap_server, false);
+}
+
 static int
 srv_get_descriptor (const httpr_server_t * ap_server)
 {
@@ -1651,6 +1819,8 @@ httpr_srv_destroy (httpr_server_t * ap_server)
   if (ap_server)
     {
       srv_destroy_server_io_watcher (ap_server);
+      tiz_srv_timer_watcher_destroy (ap_server->p_parent,
+                                     ap_server->p_srv_ev_timer);
       if (ICE_SOCK_ERROR != ap_server->lstn_sockfd)
         {
           close (ap_server->lstn_sockfd);
@@ -1690,9 +1860,13 @@ httpr_srv_init (httpr_server_t ** app_server, void * ap_parent,
   p_server->lstn_sockfd = ICE_SOCK_ERROR;
   p_server->p_ip = NULL;
   p_server->p_srv_ev_io = NULL;
+  p_server->p_srv_ev_timer = NULL;
+  p_server->timer_started = false;
   p_server->max_clients = a_max_clients;
   p_server->p_lstnrs = NULL;
   p_server->p_hdr = NULL;
+  p_server->hdr_stall_time = 0;
+  p_server->max_lag = srv_get_max_listener_lag ();
   p_server->pf_release_buf = a_pf_release_buf;
   p_server->pf_acquire_buf = a_pf_acquire_buf;
   p_server->need_more_data = true;
@@ -1735,6 +1909,10 @@ httpr_srv_init (httpr_server_t ** app_server, void * ap_parent,
   goto_end_on_omx_error (rc, handleOf (ap_parent),
                          "Unable to alloc the server's io event");
 
+  rc = tiz_srv_timer_watcher_init (ap_parent, &(p_server->p_srv_ev_timer));
+  goto_end_on_omx_error (rc, handleOf (ap_parent),
+                         "Unable to alloc the server's timer event");
+
   /* All good so far */
   all_ok = true;
 
@@ -1786,18 +1964,16 @@ end:
 OMX_ERRORTYPE
 httpr_srv_stop (httpr_server_t * ap_server)
 {
-  httpr_listener_t * p_lstnr = NULL;
+  int i = 0;
   assert (ap_server);
   (void) srv_stop_server_io_watcher (ap_server);
+  (void) srv_stop_server_timer_watcher (ap_server);
   if (ap_server->p_lstnrs)
     {
-      /* Until support for multiple listeners gets implemented, there will only
-         be one listener in the map */
-      p_lstnr = srv_get_first_listener (ap_server);
-      if (p_lstnr)
+      for (i = srv_get_listeners_count (ap_server) - 1; i >= 0; --i)
         {
+          httpr_listener_t * p_lstnr = srv_get_listener_at (ap_server, i);
           (void) srv_stop_listener_io_watcher (p_lstnr);
-          (void) srv_stop_listener_timer_watcher (p_lstnr);
           (void) srv_remove_listener (ap_server, p_lstnr);
         }
     }
@@ -1810,12 +1986,7 @@ void
 httpr_srv_release_buffers (httpr_server_t * ap_server)
 {
   assert (ap_server);
-  if (ap_server->p_hdr)
-    {
-      ap_server->p_hdr->nFilledLen = 0;
-      ap_server->pf_release_buf (ap_server->p_hdr, ap_server->p_arg);
-      ap_server->p_hdr = NULL;
-    }
+  srv_release_shared_buffer (ap_server);
 }
 
 void
@@ -1838,13 +2009,7 @@ httpr_srv_set_mp3_settings (httpr_server_t * ap_server, const OMX_U32 a_bitrate,
 
   ap_server->wait_time = (1 / ap_server->pkts_per_sec);
 
-  if (srv_get_listeners_count (ap_server) > 0)
-    {
-      httpr_listener_t * p_lstnr = srv_get_first_listener (ap_server);
-      assert (p_lstnr);
-      srv_stop_listener_timer_watcher (p_lstnr);
-      srv_start_listener_timer_watcher (p_lstnr, ap_server->wait_time);
-    }
+  (void) srv_restart_server_timer_watcher (ap_server);
 
   TIZ_PRINTF_DBG_MAG (
     "burst [%d] sample rate [%u] bitrate [%u] "
@@ -1921,17 +2086,18 @@ httpr_srv_set_stream_title (httpr_server_t * ap_server,
            OMX_TIZONIA_MAX_SHOUTCAST_METADATA_SIZE);
   p_mount->stream_title[OMX_TIZONIA_MAX_SHOUTCAST_METADATA_SIZE - 1] = '\000';
 
-  if (srv_get_listeners_count (ap_server) > 0)
-    {
-      httpr_listener_t * p_lstnr = srv_get_first_listener (ap_server);
-      assert (p_lstnr);
-      assert (p_lstnr->p_con);
-      p_lstnr->p_con->metadata_delivered = false;
-      p_lstnr->p_con->initial_burst_bytes
-        = ap_server->mountpoint.initial_burst_size * 0.1;
-      srv_stop_listener_timer_watcher (p_lstnr);
-      srv_start_listener_timer_watcher (p_lstnr, ap_server->wait_time);
-    }
+  {
+    int i = 0;
+    for (i = 0; i < srv_get_listeners_count (ap_server); ++i)
+      {
+        httpr_listener_t * p_lstnr = srv_get_listener_at (ap_server, i);
+        assert (p_lstnr->p_con);
+        p_lstnr->p_con->metadata_delivered = false;
+        p_lstnr->p_con->initial_burst_bytes
+          = ap_server->mountpoint.initial_burst_size * 0.1;
+      }
+  }
+  (void) srv_restart_server_timer_watcher (ap_server);
 }
 
 OMX_ERRORTYPE
@@ -1939,7 +2105,7 @@ httpr_srv_buffer_event (httpr_server_t * ap_server)
 {
   assert (ap_server);
   return ((ap_server->running && ap_server->need_more_data)
-            ? srv_stream_to_client (ap_server)
+            ? srv_stream_to_client (ap_server, false)
             : OMX_ErrorNone);
 }
 
@@ -1961,8 +2127,8 @@ httpr_srv_io_event (httpr_server_t * ap_server, const int a_fd)
         }
       else
         {
-          /* The client socket is ready */
-          rc = srv_stream_to_client (ap_server);
+          /* One of the client sockets is ready */
+          rc = srv_listener_io_ready (ap_server, a_fd);
         }
     }
   return rc;
@@ -1972,5 +2138,6 @@ OMX_ERRORTYPE
 httpr_srv_timer_event (httpr_server_t * ap_server)
 {
   assert (ap_server);
-  return ap_server->running ? srv_stream_to_client (ap_server) : OMX_ErrorNone;
+  return ap_server->running ? srv_stream_to_client (ap_server, true)
+                            : OMX_ErrorNone;
 }
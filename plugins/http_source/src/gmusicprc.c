@@ -55,7 +55,7 @@
 static OMX_ERRORTYPE
 gmusic_prc_deallocate_resources (void *);
 static OMX_ERRORTYPE
-release_buffer (gmusic_prc_t *);
+release_buffer (gmusic_prc_t *, OMX_BUFFERHEADERTYPE *);
 static OMX_ERRORTYPE
 prepare_for_port_auto_detection (gmusic_prc_t * ap_prc);
 static OMX_ERRORTYPE
@@ -416,32 +416,29 @@ obtain_next_url (gmusic_prc_t * ap_prc, int a_skip_value)
 }
 
 static OMX_ERRORTYPE
-release_buffer (gmusic_prc_t * ap_prc)
+release_buffer (gmusic_prc_t * ap_prc, OMX_BUFFERHEADERTYPE * ap_hdr)
 {
   assert (ap_prc);
+  assert (ap_hdr);
 
-  if (ap_prc->p_outhdr_)
+  if (ap_prc->bytes_before_eos_ > ap_hdr->nFilledLen)
     {
-      if (ap_prc->bytes_before_eos_ > ap_prc->p_outhdr_->nFilledLen)
-        {
-          ap_prc->bytes_before_eos_ -= ap_prc->p_outhdr_->nFilledLen;
-        }
-      else
-        {
-          ap_prc->bytes_before_eos_ = 0;
-          ap_prc->eos_ = true;
-        }
+      ap_prc->bytes_before_eos_ -= ap_hdr->nFilledLen;
+    }
+  else
+    {
+      ap_prc->bytes_before_eos_ = 0;
+      ap_prc->eos_ = true;
+    }
 
-      if (ap_prc->eos_)
-        {
-          ap_prc->eos_ = false;
-          ap_prc->p_outhdr_->nFlags |= OMX_BUFFERFLAG_EOS;
-        }
-      tiz_check_omx (tiz_krn_release_buffer (
-        tiz_get_krn (handleOf (ap_prc)), ARATELIA_HTTP_SOURCE_PORT_INDEX,
-        ap_prc->p_outhdr_));
-      ap_prc->p_outhdr_ = NULL;
+  if (ap_prc->eos_)
+    {
+      ap_prc->eos_ = false;
+      ap_hdr->nFlags |= OMX_BUFFERFLAG_EOS;
     }
+  tiz_check_omx (tiz_krn_release_buffer (tiz_get_krn (handleOf (ap_prc)),
+                                         ARATELIA_HTTP_SOURCE_PORT_INDEX,
+                                         ap_hdr));
   return OMX_ErrorNone;
 }
 
@@ -451,11 +448,12 @@ buffer_filled (OMX_BUFFERHEADERTYPE * ap_hdr, void * ap_arg)
   gmusic_prc_t * p_prc = ap_arg;
   assert (p_prc);
   assert (ap_hdr);
-  assert (p_prc->p_outhdr_ == ap_hdr);
   ap_hdr->nOffset = 0;
-  (void) release_buffer (p_prc);
+  (void) release_buffer (p_prc, ap_hdr);
 }
 
+/* The transfer runs in scatter mode, so every call claims a new header, which
+   the transfer holds until it is full */
 static OMX_BUFFERHEADERTYPE *
 buffer_emptied (OMX_PTR ap_arg)
 {
@@ -465,24 +463,20 @@ buffer_emptied (OMX_PTR ap_arg)
 
   if (!p_prc->port_disabled_)
     {
-      if (p_prc->p_outhdr_)
-        {
-          p_hdr = p_prc->p_outhdr_;
-        }
-      else
+      if (OMX_ErrorNone
+          == (tiz_krn_claim_buffer (tiz_get_krn (handleOf (p_prc)),
+                                    ARATELIA_HTTP_SOURCE_PORT_INDEX, 0,
+                                    &p_hdr)))
         {
-          if (OMX_ErrorNone
-              == (tiz_krn_claim_buffer (tiz_get_krn (handleOf (p_prc)),
-                                        ARATELIA_HTTP_SOURCE_PORT_INDEX, 0,
-                                        &p_prc->p_outhdr_)))
+          if (p_hdr)
+            {
+              TIZ_TRACE (handleOf (p_prc),
+                         "Claimed HEADER [%p]...nFilledLen [%d]", p_hdr,
+                         p_hdr->nFilledLen);
+            }
+          else
             {
-              if (p_prc->p_outhdr_)
-                {
-                  TIZ_TRACE (handleOf (p_prc),
-                             "Claimed HEADER [%p]...nFilledLen [%d]",
-                             p_prc->p_outhdr_, p_prc->p_outhdr_->nFilledLen);
-                  p_hdr = p_prc->p_outhdr_;
-                }
+              TIZ_TRACE (handleOf (p_prc), "No more headers available");
             }
         }
     }
@@ -646,7 +640,6 @@ static void *
 gmusic_prc_ctor (void * ap_obj, va_list * app)
 {
   gmusic_prc_t * p_prc = super_ctor (typeOf (ap_obj, "gmusicprc"), ap_obj, app);
-  p_prc->p_outhdr_ = NULL;
   p_prc->p_uri_param_ = NULL;
   p_prc->eos_ = false;
   p_prc->port_disabled_ = false;
@@ -713,6 +706,10 @@ gmusic_prc_allocate_resources (void * ap_obj, OMX_U32 a_pid)
                            ARATELIA_HTTP_SOURCE_PORT_MIN_BUF_SIZE,
                            ARATELIA_HTTP_SOURCE_DEFAULT_RECONNECT_TIMEOUT,
                            buffer_cbacks, info_cbacks, io_cbacks, timer_cbacks);
+    if (OMX_ErrorNone == rc)
+      {
+        tiz_urltrans_enable_scatter_mode (p_prc->p_trans_);
+      }
   }
   return rc;
 }
@@ -764,7 +761,7 @@ gmusic_prc_stop_and_return (void * ap_prc)
       tiz_urltrans_pause (p_prc->p_trans_);
       tiz_urltrans_flush_buffer (p_prc->p_trans_);
     }
-  return release_buffer (p_prc);
+  return OMX_ErrorNone;
 }
 
 /*
@@ -817,7 +814,7 @@ gmusic_prc_port_flush (const void * ap_obj, OMX_U32 TIZ_UNUSED (a_pid))
     {
       tiz_urltrans_flush_buffer (p_prc->p_trans_);
     }
-  return release_buffer (p_prc);
+  return OMX_ErrorNone;
 }
 
 static OMX_ERRORTYPE
@@ -831,10 +828,10 @@ gmusic_prc_port_disable (const void * ap_obj, OMX_U32 TIZ_UNUSED (a_pid))
   if (p_prc->p_trans_)
     {
       tiz_urltrans_pause (p_prc->p_trans_);
+      /* This also releases any buffers held */
       tiz_urltrans_flush_buffer (p_prc->p_trans_);
     }
-  /* Release any buffers held  */
-  return release_buffer ((gmusic_prc_t *) ap_obj);
+  return OMX_ErrorNone;
 }
 
 static OMX_ERRORTYPE
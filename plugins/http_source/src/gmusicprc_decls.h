@@ -46,7 +46,6 @@ struct gmusic_prc
 {
   /* Object */
   const tiz_prc_t _;
-  OMX_BUFFERHEADERTYPE * p_outhdr_;
   OMX_TIZONIA_AUDIO_PARAM_GMUSICSESSIONTYPE session_;
   OMX_TIZONIA_AUDIO_PARAM_GMUSICPLAYLISTTYPE playlist_;
   OMX_TIZONIA_PLAYLISTSKIPTYPE playlist_skip_;
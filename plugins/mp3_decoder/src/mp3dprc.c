@@ -34,6 +34,8 @@
 #include <limits.h>
 #include <string.h>
 
+#include <OMX_TizoniaExt.h>
+
 #include <tizplatform.h>
 
 #include <tizkernel.h>
@@ -47,6 +49,9 @@
 #define TIZ_LOG_CATEGORY_NAME "tiz.mp3_decoder.prc"
 #endif
 
+/* Size of the per-channel arrays in struct mad_pcm */
+#define MP3D_MAX_PCM_SAMPLES 1152
+
 static void
 reset_stream_parameters (mp3d_prc_t * ap_prc)
 {
@@ -60,6 +65,26 @@ reset_stream_parameters (mp3d_prc_t * ap_prc)
   ap_prc->eos_ = false;
 }
 
+static void
+reset_seek_info (mp3d_prc_t * ap_prc)
+{
+  assert (ap_prc);
+  ap_prc->stream_pos_ = 0;
+  ap_prc->first_frame_pos_ = 0;
+  ap_prc->seek_target_ = 0;
+  ap_prc->skip_samples_ = 0;
+  ap_prc->awaiting_start_ = false;
+  ap_prc->seek_info_ready_ = false;
+  ap_prc->duration_ = -1;
+  ap_prc->total_bytes_ = 0;
+  ap_prc->bitrate_ = 0;
+  ap_prc->has_xing_toc_ = false;
+  tiz_mem_free (ap_prc->p_vbri_toc_);
+  ap_prc->p_vbri_toc_ = NULL;
+  ap_prc->vbri_entries_ = 0;
+  ap_prc->vbri_entry_duration_ = 0;
+}
+
 static void
 init_mad_decoder (mp3d_prc_t * ap_prc)
 {
@@ -280,46 +305,6 @@ store_stream_metadata (mp3d_prc_t * ap_prc, struct mad_header * Header)
              Emphasis, Header->samplerate);
 }
 
-static signed short
-mad_fixed_to_sshort (mad_fixed_t fixed)
-{
-  /* A fixed point number is formed of the following bit pattern:
-   *
-   * SWWWFFFFFFFFFFFFFFFFFFFFFFFFFFFF
-   * MSB                          LSB
-   * S ==> Sign (0 is positive, 1 is negative)
-   * W ==> Whole part bits
-   * F ==> Fractional part bits
-   *
-   * This pattern contains MAD_F_FRACBITS fractional bits, one
-   * should alway use this macro when working on the bits of a fixed
-   * point number. It is not guaranteed to be constant over the
-   * different platforms supported by libmad.
-   *
-   * The signed short value is formed, after clipping, by the least
-   * significant whole part bit, followed by the 15 most significant
-   * fractional part bits. Warning: this is a quick and dirty way to
-   * compute the 16-bit number, madplay includes much better
-   * algorithms.
-   */
-
-  /* Clipping */
-  if (fixed >= MAD_F_ONE)
-    {
-      return (SHRT_MAX);
-    }
-
-  if (fixed <= -MAD_F_ONE)
-    {
-      return (-SHRT_MAX);
-    }
-
-  /* Conversion. */
-  fixed = fixed >> (MAD_F_FRACBITS - 15);
-
-  return (signed short) fixed;
-}
-
 static size_t
 read_from_omx_buffer (const mp3d_prc_t * ap_prc, void * ap_dst, size_t bytes,
                       OMX_BUFFERHEADERTYPE * ap_hdr)
@@ -385,39 +370,28 @@ static int
 synthesize_samples (const void * ap_obj, int next_sample)
 {
   mp3d_prc_t * p_prc = (mp3d_prc_t *) ap_obj;
-  const unsigned char * p_bufend
-    = p_prc->p_outhdr_->pBuffer + p_prc->p_outhdr_->nAllocLen;
-  unsigned char * p_output
-    = p_prc->p_outhdr_->pBuffer + p_prc->p_outhdr_->nFilledLen;
-  bool buffer_full = (p_bufend == p_output);
-  int i;
-
-  for (i = next_sample; i < p_prc->synth_.pcm.length && !buffer_full; i++)
+  OMX_BUFFERHEADERTYPE * p_hdr = p_prc->p_outhdr_;
+  const OMX_U32 early_release_len
+    = (OMX_U32) (ARATELIA_MP3_DECODER_PORT_MIN_OUTPUT_BUF_SIZE * .2);
+  /* We're outputting two channels, also for mono streams. If the decoded
+   * stream is monophonic then the right output channel is the same as the
+   * left one. */
+  const bool stereo = (MAD_NCHANNELS (&p_prc->frame_.header) == 2);
+  int i = next_sample;
+
+  if (i < p_prc->synth_.pcm.length
+      && p_hdr->nAllocLen - p_hdr->nFilledLen >= 4)
     {
-      signed short sample;
-
-      /* Left channel */
-      sample = mad_fixed_to_sshort (p_prc->synth_.pcm.samples[0][i]);
-      *(p_output++) = sample >> 8;
-      *(p_output++) = sample & 0xff;
-
-      /* Right channel. If the decoded stream is monophonic then
-       * the right output channel is the same as the left one.
-       */
-      if (MAD_NCHANNELS (&p_prc->frame_.header) == 2)
-        {
-          sample = mad_fixed_to_sshort (p_prc->synth_.pcm.samples[1][i]);
-        }
-      *(p_output++) = sample >> 8;
-      *(p_output++) = sample & 0xff;
-
-      p_prc->p_outhdr_->nFilledLen += 4;
+      int16_t left[MP3D_MAX_PCM_SAMPLES];
+      int16_t right[MP3D_MAX_PCM_SAMPLES];
+      const void * channels[2] = {left, stereo ? right : left};
+      OMX_U8 * p_output = p_hdr->pBuffer + p_hdr->nFilledLen;
+      size_t nframes = MIN ((size_t) (p_prc->synth_.pcm.length - i),
+                            (p_hdr->nAllocLen - p_hdr->nFilledLen) / 4);
 
       if (p_prc->frame_.header.samplerate != p_prc->pcmmode_.nSamplingRate
           || p_prc->pcmmode_.nChannels < 2)
         {
-          /* We're outputting two channels, also for mono streams.
-           */
           const OMX_U32 nchannels = 2;
           TIZ_PRINTF_DBG_GRN ("samplerate [%d] NCHANNELS [%d] channels [%d].",
                               p_prc->frame_.header.samplerate,
@@ -428,25 +402,42 @@ synthesize_samples (const void * ap_obj, int next_sample)
                                   nchannels);
         }
 
-      /* release the output buffer if it is full, or if we are at the early stages
-         of the decoding */
-      if (p_output == p_bufend)
+      /* At the early stages of the decoding, stop as soon as there is
+         enough data to release the buffer */
+      if (p_prc->frame_count_ < 5)
         {
-          p_output = p_prc->p_outhdr_->pBuffer;
-          p_prc->p_outhdr_->nFilledLen = p_prc->p_outhdr_->nAllocLen;
-          (void) release_headers (p_prc,
-                                  ARATELIA_MP3_DECODER_OUTPUT_PORT_INDEX);
-          buffer_full = true;
+          nframes = MIN (nframes, p_hdr->nFilledLen < early_release_len
+                                    ? (early_release_len - p_hdr->nFilledLen
+                                       + 3) / 4
+                                    : 1);
         }
-      else if (p_prc->frame_count_ < 5
-               && p_prc->p_outhdr_->nFilledLen
-                    >= (int) (ARATELIA_MP3_DECODER_PORT_MIN_OUTPUT_BUF_SIZE
-                              * .2))
+
+      /* Dithered requantization to 16 bits, then interleave into the
+         big-endian frames the output port is configured for */
+      (void) tiz_pcm_fixed_to_s16 (
+        left, (const int32_t *) &p_prc->synth_.pcm.samples[0][i], nframes,
+        MAD_F_FRACBITS, &p_prc->dither_);
+      if (stereo)
+        {
+          (void) tiz_pcm_fixed_to_s16 (
+            right, (const int32_t *) &p_prc->synth_.pcm.samples[1][i],
+            nframes, MAD_F_FRACBITS, &p_prc->dither_);
+        }
+      (void) tiz_pcm_interleave (p_output, channels, 2, 2, nframes);
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+      (void) tiz_pcm_swap (p_output, 2, nframes * 2);
+#endif
+      p_hdr->nFilledLen += nframes * 4;
+      i += nframes;
+
+      /* release the output buffer if it is full, or if we are at the early
+         stages of the decoding */
+      if (p_hdr->nAllocLen - p_hdr->nFilledLen < 4
+          || (p_prc->frame_count_ < 5
+              && p_hdr->nFilledLen >= early_release_len))
         {
-          p_output = p_prc->p_outhdr_->pBuffer;
           (void) release_headers (p_prc,
                                   ARATELIA_MP3_DECODER_OUTPUT_PORT_INDEX);
-          buffer_full = true;
         }
     }
 
@@ -461,6 +452,246 @@ synthesize_samples (const void * ap_obj, int next_sample)
   return 0;
 }
 
+static inline unsigned long
+read_be (const unsigned char * ap_data, const size_t a_nbytes)
+{
+  unsigned long value = 0;
+  size_t i = 0;
+  for (i = 0; i < a_nbytes; ++i)
+    {
+      value = (value << 8) | ap_data[i];
+    }
+  return value;
+}
+
+static inline OMX_TICKS
+timer_to_us (const mad_timer_t a_timer)
+{
+  return (OMX_TICKS) a_timer.seconds * 1000000
+         + mad_timer_fraction (a_timer, 1000000);
+}
+
+static inline unsigned long
+samples_per_frame (const struct mad_header * ap_header)
+{
+  assert (ap_header);
+  return 32 * MAD_NSBSAMPLES (ap_header);
+}
+
+static OMX_ERRORTYPE
+store_stream_position (mp3d_prc_t * ap_prc, const OMX_TICKS a_timestamp,
+                       const OMX_S64 a_byte_offset)
+{
+  OMX_TIZONIA_STREAMPOSITIONTYPE position;
+  assert (ap_prc);
+  TIZ_INIT_OMX_PORT_STRUCT (position, ARATELIA_MP3_DECODER_INPUT_PORT_INDEX);
+  position.nTimestamp = a_timestamp;
+  position.nByteOffset = a_byte_offset;
+  return tiz_krn_SetConfig_internal (tiz_get_krn (handleOf (ap_prc)),
+                                     handleOf (ap_prc),
+                                     OMX_TizoniaIndexConfigStreamPosition,
+                                     &position);
+}
+
+/* Xing/Info tag, found in the side info area of the first Layer III frame:
+   frame count, stream size and a 100-entry table of contents that maps
+   percentages of the duration to fractions (x/256) of the stream size. */
+static bool
+parse_xing_header (mp3d_prc_t * ap_prc, const unsigned char * ap_frame,
+                   const size_t a_len)
+{
+  const struct mad_header * p_hdr = &(ap_prc->frame_.header);
+  const bool mono = (MAD_MODE_SINGLE_CHANNEL == p_hdr->mode);
+  const bool lsf = (p_hdr->flags & MAD_FLAG_LSF_EXT) != 0;
+  size_t pos = 4 + ((p_hdr->flags & MAD_FLAG_PROTECTION) ? 2 : 0)
+               + (lsf ? (mono ? 9 : 17) : (mono ? 17 : 32));
+  unsigned long flags = 0;
+  unsigned long frames = 0;
+
+  if (MAD_LAYER_III != p_hdr->layer || pos + 8 > a_len
+      || (memcmp (ap_frame + pos, "Xing", 4) != 0
+          && memcmp (ap_frame + pos, "Info", 4) != 0))
+    {
+      return false;
+    }
+
+  flags = read_be (ap_frame + pos + 4, 4);
+  pos += 8;
+  if ((flags & 0x1) && pos + 4 <= a_len)
+    {
+      frames = read_be (ap_frame + pos, 4);
+      pos += 4;
+    }
+  if ((flags & 0x2) && pos + 4 <= a_len)
+    {
+      ap_prc->total_bytes_ = read_be (ap_frame + pos, 4);
+      pos += 4;
+    }
+  if ((flags & 0x4) && pos + 100 <= a_len)
+    {
+      memcpy (ap_prc->xing_toc_, ap_frame + pos, 100);
+      ap_prc->has_xing_toc_ = true;
+    }
+  if (frames > 0 && p_hdr->samplerate > 0)
+    {
+      ap_prc->duration_ = (OMX_TICKS) frames * samples_per_frame (p_hdr)
+                          * 1000000 / p_hdr->samplerate;
+    }
+
+  TIZ_TRACE (handleOf (ap_prc), "Xing : frames [%lu] bytes [%lld] toc [%s]",
+             frames, (long long) ap_prc->total_bytes_,
+             ap_prc->has_xing_toc_ ? "YES" : "NO");
+  return true;
+}
+
+/* VBRI tag (Fraunhofer encoders), 32 bytes after the header of the first
+   frame: a table with the size of each group of 'frames per entry'
+   frames. */
+static bool
+parse_vbri_header (mp3d_prc_t * ap_prc, const unsigned char * ap_frame,
+                   const size_t a_len)
+{
+  const struct mad_header * p_hdr = &(ap_prc->frame_.header);
+  const size_t pos = 4 + 32;
+  unsigned long frames = 0;
+  unsigned entries = 0;
+  unsigned long scale = 0;
+  size_t entry_size = 0;
+  unsigned long frames_per_entry = 0;
+  unsigned i = 0;
+
+  if (pos + 26 > a_len || memcmp (ap_frame + pos, "VBRI", 4) != 0
+      || 0 == p_hdr->samplerate)
+    {
+      return false;
+    }
+
+  ap_prc->total_bytes_ = read_be (ap_frame + pos + 10, 4);
+  frames = read_be (ap_frame + pos + 14, 4);
+  entries = read_be (ap_frame + pos + 18, 2);
+  scale = read_be (ap_frame + pos + 20, 2);
+  entry_size = read_be (ap_frame + pos + 22, 2);
+  frames_per_entry = read_be (ap_frame + pos + 24, 2);
+
+  ap_prc->duration_ = (OMX_TICKS) frames * samples_per_frame (p_hdr) * 1000000
+                      / p_hdr->samplerate;
+
+  if (entries > 0 && entry_size > 0 && entry_size <= 4 && frames_per_entry > 0
+      && pos + 26 + entries * entry_size <= a_len
+      && NULL != (ap_prc->p_vbri_toc_
+                  = tiz_mem_alloc (entries * sizeof (OMX_S64))))
+    {
+      /* Convert the sizes into the stream offsets where each group starts */
+      const unsigned char * p_entry = ap_frame + pos + 26;
+      ap_prc->p_vbri_toc_[0] = ap_prc->first_frame_pos_;
+      for (i = 1; i < entries; ++i, p_entry += entry_size)
+        {
+          ap_prc->p_vbri_toc_[i] = ap_prc->p_vbri_toc_[i - 1]
+                                   + read_be (p_entry, entry_size) * scale;
+        }
+      ap_prc->vbri_entries_ = entries;
+      ap_prc->vbri_entry_duration_ = (OMX_TICKS) frames_per_entry
+                                     * samples_per_frame (p_hdr) * 1000000
+                                     / p_hdr->samplerate;
+    }
+
+  TIZ_TRACE (handleOf (ap_prc), "VBRI : frames [%lu] bytes [%lld] toc [%u]",
+             frames, (long long) ap_prc->total_bytes_, ap_prc->vbri_entries_);
+  return true;
+}
+
+static void
+obtain_seek_info (mp3d_prc_t * ap_prc)
+{
+  const unsigned char * p_frame = NULL;
+  size_t len = 0;
+
+  assert (ap_prc);
+  assert (ap_prc->stream_.this_frame);
+
+  p_frame = ap_prc->stream_.this_frame;
+  len = ap_prc->stream_.next_frame - ap_prc->stream_.this_frame;
+
+  /* Anything before this frame (e.g. an ID3v2 tag) is not audio */
+  ap_prc->first_frame_pos_
+    = ap_prc->stream_pos_ + (p_frame - ap_prc->in_buff_);
+  ap_prc->bitrate_ = ap_prc->frame_.header.bitrate;
+
+  if (!parse_xing_header (ap_prc, p_frame, len))
+    {
+      (void) parse_vbri_header (ap_prc, p_frame, len);
+    }
+
+  ap_prc->seek_info_ready_ = true;
+
+  /* Let the client know that this stream can be seeked */
+  (void) store_stream_position (ap_prc, 0, ap_prc->first_frame_pos_);
+}
+
+static void
+find_seek_point (const mp3d_prc_t * ap_prc, const OMX_TICKS a_target,
+                 OMX_TICKS * ap_time, OMX_S64 * ap_offset)
+{
+  assert (ap_prc);
+  assert (ap_time);
+  assert (ap_offset);
+
+  *ap_time = 0;
+  *ap_offset = ap_prc->first_frame_pos_;
+
+  if (ap_prc->p_vbri_toc_)
+    {
+      /* Exact, at the start of a group of frames */
+      const unsigned idx
+        = MIN (a_target / ap_prc->vbri_entry_duration_,
+               ap_prc->vbri_entries_ - 1);
+      *ap_time = idx * ap_prc->vbri_entry_duration_;
+      *ap_offset = ap_prc->p_vbri_toc_[idx];
+    }
+  else if (ap_prc->has_xing_toc_ && ap_prc->duration_ > 0
+           && ap_prc->total_bytes_ > 0)
+    {
+      /* Interpolate between the two surrounding table entries. The table
+         has a 1% resolution, so the resulting position is approximate. */
+      const double percent
+        = MIN (MAX (100.0 * a_target / ap_prc->duration_, 0.0), 99.99);
+      const int i = (int) percent;
+      const double fa = ap_prc->xing_toc_[i];
+      const double fb = i < 99 ? ap_prc->xing_toc_[i + 1] : 256.0;
+      const double fx = fa + (fb - fa) * (percent - i);
+      *ap_time = a_target;
+      *ap_offset
+        = ap_prc->first_frame_pos_ + (OMX_S64) (fx / 256.0 * ap_prc->total_bytes_);
+    }
+  else if (ap_prc->bitrate_ > 0)
+    {
+      /* Assume a constant bitrate */
+      *ap_time = a_target;
+      *ap_offset = ap_prc->first_frame_pos_
+                   + (OMX_S64) (a_target * (OMX_TICKS) ap_prc->bitrate_
+                                / 8000000);
+    }
+}
+
+static void
+resync_decoder (mp3d_prc_t * ap_prc, const OMX_TICKS a_start_time)
+{
+  assert (ap_prc);
+  assert (ap_prc->p_inhdr_);
+
+  TIZ_TRACE (handleOf (ap_prc), "resuming at [%lld] us (target [%lld] us)",
+             (long long) a_start_time, (long long) ap_prc->seek_target_);
+
+  mad_timer_set (&ap_prc->timer_, a_start_time / 1000000,
+                 a_start_time % 1000000, 1000000);
+  ap_prc->skip_samples_
+    = ap_prc->seek_target_ > a_start_time && ap_prc->pcmmode_.nSamplingRate > 0
+        ? (ap_prc->seek_target_ - a_start_time)
+            * ap_prc->pcmmode_.nSamplingRate / 1000000
+        : 0;
+  ap_prc->awaiting_start_ = false;
+}
+
 static OMX_ERRORTYPE
 decode_buffer (const void * ap_obj)
 {
@@ -497,6 +728,8 @@ decode_buffer (const void * ap_obj)
 
           if (p_obj->stream_.next_frame != NULL)
             {
+              p_obj->stream_pos_
+                += p_obj->stream_.next_frame - p_obj->in_buff_;
               p_obj->remaining_
                 = p_obj->stream_.bufend - p_obj->stream_.next_frame;
               memmove (p_obj->in_buff_, p_obj->stream_.next_frame,
@@ -601,6 +834,11 @@ decode_buffer (const void * ap_obj)
           store_stream_metadata (p_obj, &(p_obj->frame_.header));
         }
 
+      if (!p_obj->seek_info_ready_)
+        {
+          obtain_seek_info (p_obj);
+        }
+
       p_obj->frame_count_++;
       mad_timer_add (&p_obj->timer_, p_obj->frame_.header.duration);
 
@@ -609,6 +847,18 @@ decode_buffer (const void * ap_obj)
        */
       mad_synth_frame (&p_obj->synth_, &p_obj->frame_);
 
+      if (p_obj->skip_samples_ > 0)
+        {
+          /* Still short of the seek target */
+          if (p_obj->skip_samples_ >= p_obj->synth_.pcm.length)
+            {
+              p_obj->skip_samples_ -= p_obj->synth_.pcm.length;
+              continue;
+            }
+          p_obj->next_synth_sample_ = p_obj->skip_samples_;
+          p_obj->skip_samples_ = 0;
+        }
+
       p_obj->next_synth_sample_
         = synthesize_samples (p_obj, p_obj->next_synth_sample_);
     }
@@ -714,12 +964,16 @@ mp3d_proc_ctor (void * ap_obj, va_list * app)
   p_obj->eos_ = false;
   p_obj->in_port_disabled_ = false;
   p_obj->out_port_disabled_ = false;
+  p_obj->p_vbri_toc_ = NULL;
+  tiz_pcm_dither_init (&(p_obj->dither_), 0x9E3779B9);
+  reset_seek_info (p_obj);
   return p_obj;
 }
 
 static void *
 mp3d_proc_dtor (void * ap_obj)
 {
+  reset_seek_info (ap_obj);
   return super_dtor (typeOf (ap_obj, "mp3dprc"), ap_obj);
 }
 
@@ -773,8 +1027,10 @@ mp3d_proc_prepare_to_transfer (void * ap_obj, OMX_U32 a_pid)
              p_prc->pcmmode_.nSamplingRate, p_prc->pcmmode_.nChannels);
 
   reset_stream_parameters (ap_obj);
+  reset_seek_info (ap_obj);
 
-  return OMX_ErrorNone;
+  /* Not seekable until the first frame of this stream has been parsed */
+  return store_stream_position (p_prc, -1, -1);
 }
 
 static OMX_ERRORTYPE
@@ -823,6 +1079,26 @@ mp3d_proc_buffers_ready (const void * ap_obj)
             }
         }
 
+      if (p_obj->awaiting_start_)
+        {
+          if (!p_obj->p_inhdr_)
+            {
+              break;
+            }
+          if (0 == (p_obj->p_inhdr_->nFlags & OMX_BUFFERFLAG_STARTTIME))
+            {
+              /* Data from before the seek point */
+              p_obj->p_inhdr_->nFilledLen = 0;
+              p_obj->p_inhdr_->nOffset = 0;
+              tiz_check_omx (tiz_krn_release_buffer (
+                tiz_get_krn (handleOf (p_obj)),
+                ARATELIA_MP3_DECODER_INPUT_PORT_INDEX, p_obj->p_inhdr_));
+              p_obj->p_inhdr_ = NULL;
+              continue;
+            }
+          resync_decoder (p_obj, p_obj->p_inhdr_->nTimeStamp);
+        }
+
       if (!p_obj->p_outhdr_)
         {
           if (!claim_output_buffer (p_obj))
@@ -857,6 +1133,59 @@ mp3d_proc_port_flush (const void * ap_obj, OMX_U32 a_pid)
   return release_headers (p_obj, a_pid);
 }
 
+static OMX_ERRORTYPE
+mp3d_proc_config_change (void * ap_obj, OMX_U32 TIZ_UNUSED (a_pid),
+                         OMX_INDEXTYPE a_config_idx)
+{
+  mp3d_prc_t * p_obj = ap_obj;
+  assert (p_obj);
+
+  if (OMX_TizoniaIndexConfigStreamPosition == a_config_idx
+      && p_obj->seek_info_ready_)
+    {
+      OMX_TIZONIA_STREAMPOSITIONTYPE position;
+      OMX_TICKS seek_time = 0;
+      OMX_S64 seek_offset = 0;
+
+      TIZ_INIT_OMX_STRUCT (position);
+      tiz_check_omx (tiz_api_GetConfig (tiz_get_krn (handleOf (p_obj)),
+                                        handleOf (p_obj),
+                                        OMX_TizoniaIndexConfigStreamPosition,
+                                        &position));
+
+      /* The request is relative to the current decoding position */
+      p_obj->seek_target_
+        = MAX (timer_to_us (p_obj->timer_) + position.nTimestamp, 0);
+      if (p_obj->duration_ > 0 && p_obj->seek_target_ >= p_obj->duration_)
+        {
+          p_obj->seek_target_ = p_obj->duration_ - 1;
+        }
+
+      find_seek_point (p_obj, p_obj->seek_target_, &seek_time, &seek_offset);
+
+      TIZ_NOTICE (handleOf (p_obj),
+                  "seek target [%lld] us seek point [%lld] us offset [%lld]",
+                  (long long) p_obj->seek_target_, (long long) seek_time,
+                  (long long) seek_offset);
+
+      /* Start over with a clean decoder, and drop the input until the source
+         signals the new position */
+      tiz_check_omx (
+        release_headers (p_obj, ARATELIA_MP3_DECODER_INPUT_PORT_INDEX));
+      deinit_mad_decoder (p_obj);
+      init_mad_decoder (p_obj);
+      reset_stream_parameters (p_obj);
+      p_obj->stream_pos_ = seek_offset;
+      p_obj->awaiting_start_ = true;
+
+      tiz_check_omx (store_stream_position (p_obj, seek_time, seek_offset));
+      tiz_srv_issue_event ((OMX_PTR) p_obj, OMX_EventIndexSettingChanged,
+                           ARATELIA_MP3_DECODER_INPUT_PORT_INDEX,
+                           OMX_TizoniaIndexConfigStreamPosition, NULL);
+    }
+  return OMX_ErrorNone;
+}
+
 static OMX_ERRORTYPE
 mp3d_proc_port_disable (const void * ap_obj, OMX_U32 a_pid)
 {
@@ -882,6 +1211,7 @@ mp3d_proc_port_enable (const void * ap_obj, OMX_U32 a_pid)
   if (OMX_ALL == a_pid || ARATELIA_MP3_DECODER_INPUT_PORT_INDEX == a_pid)
     {
       reset_stream_parameters (p_obj);
+      reset_seek_info (p_obj);
       p_obj->in_port_disabled_ = false;
     }
   if (OMX_ALL == a_pid || ARATELIA_MP3_DECODER_OUTPUT_PORT_INDEX == a_pid)
@@ -957,6 +1287,8 @@ mp3d_prc_init (void * ap_tos, void * ap_hdl)
      tiz_prc_port_disable, mp3d_proc_port_disable,
      /* TIZ_CLASS_COMMENT: */
      tiz_prc_port_enable, mp3d_proc_port_enable,
+     /* TIZ_CLASS_COMMENT: */
+     tiz_prc_config_change, mp3d_proc_config_change,
      /* TIZ_CLASS_COMMENT: stop value */
      0);
 
@@ -38,6 +38,7 @@ extern "C" {
 
 #include <OMX_Core.h>
 
+#include <tizplatform.h>
 #include <tizprc_decls.h>
 
 #define INPUT_BUFFER_SIZE (5 * 8192)
@@ -59,9 +60,24 @@ struct mp3d_prc
   OMX_BUFFERHEADERTYPE * p_inhdr_;
   OMX_BUFFERHEADERTYPE * p_outhdr_;
   int next_synth_sample_;
+  tiz_pcm_dither_t dither_;
   bool eos_;
   bool in_port_disabled_;
   bool out_port_disabled_;
+  OMX_S64 stream_pos_;
+  OMX_S64 first_frame_pos_;
+  OMX_TICKS seek_target_;
+  unsigned long skip_samples_;
+  bool awaiting_start_;
+  bool seek_info_ready_;
+  OMX_TICKS duration_;
+  OMX_S64 total_bytes_;
+  unsigned long bitrate_;
+  unsigned char xing_toc_[100];
+  bool has_xing_toc_;
+  OMX_S64 * p_vbri_toc_;
+  unsigned vbri_entries_;
+  OMX_TICKS vbri_entry_duration_;
 };
 
 typedef struct mp3d_prc_class mp3d_prc_class_t;
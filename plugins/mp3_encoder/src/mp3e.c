@@ -82,7 +82,7 @@ instantiate_pcm_port (OMX_HANDLETYPE ap_hdl)
     ARATELIA_MP3_ENCODER_PORT_ALIGNMENT,
     ARATELIA_MP3_ENCODER_PORT_SUPPLIERPREF,
     {ARATELIA_MP3_ENCODER_INPUT_PORT_INDEX, NULL, NULL, NULL},
-    1                           /* slave port */
+    -1                          /* no slaving; lame resamples as needed */
   };
 
   /* Instantiate the pcm port */
@@ -134,7 +134,7 @@ instantiate_mp3_port (OMX_HANDLETYPE ap_hdl)
     ARATELIA_MP3_ENCODER_PORT_ALIGNMENT,
     ARATELIA_MP3_ENCODER_PORT_SUPPLIERPREF,
     {ARATELIA_MP3_ENCODER_OUTPUT_PORT_INDEX, NULL, NULL, NULL},
-    0                           /* Master port */
+    -1                          /* no slaving; lame resamples as needed */
   };
 
   mp3type.nSize             = sizeof (OMX_AUDIO_PARAM_MP3TYPE);
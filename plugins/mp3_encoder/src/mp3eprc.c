@@ -34,6 +34,8 @@
 #include <limits.h>
 #include <string.h>
 
+#include <OMX_TizoniaExt.h>
+
 #include <tizplatform.h>
 
 #include <tizkernel.h>
@@ -96,6 +98,159 @@ release_buffers (const void *ap_obj)
   return OMX_ErrorNone;
 }
 
+static void
+free_planar_buffers (mp3e_prc_t * ap_prc)
+{
+  assert (ap_prc);
+  tiz_mem_free (ap_prc->p_planar_[0]);
+  tiz_mem_free (ap_prc->p_planar_[1]);
+  ap_prc->p_planar_[0] = NULL;
+  ap_prc->p_planar_[1] = NULL;
+  ap_prc->planar_nsamples_ = 0;
+}
+
+static bool
+alloc_planar_buffers (mp3e_prc_t * ap_prc, const size_t a_nsamples)
+{
+  assert (ap_prc);
+  if (a_nsamples > ap_prc->planar_nsamples_)
+    {
+      free_planar_buffers (ap_prc);
+      if (NULL == (ap_prc->p_planar_[0]
+                   = tiz_mem_alloc (a_nsamples * sizeof (int)))
+          || NULL == (ap_prc->p_planar_[1]
+                      = tiz_mem_alloc (a_nsamples * sizeof (int))))
+        {
+          free_planar_buffers (ap_prc);
+          return false;
+        }
+      ap_prc->planar_nsamples_ = a_nsamples;
+    }
+  return true;
+}
+
+static void
+free_float_buffer (mp3e_prc_t * ap_prc)
+{
+  assert (ap_prc);
+  tiz_mem_free (ap_prc->p_float_);
+  ap_prc->p_float_ = NULL;
+  ap_prc->float_nsamples_ = 0;
+}
+
+static bool
+alloc_float_buffer (mp3e_prc_t * ap_prc, const size_t a_nsamples)
+{
+  assert (ap_prc);
+  if (a_nsamples > ap_prc->float_nsamples_)
+    {
+      free_float_buffer (ap_prc);
+      if (NULL == (ap_prc->p_float_
+                   = tiz_mem_alloc (a_nsamples * sizeof (float))))
+        {
+          return false;
+        }
+      ap_prc->float_nsamples_ = a_nsamples;
+    }
+  return true;
+}
+
+/* 32-bit samples are either float (eNumData is OMX_NumericalDataFloat) or
+ * signed integers; lame only takes the latter as separate channel buffers */
+static int
+encode_s32_samples (mp3e_prc_t * ap_prc, OMX_U8 * ap_in, const int a_nsamples,
+                    OMX_U8 * ap_out, const int a_out_len)
+{
+  assert (ap_prc);
+
+  if (1 == ap_prc->pcmmode_.nChannels)
+    {
+      return lame_encode_buffer_int (ap_prc->lame_, (int *) ap_in,
+                                     (int *) ap_in, a_nsamples, ap_out,
+                                     a_out_len);
+    }
+
+  if (!alloc_planar_buffers (ap_prc, a_nsamples)
+      || OMX_ErrorNone
+           != tiz_pcm_deinterleave ((void * const *) ap_prc->p_planar_, ap_in,
+                                    sizeof (int), 2, a_nsamples))
+    {
+      return -2;
+    }
+
+  return lame_encode_buffer_int (ap_prc->lame_, ap_prc->p_planar_[0],
+                                 ap_prc->p_planar_[1], a_nsamples, ap_out,
+                                 a_out_len);
+}
+
+/* lame has no entry point for 24-bit samples (e.g. from 24-bit FLAC); the
+ * packed samples are converted to float instead */
+static int
+encode_s24_samples (mp3e_prc_t * ap_prc, OMX_U8 * ap_in, const int a_nsamples,
+                    OMX_U8 * ap_out, const int a_out_len)
+{
+  size_t nsamples = 0;
+  assert (ap_prc);
+
+  nsamples = (size_t) a_nsamples * ap_prc->pcmmode_.nChannels;
+  if (!alloc_float_buffer (ap_prc, nsamples)
+      || OMX_ErrorNone != tiz_pcm_to_float (ap_prc->p_float_, ap_in,
+                                            ETIZPcmFmtS24_3, nsamples))
+    {
+      return -2;
+    }
+
+  return 1 == ap_prc->pcmmode_.nChannels
+    ? lame_encode_buffer_ieee_float (ap_prc->lame_, ap_prc->p_float_,
+                                     ap_prc->p_float_, a_nsamples, ap_out,
+                                     a_out_len)
+    : lame_encode_buffer_interleaved_ieee_float (ap_prc->lame_,
+                                                 ap_prc->p_float_,
+                                                 a_nsamples, ap_out,
+                                                 a_out_len);
+}
+
+static int
+encode_samples (mp3e_prc_t * ap_prc, OMX_U8 * ap_in, const int a_nsamples,
+                OMX_U8 * ap_out, const int a_out_len)
+{
+  bool is_float = false;
+  assert (ap_prc);
+  is_float = (OMX_NumericalDataFloat == ap_prc->pcmmode_.eNumData);
+
+  if (!is_float && 32 == ap_prc->pcmmode_.nBitPerSample)
+    {
+      return encode_s32_samples (ap_prc, ap_in, a_nsamples, ap_out,
+                                 a_out_len);
+    }
+
+  if (24 == ap_prc->pcmmode_.nBitPerSample)
+    {
+      return encode_s24_samples (ap_prc, ap_in, a_nsamples, ap_out,
+                                 a_out_len);
+    }
+
+  /* Mono input is fed to both of lame's channels, so that the mp3 stream
+   * keeps the configured channel mode regardless of the input */
+  if (1 == ap_prc->pcmmode_.nChannels)
+    {
+      return is_float
+        ? lame_encode_buffer_ieee_float (ap_prc->lame_, (float *) ap_in,
+                                         (float *) ap_in, a_nsamples,
+                                         ap_out, a_out_len)
+        : lame_encode_buffer (ap_prc->lame_, (short int *) ap_in,
+                              (short int *) ap_in, a_nsamples,
+                              ap_out, a_out_len);
+    }
+
+  return is_float
+    ? lame_encode_buffer_interleaved_ieee_float (ap_prc->lame_,
+                                                 (float *) ap_in, a_nsamples,
+                                                 ap_out, a_out_len)
+    : lame_encode_buffer_interleaved (ap_prc->lame_, (short int *) ap_in,
+                                      a_nsamples, ap_out, a_out_len);
+}
+
 static OMX_ERRORTYPE
 encode_buffer (const void *ap_obj)
 {
@@ -112,9 +267,9 @@ encode_buffer (const void *ap_obj)
           p_obj->eos_ = true;
         }
 
-      nsamples = (p_obj->p_inhdr_->nFilledLen
-                  / p_obj->pcmmode_.nChannels /
-                  p_obj->pcmmode_.nBitPerSample) * 8;
+      nsamples = p_obj->p_inhdr_->nFilledLen
+                 / (p_obj->pcmmode_.nChannels
+                    * (p_obj->pcmmode_.nBitPerSample / 8));
 
       TIZ_TRACE (handleOf (ap_obj),
                 "p_inhdr [%p] nsamples [%d] nFilledLen [%d] "
@@ -124,14 +279,14 @@ encode_buffer (const void *ap_obj)
                 p_obj->pcmmode_.nBitPerSample, p_obj->p_inhdr_->nOffset);
 
       if (0 > (encoded_bytes
-               = lame_encode_buffer_interleaved
-               (p_obj->lame_,
-                (short int *) (p_obj->p_inhdr_->pBuffer
-                               + p_obj->p_inhdr_->nOffset),
-                nsamples,
-                p_obj->p_outhdr_->pBuffer
-                + p_obj->p_outhdr_->nOffset,
-                p_obj->p_outhdr_->nAllocLen - p_obj->p_outhdr_->nFilledLen)))
+               = encode_samples (p_obj,
+                                 p_obj->p_inhdr_->pBuffer
+                                 + p_obj->p_inhdr_->nOffset,
+                                 nsamples,
+                                 p_obj->p_outhdr_->pBuffer
+                                 + p_obj->p_outhdr_->nOffset,
+                                 p_obj->p_outhdr_->nAllocLen
+                                 - p_obj->p_outhdr_->nFilledLen)))
         {
           if (encoded_bytes == -1)
             {
@@ -279,6 +434,24 @@ set_lame_pcm_settings (void *ap_obj, OMX_HANDLETYPE ap_hdl, void *ap_krn)
              p_prc->pcmmode_.bInterleaved ? "OMX_TRUE" : "OMX_FALSE",
              p_prc->pcmmode_.ePCMMode);
 
+  /* 16-bit, packed 24-bit or 32-bit signed, or 32-bit float (as produced by
+   * the opus and vorbis decoders) samples; mono or interleaved stereo */
+  if ((OMX_NumericalDataFloat == p_prc->pcmmode_.eNumData
+       ? 32 != p_prc->pcmmode_.nBitPerSample
+       : (16 != p_prc->pcmmode_.nBitPerSample
+          && 24 != p_prc->pcmmode_.nBitPerSample
+          && 32 != p_prc->pcmmode_.nBitPerSample))
+      || p_prc->pcmmode_.nChannels < 1 || p_prc->pcmmode_.nChannels > 2)
+    {
+      TIZ_ERROR (handleOf (p_prc), "[OMX_ErrorUnsupportedSetting] : "
+                 "Unsupported pcm format");
+      return OMX_ErrorUnsupportedSetting;
+    }
+
+  /* The input sampling rate comes from the pcm port; lame resamples to the
+   * mp3 port's rate, if one has been set there */
+  (void) lame_set_in_samplerate (p_prc->lame_, p_prc->pcmmode_.nSamplingRate);
+
   return ret_val;
 }
 
@@ -306,7 +479,7 @@ set_lame_mp3_settings (void *ap_obj, OMX_HANDLETYPE ap_hdl, void *ap_krn)
       return ret_val;
     }
 
-  TIZ_ERROR (handleOf (p_prc), "nChannels = [%d] nBitRate = [%d] "
+  TIZ_TRACE (handleOf (p_prc), "nChannels = [%d] nBitRate = [%d] "
              "nSampleRate = [%d] nAudioBandWidth = [%d] eChannelMode = [%d] "
              "eFormat = [%d]",
              p_prc->mp3type_.nChannels,
@@ -315,9 +488,21 @@ set_lame_mp3_settings (void *ap_obj, OMX_HANDLETYPE ap_hdl, void *ap_krn)
              p_prc->mp3type_.nAudioBandWidth,
              p_prc->mp3type_.eChannelMode, p_prc->mp3type_.eFormat);
 
-  (void) lame_set_num_channels (p_prc->lame_, p_prc->mp3type_.nChannels);
-  (void) lame_set_in_samplerate (p_prc->lame_, p_prc->mp3type_.nSampleRate);
-  (void) lame_set_brate (p_prc->lame_, p_prc->mp3type_.nBitRate);
+  /* Mono input is duplicated into both channels (see encode_samples), unless
+   * the output is mono too */
+  (void) lame_set_num_channels
+    (p_prc->lame_, (1 == p_prc->mp3type_.nChannels
+                    && 1 == p_prc->pcmmode_.nChannels) ? 1 : 2);
+  if (p_prc->mp3type_.nSampleRate > 0)
+    {
+      (void) lame_set_out_samplerate (p_prc->lame_,
+                                      p_prc->mp3type_.nSampleRate);
+    }
+  if (p_prc->mp3type_.nBitRate > 0)
+    {
+      /* OpenMAX IL bit rates are in bits per second; lame's are in kbps */
+      (void) lame_set_brate (p_prc->lame_, p_prc->mp3type_.nBitRate / 1000);
+    }
 
   switch (p_prc->mp3type_.eChannelMode)
     {
@@ -370,6 +555,11 @@ mp3e_proc_ctor (void *ap_obj, va_list * app)
   p_prc->p_outhdr_ = 0;
   p_prc->eos_ = false;
   p_prc->lame_flushed_ = true;
+  p_prc->p_planar_[0] = NULL;
+  p_prc->p_planar_[1] = NULL;
+  p_prc->planar_nsamples_ = 0;
+  p_prc->p_float_ = NULL;
+  p_prc->float_nsamples_ = 0;
   return p_prc;
 }
 
@@ -384,6 +574,8 @@ mp3e_proc_dtor (void *ap_obj)
       lame_close (p_prc->lame_);
       p_prc->lame_ = NULL;
     }
+  free_planar_buffers (p_prc);
+  free_float_buffer (p_prc);
 
   return super_dtor (typeOf (ap_obj, "mp3eprc"), ap_obj);
 }
@@ -427,6 +619,8 @@ mp3e_proc_deallocate_resources (void *ap_obj)
       lame_close (p_prc->lame_);
       p_prc->lame_ = NULL;
     }
+  free_planar_buffers (p_prc);
+  free_float_buffer (p_prc);
 
   return OMX_ErrorNone;
 }
@@ -444,14 +638,16 @@ mp3e_proc_prepare_to_transfer (void *ap_obj, OMX_U32 TIZ_UNUSED (a_pid))
       return OMX_ErrorNone;
     }
 
-  if (OMX_ErrorNone != (ret_val = set_lame_mp3_settings (p_prc,
+  /* The pcm settings go first; the number of channels given to lame depends
+   * on them */
+  if (OMX_ErrorNone != (ret_val = set_lame_pcm_settings (p_prc,
                                                          handleOf (p_prc),
                                                          tiz_get_krn (handleOf (p_prc)))))
     {
       return ret_val;
     }
 
-  if (OMX_ErrorNone != (ret_val = set_lame_pcm_settings (p_prc,
+  if (OMX_ErrorNone != (ret_val = set_lame_mp3_settings (p_prc,
                                                          handleOf (p_prc),
                                                          tiz_get_krn (handleOf (p_prc)))))
     {
@@ -465,6 +661,8 @@ mp3e_proc_prepare_to_transfer (void *ap_obj, OMX_U32 TIZ_UNUSED (a_pid))
       return OMX_ErrorInsufficientResources;
     }
 
+  p_prc->frame_size_ = 0;
+  p_prc->eos_ = false;
   p_prc->lame_flushed_ = false;
 
   return OMX_ErrorNone;
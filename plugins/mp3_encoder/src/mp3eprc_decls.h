@@ -58,6 +58,10 @@ extern "C"
     OMX_BUFFERHEADERTYPE *p_outhdr_;
     bool eos_;
     bool lame_flushed_;
+    int *p_planar_[2];          /* s32 stereo input, deinterleaved for lame */
+    size_t planar_nsamples_;
+    float *p_float_;            /* s24 input, converted to float for lame */
+    size_t float_nsamples_;
   };
 
   typedef struct mp3e_prc_class mp3e_prc_class_t;
@@ -36,6 +36,8 @@
 #include <unistd.h>
 #include <limits.h>
 
+#include <OMX_TizoniaExt.h>
+
 #include <tizplatform.h>
 
 #include <tizkernel.h>
@@ -234,8 +236,10 @@ alloc_oggz (oggdmux_prc_t * ap_prc)
   assert (ap_prc);
   assert (!ap_prc->p_oggz_);
 
-  /* Allocate the oggz object */
-  tiz_check_null_ret_oom ((ap_prc->p_oggz_ = oggz_new (OGGZ_READ)));
+  /* Allocate the oggz object. OGGZ_AUTO installs the granulepos metrics of
+     the known codecs, which are needed to seek by time. */
+  tiz_check_null_ret_oom (
+    (ap_prc->p_oggz_ = oggz_new (OGGZ_READ | OGGZ_AUTO)));
 
   /* Allocate a table */
   tiz_check_null_ret_oom ((ap_prc->p_tracks_ = oggz_table_new ()));
@@ -557,6 +561,15 @@ release_header (oggdmux_prc_t * ap_prc, const OMX_U32 a_pid)
              "nFilledLen [%d] nFlags [%d]",
              p_hdr, a_pid, p_hdr->nFilledLen, p_hdr->nFlags);
 
+  if (ap_prc->seeked_ && a_pid == ARATELIA_OGG_DEMUXER_AUDIO_PORT_BASE_INDEX
+      && p_hdr->nFilledLen > 0)
+    {
+      /* First audio data after a seek */
+      p_hdr->nFlags |= OMX_BUFFERFLAG_STARTTIME;
+      p_hdr->nTimeStamp = ap_prc->seek_time_;
+      ap_prc->seeked_ = false;
+    }
+
   /* TODO: Check for OOM error and issue Error Event */
   p_hdr->nOffset = 0;
   (void) tiz_krn_release_buffer (tiz_get_krn (handleOf (ap_prc)), a_pid, p_hdr);
@@ -895,6 +908,41 @@ seek_to_byte_offset (oggdmux_prc_t * ap_prc, const oggz_off_t a_offset)
   return OMX_ErrorNone;
 }
 
+static OMX_ERRORTYPE
+seek_to_time (oggdmux_prc_t * ap_prc, const OMX_TICKS a_time_us)
+{
+  ogg_int64_t units = 0;
+  assert (ap_prc);
+
+  /* Whatever is still held belongs to the old position; the decoder will drop
+     it while it waits for the STARTTIME buffer */
+  tiz_check_omx (release_all_buffers (ap_prc, OMX_ALL));
+  ap_prc->aud_store_offset_ = 0;
+  ap_prc->vid_store_offset_ = 0;
+
+  /* Units are milliseconds. liboggz bisects on the granule positions and
+     lands on the page boundary that precedes the requested time. */
+  if ((units = oggz_seek_units (ap_prc->p_oggz_, a_time_us / 1000, SEEK_SET))
+      < 0)
+    {
+      TIZ_ERROR (handleOf (ap_prc), "Unable to seek to time [%lld] us",
+                 (long long) a_time_us);
+      return OMX_ErrorUndefined;
+    }
+
+  TIZ_NOTICE (handleOf (ap_prc), "Seeked to [%lld] ms (requested [%lld] ms)",
+              (long long) units, (long long) (a_time_us / 1000));
+
+  ap_prc->file_eos_ = false;
+  ap_prc->aud_eos_ = false;
+  ap_prc->vid_eos_ = false;
+  ap_prc->seeked_ = true;
+  ap_prc->seek_time_ = units * 1000;
+  ap_prc->awaiting_buffers_ = true;
+
+  return OMX_ErrorNone;
+}
+
 static inline OMX_ERRORTYPE
 set_read_page_callback (oggdmux_prc_t * ap_prc, OggzReadPage ap_read_cback)
 {
@@ -1101,6 +1149,8 @@ oggdmux_prc_ctor (void * ap_obj, va_list * app)
   p_prc->vid_eos_ = false;
   p_prc->aud_port_disabled_ = false;
   p_prc->vid_port_disabled_ = false;
+  p_prc->seeked_ = false;
+  p_prc->seek_time_ = 0;
 
   return p_prc;
 }
@@ -1241,6 +1291,29 @@ oggdmux_prc_port_enable (const void * ap_obj, OMX_U32 a_pid)
   return OMX_ErrorNone;
 }
 
+static OMX_ERRORTYPE
+oggdmux_prc_config_change (void * ap_obj, OMX_U32 TIZ_UNUSED (a_pid),
+                           OMX_INDEXTYPE a_config_idx)
+{
+  oggdmux_prc_t * p_prc = ap_obj;
+  assert (p_prc);
+
+  if (OMX_TizoniaIndexConfigStreamPosition == a_config_idx && p_prc->p_oggz_)
+    {
+      OMX_TIZONIA_STREAMPOSITIONTYPE position;
+      TIZ_INIT_OMX_STRUCT (position);
+      tiz_check_omx (tiz_api_GetConfig (tiz_get_krn (handleOf (p_prc)),
+                                        handleOf (p_prc),
+                                        OMX_TizoniaIndexConfigStreamPosition,
+                                        &position));
+      /* Byte offsets computed by a decoder refer to the elementary stream,
+         not to the container, so always seek by time here */
+      tiz_check_omx (seek_to_time (p_prc, MAX (position.nTimestamp, 0)));
+      tiz_check_omx (oggdmux_prc_buffers_ready (p_prc));
+    }
+  return OMX_ErrorNone;
+}
+
 /*
  * oggdmux_prc_class
  */
@@ -1305,6 +1378,8 @@ oggdmux_prc_init (void * ap_tos, void * ap_hdl)
      tiz_prc_port_enable, oggdmux_prc_port_enable,
      /* TIZ_CLASS_COMMENT: */
      tiz_prc_buffers_ready, oggdmux_prc_buffers_ready,
+     /* TIZ_CLASS_COMMENT: */
+     tiz_prc_config_change, oggdmux_prc_config_change,
      /* TIZ_CLASS_COMMENT: stop value*/
      0);
 
@@ -63,6 +63,8 @@ struct oggdmux_prc
   bool vid_eos_;
   bool aud_port_disabled_;
   bool vid_port_disabled_;
+  bool seeked_;
+  OMX_TICKS seek_time_;
 };
 
 typedef struct oggdmux_prc_class oggdmux_prc_class_t;
@@ -109,7 +109,7 @@ instantiate_pcm_port (OMX_HANDLETYPE ap_hdl)
     OMX_PortDomainAudio,
     OMX_DirOutput,
     ARATELIA_OPUS_DECODER_PORT_MIN_BUF_COUNT,
-    ARATELIA_OPUS_DECODER_PORT_MIN_OUTPUT_BUF_SIZE,
+    sizeof (float) * ARATELIA_OPUS_DECODER_PORT_MIN_OUTPUT_BUF_SIZE,
     ARATELIA_OPUS_DECODER_PORT_NONCONTIGUOUS,
     ARATELIA_OPUS_DECODER_PORT_ALIGNMENT,
     ARATELIA_OPUS_DECODER_PORT_SUPPLIERPREF,
@@ -122,10 +122,10 @@ instantiate_pcm_port (OMX_HANDLETYPE ap_hdl)
   pcmmode.nVersion.nVersion = OMX_VERSION;
   pcmmode.nPortIndex = ARATELIA_OPUS_DECODER_OUTPUT_PORT_INDEX;
   pcmmode.nChannels = 2;
-  pcmmode.eNumData = OMX_NumericalDataSigned;
-  pcmmode.eEndian = OMX_EndianBig;
+  pcmmode.eNumData = OMX_NumericalDataFloat;
+  pcmmode.eEndian = OMX_EndianLittle;
   pcmmode.bInterleaved = OMX_TRUE;
-  pcmmode.nBitPerSample = 16;
+  pcmmode.nBitPerSample = 32; /* This component outputs float samples */
   pcmmode.nSamplingRate = 48000;
   pcmmode.ePCMMode = OMX_AUDIO_PCMModeLinear;
   pcmmode.eChannelMapping[0] = OMX_AUDIO_ChannelLF;
@@ -39,25 +39,13 @@
 
 #include <tizkernel.h>
 
+#include <OMX_TizoniaExt.h>
+
 #include "opusd.h"
 #include "opusutils.h"
 #include "opusdprc.h"
 #include "opusdprc_decls.h"
 
-#ifdef HAVE_LRINTF
-#define float2int(x) lrintf (x)
-#else
-#define float2int(flt) ((int) (floor (.5 + flt)))
-#endif
-
-#ifndef HAVE_FMINF
-#define fminf(_x, _y) ((_x) < (_y) ? (_x) : (_y))
-#endif
-
-#ifndef HAVE_FMAXF
-#define fmaxf(_x, _y) ((_x) > (_y) ? (_x) : (_y))
-#endif
-
 #ifdef TIZ_LOG_CATEGORY_NAME
 #undef TIZ_LOG_CATEGORY_NAME
 #define TIZ_LOG_CATEGORY_NAME "tiz.opus_decoder.prc"
@@ -262,6 +250,35 @@ update_pcm_mode (opusd_prc_t * ap_prc, const OMX_U32 a_samplerate,
   return OMX_ErrorNone;
 }
 
+static inline OMX_TICKS
+samples_to_us (const opusd_prc_t * ap_prc, const OMX_S64 a_samples)
+{
+  assert (ap_prc);
+  return ap_prc->rate_ > 0 ? (a_samples * 1000000) / ap_prc->rate_ : 0;
+}
+
+static inline OMX_S64
+us_to_samples (const opusd_prc_t * ap_prc, const OMX_TICKS a_us)
+{
+  assert (ap_prc);
+  return (a_us * ap_prc->rate_) / 1000000;
+}
+
+static OMX_ERRORTYPE
+store_stream_position (opusd_prc_t * ap_prc, const OMX_TICKS a_timestamp,
+                       const OMX_S64 a_byte_offset)
+{
+  OMX_TIZONIA_STREAMPOSITIONTYPE position;
+  assert (ap_prc);
+  TIZ_INIT_OMX_PORT_STRUCT (position, ARATELIA_OPUS_DECODER_INPUT_PORT_INDEX);
+  position.nTimestamp = a_timestamp;
+  position.nByteOffset = a_byte_offset;
+  return tiz_krn_SetConfig_internal (tiz_get_krn (handleOf (ap_prc)),
+                                     handleOf (ap_prc),
+                                     OMX_TizoniaIndexConfigStreamPosition,
+                                     &position);
+}
+
 static OMX_ERRORTYPE
 init_opus_decoder (opusd_prc_t * ap_prc)
 {
@@ -319,6 +336,10 @@ init_opus_decoder (opusd_prc_t * ap_prc)
     store_stream_metadata (ap_prc);
     (void) update_pcm_mode (ap_prc, ap_prc->rate_, ap_prc->channels_);
 
+    /* Opus packets are seeked by time in the container; the byte offset is
+       left to the demuxer. */
+    (void) store_stream_position (ap_prc, 0, -1);
+
     p_in->nOffset += header_offset;
     p_in->nFilledLen -= header_offset;
     if (0 == p_in->nFilledLen)
@@ -400,6 +421,28 @@ transform_buffer (opusd_prc_t * ap_prc)
       return OMX_ErrorNone;
     }
 
+  if (ap_prc->awaiting_start_)
+    {
+      if (0 == (p_in->nFlags & OMX_BUFFERFLAG_STARTTIME))
+        {
+          /* Stale packet from before the seek */
+          p_in->nFilledLen = 0;
+          p_in->nFlags = 0;
+          return release_header (ap_prc,
+                                 ARATELIA_OPUS_DECODER_INPUT_PORT_INDEX);
+        }
+      /* First packet at the new position; the samples between the page
+         time and the requested time are discarded */
+      opus_multistream_decoder_ctl (ap_prc->p_opus_dec_, OPUS_RESET_STATE);
+      ap_prc->position_ = us_to_samples (ap_prc, p_in->nTimeStamp);
+      ap_prc->skip_samples_ = MAX (
+        us_to_samples (ap_prc, ap_prc->seek_target_ - p_in->nTimeStamp), 0);
+      ap_prc->awaiting_start_ = false;
+      TIZ_DEBUG (handleOf (ap_prc), "resync at [%lld] us skip [%lld] samples",
+                 (long long) p_in->nTimeStamp,
+                 (long long) ap_prc->skip_samples_);
+    }
+
   if (0 == p_in->nFilledLen)
     {
       TIZ_TRACE (handleOf (ap_prc), "HEADER [%p] nFlags [%d] is empty", p_in,
@@ -422,9 +465,7 @@ transform_buffer (opusd_prc_t * ap_prc)
     opus_int32 len = p_in->nFilledLen;
     int fec = 0;
     float * output = NULL;
-    short * out = NULL;
     unsigned out_len = 0;
-    int i = 0;
     int tmp_skip = 0;
     int frame_size = opus_multistream_decode_float (ap_prc->p_opus_dec_, p_data,
                                                     len, ap_prc->p_out_buf_,
@@ -443,15 +484,20 @@ transform_buffer (opusd_prc_t * ap_prc)
         ap_prc->preskip_ -= tmp_skip;
         output = ap_prc->p_out_buf_ + ap_prc->channels_ * tmp_skip;
         out_len = frame_size - tmp_skip;
+        ap_prc->position_ += out_len;
 
-        /* Convert to short and save to output file */
-        out = (short *) (p_out->pBuffer + p_out->nOffset);
-        for (i = 0; i < (int) out_len * ap_prc->channels_; ++i)
+        if (ap_prc->skip_samples_ > 0)
           {
-            out[i] = (short) float2int (
-              fmaxf (-32768, fminf (output[i] * 32768.f, 32767)));
+            tmp_skip = MIN (ap_prc->skip_samples_, (OMX_S64) out_len);
+            ap_prc->skip_samples_ -= tmp_skip;
+            output += ap_prc->channels_ * tmp_skip;
+            out_len -= tmp_skip;
           }
 
+        /* The output port carries the decoder's native float samples */
+        (void) memcpy (p_out->pBuffer + p_out->nOffset, output,
+                       out_len * ap_prc->channels_ * sizeof (float));
+
         if ((p_in->nFlags & OMX_BUFFERFLAG_EOS) > 0)
           {
             /* Propagate EOS flag to output */
@@ -459,7 +505,7 @@ transform_buffer (opusd_prc_t * ap_prc)
             p_in->nFlags &= ~(1 << OMX_BUFFERFLAG_EOS);
           }
 
-        p_out->nFilledLen = out_len * ap_prc->channels_ * 2;
+        p_out->nFilledLen = out_len * ap_prc->channels_ * sizeof (float);
         TIZ_TRACE (handleOf (ap_prc),
                    "frame_size [%d] len [%d] - error [%s] nFilledLen [%d]",
                    frame_size, len, opus_strerror (frame_size),
@@ -522,6 +568,10 @@ reset_stream_parameters (opusd_prc_t * ap_prc)
   ap_prc->mapping_family_ = 0;
   ap_prc->channels_ = 0;
   ap_prc->preskip_ = 0;
+  ap_prc->position_ = 0;
+  ap_prc->skip_samples_ = 0;
+  ap_prc->seek_target_ = 0;
+  ap_prc->awaiting_start_ = false;
   ap_prc->eos_ = false;
   ap_prc->opus_header_parsed_ = false;
   ap_prc->opus_comments_parsed_ = false;
@@ -602,7 +652,9 @@ opusd_prc_prepare_to_transfer (void * ap_obj, OMX_U32 a_pid)
              p_prc->pcmmode_.nSamplingRate, p_prc->pcmmode_.nChannels);
 
   reset_stream_parameters (ap_obj);
-  return OMX_ErrorNone;
+
+  /* Not seekable until the stream header has been parsed */
+  return store_stream_position (p_prc, -1, -1);
 }
 
 static OMX_ERRORTYPE
@@ -665,6 +717,46 @@ opusd_prc_port_flush (const void * ap_obj, OMX_U32 a_pid)
   return release_headers (p_obj, a_pid);
 }
 
+static OMX_ERRORTYPE
+opusd_prc_config_change (void * ap_prc, OMX_U32 TIZ_UNUSED (a_pid),
+                         OMX_INDEXTYPE a_config_idx)
+{
+  opusd_prc_t * p_prc = ap_prc;
+  assert (p_prc);
+
+  if (OMX_TizoniaIndexConfigStreamPosition == a_config_idx
+      && p_prc->opus_header_parsed_)
+    {
+      OMX_TIZONIA_STREAMPOSITIONTYPE position;
+
+      TIZ_INIT_OMX_STRUCT (position);
+      tiz_check_omx (tiz_api_GetConfig (tiz_get_krn (handleOf (p_prc)),
+                                        handleOf (p_prc),
+                                        OMX_TizoniaIndexConfigStreamPosition,
+                                        &position));
+
+      /* The request is relative to the current decoding position */
+      p_prc->seek_target_ = MAX (
+        samples_to_us (p_prc, p_prc->position_) + position.nTimestamp, 0);
+
+      TIZ_NOTICE (handleOf (p_prc), "seek target [%lld] us",
+                  (long long) p_prc->seek_target_);
+
+      /* Drop the input until the demuxer signals the new position */
+      tiz_check_omx (
+        release_headers (p_prc, ARATELIA_OPUS_DECODER_INPUT_PORT_INDEX));
+      p_prc->skip_samples_ = 0;
+      p_prc->eos_ = false;
+      p_prc->awaiting_start_ = true;
+
+      tiz_check_omx (store_stream_position (p_prc, p_prc->seek_target_, -1));
+      tiz_srv_issue_event ((OMX_PTR) p_prc, OMX_EventIndexSettingChanged,
+                           ARATELIA_OPUS_DECODER_INPUT_PORT_INDEX,
+                           OMX_TizoniaIndexConfigStreamPosition, NULL);
+    }
+  return OMX_ErrorNone;
+}
+
 static OMX_ERRORTYPE
 opusd_prc_port_disable (const void * ap_prc, OMX_U32 a_pid)
 {
@@ -761,6 +853,8 @@ opusd_prc_init (void * ap_tos, void * ap_hdl)
      /* TIZ_CLASS_COMMENT: */
      tiz_prc_port_flush, opusd_prc_port_flush,
      /* TIZ_CLASS_COMMENT: */
+     tiz_prc_config_change, opusd_prc_config_change,
+     /* TIZ_CLASS_COMMENT: */
      tiz_prc_port_disable, opusd_prc_port_disable,
      /* TIZ_CLASS_COMMENT: */
      tiz_prc_port_enable, opusd_prc_port_enable,
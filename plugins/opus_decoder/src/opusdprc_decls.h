@@ -54,6 +54,10 @@ struct opusd_prc
   int mapping_family_;
   int channels_;
   int preskip_;
+  OMX_S64 position_;
+  OMX_S64 skip_samples_;
+  OMX_TICKS seek_target_;
+  bool awaiting_start_;
   bool eos_;
   bool in_port_disabled_;
   bool out_port_disabled_;
@@ -122,8 +122,8 @@ instantiate_pcm_port (OMX_HANDLETYPE ap_hdl)
   pcmmode.nVersion.nVersion = OMX_VERSION;
   pcmmode.nPortIndex = ARATELIA_OPUS_DECODER_OUTPUT_PORT_INDEX;
   pcmmode.nChannels = 2;
-  pcmmode.eNumData = OMX_NumericalDataSigned;
-  pcmmode.eEndian = OMX_EndianBig;
+  pcmmode.eNumData = OMX_NumericalDataFloat;
+  pcmmode.eEndian = OMX_EndianLittle;
   pcmmode.bInterleaved = OMX_TRUE;
   pcmmode.nBitPerSample
     = 32; /* This component will output 32-bit float samples */
@@ -91,7 +91,10 @@ allocate_temp_data_store (opusfiled_prc_t * ap_prc)
                           OMX_IndexParamPortDefinition, &port_def));
 
   assert (ap_prc->p_store_ == NULL);
-  return tiz_buffer_init (&(ap_prc->p_store_), port_def.nBufferSize);
+  tiz_check_omx (tiz_buffer_init (&(ap_prc->p_store_), port_def.nBufferSize));
+  /* If this fails, the store simply stays linear */
+  (void) tiz_buffer_seek_mode (ap_prc->p_store_, TIZ_BUFFER_CIRCULAR);
+  return OMX_ErrorNone;
 }
 
 static inline void
@@ -134,12 +137,20 @@ release_input_header (opusfiled_prc_t * ap_prc)
   return OMX_ErrorNone;
 }
 
+/* Bytes in the store that libopusfile has not read yet */
+static size_t
+store_bytes_unread (const opusfiled_prc_t * ap_prc)
+{
+  const size_t nbytes = tiz_buffer_available (ap_prc->p_store_);
+  return nbytes > ap_prc->store_offset_ ? nbytes - ap_prc->store_offset_ : 0;
+}
+
 static bool
 store_data (opusfiled_prc_t * ap_prc)
 {
   bool rc = true;
 
-  if ((tiz_buffer_available (ap_prc->p_store_) - ap_prc->store_offset_)
+  if (store_bytes_unread (ap_prc)
       < ARATELIA_OPUS_DECODER_PORT_MIN_INPUT_BUF_SIZE)
     {
       OMX_BUFFERHEADERTYPE * p_in = tiz_filter_prc_get_header (
@@ -149,7 +160,7 @@ store_data (opusfiled_prc_t * ap_prc)
 
       if (p_in)
         {
-          TIZ_TRACE (handleOf (ap_prc), "store available [%d]",
+          TIZ_TRACE (handleOf (ap_prc), "store available [%zu]",
                      tiz_buffer_available (ap_prc->p_store_));
           if (tiz_buffer_push (ap_prc->p_store_, p_in->pBuffer + p_in->nOffset,
                                p_in->nFilledLen)
@@ -175,14 +186,13 @@ read_cback (void * ap_private, unsigned char * ap_ptr, int a_nbytes)
   (void) store_data (p_prc);
 
   TIZ_TRACE (handleOf (p_prc),
-             "decoder_inited_ [%s] store bytes [%d] offset [%d]",
+             "decoder_inited_ [%s] store bytes [%zu] offset [%d]",
              (p_prc->decoder_inited_ ? "YES" : "NO"),
              tiz_buffer_available (p_prc->p_store_), p_prc->store_offset_);
 
   if (tiz_buffer_available (p_prc->p_store_) > 0)
     {
-      bytes_read = MIN (a_nbytes, tiz_buffer_available (p_prc->p_store_)
-                                    - p_prc->store_offset_);
+      bytes_read = MIN ((size_t) a_nbytes, store_bytes_unread (p_prc));
       memcpy (ap_ptr, tiz_buffer_get (p_prc->p_store_) + p_prc->store_offset_,
               bytes_read);
       if (p_prc->decoder_inited_)
@@ -257,7 +267,7 @@ transform_buffer (opusfiled_prc_t * ap_prc)
 
   if (tiz_buffer_available (ap_prc->p_store_) == 0 || NULL == p_out)
     {
-      TIZ_TRACE (handleOf (ap_prc), "store bytes [%d] OUT HEADER [%p]",
+      TIZ_TRACE (handleOf (ap_prc), "store bytes [%zu] OUT HEADER [%p]",
                  tiz_buffer_available (ap_prc->p_store_), p_out);
 
       /* Propagate the EOS flag to the next component */
@@ -114,7 +114,10 @@ static OMX_ERRORTYPE allocate_temp_data_store (sndfiled_prc_t *ap_prc)
       tiz_api_GetParameter (tiz_get_krn (handleOf (ap_prc)), handleOf (ap_prc),
                             OMX_IndexParamPortDefinition, &port_def));
   assert (ap_prc->p_store_ == NULL);
-  return tiz_buffer_init (&(ap_prc->p_store_), port_def.nBufferSize);
+  tiz_check_omx (tiz_buffer_init (&(ap_prc->p_store_), port_def.nBufferSize));
+  /* If this fails, the store simply stays linear */
+  (void) tiz_buffer_seek_mode (ap_prc->p_store_, TIZ_BUFFER_CIRCULAR);
+  return OMX_ErrorNone;
 }
 
 static inline void deallocate_temp_data_store (
@@ -127,12 +130,19 @@ static inline void deallocate_temp_data_store (
   ap_prc->p_store_ = NULL;
 }
 
+/* Bytes in the store that libsndfile has not read yet */
+static size_t store_bytes_unread (const sndfiled_prc_t *ap_prc)
+{
+  const size_t nbytes = tiz_buffer_available (ap_prc->p_store_);
+  return nbytes > ap_prc->store_offset_ ? nbytes - ap_prc->store_offset_ : 0;
+}
+
 static bool store_data (sndfiled_prc_t *ap_prc)
 {
   bool rc = true;
   assert (ap_prc);
 
-  if ((tiz_buffer_available (ap_prc->p_store_) - ap_prc->store_offset_)
+  if (store_bytes_unread (ap_prc)
       < ARATELIA_PCM_DECODER_PORT_MIN_INPUT_BUF_SIZE * 2)
     {
       OMX_BUFFERHEADERTYPE *p_in = tiz_filter_prc_get_header (
@@ -146,7 +156,7 @@ static bool store_data (sndfiled_prc_t *ap_prc)
                                      p_in->pBuffer + p_in->nOffset,
                                      p_in->nFilledLen) == p_in->nFilledLen)
             {
-              TIZ_TRACE (handleOf (ap_prc), "store bytes [%d]",
+              TIZ_TRACE (handleOf (ap_prc), "store bytes [%zu]",
                          tiz_buffer_available (ap_prc->p_store_));
               release_in_hdr (ap_prc);
             }
@@ -186,12 +196,11 @@ static sf_count_t sf_io_read (void *ap_ptr, sf_count_t count, void *user_data)
       && tiz_buffer_available (p_prc->p_store_) > 0)
     {
       TIZ_TRACE (handleOf (p_prc),
-                 "count [%d] decoder_inited_ [%s] store bytes [%d] offset [%d]",
+                 "count [%d] decoder_inited_ [%s] store bytes [%zu] offset [%d]",
                  count, (p_prc->decoder_inited_ ? "YES" : "NO"),
                  tiz_buffer_available (p_prc->p_store_),
                  p_prc->store_offset_);
-      bytes_read = MIN (count, tiz_buffer_available (p_prc->p_store_)
-                               - p_prc->store_offset_);
+      bytes_read = MIN (count, (sf_count_t) store_bytes_unread (p_prc));
       memcpy (ap_ptr,
               tiz_buffer_get (p_prc->p_store_) + p_prc->store_offset_,
               bytes_read);
@@ -56,7 +56,7 @@ extern "C"
   ARATELIA_AUDIO_RENDERER_NULL_ALSA_DEVICE
 #define ARATELIA_AUDIO_RENDERER_DEFAULT_ALSA_MIXER  "Master"
 
-#define ARATELIA_AUDIO_RENDERER_DEFAULT_RAMP_STEP_COUNT 20
+#define ARATELIA_AUDIO_RENDERER_DEFAULT_RAMP_DURATION_MS 4000
 
 #ifdef __cplusplus
 }
@@ -32,9 +32,10 @@
 
 #include <assert.h>
 #include <errno.h>
-#include <math.h>
+#include <stdint.h>
 #include <string.h>
-#include <byteswap.h>
+
+#include <OMX_TizoniaExt.h>
 
 #include <tizplatform.h>
 
@@ -144,12 +145,47 @@ print_msg:
   TIZ_LOG (TIZ_PRIORITY_ERROR, "%s", err_msg);
 }
 
+static bool is_alsa_pcm_format_supported (ar_prc_t *ap_prc,
+                                           const snd_pcm_format_t a_format)
+{
+  assert (ap_prc);
+  return (SND_PCM_FORMAT_UNKNOWN != a_format
+          && 0 == snd_pcm_hw_params_test_format (
+                      ap_prc->p_pcm_, ap_prc->p_hw_params_, a_format));
+}
+
+static snd_pcm_format_t opposite_byte_order (const snd_pcm_format_t a_format)
+{
+  switch (a_format)
+    {
+      case SND_PCM_FORMAT_FLOAT_LE:
+        return SND_PCM_FORMAT_FLOAT_BE;
+      case SND_PCM_FORMAT_FLOAT_BE:
+        return SND_PCM_FORMAT_FLOAT_LE;
+      case SND_PCM_FORMAT_S32_LE:
+        return SND_PCM_FORMAT_S32_BE;
+      case SND_PCM_FORMAT_S32_BE:
+        return SND_PCM_FORMAT_S32_LE;
+      case SND_PCM_FORMAT_S24_3LE:
+        return SND_PCM_FORMAT_S24_3BE;
+      case SND_PCM_FORMAT_S24_3BE:
+        return SND_PCM_FORMAT_S24_3LE;
+      case SND_PCM_FORMAT_S16_LE:
+        return SND_PCM_FORMAT_S16_BE;
+      case SND_PCM_FORMAT_S16_BE:
+        return SND_PCM_FORMAT_S16_LE;
+      default:
+        break;
+    };
+  return SND_PCM_FORMAT_UNKNOWN;
+}
+
 static void verify_alsa_pcm_format_support (
     ar_prc_t *ap_prc, snd_pcm_format_t *ap_snd_pcm_format)
 {
   int fmt = 0;
   snd_pcm_format_mask_t *fmask = NULL;
-  bool is_supported_format = false;
+  snd_pcm_format_t opposite = SND_PCM_FORMAT_UNKNOWN;
 
   assert (ap_prc);
   assert (ap_snd_pcm_format);
@@ -161,71 +197,59 @@ static void verify_alsa_pcm_format_support (
     {
       if (snd_pcm_format_mask_test (fmask, (snd_pcm_format_t)fmt))
         {
-          const snd_pcm_format_t supported_format = snd_pcm_format_value (
-              snd_pcm_format_name ((snd_pcm_format_t)fmt));
           TIZ_DEBUG (handleOf (ap_prc), "%s : byte order [%s]",
                      snd_pcm_format_name ((snd_pcm_format_t)fmt),
-                     snd_pcm_format_little_endian (supported_format) == 1
+                     snd_pcm_format_little_endian ((snd_pcm_format_t)fmt)
+                             == 1
                          ? "LITTLE"
                          : "BIG");
-          if (supported_format == *ap_snd_pcm_format)
-            {
-              is_supported_format = true;
-              TIZ_DEBUG (handleOf (ap_prc),
-                         "%s : format supported by the alsa pcm",
-                         snd_pcm_format_name ((snd_pcm_format_t)fmt));
-              break;
-            }
         }
     }
 
-  if (!is_supported_format)
+  if (is_alsa_pcm_format_supported (ap_prc, *ap_snd_pcm_format))
+    {
+      TIZ_DEBUG (handleOf (ap_prc), "%s : format supported by the alsa pcm",
+                 snd_pcm_format_name (*ap_snd_pcm_format));
+      return;
+    }
+
+  /* Same sample format, opposite byte order: the samples are swapped before
+     being written */
+  opposite = opposite_byte_order (*ap_snd_pcm_format);
+  if (is_alsa_pcm_format_supported (ap_prc, opposite))
     {
       ap_prc->swap_byte_order_ = true;
+      *ap_snd_pcm_format = opposite;
+      return;
+    }
 
-      switch (*ap_snd_pcm_format)
-        {
-          case SND_PCM_FORMAT_FLOAT_LE:
-            {
-              *ap_snd_pcm_format = SND_PCM_FORMAT_FLOAT_BE;
-            }
-            break;
-          case SND_PCM_FORMAT_FLOAT_BE:
-            {
-              *ap_snd_pcm_format = SND_PCM_FORMAT_FLOAT_LE;
-            }
-            break;
-          case SND_PCM_FORMAT_S24:
-            {
-              *ap_snd_pcm_format = SND_PCM_FORMAT_S24_BE;
-            }
-            break;
-          case SND_PCM_FORMAT_S24_BE:
-            {
-              *ap_snd_pcm_format = SND_PCM_FORMAT_S24;
-            }
-            break;
-          case SND_PCM_FORMAT_S16:
-            {
-              *ap_snd_pcm_format = SND_PCM_FORMAT_S16_BE;
-            }
-            break;
-          case SND_PCM_FORMAT_S16_BE:
-            {
-              *ap_snd_pcm_format = SND_PCM_FORMAT_S16;
-            }
-            break;
-          default:
-            {
-            }
-            break;
-        };
+  /* Packed 24-bit samples are widened to 32 bits, which is lossless and
+     what most hardware that lacks S24_3 supports */
+  if ((SND_PCM_FORMAT_S24_3LE == *ap_snd_pcm_format
+       || SND_PCM_FORMAT_S24_3BE == *ap_snd_pcm_format)
+      && is_alsa_pcm_format_supported (ap_prc, SND_PCM_FORMAT_S32))
+    {
+      ap_prc->widen_s24_3_ = true;
+      *ap_snd_pcm_format = SND_PCM_FORMAT_S32;
+      return;
     }
+
+  /* Nothing better to offer; alsa-lib will convert, if the pcm allows it */
+  TIZ_NOTICE (handleOf (ap_prc), "%s : format not supported by the alsa pcm",
+              snd_pcm_format_name (*ap_snd_pcm_format));
+}
+
+static const char *numerical_data_to_str (const OMX_NUMERICALDATATYPE a_data)
+{
+  return OMX_NumericalDataFloat == a_data
+             ? "FLOAT"
+             : (OMX_NumericalDataSigned == a_data ? "SIGNED" : "UNSIGNED");
 }
 
 static OMX_ERRORTYPE retrieve_alsa_pcm_format (
     ar_prc_t *ap_prc, snd_pcm_format_t *ap_snd_pcm_format)
 {
+  bool little = false;
 
   assert (ap_prc);
   assert (ap_snd_pcm_format);
@@ -237,28 +261,47 @@ static OMX_ERRORTYPE retrieve_alsa_pcm_format (
       tiz_api_GetParameter (tiz_get_krn (handleOf (ap_prc)), handleOf (ap_prc),
                             OMX_IndexParamAudioPcm, &ap_prc->pcmmode));
 
-  if (ap_prc->pcmmode.nBitPerSample == 24)
+  little = (ap_prc->pcmmode.eEndian == OMX_EndianLittle);
+  switch (ap_prc->pcmmode.nBitPerSample)
     {
-      *ap_snd_pcm_format = ap_prc->pcmmode.eEndian == OMX_EndianLittle
-                           ? SND_PCM_FORMAT_S24
-                           : SND_PCM_FORMAT_S24_BE;
-    }
-  /* NOTE: this is to allow float pcm streams coming from the the vorbis or
-     opusfile decoders */
-  else if (ap_prc->pcmmode.nBitPerSample == 32)
-    {
-      *ap_snd_pcm_format = ap_prc->pcmmode.eEndian == OMX_EndianLittle
-                           ? SND_PCM_FORMAT_FLOAT_LE
-                           : SND_PCM_FORMAT_FLOAT_BE;
-    }
-  else
-    {
-      *ap_snd_pcm_format = ap_prc->pcmmode.eEndian == OMX_EndianLittle
-                           ? SND_PCM_FORMAT_S16
-                           : SND_PCM_FORMAT_S16_BE;
-    }
+      case 8:
+        {
+          *ap_snd_pcm_format
+              = ap_prc->pcmmode.eNumData == OMX_NumericalDataUnsigned
+                    ? SND_PCM_FORMAT_U8
+                    : SND_PCM_FORMAT_S8;
+        }
+        break;
+      case 24:
+        {
+          /* Packed, 3 bytes per sample */
+          *ap_snd_pcm_format
+              = little ? SND_PCM_FORMAT_S24_3LE : SND_PCM_FORMAT_S24_3BE;
+        }
+        break;
+      case 32:
+        {
+          if (ap_prc->pcmmode.eNumData == OMX_NumericalDataFloat)
+            {
+              *ap_snd_pcm_format
+                  = little ? SND_PCM_FORMAT_FLOAT_LE : SND_PCM_FORMAT_FLOAT_BE;
+            }
+          else
+            {
+              *ap_snd_pcm_format
+                  = little ? SND_PCM_FORMAT_S32_LE : SND_PCM_FORMAT_S32_BE;
+            }
+        }
+        break;
+      default:
+        {
+          *ap_snd_pcm_format
+              = little ? SND_PCM_FORMAT_S16_LE : SND_PCM_FORMAT_S16_BE;
+        }
+        break;
+    };
 
-  verify_alsa_pcm_format_support(ap_prc, ap_snd_pcm_format);
+  verify_alsa_pcm_format_support (ap_prc, ap_snd_pcm_format);
 
   TIZ_NOTICE (
       handleOf (ap_prc),
@@ -267,8 +310,7 @@ static OMX_ERRORTYPE retrieve_alsa_pcm_format (
       "bInterleaved = [%s] ePCMMode = [%d] snd_pcm_format = [%s]",
       ap_prc->pcmmode.nChannels, ap_prc->pcmmode.nBitPerSample,
       ap_prc->pcmmode.nSamplingRate,
-      ap_prc->pcmmode.eNumData == OMX_NumericalDataSigned ? "SIGNED"
-                                                          : "UNSIGNED",
+      numerical_data_to_str (ap_prc->pcmmode.eNumData),
       ap_prc->pcmmode.eEndian == OMX_EndianBig ? "BIG" : "LITTLE",
       ap_prc->pcmmode.bInterleaved == OMX_TRUE ? "OMX_TRUE" : "OMX_FALSE",
       ap_prc->pcmmode.ePCMMode,
@@ -374,6 +416,7 @@ static OMX_ERRORTYPE release_header (ar_prc_t *ap_prc)
           tiz_get_krn (handleOf (ap_prc)), ARATELIA_AUDIO_RENDERER_PORT_INDEX,
           ap_prc->p_inhdr_));
       ap_prc->p_inhdr_ = NULL;
+      ap_prc->inhdr_processed_ = false;
     }
   return OMX_ErrorNone;
 }
@@ -391,104 +434,133 @@ static inline OMX_ERRORTYPE do_flush (ar_prc_t *ap_prc)
   return release_header (ap_prc);
 }
 
-static float sint_to_float (const int a_sample)
+static tiz_pcm_fmt_t get_pcm_sample_format (const ar_prc_t *ap_prc)
 {
-  float f;
-  if (a_sample >= 0)
-    f = a_sample / 32767.0;
-  else
-    f = a_sample / 32768.0;
-  return f;
+  assert (ap_prc);
+  switch (ap_prc->pcmmode.nBitPerSample)
+    {
+      case 16:
+        return ETIZPcmFmtS16;
+      case 24:
+        return ETIZPcmFmtS24_3;
+      case 32:
+        return ap_prc->pcmmode.eNumData == OMX_NumericalDataFloat
+                   ? ETIZPcmFmtFloat
+                   : ETIZPcmFmtS32;
+      default:
+        break;
+    };
+  return ETIZPcmFmtMax;
 }
 
-static int float_to_sint (const float a_sample)
+static bool is_host_byte_order (const OMX_ENDIANTYPE a_endian)
 {
-  float f;
-  f = a_sample * 32767;
-  if (f < -32768)
-    f = -32768;
-  if (f > 32767)
-    f = 32767;
-  return (int)f;
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  return OMX_EndianBig == a_endian;
+#else
+  return OMX_EndianLittle == a_endian;
+#endif
 }
 
-static void adjust_gain (const ar_prc_t *ap_prc, OMX_BUFFERHEADERTYPE *ap_hdr,
-                         const snd_pcm_uframes_t a_samples_per_channel)
+static void process_pcm (ar_prc_t *ap_prc, OMX_BUFFERHEADERTYPE *ap_hdr,
+                         const snd_pcm_uframes_t a_frames)
 {
+  tiz_pcm_fmt_t fmt = ETIZPcmFmtMax;
+  size_t width = 0;
+  size_t nsamples = 0;
+  bool host_order = false;
+  bool swap = false;
+  OMX_U8 *p_pcm = NULL;
+
   assert (ap_prc);
   assert (ap_hdr);
+  assert (ap_hdr->pBuffer);
+
+  fmt = get_pcm_sample_format (ap_prc);
+  width = ap_prc->pcmmode.nBitPerSample / 8;
+  nsamples = a_frames * ap_prc->pcmmode.nChannels;
+  host_order = is_host_byte_order (ap_prc->pcmmode.eEndian);
+  swap = ap_prc->swap_byte_order_;
+  p_pcm = ap_hdr->pBuffer + ap_hdr->nOffset;
 
-  if (ARATELIA_AUDIO_RENDERER_DEFAULT_GAIN_VALUE != ap_prc->gain_)
+  if (ETIZPcmFmtMax != fmt
+      && (1.f != ap_prc->gain_factor_ || ap_prc->ramp_frames_ > 0))
     {
-      int i;
-      int gainadj = (int)(ap_prc->gain_ * 256.);
-      float gain = pow (10., gainadj / 5120.);
-      /*       gain = 3.1f; */
-      /*       fprintf (stderr, "%f samples %ld\n", gain, a_samples_per_channel); */
-      OMX_S16 *pcm = (OMX_S16 *)(ap_hdr->pBuffer + ap_hdr->nOffset);
-      for (i = 0; i < a_samples_per_channel; i++)
+      const snd_pcm_uframes_t ramp_frames
+          = MIN (a_frames, (snd_pcm_uframes_t)ap_prc->ramp_frames_);
+      const size_t ramp_samples = ramp_frames * ap_prc->pcmmode.nChannels;
+
+      /* Gain and ramps operate on samples in host byte order */
+      if (!host_order)
         {
-          float f = sint_to_float (*pcm);
-          f *= gain;
-          int v = float_to_sint (f);
-          *(pcm++) = (v > 32767) ? 32767 : ((v < -32768) ? -32768 : v);
-          f = sint_to_float (*pcm);
-          f *= gain;
-          v = float_to_sint (f);
-          *(pcm++) = (v > 32767) ? 32767 : ((v < -32768) ? -32768 : v);
+          (void)tiz_pcm_swap (p_pcm, width, nsamples);
         }
-    }
-}
 
-static void swap_byte_order_s16 (const ar_prc_t *ap_prc, OMX_BUFFERHEADERTYPE *ap_hdr,
-                                 const int a_samples)
-{
-  assert (ap_prc);
-  assert (ap_hdr);
-  assert (ap_hdr->pBuffer);
+      if (ramp_frames > 0)
+        {
+          (void)tiz_pcm_ramp (p_pcm, fmt, ramp_frames,
+                              ap_prc->pcmmode.nChannels,
+                              ap_prc->ramp_gain_ * ap_prc->gain_factor_,
+                              ap_prc->ramp_gain_step_ * ap_prc->gain_factor_);
+          ap_prc->ramp_gain_ += (float)ramp_frames * ap_prc->ramp_gain_step_;
+          ap_prc->ramp_frames_ -= ramp_frames;
+        }
 
-  {
-    OMX_S16 *p_pcm = (OMX_S16 *)(ap_hdr->pBuffer + ap_hdr->nOffset);
-    int i = 0;
-    for (i = 0; i < a_samples; ++i)
-      {
-        *p_pcm = bswap_16(*p_pcm);
-        p_pcm++;
-      }
-  }
+      (void)tiz_pcm_gain (p_pcm + ramp_samples * width, fmt,
+                          nsamples - ramp_samples, ap_prc->gain_factor_);
+
+      /* The samples are now in host byte order, but the pcm wants them in
+         their original order or, if swap_byte_order_ is set, in the
+         opposite one */
+      swap = (host_order == ap_prc->swap_byte_order_);
+    }
+
+  if (swap)
+    {
+      TIZ_DEBUG (handleOf (ap_prc),
+                 "nBitPerSample = [%d] nFilledLen = [%d] samples = [%d] "
+                 "nOffset = [%d]",
+                 ap_prc->pcmmode.nBitPerSample, ap_hdr->nFilledLen, (int)nsamples,
+                 ap_hdr->nOffset);
+      (void)tiz_pcm_swap (p_pcm, width, nsamples);
+    }
 }
 
-static void swap_byte_order (const ar_prc_t *ap_prc,
-                             OMX_BUFFERHEADERTYPE *ap_hdr)
+/* Expands the header's packed 24-bit samples into host-order 32-bit ones,
+   for pcms that support S32 but not S24_3 (see
+   verify_alsa_pcm_format_support) */
+static OMX_ERRORTYPE widen_pcm (ar_prc_t *ap_prc,
+                                const OMX_BUFFERHEADERTYPE *ap_hdr,
+                                const snd_pcm_uframes_t a_frames)
 {
+  const size_t nsamples = a_frames * ap_prc->pcmmode.nChannels;
+  const bool little = (ap_prc->pcmmode.eEndian == OMX_EndianLittle);
+  const uint8_t *p_from = ap_hdr->pBuffer + ap_hdr->nOffset;
+  size_t i = 0;
+
   assert (ap_prc);
   assert (ap_hdr);
 
-  if (ap_prc->swap_byte_order_ && !ap_hdr->nOffset)
+  if (nsamples * sizeof (int32_t) > ap_prc->wide_alloc_len_)
     {
-      const int bytes_per_sample = ap_prc->pcmmode.nBitPerSample / 8;
-      const int samples = ap_hdr->nFilledLen / bytes_per_sample;
-      TIZ_DEBUG (handleOf (ap_prc),
-                 "nBitPerSample = [%d] "
-                 "nFilledLen = [%d] "
-                 "samples = [%d]"
-                 "nOffset = [%d]",
-                 ap_prc->pcmmode.nBitPerSample, ap_hdr->nFilledLen, samples,
-                 ap_hdr->nOffset);
+      int32_t *p_wide = tiz_mem_realloc (ap_prc->p_wide_,
+                                         nsamples * sizeof (int32_t));
+      tiz_check_null_ret_oom (p_wide);
+      ap_prc->p_wide_ = p_wide;
+      ap_prc->wide_alloc_len_ = nsamples * sizeof (int32_t);
+    }
 
-      switch (ap_prc->pcmmode.nBitPerSample)
-        {
-        case 16:
-          {
-            swap_byte_order_s16 (ap_prc, ap_hdr, samples);
-          }
-          break;
-        default:
-          {
-          }
-          break;
-        };
+  for (i = 0; i < nsamples; ++i, p_from += 3)
+    {
+      const uint32_t word
+          = little ? ((uint32_t)p_from[0] << 8 | (uint32_t)p_from[1] << 16
+                      | (uint32_t)p_from[2] << 24)
+                   : ((uint32_t)p_from[2] << 8 | (uint32_t)p_from[1] << 16
+                      | (uint32_t)p_from[0] << 24);
+      ap_prc->p_wide_[i] = (int32_t)word;
     }
+  ap_prc->wide_offset_ = 0;
+  return OMX_ErrorNone;
 }
 
 static OMX_ERRORTYPE get_alsa_master_volume (ar_prc_t *ap_prc,
@@ -649,37 +721,22 @@ static void prepare_volume_ramp (ar_prc_t *ap_prc)
   assert (ap_prc);
   if (ap_prc->ramp_enabled_)
     {
-      ap_prc->ramp_volume_ = ARATELIA_AUDIO_RENDERER_DEFAULT_VOLUME_VALUE;
-      ap_prc->ramp_step_count_
-          = ARATELIA_AUDIO_RENDERER_DEFAULT_RAMP_STEP_COUNT;
-      ap_prc->ramp_step_ = (double)ap_prc->ramp_volume_
-                           / (double)ap_prc->ramp_step_count_;
+      /* Fade in from silence. The ramp is applied to the samples as they are
+         rendered (see process_pcm) */
+      ap_prc->ramp_frames_
+          = (ap_prc->pcmmode.nSamplingRate
+             * ARATELIA_AUDIO_RENDERER_DEFAULT_RAMP_DURATION_MS)
+            / 1000;
+      ap_prc->ramp_gain_ = 0.f;
+      ap_prc->ramp_gain_step_
+          = ap_prc->ramp_frames_ > 0 ? 1.f / (float)ap_prc->ramp_frames_ : 0.f;
     }
 }
 
-static OMX_ERRORTYPE start_volume_ramp (ar_prc_t *ap_prc)
-{
-  assert (ap_prc);
-  if (ap_prc->ramp_enabled_)
-    {
-      assert (ap_prc->p_vol_ramp_timer_);
-      ap_prc->ramp_volume_ = 0;
-      tiz_check_omx (
-          tiz_srv_timer_watcher_start (ap_prc, ap_prc->p_vol_ramp_timer_, 0.2, 0.2));
-    }
-  return OMX_ErrorNone;
-}
-
 static void stop_volume_ramp (ar_prc_t *ap_prc)
 {
   assert (ap_prc);
-  if (ap_prc->ramp_enabled_)
-    {
-      if (ap_prc->p_vol_ramp_timer_)
-        {
-          (void)tiz_srv_timer_watcher_stop (ap_prc, ap_prc->p_vol_ramp_timer_);
-        }
-    }
+  ap_prc->ramp_frames_ = 0;
 }
 
 static OMX_ERRORTYPE start_eos_timer (ar_prc_t *ap_prc)
@@ -712,24 +769,6 @@ static void stop_eos_timer (ar_prc_t *ap_prc)
     }
 }
 
-static OMX_ERRORTYPE apply_ramp_step (ar_prc_t *ap_prc)
-{
-  assert (ap_prc);
-  if (ap_prc->ramp_enabled_)
-    {
-      if (ap_prc->ramp_step_count_-- > 0)
-        {
-          ap_prc->ramp_volume_ += ap_prc->ramp_step_;
-          set_volume (ap_prc, ap_prc->ramp_volume_);
-        }
-      else
-        {
-          stop_volume_ramp (ap_prc);
-        }
-    }
-  return OMX_ErrorNone;
-}
-
 static OMX_ERRORTYPE render_buffer (ar_prc_t *ap_prc,
                                     OMX_BUFFERHEADERTYPE *ap_hdr)
 {
@@ -744,14 +783,26 @@ static OMX_ERRORTYPE render_buffer (ar_prc_t *ap_prc,
   assert (ap_hdr->nFilledLen > 0);
   samples_per_channel = ap_hdr->nFilledLen / step;
 
-  adjust_gain (ap_prc, ap_hdr, samples_per_channel);
-  swap_byte_order (ap_prc, ap_hdr);
+  /* A header may take several writes to be rendered; make sure its samples
+     are only processed once */
+  if (!ap_prc->inhdr_processed_)
+    {
+      process_pcm (ap_prc, ap_hdr, samples_per_channel);
+      if (ap_prc->widen_s24_3_)
+        {
+          tiz_check_omx (widen_pcm (ap_prc, ap_hdr, samples_per_channel));
+        }
+      ap_prc->inhdr_processed_ = true;
+    }
 
   while (samples_per_channel > 0 && OMX_ErrorNone == rc)
     {
+      const void *p_data
+          = ap_prc->widen_s24_3_
+                ? (const void *)(ap_prc->p_wide_ + ap_prc->wide_offset_)
+                : (const void *)(ap_hdr->pBuffer + ap_hdr->nOffset);
       snd_pcm_sframes_t err
-          = snd_pcm_writei (ap_prc->p_pcm_, ap_hdr->pBuffer + ap_hdr->nOffset,
-                            samples_per_channel);
+          = snd_pcm_writei (ap_prc->p_pcm_, p_data, samples_per_channel);
 
       if (-EAGAIN == err)
         {
@@ -774,6 +825,7 @@ static OMX_ERRORTYPE render_buffer (ar_prc_t *ap_prc,
         {
           ap_hdr->nOffset += err * step;
           ap_hdr->nFilledLen -= err * step;
+          ap_prc->wide_offset_ += err * ap_prc->pcmmode.nChannels;
           samples_per_channel -= err;
         }
     }
@@ -874,21 +926,26 @@ static void *ar_prc_ctor (void *ap_prc, va_list *app)
   p_prc->p_pcm_name_ = NULL;
   p_prc->p_mixer_name_ = NULL;
   p_prc->swap_byte_order_ = false;
+  p_prc->widen_s24_3_ = false;
+  p_prc->p_wide_ = NULL;
+  p_prc->wide_alloc_len_ = 0;
+  p_prc->wide_offset_ = 0;
   p_prc->descriptor_count_ = 0;
   p_prc->p_fds_ = NULL;
   p_prc->p_ev_io_ = NULL;
-  p_prc->p_vol_ramp_timer_ = NULL;
   p_prc->p_eos_timer_ = NULL;
   p_prc->p_inhdr_ = NULL;
+  p_prc->inhdr_processed_ = false;
   p_prc->port_disabled_ = false;
   p_prc->awaiting_io_ev_ = false;
   p_prc->nflags_ = 0;
   p_prc->gain_ = ARATELIA_AUDIO_RENDERER_DEFAULT_GAIN_VALUE;
+  p_prc->gain_factor_ = tiz_pcm_db_to_gain (p_prc->gain_);
   p_prc->volume_ = ARATELIA_AUDIO_RENDERER_DEFAULT_VOLUME_VALUE;
   p_prc->ramp_enabled_ = false;
-  p_prc->ramp_step_ = 0;
-  p_prc->ramp_step_count_ = ARATELIA_AUDIO_RENDERER_DEFAULT_RAMP_STEP_COUNT;
-  p_prc->ramp_volume_ = 0;
+  p_prc->ramp_gain_ = 0.f;
+  p_prc->ramp_gain_step_ = 0.f;
+  p_prc->ramp_frames_ = 0;
   return p_prc;
 }
 
@@ -939,13 +996,6 @@ static OMX_ERRORTYPE ar_prc_allocate_resources (void *ap_prc,
           = tiz_mem_alloc (sizeof(struct pollfd) * p_prc->descriptor_count_);
       tiz_check_null_ret_oom (p_prc->p_fds_ != NULL);
 
-      /* This is to generate volume ramps when needed */
-      if (p_prc->ramp_enabled_)
-        {
-          tiz_check_omx (
-              tiz_srv_timer_watcher_init (p_prc, &(p_prc->p_vol_ramp_timer_)));
-        }
-
       /* This is to produce accurate EOS flag events */
       tiz_check_omx (
           tiz_srv_timer_watcher_init (p_prc, &(p_prc->p_eos_timer_)));
@@ -968,6 +1018,7 @@ static OMX_ERRORTYPE ar_prc_prepare_to_transfer (void *ap_prc,
       snd_pcm_format_t snd_pcm_format;
 
       p_prc->swap_byte_order_ = false;
+      p_prc->widen_s24_3_ = false;
 
       log_alsa_pcm_state (p_prc);
 
@@ -1020,8 +1071,6 @@ static OMX_ERRORTYPE ar_prc_transfer_and_process (void *ap_prc,
   assert (p_prc);
   log_alsa_pcm_state (p_prc);
   prepare_volume_ramp (p_prc);
-  tiz_check_omx (start_volume_ramp (p_prc));
-  tiz_check_omx (apply_ramp_step (p_prc));
   return OMX_ErrorNone;
 }
 
@@ -1041,16 +1090,14 @@ static OMX_ERRORTYPE ar_prc_deallocate_resources (void *ap_prc)
   tiz_srv_timer_watcher_destroy (p_prc, p_prc->p_eos_timer_);
   p_prc->p_eos_timer_ = NULL;
 
-  if (p_prc->ramp_enabled_)
-    {
-      tiz_srv_timer_watcher_destroy (p_prc, p_prc->p_vol_ramp_timer_);
-      p_prc->p_vol_ramp_timer_ = NULL;
-    }
-
   p_prc->descriptor_count_ = 0;
   tiz_mem_free (p_prc->p_fds_);
   p_prc->p_fds_ = NULL;
 
+  tiz_mem_free (p_prc->p_wide_);
+  p_prc->p_wide_ = NULL;
+  p_prc->wide_alloc_len_ = 0;
+
   tiz_srv_io_watcher_destroy (p_prc, p_prc->p_ev_io_);
   p_prc->p_ev_io_ = NULL;
 
@@ -1120,10 +1167,6 @@ static OMX_ERRORTYPE ar_prc_timer_ready (void *ap_prc,
       tiz_srv_issue_event ((OMX_PTR)ap_prc, OMX_EventBufferFlag, 0,
                            p_prc->nflags_, NULL);
     }
-  else if (ap_ev_timer == p_prc->p_vol_ramp_timer_)
-    {
-      rc = apply_ramp_step (ap_prc);
-    }
   else
     {
       assert (0);
@@ -35,6 +35,7 @@ extern "C"
 #endif
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <alsa/asoundlib.h>
 #include <poll.h>
 
@@ -53,21 +54,26 @@ extern "C"
     char *p_pcm_name_;
     char *p_mixer_name_;
     bool swap_byte_order_;
+    bool widen_s24_3_;
+    int32_t *p_wide_;
+    size_t wide_alloc_len_;
+    size_t wide_offset_;
     int descriptor_count_;
     struct pollfd *p_fds_;
     tiz_event_io_t *p_ev_io_;
-    tiz_event_timer_t *p_vol_ramp_timer_;
     tiz_event_timer_t *p_eos_timer_;
     OMX_BUFFERHEADERTYPE *p_inhdr_;
+    bool inhdr_processed_;
     bool port_disabled_;
     bool awaiting_io_ev_;
     OMX_U32 nflags_;
     float gain_;
+    float gain_factor_;
     long volume_;
     bool ramp_enabled_;
-    long ramp_step_;
-    long ramp_step_count_;
-    long ramp_volume_;
+    float ramp_gain_;
+    float ramp_gain_step_;
+    OMX_U32 ramp_frames_;
   };
 
   typedef struct ar_prc_class ar_prc_class_t;
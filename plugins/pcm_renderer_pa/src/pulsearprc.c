@@ -31,8 +31,12 @@
 #endif
 
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 #include <assert.h>
 
+#include <OMX_TizoniaExt.h>
+
 #include <tizplatform.h>
 
 #include <tizkernel.h>
@@ -163,104 +167,231 @@ ready_to_process (pulsear_prc_t * ap_prc)
           && !ap_prc->port_disabled_ && !ap_prc->stopped_);
 }
 
-static OMX_BUFFERHEADERTYPE *
-get_header (pulsear_prc_t * ap_prc)
+/* Claims headers until they hold enough data for the next PA write. Returns
+   the number of bytes in the claimed headers. */
+static size_t
+claim_headers (pulsear_prc_t * ap_prc)
 {
-  OMX_BUFFERHEADERTYPE * p_hdr = NULL;
+  size_t nbytes = 0;
+  size_t i = 0;
   assert (ap_prc);
 
-  if (!ap_prc->port_disabled_)
+  for (i = 0; i < ap_prc->ninhdrs_; ++i)
+    {
+      nbytes += ap_prc->p_inhdrs_[i]->nFilledLen;
+    }
+
+  while (!ap_prc->port_disabled_ && nbytes < ap_prc->pa_nbytes_
+         && ap_prc->ninhdrs_ < PULSEAR_MAX_INHDRS)
     {
-      if (!ap_prc->p_inhdr_)
+      OMX_BUFFERHEADERTYPE * p_hdr = NULL;
+      (void) tiz_krn_claim_buffer (tiz_get_krn (handleOf (ap_prc)),
+                                   ARATELIA_PCM_RENDERER_PORT_INDEX, 0,
+                                   &p_hdr);
+      if (!p_hdr)
         {
-          (void) tiz_krn_claim_buffer (tiz_get_krn (handleOf (ap_prc)),
-                                       ARATELIA_PCM_RENDERER_PORT_INDEX, 0,
-                                       &ap_prc->p_inhdr_);
-          if (ap_prc->p_inhdr_)
-            {
-              TIZ_TRACE (handleOf (ap_prc),
-                         "Claimed HEADER [%p]...nFilledLen [%d]",
-                         ap_prc->p_inhdr_, ap_prc->p_inhdr_->nFilledLen);
-            }
+          break;
         }
-      p_hdr = ap_prc->p_inhdr_;
+      TIZ_TRACE (handleOf (ap_prc), "Claimed HEADER [%p]...nFilledLen [%d]",
+                 p_hdr, p_hdr->nFilledLen);
+      ap_prc->p_inhdrs_[ap_prc->ninhdrs_++] = p_hdr;
+      nbytes += p_hdr->nFilledLen;
+      ap_prc->eos_ = false;
     }
-  return p_hdr;
+
+  return nbytes;
 }
 
 static OMX_ERRORTYPE
-release_header (pulsear_prc_t * ap_prc)
+release_header (pulsear_prc_t * ap_prc, OMX_BUFFERHEADERTYPE * ap_hdr)
 {
   assert (ap_prc);
+  assert (ap_hdr);
+
+  TIZ_TRACE (handleOf (ap_prc), "Releasing HEADER [%p] emptied", ap_hdr);
+  ap_hdr->nOffset = 0;
+  ap_hdr->nFilledLen = 0;
+  return tiz_krn_release_buffer (tiz_get_krn (handleOf (ap_prc)),
+                                 ARATELIA_PCM_RENDERER_PORT_INDEX, ap_hdr);
+}
 
-  if (ap_prc->p_inhdr_)
+static OMX_ERRORTYPE
+release_headers (pulsear_prc_t * ap_prc)
+{
+  size_t i = 0;
+  assert (ap_prc);
+
+  for (i = 0; i < ap_prc->ninhdrs_; ++i)
     {
-      TIZ_TRACE (handleOf (ap_prc), "Releasing HEADER [%p] emptied",
-                 ap_prc->p_inhdr_);
-      ap_prc->p_inhdr_->nOffset = 0;
-      ap_prc->p_inhdr_->nFilledLen = 0;
-      tiz_check_omx (tiz_krn_release_buffer (tiz_get_krn (handleOf (ap_prc)),
-                                             ARATELIA_PCM_RENDERER_PORT_INDEX,
-                                             ap_prc->p_inhdr_));
-      ap_prc->p_inhdr_ = NULL;
+      tiz_check_omx (release_header (ap_prc, ap_prc->p_inhdrs_[i]));
     }
+  ap_prc->ninhdrs_ = 0;
   return OMX_ErrorNone;
 }
 
+/* Returns the headers that have been fully written, in the order they were
+   claimed, and issues the EOS event if one of them carries the flag. */
 static OMX_ERRORTYPE
-buffer_emptied (pulsear_prc_t * ap_prc)
+release_emptied_headers (pulsear_prc_t * ap_prc)
 {
+  size_t nemptied = 0;
+  size_t i = 0;
   assert (ap_prc);
-  assert (ap_prc->p_inhdr_);
-  assert (ap_prc->p_inhdr_->nFilledLen == 0);
 
-  if ((ap_prc->p_inhdr_->nFlags & OMX_BUFFERFLAG_EOS) != 0)
+  while (nemptied < ap_prc->ninhdrs_
+         && 0 == ap_prc->p_inhdrs_[nemptied]->nFilledLen)
+    {
+      OMX_BUFFERHEADERTYPE * p_hdr = ap_prc->p_inhdrs_[nemptied++];
+      if ((p_hdr->nFlags & OMX_BUFFERFLAG_EOS) != 0)
+        {
+          TIZ_DEBUG (handleOf (ap_prc), "OMX_BUFFERFLAG_EOS in HEADER [%p]",
+                     p_hdr);
+          tiz_srv_issue_event ((OMX_PTR) ap_prc, OMX_EventBufferFlag, 0,
+                               p_hdr->nFlags, NULL);
+          ap_prc->eos_ = true;
+        }
+      tiz_check_omx (release_header (ap_prc, p_hdr));
+    }
+
+  for (i = nemptied; i < ap_prc->ninhdrs_; ++i)
     {
-      TIZ_DEBUG (handleOf (ap_prc), "OMX_BUFFERFLAG_EOS in HEADER [%p]",
-                 ap_prc->p_inhdr_);
-      tiz_srv_issue_event ((OMX_PTR) ap_prc, OMX_EventBufferFlag, 0,
-                           ap_prc->p_inhdr_->nFlags, NULL);
+      ap_prc->p_inhdrs_[i - nemptied] = ap_prc->p_inhdrs_[i];
     }
+  ap_prc->ninhdrs_ -= nemptied;
+  return OMX_ErrorNone;
+}
+
+static unsigned long long
+monotonic_ns (void)
+{
+  struct timespec ts;
+  (void) clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (unsigned long long) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
 
-  return release_header (ap_prc);
+static void
+log_render_stats (pulsear_prc_t * ap_prc)
+{
+  pulsear_prc_stats_t * p_stats = NULL;
+  assert (ap_prc);
+  p_stats = &(ap_prc->stats_);
+  if (p_stats->nwrites_ > 0)
+    {
+      TIZ_DEBUG (handleOf (ap_prc),
+                 "writes [%lu] copies [%lu] bytes [%llu] "
+                 "lock held avg [%llu ns] max [%llu ns]",
+                 p_stats->nwrites_, p_stats->ncopies_, p_stats->nbytes_,
+                 p_stats->lock_ns_ / p_stats->nwrites_, p_stats->lock_max_ns_);
+    }
+  tiz_mem_set (p_stats, 0, sizeof (pulsear_prc_stats_t));
+}
+
+/* Fills one PulseAudio write buffer with the data in the claimed OMX headers,
+   and hands it to the server in a single pa_stream_write call. The buffer
+   comes from pa_stream_begin_write, i.e. it is the memblock (in the server's
+   shared memory pool) that PA will send, so the samples are copied once,
+   straight from the OMX buffers into it. Only the PA calls and the copy run
+   with the mainloop lock held; headers are claimed before and released after
+   by the caller. Returns the number of bytes written. */
+static size_t
+write_pcm_data (pulsear_prc_t * ap_prc)
+{
+  void * p_pa_buf = NULL;
+  size_t pa_buf_len = ap_prc->pa_nbytes_;
+  size_t filled = 0;
+  size_t i = 0;
+  bool write_failed = false;
+  unsigned long long lock_start = 0;
+  unsigned long long lock_ns = 0;
+
+  assert (ap_prc);
+  assert (ap_prc->p_pa_loop_);
+  assert (ap_prc->p_pa_context_);
+
+  pa_threaded_mainloop_lock (ap_prc->p_pa_loop_);
+  lock_start = monotonic_ns ();
+
+  if (pa_stream_begin_write (ap_prc->p_pa_stream_, &p_pa_buf, &pa_buf_len) < 0
+      || !p_pa_buf)
+    {
+      pa_threaded_mainloop_unlock (ap_prc->p_pa_loop_);
+      TIZ_ERROR (handleOf (ap_prc), "pa_stream_begin_write : %s",
+                 pa_strerror (pa_context_errno (ap_prc->p_pa_context_)));
+      return 0;
+    }
+
+  /* PA may offer less than requested, but never more */
+  pa_buf_len = MIN (pa_buf_len, ap_prc->pa_nbytes_);
+  for (i = 0; i < ap_prc->ninhdrs_ && filled < pa_buf_len; ++i)
+    {
+      OMX_BUFFERHEADERTYPE * p_hdr = ap_prc->p_inhdrs_[i];
+      if (p_hdr->nFilledLen > 0)
+        {
+          const size_t bytes_to_copy
+            = MIN (pa_buf_len - filled, p_hdr->nFilledLen);
+          memcpy ((OMX_U8 *) p_pa_buf + filled,
+                  p_hdr->pBuffer + p_hdr->nOffset, bytes_to_copy);
+          p_hdr->nFilledLen -= bytes_to_copy;
+          p_hdr->nOffset += bytes_to_copy;
+          filled += bytes_to_copy;
+          ap_prc->stats_.ncopies_++;
+        }
+    }
+
+  if (0 == filled)
+    {
+      (void) pa_stream_cancel_write (ap_prc->p_pa_stream_);
+    }
+  else if (pa_stream_write (ap_prc->p_pa_stream_, p_pa_buf, filled, NULL, 0,
+                            PA_SEEK_RELATIVE)
+           < 0)
+    {
+      write_failed = true;
+      filled = 0;
+    }
+
+  lock_ns = monotonic_ns () - lock_start;
+  pa_threaded_mainloop_unlock (ap_prc->p_pa_loop_);
+
+  if (write_failed)
+    {
+      TIZ_ERROR (handleOf (ap_prc), "pa_stream_write : %s",
+                 pa_strerror (pa_context_errno (ap_prc->p_pa_context_)));
+    }
+
+  ap_prc->stats_.nwrites_++;
+  ap_prc->stats_.nbytes_ += filled;
+  ap_prc->stats_.lock_ns_ += lock_ns;
+  ap_prc->stats_.lock_max_ns_ = MAX (ap_prc->stats_.lock_max_ns_, lock_ns);
+
+  return filled;
 }
 
 static OMX_ERRORTYPE
 render_pcm_data (pulsear_prc_t * ap_prc)
 {
-  OMX_ERRORTYPE rc = OMX_ErrorNone;
-  OMX_BUFFERHEADERTYPE * p_hdr = NULL;
   assert (ap_prc);
 
-  while ((p_hdr = get_header (ap_prc)) && ap_prc->pa_nbytes_ > 0)
+  while (ap_prc->pa_nbytes_ > 0)
     {
-      if (p_hdr->nFilledLen > 0)
+      const size_t pending = claim_headers (ap_prc);
+      size_t written = 0;
+
+      if (0 == ap_prc->ninhdrs_)
         {
-          const int bytes_to_write
-            = MIN (ap_prc->pa_nbytes_, p_hdr->nFilledLen);
-          assert (ap_prc->p_pa_loop_);
-          assert (ap_prc->p_pa_context_);
-
-          pa_threaded_mainloop_lock (ap_prc->p_pa_loop_);
-          int result = pa_stream_write (
-            ap_prc->p_pa_stream_, p_hdr->pBuffer + p_hdr->nOffset,
-            bytes_to_write, NULL, 0, PA_SEEK_RELATIVE);
-          /* TODO : Check return code */
-          (void) result;
-          pa_threaded_mainloop_unlock (ap_prc->p_pa_loop_);
-          p_hdr->nFilledLen -= bytes_to_write;
-          p_hdr->nOffset += bytes_to_write;
-          ap_prc->pa_nbytes_ -= bytes_to_write;
+          break;
         }
 
-      if (0 == p_hdr->nFilledLen)
+      if (pending > 0 && 0 == (written = write_pcm_data (ap_prc)))
         {
-          rc = buffer_emptied (ap_prc);
-          p_hdr = NULL;
+          break;
         }
+
+      ap_prc->pa_nbytes_ -= written;
+      tiz_check_omx (release_emptied_headers (ap_prc));
     }
 
-  return rc;
+  return OMX_ErrorNone;
 }
 
 static void
@@ -553,16 +684,29 @@ init_pulseaudio_sample_spec (pulsear_prc_t * ap_prc, pa_sample_spec * ap_spec)
         }
       else if (ap_prc->pcmmode_.nBitPerSample == 24)
         {
+          /* Packed, 3 bytes per sample */
           ap_spec->format = ap_prc->pcmmode_.eEndian == OMX_EndianBig
                               ? PA_SAMPLE_S24BE
                               : PA_SAMPLE_S24LE;
         }
-      else if (ap_prc->pcmmode_.nBitPerSample == 32)
+      else if (ap_prc->pcmmode_.nBitPerSample == 32
+               && ap_prc->pcmmode_.eNumData == OMX_NumericalDataFloat)
         {
           ap_spec->format = ap_prc->pcmmode_.eEndian == OMX_EndianBig
                               ? PA_SAMPLE_FLOAT32BE
                               : PA_SAMPLE_FLOAT32LE;
         }
+      else if (ap_prc->pcmmode_.nBitPerSample == 32)
+        {
+          ap_spec->format = ap_prc->pcmmode_.eEndian == OMX_EndianBig
+                              ? PA_SAMPLE_S32BE
+                              : PA_SAMPLE_S32LE;
+        }
+      else if (ap_prc->pcmmode_.nBitPerSample == 8
+               && ap_prc->pcmmode_.eNumData == OMX_NumericalDataUnsigned)
+        {
+          ap_spec->format = PA_SAMPLE_U8;
+        }
       else
         {
           ap_spec->format = ap_prc->pcmmode_.eEndian == OMX_EndianBig
@@ -580,6 +724,27 @@ init_pulseaudio_sample_spec (pulsear_prc_t * ap_prc, pa_sample_spec * ap_spec)
   return rc;
 }
 
+/* Whether the stream that was kept across a port disable can carry the pcm
+   settings currently configured on the input port */
+static bool
+is_stream_spec_current (pulsear_prc_t * ap_prc)
+{
+  bool rc = false;
+  pa_sample_spec spec;
+  assert (ap_prc);
+  if (ap_prc->p_pa_loop_ && ap_prc->p_pa_stream_
+      && PA_STREAM_READY == ap_prc->pa_stream_state_
+      && PA_OK == init_pulseaudio_sample_spec (ap_prc, &spec))
+    {
+      const pa_sample_spec * p_cur_spec = NULL;
+      pa_threaded_mainloop_lock (ap_prc->p_pa_loop_);
+      p_cur_spec = pa_stream_get_sample_spec (ap_prc->p_pa_stream_);
+      rc = (p_cur_spec && pa_sample_spec_equal (p_cur_spec, &spec));
+      pa_threaded_mainloop_unlock (ap_prc->p_pa_loop_);
+    }
+  return rc;
+}
+
 /* Pulseaudio mainloop lock must have been acquired before calling this
    function */
 static int
@@ -783,6 +948,7 @@ static inline OMX_ERRORTYPE
 do_flush (pulsear_prc_t * ap_prc)
 {
   assert (ap_prc);
+  ap_prc->eos_ = false;
   if (ap_prc->p_pa_loop_ && ap_prc->p_pa_stream_
       && PA_STREAM_READY == ap_prc->pa_stream_state_)
     {
@@ -800,7 +966,7 @@ do_flush (pulsear_prc_t * ap_prc)
       pa_threaded_mainloop_unlock (ap_prc->p_pa_loop_);
     }
   /* Release any buffers held  */
-  return release_header (ap_prc);
+  return release_headers (ap_prc);
 }
 
 static bool
@@ -964,10 +1130,11 @@ pulsear_prc_ctor (void * ap_prc, va_list * app)
 {
   pulsear_prc_t * p_prc
     = super_ctor (typeOf (ap_prc, "pulsearprc"), ap_prc, app);
-  p_prc->p_inhdr_ = NULL;
+  p_prc->ninhdrs_ = 0;
   p_prc->port_disabled_ = false;
   p_prc->paused_ = false;
   p_prc->stopped_ = true;
+  p_prc->eos_ = false;
   p_prc->p_pa_loop_ = NULL;
   p_prc->p_pa_context_ = NULL;
   p_prc->p_pa_stream_ = NULL;
@@ -981,6 +1148,7 @@ pulsear_prc_ctor (void * ap_prc, va_list * app)
   p_prc->ramp_step_ = 0;
   p_prc->ramp_step_count_ = ARATELIA_PCM_RENDERER_DEFAULT_RAMP_STEP_COUNT;
   p_prc->ramp_volume_ = 0;
+  tiz_mem_set (&(p_prc->stats_), 0, sizeof (pulsear_prc_stats_t));
   return p_prc;
 }
 
@@ -1059,6 +1227,7 @@ pulsear_prc_stop_and_return (void * ap_prc)
   assert (ap_prc);
   p_prc->stopped_ = true;
   stop_volume_ramp (ap_prc);
+  log_render_stats (p_prc);
   return do_flush (ap_prc);
 }
 
@@ -1171,27 +1340,38 @@ pulsear_prc_port_disable (const void * ap_prc, OMX_U32 TIZ_UNUSED (a_pid))
     {
       p_prc->port_disabled_ = true;
       stop_volume_ramp (p_prc);
-      if (p_prc->p_pa_loop_ && p_prc->p_pa_stream_
-          && PA_STREAM_READY == p_prc->pa_stream_state_)
+      if (p_prc->eos_)
         {
-          pa_operation * p_op = NULL;
-          pa_threaded_mainloop_lock (p_prc->p_pa_loop_);
-          p_op = pa_stream_flush (p_prc->p_pa_stream_,
-                                  pulseaudio_stream_success_cback, p_prc);
-          if (p_op)
+          /* The whole stream has been handed over to PA already. Let PA play
+             out what it still holds; the stream is reused if the port comes
+             back with the same pcm settings, e.g. on a gapless track
+             switch. */
+          TIZ_DEBUG (handleOf (p_prc), "EOS seen - keeping the PA stream");
+        }
+      else
+        {
+          if (p_prc->p_pa_loop_ && p_prc->p_pa_stream_
+              && PA_STREAM_READY == p_prc->pa_stream_state_)
             {
-              if (!pulseaudio_wait_for_operation (p_prc, p_op))
+              pa_operation * p_op = NULL;
+              pa_threaded_mainloop_lock (p_prc->p_pa_loop_);
+              p_op = pa_stream_flush (p_prc->p_pa_stream_,
+                                      pulseaudio_stream_success_cback, p_prc);
+              if (p_op)
                 {
-                  TIZ_ERROR (handleOf (p_prc), "Operation wait failed.");
+                  if (!pulseaudio_wait_for_operation (p_prc, p_op))
+                    {
+                      TIZ_ERROR (handleOf (p_prc), "Operation wait failed.");
+                    }
                 }
+              pa_threaded_mainloop_unlock (p_prc->p_pa_loop_);
             }
-          pa_threaded_mainloop_unlock (p_prc->p_pa_loop_);
+          tiz_check_omx (pulsear_prc_deallocate_resources (p_prc));
         }
-      tiz_check_omx (pulsear_prc_deallocate_resources (p_prc));
     }
 
   /* Release any buffers held  */
-  return release_header ((pulsear_prc_t *) p_prc);
+  return release_headers ((pulsear_prc_t *) p_prc);
 }
 
 static OMX_ERRORTYPE
@@ -1204,9 +1384,22 @@ pulsear_prc_port_enable (const void * ap_obj, OMX_U32 TIZ_UNUSED (a_pid))
   if (p_prc->port_disabled_)
     {
       p_prc->port_disabled_ = false;
-      tiz_check_omx (pulsear_prc_allocate_resources (p_prc, OMX_ALL));
-      tiz_check_omx (pulsear_prc_prepare_to_transfer (p_prc, OMX_ALL));
-      tiz_check_omx (pulsear_prc_transfer_and_process (p_prc, OMX_ALL));
+      if (p_prc->eos_ && p_prc->p_ev_timer_ && is_stream_spec_current (p_prc))
+        {
+          /* Carry on with the stream kept at port disable time; no volume
+             ramp, as the audio continues where the previous stream ended */
+          TIZ_DEBUG (handleOf (p_prc), "Reusing the PA stream");
+          p_prc->eos_ = false;
+          p_prc->stopped_ = false;
+        }
+      else
+        {
+          p_prc->eos_ = false;
+          tiz_check_omx (pulsear_prc_deallocate_resources (p_prc));
+          tiz_check_omx (pulsear_prc_allocate_resources (p_prc, OMX_ALL));
+          tiz_check_omx (pulsear_prc_prepare_to_transfer (p_prc, OMX_ALL));
+          tiz_check_omx (pulsear_prc_transfer_and_process (p_prc, OMX_ALL));
+        }
       TIZ_DEBUG (handleOf (p_prc), "p_prc->volume_ [%d]", p_prc->volume_);
     }
   return OMX_ErrorNone;
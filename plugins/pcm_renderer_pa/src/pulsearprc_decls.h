@@ -47,16 +47,31 @@ extern "C" {
 
 #include <tizprc_decls.h>
 
+/* Maximum number of OMX headers that are copied into one PA write buffer */
+#define PULSEAR_MAX_INHDRS 8
+
+typedef struct pulsear_prc_stats pulsear_prc_stats_t;
+struct pulsear_prc_stats
+{
+  unsigned long nwrites_;
+  unsigned long ncopies_;
+  unsigned long long nbytes_;
+  unsigned long long lock_ns_;
+  unsigned long long lock_max_ns_;
+};
+
 typedef struct pulsear_prc pulsear_prc_t;
 struct pulsear_prc
 {
   /* Object */
   const tiz_prc_t _;
   OMX_AUDIO_PARAM_PCMMODETYPE pcmmode_;
-  OMX_BUFFERHEADERTYPE *p_inhdr_;
+  OMX_BUFFERHEADERTYPE *p_inhdrs_[PULSEAR_MAX_INHDRS];
+  size_t ninhdrs_;
   bool port_disabled_;
   bool paused_;
   bool stopped_;
+  bool eos_;
   struct pa_threaded_mainloop *p_pa_loop_;
   struct pa_context *p_pa_context_;
   struct pa_stream *p_pa_stream_;
@@ -71,6 +86,7 @@ struct pulsear_prc
   long ramp_step_;
   long ramp_step_count_;
   long ramp_volume_;
+  pulsear_prc_stats_t stats_;
 };
 
 typedef struct pulsear_prc_class pulsear_prc_class_t;
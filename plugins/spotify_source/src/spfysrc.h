@@ -53,6 +53,10 @@ extern "C" {
 #define ARATELIA_SPOTIFY_SOURCE_DEFAULT_CACHE_SECONDS 6
 #define ARATELIA_SPOTIFY_SOURCE_MIN_CACHE_SECONDS 7
 #define ARATELIA_SPOTIFY_SOURCE_MAX_CACHE_SECONDS 12
+/* Size of the PCM ring between libspotify's thread and the component's;
+   must be a power of two, and larger than the max cache at the highest
+   bitrate */
+#define ARATELIA_SPOTIFY_SOURCE_PCM_RING_SIZE (1024 * 1024)
 
 #ifdef __cplusplus
 }
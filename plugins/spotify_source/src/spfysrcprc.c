@@ -88,15 +88,6 @@ extern const uint8_t g_appkey[];
 /* The size of the application key. */
 extern const size_t g_appkey_size;
 
-typedef struct spfy_music_delivery_data spfy_music_delivery_data_t;
-struct spfy_music_delivery_data
-{
-  sp_session * p_sess;
-  sp_audioformat format;
-  void * p_frames;
-  int num_frames;
-};
-
 static OMX_S32
 ready_playlist_map_compare_func (OMX_PTR ap_key1, OMX_PTR ap_key2)
 {
@@ -240,11 +231,68 @@ playlist_name_match (spfysrc_prc_t * ap_prc, const char * ap_pl_name,
   return outcome;
 }
 
+static inline size_t
+pcm_ring_used (spfysrc_pcm_ring_t * ap_ring)
+{
+  /* Consumer side */
+  return __atomic_load_n (&(ap_ring->tail), __ATOMIC_ACQUIRE) - ap_ring->head;
+}
+
+static inline size_t
+pcm_ring_free (spfysrc_pcm_ring_t * ap_ring)
+{
+  /* Producer side */
+  return ap_ring->size
+         - (ap_ring->tail - __atomic_load_n (&(ap_ring->head), __ATOMIC_ACQUIRE));
+}
+
+static void
+pcm_ring_write (spfysrc_pcm_ring_t * ap_ring, const void * ap_src,
+                const size_t a_nbytes)
+{
+  /* Producer side; the caller has checked that there is enough space */
+  const size_t pos = ap_ring->tail & (ap_ring->size - 1);
+  const size_t first = MIN (a_nbytes, ap_ring->size - pos);
+  assert (a_nbytes <= pcm_ring_free (ap_ring));
+  (void) memcpy (ap_ring->p_data + pos, ap_src, first);
+  (void) memcpy (ap_ring->p_data, (const OMX_U8 *) ap_src + first,
+                 a_nbytes - first);
+  __atomic_store_n (&(ap_ring->tail), ap_ring->tail + a_nbytes,
+                    __ATOMIC_RELEASE);
+}
+
+/* Returns the longest contiguous run of data at the head of the ring */
+static inline const OMX_U8 *
+pcm_ring_peek (spfysrc_pcm_ring_t * ap_ring, size_t * ap_nbytes)
+{
+  const size_t pos = ap_ring->head & (ap_ring->size - 1);
+  *ap_nbytes = MIN (pcm_ring_used (ap_ring), ap_ring->size - pos);
+  return ap_ring->p_data + pos;
+}
+
+static inline void
+pcm_ring_advance (spfysrc_pcm_ring_t * ap_ring, const size_t a_nbytes)
+{
+  /* Consumer side */
+  __atomic_store_n (&(ap_ring->head), ap_ring->head + a_nbytes,
+                    __ATOMIC_RELEASE);
+}
+
+static inline void
+pcm_ring_clear (spfysrc_pcm_ring_t * ap_ring)
+{
+  /* Consumer side */
+  if (ap_ring->p_data)
+    {
+      pcm_ring_advance (ap_ring, pcm_ring_used (ap_ring));
+    }
+}
+
 static void
 reset_stream_parameters (spfysrc_prc_t * ap_prc)
 {
   assert (ap_prc);
-  tiz_buffer_clear (ap_prc->p_store_);
+  pcm_ring_clear (&(ap_prc->ring_));
   ap_prc->initial_cache_bytes_
     = ((ARATELIA_SPOTIFY_SOURCE_DEFAULT_BIT_RATE_KBITS * 1000) / 8)
       * ARATELIA_SPOTIFY_SOURCE_DEFAULT_CACHE_SECONDS;
@@ -738,27 +786,26 @@ end:
 }
 
 static OMX_ERRORTYPE
-allocate_temp_data_store (spfysrc_prc_t * ap_prc)
+allocate_pcm_ring (spfysrc_prc_t * ap_prc)
 {
-  OMX_PARAM_PORTDEFINITIONTYPE port_def;
   assert (ap_prc);
-  TIZ_INIT_OMX_PORT_STRUCT (port_def, ARATELIA_SPOTIFY_SOURCE_PORT_INDEX);
-  tiz_check_omx (
-    tiz_api_GetParameter (tiz_get_krn (handleOf (ap_prc)), handleOf (ap_prc),
-                          OMX_IndexParamPortDefinition, &port_def));
-  assert (ap_prc->p_store_ == NULL);
-  return tiz_buffer_init (&(ap_prc->p_store_), port_def.nBufferSize);
+  assert (ap_prc->ring_.p_data == NULL);
+  if (!(ap_prc->ring_.p_data
+        = tiz_mem_alloc (ARATELIA_SPOTIFY_SOURCE_PCM_RING_SIZE)))
+    {
+      return OMX_ErrorInsufficientResources;
+    }
+  ap_prc->ring_.size = ARATELIA_SPOTIFY_SOURCE_PCM_RING_SIZE;
+  ap_prc->ring_.head = ap_prc->ring_.tail = 0;
+  return OMX_ErrorNone;
 }
 
 static inline void
-deallocate_temp_data_store (
-  /*@special@ */ spfysrc_prc_t * ap_prc)
-/*@releases ap_prc->p_store_@ */
-/*@ensures isnull ap_prc->p_store_@ */
+deallocate_pcm_ring (spfysrc_prc_t * ap_prc)
 {
   assert (ap_prc);
-  tiz_buffer_destroy (ap_prc->p_store_);
-  ap_prc->p_store_ = NULL;
+  tiz_mem_free (ap_prc->ring_.p_data);
+  tiz_mem_set (&(ap_prc->ring_), 0, sizeof (ap_prc->ring_));
 }
 
 static inline int
@@ -887,7 +934,7 @@ reevaluate_cache (spfysrc_prc_t * ap_prc)
 
   if (ap_prc->p_sp_session_ && !ap_prc->initial_cache_bytes_)
     {
-      const int current_cache_bytes = tiz_buffer_available (ap_prc->p_store_);
+      const int current_cache_bytes = pcm_ring_used (&(ap_prc->ring_));
       if (current_cache_bytes > ap_prc->max_cache_bytes_
           && !ap_prc->spotify_paused_)
         {
@@ -906,35 +953,43 @@ reevaluate_cache (spfysrc_prc_t * ap_prc)
 static OMX_ERRORTYPE
 consume_cache (spfysrc_prc_t * ap_prc)
 {
+  spfysrc_pcm_ring_t * p_ring = NULL;
   assert (ap_prc);
 
+  p_ring = &(ap_prc->ring_);
+
   /* Also, control here the delivery of the next eos flag */
   if (ap_prc->eos_ && ap_prc->bytes_till_eos_ <= 0)
     {
-      ap_prc->bytes_till_eos_ = tiz_buffer_available (ap_prc->p_store_);
+      ap_prc->bytes_till_eos_ = pcm_ring_used (p_ring);
     }
 
   TIZ_TRACE (handleOf (ap_prc),
-             "store [%d] initial_cache [%d] min_cache [%d] max_cache [%d]",
-             tiz_buffer_available (ap_prc->p_store_),
-             ap_prc->initial_cache_bytes_, ap_prc->min_cache_bytes_,
-             ap_prc->max_cache_bytes_);
+             "store [%zu] initial_cache [%d] min_cache [%d] max_cache [%d]",
+             pcm_ring_used (p_ring), ap_prc->initial_cache_bytes_,
+             ap_prc->min_cache_bytes_, ap_prc->max_cache_bytes_);
 
-  if (tiz_buffer_available (ap_prc->p_store_) > ap_prc->initial_cache_bytes_)
+  if (pcm_ring_used (p_ring) > ap_prc->initial_cache_bytes_)
     {
-      int nbytes_stored = 0;
       OMX_BUFFERHEADERTYPE * p_out = NULL;
 
       /* Reset the initial size */
       ap_prc->initial_cache_bytes_ = 0;
 
-      while ((nbytes_stored = tiz_buffer_available (ap_prc->p_store_)) > 0
+      while (pcm_ring_used (p_ring) > 0
              && (p_out = buffer_needed (ap_prc)) != NULL)
         {
-          int nbytes_copied = copy_to_omx_buffer (
-            p_out, tiz_buffer_get (ap_prc->p_store_), nbytes_stored);
-          tiz_check_omx (release_buffer (ap_prc));
-          (void) tiz_buffer_advance (ap_prc->p_store_, nbytes_copied);
+          size_t nbytes_stored = 0;
+          const OMX_U8 * p_in = pcm_ring_peek (p_ring, &nbytes_stored);
+          int nbytes_copied = copy_to_omx_buffer (p_out, p_in, nbytes_stored);
+          pcm_ring_advance (p_ring, nbytes_copied);
+          /* The data may wrap around the end of the ring; only release the
+             buffer once it is full or there is nothing else to copy */
+          if (p_out->nFilledLen == p_out->nAllocLen
+              || pcm_ring_used (p_ring) == 0)
+            {
+              tiz_check_omx (release_buffer (ap_prc));
+            }
           p_out = NULL;
         }
     }
@@ -1128,78 +1183,56 @@ static void
 music_delivery_handler (OMX_PTR ap_prc, tiz_event_pluggable_t * ap_event)
 {
   spfysrc_prc_t * p_prc = ap_prc;
+  int channels = 0;
+  int samplerate = 0;
 
   assert (p_prc);
-  assert (ap_event);
+  assert (ap_event == &(p_prc->delivery_event_));
 
-  TIZ_TRACE (handleOf (ap_prc), "p_data [%p] ", ap_event->p_data);
-
-  /* Decide if spotify music delivery needs pause/re-start */
-  reevaluate_cache (ap_prc);
+  /* The event belongs to the processor, so it is not freed here. From now
+     on, libspotify's thread may post it again. */
+  __atomic_store_n (&(p_prc->delivery_pending_), false, __ATOMIC_RELEASE);
 
-  if (!p_prc->stopping_ && ap_event->p_data)
+  if (p_prc->stopping_)
     {
-      spfy_music_delivery_data_t * p_data = ap_event->p_data;
-      int nbytes
-        = p_data->num_frames * sizeof (int16_t) * p_data->format.channels;
-      OMX_U8 * p_in = (OMX_U8 *) p_data->p_frames;
-      OMX_BUFFERHEADERTYPE * p_out = NULL;
-
-      TIZ_TRACE (handleOf (ap_prc),
-                 "nbytes [%d] spotify_paused_ [%s] store [%d]", nbytes,
-                 p_prc->spotify_paused_ ? "YES" : "NO",
-                 tiz_buffer_available (p_prc->p_store_));
-
-      consume_cache (p_prc);
-      if (!p_prc->spotify_paused_)
-        {
-          while (nbytes > 0 && (p_out = buffer_needed (p_prc)) != NULL
-                 && !p_prc->initial_cache_bytes_)
-            {
-              int nbytes_copied = copy_to_omx_buffer (p_out, p_in, nbytes);
-              (void) release_buffer (p_prc);
-              nbytes -= nbytes_copied;
-              p_in += nbytes_copied;
-            }
-        }
+      pcm_ring_clear (&(p_prc->ring_));
+      return;
+    }
 
-      if (nbytes > 0)
-        {
-          int nbytes_stored = 0;
-          if ((nbytes_stored = tiz_buffer_push (p_prc->p_store_, p_in, nbytes))
-              < nbytes)
-            {
-              TIZ_ERROR (handleOf (p_prc),
-                         "Unable to store all the data (wanted %d, "
-                         "stored %d).",
-                         nbytes, nbytes_stored);
-              assert (0);
-            }
-          nbytes -= nbytes_stored;
-        }
-      if (p_prc->auto_detect_on_
-          || p_prc->num_channels_ != p_data->format.channels
-          || p_prc->samplerate_ != p_data->format.sample_rate)
-        {
-          p_prc->auto_detect_on_ = false;
-          p_prc->num_channels_ = p_data->format.channels;
-          p_prc->samplerate_ = p_data->format.sample_rate;
-          p_prc->audio_coding_type_ = OMX_AUDIO_CodingPCM;
-          set_audio_coding_on_port (p_prc);
-          set_pcm_audio_info_on_port (p_prc);
-          /* And now trigger the OMX_EventPortFormatDetected and
-             OMX_EventPortSettingsChanged events or a
-             OMX_ErrorFormatNotDetected event */
-          send_port_auto_detect_events (p_prc);
-        }
-      tiz_mem_free (p_data->p_frames);
-      tiz_mem_free (ap_event->p_data);
+  TIZ_TRACE (handleOf (ap_prc), "spotify_paused_ [%s] store [%zu]",
+             p_prc->spotify_paused_ ? "YES" : "NO",
+             pcm_ring_used (&(p_prc->ring_)));
+
+  /* The format is published before the ring's tail, which pcm_ring_used ()
+     has just acquired */
+  channels = __atomic_load_n (&(p_prc->ring_channels_), __ATOMIC_RELAXED);
+  samplerate = __atomic_load_n (&(p_prc->ring_samplerate_), __ATOMIC_RELAXED);
+  if (channels > 0
+      && (p_prc->auto_detect_on_ || p_prc->num_channels_ != channels
+          || p_prc->samplerate_ != samplerate))
+    {
+      p_prc->auto_detect_on_ = false;
+      p_prc->num_channels_ = channels;
+      p_prc->samplerate_ = samplerate;
+      p_prc->audio_coding_type_ = OMX_AUDIO_CodingPCM;
+      set_audio_coding_on_port (p_prc);
+      set_pcm_audio_info_on_port (p_prc);
+      /* And now trigger the OMX_EventPortFormatDetected and
+         OMX_EventPortSettingsChanged events or a
+         OMX_ErrorFormatNotDetected event */
+      send_port_auto_detect_events (p_prc);
     }
-  tiz_mem_free (ap_event);
+
+  /* Decide if spotify music delivery needs pause/re-start */
+  reevaluate_cache (p_prc);
+  (void) consume_cache (p_prc);
 }
 
 /**
  * This callback is used from libspotify whenever there is PCM data available.
+ * The frames are copied straight into the PCM ring. libspotify is told how
+ * many of them fitted, and delivers the rest again later. The component's
+ * thread is only notified if the previous notification has been handled.
  *
  * @note This function is called from an internal session thread!
  */
@@ -1207,41 +1240,37 @@ static int
 music_delivery (sp_session * sess, const sp_audioformat * format,
                 const void * frames, int num_frames)
 {
+  spfysrc_prc_t * p_prc = sp_session_userdata (sess);
   int num_frames_delivered = 0;
-  if (num_frames > 0)
-    {
-      /* We'll only send another pluggable event into the component's main
-         event queue if there are a few spaces available. Otherwise, we'll ask
-         Spotify to wait a little. */
-      if (tiz_comp_event_queue_unused_spaces (
-            handleOf (sp_session_userdata (sess)))
-          >= SPFYSRC_MIN_QUEUE_UNUSED_SPACES)
+
+  assert (p_prc);
+
+  if (num_frames > 0 && p_prc->ring_.p_data)
+    {
+      const size_t frame_len = sizeof (int16_t) * format->channels;
+      assert (frames);
+      num_frames_delivered
+        = MIN ((size_t) num_frames, pcm_ring_free (&(p_prc->ring_)) / frame_len);
+      if (num_frames_delivered > 0)
         {
-          spfy_music_delivery_data_t * p_data
-            = tiz_mem_calloc (1, sizeof (spfy_music_delivery_data_t));
-          if (p_data)
+          __atomic_store_n (&(p_prc->ring_channels_), format->channels,
+                            __ATOMIC_RELAXED);
+          __atomic_store_n (&(p_prc->ring_samplerate_), format->sample_rate,
+                            __ATOMIC_RELAXED);
+          pcm_ring_write (&(p_prc->ring_), frames,
+                          num_frames_delivered * frame_len);
+        }
+
+      if (!__atomic_exchange_n (&(p_prc->delivery_pending_), true,
+                                __ATOMIC_ACQ_REL))
+        {
+          if (OMX_ErrorNone
+              != tiz_comp_event_pluggable (handleOf (p_prc),
+                                           &(p_prc->delivery_event_)))
             {
-              size_t pcm_buffer_len
-                = num_frames * sizeof (int16_t) * format->channels;
-              assert (sess);
-              assert (format);
-              assert (frames);
-              p_data->p_sess = sess;
-              p_data->format.sample_type = format->sample_type;
-              p_data->format.sample_rate = format->sample_rate;
-              p_data->format.channels = format->channels;
-              p_data->p_frames = tiz_mem_alloc (pcm_buffer_len);
-              memcpy (p_data->p_frames, frames, pcm_buffer_len);
-              p_data->num_frames = num_frames;
-              TIZ_PRINTF_DBG_YEL (
-                "music_delivery - num frames : %d pcm_buffer_len : %d - "
-                "spaces %d\n",
-                num_frames, pcm_buffer_len,
-                tiz_comp_event_queue_unused_spaces (
-                  handleOf (sp_session_userdata (sess))));
-              post_spotify_event (sp_session_userdata (sess),
-                                  music_delivery_handler, p_data);
-              num_frames_delivered = num_frames;
+              /* Nothing will drain the ring; let the next delivery retry */
+              __atomic_store_n (&(p_prc->delivery_pending_), false,
+                                __ATOMIC_RELEASE);
             }
         }
     }
@@ -1648,7 +1677,13 @@ spfysrc_prc_ctor (void * ap_obj, va_list * app)
   p_prc->initial_cache_bytes_ = 0;
   p_prc->min_cache_bytes_ = 0;
   p_prc->max_cache_bytes_ = 0;
-  p_prc->p_store_ = NULL;
+  tiz_mem_set (&(p_prc->ring_), 0, sizeof (p_prc->ring_));
+  p_prc->delivery_event_.p_servant = p_prc;
+  p_prc->delivery_event_.pf_hdlr = music_delivery_handler;
+  p_prc->delivery_event_.p_data = NULL;
+  p_prc->delivery_pending_ = false;
+  p_prc->ring_channels_ = 0;
+  p_prc->ring_samplerate_ = 0;
   p_prc->p_ev_timer_ = NULL;
   p_prc->p_shuffle_lst_ = NULL;
   TIZ_INIT_OMX_STRUCT (p_prc->session_);
@@ -1736,7 +1771,7 @@ spfysrc_prc_allocate_resources (void * ap_prc, OMX_U32 a_pid)
   assert (NULL == p_prc->p_uri_param_);
   assert (NULL == p_prc->p_shuffle_lst_);
 
-  tiz_check_omx (allocate_temp_data_store (p_prc));
+  tiz_check_omx (allocate_pcm_ring (p_prc));
   tiz_check_omx (retrieve_session_configuration (p_prc));
   tiz_check_omx (retrieve_playlist (p_prc));
   tiz_check_omx (tiz_srv_timer_watcher_init (p_prc, &(p_prc->p_ev_timer_)));
@@ -1814,7 +1849,7 @@ spfysrc_prc_deallocate_resources (void * ap_prc)
   p_prc->sp_config_.cache_location = p_prc->sp_config_.settings_location = NULL;
   p_prc->spotify_inited_ = false;
 
-  deallocate_temp_data_store (p_prc);
+  deallocate_pcm_ring (p_prc);
 
   return OMX_ErrorNone;
 }
@@ -40,6 +40,18 @@ extern "C" {
 
 #include <tizprc_decls.h>
 
+/* Single-producer, single-consumer PCM ring. libspotify's thread is the
+   producer and only moves 'tail'; the component's thread is the consumer and
+   only moves 'head'. Both are free-running byte counters. */
+typedef struct spfysrc_pcm_ring spfysrc_pcm_ring_t;
+struct spfysrc_pcm_ring
+{
+  OMX_U8 * p_data;
+  size_t size; /* A power of two */
+  size_t head;
+  size_t tail;
+};
+
 typedef struct spfysrc_prc spfysrc_prc_t;
 struct spfysrc_prc
 {
@@ -57,7 +69,13 @@ struct spfysrc_prc
   int initial_cache_bytes_;
   int min_cache_bytes_;
   int max_cache_bytes_;
-  tiz_buffer_t * p_store_; /* The component's pcm buffer */
+  spfysrc_pcm_ring_t ring_; /* The component's pcm buffer */
+  tiz_event_pluggable_t delivery_event_; /* Reused for every delivery
+                                            notification */
+  bool delivery_pending_; /* Set by libspotify's thread when it posts
+                             delivery_event_, cleared by the handler */
+  int ring_channels_;     /* Format of the data last written to the ring */
+  int ring_samplerate_;
   tiz_event_timer_t * p_ev_timer_;
   tiz_shuffle_lst_t * p_shuffle_lst_;
   OMX_TIZONIA_AUDIO_PARAM_SPOTIFYSESSIONTYPE session_;
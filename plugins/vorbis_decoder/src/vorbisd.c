@@ -33,6 +33,8 @@
 #include <assert.h>
 #include <string.h>
 
+#include <OMX_TizoniaExt.h>
+
 #include <tizplatform.h>
 
 #include <tizscheduler.h>
@@ -115,10 +117,10 @@ instantiate_output_port (OMX_HANDLETYPE ap_hdl)
   pcmmode.nVersion.nVersion = OMX_VERSION;
   pcmmode.nPortIndex = 1;
   pcmmode.nChannels = 2;
-  pcmmode.eNumData = OMX_NumericalDataSigned;
-  pcmmode.eEndian = OMX_EndianBig;
+  pcmmode.eNumData = OMX_NumericalDataFloat;
+  pcmmode.eEndian = OMX_EndianLittle;
   pcmmode.bInterleaved = OMX_TRUE;
-  pcmmode.nBitPerSample = 16;
+  pcmmode.nBitPerSample = 32; /* This component outputs float samples */
   pcmmode.nSamplingRate = 48000;
   pcmmode.ePCMMode = OMX_AUDIO_PCMModeLinear;
   pcmmode.eChannelMapping[0] = OMX_AUDIO_ChannelLF;
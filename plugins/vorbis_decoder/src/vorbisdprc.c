@@ -111,17 +111,20 @@ get_store_offset_ptr (vorbisd_prc_t * ap_prc)
   return &(ap_prc->store_offset_);
 }
 
-static int
-store_data (vorbisd_prc_t * ap_prc, const OMX_U8 * ap_data, OMX_U32 a_nbytes)
+static OMX_U32
+store_data (vorbisd_prc_t * ap_prc, const float * const * app_pcm,
+            OMX_U32 a_nframes)
 {
   OMX_U8 ** pp_store = NULL;
   OMX_U32 * p_offset = NULL;
   OMX_U32 * p_size = NULL;
-  OMX_U32 nbytes_to_copy = 0;
+  const OMX_U32 frame_len = sizeof (float) * ap_prc->fsinfo_.channels;
+  const OMX_U32 nbytes = a_nframes * frame_len;
+  OMX_U32 nframes_to_copy = 0;
   OMX_U32 nbytes_avail = 0;
 
   assert (ap_prc);
-  assert (ap_data);
+  assert (app_pcm);
 
   pp_store = get_store_ptr (ap_prc);
   p_size = get_store_size_ptr (ap_prc);
@@ -133,15 +136,15 @@ store_data (vorbisd_prc_t * ap_prc, const OMX_U8 * ap_data, OMX_U32 a_nbytes)
 
   nbytes_avail = *p_size - *p_offset;
 
-  if (a_nbytes > nbytes_avail)
+  if (nbytes > nbytes_avail)
     {
       /* need to re-alloc */
       OMX_U8 * p_new_store = NULL;
-      p_new_store = tiz_mem_realloc (*pp_store, *p_offset + a_nbytes);
+      p_new_store = tiz_mem_realloc (*pp_store, *p_offset + nbytes);
       if (p_new_store)
         {
           *pp_store = p_new_store;
-          *p_size = *p_offset + a_nbytes;
+          *p_size = *p_offset + nbytes;
           nbytes_avail = *p_size - *p_offset;
           TIZ_TRACE (handleOf (ap_prc),
                      "Realloc'd data store "
@@ -149,25 +152,15 @@ store_data (vorbisd_prc_t * ap_prc, const OMX_U8 * ap_data, OMX_U32 a_nbytes)
                      *p_size);
         }
     }
-  nbytes_to_copy = MIN (nbytes_avail, a_nbytes);
-  memcpy (*pp_store + *p_offset, ap_data, nbytes_to_copy);
-  *p_offset += nbytes_to_copy;
+  nframes_to_copy = MIN (nbytes_avail / frame_len, a_nframes);
+  (void) tiz_pcm_interleave (*pp_store + *p_offset,
+                             (const void * const *) app_pcm, sizeof (float),
+                             ap_prc->fsinfo_.channels, nframes_to_copy);
+  *p_offset += nframes_to_copy * frame_len;
 
   TIZ_TRACE (handleOf (ap_prc), "bytes currently stored [%d]", *p_offset);
 
-  return a_nbytes - nbytes_to_copy;
-}
-
-static inline void
-write_frame_float_ilv (float * to, const float * from, const int channels)
-{
-  int i = 0;
-  assert (to);
-  assert (from);
-  for (i = 0; i < channels; ++i)
-    {
-      to[i] = from[i];
-    }
+  return (a_nframes - nframes_to_copy) * frame_len;
 }
 
 static OMX_ERRORTYPE
@@ -327,23 +320,16 @@ fishsound_decoded_callback (FishSound * ap_fsound, float * app_pcm[],
     }
 
   {
-    /* write decoded PCM samples */
-    size_t i = 0;
+    /* write decoded PCM samples, interleaving the channels */
     size_t frame_len = sizeof (float) * p_prc->fsinfo_.channels;
     size_t frames_alloc = ((p_out->nAllocLen - p_out->nOffset) / frame_len);
     size_t frames_to_write = (frames > frames_alloc) ? frames_alloc : frames;
     size_t bytes_to_write = frames_to_write * frame_len;
     assert (p_out);
 
-    for (i = 0; i < frames_to_write; ++i)
-      {
-        size_t frame_offset = i * frame_len;
-        size_t float_offset = i * p_prc->fsinfo_.channels;
-        float * out
-          = (float *) (p_out->pBuffer + p_out->nOffset + frame_offset);
-        write_frame_float_ilv (out, ((float *) app_pcm) + float_offset,
-                               p_prc->fsinfo_.channels);
-      }
+    (void) tiz_pcm_interleave (
+      p_out->pBuffer + p_out->nOffset, (const void * const *) app_pcm,
+      sizeof (float), p_prc->fsinfo_.channels, frames_to_write);
     p_out->nFilledLen += bytes_to_write;
     p_out->nOffset += bytes_to_write;
 
@@ -351,12 +337,17 @@ fishsound_decoded_callback (FishSound * ap_fsound, float * app_pcm[],
       {
         /* Temporarily store the data until an omx buffer is
          * available */
+        const float * remaining[2] = {NULL, NULL};
         OMX_U32 nbytes_remaining = (frames - frames_to_write) * frame_len;
+        int c = 0;
+        for (c = 0; c < p_prc->fsinfo_.channels; ++c)
+          {
+            remaining[c] = app_pcm[c] + frames_to_write;
+          }
         TIZ_TRACE (handleOf (p_prc), "Need to store [%d] bytes",
                    nbytes_remaining);
-        nbytes_remaining = store_data (
-          p_prc, (OMX_U8 *) (app_pcm[frames_to_write * sizeof (float)]),
-          nbytes_remaining);
+        nbytes_remaining
+          = store_data (p_prc, remaining, frames - frames_to_write);
       }
 
     if (tiz_filter_prc_is_eos (p_prc))
@@ -388,15 +379,9 @@ init_vorbis_decoder (vorbisd_prc_t * ap_prc)
       ap_prc->p_fsnd_ = fish_sound_new (FISH_SOUND_DECODE, &(ap_prc->fsinfo_));
       tiz_check_null_ret_oom (ap_prc->p_fsnd_ != NULL);
 
-      if (0 != fish_sound_set_interleave (ap_prc->p_fsnd_, 1))
-        {
-          TIZ_ERROR (handleOf (ap_prc),
-                     "[OMX_ErrorInsufficientResources] : "
-                     "Could not set interleaved.");
-          goto end;
-        }
-
-      if (0 != fish_sound_set_decoded_float_ilv (
+      /* Ask for planar output: libfishsound would otherwise interleave
+         the samples itself, one at a time, into an intermediate buffer */
+      if (0 != fish_sound_set_decoded_float (
                  ap_prc->p_fsnd_, fishsound_decoded_callback, ap_prc))
         {
           TIZ_ERROR (handleOf (ap_prc),
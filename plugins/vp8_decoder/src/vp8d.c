@@ -57,6 +57,10 @@
 
 static OMX_VERSIONTYPE vp8_decoder_version = { {1, 0, 0, 0} };
 
+/* Decoded frames are page-aligned and, from 1080p or so, backed by huge
+   pages */
+static OMX_U32 vp8_output_buffer_flags = TIZ_BUFPOOL_HUGEPAGES;
+
 static OMX_PTR
 instantiate_input_port (OMX_HANDLETYPE ap_hdl)
 {
@@ -137,7 +141,8 @@ instantiate_output_port (OMX_HANDLETYPE ap_hdl)
     ARATELIA_VP8_DECODER_PORT_NONCONTIGUOUS,
     ARATELIA_VP8_DECODER_PORT_ALIGNMENT,
     ARATELIA_VP8_DECODER_PORT_SUPPLIERPREF,
-    {ARATELIA_VP8_DECODER_OUTPUT_PORT_INDEX, NULL, NULL, NULL},
+    {ARATELIA_VP8_DECODER_OUTPUT_PORT_INDEX, tiz_bufpool_alloc_hook,
+     tiz_bufpool_free_hook, &vp8_output_buffer_flags},
     0                           /* Master port */
   };
 
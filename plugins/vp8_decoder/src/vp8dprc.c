@@ -467,19 +467,17 @@ read_frame (vp8d_prc_t *ap_prc, OMX_BUFFERHEADERTYPE *p_inhdr)
 }
 
 static void
-out_put (OMX_BUFFERHEADERTYPE * p_hdr, const uint8_t * buf, unsigned int len)
+put_plane (OMX_U8 * ap_dst, const OMX_U32 a_dst_stride, const uint8_t * ap_src,
+           const int a_src_stride, const unsigned int a_width,
+           const unsigned int a_rows)
 {
-  memcpy (p_hdr->pBuffer + p_hdr->nOffset, buf, len);
-  p_hdr->nOffset += len;
-  p_hdr->nFilledLen = p_hdr->nOffset;
-
-  if (p_hdr->nFilledLen > p_hdr->nAllocLen)
+  unsigned int y;
+  for (y = 0; y < a_rows; y++)
     {
-      TIZ_LOG (TIZ_PRIORITY_TRACE, "len [%d] nFilledLen [%d] nAllocLen [%d]",
-               len, p_hdr->nFilledLen, p_hdr->nAllocLen);
-      assert (p_hdr->nFilledLen <= p_hdr->nAllocLen);
+      memcpy (ap_dst, ap_src, a_width);
+      ap_dst += a_dst_stride;
+      ap_src += a_src_stride;
     }
-
 }
 
 static void
@@ -505,29 +503,37 @@ decode_frame (vp8d_prc_t *ap_prc)
     {
       if ((img = vpx_codec_get_frame (&(ap_prc->vp8ctx_), &iter)))
         {
-          unsigned int y;
-          uint8_t *buf = img->planes[VPX_PLANE_Y];
-
-          for (y = 0; y < img->d_h; y++)
+          /* The planes are written where the output port's stride and slice
+           * height say they are, so that the renderer (or the overlay that
+           * backs the buffer) can use them as they are */
+          OMX_BUFFERHEADERTYPE *p_hdr = ap_prc->p_outhdr_;
+          const OMX_U32 stride = ap_prc->out_stride_;
+          const OMX_U32 slice_height = ap_prc->out_slice_height_;
+          const OMX_U32 cstride = (stride + 1) / 2;
+          const OMX_U32 y_sz = stride * slice_height;
+          const OMX_U32 c_sz = cstride * ((slice_height + 1) / 2);
+          OMX_U8 *p_y = p_hdr->pBuffer + p_hdr->nOffset;
+
+          if (img->d_w > stride || img->d_h > slice_height
+              || p_hdr->nOffset + y_sz + 2 * c_sz > p_hdr->nAllocLen)
             {
-              out_put (ap_prc->p_outhdr_, buf, img->d_w);
-              buf += img->stride[VPX_PLANE_Y];
+              TIZ_ERROR (handleOf (ap_prc),
+                         "Frame [%ux%u] does not fit the output port "
+                         "(stride [%u] slice height [%u] nAllocLen [%u])",
+                         img->d_w, img->d_h, stride, slice_height,
+                         p_hdr->nAllocLen);
             }
-
-          buf = img->planes[VPX_PLANE_U];
-
-          for (y = 0; y < (1 + img->d_h) / 2; y++)
-            {
-              out_put (ap_prc->p_outhdr_, buf, (1 + img->d_w) / 2);
-              buf += img->stride[VPX_PLANE_U];
-            }
-
-          buf = img->planes[VPX_PLANE_V];
-
-          for (y = 0; y < (1 + img->d_h) / 2; y++)
+          else
             {
-              out_put (ap_prc->p_outhdr_, buf, (1 + img->d_w) / 2);
-              buf += img->stride[VPX_PLANE_V];
+              put_plane (p_y, stride, img->planes[VPX_PLANE_Y],
+                         img->stride[VPX_PLANE_Y], img->d_w, img->d_h);
+              put_plane (p_y + y_sz, cstride, img->planes[VPX_PLANE_U],
+                         img->stride[VPX_PLANE_U], (1 + img->d_w) / 2,
+                         (1 + img->d_h) / 2);
+              put_plane (p_y + y_sz + c_sz, cstride, img->planes[VPX_PLANE_V],
+                         img->stride[VPX_PLANE_V], (1 + img->d_w) / 2,
+                         (1 + img->d_h) / 2);
+              p_hdr->nFilledLen = y_sz + 2 * c_sz;
             }
         }
     }
@@ -638,6 +644,8 @@ vp8d_proc_ctor (void *ap_obj, va_list * app)
   p_prc->first_buf_   = true;
   p_prc->eos_         = false;
   p_prc->stream_type_ = STREAM_IVF;
+  p_prc->out_stride_       = 0;
+  p_prc->out_slice_height_ = 0;
   tiz_mem_set (&(p_prc->codec_buf_), 0, sizeof(p_prc->codec_buf_));
   return p_prc;
 }
@@ -696,7 +704,33 @@ static OMX_ERRORTYPE
 vp8d_proc_prepare_to_transfer (void *ap_obj, OMX_U32 a_pid)
 {
   vp8d_prc_t *p_prc = ap_obj;
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+  OMX_PARAM_PORTDEFINITIONTYPE portdef;
+  TIZ_INIT_OMX_PORT_STRUCT (portdef, ARATELIA_VP8_DECODER_OUTPUT_PORT_INDEX);
+
   assert (p_prc);
+
+  /* Retrieve the frame layout negotiated on the output port */
+  if (OMX_ErrorNone != (rc = tiz_api_GetParameter
+                        (tiz_get_krn (handleOf (p_prc)),
+                         handleOf (p_prc),
+                         OMX_IndexParamPortDefinition, &portdef)))
+    {
+      TIZ_ERROR (handleOf (p_prc),
+                 "[%s] : retrieving the port definition", tiz_err_to_str (rc));
+      return rc;
+    }
+
+  p_prc->out_stride_ = portdef.format.video.nStride > 0
+    ? (OMX_U32) portdef.format.video.nStride
+    : portdef.format.video.nFrameWidth;
+  p_prc->out_slice_height_ = portdef.format.video.nSliceHeight > 0
+    ? portdef.format.video.nSliceHeight
+    : portdef.format.video.nFrameHeight;
+
+  TIZ_TRACE (handleOf (p_prc), "stride [%u] slice height [%u]",
+             p_prc->out_stride_, p_prc->out_slice_height_);
+
   p_prc->first_buf_ = true;
   p_prc->eos_       = false;
   return OMX_ErrorNone;
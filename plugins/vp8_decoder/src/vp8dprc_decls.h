@@ -70,6 +70,8 @@ extern "C"
     bool eos_;
     vp8dprc_stream_type_t stream_type_;
     vp8d_codec_buffer_t codec_buf_;
+    OMX_U32 out_stride_;
+    OMX_U32 out_slice_height_;
   };
 
   typedef struct vp8d_prc_class vp8d_prc_class_t;
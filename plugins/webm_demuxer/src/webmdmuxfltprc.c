@@ -80,7 +80,7 @@ store_data (webmdmuxflt_prc_t * ap_prc);
     {                                                                       \
       TIZ_DEBUG (                                                           \
         handleOf (ap_prc),                                                  \
-        "store [%d] eos [%s] last read len ? [%d] ne read err [%d] out "    \
+        "store [%zu] eos [%s] last read len ? [%d] ne read err [%d] out "   \
         "headers [%s]",                                                     \
         tiz_buffer_available (ap_prc->p_webm_store_),                       \
         (tiz_filter_prc_is_eos (ap_prc) ? "YES" : "NO"),                    \
@@ -379,7 +379,7 @@ deliver_codec_metadata (webmdmuxflt_prc_t * ap_prc, const OMX_U32 a_pid)
       tiz_buffer_advance (p_out_store, nbytes_to_copy);
       p_hdr->nFilledLen += nbytes_to_copy;
       TIZ_DEBUG (
-        handleOf (ap_prc), "nbytes_to_copy [%u] nFilledLen [%d] avail [%d]",
+        handleOf (ap_prc), "nbytes_to_copy [%u] nFilledLen [%d] avail [%zu]",
         nbytes_to_copy, p_hdr->nFilledLen, tiz_buffer_available (p_out_store));
       tiz_vector_erase (p_header_lengths, (OMX_S32) 0, (OMX_S32) 1);
       tiz_check_omx (release_output_header (ap_prc, a_pid));
@@ -408,7 +408,7 @@ store_audio_codec_metadata (webmdmuxflt_prc_t * ap_prc,
     tiz_vector_push_back (ap_prc->p_aud_header_lengths_, &a_length));
 
   TIZ_DEBUG (handleOf (ap_prc),
-             "copied metadata (len %u) to temp out buffer (%d) ", a_length,
+             "copied metadata (len %u) to temp out buffer (%zu) ", a_length,
              tiz_buffer_available (ap_prc->p_aud_store_));
 
   return OMX_ErrorNone;
@@ -483,7 +483,7 @@ store_data (webmdmuxflt_prc_t * ap_prc)
   if (p_in)
     {
       int pushed = 0;
-      TIZ_TRACE (handleOf (ap_prc), "avail [%d] incoming [%d]",
+      TIZ_TRACE (handleOf (ap_prc), "avail [%zu] incoming [%d]",
                  tiz_buffer_available (ap_prc->p_webm_store_),
                  p_in->nFilledLen - p_in->nOffset);
       pushed = tiz_buffer_push (
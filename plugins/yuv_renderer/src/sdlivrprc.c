@@ -37,6 +37,7 @@
 #include <tizplatform.h>
 
 #include <tizkernel.h>
+#include <tizport.h>
 
 #include "sdlivr.h"
 #include "sdlivrprc.h"
@@ -47,83 +48,318 @@
 #define TIZ_LOG_CATEGORY_NAME "tiz.yuv_renderer.prc"
 #endif
 
+/* Frames arrive as tightly packed I420 unless the port says otherwise:
+ * nStride and nSliceHeight describe the luma plane, and each chroma plane has
+ * half the stride and half the slice height, rounded up. */
+static void
+get_frame_layout (const OMX_VIDEO_PORTDEFINITIONTYPE * ap_vportdef,
+                  OMX_U32 * ap_stride, OMX_U32 * ap_slice_height,
+                  OMX_U32 * ap_frame_size)
+{
+  const OMX_U32 stride = ap_vportdef->nStride > 0
+    ? (OMX_U32) ap_vportdef->nStride : ap_vportdef->nFrameWidth;
+  const OMX_U32 slice_height = ap_vportdef->nSliceHeight > 0
+    ? ap_vportdef->nSliceHeight : ap_vportdef->nFrameHeight;
+  *ap_stride = stride;
+  *ap_slice_height = slice_height;
+  *ap_frame_size
+    = stride * slice_height + 2 * ((stride + 1) / 2) * ((slice_height + 1) / 2);
+}
+
 static OMX_ERRORTYPE
-sdlivr_proc_render_buffer (const sdlivr_prc_t *ap_prc, OMX_BUFFERHEADERTYPE * p_hdr)
+init_sdl (const sdlivr_prc_t * ap_prc)
+{
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+  if (!SDL_WasInit (SDL_INIT_VIDEO) && -1 == SDL_Init (SDL_INIT_VIDEO))
+    {
+      rc =  OMX_ErrorInsufficientResources;
+      TIZ_ERROR (handleOf (ap_prc),
+                 "[%s] : while initializing SDL [%s]", tiz_err_to_str (rc),
+                 SDL_GetError ());
+    }
+  return rc;
+}
+
+static OMX_ERRORTYPE
+set_video_mode (sdlivr_prc_t * ap_prc)
 {
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+  OMX_PARAM_PORTDEFINITIONTYPE portdef;
+  TIZ_INIT_OMX_PORT_STRUCT (portdef, ARATELIA_YUV_RENDERER_PORT_INDEX);
+
   assert (ap_prc);
 
-  if (ap_prc->p_overlay)
+  /* Retrieve port def from port */
+  if (OMX_ErrorNone != (rc = tiz_api_GetParameter
+                        (tiz_get_krn (handleOf (ap_prc)),
+                         handleOf (ap_prc),
+                         OMX_IndexParamPortDefinition, &portdef)))
     {
-      /* AVPicture pict; */
-      SDL_Rect rect;
-      uint8_t *y;
-      uint8_t *u;
-      uint8_t *v;
-      unsigned int bytes;
-      int pitch0, pitch1;
-
-      /* align pitch on 16-pixel boundary. */
-      pitch0 = (ap_prc->vportdef_.nFrameWidth + 15) & ~15;
-      pitch1 = pitch0 / 2;
-
-      /* hard-coded to be YUV420 plannar */
-      y = p_hdr->pBuffer;
-      u = y + pitch0 * ap_prc->vportdef_.nFrameHeight;
-      v = u + pitch1 * ap_prc->vportdef_.nFrameHeight / 2;
-
-      SDL_LockYUVOverlay (ap_prc->p_overlay);
-
-      if (ap_prc->p_overlay->pitches[0] != pitch0
-          || ap_prc->p_overlay->pitches[1] != pitch1
-          || ap_prc->p_overlay->pitches[2] != pitch1)
-        {
-          int hh;
-          uint8_t *y2;
-          uint8_t *u2;
-          uint8_t *v2;
+      TIZ_ERROR (handleOf (ap_prc),
+                 "[%s] : retrieving the port definition", tiz_err_to_str (rc));
+      return rc;
+    }
 
-          y2 = ap_prc->p_overlay->pixels[0];
-          u2 = ap_prc->p_overlay->pixels[2];
-          v2 = ap_prc->p_overlay->pixels[1];
+  ap_prc->vportdef_ = portdef.format.video;
 
-          for (hh = 0; hh < ap_prc->vportdef_.nFrameHeight; hh++)
-            {
-              memcpy (y2, y, ap_prc->p_overlay->pitches[0]);
-              y2 += ap_prc->p_overlay->pitches[0];
-              y += pitch0;
-            }
-          for (hh = 0; hh < ap_prc->vportdef_.nFrameHeight / 2; hh++)
+  TIZ_TRACE (handleOf (ap_prc),
+            "nFrameWidth = [%d] nFrameHeight = [%d] "
+            "nStride = [%d] nSliceHeight = [%d]",
+            ap_prc->vportdef_.nFrameWidth, ap_prc->vportdef_.nFrameHeight,
+            ap_prc->vportdef_.nStride, ap_prc->vportdef_.nSliceHeight);
+
+  /* Overlays belong to the display surface, so the video mode is only set
+   * again if the frame size has changed */
+  if (!ap_prc->p_surface
+      || ap_prc->p_surface->w != (int) ap_prc->vportdef_.nFrameWidth
+      || ap_prc->p_surface->h != (int) ap_prc->vportdef_.nFrameHeight)
+    {
+      SDL_WM_SetCaption ("Tizonia YUV renderer", "YUV");
+      ap_prc->p_surface = SDL_SetVideoMode
+        (ap_prc->vportdef_.nFrameWidth, ap_prc->vportdef_.nFrameHeight, 0,
+         SDL_HWSURFACE | SDL_ASYNCBLIT | SDL_HWACCEL | SDL_RESIZABLE);
+    }
+
+  if (!ap_prc->p_surface)
+    {
+      rc = OMX_ErrorInsufficientResources;
+      TIZ_ERROR (handleOf (ap_prc),
+                 "[%s] : while setting the video mode [%s]",
+                 tiz_err_to_str (rc), SDL_GetError ());
+    }
+
+  return rc;
+}
+
+/* Buffers on the input port are, when possible, the pixels of an IYUV
+ * overlay. The overlay is kept locked while the buffer is away from the
+ * renderer, and is displayed in place when the buffer comes back. That is only
+ * possible when the overlay's planes are laid out exactly as the port's
+ * frames; otherwise, a plain heap buffer is handed out instead. */
+static void
+update_shared_overlay (sdlivr_prc_t * ap_prc)
+{
+  OMX_U32 w = 0;
+  OMX_U32 h = 0;
+
+  assert (ap_prc);
+
+  w = ap_prc->vportdef_.nFrameWidth;
+  h = ap_prc->vportdef_.nFrameHeight;
+
+  /* The shared overlay must never be smaller than the frames copied into it,
+     so it is re-created whenever the port's frame size changes */
+  if (ap_prc->p_overlay
+      && ((OMX_U32) ap_prc->p_overlay->w != w
+          || (OMX_U32) ap_prc->p_overlay->h != h))
+    {
+      TIZ_DEBUG (handleOf (ap_prc),
+                 "Frame size changed [%dx%d] -> [%ux%u]; "
+                 "re-creating the overlay",
+                 ap_prc->p_overlay->w, ap_prc->p_overlay->h, w, h);
+      SDL_FreeYUVOverlay (ap_prc->p_overlay);
+      ap_prc->p_overlay = NULL;
+    }
+
+  /* Used for buffers that are not backed by an overlay */
+  if (!ap_prc->p_overlay && ap_prc->p_surface)
+    {
+      ap_prc->p_overlay
+        = SDL_CreateYUVOverlay (w, h, SDL_IYUV_OVERLAY, ap_prc->p_surface);
+    }
+}
+
+static OMX_U8 *
+sdlivr_proc_alloc_hook (OMX_U32 * ap_size, OMX_PTR * app_port_priv,
+                        void * ap_args)
+{
+  sdlivr_prc_t * p_prc = ap_args;
+  SDL_Overlay * p_overlay = NULL;
+  OMX_U8 * p_buf = NULL;
+
+  assert (p_prc);
+  assert (ap_size);
+  assert (app_port_priv);
+
+  *app_port_priv = NULL;
+
+  if (OMX_ErrorNone == init_sdl (p_prc)
+      && OMX_ErrorNone == set_video_mode (p_prc))
+    {
+      const OMX_U32 w = p_prc->vportdef_.nFrameWidth;
+      const OMX_U32 h = p_prc->vportdef_.nFrameHeight;
+      OMX_U32 stride = 0;
+      OMX_U32 slice_height = 0;
+      OMX_U32 frame_size = 0;
+
+      get_frame_layout (&(p_prc->vportdef_), &stride, &slice_height,
+                        &frame_size);
+
+      /* The port may have been re-enabled with a different frame size */
+      update_shared_overlay (p_prc);
+
+      if (stride == w && slice_height == h && *ap_size <= frame_size
+          && (p_overlay
+              = SDL_CreateYUVOverlay (w, h, SDL_IYUV_OVERLAY, p_prc->p_surface)))
+        {
+          SDL_LockYUVOverlay (p_overlay);
+          if (p_overlay->planes == 3 && p_overlay->pitches[0] == stride
+              && p_overlay->pitches[1] == (stride + 1) / 2
+              && p_overlay->pitches[2] == (stride + 1) / 2
+              && p_overlay->pixels[1]
+                   == p_overlay->pixels[0] + stride * slice_height
+              && p_overlay->pixels[2]
+                   == p_overlay->pixels[1]
+                        + ((stride + 1) / 2) * ((slice_height + 1) / 2))
             {
-              memcpy (u2, u, ap_prc->p_overlay->pitches[2]);
-              u2 += ap_prc->p_overlay->pitches[2];
-              u += pitch1;
+              p_buf = p_overlay->pixels[0];
+              *ap_size = frame_size;
+              *app_port_priv = p_overlay;
             }
-          for (hh = 0; hh < ap_prc->vportdef_.nFrameHeight / 2; hh++)
+          else
             {
-              memcpy (v2, v, ap_prc->p_overlay->pitches[1]);
-              v2 += ap_prc->p_overlay->pitches[1];
-              v += pitch1;
+              SDL_UnlockYUVOverlay (p_overlay);
+              SDL_FreeYUVOverlay (p_overlay);
+              p_overlay = NULL;
             }
         }
-      else
+    }
+
+  if (!p_buf)
+    {
+      TIZ_DEBUG (handleOf (p_prc),
+                 "Overlay layout does not match the port; "
+                 "using a heap buffer");
+      p_buf = tiz_mem_calloc (*ap_size, sizeof (OMX_U8));
+    }
+  else
+    {
+      p_prc->noverlay_bufs_++;
+    }
+
+  return p_buf;
+}
+
+static void
+sdlivr_proc_free_hook (OMX_PTR ap_buf, OMX_PTR ap_port_priv, void * ap_args)
+{
+  sdlivr_prc_t * p_prc = ap_args;
+  assert (p_prc);
+  if (ap_port_priv)
+    {
+      SDL_Overlay * p_overlay = ap_port_priv;
+      SDL_UnlockYUVOverlay (p_overlay);
+      SDL_FreeYUVOverlay (p_overlay);
+      assert (p_prc->noverlay_bufs_ > 0);
+      if (0 == --p_prc->noverlay_bufs_ && p_prc->sdl_quit_pending_)
         {
-          bytes = pitch0 * ap_prc->vportdef_.nFrameHeight;
-          memcpy (ap_prc->p_overlay->pixels[0], y, bytes);
+          p_prc->p_surface = NULL;
+          p_prc->sdl_quit_pending_ = false;
+          SDL_Quit ();
+        }
+    }
+  else
+    {
+      tiz_mem_free (ap_buf);
+    }
+}
 
-          bytes = pitch1 * ap_prc->vportdef_.nFrameHeight / 2;
-          memcpy (ap_prc->p_overlay->pixels[2], u, bytes);
+static void
+copy_plane (uint8_t * ap_dst, const int a_dst_pitch, const uint8_t * ap_src,
+            const OMX_U32 a_src_stride, const OMX_U32 a_width,
+            const OMX_U32 a_rows)
+{
+  if ((OMX_U32) a_dst_pitch == a_src_stride)
+    {
+      memcpy (ap_dst, ap_src, a_src_stride * a_rows);
+    }
+  else
+    {
+      const OMX_U32 len = MIN (a_width, (OMX_U32) a_dst_pitch);
+      OMX_U32 i;
+      for (i = 0; i < a_rows; i++)
+        {
+          memcpy (ap_dst, ap_src, len);
+          ap_dst += a_dst_pitch;
+          ap_src += a_src_stride;
+        }
+    }
+}
 
-          bytes = pitch1 * ap_prc->vportdef_.nFrameHeight / 2;
-          memcpy (ap_prc->p_overlay->pixels[1], v, bytes);
+static OMX_ERRORTYPE
+sdlivr_proc_render_buffer (const sdlivr_prc_t *ap_prc, OMX_BUFFERHEADERTYPE * p_hdr)
+{
+  SDL_Overlay *p_overlay = NULL;
+
+  assert (ap_prc);
+  assert (p_hdr);
+
+  if (p_hdr->pInputPortPrivate)
+    {
+      /* The buffer is the overlay itself; nothing to copy */
+      p_overlay = p_hdr->pInputPortPrivate;
+    }
+  else if (ap_prc->p_overlay && p_hdr->nFilledLen > 0)
+    {
+      const OMX_U32 w = ap_prc->vportdef_.nFrameWidth;
+      const OMX_U32 h = ap_prc->vportdef_.nFrameHeight;
+      OMX_U32 stride = 0;
+      OMX_U32 slice_height = 0;
+      OMX_U32 frame_size = 0;
+      const uint8_t *y = p_hdr->pBuffer + p_hdr->nOffset;
+      const uint8_t *u = NULL;
+      const uint8_t *v = NULL;
+
+      get_frame_layout (&(ap_prc->vportdef_), &stride, &slice_height,
+                        &frame_size);
+
+      if ((OMX_U32) ap_prc->p_overlay->w != w
+          || (OMX_U32) ap_prc->p_overlay->h != h)
+        {
+          TIZ_ERROR (handleOf (ap_prc),
+                     "Overlay size [%dx%d] does not match the frame [%ux%u]",
+                     ap_prc->p_overlay->w, ap_prc->p_overlay->h, w, h);
+          p_hdr->nFilledLen = 0;
+          return OMX_ErrorNone;
         }
 
-      SDL_UnlockYUVOverlay (ap_prc->p_overlay);
+      if (p_hdr->nFilledLen < frame_size)
+        {
+          TIZ_ERROR (handleOf (ap_prc),
+                     "Short frame : nFilledLen [%u] expected [%u]",
+                     p_hdr->nFilledLen, frame_size);
+          p_hdr->nFilledLen = 0;
+          return OMX_ErrorNone;
+        }
+
+      /* hard-coded to be YUV420 planar */
+      u = y + stride * slice_height;
+      v = u + ((stride + 1) / 2) * ((slice_height + 1) / 2);
+      p_overlay = ap_prc->p_overlay;
+
+      SDL_LockYUVOverlay (p_overlay);
+      copy_plane (p_overlay->pixels[0], p_overlay->pitches[0], y, stride, w,
+                  h);
+      copy_plane (p_overlay->pixels[1], p_overlay->pitches[1], u,
+                  (stride + 1) / 2, (w + 1) / 2, (h + 1) / 2);
+      copy_plane (p_overlay->pixels[2], p_overlay->pitches[2], v,
+                  (stride + 1) / 2, (w + 1) / 2, (h + 1) / 2);
+    }
 
+  if (p_overlay && p_hdr->nFilledLen > 0)
+    {
+      SDL_Rect rect;
       rect.x = 0;
       rect.y = 0;
       rect.w = ap_prc->vportdef_.nFrameWidth;
       rect.h = ap_prc->vportdef_.nFrameHeight;
-      SDL_DisplayYUVOverlay (ap_prc->p_overlay, &rect);
+      SDL_UnlockYUVOverlay (p_overlay);
+      SDL_DisplayYUVOverlay (p_overlay, &rect);
+      if (p_overlay != ap_prc->p_overlay)
+        {
+          /* Hand the pixels back to the buffer */
+          SDL_LockYUVOverlay (p_overlay);
+        }
     }
 
   p_hdr->nFilledLen = 0;
@@ -131,7 +367,6 @@ sdlivr_proc_render_buffer (const sdlivr_prc_t *ap_prc, OMX_BUFFERHEADERTYPE * p_
   return OMX_ErrorNone;
 }
 
-
 /*
  * sdlivrprc
  */
@@ -140,10 +375,25 @@ static void *
 sdlivr_proc_ctor (void *ap_obj, va_list * app)
 {
   sdlivr_prc_t *p_prc = super_ctor (typeOf (ap_obj, "sdlivrprc"), ap_obj, app);
+  tiz_alloc_hooks_t hooks = { ARATELIA_YUV_RENDERER_PORT_INDEX,
+                              sdlivr_proc_alloc_hook, sdlivr_proc_free_hook,
+                              NULL };
   assert (p_prc);
   p_prc->pinhdr_ = NULL;
   p_prc->pouthdr_ = NULL;
+  p_prc->p_surface = NULL;
+  p_prc->p_overlay = NULL;
+  p_prc->noverlay_bufs_ = 0;
+  p_prc->sdl_quit_pending_ = false;
   p_prc->eos_ = false;
+
+  /* The input port's buffers are allocated from SDL overlays (the ports are
+   * instantiated before the processor) */
+  hooks.p_args = p_prc;
+  tiz_port_set_alloc_hooks (
+    tiz_krn_get_port (tiz_get_krn (handleOf (p_prc)),
+                      ARATELIA_YUV_RENDERER_PORT_INDEX),
+    &hooks, NULL);
   return p_prc;
 }
 
@@ -160,21 +410,27 @@ sdlivr_proc_dtor (void *ap_obj)
 static OMX_ERRORTYPE
 sdlivr_proc_allocate_resources (void *ap_obj, OMX_U32 a_pid)
 {
-  OMX_ERRORTYPE rc = OMX_ErrorNone;
-  if (-1 == SDL_Init (SDL_INIT_VIDEO))
-    {
-      rc =  OMX_ErrorInsufficientResources;
-      TIZ_ERROR (handleOf (ap_obj),
-                 "[%s] : while initializing SDL [%s]", tiz_err_to_str (rc),
-                 SDL_GetError ());
-    }
-  return rc;
+  sdlivr_prc_t *p_prc = ap_obj;
+  assert (p_prc);
+  p_prc->sdl_quit_pending_ = false;
+  return init_sdl (p_prc);
 }
 
 static OMX_ERRORTYPE
 sdlivr_proc_deallocate_resources (void *ap_obj)
 {
-  SDL_Quit ();
+  sdlivr_prc_t *p_prc = ap_obj;
+  assert (p_prc);
+  /* Overlay-backed buffers may still be waiting to be freed */
+  if (p_prc->noverlay_bufs_ > 0)
+    {
+      p_prc->sdl_quit_pending_ = true;
+    }
+  else
+    {
+      p_prc->p_surface = NULL;
+      SDL_Quit ();
+    }
   return OMX_ErrorNone;
 }
 
@@ -182,49 +438,13 @@ static OMX_ERRORTYPE
 sdlivr_proc_prepare_to_transfer (void *ap_obj, OMX_U32 a_pid)
 {
   sdlivr_prc_t *p_prc = ap_obj;
-  OMX_ERRORTYPE rc = OMX_ErrorNone;
-  OMX_PARAM_PORTDEFINITIONTYPE portdef;
-  TIZ_INIT_OMX_PORT_STRUCT (portdef, ARATELIA_YUV_RENDERER_PORT_INDEX);
 
   TIZ_TRACE (handleOf (p_prc), "pid [%d]", a_pid);
 
   assert (p_prc);
 
-  /* Retrieve port def from port */
-  if (OMX_ErrorNone != (rc = tiz_api_GetParameter
-                        (tiz_get_krn (handleOf (p_prc)),
-                         handleOf (p_prc),
-                         OMX_IndexParamPortDefinition, &portdef)))
-    {
-      TIZ_ERROR (handleOf (p_prc),
-                 "[%s] : retrieving the port definition", tiz_err_to_str (rc));
-      return rc;
-    }
-
-  p_prc->vportdef_ = portdef.format.video;
-
-  TIZ_TRACE (handleOf (p_prc),
-            "nFrameWidth = [%d] nFrameHeight = [%d] ",
-            /*            "nStride = [%d] nSliceHeight = [%d] nBitrate = [%d] " */
-            /*            "xFramerate = [%s] eCompressionFormat = [%d] eColorFormat = [%d]", */
-            p_prc->vportdef_.nFrameWidth, p_prc->vportdef_.nFrameHeight);
-  /*            p_prc->vportdef_.nStride, */
-  /*            p_prc->vportdef_.nSliceHeight, */
-  /*            p_prc->vportdef_.nBitrate, */
-  /*            p_prc->vportdef_.xFramerate, */
-  /*            p_prc->vportdef_.eCompressionFormat, */
-  /*            p_prc->vportdef_.eColorFormat); */
-
-  SDL_WM_SetCaption ("Tizonia YUV renderer", "YUV");
-
-
-  p_prc->p_surface = SDL_SetVideoMode
-    (p_prc->vportdef_.nFrameWidth, p_prc->vportdef_.nFrameHeight, 0,
-     SDL_HWSURFACE | SDL_ASYNCBLIT | SDL_HWACCEL | SDL_RESIZABLE);
-
-  p_prc->p_overlay = SDL_CreateYUVOverlay
-    (p_prc->vportdef_.nFrameWidth, p_prc->vportdef_.nFrameHeight,
-     SDL_YV12_OVERLAY, p_prc->p_surface);
+  tiz_check_omx (set_video_mode (p_prc));
+  update_shared_overlay (p_prc);
   return OMX_ErrorNone;
 }
 
@@ -239,7 +459,11 @@ sdlivr_proc_stop_and_return (void *ap_obj)
 {
   sdlivr_prc_t *p_prc = ap_obj;
   assert (p_prc);
-  SDL_FreeYUVOverlay (p_prc->p_overlay);
+  if (p_prc->p_overlay)
+    {
+      SDL_FreeYUVOverlay (p_prc->p_overlay);
+      p_prc->p_overlay = NULL;
+    }
   return OMX_ErrorNone;
 }
 
@@ -49,6 +49,8 @@ extern "C"
     OMX_VIDEO_PORTDEFINITIONTYPE vportdef_;
     SDL_Surface *p_surface;
     SDL_Overlay *p_overlay;
+    OMX_U32 noverlay_bufs_;
+    bool sdl_quit_pending_;
     bool eos_;
   };
 